@@ -103,6 +103,7 @@ constexpr const char *VoxformatWithMaterials = "voxformat_withmaterials";
 constexpr const char *VoxformatColorAsFloat = "voxformat_colorasfloat";
 constexpr const char *VoxformatWithtexcoords = "voxformat_withtexcoords";
 constexpr const char *VoxformatPointCloudSize = "voxformat_pointcloudsize";
+constexpr const char *VoxformatPointCloudMemory = "voxformat_pointcloudmemory";
 constexpr const char *VoxformatTransform = "voxformat_transform_mesh";
 constexpr const char *VoxformatOptimize = "voxformat_optimize";
 constexpr const char *VoxformatMeshSimplify = "voxformat_mesh_simplify";
@@ -110,6 +111,8 @@ constexpr const char *VoxformatFillHollow = "voxformat_fillhollow";
 constexpr const char *VoxformatVoxelizeMode = "voxformat_voxelizemode";
 constexpr const char *VoxformatQBTPaletteMode = "voxformat_qbtpalettemode";
 constexpr const char *VoxformatQBTMergeCompounds = "voxformat_qbtmergecompounds";
+constexpr const char *VoxformatVENGIIndexed = "voxformat_vengiindexed";
+constexpr const char *VoxformatPLYBinary = "voxformat_plybinary";
 constexpr const char *VoxformatVOXCreateLayers = "voxformat_voxcreatelayers";
 constexpr const char *VoxformatVOXCreateGroups = "voxformat_voxcreategroups";
 constexpr const char *VoxformatVXLLoadHVA = "voxformat_vxllodhva";
@@ -117,6 +120,8 @@ constexpr const char *VoxformatQBSaveLeftHanded = "voxformat_qbsavelefthanded";
 constexpr const char *VoxformatQBSaveCompressed = "voxformat_qbsavecompressed";
 constexpr const char *VoxformatGLTF_KHR_materials_pbrSpecularGlossiness = "voxformat_gltf_khr_materials_pbrspecularglossiness";
 constexpr const char *VoxformatGLTF_KHR_materials_specular = "voxformat_gltf_khr_materials_specular";
+constexpr const char *VoxformatGLTF_KHR_mesh_quantization = "voxformat_gltf_khr_mesh_quantization";
+constexpr const char *VoxformatGLTF_EXT_mesh_gpu_instancing = "voxformat_gltf_ext_mesh_gpu_instancing";
 constexpr const char *VoxformatImageVolumeMaxDepth = "voxformat_imagevolumemaxdepth";
 constexpr const char *VoxformatImageHeightmapMinHeight = "voxformat_imageheightmapminheight";
 constexpr const char *VoxformatImageVolumeBothSides = "voxformat_imagevolumebothsides";
@@ -125,6 +130,7 @@ constexpr const char *VoxformatImageSliceOffsetAxis = "voxformat_imagesliceoffse
 constexpr const char *VoxformatImageSliceOffset = "voxformat_imagesliceoffset";
 constexpr const char *VoxformatImageSaveType = "voxformat_imagesavetype";
 constexpr const char *VoxformatTexturePath = "voxformat_texturepath";
+constexpr const char *VoxformatSceneCache = "voxformat_scenecache";
 constexpr const char *VoxformatSchematicType = "voxformat_schematictype";
 constexpr const char *VoxformatBinvoxVersion = "voxformat_binvoxversion";
 constexpr const char *VoxformatSkinApplyTransform = "voxformat_skinapplytransform";
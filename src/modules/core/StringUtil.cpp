@@ -117,6 +117,54 @@ core::String toHex(int32_t number) {
 	return rc;
 }
 
+static int formatUInt(char *buf, uint64_t value) {
+	char tmp[24];
+	int n = 0;
+	do {
+		tmp[n++] = (char)('0' + value % 10u);
+		value /= 10u;
+	} while (value != 0u);
+	for (int i = 0; i < n; ++i) {
+		buf[i] = tmp[n - 1 - i];
+	}
+	return n;
+}
+
+int formatInt(char *buf, int64_t value) {
+	if (value < 0) {
+		buf[0] = '-';
+		return 1 + formatUInt(buf + 1, (uint64_t)0 - (uint64_t)value);
+	}
+	return formatUInt(buf, (uint64_t)value);
+}
+
+int formatFloat(char *buf, float value, int decimals) {
+	static const uint64_t powers[] = {1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u};
+	core_assert(decimals >= 0 && decimals < (int)lengthof(powers));
+	// a float has 24 bits of mantissa and 10^9 needs 21 bits without the power of two - so the product is exact in a
+	// double and rounding it to an integer gives the same result as printf (round half to even)
+	const double scaled = fabs((double)value * (double)powers[decimals]);
+	if (!isfinite(value) || scaled >= 9.0e18) {
+		return SDL_snprintf(buf, FormatNumberBufSize, "%.*f", decimals, (double)value);
+	}
+	const uint64_t n = (uint64_t)llrint(scaled);
+	int len = 0;
+	if (signbit(value)) {
+		buf[len++] = '-';
+	}
+	len += formatUInt(buf + len, n / powers[decimals]);
+	if (decimals > 0) {
+		buf[len++] = '.';
+		uint64_t fraction = n % powers[decimals];
+		for (int i = decimals - 1; i >= 0; --i) {
+			buf[len + i] = (char)('0' + fraction % 10u);
+			fraction /= 10u;
+		}
+		len += decimals;
+	}
+	return len;
+}
+
 core::String eraseAllChars(const core::String &str, char chr) {
 	if (str.empty()) {
 		return str;
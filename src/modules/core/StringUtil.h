@@ -40,6 +40,23 @@ inline char toHex(char code) {
 
 core::String toHex(int32_t number);
 
+/**
+ * @brief The size of the buffer that is needed for @c formatFloat() and @c formatInt()
+ */
+constexpr const int FormatNumberBufSize = 64;
+
+/**
+ * @brief Writes the value in the same way as @c printf("%.*f", decimals, value) but without parsing a format string
+ * @param[out] buf The target buffer of at least @c FormatNumberBufSize bytes - it's not null terminated
+ * @param decimals The amount of decimal places [0-9]
+ * @return The amount of characters written
+ */
+int formatFloat(char *buf, float value, int decimals = 6);
+/**
+ * @copydoc formatFloat()
+ */
+int formatInt(char *buf, int64_t value);
+
 float toFloat(const core::String& str);
 
 double toDouble(const core::String& str);
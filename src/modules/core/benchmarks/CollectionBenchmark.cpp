@@ -1,7 +1,10 @@
 #include "app/benchmark/AbstractBenchmark.h"
 #include "core/Assert.h"
 #include "core/collection/DynamicArray.h"
+#include "core/collection/DynamicMap.h"
+#include "core/collection/HashMap.h"
 #include "core/collection/Map.h"
+#include "core/collection/ParallelHashMap.h"
 #include <map>
 #include <unordered_map>
 #include <vector>
@@ -59,6 +62,82 @@ BENCHMARK_REGISTER_F(MapBenchmark, compareToMapCore)->RangeMultiplier(2)->Range(
 BENCHMARK_REGISTER_F(MapBenchmark, compareToMapStd)->RangeMultiplier(2)->Range(8, 512);
 BENCHMARK_REGISTER_F(MapBenchmark, compareToUnorderedMapStd)->RangeMultiplier(2)->Range(8, 512);
 
+BENCHMARK_DEFINE_F(MapBenchmark, insertFindDynamicMap)(benchmark::State &state) {
+	const int64_t n = state.range(0);
+	for (auto _ : state) {
+		// same bucket count as the sparse volume used
+		core::DynamicMap<int64_t, int64_t, 1031, std::hash<int64_t>> map;
+		for (int64_t i = 0; i < n; ++i) {
+			map.put(i, i);
+		}
+		for (int64_t i = 0; i < n; ++i) {
+			int64_t value;
+			if (!map.get(i, value) || value != i) {
+				state.SkipWithError("Failed!");
+				break;
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_DEFINE_F(MapBenchmark, insertFindHashMap)(benchmark::State &state) {
+	const int64_t n = state.range(0);
+	for (auto _ : state) {
+		core::HashMap<int64_t, int64_t, std::hash<int64_t>> map;
+		for (int64_t i = 0; i < n; ++i) {
+			map.put(i, i);
+		}
+		for (int64_t i = 0; i < n; ++i) {
+			int64_t value;
+			if (!map.get(i, value) || value != i) {
+				state.SkipWithError("Failed!");
+				break;
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_DEFINE_F(MapBenchmark, insertFindUnorderedMapStd)(benchmark::State &state) {
+	const int64_t n = state.range(0);
+	for (auto _ : state) {
+		std::unordered_map<int64_t, int64_t> map;
+		for (int64_t i = 0; i < n; ++i) {
+			map.emplace(i, i);
+		}
+		for (int64_t i = 0; i < n; ++i) {
+			auto iter = map.find(i);
+			if (iter == map.end() || iter->second != i) {
+				state.SkipWithError("Failed!");
+				break;
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_DEFINE_F(MapBenchmark, parallelInsertParallelHashMap)(benchmark::State &state) {
+	const int64_t n = state.range(0);
+	for (auto _ : state) {
+		core::ParallelHashMap<int64_t, int64_t, std::hash<int64_t>> map;
+		app::for_parallel(0, (int)n, [&map](int start, int end) {
+			for (int i = start; i < end; ++i) {
+				map.put(i, i);
+			}
+		});
+		if ((int64_t)map.size() != n) {
+			state.SkipWithError("Failed!");
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_REGISTER_F(MapBenchmark, insertFindDynamicMap)->RangeMultiplier(32)->Range(1 << 10, 1 << 15)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(MapBenchmark, insertFindHashMap)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(MapBenchmark, insertFindUnorderedMapStd)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(MapBenchmark, parallelInsertParallelHashMap)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+
 class DynamicArrayBenchmark : public app::AbstractBenchmark {
 protected:
 	struct TestData {
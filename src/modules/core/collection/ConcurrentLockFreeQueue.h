@@ -0,0 +1,109 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/NonCopyable.h"
+#include "core/Common.h"
+#include "core/concurrent/Atomic.h"
+#include <stdint.h>
+
+namespace core {
+
+/**
+ * @brief Unbounded lock-free multi-producer single-consumer queue
+ *
+ * Any number of threads may @c push() concurrently, but only one thread is allowed to @c pop() at a time.
+ * Based on the intrusive node queue by Dmitry Vyukov - producers only perform one atomic exchange, the
+ * consumer never touches the head.
+ *
+ * @note The @c Data type must be default constructible and movable.
+ * @ingroup Collections
+ */
+template<class Data>
+class ConcurrentLockFreeQueue : public core::NonCopyable {
+private:
+	struct Node {
+		core::AtomicPtr<Node> next{nullptr};
+		Data value{};
+	};
+	// producers append to the head
+	core::AtomicPtr<Node> _head;
+	// only accessed by the consumer - always points to the last consumed (or the initial stub) node
+	Node *_tail;
+	core::AtomicInt _size{0};
+
+	void pushNode(Node *node) {
+		_size.increment(1);
+		Node *prev = _head.exchange(node);
+		prev->next = node;
+	}
+
+public:
+	using value_type = Data;
+
+	ConcurrentLockFreeQueue() {
+		Node *stub = new Node();
+		_head = stub;
+		_tail = stub;
+	}
+
+	~ConcurrentLockFreeQueue() {
+		clear();
+		delete _tail;
+	}
+
+	void push(const Data &data) {
+		Node *node = new Node();
+		node->value = data;
+		pushNode(node);
+	}
+
+	void push(Data &&data) {
+		Node *node = new Node();
+		node->value = core::move(data);
+		pushNode(node);
+	}
+
+	/**
+	 * @note Only call this from the consumer thread
+	 */
+	bool pop(Data &poppedValue) {
+		Node *tail = _tail;
+		Node *next = tail->next;
+		if (next == nullptr) {
+			return false;
+		}
+		poppedValue = core::move(next->value);
+		_tail = next;
+		_size.decrement(1);
+		delete tail;
+		return true;
+	}
+
+	/**
+	 * @note Only call this from the consumer thread
+	 */
+	void clear() {
+		Data value;
+		while (pop(value)) {
+		}
+	}
+
+	/**
+	 * @note Only reliable on the consumer thread - producers might add new entries at any time
+	 */
+	inline bool empty() const {
+		return _size == 0;
+	}
+
+	/**
+	 * @return The approximate amount of queued entries
+	 */
+	inline uint32_t size() const {
+		return (uint32_t)(int)_size;
+	}
+};
+
+} // namespace core
@@ -0,0 +1,379 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/Assert.h"
+#include "core/Common.h"
+#include "core/StandardLib.h"
+#include "core/collection/DynamicMap.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+
+namespace core {
+
+/**
+ * @brief Growable hash map with open addressing (robin hood hashing with linear probing)
+ *
+ * The key value pairs are stored in one flat array and the capacity is doubled once the load factor exceeds 7/8.
+ * Contrary to @c Map and @c DynamicMap there are no per entry allocations, no chains and the bucket count doesn't
+ * need to be known at compile time - this makes it the better choice for maps with a lot of entries.
+ *
+ * @note Pointers and iterators are invalidated by inserting or removing entries.
+ * @sa DynamicMap
+ * @sa ParallelHashMap
+ * @ingroup Collections
+ */
+template<typename KEYTYPE, typename VALUETYPE, typename HASHER = privdynamicmap::DefaultHasher,
+		 typename COMPARE = privdynamicmap::EqualCompare>
+class HashMap {
+public:
+	using value_type = VALUETYPE;
+	using key_type = KEYTYPE;
+
+	struct KeyValue {
+		KEYTYPE key;
+		VALUETYPE value;
+	};
+
+private:
+	static constexpr size_t MinCapacity = 16u;
+	static constexpr size_t InvalidSlot = (size_t)-1;
+
+	KeyValue *_slots = nullptr;
+	// 0 means empty - otherwise the distance to the home slot + 1
+	uint16_t *_distances = nullptr;
+	size_t _capacity = 0u;
+	size_t _size = 0u;
+	HASHER _hasher;
+
+	CORE_FORCE_INLINE size_t homeSlot(const KEYTYPE &key) const {
+		// the default hashers are often just the identity - mix the bits to not cluster consecutive keys
+		uint64_t h = (uint64_t)_hasher(key);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		return (size_t)h & (_capacity - 1u);
+	}
+
+	CORE_FORCE_INLINE size_t maxSize() const {
+		return _capacity - _capacity / 8u;
+	}
+
+	size_t findSlot(const KEYTYPE &key) const {
+		if (_size == 0u) {
+			return InvalidSlot;
+		}
+		size_t idx = homeSlot(key);
+		for (uint32_t distance = 1u;; ++distance) {
+			const uint32_t slotDistance = _distances[idx];
+			// an empty slot or an entry that is closer to its home slot than we are - the key can't be in the map
+			if (slotDistance < distance) {
+				return InvalidSlot;
+			}
+			if (slotDistance == distance && COMPARE()(_slots[idx].key, key)) {
+				return idx;
+			}
+			idx = (idx + 1u) & (_capacity - 1u);
+		}
+	}
+
+	/**
+	 * @brief Inserts a key that is not yet part of the map - the capacity must be big enough
+	 * @return The slot of the inserted entry
+	 */
+	size_t insertNew(KeyValue &&entry) {
+		size_t idx = homeSlot(entry.key);
+		uint32_t distance = 1u;
+		size_t insertedSlot = InvalidSlot;
+		for (;;) {
+			const uint32_t slotDistance = _distances[idx];
+			if (slotDistance == 0u) {
+				::new (&_slots[idx]) KeyValue(core::move(entry));
+				_distances[idx] = (uint16_t)distance;
+				++_size;
+				return insertedSlot == InvalidSlot ? idx : insertedSlot;
+			}
+			if (slotDistance < distance) {
+				// take the slot from the richer entry and continue with the displaced one
+				KeyValue tmp(core::move(_slots[idx]));
+				_slots[idx] = core::move(entry);
+				entry = core::move(tmp);
+				_distances[idx] = (uint16_t)distance;
+				distance = slotDistance;
+				if (insertedSlot == InvalidSlot) {
+					insertedSlot = idx;
+				}
+			}
+			++distance;
+			core_assert_msg(distance < 0xFFFFu, "Probe sequence is too long - check the hash function");
+			idx = (idx + 1u) & (_capacity - 1u);
+		}
+	}
+
+	void rehash(size_t capacity) {
+		KeyValue *oldSlots = _slots;
+		uint16_t *oldDistances = _distances;
+		const size_t oldCapacity = _capacity;
+		_slots = (KeyValue *)core_malloc(capacity * sizeof(KeyValue));
+		_distances = (uint16_t *)core_malloc(capacity * sizeof(uint16_t));
+		core_memset(_distances, 0, capacity * sizeof(uint16_t));
+		_capacity = capacity;
+		_size = 0u;
+		for (size_t i = 0u; i < oldCapacity; ++i) {
+			if (oldDistances[i] == 0u) {
+				continue;
+			}
+			insertNew(core::move(oldSlots[i]));
+			oldSlots[i].~KeyValue();
+		}
+		core_free(oldSlots);
+		core_free(oldDistances);
+	}
+
+	void growIfNeeded() {
+		if (_capacity == 0u) {
+			rehash(MinCapacity);
+		} else if (_size + 1u > maxSize()) {
+			rehash(_capacity * 2u);
+		}
+	}
+
+	void release() {
+		clear();
+		core_free(_slots);
+		core_free(_distances);
+		_slots = nullptr;
+		_distances = nullptr;
+		_capacity = 0u;
+	}
+
+public:
+	class iterator {
+	private:
+		const HashMap *_map;
+		size_t _idx;
+		KeyValue *_ptr;
+
+	public:
+		constexpr iterator() : _map(nullptr), _idx(0u), _ptr(nullptr) {
+		}
+
+		iterator(const HashMap *map, size_t idx) : _map(map), _idx(idx), _ptr(&map->_slots[idx]) {
+		}
+
+		CORE_FORCE_INLINE KeyValue *operator*() const {
+			return _ptr;
+		}
+
+		CORE_FORCE_INLINE KeyValue *operator->() const {
+			return _ptr;
+		}
+
+		iterator &operator++() {
+			for (++_idx; _idx < _map->_capacity; ++_idx) {
+				if (_map->_distances[_idx] != 0u) {
+					_ptr = &_map->_slots[_idx];
+					return *this;
+				}
+			}
+			_ptr = nullptr;
+			_idx = 0u;
+			return *this;
+		}
+
+		CORE_FORCE_INLINE bool operator!=(const iterator &rhs) const {
+			return _ptr != rhs._ptr;
+		}
+
+		CORE_FORCE_INLINE bool operator==(const iterator &rhs) const {
+			return _ptr == rhs._ptr;
+		}
+	};
+
+	HashMap() = default;
+
+	explicit HashMap(size_t n) {
+		reserve(n);
+	}
+
+	HashMap(const HashMap &other) {
+		reserve(other.size());
+		for (auto iter = other.begin(); iter != other.end(); ++iter) {
+			put(iter->key, iter->value);
+		}
+	}
+
+	HashMap(HashMap &&other) noexcept
+		: _slots(other._slots), _distances(other._distances), _capacity(other._capacity), _size(other._size),
+		  _hasher(other._hasher) {
+		other._slots = nullptr;
+		other._distances = nullptr;
+		other._capacity = 0u;
+		other._size = 0u;
+	}
+
+	~HashMap() {
+		release();
+	}
+
+	HashMap &operator=(const HashMap &other) {
+		if (this != &other) {
+			clear();
+			reserve(other.size());
+			for (auto iter = other.begin(); iter != other.end(); ++iter) {
+				put(iter->key, iter->value);
+			}
+		}
+		return *this;
+	}
+
+	HashMap &operator=(HashMap &&other) noexcept {
+		if (this != &other) {
+			release();
+			_slots = other._slots;
+			_distances = other._distances;
+			_capacity = other._capacity;
+			_size = other._size;
+			_hasher = other._hasher;
+			other._slots = nullptr;
+			other._distances = nullptr;
+			other._capacity = 0u;
+			other._size = 0u;
+		}
+		return *this;
+	}
+
+	/**
+	 * @brief Makes sure that @c n entries can get inserted without rehashing
+	 */
+	void reserve(size_t n) {
+		size_t capacity = MinCapacity;
+		while (capacity - capacity / 8u < n) {
+			capacity *= 2u;
+		}
+		if (capacity > _capacity) {
+			rehash(capacity);
+		}
+	}
+
+	inline size_t size() const {
+		return _size;
+	}
+
+	inline bool empty() const {
+		return _size == 0u;
+	}
+
+	inline size_t capacity() const {
+		return _capacity;
+	}
+
+	bool get(const KEYTYPE &key, VALUETYPE &value) const {
+		const size_t idx = findSlot(key);
+		if (idx == InvalidSlot) {
+			return false;
+		}
+		value = _slots[idx].value;
+		return true;
+	}
+
+	bool hasKey(const KEYTYPE &key) const {
+		return findSlot(key) != InvalidSlot;
+	}
+
+	iterator find(const KEYTYPE &key) const {
+		const size_t idx = findSlot(key);
+		if (idx == InvalidSlot) {
+			return end();
+		}
+		return iterator(this, idx);
+	}
+
+	void put(const KEYTYPE &key, const VALUETYPE &value) {
+		const size_t idx = findSlot(key);
+		if (idx != InvalidSlot) {
+			_slots[idx].value = value;
+			return;
+		}
+		growIfNeeded();
+		insertNew(KeyValue{key, value});
+	}
+
+	void emplace(const KEYTYPE &key, VALUETYPE &&value) {
+		const size_t idx = findSlot(key);
+		if (idx != InvalidSlot) {
+			_slots[idx].value = core::forward<VALUETYPE>(value);
+			return;
+		}
+		growIfNeeded();
+		insertNew(KeyValue{key, core::forward<VALUETYPE>(value)});
+	}
+
+	/**
+	 * @brief Inserts the given value if the key doesn't exist yet - otherwise the existing value is handed over to
+	 * the given function
+	 * @return @c true if the value was inserted
+	 */
+	template<typename FUNC>
+	bool emplaceOrUpdate(const KEYTYPE &key, VALUETYPE &&value, FUNC &&update) {
+		const size_t idx = findSlot(key);
+		if (idx != InvalidSlot) {
+			update(_slots[idx].value);
+			return false;
+		}
+		growIfNeeded();
+		insertNew(KeyValue{key, core::forward<VALUETYPE>(value)});
+		return true;
+	}
+
+	bool remove(const KEYTYPE &key) {
+		size_t idx = findSlot(key);
+		if (idx == InvalidSlot) {
+			return false;
+		}
+		// backward shift deletion - no tombstones needed
+		size_t next = (idx + 1u) & (_capacity - 1u);
+		while (_distances[next] > 1u) {
+			_slots[idx] = core::move(_slots[next]);
+			_distances[idx] = _distances[next] - 1u;
+			idx = next;
+			next = (next + 1u) & (_capacity - 1u);
+		}
+		_slots[idx].~KeyValue();
+		_distances[idx] = 0u;
+		--_size;
+		return true;
+	}
+
+	inline void erase(const iterator &iter) {
+		remove(iter->key);
+	}
+
+	void clear() {
+		for (size_t i = 0u; i < _capacity; ++i) {
+			if (_distances[i] != 0u) {
+				_slots[i].~KeyValue();
+				_distances[i] = 0u;
+			}
+		}
+		_size = 0u;
+	}
+
+	iterator begin() const {
+		for (size_t i = 0u; i < _capacity; ++i) {
+			if (_distances[i] != 0u) {
+				return iterator(this, i);
+			}
+		}
+		return end();
+	}
+
+	constexpr iterator end() const {
+		return iterator();
+	}
+};
+
+} // namespace core
@@ -0,0 +1,147 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "app/Async.h"
+#include "core/Trace.h"
+#include "core/collection/HashMap.h"
+#include "core/concurrent/Lock.h"
+
+namespace core {
+
+/**
+ * @brief Hash map that can get filled from several threads at the same time
+ *
+ * The entries are distributed over @c SHARDS independently locked @c HashMap instances. Threads that insert
+ * different keys are only blocked if the keys end up in the same shard.
+ *
+ * @note The modifying functions are thread safe - the reading ones are not and should only be used after the map
+ * was filled.
+ * @sa HashMap
+ * @ingroup Collections
+ */
+template<typename KEYTYPE, typename VALUETYPE, typename HASHER = privdynamicmap::DefaultHasher,
+		 typename COMPARE = privdynamicmap::EqualCompare, size_t SHARDS = 64>
+class ParallelHashMap {
+public:
+	using Map = HashMap<KEYTYPE, VALUETYPE, HASHER, COMPARE>;
+
+private:
+	struct Shard {
+		core_trace_mutex(core::Lock, lock, "ParallelHashMap");
+		Map map;
+	};
+	Shard _shards[SHARDS];
+	HASHER _hasher;
+
+	CORE_FORCE_INLINE Shard &shard(const KEYTYPE &key) {
+		// use other bits than the slot index inside the shard map
+		const uint64_t h = (uint64_t)_hasher(key) * 0x9E3779B97F4A7C15ULL;
+		return _shards[(h >> 40) % SHARDS];
+	}
+
+	CORE_FORCE_INLINE const Shard &shard(const KEYTYPE &key) const {
+		const uint64_t h = (uint64_t)_hasher(key) * 0x9E3779B97F4A7C15ULL;
+		return _shards[(h >> 40) % SHARDS];
+	}
+
+public:
+	ParallelHashMap() = default;
+
+	/**
+	 * @param n The expected amount of entries
+	 */
+	explicit ParallelHashMap(size_t n) {
+		reserve(n);
+	}
+
+	ParallelHashMap(const ParallelHashMap &) = delete;
+	ParallelHashMap &operator=(const ParallelHashMap &) = delete;
+
+	void reserve(size_t n) {
+		for (Shard &s : _shards) {
+			s.map.reserve(n / SHARDS + 1u);
+		}
+	}
+
+	void put(const KEYTYPE &key, const VALUETYPE &value) {
+		Shard &s = shard(key);
+		core::ScopedLock lock(s.lock);
+		s.map.put(key, value);
+	}
+
+	/**
+	 * @brief Inserts the given value if the key doesn't exist yet - otherwise the existing value is handed over to
+	 * the given function. The function is called while the shard of the key is locked.
+	 * @return @c true if the value was inserted
+	 */
+	template<typename FUNC>
+	bool emplaceOrUpdate(const KEYTYPE &key, VALUETYPE &&value, FUNC &&update) {
+		Shard &s = shard(key);
+		core::ScopedLock lock(s.lock);
+		return s.map.emplaceOrUpdate(key, core::forward<VALUETYPE>(value), core::forward<FUNC>(update));
+	}
+
+	bool get(const KEYTYPE &key, VALUETYPE &value) const {
+		return shard(key).map.get(key, value);
+	}
+
+	bool hasKey(const KEYTYPE &key) const {
+		return shard(key).map.hasKey(key);
+	}
+
+	size_t size() const {
+		size_t n = 0u;
+		for (const Shard &s : _shards) {
+			n += s.map.size();
+		}
+		return n;
+	}
+
+	bool empty() const {
+		for (const Shard &s : _shards) {
+			if (!s.map.empty()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void clear() {
+		for (Shard &s : _shards) {
+			s.map.clear();
+		}
+	}
+
+	/**
+	 * @brief Calls the given function for all entries - sequentially
+	 */
+	template<typename FUNC>
+	void visit(FUNC &&fn) const {
+		for (const Shard &s : _shards) {
+			for (auto iter = s.map.begin(); iter != s.map.end(); ++iter) {
+				fn(iter->key, iter->value);
+			}
+		}
+	}
+
+	/**
+	 * @brief Calls the given function for all entries - the shards are processed in parallel
+	 */
+	template<typename FUNC>
+	void for_parallel(FUNC &&fn) const {
+		auto func = [this, &fn](int start, int end) {
+			for (int i = start; i < end; ++i) {
+				const Map &map = _shards[i].map;
+				for (auto iter = map.begin(); iter != map.end(); ++iter) {
+					fn(iter->key, iter->value);
+				}
+			}
+		};
+		app::for_parallel(0, (int)SHARDS, func);
+	}
+};
+
+} // namespace core
@@ -0,0 +1,90 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "core/collection/ConcurrentLockFreeQueue.h"
+#include "core/collection/DynamicArray.h"
+#include "core/String.h"
+#include <thread>
+
+namespace collection {
+
+class ConcurrentLockFreeQueueTest : public testing::Test {
+};
+
+TEST_F(ConcurrentLockFreeQueueTest, testPushPop) {
+	core::ConcurrentLockFreeQueue<int> queue;
+	const int n = 1000;
+	for (int i = 0; i < n; ++i) {
+		queue.push(i);
+	}
+	ASSERT_EQ((int)queue.size(), n);
+	for (int i = 0; i < n; ++i) {
+		int v;
+		ASSERT_TRUE(queue.pop(v));
+		ASSERT_EQ(i, v);
+	}
+	int v;
+	EXPECT_FALSE(queue.pop(v));
+	EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(ConcurrentLockFreeQueueTest, testMove) {
+	core::ConcurrentLockFreeQueue<core::String> queue;
+	queue.push(core::String("foo"));
+	queue.push(core::String("bar"));
+	core::String v;
+	ASSERT_TRUE(queue.pop(v));
+	EXPECT_EQ("foo", v);
+	ASSERT_TRUE(queue.pop(v));
+	EXPECT_EQ("bar", v);
+}
+
+TEST_F(ConcurrentLockFreeQueueTest, testClear) {
+	core::ConcurrentLockFreeQueue<int> queue;
+	for (int i = 0; i < 10; ++i) {
+		queue.push(i);
+	}
+	queue.clear();
+	EXPECT_TRUE(queue.empty());
+	int v;
+	EXPECT_FALSE(queue.pop(v));
+}
+
+TEST_F(ConcurrentLockFreeQueueTest, testMultipleProducers) {
+	const int producers = 4;
+	const int n = 10000;
+	core::ConcurrentLockFreeQueue<int> queue;
+	core::DynamicArray<std::thread> threads;
+	for (int p = 0; p < producers; ++p) {
+		threads.emplace_back([&queue, p]() {
+			for (int i = 0; i < n; ++i) {
+				queue.push(p * n + i);
+			}
+		});
+	}
+	// the per-producer order must be kept
+	int last[producers];
+	for (int p = 0; p < producers; ++p) {
+		last[p] = -1;
+	}
+	int received = 0;
+	while (received < producers * n) {
+		int v;
+		if (!queue.pop(v)) {
+			std::this_thread::yield();
+			continue;
+		}
+		const int p = v / n;
+		ASSERT_LT(last[p], v % n);
+		last[p] = v % n;
+		++received;
+	}
+	for (std::thread &t : threads) {
+		t.join();
+	}
+	EXPECT_TRUE(queue.empty());
+}
+
+} // namespace collection
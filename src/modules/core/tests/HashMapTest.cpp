@@ -0,0 +1,110 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "core/collection/HashMap.h"
+#include "core/SharedPtr.h"
+#include "core/String.h"
+#include "core/StringUtil.h"
+
+namespace core {
+
+TEST(OpenHashMapTest, testPutGet) {
+	core::HashMap<int64_t, int64_t, std::hash<int64_t>> map;
+	map.put(1, 1);
+	map.put(1, 2);
+	map.put(2, 1);
+	map.put(3, 1337);
+	map.put(4, 42);
+	int64_t value;
+	EXPECT_EQ(4u, map.size());
+	EXPECT_TRUE(map.get(1, value));
+	EXPECT_EQ(2, value);
+	EXPECT_TRUE(map.get(2, value));
+	EXPECT_EQ(1, value);
+	EXPECT_TRUE(map.get(3, value));
+	EXPECT_EQ(1337, value);
+	EXPECT_TRUE(map.get(4, value));
+	EXPECT_EQ(42, value);
+	EXPECT_FALSE(map.get(5, value));
+}
+
+TEST(OpenHashMapTest, testGrow) {
+	core::HashMap<int64_t, int64_t, std::hash<int64_t>> map;
+	for (int64_t i = 0; i < 100000; ++i) {
+		map.put(i, i * 2);
+	}
+	EXPECT_EQ(100000u, map.size());
+	EXPECT_GE(map.capacity(), map.size());
+	int64_t value = 0;
+	for (int64_t i = 0; i < 100000; ++i) {
+		ASSERT_TRUE(map.get(i, value)) << i;
+		ASSERT_EQ(i * 2, value);
+	}
+	EXPECT_FALSE(map.hasKey(100000));
+}
+
+TEST(OpenHashMapTest, testRemove) {
+	core::HashMap<int64_t, int64_t, std::hash<int64_t>> map;
+	for (int64_t i = 0; i < 1024; ++i) {
+		map.put(i, i);
+	}
+	for (int64_t i = 0; i < 1024; i += 2) {
+		EXPECT_TRUE(map.remove(i));
+	}
+	EXPECT_FALSE(map.remove(0));
+	EXPECT_EQ(512u, map.size());
+	for (int64_t i = 0; i < 1024; ++i) {
+		EXPECT_EQ(i % 2 == 1, map.hasKey(i)) << i;
+	}
+	auto iter = map.find(1);
+	ASSERT_NE(map.end(), iter);
+	map.erase(iter);
+	EXPECT_EQ(511u, map.size());
+	EXPECT_FALSE(map.hasKey(1));
+}
+
+TEST(OpenHashMapTest, testIterate) {
+	core::HashMap<int64_t, int64_t, std::hash<int64_t>> map;
+	EXPECT_EQ(map.begin(), map.end());
+	EXPECT_EQ(map.end(), map.find(42));
+	for (int64_t i = 0; i < 1024; ++i) {
+		map.put(i, i);
+	}
+	int cnt = 0;
+	for (auto entry : map) {
+		EXPECT_EQ(entry->key, entry->value);
+		++cnt;
+	}
+	EXPECT_EQ(1024, cnt);
+}
+
+TEST(OpenHashMapTest, testEmplaceOrUpdate) {
+	core::HashMap<int, int> map;
+	EXPECT_TRUE(map.emplaceOrUpdate(1, 1, [](int &v) { ++v; }));
+	EXPECT_FALSE(map.emplaceOrUpdate(1, 1, [](int &v) { ++v; }));
+	int value = 0;
+	EXPECT_TRUE(map.get(1, value));
+	EXPECT_EQ(2, value);
+}
+
+TEST(OpenHashMapTest, testCopyMove) {
+	core::HashMap<int, core::SharedPtr<core::String>> map;
+	for (int i = 0; i < 1024; ++i) {
+		map.put(i, core::make_shared<core::String>(core::string::toString(i)));
+	}
+	core::HashMap<int, core::SharedPtr<core::String>> map2 = map;
+	EXPECT_EQ(1024u, map2.size());
+	map.clear();
+	EXPECT_TRUE(map.empty());
+	core::HashMap<int, core::SharedPtr<core::String>> map3;
+	map3 = core::move(map2);
+	EXPECT_TRUE(map2.empty());
+	EXPECT_EQ(map2.end(), map2.find(1));
+	auto iter = map3.find(42);
+	ASSERT_NE(map3.end(), iter);
+	EXPECT_EQ("42", *iter->value.get());
+}
+
+} // namespace core
@@ -305,4 +305,36 @@ TEST_F(StringUtilTest, testFileMatchesMultiple) {
 	EXPECT_FALSE(core::string::fileMatchesMultiple("foobar.txt", "bar,foo"));
 }
 
+TEST_F(StringUtilTest, testFormatFloat) {
+	const float values[] = {0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 1.5f, 2.5f, 0.125f, 0.1f, 0.3f, 15.99f, 123.456f,
+							-98765.4321f, 0.0000005f, -0.0000004f, 1.0e10f, 3.0e15f, 1.0e30f};
+	char expected[core::string::FormatNumberBufSize];
+	char buf[core::string::FormatNumberBufSize];
+	for (int decimals = 0; decimals <= 6; ++decimals) {
+		for (float value : values) {
+			const int expectedLen = SDL_snprintf(expected, sizeof(expected), "%.*f", decimals, (double)value);
+			const int len = core::string::formatFloat(buf, value, decimals);
+			ASSERT_EQ(expectedLen, len) << expected;
+			EXPECT_EQ(0, SDL_memcmp(expected, buf, len)) << expected << " with " << decimals << " decimals";
+		}
+	}
+	for (int i = -100000; i <= 100000; i += 7) {
+		const float value = (float)i / 1024.0f;
+		const int expectedLen = SDL_snprintf(expected, sizeof(expected), "%.*f", 4, (double)value);
+		const int len = core::string::formatFloat(buf, value, 4);
+		ASSERT_EQ(expectedLen, len) << expected;
+		ASSERT_EQ(0, SDL_memcmp(expected, buf, len)) << expected;
+	}
+}
+
+TEST_F(StringUtilTest, testFormatInt) {
+	char buf[core::string::FormatNumberBufSize];
+	int len = core::string::formatInt(buf, 0);
+	EXPECT_EQ("0", core::String(buf, len));
+	len = core::string::formatInt(buf, -42);
+	EXPECT_EQ("-42", core::String(buf, len));
+	len = core::string::formatInt(buf, INT64_MIN);
+	EXPECT_EQ("-9223372036854775808", core::String(buf, len));
+}
+
 }
@@ -194,6 +194,14 @@ bool Filesystem::sysRemoveFile(const core::String &file) {
 	return fs_unlink(file.c_str());
 }
 
+bool Filesystem::sysRenameFile(const core::String &from, const core::String &to) {
+	if (from.empty() || to.empty()) {
+		Log::error("Can't rename file: No path given");
+		return false;
+	}
+	return fs_rename(from.c_str(), to.c_str());
+}
+
 bool Filesystem::sysRemoveDir(const core::String &dir, bool recursive) {
 	if (dir.empty()) {
 		Log::error("Can't delete dir: No path given");
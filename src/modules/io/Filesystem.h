@@ -219,6 +219,11 @@ public:
 	static bool sysRemoveFile(const core::Path& file) {
 		return sysRemoveFile(file.str());
 	}
+	/**
+	 * @brief Renames the file without taking the write path into account - an existing target file is replaced.
+	 * This can be used to replace a file atomically by a completely written temporary file.
+	 */
+	static bool sysRenameFile(const core::String& from, const core::String& to);
 };
 
 inline const Paths& Filesystem::registeredPaths() const {
@@ -29,6 +29,10 @@ bool fs_unlink(const char *path) {
 	return false;
 }
 
+bool fs_rename(const char *from, const char *to) {
+	return false;
+}
+
 bool fs_exists(const char *path) {
 	return false;
 }
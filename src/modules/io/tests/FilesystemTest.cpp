@@ -4,6 +4,7 @@
 
 #include "app/tests/AbstractTest.h"
 #include "core/tests/TestHelper.h"
+#include "io/File.h"
 #include "io/Filesystem.h"
 #include "core/Algorithm.h"
 #include "core/Enum.h"
@@ -75,6 +76,18 @@ TEST_F(FilesystemTest, testFileExists) {
 	fs.shutdown();
 }
 
+TEST_F(FilesystemTest, testSysRenameFile) {
+	EXPECT_TRUE(io::Filesystem::sysWrite("renametest/from.txt", "new"));
+	EXPECT_TRUE(io::Filesystem::sysWrite("renametest/to.txt", "old"));
+	EXPECT_TRUE(io::Filesystem::sysRenameFile("renametest/from.txt", "renametest/to.txt"));
+	EXPECT_FALSE(io::Filesystem::sysExists("renametest/from.txt"));
+	io::File file("renametest/to.txt");
+	EXPECT_EQ("new", file.load());
+	file.close();
+	EXPECT_TRUE(io::Filesystem::sysRemoveFile("renametest/to.txt"));
+	EXPECT_TRUE(io::Filesystem::sysRemoveDir("renametest"));
+}
+
 TEST_F(FilesystemTest, testListDirectoryFilter) {
 	io::Filesystem fs;
 	EXPECT_TRUE(fs.init("test", "test")) << "Failed to initialize the filesystem";
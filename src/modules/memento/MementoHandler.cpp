@@ -151,7 +151,7 @@ MementoData::MementoData(const uint8_t *buf, size_t bufSize, const voxel::Region
 
 MementoData::MementoData(MementoData &&o) noexcept
 	: _compressedSize(o._compressedSize), _buffer(o._buffer), _dataRegion(o._dataRegion),
-	  _volumeRegion(o._volumeRegion), _modifiedRegion(o._modifiedRegion) {
+	  _volumeRegion(o._volumeRegion), _modifiedRegion(o._modifiedRegion), _solidVoxels(o._solidVoxels) {
 	o._compressedSize = 0;
 	o._buffer = nullptr;
 }
@@ -165,7 +165,7 @@ MementoData::~MementoData() {
 
 MementoData::MementoData(const MementoData &o)
 	: _compressedSize(o._compressedSize), _dataRegion(o._dataRegion), _volumeRegion(o._volumeRegion),
-	  _modifiedRegion(o._modifiedRegion) {
+	  _modifiedRegion(o._modifiedRegion), _solidVoxels(o._solidVoxels) {
 	if (o._buffer != nullptr) {
 		core_assert(_compressedSize > 0);
 		_buffer = (uint8_t *)core_malloc(_compressedSize);
@@ -187,6 +187,7 @@ MementoData &MementoData::operator=(MementoData &&o) noexcept {
 		_dataRegion = o._dataRegion;
 		_volumeRegion = o._volumeRegion;
 		_modifiedRegion = o._modifiedRegion;
+		_solidVoxels = o._solidVoxels;
 	}
 	return *this;
 }
@@ -207,10 +208,21 @@ MementoData &MementoData::operator=(const MementoData &o) noexcept {
 		}
 		_dataRegion = o._dataRegion;
 		_volumeRegion = o._volumeRegion;
+		_solidVoxels = o._solidVoxels;
 	}
 	return *this;
 }
 
+static size_t countSolidVoxels(const voxel::Voxel *voxels, size_t n) {
+	size_t solid = 0u;
+	for (size_t i = 0u; i < n; ++i) {
+		if (!voxel::isAir(voxels[i].getMaterial())) {
+			++solid;
+		}
+	}
+	return solid;
+}
+
 MementoData MementoData::fromVolume(const voxel::RawVolume *volume, const voxel::Region &region) {
 	if (volume == nullptr) {
 		return MementoData();
@@ -230,7 +242,9 @@ MementoData MementoData::fromVolume(const voxel::RawVolume *volume, const voxel:
 		stream.flush();
 		const size_t size = (size_t)outStream.size();
 		const voxel::Region actualRegion = v.region();
-		return {outStream.release(), size, actualRegion, volume->region()};
+		MementoData data(outStream.release(), size, actualRegion, volume->region());
+		data._solidVoxels = countSolidVoxels(v.voxels(), (size_t)actualVoxels);
+		return data;
 	}
 	const int allVoxels = volume->region().voxels();
 	io::BufferedReadWriteStream outStream((int64_t)allVoxels * sizeof(voxel::Voxel));
@@ -241,7 +255,9 @@ MementoData MementoData::fromVolume(const voxel::RawVolume *volume, const voxel:
 	}
 	stream.flush();
 	const size_t size = (size_t)outStream.size();
-	return {outStream.release(), size, volume->region(), volume->region()};
+	MementoData data(outStream.release(), size, volume->region(), volume->region());
+	data._solidVoxels = countSolidVoxels(volume->voxels(), (size_t)allVoxels);
+	return data;
 }
 
 bool MementoData::toVolume(voxel::RawVolume *volume, const MementoData &mementoData, const voxel::Region &region) {
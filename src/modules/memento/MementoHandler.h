@@ -166,6 +166,13 @@ private:
 	 */
 	voxel::Region _modifiedRegion{};
 
+	/**
+	 * @brief The amount of non-air voxels in the data region
+	 *
+	 * This allows to pick the encoding of the network messages without decompressing the data.
+	 */
+	size_t _solidVoxels = 0;
+
 	MementoData(const uint8_t *buf, size_t bufSize, const voxel::Region &dataRegion, const voxel::Region &volumeRegion);
 	MementoData(uint8_t *buf, size_t bufSize, const voxel::Region &dataRegion, const voxel::Region &volumeRegion);
 
@@ -211,6 +218,13 @@ public:
 		return _buffer != nullptr;
 	}
 
+	/**
+	 * @return The amount of non-air voxels in the data region
+	 */
+	inline size_t solidVoxels() const {
+		return _solidVoxels;
+	}
+
 	/**
 	 * @brief Get read-only access to the compressed data buffer
 	 * @return Pointer to the compressed data buffer, or nullptr if no data is present
@@ -19,14 +19,18 @@
 #include <ws2tcpip.h>
 #define network_cleanup() WSACleanup()
 #define network_return int
+#define network_poll WSAPoll
+using network_pollfd = WSAPOLLFD;
 #else
 #define network_return ssize_t
 #include <arpa/inet.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <signal.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
@@ -36,6 +40,8 @@
 #include <unistd.h>
 #define closesocket close
 #define network_cleanup()
+#define network_poll poll
+using network_pollfd = struct pollfd;
 #endif
 
 namespace network {
@@ -52,5 +58,30 @@ struct NetworkImpl {
 	}
 };
 
+inline bool setNonBlocking(SocketId socketFD) {
+#ifdef WIN32
+	unsigned long mode = 1;
+	return ioctlsocket(socketFD, FIONBIO, &mode) == 0;
+#else
+	const int flags = fcntl(socketFD, F_GETFL, 0);
+	if (flags == -1) {
+		return false;
+	}
+	return fcntl(socketFD, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+/**
+ * @return @c true if the last socket operation failed only because it would have blocked
+ */
+inline bool wouldBlock() {
+#ifdef WIN32
+	const int error = WSAGetLastError();
+	return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
 
 } // namespace voxedit
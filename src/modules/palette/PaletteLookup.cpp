@@ -64,4 +64,21 @@ uint8_t PaletteLookup::findClosestIndex(color::RGBA rgba) {
 	return _cache[idx];
 }
 
+void PaletteLookup::findClosestIndices(const color::RGBA *colors, uint8_t *indices, size_t n) {
+	color::RGBA last(0, 0, 0, 0);
+	uint8_t lastIndex = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const color::RGBA rgba = colors[i];
+		if (rgba.a == 0) {
+			indices[i] = 0;
+			continue;
+		}
+		if (rgba != last) {
+			last = rgba;
+			lastIndex = findClosestIndex(rgba);
+		}
+		indices[i] = lastIndex;
+	}
+}
+
 } // namespace palette
@@ -47,6 +47,17 @@ public:
 	 * @sa color::getClosestMatch()
 	 */
 	uint8_t findClosestIndex(color::RGBA rgba);
+
+	/**
+	 * @brief Maps a whole row or slice of colors at once
+	 *
+	 * Runs of the same color are only looked up once. Fully transparent colors are not looked up at all and get the
+	 * index @c 0 - use the alpha value of the input color to decide whether the result should be used.
+	 * @param[in] colors The input colors
+	 * @param[out] indices Receives the closest palette index for each color
+	 * @param[in] n The amount of colors and indices
+	 */
+	void findClosestIndices(const color::RGBA *colors, uint8_t *indices, size_t n);
 };
 
 } // namespace palette
@@ -158,6 +158,23 @@ TEST_F(PaletteTest, testPaletteLookup) {
 	EXPECT_EQ(255u, palLookup.findClosestIndex(black));
 }
 
+TEST_F(PaletteTest, testPaletteLookupBatch) {
+	palette::Palette pal;
+	pal.nippon();
+	palette::PaletteLookup palLookup(pal);
+	const color::RGBA colors[] = {color::RGBA(255, 0, 0, 255), color::RGBA(255, 0, 0, 255), color::RGBA(0, 0, 0, 0),
+								  color::RGBA(0, 255, 0, 255), color::RGBA(255, 0, 0, 255)};
+	uint8_t indices[lengthof(colors)];
+	palLookup.findClosestIndices(colors, indices, lengthof(colors));
+	for (int i = 0; i < lengthof(colors); ++i) {
+		if (colors[i].a == 0) {
+			EXPECT_EQ(0u, indices[i]);
+			continue;
+		}
+		EXPECT_EQ(palLookup.findClosestIndex(colors[i]), indices[i]) << "at " << i;
+	}
+}
+
 TEST_F(PaletteTest, testReduce) {
 	Palette pal;
 	pal.nippon();
@@ -17,6 +17,11 @@ namespace voxel {
 MeshState::MeshState() {
 }
 
+MeshState::~MeshState() {
+	// the extraction jobs are pushing their results into this instance
+	waitForRunningExtractions();
+}
+
 bool MeshState::init() {
 	_meshMode = core::Var::getSafe(cfg::VoxelMeshMode);
 	_meshMode->markClean();
@@ -100,7 +105,9 @@ void MeshState::addOrReplaceMeshes(MeshState::ExtractionResult &result, MeshType
 
 int MeshState::pop() {
 	int result = -1;
-	_pendingMeshes.try_pop(result);
+	if (!_pendingMeshes.try_pop(result) && consumeFinishedExtractions() > 0) {
+		_pendingMeshes.try_pop(result);
+	}
 	return result;
 }
 
@@ -178,64 +185,123 @@ voxel::Region MeshState::calculateExtractRegion(int x, int y, int z, const glm::
 
 bool MeshState::runScheduledExtractions(size_t maxExtraction) {
 	core_trace_scoped(MeshStateRunScheduledExtractions);
-	const size_t n = _extractRegions.size();
-	if (n == 0) {
-		return false;
-	}
 	if (maxExtraction == 0) {
 		maxExtraction = core::cpus();
 	}
-	ExtractRegion regions[64] {};
-	if (maxExtraction > lengthof(regions)) {
-		maxExtraction = lengthof(regions);
-	}
-	for (size_t i = 0; i < maxExtraction && i < n; ++i) {
-		if (!_extractRegions.pop(regions[i])) {
-			maxExtraction = i;
+	const voxel::SurfaceExtractionType type = meshMode();
+	while (_runningExtractions.size() < maxExtraction) {
+		ExtractRegion extractRegion;
+		if (!_extractRegions.pop(extractRegion)) {
 			break;
 		}
+		const int idx = extractRegion.idx;
+		if (idx == -1) {
+			continue;
+		}
+		const voxel::RawVolume *v = volume(idx);
+		if (v == nullptr) {
+			continue;
+		}
+		const voxel::Region region = extractRegion.region;
+		// the extractors are also looking at the neighbours of the region
+		const voxel::Region copyRegion(region.getLowerCorner() - 2, region.getUpperCorner() + 2);
+		if (!copyRegion.isValid()) {
+			continue;
+		}
+
+		// the volume and the palette might get modified while the extraction is running
+		const core::SharedPtr<voxel::RawVolume> snapshot = core::make_shared<voxel::RawVolume>(*v, copyRegion);
+		const core::SharedPtr<palette::Palette> pal = core::make_shared<palette::Palette>(palette(resolveIdx(idx)));
+		const uint32_t volumeGeneration = _volumeData[idx]._generation;
+		const uint32_t generation = _generation;
+		const uint64_t sequence = ++_sequence;
+		const glm::ivec4 key(region.getLowerCorner(), idx);
+		auto sequenceIter = _regionSequences.find(key);
+		if (sequenceIter != _regionSequences.end()) {
+			++sequenceIter->value.running;
+		} else {
+			RegionSequence regionSequence;
+			regionSequence.running = 1u;
+			_regionSequences.put(key, regionSequence);
+		}
+		_runningExtractions.emplace_back(app::async(
+			[this, snapshot, pal, region, idx, type, volumeGeneration, generation, sequence]() {
+				core_trace_scoped(MeshStateExtraction);
+				const glm::ivec3 &mins = region.getLowerCorner();
+				voxel::ChunkMesh mesh(262144, 524288, true);
+				voxel::SurfaceExtractionContext ctx =
+					voxel::createContext(type, snapshot.get(), region, *pal.get(), mesh, mins);
+				voxel::extractSurface(ctx);
+				ExtractionResult result(mins, idx, core::move(mesh));
+				result.volumeGeneration = volumeGeneration;
+				result.generation = generation;
+				result.sequence = sequence;
+				_finishedExtractions.push(core::move(result));
+			}));
+	}
+	Log::debug("%i extractions running in the background", (int)_runningExtractions.size());
+	return !_runningExtractions.empty();
+}
+
+bool MeshState::isCurrent(const ExtractionResult &result) const {
+	if (result.generation != _generation) {
+		return false;
 	}
-	ExtractionResult results[lengthof(regions)] {};
-	Log::debug("running %i extractions in parallel", (int)maxExtraction);
-	voxel::SurfaceExtractionType type = (voxel::SurfaceExtractionType)_meshMode->intVal();
-	auto fn = [&regions, &results, this, type] (size_t start, size_t end) {
-		for (size_t i = start; i < end; ++i) {
-			const ExtractRegion &extractRegion = regions[i];
-			const int idx = extractRegion.idx;
-			if (idx == -1) {
-				continue;
-			}
-			const voxel::RawVolume *v = volume(idx);
-			if (v == nullptr) {
-				continue;
-			}
-			const voxel::Region finalRegion = extractRegion.region;
-			const voxel::Region copyRegion(finalRegion.getLowerCorner() - 2, finalRegion.getUpperCorner() + 2);
-			if (!copyRegion.isValid()) {
-				continue;
-			}
+	if (result.idx < 0 || result.idx >= MAX_VOLUMES) {
+		return false;
+	}
+	if (_volumeData[result.idx]._generation != result.volumeGeneration) {
+		Log::debug("Drop extraction result for replaced volume %i", result.idx);
+		return false;
+	}
+	return true;
+}
 
-			const palette::Palette &pal = palette(resolveIdx(idx));
-			const glm::ivec3 &mins = extractRegion.region.getLowerCorner();
-			voxel::ChunkMesh mesh(262144, 524288, true);
-			voxel::SurfaceExtractionContext ctx = voxel::createContext(type, v, extractRegion.region, pal, mesh, mins);
-			voxel::extractSurface(ctx);
-			results[i] = {mins, idx, core::move(mesh)};
+int MeshState::consumeFinishedExtractions() {
+	core_trace_scoped(MeshStateConsumeFinishedExtractions);
+	// the result is queued before the future gets ready
+	for (size_t i = 0; i < _runningExtractions.size();) {
+		const core::Future<void> &future = _runningExtractions[i];
+		if (!future.valid() || future.ready()) {
+			_runningExtractions.erase(i);
+		} else {
+			++i;
 		}
-	};
-	app::for_parallel(0, maxExtraction, fn);
+	}
 
-	for (size_t i = 0; i < maxExtraction; ++i) {
-		ExtractionResult &result = results[i];
-		if (result.idx == -1) {
+	int n = 0;
+	ExtractionResult result;
+	while (_finishedExtractions.pop(result)) {
+		const glm::ivec4 key(result.mins, result.idx);
+		auto iter = _regionSequences.find(key);
+		if (iter == _regionSequences.end()) {
+			continue;
+		}
+		// a newer extraction of the same region might have finished earlier
+		const bool apply = isCurrent(result) && iter->value.applied <= result.sequence;
+		if (apply) {
+			iter->value.applied = result.sequence;
+		}
+		if (--iter->value.running == 0u) {
+			_regionSequences.remove(key);
+		}
+		if (!apply) {
 			continue;
 		}
 		addOrReplaceMeshes(result, MeshType_Opaque);
 		addOrReplaceMeshes(result, MeshType_Transparency);
 		_pendingMeshes.push(result.idx);
+		++n;
 	}
+	return n;
+}
 
-	return true;
+void MeshState::waitForRunningExtractions() {
+	core_trace_scoped(MeshStateWaitForRunningExtractions);
+	for (core::Future<void> &future : _runningExtractions) {
+		future.wait();
+	}
+	_runningExtractions.clear();
 }
 
 bool MeshState::update() {
@@ -252,6 +318,7 @@ bool MeshState::update() {
 		}
 		triggerClear = true;
 	}
+	consumeFinishedExtractions();
 	runScheduledExtractions();
 	return triggerClear;
 }
@@ -301,7 +368,9 @@ bool MeshState::scheduleRegionExtraction(int idx, const voxel::Region &region) {
 
 void MeshState::extractAllPending() {
 	core_trace_scoped(MeshStateExtractAllPending);
-	while (runScheduledExtractions(100)) {
+	while (runScheduledExtractions(core::cpus() * 2)) {
+		waitForRunningExtractions();
+		consumeFinishedExtractions();
 	}
 }
 
@@ -309,6 +378,8 @@ void MeshState::clearPendingExtractions() {
 	core_trace_scoped(MeshStateClearPendingExtractions);
 	_pendingMeshes.clear();
 	_extractRegions.clear();
+	// the results of the running extractions are dropped once they are consumed
+	++_generation;
 }
 
 voxel::SurfaceExtractionType MeshState::meshMode() const {
@@ -352,6 +423,7 @@ voxel::RawVolume *MeshState::setVolume(int idx, voxel::RawVolume *v, palette::Pa
 	}
 	core_trace_scoped(RawVolumeRendererSetVolume);
 	_volumeData[idx]._rawVolume = v;
+	++_volumeData[idx]._generation;
 	if (meshDelete) {
 		deleteMeshes(idx);
 		meshDeleted = true;
@@ -367,6 +439,9 @@ voxel::RawVolume *MeshState::setVolume(int idx, voxel::RawVolume *v, palette::Pa
 }
 
 core::Buffer<voxel::RawVolume *> MeshState::shutdown() {
+	waitForRunningExtractions();
+	clearPendingExtractions();
+	consumeFinishedExtractions();
 	clearMeshes();
 	core::Buffer<voxel::RawVolume *> old;
 	old.reserve(MAX_VOLUMES);
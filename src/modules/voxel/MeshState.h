@@ -9,9 +9,12 @@
 #include "core/SharedPtr.h"
 #include "core/Var.h"
 #include "core/collection/Array.h"
+#include "core/collection/ConcurrentLockFreeQueue.h"
+#include "core/collection/DynamicArray.h"
 #include "core/collection/DynamicMap.h"
 #include "core/collection/PriorityQueue.h"
 #include "core/collection/Queue.h"
+#include "core/concurrent/Future.h"
 #include "palette/NormalPalette.h"
 #include "palette/Palette.h"
 #include "video/Types.h"
@@ -32,6 +35,11 @@ enum MeshType { MeshType_Opaque, MeshType_Transparency, MeshType_Max };
 /**
  * @brief Handles the mesh extraction of the volumes
  *
+ * The extraction runs in the background. Each scheduled region is copied into a snapshot volume (including the
+ * border voxels the extractors need) on the calling thread - so the volume can get modified while the extraction
+ * is running. The finished meshes are handed back via a lock-free queue and taken over in @c update() or @c pop()
+ * without waiting for the running extractions.
+ *
  * @note This class doesn't own the @c voxel::RawVolume instances. It's up to the caller to inform this class about
  * deleted or added volumes.
  */
@@ -51,6 +59,8 @@ private:
 		// if one or three axes are negative, then cull the front face
 		video::Face _cullFace = video::Face::Back;
 		int _reference = -1;
+		// incremented whenever the volume is replaced - results of extractions for an older volume are dropped
+		uint32_t _generation = 0u;
 		glm::mat4 _model{1.0f};
 		glm::vec3 _mins{0.0f};
 		glm::vec3 _maxs{0.0f};
@@ -71,6 +81,11 @@ private:
 		glm::ivec3 mins{};
 		int idx = -1;
 		voxel::ChunkMesh mesh{0, 0, true};
+		// the volume generation and the global mesh state generation at the time the extraction was started
+		uint32_t volumeGeneration = 0u;
+		uint32_t generation = 0u;
+		// newer extractions of the same region are not replaced by older ones that finished later
+		uint64_t sequence = 0u;
 
 		inline bool operator<(const ExtractionResult &rhs) const {
 			return idx < rhs.idx;
@@ -101,18 +116,57 @@ private:
 	voxel::Region calculateExtractRegion(int x, int y, int z, const glm::ivec3 &meshSize) const;
 	core::Queue<int> _pendingMeshes;
 	core::VarPtr _meshMode;
+
+	// filled by the extraction jobs - only consumed by the thread that owns the mesh state
+	core::ConcurrentLockFreeQueue<ExtractionResult> _finishedExtractions;
+	core::DynamicArray<core::Future<void>> _runningExtractions;
+	struct RegionSequence {
+		// the sequence of the last result that was taken over
+		uint64_t applied = 0u;
+		// the extractions of the region whose results weren't consumed yet
+		uint32_t running = 0u;
+	};
+	// only contains the regions (mins and volume index) with running extractions - the entry is removed once the
+	// last result was consumed
+	core::DynamicMap<glm::ivec4, RegionSequence, 1031, glm::hash<glm::ivec4>> _regionSequences;
+	uint64_t _sequence = 0u;
+	// incremented if all running extractions should get dropped - e.g. the mesh mode changed
+	uint32_t _generation = 0u;
+
 	bool deleteMeshes(const glm::ivec3 &pos, int idx);
+	/**
+	 * @brief Starts the extraction jobs for the scheduled regions in the background
+	 * @param maxExtraction The max amount of extractions that are running at the same time - @c 0 means the amount
+	 * of cores
+	 * @return @c true if there are scheduled regions left or extractions are still running
+	 */
 	bool runScheduledExtractions(size_t maxExtraction = 0);
+	/**
+	 * @brief Takes over the meshes of the finished extractions without waiting for the running ones
+	 * @return The amount of meshes that were taken over
+	 */
+	int consumeFinishedExtractions();
+	/**
+	 * @return @c false if the volume or the mesh mode changed since the extraction was started
+	 */
+	bool isCurrent(const ExtractionResult &result) const;
+	/**
+	 * @brief Blocks until all running extractions are finished
+	 */
+	void waitForRunningExtractions();
 	bool deleteMeshes(int idx);
 	void addOrReplaceMeshes(MeshState::ExtractionResult &result, MeshType type);
 
 public:
 	MeshState();
+	~MeshState();
 	void clearMeshes();
 	const MeshesMap &meshes(MeshType type) const;
 	/**
 	 * @brief This will transfer the extracted meshes into the mesh state and make
 	 * it available to others
+	 * @note This doesn't wait for running extractions - the meshes show up on later calls
+	 * @return The volume index of a mesh that was updated or @c -1 if there is none
 	 */
 	int pop();
 	void count(MeshType meshType, int idx, size_t &vertCount, size_t &normalsCount, size_t &indCount) const;
@@ -133,6 +187,14 @@ public:
 	 * @return the amount of pending extractions
 	 */
 	int pendingExtractions() const;
+	/**
+	 * @return the amount of extractions that were started but not yet taken over
+	 */
+	int runningExtractions() const;
+	/**
+	 * @return the amount of regions with extractions whose results weren't taken over yet
+	 */
+	int runningRegions() const;
 	void clearPendingExtractions();
 	int pendingMeshes() const;
 
@@ -216,6 +278,14 @@ inline int MeshState::pendingExtractions() const {
 	return (int)_extractRegions.size();
 }
 
+inline int MeshState::runningExtractions() const {
+	return (int)_runningExtractions.size();
+}
+
+inline int MeshState::runningRegions() const {
+	return (int)_regionSequences.size();
+}
+
 inline int MeshState::pendingMeshes() const {
 	return (int)_pendingMeshes.size();
 }
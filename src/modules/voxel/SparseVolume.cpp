@@ -3,44 +3,101 @@
  */
 
 #include "SparseVolume.h"
+#include <limits>
 
 namespace voxel {
 
 SparseVolume::SparseVolume(const voxel::Region &region) : _region(region), _isRegionValid(_region.isValid()) {
 }
 
+SparseVolume::SparseVolume(const SparseVolume &other)
+	: _region(other._region), _isRegionValid(other._isRegionValid), _storeEmptyVoxels(other._storeEmptyVoxels),
+	  _size(other._size) {
+	_bricks.reserve(other._bricks.size());
+	for (auto iter = other._bricks.begin(); iter != other._bricks.end(); ++iter) {
+		_bricks.put(iter->key, new Brick(*iter->value));
+	}
+}
+
+SparseVolume::~SparseVolume() {
+	clear();
+}
+
+const SparseVolume::Brick *SparseVolume::brick(const glm::ivec3 &brickPos) const {
+	auto iter = _bricks.find(brickPos);
+	if (iter == _bricks.end()) {
+		return nullptr;
+	}
+	return iter->value;
+}
+
 bool SparseVolume::setVoxel(const glm::ivec3 &pos, const voxel::Voxel &voxel) {
 	if (_isRegionValid && !_region.containsPoint(pos)) {
 		return false;
 	}
+	const glm::ivec3 &bPos = brickPos(pos);
+	const uint32_t idx = Brick::index(pos);
+	const uint64_t bit = 1ull << (idx % 64u);
+	auto iter = _bricks.find(bPos);
 	if (!_storeEmptyVoxels && isAir(voxel.getMaterial())) {
-		_map.remove(pos);
+		if (iter == _bricks.end()) {
+			return true;
+		}
+		Brick *b = iter->value;
+		if (b->has(idx)) {
+			b->occupied[idx / 64u] &= ~bit;
+			b->voxels[idx] = _emptyVoxel;
+			--_size;
+		}
 		return true;
 	}
-	_map.put(pos, voxel);
+	Brick *b;
+	if (iter == _bricks.end()) {
+		b = new Brick();
+		_bricks.put(bPos, b);
+		++_generation;
+	} else {
+		b = iter->value;
+	}
+	if (!b->has(idx)) {
+		b->occupied[idx / 64u] |= bit;
+		++_size;
+	}
+	b->voxels[idx] = voxel;
 	return true;
 }
 
 const Voxel &SparseVolume::voxel(const glm::ivec3 &pos) const {
-	auto iter = _map.find(pos);
-	if (iter != _map.end()) {
-		return iter->second;
+	const Brick *b = brick(brickPos(pos));
+	if (b != nullptr) {
+		return b->voxels[Brick::index(pos)];
 	}
 	return _emptyVoxel;
 }
 
 bool SparseVolume::hasVoxel(const glm::ivec3 &pos) const {
-	return _map.hasKey(pos);
+	const Brick *b = brick(brickPos(pos));
+	if (b == nullptr) {
+		return false;
+	}
+	return b->has(Brick::index(pos));
 }
 
 void SparseVolume::clear() {
-	_map.clear();
+	for (auto iter = _bricks.begin(); iter != _bricks.end(); ++iter) {
+		delete iter->value;
+	}
+	_bricks.clear();
+	_size = 0u;
+	++_generation;
 }
 
-SparseVolume::Sampler::Sampler(const SparseVolume *volume) : _volume(const_cast<SparseVolume *>(volume)) {
+SparseVolume::Sampler::Sampler(const SparseVolume *volume)
+	: _volume(const_cast<SparseVolume *>(volume)), _generation(volume->_generation) {
 }
 
-SparseVolume::Sampler::Sampler(const SparseVolume &volume) : _volume(const_cast<SparseVolume *>(&volume)) {
+SparseVolume::Sampler::Sampler(const SparseVolume &volume)
+	: _volume(const_cast<SparseVolume *>(&volume)), _generation(volume._generation) {
 }
 
 SparseVolume::Sampler::~Sampler() {
@@ -51,6 +108,7 @@ bool SparseVolume::Sampler::setVoxel(const Voxel &voxel) {
 		return false;
 	}
 	_volume->setVoxel(_posInVolume, voxel);
+	_currentVoxel = cachedVoxel(_posInVolume);
 	return true;
 }
 
@@ -75,7 +133,7 @@ bool SparseVolume::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_t zPos
 
 	// Then we update the voxel pointer
 	if (currentPositionValid()) {
-		_currentVoxel = _volume->voxel(_posInVolume);
+		_currentVoxel = cachedVoxel(_posInVolume);
 		return true;
 	}
 	return false;
@@ -97,69 +155,6 @@ void SparseVolume::Sampler::movePositive(math::Axis axis, uint32_t offset) {
 	}
 }
 
-void SparseVolume::Sampler::movePositiveX(uint32_t offset) {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	_posInVolume.x += (int)offset;
-
-	if (region().isValid()) {
-		if (!region().containsPointInX(_posInVolume.x)) {
-			_currentPositionInvalid |= SAMPLER_INVALIDX;
-		} else {
-			_currentPositionInvalid &= ~SAMPLER_INVALIDX;
-		}
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel = _volume->voxel(_posInVolume);
-	}
-}
-
-void SparseVolume::Sampler::movePositiveY(uint32_t offset) {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	_posInVolume.y += (int)offset;
-
-	if (region().isValid()) {
-		if (!region().containsPointInY(_posInVolume.y)) {
-			_currentPositionInvalid |= SAMPLER_INVALIDY;
-		} else {
-			_currentPositionInvalid &= ~SAMPLER_INVALIDY;
-		}
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel = _volume->voxel(_posInVolume);
-	}
-}
-
-void SparseVolume::Sampler::movePositiveZ(uint32_t offset) {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	_posInVolume.z += (int)offset;
-
-	if (region().isValid()) {
-		if (!region().containsPointInZ(_posInVolume.z)) {
-			_currentPositionInvalid |= SAMPLER_INVALIDZ;
-		} else {
-			_currentPositionInvalid &= ~SAMPLER_INVALIDZ;
-		}
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel = _volume->voxel(_posInVolume);
-	}
-}
-
 void SparseVolume::Sampler::moveNegative(math::Axis axis, uint32_t offset) {
 	switch (axis) {
 	case math::Axis::X:
@@ -176,82 +171,34 @@ void SparseVolume::Sampler::moveNegative(math::Axis axis, uint32_t offset) {
 	}
 }
 
-void SparseVolume::Sampler::moveNegativeX(uint32_t offset) {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	_posInVolume.x -= (int)offset;
-
-	if (region().isValid()) {
-		if (!region().containsPointInX(_posInVolume.x)) {
-			_currentPositionInvalid |= SAMPLER_INVALIDX;
-		} else {
-			_currentPositionInvalid &= ~SAMPLER_INVALIDX;
-		}
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel = _volume->voxel(_posInVolume);
-	}
-}
-
-void SparseVolume::Sampler::moveNegativeY(uint32_t offset) {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	_posInVolume.y -= (int)offset;
-
-	if (region().isValid()) {
-		if (!region().containsPointInY(_posInVolume.y)) {
-			_currentPositionInvalid |= SAMPLER_INVALIDY;
-		} else {
-			_currentPositionInvalid &= ~SAMPLER_INVALIDY;
-		}
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel = _volume->voxel(_posInVolume);
-	}
-}
-
-void SparseVolume::Sampler::moveNegativeZ(uint32_t offset) {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	_posInVolume.z -= (int)offset;
-
-	if (region().isValid()) {
-		if (!region().containsPointInZ(_posInVolume.z)) {
-			_currentPositionInvalid |= SAMPLER_INVALIDZ;
-		} else {
-			_currentPositionInvalid &= ~SAMPLER_INVALIDZ;
-		}
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel = _volume->voxel(_posInVolume);
-	}
-}
-
 Region SparseVolume::calculateRegion() const {
-	if (_map.empty()) {
+	if (empty()) {
 		return Region::InvalidRegion;
 	}
 
-	auto iter = _map.begin();
-	const glm::ivec3 &p = iter->key;
-	glm::aligned_ivec4 mins(p, 0);
-	glm::aligned_ivec4 maxs(p, 0);
-	for (++iter; iter != _map.end(); ++iter) {
-		const glm::aligned_ivec4 k(iter->key, 0);
-		maxs = (glm::max)(maxs, k);
-		mins = (glm::min)(mins, k);
+	glm::aligned_ivec4 mins((std::numeric_limits<int>::max)());
+	glm::aligned_ivec4 maxs((std::numeric_limits<int>::min)());
+	for (auto iter = _bricks.begin(); iter != _bricks.end(); ++iter) {
+		const glm::aligned_ivec4 brickMins(iter->key * BrickSize, 0);
+		const glm::aligned_ivec4 brickMaxs(iter->key * BrickSize + BrickMask, 0);
+		// only the voxels of bricks that are not fully inside the current bounds can change them
+		if (glm::all(glm::greaterThanEqual(brickMins, mins)) && glm::all(glm::lessThanEqual(brickMaxs, maxs))) {
+			continue;
+		}
+		const Brick *b = iter->value;
+		for (uint32_t w = 0u; w < BrickVoxels / 64; ++w) {
+			uint32_t idx = w * 64u;
+			for (uint64_t bits = b->occupied[w]; bits != 0u; bits >>= 1, ++idx) {
+				if ((bits & 1u) == 0u) {
+					continue;
+				}
+				const glm::aligned_ivec4 k(brickMins.x + priv::morton256_decode_x[idx],
+										   brickMins.y + priv::morton256_decode_y[idx],
+										   brickMins.z + priv::morton256_decode_z[idx], 0);
+				maxs = (glm::max)(maxs, k);
+				mins = (glm::min)(mins, k);
+			}
+		}
 	}
 	return voxel::Region{mins, maxs};
 }
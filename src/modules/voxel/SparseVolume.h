@@ -5,24 +5,58 @@
 #pragma once
 
 #include "core/GLM.h"
-#include "core/collection/DynamicMap.h"
+#include "core/collection/HashMap.h"
 #include "math/Axis.h"
+#include "voxel/Morton.h"
 #include "voxelutil/VolumeVisitor.h"
 #include "voxel/VolumeSamplerUtil.h"
 
 namespace voxel {
 
 /**
- * Sparse volume implementation which stores data in a hashmap. This is useful for volumes where most of the voxels are
- * empty.
+ * Sparse volume implementation which stores data in a hashmap of small dense bricks. This is useful for volumes where
+ * most of the voxels are empty.
+ *
+ * The voxels of a brick are stored in morton order and a bit mask keeps track of the voxels that were set. The
+ * sampler caches the bricks around its current position - moving and peeking only needs a hash lookup if a brick
+ * boundary is crossed.
  */
 class SparseVolume {
+public:
+	static constexpr int BrickBits = 3;
+	static constexpr int BrickSize = 1 << BrickBits;
+	static constexpr int BrickMask = BrickSize - 1;
+	static constexpr int BrickVoxels = BrickSize * BrickSize * BrickSize;
+
 private:
-	core::DynamicMap<glm::ivec3, voxel::Voxel, 1031, glm::hash<glm::ivec3>> _map;
+	struct Brick {
+		voxel::Voxel voxels[BrickVoxels];
+		uint64_t occupied[BrickVoxels / 64]{};
+
+		static CORE_FORCE_INLINE uint32_t index(const glm::ivec3 &pos) {
+			return mortonIndex(pos.x & BrickMask, pos.y & BrickMask, pos.z & BrickMask);
+		}
+
+		CORE_FORCE_INLINE bool has(uint32_t idx) const {
+			return (occupied[idx / 64u] & (1ull << (idx % 64u))) != 0u;
+		}
+	};
+
+	// the bricks are never freed before clear() is called - this keeps the cached sampler pointers valid
+	core::HashMap<glm::ivec3, Brick *, glm::hash<glm::ivec3>> _bricks;
 	static const constexpr voxel::Voxel _emptyVoxel{VoxelType::Air, 0, 0, 0};
 	const voxel::Region _region;
 	const bool _isRegionValid;
 	bool _storeEmptyVoxels = false;
+	size_t _size = 0u;
+	// increased whenever a brick is created or the bricks are freed - the samplers use this to invalidate their cache
+	uint32_t _generation = 0u;
+
+	static CORE_FORCE_INLINE glm::ivec3 brickPos(const glm::ivec3 &pos) {
+		return glm::ivec3(pos.x >> BrickBits, pos.y >> BrickBits, pos.z >> BrickBits);
+	}
+
+	const Brick *brick(const glm::ivec3 &brickPos) const;
 
 public:
 	class Sampler {
@@ -31,6 +65,13 @@ public:
 		static const uint8_t SAMPLER_INVALIDY = 1 << 1;
 		static const uint8_t SAMPLER_INVALIDZ = 1 << 2;
 
+		/**
+		 * @brief Looks up the voxel in the cached bricks - only needs a hash lookup if the brick isn't cached yet
+		 */
+		const Voxel &cachedVoxel(const glm::ivec3 &pos) const;
+		const Voxel &peek(int x, int y, int z) const;
+		void updateVoxel(bool oldPositionValid);
+
 	public:
 		Sampler(const SparseVolume &volume);
 		Sampler(const SparseVolume *volume);
@@ -97,10 +138,27 @@ public:
 
 		/** Whether the current position is inside the volume */
 		uint8_t _currentPositionInvalid = 0u;
+
+		struct CachedBrick {
+			glm::ivec3 pos;
+			const Brick *brick;
+		};
+		/**
+		 * Direct mapped cache of the last used bricks - 16 bricks along the x axis and two along y and z. This covers
+		 * the neighbours of the current brick and the bricks of the previous row. An entry is only valid if its bit
+		 * in @c _cachedBricks is set.
+		 */
+		mutable CachedBrick _brickCache[64];
+		mutable uint64_t _cachedBricks = 0u;
+		mutable uint32_t _generation = 0u;
 	};
 
 	// invalid region means unlimited size
 	SparseVolume(const voxel::Region &limitRegion = voxel::Region::InvalidRegion);
+	SparseVolume(const SparseVolume &other);
+	~SparseVolume();
+
+	SparseVolume &operator=(const SparseVolume &other) = delete;
 
 	void setStoreEmptyVoxels(bool storeEmptyVoxels) {
 		_storeEmptyVoxels = storeEmptyVoxels;
@@ -144,7 +202,7 @@ public:
 	}
 
 	[[nodiscard]] inline size_t size() const {
-		return _map.size();
+		return _size;
 	}
 
 	/**
@@ -168,13 +226,33 @@ public:
 	 */
 	int32_t depth() const;
 
+	/**
+	 * @brief Calls the given function for all stored voxels - brick by brick, the order is not defined
+	 */
+	template<class FUNC>
+	void visitVoxels(FUNC &&func) const {
+		for (auto iter = _bricks.begin(); iter != _bricks.end(); ++iter) {
+			const Brick *b = iter->value;
+			const glm::ivec3 mins = iter->key * BrickSize;
+			for (uint32_t w = 0u; w < BrickVoxels / 64; ++w) {
+				uint32_t idx = w * 64u;
+				for (uint64_t bits = b->occupied[w]; bits != 0u; bits >>= 1, ++idx) {
+					if ((bits & 1u) == 0u) {
+						continue;
+					}
+					const glm::ivec3 pos(mins.x + priv::morton256_decode_x[idx], mins.y + priv::morton256_decode_y[idx],
+										 mins.z + priv::morton256_decode_z[idx]);
+					func(pos, b->voxels[idx]);
+				}
+			}
+		}
+	}
+
 	template<class Volume>
 	void copyTo(Volume &target) const {
-		for (auto iter = _map.begin(); iter != _map.end(); ++iter) {
-			const glm::ivec3 &pos = iter->first;
-			const voxel::Voxel &voxel = iter->second;
+		visitVoxels([&target](const glm::ivec3 &pos, const voxel::Voxel &voxel) {
 			target.setVoxel(pos.x, pos.y, pos.z, voxel);
-		}
+		});
 	}
 
 	template<class Volume>
@@ -238,9 +316,43 @@ inline const Voxel &SparseVolume::Sampler::voxel() const {
 	if (this->currentPositionValid()) {
 		return _currentVoxel;
 	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z);
+	return cachedVoxel(this->_posInVolume);
+}
+
+CORE_FORCE_INLINE const Voxel &SparseVolume::Sampler::cachedVoxel(const glm::ivec3 &pos) const {
+	if (core_unlikely(_generation != _volume->_generation)) {
+		_generation = _volume->_generation;
+		_cachedBricks = 0u;
+	}
+	const glm::ivec3 &bPos = brickPos(pos);
+	const uint32_t slot = (uint32_t)((bPos.x & 15) | ((bPos.y & 1) << 4) | ((bPos.z & 1) << 5));
+	CachedBrick &cached = _brickCache[slot];
+	if ((_cachedBricks & (1ull << slot)) == 0u || cached.pos != bPos) {
+		cached.pos = bPos;
+		cached.brick = _volume->brick(bPos);
+		_cachedBricks |= 1ull << slot;
+	}
+	if (cached.brick == nullptr) {
+		return _emptyVoxel;
+	}
+	return cached.brick->voxels[Brick::index(pos)];
 }
 
+CORE_FORCE_INLINE const Voxel &SparseVolume::Sampler::peek(int x, int y, int z) const {
+	return cachedVoxel(glm::ivec3(_posInVolume.x + x, _posInVolume.y + y, _posInVolume.z + z));
+}
+
+CORE_FORCE_INLINE void SparseVolume::Sampler::updateVoxel(bool oldPositionValid) {
+	if (core_unlikely(!oldPositionValid)) {
+		setPosition(_posInVolume);
+		return;
+	}
+	if (core_likely(currentPositionValid())) {
+		_currentVoxel = cachedVoxel(_posInVolume);
+	}
+}
+
+
 inline bool SparseVolume::Sampler::currentPositionValid() const {
 	return !_currentPositionInvalid;
 }
@@ -249,115 +361,217 @@ inline bool SparseVolume::Sampler::setPosition(const glm::ivec3 &v3dNewPos) {
 	return setPosition(v3dNewPos.x, v3dNewPos.y, v3dNewPos.z);
 }
 
+CORE_FORCE_INLINE void SparseVolume::Sampler::movePositiveX(uint32_t offset) {
+	const bool bIsOldPositionValid = currentPositionValid();
+
+	_posInVolume.x += (int)offset;
+
+	if (_volume->_isRegionValid) {
+		if (!region().containsPointInX(_posInVolume.x)) {
+			_currentPositionInvalid |= SAMPLER_INVALIDX;
+		} else {
+			_currentPositionInvalid &= ~SAMPLER_INVALIDX;
+		}
+	}
+
+	// Then we update the voxel pointer
+	updateVoxel(bIsOldPositionValid);
+}
+
+CORE_FORCE_INLINE void SparseVolume::Sampler::movePositiveY(uint32_t offset) {
+	const bool bIsOldPositionValid = currentPositionValid();
+
+	_posInVolume.y += (int)offset;
+
+	if (_volume->_isRegionValid) {
+		if (!region().containsPointInY(_posInVolume.y)) {
+			_currentPositionInvalid |= SAMPLER_INVALIDY;
+		} else {
+			_currentPositionInvalid &= ~SAMPLER_INVALIDY;
+		}
+	}
+
+	// Then we update the voxel pointer
+	updateVoxel(bIsOldPositionValid);
+}
+
+CORE_FORCE_INLINE void SparseVolume::Sampler::movePositiveZ(uint32_t offset) {
+	const bool bIsOldPositionValid = currentPositionValid();
+
+	_posInVolume.z += (int)offset;
+
+	if (_volume->_isRegionValid) {
+		if (!region().containsPointInZ(_posInVolume.z)) {
+			_currentPositionInvalid |= SAMPLER_INVALIDZ;
+		} else {
+			_currentPositionInvalid &= ~SAMPLER_INVALIDZ;
+		}
+	}
+
+	// Then we update the voxel pointer
+	updateVoxel(bIsOldPositionValid);
+}
+
+CORE_FORCE_INLINE void SparseVolume::Sampler::moveNegativeX(uint32_t offset) {
+	const bool bIsOldPositionValid = currentPositionValid();
+
+	_posInVolume.x -= (int)offset;
+
+	if (_volume->_isRegionValid) {
+		if (!region().containsPointInX(_posInVolume.x)) {
+			_currentPositionInvalid |= SAMPLER_INVALIDX;
+		} else {
+			_currentPositionInvalid &= ~SAMPLER_INVALIDX;
+		}
+	}
+
+	// Then we update the voxel pointer
+	updateVoxel(bIsOldPositionValid);
+}
+
+CORE_FORCE_INLINE void SparseVolume::Sampler::moveNegativeY(uint32_t offset) {
+	const bool bIsOldPositionValid = currentPositionValid();
+
+	_posInVolume.y -= (int)offset;
+
+	if (_volume->_isRegionValid) {
+		if (!region().containsPointInY(_posInVolume.y)) {
+			_currentPositionInvalid |= SAMPLER_INVALIDY;
+		} else {
+			_currentPositionInvalid &= ~SAMPLER_INVALIDY;
+		}
+	}
+
+	// Then we update the voxel pointer
+	updateVoxel(bIsOldPositionValid);
+}
+
+CORE_FORCE_INLINE void SparseVolume::Sampler::moveNegativeZ(uint32_t offset) {
+	const bool bIsOldPositionValid = currentPositionValid();
+
+	_posInVolume.z -= (int)offset;
+
+	if (_volume->_isRegionValid) {
+		if (!region().containsPointInZ(_posInVolume.z)) {
+			_currentPositionInvalid |= SAMPLER_INVALIDZ;
+		} else {
+			_currentPositionInvalid &= ~SAMPLER_INVALIDZ;
+		}
+	}
+
+	// Then we update the voxel pointer
+	updateVoxel(bIsOldPositionValid);
+}
+
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx1ny1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
+	return peek(-1, -1, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx1ny0pz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z);
+	return peek(-1, -1, 0);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx1ny1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
+	return peek(-1, -1, 1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx0py1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z - 1);
+	return peek(-1, 0, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx0py0pz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z);
+	return peek(-1, 0, 0);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx0py1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z + 1);
+	return peek(-1, 0, 1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx1py1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
+	return peek(-1, 1, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx1py0pz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z);
+	return peek(-1, 1, 0);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1nx1py1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
+	return peek(-1, 1, 1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px1ny1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
+	return peek(0, -1, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px1ny0pz() const {
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z);
+	return peek(0, -1, 0);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px1ny1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
+	return peek(0, -1, 1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px0py1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z - 1);
+	return peek(0, 0, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px0py0pz() const {
 	if (this->currentPositionValid()) {
 		return _currentVoxel;
 	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z);
+	return cachedVoxel(this->_posInVolume);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px0py1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z + 1);
+	return peek(0, 0, 1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px1py1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
+	return peek(0, 1, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px1py0pz() const {
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z);
+	return peek(0, 1, 0);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel0px1py1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
+	return peek(0, 1, 1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px1ny1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
+	return peek(1, -1, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px1ny0pz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z);
+	return peek(1, -1, 0);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px1ny1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
+	return peek(1, -1, 1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px0py1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z - 1);
+	return peek(1, 0, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px0py0pz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z);
+	return peek(1, 0, 0);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px0py1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z + 1);
+	return peek(1, 0, 1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px1py1nz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
+	return peek(1, 1, -1);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px1py0pz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z);
+	return peek(1, 1, 0);
 }
 
 inline const Voxel &SparseVolume::Sampler::peekVoxel1px1py1pz() const {
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
+	return peek(1, 1, 1);
 }
 
 } // namespace voxel
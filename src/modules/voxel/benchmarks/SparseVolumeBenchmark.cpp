@@ -4,6 +4,7 @@
 
 #include "app/benchmark/AbstractBenchmark.h"
 #include "core/collection/Vector.h"
+#include "voxel/RawVolume.h"
 #include "voxel/SparseVolume.h"
 
 class SparseVolumeBenchmark : public app::AbstractBenchmark {
@@ -74,6 +75,84 @@ BENCHMARK_DEFINE_F(SparseVolumeBenchmark, SetVoxels)(benchmark::State &state) {
 	}
 }
 
+/**
+ * @brief Fills a hollow sphere - similar to the surface of a point cloud or mesh import
+ */
+template<class Volume>
+static void fillSphere(Volume &volume, int size) {
+	const glm::vec3 center(size / 2.0f);
+	const float radius = size / 2.0f - 1.0f;
+	for (int z = 0; z < size; ++z) {
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				const float dist = glm::distance(glm::vec3(x, y, z), center);
+				if (dist <= radius && dist >= radius - 2.0f) {
+					volume.setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Walks the volume like the surface extractors do - peeking into the six face neighbours of every voxel
+ */
+template<class Volume>
+static int countVisibleFaces(const Volume &volume) {
+	const voxel::Region &region = volume.region();
+	typename Volume::Sampler sampler(volume);
+	int faces = 0;
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			sampler.setPosition(region.getLowerX(), y, z);
+			for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				if (!voxel::isAir(sampler.voxel().getMaterial())) {
+					faces += voxel::isAir(sampler.peekVoxel1nx0py0pz().getMaterial());
+					faces += voxel::isAir(sampler.peekVoxel1px0py0pz().getMaterial());
+					faces += voxel::isAir(sampler.peekVoxel0px1ny0pz().getMaterial());
+					faces += voxel::isAir(sampler.peekVoxel0px1py0pz().getMaterial());
+					faces += voxel::isAir(sampler.peekVoxel0px0py1nz().getMaterial());
+					faces += voxel::isAir(sampler.peekVoxel0px0py1pz().getMaterial());
+				}
+				sampler.movePositiveX();
+			}
+		}
+	}
+	return faces;
+}
+
+BENCHMARK_DEFINE_F(SparseVolumeBenchmark, SamplerPeek)(benchmark::State &state) {
+	const int size = (int)state.range(0);
+	voxel::SparseVolume sparse(voxel::Region(0, size - 1));
+	fillSphere(sparse, size);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(countVisibleFaces(sparse));
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)size * size * size);
+}
+
+BENCHMARK_DEFINE_F(SparseVolumeBenchmark, SamplerPeekRawVolume)(benchmark::State &state) {
+	const int size = (int)state.range(0);
+	voxel::RawVolume raw(voxel::Region(0, size - 1));
+	fillSphere(raw, size);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(countVisibleFaces(raw));
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)size * size * size);
+}
+
+BENCHMARK_DEFINE_F(SparseVolumeBenchmark, VisitVoxels)(benchmark::State &state) {
+	const int size = (int)state.range(0);
+	voxel::SparseVolume sparse(voxel::Region(0, size - 1));
+	fillSphere(sparse, size);
+	for (auto _ : state) {
+		int cnt = 0;
+		sparse.visitVoxels([&cnt](const glm::ivec3 &, const voxel::Voxel &) { ++cnt; });
+		benchmark::DoNotOptimize(cnt);
+	}
+	state.SetItemsProcessed(state.iterations() * (int64_t)sparse.size());
+}
+
 BENCHMARK_REGISTER_F(SparseVolumeBenchmark, SetVoxel);
 BENCHMARK_REGISTER_F(SparseVolumeBenchmark, SetVoxelSampler);
 BENCHMARK_REGISTER_F(SparseVolumeBenchmark, SetVoxel_unlimit);
@@ -81,3 +160,6 @@ BENCHMARK_REGISTER_F(SparseVolumeBenchmark, SetVoxelSampler_unlimit);
 BENCHMARK_REGISTER_F(SparseVolumeBenchmark, CalculateRegion);
 BENCHMARK_REGISTER_F(SparseVolumeBenchmark, SetVoxelsY);
 BENCHMARK_REGISTER_F(SparseVolumeBenchmark, SetVoxels);
+BENCHMARK_REGISTER_F(SparseVolumeBenchmark, SamplerPeek)->Arg(64)->Arg(256);
+BENCHMARK_REGISTER_F(SparseVolumeBenchmark, SamplerPeekRawVolume)->Arg(64)->Arg(256);
+BENCHMARK_REGISTER_F(SparseVolumeBenchmark, VisitVoxels)->Arg(64)->Arg(256);
@@ -38,6 +38,7 @@ SOFTWARE.
  */
 
 #include "BinaryGreedyMesher.h"
+#include "OccupancyMask.h"
 #include "app/Async.h"
 #include "core/Trace.h"
 #include "core/collection/Array.h"
@@ -141,82 +142,65 @@ CORE_FORCE_INLINE bool solid_check<0>(const voxel::Voxel &voxel) {
  * - First 4: Cardinal directions (up, down, left, right)
  * - Last 4: Diagonal directions (corners)
  *
- * Used by compare_ao() to check if two adjacent voxels have the same AO environment,
+ * Used by ao_difference() to check if two adjacent voxels have the same AO environment,
  * which determines if they can be merged into a single quad.
- *
- * The AO calculation samples these neighbors to determine how much ambient light
- * reaches each vertex of a face.
  */
 static const glm::ivec2 ao_dirs[8] = {
 	glm::ivec2(-1, 0),	glm::ivec2(0, -1), glm::ivec2(0, 1),  glm::ivec2(1, 0),
 	glm::ivec2(-1, -1), glm::ivec2(-1, 1), glm::ivec2(1, -1), glm::ivec2(1, 1),
 };
 
+using BinaryMesherInput = core::DynamicArray<Voxel>;
+
 /**
- * @brief Calculates ambient occlusion value for a vertex
- *
- * Uses the standard voxel AO formula based on neighboring voxel occupancy.
- *
- * The formula considers three neighbors around each vertex:
- * - Two adjacent (side) voxels
- * - One diagonal (corner) voxel
- *
- * Special case: If both side voxels are occupied, the corner is fully occluded
- * regardless of whether the diagonal voxel exists. This prevents light bleeding
- * through diagonal gaps.
- *
- * Visual representation (top-down view of a vertex):
- * @code
- *     [side2]
- *        |
- * [corner]--[VERTEX]--[face]
- *        |
- *     [side1]
- * @endcode
- *
- * @param side1 Is the first adjacent side occupied? (0 or 1)
- * @param side2 Is the second adjacent side occupied? (0 or 1)
- * @param corner Is the diagonal corner occupied? (0 or 1)
- * @return AO value from 0 (fully occluded/dark) to 3 (no occlusion/bright)
+ * @brief Occupancy columns along the depth axis of each face orientation
  *
- * @note The corner is only checked if at least one side is empty.
- *       This is because if both sides are solid, light cannot reach
- *       the corner anyway (prevents light leaking).
+ * Bit @c c of the row @c (axis*CS_P2 + right*CS_P + forward) is set if the voxel at
+ * @c get_axis_i(axis,right,forward,c) passes the @c solid_check(). The columns are filled
+ * while building the face masks and replace the voxel lookups for the ambient occlusion.
  */
-CORE_FORCE_INLINE int vertexAO(uint8_t side1, uint8_t side2, uint8_t corner) {
-	return (side1 && side2) ? 0 : (3 - (side1 + side2 + corner));
+CORE_FORCE_INLINE uint64_t occupancy_column(const OccupancyMask &occupancy, int axis, int right, int forward) {
+	return *occupancy.row(axis * CS_P2 + right * CS_P + forward);
 }
 
-using BinaryMesherInput = core::DynamicArray<Voxel>;
-
 /**
- * @brief Checks if ambient occlusion values match between two positions
- *
- * For quads to be merged, their ambient occlusion must be consistent.
- * This function compares all 8 AO sampling directions around two positions
- * to ensure they would produce identical AO values.
- *
- * @tparam MeshType Type of mesh being generated
- * @param voxels The voxel data buffer
- * @param axis Current axis being processed
- * @param forward Forward position in current sweep
- * @param right Right position in current sweep
- * @param c Depth position (perpendicular to face)
+ * @brief Checks if ambient occlusion values match between two positions for a whole column
+ *
+ * For quads to be merged, their ambient occlusion must be consistent. This compares all 8 AO
+ * sampling directions around two positions for all depth values at once.
+ *
  * @param forward_offset Offset to compare in forward direction
  * @param right_offset Offset to compare in right direction
- * @return true if AO values match and quads can be merged
+ * @return Bit @c c is set if the AO values at depth @c c differ and the quads can't be merged
  */
-template<int MeshType>
-CORE_FORCE_INLINE bool compare_ao(const BinaryMesherInput &voxels, int axis, int forward, int right, int c,
-								  int forward_offset, int right_offset) {
+CORE_FORCE_INLINE uint64_t ao_difference(const OccupancyMask &occupancy, int axis, int forward, int right,
+										 int forward_offset, int right_offset) {
+	uint64_t diff = 0;
 	for (const auto &ao_dir : ao_dirs) {
-		if (solid_check<MeshType>(voxels[get_axis_i(axis, right + ao_dir[0], forward + ao_dir[1], c)]) !=
-			solid_check<MeshType>(
-				voxels[get_axis_i(axis, right + right_offset + ao_dir[0], forward + forward_offset + ao_dir[1], c)])) {
-			return false;
-		}
+		diff |= occupancy_column(occupancy, axis, right + ao_dir[0], forward + ao_dir[1]) ^
+				occupancy_column(occupancy, axis, right + right_offset + ao_dir[0],
+								 forward + forward_offset + ao_dir[1]);
 	}
-	return true;
+	return diff;
+}
+
+/**
+ * @brief Collects the eight neighbours of a face in the layer @c c for @c faceAmbientOcclusion()
+ *
+ * The diagonal corners are only taken into account if both adjacent sides are empty.
+ */
+CORE_FORCE_INLINE uint8_t ao_neighbours(const OccupancyMask &occupancy, int axis, int forward, int right, int c) {
+	const uint8_t f = (occupancy_column(occupancy, axis, right, forward - 1) >> c) & 1u;
+	const uint8_t b = (occupancy_column(occupancy, axis, right, forward + 1) >> c) & 1u;
+	const uint8_t l = (occupancy_column(occupancy, axis, right - 1, forward) >> c) & 1u;
+	const uint8_t r = (occupancy_column(occupancy, axis, right + 1, forward) >> c) & 1u;
+	const uint8_t lf = !l && !f && ((occupancy_column(occupancy, axis, right - 1, forward - 1) >> c) & 1u);
+	const uint8_t lb = !l && !b && ((occupancy_column(occupancy, axis, right - 1, forward + 1) >> c) & 1u);
+	const uint8_t rf = !r && !f && ((occupancy_column(occupancy, axis, right + 1, forward - 1) >> c) & 1u);
+	const uint8_t rb = !r && !b && ((occupancy_column(occupancy, axis, right + 1, forward + 1) >> c) & 1u);
+	return (l << FaceNeighbourLeft) | (r << FaceNeighbourRight) | (f << FaceNeighbourFront) |
+		   (b << FaceNeighbourBack) | (lf << FaceNeighbourLeftFront) | (lb << FaceNeighbourLeftBack) |
+		   (rf << FaceNeighbourRightFront) | (rb << FaceNeighbourRightBack);
 }
 
 /**
@@ -418,6 +402,12 @@ void extractBinaryGreedyMeshType(const glm::ivec3 &translate, bool ambientOcclus
 	 */
 	alignas(16) core::Array<uint64_t, CS_P2> a_axis_cols({});
 
+	/**
+	 * occupancy: The solid columns along the depth axis of all three face orientations - see
+	 * occupancy_column(). Only needed for the ambient occlusion.
+	 */
+	OccupancyMask occupancy(CS_P, ambientOcclusion ? CS_P2 * 3 : 0);
+
 	// === PHASE 1: Build binary columns and cull faces ===
 	// This phase iterates through all voxels once, building 64-bit occupancy
 	// columns and simultaneously performing face culling via bitwise operations.
@@ -446,6 +436,14 @@ void extractBinaryGreedyMeshType(const glm::ivec3 &translate, bool ambientOcclus
 			col_face_masks[a + (b * CS_P) + (4 * CS_P2)] = cb & ~((cb >> 1) | CULL_MASK);
 			// Positive direction: shift left and compare
 			col_face_masks[a + (b * CS_P) + (5 * CS_P2)] = cb & ~((cb << 1) | 1ULL);
+			if (ambientOcclusion) {
+				*occupancy.row(2 * CS_P2 + a * CS_P + b) = cb;
+			}
+		}
+		if (ambientOcclusion) {
+			for (int c = 0; c < CS_P; ++c) {
+				*occupancy.row(CS_P2 + c * CS_P + a) = b_axis_cols[c];
+			}
 		}
 
 		// Cull faces in the second (b) axis direction
@@ -468,6 +466,14 @@ void extractBinaryGreedyMeshType(const glm::ivec3 &translate, bool ambientOcclus
 		}
 	}
 
+	if (ambientOcclusion) {
+		for (int right = 0; right < CS_P; ++right) {
+			for (int forward = 0; forward < CS_P; ++forward) {
+				*occupancy.row(right * CS_P + forward) = a_axis_cols[right + forward * CS_P];
+			}
+		}
+	}
+
 	// === PHASE 2 & 3: Greedy meshing for each face direction ===
 	//
 	// For each of the 6 face directions, we perform greedy merging to combine
@@ -531,23 +537,37 @@ void extractBinaryGreedyMeshType(const glm::ivec3 &translate, bool ambientOcclus
 				uint64_t bits_merging_forward = bits_here & bits_forward & ~bits_walking_right;
 				const uint64_t bits_merging_right = bits_here & bits_right;
 
-				unsigned long bit_pos;
+				/**
+				 * Bits of the depth axis where the AO environment differs from the
+				 * next row or column - shifted to the face position (the AO is
+				 * sampled at bit_pos + air_dir)
+				 */
+				uint64_t ao_blocked_forward = 0;
+				uint64_t ao_blocked_right = 0;
+				if (ambientOcclusion) {
+					if (bits_merging_forward) {
+						const uint64_t diff = ao_difference(occupancy, axis, forward, right, 1, 0);
+						ao_blocked_forward = air_dir > 0 ? diff >> 1 : diff << 1;
+					}
+					if (bits_merging_right) {
+						const uint64_t diff = ao_difference(occupancy, axis, forward, right, 0, 1);
+						ao_blocked_right = air_dir > 0 ? diff >> 1 : diff << 1;
+					}
+				}
+
+				int bit_pos;
 
 				/**
 				 * Process faces that can merge forward.
 				 *
-				 * Uses __builtin_ctzll (Count Trailing Zeros) to efficiently find
+				 * Uses lowestBit() (Count Trailing Zeros) to efficiently find
 				 * the position of the lowest set bit. This is a key optimization
 				 * that allows processing only the bits that are actually set,
 				 * skipping empty positions entirely.
 				 */
 				uint64_t copy_front = bits_merging_forward;
 				while (copy_front) {
-#ifdef _MSC_VER
-					_BitScanForward64(&bit_pos, copy_front);
-#else
-					bit_pos = __builtin_ctzll(copy_front);
-#endif
+					bit_pos = lowestBit(copy_front);
 
 					copy_front &= ~(1ULL << bit_pos);
 
@@ -561,8 +581,7 @@ void extractBinaryGreedyMeshType(const glm::ivec3 &translate, bool ambientOcclus
 					 */
 					if (voxels[get_axis_i(axis, right, forward, bit_pos)].isSame(
 							voxels[get_axis_i(axis, right, forward + 1, bit_pos)]) &&
-						(!ambientOcclusion ||
-						 compare_ao<MeshType>(voxels, axis, forward, right, bit_pos + air_dir, 1, 0))) {
+						(ao_blocked_forward & (1ULL << bit_pos)) == 0) {
 						merged_forward[(right * CS_P) + bit_pos]++;
 					} else {
 						// Can't merge, remove from merging set
@@ -582,11 +601,7 @@ void extractBinaryGreedyMeshType(const glm::ivec3 &translate, bool ambientOcclus
 				 */
 				uint64_t bits_stopped_forward = bits_here & ~bits_merging_forward;
 				while (bits_stopped_forward) {
-#ifdef _MSC_VER
-					_BitScanForward64(&bit_pos, bits_stopped_forward);
-#else
-					bit_pos = __builtin_ctzll(bits_stopped_forward);
-#endif
+					bit_pos = lowestBit(bits_stopped_forward);
 
 					bits_stopped_forward &= ~(1ULL << bit_pos);
 
@@ -604,8 +619,7 @@ void extractBinaryGreedyMeshType(const glm::ivec3 &translate, bool ambientOcclus
 					if ((bits_merging_right & (1ULL << bit_pos)) != 0 &&
 						(merged_forward[(right * CS_P) + bit_pos] == merged_forward[(right + 1) * CS_P + bit_pos]) &&
 						(type.isSame(voxels[get_axis_i(axis, right + 1, forward, bit_pos)])) &&
-						(!ambientOcclusion ||
-						 compare_ao<MeshType>(voxels, axis, forward, right, bit_pos + air_dir, 0, 1))) {
+						(ao_blocked_right & (1ULL << bit_pos)) == 0) {
 						bits_walking_right |= 1ULL << bit_pos;
 						merged_right[bit_pos]++;
 						merged_forward[rightxCS_P + bit_pos] = 0;
@@ -631,39 +645,17 @@ void extractBinaryGreedyMeshType(const glm::ivec3 &translate, bool ambientOcclus
 					 * Calculate ambient occlusion for all four corners of the quad.
 					 *
 					 * AO is sampled from the voxel layer on the "air" side of the face
-					 * (bit_pos + air_dir). For each corner, we check:
-					 * - Two adjacent cardinal neighbors (ao_L, ao_R, ao_F, ao_B)
-					 * - One diagonal neighbor (only if both adjacent are empty)
-					 *
-					 * The corner neighbors (ao_LFC, ao_RBC, etc.) are only checked
-					 * when both adjacent sides are empty, as per the vertexAO formula.
+					 * (bit_pos + air_dir). The eight neighbours in that layer are gathered
+					 * from the occupancy columns and all four corners are looked up at once.
 					 */
 					uint8_t ao_LB = 3, ao_RB = 3, ao_RF = 3, ao_LF = 3;
 					if (ambientOcclusion) {
-						const int c = bit_pos + air_dir;
-
-						// Sample adjacent voxels in cardinal directions
-						const uint8_t ao_F = solid_check<MeshType>(voxels[get_axis_i(axis, right, forward - 1, c)]);
-						const uint8_t ao_B = solid_check<MeshType>(voxels[get_axis_i(axis, right, forward + 1, c)]);
-						const uint8_t ao_L = solid_check<MeshType>(voxels[get_axis_i(axis, right - 1, forward, c)]);
-						const uint8_t ao_R = solid_check<MeshType>(voxels[get_axis_i(axis, right + 1, forward, c)]);
-
-						// Sample diagonal corners (only if both adjacent sides are empty)
-						// This optimization prevents unnecessary lookups and matches the AO formula
-						uint8_t ao_LFC = !ao_L && !ao_F &&
-										 solid_check<MeshType>(voxels[get_axis_i(axis, right - 1, forward - 1, c)]);
-						uint8_t ao_LBC = !ao_L && !ao_B &&
-										 solid_check<MeshType>(voxels[get_axis_i(axis, right - 1, forward + 1, c)]);
-						uint8_t ao_RFC = !ao_R && !ao_F &&
-										 solid_check<MeshType>(voxels[get_axis_i(axis, right + 1, forward - 1, c)]);
-						uint8_t ao_RBC = !ao_R && !ao_B &&
-										 solid_check<MeshType>(voxels[get_axis_i(axis, right + 1, forward + 1, c)]);
-
-						// Calculate AO values for each vertex
-						ao_LB = vertexAO(ao_L, ao_B, ao_LBC);
-						ao_RB = vertexAO(ao_R, ao_B, ao_RBC);
-						ao_RF = vertexAO(ao_R, ao_F, ao_RFC);
-						ao_LF = vertexAO(ao_L, ao_F, ao_LFC);
+						const uint8_t ao = faceAmbientOcclusion(
+							ao_neighbours(occupancy, axis, forward, right, bit_pos + air_dir));
+						ao_LB = faceCornerAmbientOcclusion(ao, FaceCornerLeftBack);
+						ao_RB = faceCornerAmbientOcclusion(ao, FaceCornerRightBack);
+						ao_RF = faceCornerAmbientOcclusion(ao, FaceCornerRightFront);
+						ao_LF = faceCornerAmbientOcclusion(ao, FaceCornerLeftFront);
 					}
 
 					// Reset merge counters for next iteration
@@ -3,6 +3,7 @@
  */
 
 #include "CubicSurfaceExtractor.h"
+#include "OccupancyMask.h"
 #include "app/Async.h"
 #include "core/Common.h"
 #include "core/concurrent/Atomic.h"
@@ -117,6 +118,113 @@ static CORE_FORCE_INLINE bool isTransparentQuadNeeded(VoxelType back, VoxelType
 	return !isTransparent(front);
 }
 
+/**
+ * @return The index of the mesh that gets the quad between the two voxels - @c -1 if no quad is needed
+ */
+static CORE_FORCE_INLINE int quadMesh(VoxelType back, VoxelType front, FaceNames face) {
+	if (isQuadNeeded(back, front, face)) {
+		return 0;
+	}
+	if (isTransparentQuadNeeded(back, front, face)) {
+		return 1;
+	}
+	return -1;
+}
+
+/**
+ * @brief The occupancy of one z slice of the extraction region - including a border of one voxel
+ */
+struct OccupancySlice {
+	/** the voxels that occlude the vertices of their neighbours */
+	OccupancyMask solid;
+	OccupancyMask transparent;
+
+	OccupancySlice(int width, int height) : solid(width, height), transparent(width, height) {
+	}
+};
+
+static void fillOccupancySlice(const RawVolume *volData, int x, int y, int z, OccupancySlice &slice) {
+	core_trace_scoped(FillOccupancySlice);
+	slice.solid.clear();
+	slice.transparent.clear();
+	const int width = slice.solid.width();
+	RawVolume::Sampler sampler(volData);
+	for (int row = 0; row < slice.solid.height(); ++row) {
+		uint64_t *solid = slice.solid.row(row);
+		uint64_t *transparent = slice.transparent.row(row);
+		sampler.setPosition(x, y + row, z);
+		for (int i = 0; i < width; ++i) {
+			const VoxelType material = sampler.voxel().getMaterial();
+			if (material == VoxelType::Generic) {
+				solid[i >> 6] |= 1ull << (i & 63);
+			} else if (isTransparent(material)) {
+				transparent[i >> 6] |= 1ull << (i & 63);
+			}
+			sampler.movePositiveX();
+		}
+	}
+}
+
+/**
+ * @brief The bit of a neighbour in the mask returned by @c occupancyNeighbourhood()
+ */
+static constexpr int neighbourBit(int x, int y, int z) {
+	return (x + 1) + (y + 1) * 3 + (z + 1) * 9;
+}
+
+/**
+ * @name Neighbours of the current voxel
+ * @{
+ */
+static constexpr int Left = neighbourBit(-1, 0, 0);
+static constexpr int Right = neighbourBit(1, 0, 0);
+static constexpr int Below = neighbourBit(0, -1, 0);
+static constexpr int Above = neighbourBit(0, 1, 0);
+static constexpr int Before = neighbourBit(0, 0, -1);
+static constexpr int Behind = neighbourBit(0, 0, 1);
+static constexpr int BelowLeft = neighbourBit(-1, -1, 0);
+static constexpr int BelowRight = neighbourBit(1, -1, 0);
+static constexpr int AboveLeft = neighbourBit(-1, 1, 0);
+static constexpr int AboveRight = neighbourBit(1, 1, 0);
+static constexpr int LeftBefore = neighbourBit(-1, 0, -1);
+static constexpr int RightBefore = neighbourBit(1, 0, -1);
+static constexpr int LeftBehind = neighbourBit(-1, 0, 1);
+static constexpr int RightBehind = neighbourBit(1, 0, 1);
+static constexpr int BelowBefore = neighbourBit(0, -1, -1);
+static constexpr int AboveBefore = neighbourBit(0, 1, -1);
+static constexpr int BelowBehind = neighbourBit(0, -1, 1);
+static constexpr int AboveBehind = neighbourBit(0, 1, 1);
+static constexpr int BelowLeftBefore = neighbourBit(-1, -1, -1);
+static constexpr int BelowRightBefore = neighbourBit(1, -1, -1);
+static constexpr int AboveLeftBefore = neighbourBit(-1, 1, -1);
+static constexpr int AboveRightBefore = neighbourBit(1, 1, -1);
+static constexpr int BelowLeftBehind = neighbourBit(-1, -1, 1);
+static constexpr int BelowRightBehind = neighbourBit(1, -1, 1);
+static constexpr int AboveLeftBehind = neighbourBit(-1, 1, 1);
+/** @} */
+
+/**
+ * @brief The occluding voxels of the 3x3x3 neighbourhood of a voxel
+ * @param slices The slices before, at and behind the voxel
+ * @param regX The x position of the voxel in the region - the voxel is at bit @c regX+1 of the mask row
+ * @param row The mask row of the voxel
+ * @sa neighbourBit()
+ */
+static CORE_FORCE_INLINE uint32_t occupancyNeighbourhood(OccupancySlice *const slices[3], int regX, int row) {
+	uint32_t neighbours = 0u;
+	for (int z = 0; z < 3; ++z) {
+		const OccupancyMask &solid = slices[z]->solid;
+		neighbours |= solid.bits3(regX, row - 1) << (z * 9);
+		neighbours |= solid.bits3(regX, row) << (3 + z * 9);
+		neighbours |= solid.bits3(regX, row + 1) << (6 + z * 9);
+	}
+	return neighbours;
+}
+
+static CORE_FORCE_INLINE uint8_t cornerAO(uint32_t neighbours, int side1, int side2, int corner) {
+	return vertexAmbientOcclusion((neighbours >> side1) & 1u, (neighbours >> side2) & 1u, (neighbours >> corner) & 1u);
+}
+
 static CORE_FORCE_INLINE bool isSameVertex(const VoxelVertex& v1, const VoxelVertex& v2) {
 	return v1.colorIndex == v2.colorIndex && v1.info == v2.info && v1.normalIndex == v2.normalIndex;
 }
@@ -296,24 +404,6 @@ static bool performQuadMerging(QuadList &quads, Mesh *meshCurrent) {
 	return didMerge;
 }
 
-/**
- * @brief We are checking the voxels above us. There are four possible ambient occlusion values
- * for a vertex.
- *
- * @li https://0fps.net/2013/07/03/ambient-occlusion-for-minecraft-like-worlds/
- * @li https://www.reddit.com/r/gamedev/comments/1gvk18/comment/cao9n91/
- *
- * There are four states for the ambient occlusion value.
- * @li @c 0: full occluded in the corner of three voxels
- * @li @c 3: no occluded at all
- */
-CORE_FORCE_INLINE uint8_t vertexAmbientOcclusion(bool side1, bool side2, bool corner) {
-	if (side1 && side2) {
-		return 0;
-	}
-	return 3 - (side1 + side2 + corner);
-}
-
 /**
  * @note Notice that the ambient occlusion is different for the vertices on the side than it is for the
  * vertices on the top and bottom. To fix this, we just need to pick a consistent orientation for
@@ -362,13 +452,8 @@ static void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadLi
 }
 
 static IndexType addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, const Voxel& materialIn, Array& existingVertices,
-		Mesh* meshCurrent, const VoxelType face1, const VoxelType face2, const VoxelType corner, const glm::ivec3& offset) {
+		Mesh* meshCurrent, uint8_t ambientOcclusion, const glm::ivec3& offset) {
 	core_trace_scoped(AddVertex);
-	const uint8_t ambientOcclusion = vertexAmbientOcclusion(
-		!isAir(face1) && !isTransparent(face1),
-		!isAir(face2) && !isTransparent(face2),
-		!isAir(corner) && !isTransparent(corner));
-
 	for (uint32_t ct = 0; ct < MaxVerticesPerPosition; ++ct) {
 		VertexData& entry = existingVertices(x, y, ct);
 
@@ -442,288 +527,201 @@ void extractCubicMesh(const voxel::RawVolume *volData, const Region &region, Chu
 	vecQuadsT[core::enumVal(FaceNames::NegativeZ)].resize(zSize);
 	vecQuadsT[core::enumVal(FaceNames::PositiveZ)].resize(zSize);
 
-	voxel::RawVolume::Sampler volumeSampler(volData);
-
 	{
 	core_trace_scoped(QuadGeneration);
-	volumeSampler.setPosition(offset);
 
 	const uint32_t w = upper.x - offset.x;
 	const uint32_t h = upper.y - offset.y;
 	const uint32_t d = upper.z - offset.z;
 
-	for (uint32_t regZ = 0; regZ <= d; ++regZ) {
-		voxel::RawVolume::Sampler volumeSampler2 = volumeSampler;
-		for (uint32_t regY = 0; regY <= h; ++regY) {
-			voxel::RawVolume::Sampler volumeSampler3 = volumeSampler2;
-			for (uint32_t regX = 0; regX <= w; ++regX) {
-
-				/**
-				 *
-				 *
-				 *                  [D]
-				 *            8 ____________ 7
-				 *             /|          /|
-				 *            / |         / |              ABOVE [D] |
-				 *           /  |    [F] /  |              BELOW [C]
-				 *        5 /___|_______/ 6 |  [B]       y           BEHIND  [F]
-				 *    [A]   |   |_______|___|              |      z  BEFORE [E] /
-				 *          | 4 /       |   / 3            |   /
-				 *          |  / [E]    |  /               |  /   . center
-				 *          | /         | /                | /
-				 *          |/__________|/                 |/________   LEFT  RIGHT
-				 *        1               2                          x   [A] - [B]
-				 *               [C]
-				 */
-
-				const Voxel& voxelCurrent          = volumeSampler3.voxel();
-				const Voxel& voxelLeft             = volumeSampler3.peekVoxel1nx0py0pz();
-				const Voxel& voxelBefore           = volumeSampler3.peekVoxel0px0py1nz();
-				const Voxel& voxelLeftBefore       = volumeSampler3.peekVoxel1nx0py1nz();
-				const Voxel& voxelRightBefore      = volumeSampler3.peekVoxel1px0py1nz();
-				const Voxel& voxelLeftBehind       = volumeSampler3.peekVoxel1nx0py1pz();
-
-				const Voxel& voxelAboveLeft        = volumeSampler3.peekVoxel1nx1py0pz();
-				const Voxel& voxelAboveBefore      = volumeSampler3.peekVoxel0px1py1nz();
-				const Voxel& voxelAboveLeftBefore  = volumeSampler3.peekVoxel1nx1py1nz();
-				const Voxel& voxelAboveRightBefore = volumeSampler3.peekVoxel1px1py1nz();
-				const Voxel& voxelAboveLeftBehind  = volumeSampler3.peekVoxel1nx1py1pz();
-
-				const Voxel& voxelBelow            = volumeSampler3.peekVoxel0px1ny0pz();
-				const Voxel& voxelBelowLeft        = volumeSampler3.peekVoxel1nx1ny0pz();
-				const Voxel& voxelBelowBefore      = volumeSampler3.peekVoxel0px1ny1nz();
-				const Voxel& voxelBelowLeftBefore  = volumeSampler3.peekVoxel1nx1ny1nz();
-				const Voxel& voxelBelowRightBefore = volumeSampler3.peekVoxel1px1ny1nz();
-				const Voxel& voxelBelowLeftBehind  = volumeSampler3.peekVoxel1nx1ny1pz();
-
-				const VoxelType voxelCurrentMaterial          = voxelCurrent.getMaterial();
-				const VoxelType voxelLeftMaterial             = voxelLeft.getMaterial();
-				const VoxelType voxelBelowMaterial            = voxelBelow.getMaterial();
-				const VoxelType voxelBeforeMaterial           = voxelBefore.getMaterial();
-				const VoxelType voxelLeftBeforeMaterial       = voxelLeftBefore.getMaterial();
-				const VoxelType voxelBelowLeftMaterial        = voxelBelowLeft.getMaterial();
-				const VoxelType voxelBelowLeftBeforeMaterial  = voxelBelowLeftBefore.getMaterial();
-				const VoxelType voxelLeftBehindMaterial       = voxelLeftBehind.getMaterial();
-				const VoxelType voxelBelowLeftBehindMaterial  = voxelBelowLeftBehind.getMaterial();
-				const VoxelType voxelAboveLeftMaterial        = voxelAboveLeft.getMaterial();
-				const VoxelType voxelAboveLeftBehindMaterial  = voxelAboveLeftBehind.getMaterial();
-				const VoxelType voxelAboveLeftBeforeMaterial  = voxelAboveLeftBefore.getMaterial();
-
-				// X [A] LEFT
-				if (isQuadNeeded(voxelCurrentMaterial, voxelLeftMaterial, FaceNames::NegativeX)) {
-					const IndexType v_0_1 = addVertex(reuseVertices, regX, regY,     regZ,     voxelCurrent, previousSliceVertices, &result->mesh[0],
-							voxelLeftBeforeMaterial, voxelBelowLeftMaterial, voxelBelowLeftBeforeMaterial, translate);
-					const IndexType v_1_4 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelCurrent, currentSliceVertices,  &result->mesh[0],
-							voxelBelowLeftMaterial, voxelLeftBehindMaterial, voxelBelowLeftBehindMaterial, translate);
-					const IndexType v_2_8 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelCurrent, currentSliceVertices,  &result->mesh[0],
-							voxelLeftBehindMaterial, voxelAboveLeftMaterial, voxelAboveLeftBehindMaterial, translate);
-					const IndexType v_3_5 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelCurrent, previousSliceVertices, &result->mesh[0],
-							voxelAboveLeftMaterial, voxelLeftBeforeMaterial, voxelAboveLeftBeforeMaterial, translate);
-					vecQuads[core::enumVal(FaceNames::NegativeX)][regX].emplace_back(v_0_1, v_1_4, v_2_8, v_3_5);
-				} else if (isTransparentQuadNeeded(voxelCurrentMaterial, voxelLeftMaterial, FaceNames::NegativeX)) {
-					const IndexType v_0_1 = addVertex(reuseVertices, regX, regY,     regZ,     voxelCurrent, previousSliceVerticesT, &result->mesh[1],
-							voxelLeftBeforeMaterial, voxelBelowLeftMaterial, voxelBelowLeftBeforeMaterial, translate);
-					const IndexType v_1_4 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelCurrent, currentSliceVerticesT,  &result->mesh[1],
-							voxelBelowLeftMaterial, voxelLeftBehindMaterial, voxelBelowLeftBehindMaterial, translate);
-					const IndexType v_2_8 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelCurrent, currentSliceVerticesT,  &result->mesh[1],
-							voxelLeftBehindMaterial, voxelAboveLeftMaterial, voxelAboveLeftBehindMaterial, translate);
-					const IndexType v_3_5 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelCurrent, previousSliceVerticesT, &result->mesh[1],
-							voxelAboveLeftMaterial, voxelLeftBeforeMaterial, voxelAboveLeftBeforeMaterial, translate);
-					vecQuadsT[core::enumVal(FaceNames::NegativeX)][regX].emplace_back(v_0_1, v_1_4, v_2_8, v_3_5);
-				}
-
-				// X [B] RIGHT
-				if (isQuadNeeded(voxelLeftMaterial, voxelCurrentMaterial, FaceNames::PositiveX)) {
-					const VoxelType _voxelRightBehind      = volumeSampler3.peekVoxel0px0py1pz().getMaterial();
-					const VoxelType _voxelAboveRight       = volumeSampler3.peekVoxel0px1py0pz().getMaterial();
-					const VoxelType _voxelAboveRightBehind = volumeSampler3.peekVoxel0px1py1pz().getMaterial();
-					const VoxelType _voxelBelowRightBehind = volumeSampler3.peekVoxel0px1ny1pz().getMaterial();
-
-					const VoxelType _voxelAboveRightBefore = voxelAboveBefore.getMaterial();
-					const VoxelType _voxelBelowRightBefore = voxelBelowBefore.getMaterial();
-
-					const IndexType v_0_2 = addVertex(reuseVertices, regX, regY,     regZ,     voxelLeft, previousSliceVertices, &result->mesh[0],
-							voxelBelowMaterial, voxelBeforeMaterial, _voxelBelowRightBefore, translate);
-					const IndexType v_1_3 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelLeft, currentSliceVertices,  &result->mesh[0],
-							voxelBelowMaterial, _voxelRightBehind, _voxelBelowRightBehind, translate);
-					const IndexType v_2_7 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelLeft, currentSliceVertices,  &result->mesh[0],
-							_voxelAboveRight, _voxelRightBehind, _voxelAboveRightBehind, translate);
-					const IndexType v_3_6 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelLeft, previousSliceVertices, &result->mesh[0],
-							_voxelAboveRight, voxelBeforeMaterial, _voxelAboveRightBefore, translate);
-					vecQuads[core::enumVal(FaceNames::PositiveX)][regX].emplace_back(v_0_2, v_3_6, v_2_7, v_1_3);
-				} else if (isTransparentQuadNeeded(voxelLeftMaterial, voxelCurrentMaterial, FaceNames::PositiveX)) {
-					const VoxelType _voxelRightBehind      = volumeSampler3.peekVoxel0px0py1pz().getMaterial();
-					const VoxelType _voxelAboveRight       = volumeSampler3.peekVoxel0px1py0pz().getMaterial();
-					const VoxelType _voxelAboveRightBehind = volumeSampler3.peekVoxel0px1py1pz().getMaterial();
-					const VoxelType _voxelBelowRightBehind = volumeSampler3.peekVoxel0px1ny1pz().getMaterial();
-
-					const VoxelType _voxelAboveRightBefore = voxelAboveBefore.getMaterial();
-					const VoxelType _voxelBelowRightBefore = voxelBelowBefore.getMaterial();
-
-					const IndexType v_0_2 = addVertex(reuseVertices, regX, regY,     regZ,     voxelLeft, previousSliceVerticesT, &result->mesh[1],
-							voxelBelowMaterial, voxelBeforeMaterial, _voxelBelowRightBefore, translate);
-					const IndexType v_1_3 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelLeft, currentSliceVerticesT,  &result->mesh[1],
-							voxelBelowMaterial, _voxelRightBehind, _voxelBelowRightBehind, translate);
-					const IndexType v_2_7 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelLeft, currentSliceVerticesT,  &result->mesh[1],
-							_voxelAboveRight, _voxelRightBehind, _voxelAboveRightBehind, translate);
-					const IndexType v_3_6 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelLeft, previousSliceVerticesT, &result->mesh[1],
-							_voxelAboveRight, voxelBeforeMaterial, _voxelAboveRightBefore, translate);
-					vecQuadsT[core::enumVal(FaceNames::PositiveX)][regX].emplace_back(v_0_2, v_3_6, v_2_7, v_1_3);
-				}
-
-				// Y [C] BELOW
-				if (isQuadNeeded(voxelCurrentMaterial, voxelBelowMaterial, FaceNames::NegativeY)) {
-					const Voxel& voxelBelowRightBehind = volumeSampler3.peekVoxel1px1ny1pz();
-					const Voxel& voxelBelowRight       = volumeSampler3.peekVoxel1px1ny0pz();
-					const Voxel& voxelBelowBehind      = volumeSampler3.peekVoxel0px1ny1pz();
-
-					const VoxelType voxelBelowRightMaterial       = voxelBelowRight.getMaterial();
-					const VoxelType voxelBelowBeforeMaterial      = voxelBelowBefore.getMaterial();
-					const VoxelType voxelBelowRightBeforeMaterial = voxelBelowRightBefore.getMaterial();
-					const VoxelType voxelBelowBehindMaterial      = voxelBelowBehind.getMaterial();
-					const VoxelType voxelBelowRightBehindMaterial = voxelBelowRightBehind.getMaterial();
-
-					const IndexType v_0_1 = addVertex(reuseVertices, regX,     regY, regZ,     voxelCurrent, previousSliceVertices, &result->mesh[0],
-							voxelBelowBeforeMaterial, voxelBelowLeftMaterial, voxelBelowLeftBeforeMaterial, translate);
-					const IndexType v_1_2 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelCurrent, previousSliceVertices, &result->mesh[0],
-							voxelBelowRightMaterial, voxelBelowBeforeMaterial, voxelBelowRightBeforeMaterial, translate);
-					const IndexType v_2_3 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelCurrent, currentSliceVertices,  &result->mesh[0],
-							voxelBelowBehindMaterial, voxelBelowRightMaterial, voxelBelowRightBehindMaterial, translate);
-					const IndexType v_3_4 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelCurrent, currentSliceVertices,  &result->mesh[0],
-							voxelBelowLeftMaterial, voxelBelowBehindMaterial, voxelBelowLeftBehindMaterial, translate);
-					vecQuads[core::enumVal(FaceNames::NegativeY)][regY].emplace_back(v_0_1, v_1_2, v_2_3, v_3_4);
-				} else if (isTransparentQuadNeeded(voxelCurrentMaterial, voxelBelowMaterial, FaceNames::NegativeY)) {
-					const Voxel& voxelBelowRightBehind = volumeSampler3.peekVoxel1px1ny1pz();
-					const Voxel& voxelBelowRight       = volumeSampler3.peekVoxel1px1ny0pz();
-					const Voxel& voxelBelowBehind      = volumeSampler3.peekVoxel0px1ny1pz();
-
-					const VoxelType voxelBelowRightMaterial       = voxelBelowRight.getMaterial();
-					const VoxelType voxelBelowBeforeMaterial      = voxelBelowBefore.getMaterial();
-					const VoxelType voxelBelowRightBeforeMaterial = voxelBelowRightBefore.getMaterial();
-					const VoxelType voxelBelowBehindMaterial      = voxelBelowBehind.getMaterial();
-					const VoxelType voxelBelowRightBehindMaterial = voxelBelowRightBehind.getMaterial();
-
-					const IndexType v_0_1 = addVertex(reuseVertices, regX,     regY, regZ,     voxelCurrent, previousSliceVerticesT, &result->mesh[1],
-							voxelBelowBeforeMaterial, voxelBelowLeftMaterial, voxelBelowLeftBeforeMaterial, translate);
-					const IndexType v_1_2 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelCurrent, previousSliceVerticesT, &result->mesh[1],
-							voxelBelowRightMaterial, voxelBelowBeforeMaterial, voxelBelowRightBeforeMaterial, translate);
-					const IndexType v_2_3 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelCurrent, currentSliceVerticesT,  &result->mesh[1],
-							voxelBelowBehindMaterial, voxelBelowRightMaterial, voxelBelowRightBehindMaterial, translate);
-					const IndexType v_3_4 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelCurrent, currentSliceVerticesT,  &result->mesh[1],
-							voxelBelowLeftMaterial, voxelBelowBehindMaterial, voxelBelowLeftBehindMaterial, translate);
-					vecQuadsT[core::enumVal(FaceNames::NegativeY)][regY].emplace_back(v_0_1, v_1_2, v_2_3, v_3_4);
-				}
+	// the slices before, at and behind the current z - the mask bit regX + 1 of row regY + 1 is the voxel at regX,
+	// regY to include the neighbours at the border of the region
+	OccupancySlice slice0((int)w + 3, (int)h + 3);
+	OccupancySlice slice1((int)w + 3, (int)h + 3);
+	OccupancySlice slice2((int)w + 3, (int)h + 3);
+	OccupancySlice *slices[3] = {&slice0, &slice1, &slice2};
+	fillOccupancySlice(volData, offset.x - 1, offset.y - 1, offset.z - 1, *slices[0]);
+	fillOccupancySlice(volData, offset.x - 1, offset.y - 1, offset.z, *slices[1]);
+	const int words = slice0.solid.words();
 
+	Array *previousVertices[2] = {&previousSliceVertices, &previousSliceVerticesT};
+	Array *currentVertices[2] = {&currentSliceVertices, &currentSliceVerticesT};
+	QuadListVector *quads[2] = {vecQuads, vecQuadsT};
 
-				// Y [D] ABOVE
-				if (isQuadNeeded(voxelBelowMaterial, voxelCurrentMaterial, FaceNames::PositiveY)) {
-					const VoxelType _voxelAboveRight       = volumeSampler3.peekVoxel1px0py0pz().getMaterial();
-					const VoxelType _voxelAboveBehind      = volumeSampler3.peekVoxel0px0py1pz().getMaterial();
-					const VoxelType _voxelAboveRightBehind = volumeSampler3.peekVoxel1px0py1pz().getMaterial();
-
-					const VoxelType _voxelAboveRightBefore = voxelRightBefore.getMaterial();
-					const VoxelType _voxelAboveLeftBehind  = voxelLeftBehind.getMaterial();
-
-					const IndexType v_0_5 = addVertex(reuseVertices, regX,     regY, regZ,     voxelBelow, previousSliceVertices, &result->mesh[0],
-							voxelBeforeMaterial, voxelLeftMaterial, voxelLeftBeforeMaterial, translate);
-					const IndexType v_1_6 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelBelow, previousSliceVertices, &result->mesh[0],
-							_voxelAboveRight, voxelBeforeMaterial, _voxelAboveRightBefore, translate);
-					const IndexType v_2_7 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelBelow, currentSliceVertices,  &result->mesh[0],
-							_voxelAboveBehind, _voxelAboveRight, _voxelAboveRightBehind, translate);
-					const IndexType v_3_8 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelBelow, currentSliceVertices,  &result->mesh[0],
-							voxelLeftMaterial, _voxelAboveBehind, _voxelAboveLeftBehind, translate);
-					vecQuads[core::enumVal(FaceNames::PositiveY)][regY].emplace_back(v_0_5, v_3_8, v_2_7, v_1_6);
-				} else if (isTransparentQuadNeeded(voxelBelowMaterial, voxelCurrentMaterial, FaceNames::PositiveY)) {
-					const VoxelType _voxelAboveRight       = volumeSampler3.peekVoxel1px0py0pz().getMaterial();
-					const VoxelType _voxelAboveBehind      = volumeSampler3.peekVoxel0px0py1pz().getMaterial();
-					const VoxelType _voxelAboveRightBehind = volumeSampler3.peekVoxel1px0py1pz().getMaterial();
-
-					const VoxelType _voxelAboveRightBefore = voxelRightBefore.getMaterial();
-					const VoxelType _voxelAboveLeftBehind  = voxelLeftBehind.getMaterial();
-
-					const IndexType v_0_5 = addVertex(reuseVertices, regX,     regY, regZ,     voxelBelow, previousSliceVerticesT, &result->mesh[1],
-							voxelBeforeMaterial, voxelLeftMaterial, voxelLeftBeforeMaterial, translate);
-					const IndexType v_1_6 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelBelow, previousSliceVerticesT, &result->mesh[1],
-							_voxelAboveRight, voxelBeforeMaterial, _voxelAboveRightBefore, translate);
-					const IndexType v_2_7 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelBelow, currentSliceVerticesT,  &result->mesh[1],
-							_voxelAboveBehind, _voxelAboveRight, _voxelAboveRightBehind, translate);
-					const IndexType v_3_8 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelBelow, currentSliceVerticesT,  &result->mesh[1],
-							voxelLeftMaterial, _voxelAboveBehind, _voxelAboveLeftBehind, translate);
-					vecQuadsT[core::enumVal(FaceNames::PositiveY)][regY].emplace_back(v_0_5, v_3_8, v_2_7, v_1_6);
-				}
+	voxel::RawVolume::Sampler volumeSampler(volData);
 
-				// Z [E] BEFORE
-				if (isQuadNeeded(voxelCurrentMaterial, voxelBeforeMaterial, FaceNames::NegativeZ)) {
-					const VoxelType voxelBelowBeforeMaterial = voxelBelowBefore.getMaterial();
-					const VoxelType voxelAboveBeforeMaterial = voxelAboveBefore.getMaterial();
-					const VoxelType voxelRightBeforeMaterial = voxelRightBefore.getMaterial();
-					const VoxelType voxelAboveRightBeforeMaterial = voxelAboveRightBefore.getMaterial();
-					const VoxelType voxelBelowRightBeforeMaterial = voxelBelowRightBefore.getMaterial();
-
-					const IndexType v_0_1 = addVertex(reuseVertices, regX,     regY,     regZ, voxelCurrent, previousSliceVertices, &result->mesh[0],
-							voxelBelowBeforeMaterial, voxelLeftBeforeMaterial, voxelBelowLeftBeforeMaterial, translate); //1
-					const IndexType v_1_5 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelCurrent, previousSliceVertices, &result->mesh[0],
-							voxelAboveBeforeMaterial, voxelLeftBeforeMaterial, voxelAboveLeftBeforeMaterial, translate); //5
-					const IndexType v_2_6 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelCurrent, previousSliceVertices, &result->mesh[0],
-							voxelAboveBeforeMaterial, voxelRightBeforeMaterial, voxelAboveRightBeforeMaterial, translate); //6
-					const IndexType v_3_2 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelCurrent, previousSliceVertices, &result->mesh[0],
-							voxelBelowBeforeMaterial, voxelRightBeforeMaterial, voxelBelowRightBeforeMaterial, translate); //2
-					vecQuads[core::enumVal(FaceNames::NegativeZ)][regZ].emplace_back(v_0_1, v_1_5, v_2_6, v_3_2);
-				} else if (isTransparentQuadNeeded(voxelCurrentMaterial, voxelBeforeMaterial, FaceNames::NegativeZ)) {
-					const VoxelType voxelBelowBeforeMaterial = voxelBelowBefore.getMaterial();
-					const VoxelType voxelAboveBeforeMaterial = voxelAboveBefore.getMaterial();
-					const VoxelType voxelRightBeforeMaterial = voxelRightBefore.getMaterial();
-					const VoxelType voxelAboveRightBeforeMaterial = voxelAboveRightBefore.getMaterial();
-					const VoxelType voxelBelowRightBeforeMaterial = voxelBelowRightBefore.getMaterial();
-
-					const IndexType v_0_1 = addVertex(reuseVertices, regX,     regY,     regZ, voxelCurrent, previousSliceVerticesT, &result->mesh[1],
-							voxelBelowBeforeMaterial, voxelLeftBeforeMaterial, voxelBelowLeftBeforeMaterial, translate); //1
-					const IndexType v_1_5 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelCurrent, previousSliceVerticesT, &result->mesh[1],
-							voxelAboveBeforeMaterial, voxelLeftBeforeMaterial, voxelAboveLeftBeforeMaterial, translate); //5
-					const IndexType v_2_6 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelCurrent, previousSliceVerticesT, &result->mesh[1],
-							voxelAboveBeforeMaterial, voxelRightBeforeMaterial, voxelAboveRightBeforeMaterial, translate); //6
-					const IndexType v_3_2 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelCurrent, previousSliceVerticesT, &result->mesh[1],
-							voxelBelowBeforeMaterial, voxelRightBeforeMaterial, voxelBelowRightBeforeMaterial, translate); //2
-					vecQuadsT[core::enumVal(FaceNames::NegativeZ)][regZ].emplace_back(v_0_1, v_1_5, v_2_6, v_3_2);
-				}
+	for (uint32_t regZ = 0; regZ <= d; ++regZ) {
+		fillOccupancySlice(volData, offset.x - 1, offset.y - 1, offset.z + (int)regZ + 1, *slices[2]);
+		const OccupancySlice &sliceBefore = *slices[0];
+		const OccupancySlice &sliceCurrent = *slices[1];
 
-				// Z [F] BEHIND
-				if (isQuadNeeded(voxelBeforeMaterial, voxelCurrentMaterial, FaceNames::PositiveZ)) {
-					const VoxelType _voxelRightBehind      = volumeSampler3.peekVoxel1px0py1pz().getMaterial();
-					const VoxelType _voxelAboveBehind      = volumeSampler3.peekVoxel0px1py0pz().getMaterial();
-					const VoxelType _voxelAboveRightBehind = volumeSampler3.peekVoxel1px1py0pz().getMaterial();
-					const VoxelType _voxelBelowRightBehind = volumeSampler3.peekVoxel1px1ny0pz().getMaterial();
-
-					const IndexType v_0_4 = addVertex(reuseVertices, regX,     regY,     regZ, voxelBefore, previousSliceVertices, &result->mesh[0],
-							voxelBelowMaterial, voxelLeftMaterial, voxelBelowLeftMaterial, translate); //4
-					const IndexType v_1_8 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelBefore, previousSliceVertices, &result->mesh[0],
-							_voxelAboveBehind, voxelLeftMaterial, voxelAboveLeftMaterial, translate); //8
-					const IndexType v_2_7 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelBefore, previousSliceVertices, &result->mesh[0],
-							_voxelAboveBehind, _voxelRightBehind, _voxelAboveRightBehind, translate); //7
-					const IndexType v_3_3 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelBefore, previousSliceVertices, &result->mesh[0],
-							voxelBelowMaterial, _voxelRightBehind, _voxelBelowRightBehind, translate); //3
-					vecQuads[core::enumVal(FaceNames::PositiveZ)][regZ].emplace_back(v_0_4, v_3_3, v_2_7, v_1_8);
-				} else if (isTransparentQuadNeeded(voxelBeforeMaterial, voxelCurrentMaterial, FaceNames::PositiveZ)) {
-					const VoxelType _voxelRightBehind      = volumeSampler3.peekVoxel1px0py1pz().getMaterial();
-					const VoxelType _voxelAboveBehind      = volumeSampler3.peekVoxel0px1py0pz().getMaterial();
-					const VoxelType _voxelAboveRightBehind = volumeSampler3.peekVoxel1px1py0pz().getMaterial();
-					const VoxelType _voxelBelowRightBehind = volumeSampler3.peekVoxel1px1ny0pz().getMaterial();
-
-					const IndexType v_0_4 = addVertex(reuseVertices, regX,     regY,     regZ, voxelBefore, previousSliceVerticesT, &result->mesh[1],
-							voxelBelowMaterial, voxelLeftMaterial, voxelBelowLeftMaterial, translate); //4
-					const IndexType v_1_8 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelBefore, previousSliceVerticesT, &result->mesh[1],
-							_voxelAboveBehind, voxelLeftMaterial, voxelAboveLeftMaterial, translate); //8
-					const IndexType v_2_7 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelBefore, previousSliceVerticesT, &result->mesh[1],
-							_voxelAboveBehind, _voxelRightBehind, _voxelAboveRightBehind, translate); //7
-					const IndexType v_3_3 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelBefore, previousSliceVerticesT, &result->mesh[1],
-							voxelBelowMaterial, _voxelRightBehind, _voxelBelowRightBehind, translate); //3
-					vecQuadsT[core::enumVal(FaceNames::PositiveZ)][regZ].emplace_back(v_0_4, v_3_3, v_2_7, v_1_8);
+		for (uint32_t regY = 0; regY <= h; ++regY) {
+			const int row = (int)regY + 1;
+			const uint64_t *solid = sliceCurrent.solid.row(row);
+			const uint64_t *transparent = sliceCurrent.transparent.row(row);
+			const uint64_t *solidBelow = sliceCurrent.solid.row(row - 1);
+			const uint64_t *transparentBelow = sliceCurrent.transparent.row(row - 1);
+			const uint64_t *solidBefore = sliceBefore.solid.row(row);
+			const uint64_t *transparentBefore = sliceBefore.transparent.row(row);
+			uint64_t carrySolid = 0u;
+			uint64_t carryTransparent = 0u;
+
+			for (int word = 0; word < words; ++word) {
+				// quads are only needed where the voxel differs from its left, lower or front neighbour - this
+				// skips the empty space and the inside of solid objects for a whole row of voxels at once
+				const uint64_t s = solid[word];
+				const uint64_t t = transparent[word];
+				const uint64_t solidLeft = (s << 1) | carrySolid;
+				const uint64_t transparentLeft = (t << 1) | carryTransparent;
+				carrySolid = s >> 63;
+				carryTransparent = t >> 63;
+				uint64_t candidates = (s ^ solidLeft) | (t ^ transparentLeft) | (s ^ solidBelow[word]) |
+									  (t ^ transparentBelow[word]) | (s ^ solidBefore[word]) |
+									  (t ^ transparentBefore[word]);
+
+				while (candidates) {
+					const int bit = lowestBit(candidates);
+					candidates &= candidates - 1u;
+					const int maskX = word * 64 + bit;
+					if (maskX == 0) {
+						// the left border of the region
+						continue;
+					}
+					const uint32_t regX = (uint32_t)maskX - 1u;
+					if (regX > w) {
+						break;
+					}
+					volumeSampler.setPosition(offset.x + (int)regX, offset.y + (int)regY, offset.z + (int)regZ);
+
+					/**
+					 *
+					 *
+					 *                  [D]
+					 *            8 ____________ 7
+					 *             /|          /|
+					 *            / |         / |              ABOVE [D] |
+					 *           /  |    [F] /  |              BELOW [C]
+					 *        5 /___|_______/ 6 |  [B]       y           BEHIND  [F]
+					 *    [A]   |   |_______|___|              |      z  BEFORE [E] /
+					 *          | 4 /       |   / 3            |   /
+					 *          |  / [E]    |  /               |  /   . center
+					 *          | /         | /                | /
+					 *          |/__________|/                 |/________   LEFT  RIGHT
+					 *        1               2                          x   [A] - [B]
+					 *               [C]
+					 */
+
+					const Voxel& voxelCurrent = volumeSampler.voxel();
+					const Voxel& voxelLeft    = volumeSampler.peekVoxel1nx0py0pz();
+					const Voxel& voxelBelow   = volumeSampler.peekVoxel0px1ny0pz();
+					const Voxel& voxelBefore  = volumeSampler.peekVoxel0px0py1nz();
+
+					const VoxelType voxelCurrentMaterial = voxelCurrent.getMaterial();
+					const VoxelType voxelLeftMaterial    = voxelLeft.getMaterial();
+					const VoxelType voxelBelowMaterial   = voxelBelow.getMaterial();
+					const VoxelType voxelBeforeMaterial  = voxelBefore.getMaterial();
+
+					// the occluding voxels around the current voxel for the ambient occlusion of the vertices
+					const uint32_t n = occupancyNeighbourhood(slices, (int)regX, row);
+
+					// X [A] LEFT
+					int meshIdx = quadMesh(voxelCurrentMaterial, voxelLeftMaterial, FaceNames::NegativeX);
+					if (meshIdx != -1) {
+						Mesh *mesh = &result->mesh[meshIdx];
+						const IndexType v_0_1 = addVertex(reuseVertices, regX, regY,     regZ,     voxelCurrent, *previousVertices[meshIdx], mesh,
+								cornerAO(n, LeftBefore, BelowLeft, BelowLeftBefore), translate);
+						const IndexType v_1_4 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelCurrent, *currentVertices[meshIdx],  mesh,
+								cornerAO(n, BelowLeft, LeftBehind, BelowLeftBehind), translate);
+						const IndexType v_2_8 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelCurrent, *currentVertices[meshIdx],  mesh,
+								cornerAO(n, LeftBehind, AboveLeft, AboveLeftBehind), translate);
+						const IndexType v_3_5 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelCurrent, *previousVertices[meshIdx], mesh,
+								cornerAO(n, AboveLeft, LeftBefore, AboveLeftBefore), translate);
+						quads[meshIdx][core::enumVal(FaceNames::NegativeX)][regX].emplace_back(v_0_1, v_1_4, v_2_8, v_3_5);
+					}
+
+					// X [B] RIGHT - the face of the left voxel
+					meshIdx = quadMesh(voxelLeftMaterial, voxelCurrentMaterial, FaceNames::PositiveX);
+					if (meshIdx != -1) {
+						Mesh *mesh = &result->mesh[meshIdx];
+						const IndexType v_0_2 = addVertex(reuseVertices, regX, regY,     regZ,     voxelLeft, *previousVertices[meshIdx], mesh,
+								cornerAO(n, Below, Before, BelowBefore), translate);
+						const IndexType v_1_3 = addVertex(reuseVertices, regX, regY,     regZ + 1, voxelLeft, *currentVertices[meshIdx],  mesh,
+								cornerAO(n, Below, Behind, BelowBehind), translate);
+						const IndexType v_2_7 = addVertex(reuseVertices, regX, regY + 1, regZ + 1, voxelLeft, *currentVertices[meshIdx],  mesh,
+								cornerAO(n, Above, Behind, AboveBehind), translate);
+						const IndexType v_3_6 = addVertex(reuseVertices, regX, regY + 1, regZ,     voxelLeft, *previousVertices[meshIdx], mesh,
+								cornerAO(n, Above, Before, AboveBefore), translate);
+						quads[meshIdx][core::enumVal(FaceNames::PositiveX)][regX].emplace_back(v_0_2, v_3_6, v_2_7, v_1_3);
+					}
+
+					// Y [C] BELOW
+					meshIdx = quadMesh(voxelCurrentMaterial, voxelBelowMaterial, FaceNames::NegativeY);
+					if (meshIdx != -1) {
+						Mesh *mesh = &result->mesh[meshIdx];
+						const IndexType v_0_1 = addVertex(reuseVertices, regX,     regY, regZ,     voxelCurrent, *previousVertices[meshIdx], mesh,
+								cornerAO(n, BelowBefore, BelowLeft, BelowLeftBefore), translate);
+						const IndexType v_1_2 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelCurrent, *previousVertices[meshIdx], mesh,
+								cornerAO(n, BelowRight, BelowBefore, BelowRightBefore), translate);
+						const IndexType v_2_3 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelCurrent, *currentVertices[meshIdx],  mesh,
+								cornerAO(n, BelowBehind, BelowRight, BelowRightBehind), translate);
+						const IndexType v_3_4 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelCurrent, *currentVertices[meshIdx],  mesh,
+								cornerAO(n, BelowLeft, BelowBehind, BelowLeftBehind), translate);
+						quads[meshIdx][core::enumVal(FaceNames::NegativeY)][regY].emplace_back(v_0_1, v_1_2, v_2_3, v_3_4);
+					}
+
+					// Y [D] ABOVE - the face of the voxel below
+					meshIdx = quadMesh(voxelBelowMaterial, voxelCurrentMaterial, FaceNames::PositiveY);
+					if (meshIdx != -1) {
+						Mesh *mesh = &result->mesh[meshIdx];
+						const IndexType v_0_5 = addVertex(reuseVertices, regX,     regY, regZ,     voxelBelow, *previousVertices[meshIdx], mesh,
+								cornerAO(n, Before, Left, LeftBefore), translate);
+						const IndexType v_1_6 = addVertex(reuseVertices, regX + 1, regY, regZ,     voxelBelow, *previousVertices[meshIdx], mesh,
+								cornerAO(n, Right, Before, RightBefore), translate);
+						const IndexType v_2_7 = addVertex(reuseVertices, regX + 1, regY, regZ + 1, voxelBelow, *currentVertices[meshIdx],  mesh,
+								cornerAO(n, Behind, Right, RightBehind), translate);
+						const IndexType v_3_8 = addVertex(reuseVertices, regX,     regY, regZ + 1, voxelBelow, *currentVertices[meshIdx],  mesh,
+								cornerAO(n, Left, Behind, LeftBehind), translate);
+						quads[meshIdx][core::enumVal(FaceNames::PositiveY)][regY].emplace_back(v_0_5, v_3_8, v_2_7, v_1_6);
+					}
+
+					// Z [E] BEFORE
+					meshIdx = quadMesh(voxelCurrentMaterial, voxelBeforeMaterial, FaceNames::NegativeZ);
+					if (meshIdx != -1) {
+						Mesh *mesh = &result->mesh[meshIdx];
+						const IndexType v_0_1 = addVertex(reuseVertices, regX,     regY,     regZ, voxelCurrent, *previousVertices[meshIdx], mesh,
+								cornerAO(n, BelowBefore, LeftBefore, BelowLeftBefore), translate); //1
+						const IndexType v_1_5 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelCurrent, *previousVertices[meshIdx], mesh,
+								cornerAO(n, AboveBefore, LeftBefore, AboveLeftBefore), translate); //5
+						const IndexType v_2_6 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelCurrent, *previousVertices[meshIdx], mesh,
+								cornerAO(n, AboveBefore, RightBefore, AboveRightBefore), translate); //6
+						const IndexType v_3_2 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelCurrent, *previousVertices[meshIdx], mesh,
+								cornerAO(n, BelowBefore, RightBefore, BelowRightBefore), translate); //2
+						quads[meshIdx][core::enumVal(FaceNames::NegativeZ)][regZ].emplace_back(v_0_1, v_1_5, v_2_6, v_3_2);
+					}
+
+					// Z [F] BEHIND - the face of the voxel before
+					meshIdx = quadMesh(voxelBeforeMaterial, voxelCurrentMaterial, FaceNames::PositiveZ);
+					if (meshIdx != -1) {
+						Mesh *mesh = &result->mesh[meshIdx];
+						const IndexType v_0_4 = addVertex(reuseVertices, regX,     regY,     regZ, voxelBefore, *previousVertices[meshIdx], mesh,
+								cornerAO(n, Below, Left, BelowLeft), translate); //4
+						const IndexType v_1_8 = addVertex(reuseVertices, regX,     regY + 1, regZ, voxelBefore, *previousVertices[meshIdx], mesh,
+								cornerAO(n, Above, Left, AboveLeft), translate); //8
+						const IndexType v_2_7 = addVertex(reuseVertices, regX + 1, regY + 1, regZ, voxelBefore, *previousVertices[meshIdx], mesh,
+								cornerAO(n, Above, Right, AboveRight), translate); //7
+						const IndexType v_3_3 = addVertex(reuseVertices, regX + 1, regY,     regZ, voxelBefore, *previousVertices[meshIdx], mesh,
+								cornerAO(n, Below, Right, BelowRight), translate); //3
+						quads[meshIdx][core::enumVal(FaceNames::PositiveZ)][regZ].emplace_back(v_0_4, v_3_3, v_2_7, v_1_8);
+					}
 				}
-				volumeSampler3.movePositiveX();
 			}
-			volumeSampler2.movePositiveY();
 		}
-		volumeSampler.movePositiveZ();
+
+		// the current slice becomes the slice before the next one
+		OccupancySlice *oldest = slices[0];
+		slices[0] = slices[1];
+		slices[1] = slices[2];
+		slices[2] = oldest;
 
 		previousSliceVertices.swap(currentSliceVertices);
 		previousSliceVerticesT.swap(currentSliceVerticesT);
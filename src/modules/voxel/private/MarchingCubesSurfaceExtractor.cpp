@@ -7,6 +7,8 @@
 #include "core/Common.h"
 #include "core/Trace.h"
 #include "core/collection/Array2DView.h"
+#include "core/collection/Buffer.h"
+#include "core/collection/DynamicArray.h"
 #include "MarchingCubesTables.h"
 #include "math/Axis.h"
 #include "voxel/ChunkMesh.h"
@@ -46,30 +48,135 @@ static inline Voxel blendMaterials(const palette::Palette &palette, const Voxel
 	return createVoxel(palette, palIdx);
 }
 
-// Gradient estimation
-static glm::vec3 computeCentralDifferenceGradient(const RawVolume::Sampler &volIter) {
-	const float voxel1nx = convertToDensity(volIter.peekVoxel1nx0py0pz());
-	const float voxel1px = convertToDensity(volIter.peekVoxel1px0py0pz());
+/**
+ * @brief The voxels of one slice of the extraction region with a border of one voxel in x and y direction - the
+ * border is needed for the central differences at the region boundaries.
+ */
+struct VoxelSlice {
+	core::DynamicArray<Voxel> voxels;
+	// amount of non-air voxels per row
+	core::Buffer<int> rowSolid;
+
+	void resize(int pw, int ph) {
+		voxels.resize((size_t)(pw * ph));
+		rowSolid.resize((size_t)ph);
+	}
+};
 
-	const float voxel1ny = convertToDensity(volIter.peekVoxel0px1ny0pz());
-	const float voxel1py = convertToDensity(volIter.peekVoxel0px1py0pz());
+/**
+ * @brief The gradients of all voxels of one slice of the extraction region
+ *
+ * Each voxel is shared by up to eight cells - the gradient is computed only once per voxel. The components are
+ * stored in separate arrays to allow the compiler to vectorize the computation.
+ */
+struct GradientSlice {
+	core::Buffer<float> x;
+	core::Buffer<float> y;
+	core::Buffer<float> z;
+
+	void resize(size_t n) {
+		x.resize(n);
+		y.resize(n);
+		z.resize(n);
+	}
 
-	const float voxel1nz = convertToDensity(volIter.peekVoxel0px0py1nz());
-	const float voxel1pz = convertToDensity(volIter.peekVoxel0px0py1pz());
+	inline glm::vec3 get(int idx) const {
+		return glm::vec3(x[idx], y[idx], z[idx]);
+	}
+};
+
+static void fillSlice(const RawVolume *volume, const glm::ivec3 &mins, int pw, int ph, VoxelSlice &slice) {
+	core_trace_scoped(MarchingCubesFillSlice);
+	const Region &volumeRegion = volume->region();
+	const glm::ivec3 &volumeMins = volumeRegion.getLowerCorner();
+	const glm::ivec3 &volumeMaxs = volumeRegion.getUpperCorner();
+	const int32_t volumeWidth = volumeRegion.getWidthInVoxels();
+	const int32_t volumeHeight = volumeRegion.getHeightInVoxels();
+	const Voxel &border = volume->borderValue();
+	const int borderSolid = isAir(border.getMaterial()) ? 0 : 1;
+	// the range of the row that is inside the volume - the rest is filled with the border value
+	const int x0 = glm::clamp(volumeMins.x - mins.x, 0, pw);
+	const int x1 = glm::clamp(volumeMaxs.x - mins.x + 1, 0, pw);
+	const bool insideZ = mins.z >= volumeMins.z && mins.z <= volumeMaxs.z;
+	for (int y = 0; y < ph; ++y) {
+		const int wy = mins.y + y;
+		Voxel *voxels = slice.voxels.data() + y * pw;
+		if (!insideZ || x0 >= x1 || wy < volumeMins.y || wy > volumeMaxs.y) {
+			for (int x = 0; x < pw; ++x) {
+				voxels[x] = border;
+			}
+			slice.rowSolid[y] = borderSolid * pw;
+			continue;
+		}
+		const Voxel *row = volume->voxels() + (mins.x + x0 - volumeMins.x) + (wy - volumeMins.y) * volumeWidth +
+						   (mins.z - volumeMins.z) * volumeWidth * volumeHeight;
+		for (int x = 0; x < x0; ++x) {
+			voxels[x] = border;
+		}
+		core_memcpy((void *)(voxels + x0), (const void *)row, (x1 - x0) * sizeof(Voxel));
+		for (int x = x1; x < pw; ++x) {
+			voxels[x] = border;
+		}
+		int solid = borderSolid * (pw - (x1 - x0));
+		for (int x = x0; x < x1; ++x) {
+			solid += !isAir(voxels[x].getMaterial());
+		}
+		slice.rowSolid[y] = solid;
+	}
+}
 
-	return glm::vec3(voxel1nx - voxel1px, voxel1ny - voxel1py, voxel1nz - voxel1pz);
+// Gradient estimation via central differences
+static void computeGradients(const VoxelSlice &prev, const VoxelSlice &cur, const VoxelSlice &next, int w, int h,
+							 core::Buffer<float> &densities, GradientSlice &gradients) {
+	core_trace_scoped(MarchingCubesComputeGradients);
+	const int pw = w + 2;
+	// the densities of the rows y - 1, y and y + 1 of the current slice and the row y of the previous and the next
+	// slice - they are only converted for the rows that are not uniform
+	float *c = densities.data();
+	float *ny = c + pw;
+	float *py = ny + pw;
+	float *nz = py + pw;
+	float *pz = nz + pw;
+	auto convertRow = [pw](const VoxelSlice &slice, int y, float *out) {
+		const Voxel *voxels = slice.voxels.data() + y * pw;
+		for (int x = 0; x < pw; ++x) {
+			out[x] = convertToDensity(voxels[x]);
+		}
+	};
+	for (int y = 0; y < h; ++y) {
+		float *gx = gradients.x.data() + y * w;
+		float *gy = gradients.y.data() + y * w;
+		float *gz = gradients.z.data() + y * w;
+		// all involved rows are empty or completely filled - the differences are positive zero
+		const int solid = cur.rowSolid[y] + cur.rowSolid[y + 1] + cur.rowSolid[y + 2] + prev.rowSolid[y + 1] +
+						  next.rowSolid[y + 1];
+		if (solid == 0 || solid == 5 * pw) {
+			for (int x = 0; x < w; ++x) {
+				gx[x] = gy[x] = gz[x] = 0.0f;
+			}
+			continue;
+		}
+		convertRow(cur, y + 1, c);
+		convertRow(cur, y, ny);
+		convertRow(cur, y + 2, py);
+		convertRow(prev, y + 1, nz);
+		convertRow(next, y + 1, pz);
+		for (int x = 0; x < w; ++x) {
+			gx[x] = c[x] - c[x + 2];
+			gy[x] = ny[x + 1] - py[x + 1];
+			gz[x] = nz[x + 1] - pz[x + 1];
+		}
+	}
 }
 
-static void generateVertex(math::Axis axis, const palette::Palette &palette, RawVolume::Sampler &sampler,
-				   ChunkMesh *result, core::Array2DView<glm::ivec3> &indicesView,
-				   const Voxel &v111, const glm::vec3 &n111, float v111Density, int x, int y) {
-	sampler.moveNegative(axis);
-	const Voxel v110 = sampler.voxel();
+static void generateVertex(math::Axis axis, const palette::Palette &palette, ChunkMesh *result,
+						   core::Array2DView<glm::ivec3> &indicesView, const Voxel &v111, const glm::vec3 &n111,
+						   float v111Density, const Voxel &v110, const glm::vec3 &n110, glm::ivec3 pos, int x,
+						   int y) {
 	const float v110Density = convertToDensity(v110);
 	const float interpolate = (DensityThreshold - v110Density) / (v111Density - v110Density);
 
 	// Compute the normal
-	const glm::vec3 n110 = computeCentralDifferenceGradient(sampler);
 	glm::vec3 normal = (n111 * interpolate) + (n110 * (1 - interpolate));
 
 	// The gradient for a voxel can be zero (e.g. solid voxel surrounded by empty ones) and so
@@ -82,8 +189,10 @@ static void generateVertex(math::Axis axis, const palette::Palette &palette, Raw
 	const Voxel blendedVoxel = blendMaterials(palette, v110, v111, interpolate);
 
 	const int idx = math::getIndexForAxis(axis);
+	// the vertex is placed between the previous voxel on the given axis and the current one
+	pos[idx] -= 1;
 	VoxelVertex surfaceVertex;
-	surfaceVertex.position = sampler.position();
+	surfaceVertex.position = pos;
 	surfaceVertex.position[idx] += interpolate;
 	surfaceVertex.colorIndex = blendedVoxel.getColor();
 	surfaceVertex.normalIndex = NO_NORMAL;
@@ -94,8 +203,6 @@ static void generateVertex(math::Axis axis, const palette::Palette &palette, Raw
 	const IndexType lastVertexIndex = result->mesh[0].addVertex(surfaceVertex);
 	result->mesh[0].setNormal(lastVertexIndex, normal);
 	indicesView.get(x, y)[idx] = (int)lastVertexIndex;
-
-	sampler.movePositive(axis);
 }
 
 void extractMarchingCubesMesh(const RawVolume *volume, const palette::Palette &palette, const Region &ctxRegion, ChunkMesh *result) {
@@ -116,29 +223,55 @@ void extractMarchingCubesMesh(const RawVolume *volume, const palette::Palette &p
 	core::Buffer<uint8_t> previousRowCellIndices(w);
 	core::Buffer<uint8_t> previousSliceCellIndicesBuf((size_t)(w * h));
 	core::Array2DView<uint8_t> previousSliceCellIndicesView(previousSliceCellIndicesBuf.data(), w, h);
+	// A cell in empty space has the cell index 255. If all the previous cells that contribute to the cell indices of a
+	// row have this index and the voxels of the row are air, the whole row keeps this index and can be skipped.
+	bool previousRowAir = false;
+	core::Buffer<uint8_t> previousSliceRowAir((size_t)h);
 
 	// A given vertex may be shared by multiple triangles, so we need to keep track of the indices into the vertex
 	// array.
 	core::Buffer<glm::ivec3> indicesBuf((size_t)(w * h));
 	core::Buffer<glm::ivec3> previousIndicesBuf((size_t)(w * h));
 
-	// A sampler pointing at the beginning of the region, which gets incremented to always point at the beginning of a
-	// slice.
-	RawVolume::Sampler startOfSlice(volume);
-	startOfSlice.setPosition(region.getLowerCorner());
+	// Instead of sampling the volume for every cell and the central differences, the voxels of the previous, the
+	// current and the next slice are cached (with a border of one voxel in x and y direction). The gradients are
+	// computed once per voxel for the current slice and kept for the previous slice.
+	const int32_t pw = w + 2;
+	const int32_t ph = h + 2;
+	const glm::ivec3 &lower = region.getLowerCorner();
+	VoxelSlice slices[3];
+	for (VoxelSlice &slice : slices) {
+		slice.resize(pw, ph);
+	}
+	// slice z is stored at index (z + 1) % 3
+	fillSlice(volume, glm::ivec3(lower.x - 1, lower.y - 1, lower.z - 1), pw, ph, slices[0]);
+	fillSlice(volume, glm::ivec3(lower.x - 1, lower.y - 1, lower.z), pw, ph, slices[1]);
+	core::Buffer<float> densities((size_t)(5 * pw));
+	GradientSlice gradients;
+	GradientSlice previousGradients;
+	gradients.resize((size_t)(w * h));
+	previousGradients.resize((size_t)(w * h));
 
 	for (int32_t z = 0; z < d; z++) {
-		// A sampler pointing at the beginning of the slice, which gets incremented to always point at the beginning of
-		// a row.
-		RawVolume::Sampler startOfRow = startOfSlice;
+		const VoxelSlice &previousSlice = slices[z % 3];
+		const VoxelSlice &slice = slices[(z + 1) % 3];
+		VoxelSlice &nextSlice = slices[(z + 2) % 3];
+		fillSlice(volume, glm::ivec3(lower.x - 1, lower.y - 1, lower.z + z + 1), pw, ph, nextSlice);
+		core::exchange(gradients, previousGradients);
+		computeGradients(previousSlice, slice, nextSlice, w, h, densities, gradients);
 
 		core::Array2DView<glm::ivec3> indicesView(indicesBuf.data(), w, h);
 		core::Array2DView<glm::ivec3> previousIndicesView(previousIndicesBuf.data(), w, h);
 
 		for (int32_t y = 0; y < h; y++) {
-			// Copying a sampler which is already pointing at the correct location seems (slightly) faster than
-			// calling setPosition(). Therefore we make use of 'startOfRow' and 'startOfSlice' to reset the sampler.
-			RawVolume::Sampler sampler = startOfRow;
+			if (previousCellIndex == 255 && previousRowAir && previousSliceRowAir[y] && slice.rowSolid[y + 1] == 0) {
+				continue;
+			}
+			const Voxel *voxels = slice.voxels.data() + (y + 1) * pw + 1;
+			const Voxel *previousRowVoxels = voxels - pw;
+			const Voxel *previousSliceVoxels = previousSlice.voxels.data() + (y + 1) * pw + 1;
+			const int32_t gradientOffset = y * w;
+			uint8_t rowCellIndices = 255;
 
 			for (int32_t x = 0; x < w; x++) {
 				// Note: In many cases the provided region will be (mostly) empty which means mesh vertices/indices
@@ -177,7 +310,7 @@ void extractMarchingCubesMesh(const RawVolume *volume, const palette::Palette &p
 
 				// The last bit of our cube index is obtained by looking
 				// at the relevant voxel and comparing it to the threshold
-				const Voxel v111 = sampler.voxel();
+				const Voxel &v111 = voxels[x];
 				if (convertToDensity(v111) < DensityThreshold) {
 					cellIndex |= 128;
 				}
@@ -186,6 +319,7 @@ void extractMarchingCubesMesh(const RawVolume *volume, const palette::Palette &p
 				previousCellIndex = cellIndex;
 				previousRowCellIndices[x] = cellIndex;
 				previousSliceCellIndicesView.set(x, y, cellIndex);
+				rowCellIndices &= cellIndex;
 
 				// 12 bits of edge determine whether a vertex is placed on each of the 12 edges of the cell.
 				const uint16_t edge = edgeTable[cellIndex];
@@ -199,23 +333,25 @@ void extractMarchingCubesMesh(const RawVolume *volume, const palette::Palette &p
 				if (core_unlikely(edge != 0u)) {
 					const float v111Density = convertToDensity(v111);
 
-					// Performance note: Computing normals is one of the bottlenecks in the mesh generation process. The
-					// central difference approach actually samples the same voxel more than once as we call it on two
-					// adjacent voxels. Perhaps we could expand this and eliminate duplicates in the future.
-					// Alternatively, we could compute vertex normals from adjacent face normals instead of via central
-					// differencing, but not for vertices on the edge of the region (as this causes visual
-					// discontinuities).
-					const glm::vec3 n111 = computeCentralDifferenceGradient(sampler);
+					// The gradients of the voxels were already computed for the whole slice - we could also compute
+					// vertex normals from adjacent face normals instead of via central differencing, but not for
+					// vertices on the edge of the region (as this causes visual discontinuities).
+					const int32_t gradientIdx = gradientOffset + x;
+					const glm::vec3 n111 = gradients.get(gradientIdx);
+					const glm::ivec3 pos(lower.x + x, lower.y + y, lower.z + z);
 
 					/* Find the vertices where the surface intersects the cube */
 					if ((edge & 64) && x > 0) {
-						generateVertex(math::Axis::X, palette, sampler, result, indicesView, v111, n111, v111Density, x, y);
+						generateVertex(math::Axis::X, palette, result, indicesView, v111, n111, v111Density,
+									   voxels[x - 1], gradients.get(gradientIdx - 1), pos, x, y);
 					}
 					if ((edge & 32) && y > 0) {
-						generateVertex(math::Axis::Y, palette, sampler, result, indicesView, v111, n111, v111Density, x, y);
+						generateVertex(math::Axis::Y, palette, result, indicesView, v111, n111, v111Density,
+									   previousRowVoxels[x], gradients.get(gradientIdx - w), pos, x, y);
 					}
 					if ((edge & 1024) && z > 0) {
-						generateVertex(math::Axis::Z, palette, sampler, result, indicesView, v111, n111, v111Density, x, y);
+						generateVertex(math::Axis::Z, palette, result, indicesView, v111, n111, v111Density,
+									   previousSliceVoxels[x], previousGradients.get(gradientIdx), pos, x, y);
 					}
 
 					// Now output the indices. For the first row, column or slice there aren't
@@ -272,11 +408,10 @@ void extractMarchingCubesMesh(const RawVolume *volume, const palette::Palette &p
 						}
 					}
 				}
-				sampler.movePositiveX();
 			}
-			startOfRow.movePositiveY();
+			previousRowAir = rowCellIndices == 255;
+			previousSliceRowAir[y] = previousRowAir;
 		}
-		startOfSlice.movePositiveZ();
 
 		core::exchange(indicesBuf, previousIndicesBuf);
 	}
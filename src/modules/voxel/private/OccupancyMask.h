@@ -0,0 +1,194 @@
+/**
+ * @file
+ *
+ * Occupancy bit masks for the cubic and the binary greedy surface extractors. The visibility of the faces and the
+ * ambient occlusion of their vertices only depend on whether the neighbour voxels are set - this information is
+ * gathered once into rows of bits and evaluated with bit operations instead of sampling the neighbour voxels for
+ * every single face.
+ */
+
+#pragma once
+
+#include "core/Assert.h"
+#include "core/Common.h"
+#include "core/StandardLib.h"
+#include "core/collection/Buffer.h"
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace voxel {
+
+/**
+ * @return The index of the lowest set bit - the given value must not be @c 0
+ */
+CORE_FORCE_INLINE int lowestBit(uint64_t bits) {
+	core_assert(bits != 0u);
+#ifdef _MSC_VER
+	unsigned long pos;
+	_BitScanForward64(&pos, bits);
+	return (int)pos;
+#else
+	return __builtin_ctzll(bits);
+#endif
+}
+
+/**
+ * @brief Calculates the ambient occlusion value for a vertex
+ *
+ * @li https://0fps.net/2013/07/03/ambient-occlusion-for-minecraft-like-worlds/
+ * @li https://www.reddit.com/r/gamedev/comments/1gvk18/comment/cao9n91/
+ *
+ * There are four states for the ambient occlusion value.
+ * @li @c 0: full occluded in the corner of three voxels
+ * @li @c 3: no occluded at all
+ *
+ * If both sides are occupied, the vertex is fully occluded - regardless of the corner voxel. This prevents light
+ * bleeding through diagonal gaps.
+ */
+CORE_FORCE_INLINE uint8_t vertexAmbientOcclusion(bool side1, bool side2, bool corner) {
+	if (side1 && side2) {
+		return 0;
+	}
+	return 3 - (side1 + side2 + corner);
+}
+
+/**
+ * @brief The bits of the neighbour mask that is given to @c faceAmbientOcclusion() - these are the eight voxels
+ * around a face in the layer in front of the face
+ */
+enum FaceNeighbour : uint8_t {
+	FaceNeighbourLeft,
+	FaceNeighbourRight,
+	FaceNeighbourFront,
+	FaceNeighbourBack,
+	FaceNeighbourLeftFront,
+	FaceNeighbourLeftBack,
+	FaceNeighbourRightFront,
+	FaceNeighbourRightBack
+};
+
+/**
+ * @brief The corners of a face in the value returned by @c faceAmbientOcclusion() - each corner uses two bits
+ */
+enum FaceCorner : uint8_t { FaceCornerLeftBack, FaceCornerRightBack, FaceCornerRightFront, FaceCornerLeftFront };
+
+namespace priv {
+
+struct FaceAmbientOcclusionTable {
+	uint8_t values[256]{};
+
+	constexpr FaceAmbientOcclusionTable() {
+		for (int n = 0; n < 256; ++n) {
+			const bool l = n & (1 << FaceNeighbourLeft);
+			const bool r = n & (1 << FaceNeighbourRight);
+			const bool f = n & (1 << FaceNeighbourFront);
+			const bool b = n & (1 << FaceNeighbourBack);
+			const bool lf = n & (1 << FaceNeighbourLeftFront);
+			const bool lb = n & (1 << FaceNeighbourLeftBack);
+			const bool rf = n & (1 << FaceNeighbourRightFront);
+			const bool rb = n & (1 << FaceNeighbourRightBack);
+			const int lbValue = (l && b) ? 0 : 3 - (l + b + lb);
+			const int rbValue = (r && b) ? 0 : 3 - (r + b + rb);
+			const int rfValue = (r && f) ? 0 : 3 - (r + f + rf);
+			const int lfValue = (l && f) ? 0 : 3 - (l + f + lf);
+			values[n] = (uint8_t)((lbValue << (FaceCornerLeftBack * 2)) | (rbValue << (FaceCornerRightBack * 2)) |
+								  (rfValue << (FaceCornerRightFront * 2)) | (lfValue << (FaceCornerLeftFront * 2)));
+		}
+	}
+};
+
+static constexpr FaceAmbientOcclusionTable FaceAmbientOcclusion;
+
+} // namespace priv
+
+/**
+ * @brief Looks up the ambient occlusion values of all four corners of a face at once
+ *
+ * @param neighbours The occupancy of the eight voxels around the face - see @c FaceNeighbour
+ * @return The ambient occlusion values of the corners - two bits per corner - see @c FaceCorner and
+ * @c faceCornerAmbientOcclusion()
+ */
+CORE_FORCE_INLINE uint8_t faceAmbientOcclusion(uint8_t neighbours) {
+	return priv::FaceAmbientOcclusion.values[neighbours];
+}
+
+CORE_FORCE_INLINE uint8_t faceCornerAmbientOcclusion(uint8_t faceAO, FaceCorner corner) {
+	return (faceAO >> (corner * 2)) & 3u;
+}
+
+/**
+ * @brief A two dimensional grid of bits - every row is stored in full 64 bit words
+ *
+ * The extractors keep one mask per slice of the volume (or per column orientation) and derive the visibility and
+ * the ambient occlusion of whole rows of faces from the words of the neighbouring rows.
+ */
+class OccupancyMask {
+private:
+	int _width;
+	int _height;
+	int _words;
+	core::Buffer<uint64_t> _bits;
+
+public:
+	OccupancyMask(int width, int height) : _width(width), _height(height), _words((width + 63) / 64) {
+		_bits.resize((size_t)_words * height);
+	}
+
+	void clear() {
+		core_memset(_bits.data(), 0, _bits.size() * sizeof(uint64_t));
+	}
+
+	inline int width() const {
+		return _width;
+	}
+
+	inline int height() const {
+		return _height;
+	}
+
+	/**
+	 * @return The amount of 64 bit words per row
+	 */
+	inline int words() const {
+		return _words;
+	}
+
+	inline uint64_t *row(int y) {
+		core_assert(y >= 0 && y < _height);
+		return _bits.data() + (size_t)y * _words;
+	}
+
+	inline const uint64_t *row(int y) const {
+		core_assert(y >= 0 && y < _height);
+		return _bits.data() + (size_t)y * _words;
+	}
+
+	inline void set(int x, int y) {
+		core_assert(x >= 0 && x < _width);
+		row(y)[x >> 6] |= 1ull << (x & 63);
+	}
+
+	inline bool test(int x, int y) const {
+		core_assert(x >= 0 && x < _width);
+		return (row(y)[x >> 6] >> (x & 63)) & 1u;
+	}
+
+	/**
+	 * @return The bits @c x, @c x+1 and @c x+2 of the given row in the lowest three bits
+	 */
+	inline uint32_t bits3(int x, int y) const {
+		core_assert(x >= 0 && x + 2 < _words * 64);
+		const uint64_t *r = row(y);
+		const int word = x >> 6;
+		const int shift = x & 63;
+		uint64_t value = r[word] >> shift;
+		if (shift > 61) {
+			value |= r[word + 1] << (64 - shift);
+		}
+		return (uint32_t)(value & 7u);
+	}
+};
+
+} // namespace voxel
@@ -52,9 +52,8 @@ TEST_F(AmbientOcclusionTest, testAOFaces) {
 	EXPECT_EQ(voxelvertices, 6);
 	EXPECT_EQ(aofound[0], 0); // full occlusion
 	EXPECT_EQ(aofound[1], 0);
-	// TODO: this looks wrong - it should be 4 and 2, not 2 and 4
-	EXPECT_EQ(aofound[2], 2);
-	EXPECT_EQ(aofound[3], 4); // no ao
+	EXPECT_EQ(aofound[2], 4);
+	EXPECT_EQ(aofound[3], 2); // no ao
 }
 
 } // namespace voxel
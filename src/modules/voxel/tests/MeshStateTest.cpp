@@ -21,6 +21,25 @@ protected:
 		core::Var::get(cfg::VoxelMeshSize, "16", core::CV_READONLY);
 		core::Var::get(cfg::VoxelMeshMode, core::string::toString((int)voxel::SurfaceExtractionType::Binary));
 	}
+
+	static void fill(voxel::RawVolume &v, const voxel::Voxel &voxel) {
+		const voxel::Region &region = v.region();
+		for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					v.setVoxel(x, y, z, voxel);
+				}
+			}
+		}
+	}
+
+	static size_t indices(const MeshState &meshState, int idx) {
+		size_t vertCount = 0;
+		size_t normalsCount = 0;
+		size_t indCount = 0;
+		meshState.count(MeshType_Opaque, idx, vertCount, normalsCount, indCount);
+		return indCount;
+	}
 };
 
 TEST_F(MeshStateTest, testExtractRegion) {
@@ -65,4 +84,119 @@ TEST_F(MeshStateTest, testExtractRegionBoundary) {
 	(void)meshState.shutdown();
 }
 
+TEST_F(MeshStateTest, testModifyWhileExtracting) {
+	voxel::RawVolume v(voxel::Region(0, 31));
+	fill(v, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+
+	MeshState meshState;
+	meshState.construct();
+	meshState.init();
+	bool deleted = false;
+	palette::Palette pal;
+	pal.nippon();
+	(void)meshState.setVolume(0, &v, &pal, nullptr, true, deleted);
+
+	meshState.scheduleRegionExtraction(0, v.region());
+	// starts the extraction in the background
+	meshState.update();
+	// the running extractions are working on a snapshot of the volume
+	fill(v, voxel::Voxel());
+	meshState.extractAllPending();
+	EXPECT_EQ(0, meshState.runningExtractions());
+	EXPECT_GT(indices(meshState, 0), 0u);
+
+	// the newer extraction replaces the meshes of the same regions
+	meshState.scheduleRegionExtraction(0, v.region());
+	meshState.update();
+	meshState.extractAllPending();
+	EXPECT_EQ(0u, indices(meshState, 0));
+
+	(void)meshState.shutdown();
+}
+
+TEST_F(MeshStateTest, testPopDoesNotWait) {
+	voxel::RawVolume v(voxel::Region(0, 31));
+	fill(v, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+
+	MeshState meshState;
+	meshState.construct();
+	meshState.init();
+	bool deleted = false;
+	palette::Palette pal;
+	pal.nippon();
+	(void)meshState.setVolume(0, &v, &pal, nullptr, true, deleted);
+
+	meshState.scheduleRegionExtraction(0, v.region());
+	const int scheduled = meshState.pendingExtractions();
+	ASSERT_GT(scheduled, 0);
+	int popped = 0;
+	while (popped < scheduled) {
+		meshState.update();
+		while (meshState.pop() == 0) {
+			++popped;
+		}
+		// keep modifying the volume while the extractions are running
+		v.setVoxel(0, 0, 0, voxel::createVoxel(voxel::VoxelType::Generic, popped % 2));
+	}
+	EXPECT_EQ(scheduled, popped);
+	EXPECT_EQ(0, meshState.pendingExtractions());
+	EXPECT_GT(indices(meshState, 0), 0u);
+
+	(void)meshState.shutdown();
+}
+
+TEST_F(MeshStateTest, testDropResultsOfReplacedVolume) {
+	voxel::RawVolume v(voxel::Region(0, 31));
+	fill(v, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	voxel::RawVolume empty(voxel::Region(0, 31));
+
+	MeshState meshState;
+	meshState.construct();
+	meshState.init();
+	bool deleted = false;
+	palette::Palette pal;
+	pal.nippon();
+	(void)meshState.setVolume(0, &v, &pal, nullptr, true, deleted);
+
+	meshState.scheduleRegionExtraction(0, v.region());
+	meshState.update();
+	EXPECT_EQ(&v, meshState.setVolume(0, &empty, &pal, nullptr, true, deleted));
+	meshState.extractAllPending();
+	EXPECT_EQ(-1, meshState.pop());
+	EXPECT_EQ(0u, indices(meshState, 0));
+
+	(void)meshState.shutdown();
+}
+
+TEST_F(MeshStateTest, testPruneRegionSequences) {
+	voxel::RawVolume v(voxel::Region(0, 31));
+	fill(v, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+
+	MeshState meshState;
+	meshState.construct();
+	meshState.init();
+	bool deleted = false;
+	palette::Palette pal;
+	pal.nippon();
+	(void)meshState.setVolume(0, &v, &pal, nullptr, true, deleted);
+
+	for (int i = 0; i < 4; ++i) {
+		meshState.scheduleRegionExtraction(0, v.region());
+		meshState.update();
+		EXPECT_GT(meshState.runningRegions(), 0);
+	}
+	meshState.extractAllPending();
+	EXPECT_EQ(0, meshState.runningRegions());
+	EXPECT_GT(indices(meshState, 0), 0u);
+
+	// the results of dropped extractions are released, too
+	meshState.scheduleRegionExtraction(0, v.region());
+	meshState.update();
+	meshState.clearPendingExtractions();
+	meshState.extractAllPending();
+	EXPECT_EQ(0, meshState.runningRegions());
+
+	(void)meshState.shutdown();
+}
+
 } // namespace voxelrender
@@ -67,6 +67,65 @@ TEST_F(SparseVolumeTest, testSetVoxels) {
 	ASSERT_EQ(v.region().voxels(), vxls);
 }
 
+TEST_F(SparseVolumeTest, testUnlimitedNegative) {
+	voxel::SparseVolume v;
+	const voxel::Voxel voxel = voxel::createVoxel(VoxelType::Generic, 1);
+	ASSERT_TRUE(v.setVoxel(-1, -9, -17, voxel));
+	ASSERT_TRUE(v.setVoxel(7, 8, 100, voxel));
+	ASSERT_EQ(2u, v.size());
+	EXPECT_TRUE(v.hasVoxel(-1, -9, -17));
+	EXPECT_FALSE(v.hasVoxel(-1, -9, -16));
+	EXPECT_EQ(1, v.voxel(7, 8, 100).getColor());
+	const voxel::Region region = v.calculateRegion();
+	EXPECT_EQ(glm::ivec3(-1, -9, -17), region.getLowerCorner());
+	EXPECT_EQ(glm::ivec3(7, 8, 100), region.getUpperCorner());
+	int cnt = 0;
+	v.visitVoxels([&cnt](const glm::ivec3 &pos, const voxel::Voxel &) {
+		EXPECT_TRUE(pos == glm::ivec3(-1, -9, -17) || pos == glm::ivec3(7, 8, 100));
+		++cnt;
+	});
+	EXPECT_EQ(2, cnt);
+}
+
+TEST_F(SparseVolumeTest, testStoreEmptyVoxels) {
+	voxel::SparseVolume v;
+	v.setStoreEmptyVoxels(true);
+	ASSERT_TRUE(v.setVoxel(1, 2, 3, voxel::Voxel()));
+	EXPECT_TRUE(v.hasVoxel(1, 2, 3));
+	EXPECT_FALSE(v.hasVoxel(1, 2, 4));
+	EXPECT_EQ(1u, v.size());
+	voxel::SparseVolume copy(v);
+	EXPECT_TRUE(copy.hasVoxel(1, 2, 3));
+	EXPECT_EQ(1u, copy.size());
+	v.clear();
+	EXPECT_TRUE(v.empty());
+	EXPECT_FALSE(v.hasVoxel(1, 2, 3));
+	EXPECT_TRUE(copy.hasVoxel(1, 2, 3));
+}
+
+TEST_F(SparseVolumeTest, testSamplerBrickCache) {
+	voxel::SparseVolume v;
+	SparseVolume::Sampler sampler(v);
+	sampler.setPosition(7, 0, 0);
+	// caches the empty neighbour brick
+	EXPECT_TRUE(voxel::isAir(sampler.peekVoxel1px0py0pz().getMaterial()));
+	// a new brick is created - the sampler must not return the cached empty brick
+	v.setVoxel(8, 0, 0, voxel::createVoxel(VoxelType::Generic, 2));
+	EXPECT_EQ(2, sampler.peekVoxel1px0py0pz().getColor());
+	sampler.movePositiveX();
+	EXPECT_EQ(2, sampler.voxel().getColor());
+	EXPECT_TRUE(voxel::isAir(sampler.peekVoxel1px0py0pz().getMaterial()));
+	EXPECT_TRUE(voxel::isAir(sampler.peekVoxel1nx0py0pz().getMaterial()));
+	sampler.moveNegativeY(20);
+	EXPECT_TRUE(voxel::isAir(sampler.voxel().getMaterial()));
+	EXPECT_TRUE(sampler.setVoxel(voxel::createVoxel(VoxelType::Generic, 3)));
+	EXPECT_EQ(3, v.voxel(8, -20, 0).getColor());
+	EXPECT_EQ(3, sampler.voxel().getColor());
+	v.clear();
+	EXPECT_TRUE(voxel::isAir(sampler.peekVoxel0px0py1pz().getMaterial()));
+	EXPECT_TRUE(voxel::isAir(sampler.peekVoxel0px1py0pz().getMaterial()));
+}
+
 TEST_F(SparseVolumeTest, testFullSamplerLoop) {
 	const voxel::Region region{glm::ivec3(0), glm::ivec3(63)};
 	SparseVolume v(region);
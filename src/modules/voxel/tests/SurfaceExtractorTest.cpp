@@ -28,6 +28,94 @@ protected:
 		EXPECT_EQ(vertex.ambientOcclusion, expectedAO) << msg << " - AO mismatch";
 	}
 
+	struct Checksum {
+		uint32_t vertices = 0u;
+		uint32_t indices = 0u;
+		uint64_t hash = 14695981039346656037ull;
+
+		void add(const void *data, size_t size) {
+			const uint8_t *bytes = (const uint8_t *)data;
+			for (size_t i = 0; i < size; ++i) {
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+		}
+	};
+
+	/**
+	 * @brief Helper to detect any change in the marching cubes output - including the normals
+	 */
+	static Checksum marchingCubesChecksum(const RawVolume &v, const Region &region) {
+		voxel::ChunkMesh mesh;
+		palette::Palette pal;
+		pal.nippon();
+		SurfaceExtractionContext ctx = voxel::buildMarchingCubesContext(&v, region, mesh, pal, false);
+		voxel::extractSurface(ctx);
+
+		const Mesh &m = mesh.mesh[0];
+		Checksum checksum;
+		checksum.vertices = (uint32_t)m.getNoOfVertices();
+		checksum.indices = (uint32_t)m.getNoOfIndices();
+		for (const VoxelVertex &vertex : m.getVertexVector()) {
+			checksum.add(&vertex.position, sizeof(vertex.position));
+			checksum.add(&vertex.colorIndex, sizeof(vertex.colorIndex));
+			const uint8_t flags = vertex.flags;
+			checksum.add(&flags, sizeof(flags));
+		}
+		for (const glm::vec3 &normal : m.getNormalVector()) {
+			checksum.add(&normal, sizeof(normal));
+		}
+		for (const IndexType &index : m.getIndexVector()) {
+			checksum.add(&index, sizeof(index));
+		}
+		return checksum;
+	}
+
+	/**
+	 * @brief Helper to detect any change in the output of the cubic and binary extractors - including the ambient
+	 * occlusion values of the opaque and transparent meshes
+	 */
+	static Checksum meshChecksum(SurfaceExtractionContext &ctx) {
+		voxel::extractSurface(ctx);
+		Checksum checksum;
+		for (int i = 0; i < ChunkMesh::Meshes; ++i) {
+			const Mesh &m = ctx.mesh.mesh[i];
+			checksum.vertices += (uint32_t)m.getNoOfVertices();
+			checksum.indices += (uint32_t)m.getNoOfIndices();
+			for (const VoxelVertex &vertex : m.getVertexVector()) {
+				checksum.add(&vertex.position, sizeof(vertex.position));
+				checksum.add(&vertex.colorIndex, sizeof(vertex.colorIndex));
+				const uint8_t ambientOcclusion = vertex.ambientOcclusion;
+				checksum.add(&ambientOcclusion, sizeof(ambientOcclusion));
+				const uint8_t flags = vertex.flags;
+				checksum.add(&flags, sizeof(flags));
+			}
+			for (const IndexType &index : m.getIndexVector()) {
+				checksum.add(&index, sizeof(index));
+			}
+		}
+		return checksum;
+	}
+
+	/**
+	 * @brief Fills the volume with random opaque and transparent voxels with only a few colors to allow quad merging
+	 */
+	static void fillRandom(RawVolume &v, uint32_t density) {
+		const Region &region = v.region();
+		uint32_t seed = 1u;
+		for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					seed = seed * 1664525u + 1013904223u;
+					if ((seed >> 24) >= density) {
+						continue;
+					}
+					const VoxelType type = ((seed >> 16) & 7u) == 0u ? VoxelType::Transparent : VoxelType::Generic;
+					v.setVoxel(x, y, z, voxel::createVoxel(type, (seed >> 8) & 3u));
+				}
+			}
+		}
+	}
+
 	/**
 	 * @brief Helper to count triangles with a specific color
 	 */
@@ -206,6 +294,105 @@ TEST_F(SurfaceExtractorTest, testMeshExtractionMarchingCubes) {
 	EXPECT_EQ(30, (int)mesh.mesh[0].getNoOfVertices());
 }
 
+// the mesh must stay bit-identical if the marching cubes extractor gets optimized
+TEST_F(SurfaceExtractorTest, testMeshExtractionMarchingCubesChecksum) {
+	const voxel::Region region(0, 0, 0, 23, 17, 29);
+	voxel::RawVolume v(region);
+	uint32_t seed = 1u;
+	for (int z = 0; z <= 29; ++z) {
+		for (int y = 0; y <= 17; ++y) {
+			for (int x = 0; x <= 23; ++x) {
+				seed = seed * 1664525u + 1013904223u;
+				if ((seed >> 24) < 100u) {
+					v.setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, (seed >> 8) & 0xFF));
+				}
+			}
+		}
+	}
+	// extract a sub region to also cover the region boundaries
+	const voxel::Region extractRegion(2, 1, 3, 20, 17, 26);
+	const Checksum checksum = marchingCubesChecksum(v, extractRegion);
+	EXPECT_EQ(13685u, checksum.vertices);
+	EXPECT_EQ(83682u, checksum.indices);
+	EXPECT_EQ(9171248548526130937ull, checksum.hash);
+}
+
+TEST_F(SurfaceExtractorTest, testMeshExtractionMarchingCubesSparseChecksum) {
+	const voxel::Region region(-5, -3, -7, 40, 20, 33);
+	voxel::RawVolume v(region);
+	for (int z = -7; z <= 2; ++z) {
+		for (int y = 0; y <= 4; ++y) {
+			for (int x = 30; x <= 40; ++x) {
+				v.setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, (uint8_t)(x + y)));
+			}
+		}
+	}
+	for (int z = 10; z <= 33; ++z) {
+		v.setVoxel(3, 7, z, voxel::createVoxel(voxel::VoxelType::Generic, 3));
+		v.setVoxel(-5, 20, z, voxel::createVoxel(voxel::VoxelType::Generic, 4));
+	}
+	// the extraction region exceeds the volume
+	const voxel::Region extractRegion(-8, -4, -9, 42, 21, 35);
+	const Checksum checksum = marchingCubesChecksum(v, extractRegion);
+	EXPECT_EQ(626u, checksum.vertices);
+	EXPECT_EQ(3720u, checksum.indices);
+	EXPECT_EQ(1554273192833525256ull, checksum.hash);
+}
+
+// the meshes must stay bit-identical if the neighbour lookups of the cubic extractor get optimized
+TEST_F(SurfaceExtractorTest, testMeshExtractionCubicChecksum) {
+	// wider than 64 voxels to cover more than one word of the occupancy rows
+	voxel::RawVolume v(voxel::Region(-3, 0, 0, 77, 19, 23));
+	fillRandom(v, 120u);
+	// the extraction region exceeds the volume
+	const voxel::Region extractRegion(-5, 2, -1, 79, 21, 20);
+	{
+		voxel::ChunkMesh mesh;
+		SurfaceExtractionContext ctx = buildCubicContext(&v, extractRegion, mesh, glm::ivec3(0), true, true, true);
+		const Checksum checksum = meshChecksum(ctx);
+		EXPECT_EQ(127356u, checksum.vertices);
+		EXPECT_EQ(329946u, checksum.indices);
+		EXPECT_EQ(12099539099920372051ull, checksum.hash);
+	}
+	{
+		voxel::ChunkMesh mesh;
+		SurfaceExtractionContext ctx = buildCubicContext(&v, extractRegion, mesh, glm::ivec3(1, 2, 3), false, true, true);
+		const Checksum checksum = meshChecksum(ctx);
+		EXPECT_EQ(127819u, checksum.vertices);
+		EXPECT_EQ(332778u, checksum.indices);
+		EXPECT_EQ(1459981373291512566ull, checksum.hash);
+	}
+	{
+		voxel::ChunkMesh mesh;
+		SurfaceExtractionContext ctx = buildCubicContext(&v, extractRegion, mesh, glm::ivec3(0), true, false, false);
+		const Checksum checksum = meshChecksum(ctx);
+		EXPECT_EQ(219436u, checksum.vertices);
+		EXPECT_EQ(332778u, checksum.indices);
+		EXPECT_EQ(6664438221590243615ull, checksum.hash);
+	}
+}
+
+TEST_F(SurfaceExtractorTest, testBinaryGreedyMesherChecksum) {
+	voxel::RawVolume v(voxel::Region(0, 0, 0, 29, 29, 29));
+	fillRandom(v, 90u);
+	{
+		voxel::ChunkMesh mesh;
+		SurfaceExtractionContext ctx = buildBinaryContext(&v, v.region(), mesh, glm::ivec3(0), true, false);
+		const Checksum checksum = meshChecksum(ctx);
+		EXPECT_EQ(166296u, checksum.vertices);
+		EXPECT_EQ(249444u, checksum.indices);
+		EXPECT_EQ(11778749275620661313ull, checksum.hash);
+	}
+	{
+		voxel::ChunkMesh mesh;
+		SurfaceExtractionContext ctx = buildBinaryContext(&v, v.region(), mesh, glm::ivec3(0), false, false);
+		const Checksum checksum = meshChecksum(ctx);
+		EXPECT_EQ(154204u, checksum.vertices);
+		EXPECT_EQ(231306u, checksum.indices);
+		EXPECT_EQ(5393676154404538905ull, checksum.hash);
+	}
+}
+
 TEST_F(SurfaceExtractorTest, testBinaryGreedyMesherSingleVoxel) {
 	// Test a single voxel in the center - should generate 6 faces (12 triangles)
 	const Region region(0, 0, 0, 2, 2, 2);
@@ -0,0 +1,385 @@
+/**
+ * @file
+ */
+
+#include "AssetIndex.h"
+#include "core/FourCC.h"
+#include "core/Log.h"
+#include "core/ScopedPtr.h"
+#include "core/StringUtil.h"
+#include "core/Trace.h"
+#include "io/BufferedReadWriteStream.h"
+#include "io/FormatDescription.h"
+#include "io/MemoryReadStream.h"
+#include "scenegraph/SceneGraph.h"
+#include "scenegraph/SceneGraphNode.h"
+#include "voxelformat/VolumeFormat.h"
+#include "voxelutil/VolumeVisitor.h"
+
+namespace voxelcollection {
+
+static constexpr uint32_t AssetIndexMagic = FourCC('V', 'A', 'I', 'X');
+
+#define wrapBool(action)                                                                                               \
+	if ((action) != true) {                                                                                            \
+		Log::error("Error: Failed to execute " CORE_STRINGIFY(action) " (line %i)", (int)__LINE__);                    \
+		return false;                                                                                                  \
+	}
+
+static bool encodeThumbnail(const image::ImagePtr &image, core::Buffer<uint8_t> &out) {
+	if (!image || !image->isLoaded()) {
+		return false;
+	}
+	image::ImagePtr scaled = image;
+	const int w = image->width();
+	const int h = image->height();
+	if (w > AssetIndex::ThumbnailSize || h > AssetIndex::ThumbnailSize) {
+		// don't modify the given image - it might also be used for the texture pool
+		const float scale = (float)AssetIndex::ThumbnailSize / (float)core_max(w, h);
+		scaled = image::createEmptyImage(image->name());
+		if (image->components() != 4 || !scaled->loadRGBA(image->data(), w, h) ||
+			!scaled->resize(core_max(1, (int)((float)w * scale)), core_max(1, (int)((float)h * scale)))) {
+			scaled = image;
+		}
+	}
+	io::BufferedReadWriteStream stream;
+	if (!scaled->writePNG(stream)) {
+		return false;
+	}
+	out.clear();
+	out.append(stream.getBuffer(), (size_t)stream.size());
+	return true;
+}
+
+bool AssetIndex::load(io::SeekableReadStream &stream) {
+	core_trace_scoped(AssetIndexLoad);
+	uint32_t magic;
+	wrapBool(stream.readUInt32(magic) == 0)
+	if (magic != AssetIndexMagic) {
+		Log::warn("Invalid asset index magic");
+		return false;
+	}
+	uint32_t version;
+	wrapBool(stream.readUInt32(version) == 0)
+	if (version != Version) {
+		Log::info("Asset index version %u is outdated - rebuild the index", version);
+		return false;
+	}
+	uint32_t count;
+	wrapBool(stream.readUInt32(count) == 0)
+
+	core::DynamicArray<Record> records;
+	records.reserve(count);
+	for (uint32_t i = 0u; i < count; ++i) {
+		Record record;
+		AssetEntry &entry = record.entry;
+		wrapBool(stream.readPascalStringUInt16LE(entry.path))
+		wrapBool(stream.readUInt64(entry.mtime) == 0)
+		wrapBool(stream.readUInt64(entry.size) == 0)
+		wrapBool(stream.readPascalStringUInt16LE(entry.format))
+		wrapBool(stream.readInt32(entry.dimensions.x) == 0)
+		wrapBool(stream.readInt32(entry.dimensions.y) == 0)
+		wrapBool(stream.readInt32(entry.dimensions.z) == 0)
+		wrapBool(stream.readUInt64(entry.voxels) == 0)
+		wrapBool(stream.readUInt32(entry.nodes) == 0)
+		wrapBool(stream.readUInt64(entry.paletteHash) == 0)
+		entry.scanned = stream.readBool();
+		uint32_t thumbnailSize;
+		wrapBool(stream.readUInt32(thumbnailSize) == 0)
+		if (thumbnailSize > 0u) {
+			if ((int64_t)thumbnailSize > stream.remaining()) {
+				Log::error("Invalid thumbnail size in asset index");
+				return false;
+			}
+			record.thumbnail.resize(thumbnailSize);
+			wrapBool(stream.read(record.thumbnail.data(), thumbnailSize) == (int)thumbnailSize)
+		}
+		entry.hasThumbnail = !record.thumbnail.empty();
+		record.searchKey = entry.path.toLower();
+		records.emplace_back(core::move(record));
+	}
+
+	core::ScopedLock lock(_lock);
+	_records = core::move(records);
+	_paths.clear();
+	_paths.reserve(_records.size());
+	for (size_t i = 0u; i < _records.size(); ++i) {
+		_paths.put(_records[i].entry.path, i);
+	}
+	_dirty = false;
+	Log::debug("Loaded %i asset index entries", (int)_records.size());
+	return true;
+}
+
+bool AssetIndex::save(io::SeekableWriteStream &stream) {
+	core_trace_scoped(AssetIndexSave);
+	core::ScopedLock lock(_lock);
+	wrapBool(stream.writeUInt32(AssetIndexMagic))
+	wrapBool(stream.writeUInt32(Version))
+	wrapBool(stream.writeUInt32((uint32_t)_records.size()))
+	for (const Record &record : _records) {
+		const AssetEntry &entry = record.entry;
+		wrapBool(stream.writePascalStringUInt16LE(entry.path))
+		wrapBool(stream.writeUInt64(entry.mtime))
+		wrapBool(stream.writeUInt64(entry.size))
+		wrapBool(stream.writePascalStringUInt16LE(entry.format))
+		wrapBool(stream.writeInt32(entry.dimensions.x))
+		wrapBool(stream.writeInt32(entry.dimensions.y))
+		wrapBool(stream.writeInt32(entry.dimensions.z))
+		wrapBool(stream.writeUInt64(entry.voxels))
+		wrapBool(stream.writeUInt32(entry.nodes))
+		wrapBool(stream.writeUInt64(entry.paletteHash))
+		wrapBool(stream.writeBool(entry.scanned))
+		wrapBool(stream.writeUInt32((uint32_t)record.thumbnail.size()))
+		if (!record.thumbnail.empty()) {
+			wrapBool(stream.write(record.thumbnail.data(), record.thumbnail.size()) == (int)record.thumbnail.size())
+		}
+	}
+	_dirty = false;
+	return true;
+}
+
+#undef wrapBool
+
+void AssetIndex::beginScan() {
+	core::ScopedLock lock(_lock);
+	++_scan;
+}
+
+bool AssetIndex::update(const io::FilesystemEntry &fsEntry) {
+	core::ScopedLock lock(_lock);
+	auto iter = _paths.find(fsEntry.fullPath);
+	if (iter != _paths.end()) {
+		Record &record = _records[iter->value];
+		record.scan = _scan;
+		AssetEntry &entry = record.entry;
+		if (entry.mtime == fsEntry.mtime && entry.size == fsEntry.size) {
+			return !entry.scanned;
+		}
+		// the file was modified - the metadata and the thumbnail are outdated
+		entry = AssetEntry();
+		entry.path = fsEntry.fullPath;
+		entry.mtime = fsEntry.mtime;
+		entry.size = fsEntry.size;
+		record.thumbnail.clear();
+		_dirty = true;
+		return true;
+	}
+	Record record;
+	record.entry.path = fsEntry.fullPath;
+	record.entry.mtime = fsEntry.mtime;
+	record.entry.size = fsEntry.size;
+	record.searchKey = fsEntry.fullPath.toLower();
+	record.scan = _scan;
+	_paths.put(fsEntry.fullPath, _records.size());
+	_records.emplace_back(core::move(record));
+	_dirty = true;
+	return true;
+}
+
+int AssetIndex::endScan(const core::String &dir) {
+	// scanning /foo/bar must not remove the entries of /foo/barbaz
+	const core::String prefix = dir.empty() ? dir : core::string::sanitizeDirPath(dir);
+	core::ScopedLock lock(_lock);
+	size_t n = 0u;
+	for (size_t i = 0u; i < _records.size(); ++i) {
+		Record &record = _records[i];
+		if (record.scan != _scan && core::string::startsWith(record.entry.path, prefix)) {
+			continue;
+		}
+		if (n != i) {
+			_records[n] = core::move(record);
+		}
+		++n;
+	}
+	const int removed = (int)(_records.size() - n);
+	if (removed == 0) {
+		return 0;
+	}
+	_records.erase(n, _records.size() - n);
+	_paths.clear();
+	for (size_t i = 0u; i < _records.size(); ++i) {
+		_paths.put(_records[i].entry.path, i);
+	}
+	_dirty = true;
+	return removed;
+}
+
+bool AssetIndex::setMetadata(const AssetEntry &entry, const image::ImagePtr &thumbnail) {
+	// encode outside of the lock
+	core::Buffer<uint8_t> png;
+	encodeThumbnail(thumbnail, png);
+
+	core::ScopedLock lock(_lock);
+	auto iter = _paths.find(entry.path);
+	if (iter == _paths.end()) {
+		return false;
+	}
+	Record &record = _records[iter->value];
+	if (record.entry.mtime != entry.mtime || record.entry.size != entry.size) {
+		Log::debug("Ignore outdated metadata for %s", entry.path.c_str());
+		return false;
+	}
+	record.entry = entry;
+	record.entry.scanned = true;
+	if (!png.empty()) {
+		record.thumbnail = core::move(png);
+	}
+	record.entry.hasThumbnail = !record.thumbnail.empty();
+	_dirty = true;
+	return true;
+}
+
+bool AssetIndex::setThumbnail(const core::String &path, const image::ImagePtr &thumbnail) {
+	core::Buffer<uint8_t> png;
+	if (!encodeThumbnail(thumbnail, png)) {
+		return false;
+	}
+	core::ScopedLock lock(_lock);
+	auto iter = _paths.find(path);
+	if (iter == _paths.end()) {
+		return false;
+	}
+	Record &record = _records[iter->value];
+	record.thumbnail = core::move(png);
+	record.entry.hasThumbnail = true;
+	_dirty = true;
+	return true;
+}
+
+image::ImagePtr AssetIndex::thumbnail(const core::String &path, const core::String &name) const {
+	core::Buffer<uint8_t> png;
+	{
+		core::ScopedLock lock(_lock);
+		auto iter = _paths.find(path);
+		if (iter == _paths.end()) {
+			return image::ImagePtr();
+		}
+		png = _records[iter->value].thumbnail;
+	}
+	if (png.empty()) {
+		return image::ImagePtr();
+	}
+	io::MemoryReadStream stream(png.data(), png.size());
+	image::ImagePtr image = image::loadImage(name, stream, (int)png.size());
+	if (!image || !image->isLoaded()) {
+		Log::debug("Failed to decode the thumbnail of %s", path.c_str());
+		return image::ImagePtr();
+	}
+	return image;
+}
+
+bool AssetIndex::get(const core::String &path, AssetEntry &entry) const {
+	core::ScopedLock lock(_lock);
+	auto iter = _paths.find(path);
+	if (iter == _paths.end()) {
+		return false;
+	}
+	entry = _records[iter->value].entry;
+	return true;
+}
+
+bool AssetIndex::matches(const Record &record, const AssetQuery &query, const core::String &lowerName) const {
+	const AssetEntry &entry = record.entry;
+	if (entry.voxels < query.minVoxels || entry.voxels > query.maxVoxels) {
+		return false;
+	}
+	if (entry.nodes < query.minNodes || entry.nodes > query.maxNodes) {
+		return false;
+	}
+	if (query.maxDimension > 0 && (entry.dimensions.x > query.maxDimension ||
+								   entry.dimensions.y > query.maxDimension ||
+								   entry.dimensions.z > query.maxDimension)) {
+		return false;
+	}
+	if (query.paletteHash != 0u && entry.paletteHash != query.paletteHash) {
+		return false;
+	}
+	if (query.onlyThumbnails && !entry.hasThumbnail) {
+		return false;
+	}
+	if (!query.format.empty() && entry.format != query.format) {
+		return false;
+	}
+	if (!lowerName.empty() && !record.searchKey.contains(lowerName)) {
+		return false;
+	}
+	return true;
+}
+
+core::DynamicArray<AssetEntry> AssetIndex::query(const AssetQuery &query) const {
+	core_trace_scoped(AssetIndexQuery);
+	const core::String &lowerName = query.name.toLower();
+	core::DynamicArray<AssetEntry> result;
+	core::ScopedLock lock(_lock);
+	for (const Record &record : _records) {
+		if (matches(record, query, lowerName)) {
+			result.push_back(record.entry);
+		}
+	}
+	return result;
+}
+
+void AssetIndex::clear() {
+	core::ScopedLock lock(_lock);
+	_records.clear();
+	_paths.clear();
+	_dirty = true;
+}
+
+size_t AssetIndex::size() const {
+	core::ScopedLock lock(_lock);
+	return _records.size();
+}
+
+bool AssetIndex::dirty() const {
+	core::ScopedLock lock(_lock);
+	return _dirty;
+}
+
+bool extractAssetMetadata(const io::ArchivePtr &archive, AssetEntry &entry, image::ImagePtr &thumbnail) {
+	core_trace_scoped(ExtractAssetMetadata);
+	io::FileDescription fileDesc;
+	fileDesc.set(entry.path);
+	if (const io::FormatDescription *desc = io::getDescription(fileDesc, 0, voxelformat::voxelLoad())) {
+		entry.format = desc->name;
+	}
+
+	scenegraph::SceneGraph sceneGraph;
+	voxelformat::LoadContext loadCtx;
+	if (!voxelformat::loadFormat(fileDesc, archive, sceneGraph, loadCtx)) {
+		Log::debug("Failed to load %s for the asset index", entry.path.c_str());
+		return false;
+	}
+	entry.dimensions = sceneGraph.region().getDimensionsInVoxels();
+	entry.nodes = (uint32_t)sceneGraph.size(scenegraph::SceneGraphNodeType::AllModels);
+	entry.voxels = 0u;
+	entry.paletteHash = 0u;
+	for (auto iter = sceneGraph.beginModel(); iter != sceneGraph.end(); ++iter) {
+		const scenegraph::SceneGraphNode &node = *iter;
+		entry.voxels += (uint64_t)voxelutil::countVoxels(*node.volume());
+		const uint64_t paletteHash = node.palette().hash();
+		if (entry.paletteHash == 0u) {
+			entry.paletteHash = paletteHash;
+		} else if (entry.paletteHash != paletteHash) {
+			entry.paletteHash = (entry.paletteHash ^ paletteHash) * 0x100000001b3ULL;
+		}
+	}
+	entry.scanned = true;
+
+	// prefer the thumbnails that were already created for the collection panel
+	const core::String &pngFile = entry.path + ".png";
+	if (archive->exists(pngFile)) {
+		core::ScopedPtr<io::SeekableReadStream> stream(archive->readStream(pngFile));
+		if (stream) {
+			thumbnail = image::loadImage(pngFile, *stream);
+		}
+	}
+	if (!thumbnail || !thumbnail->isLoaded()) {
+		thumbnail = voxelformat::loadScreenshot(entry.path, archive, loadCtx);
+	}
+	entry.hasThumbnail = thumbnail && thumbnail->isLoaded();
+	return true;
+}
+
+} // namespace voxelcollection
@@ -0,0 +1,150 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/SharedPtr.h"
+#include "core/String.h"
+#include "core/Trace.h"
+#include "core/collection/Buffer.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/HashMap.h"
+#include "core/concurrent/Lock.h"
+#include "image/Image.h"
+#include "io/Archive.h"
+#include "io/FilesystemEntry.h"
+#include "io/Stream.h"
+#include <glm/vec3.hpp>
+#include <limits.h>
+#include <stdint.h>
+
+namespace voxelcollection {
+
+/**
+ * @brief The precomputed metadata of a local voxel file
+ */
+struct AssetEntry {
+	/** absolute path of the file */
+	core::String path;
+	/** modification time in millis - used to detect changed files */
+	uint64_t mtime = 0u;
+	/** file size in bytes - used to detect changed files */
+	uint64_t size = 0u;
+	/** name of the voxel format description */
+	core::String format;
+	glm::ivec3 dimensions{0};
+	uint64_t voxels = 0u;
+	uint32_t nodes = 0u;
+	/** combined hash of the palettes of all model nodes */
+	uint64_t paletteHash = 0u;
+	/** @c true if the metadata was extracted for the current mtime and size */
+	bool scanned = false;
+	bool hasThumbnail = false;
+};
+
+/**
+ * @brief Filter for @c AssetIndex::query() - the default values match every entry
+ */
+struct AssetQuery {
+	/** case insensitive part of the path */
+	core::String name;
+	/** name of the voxel format description */
+	core::String format;
+	uint64_t minVoxels = 0u;
+	uint64_t maxVoxels = UINT64_MAX;
+	uint32_t minNodes = 0u;
+	uint32_t maxNodes = UINT32_MAX;
+	/** the max extent of the scene on any axis - @c 0 for no limit */
+	int maxDimension = 0;
+	/** @c 0 to accept every palette */
+	uint64_t paletteHash = 0u;
+	bool onlyThumbnails = false;
+};
+
+/**
+ * @brief Persistent index of the local voxel files
+ *
+ * The index stores the metadata and a small png thumbnail for every known file in one binary file. The entries are
+ * re-validated by comparing the modification time and size of the file - only new or changed files must be loaded
+ * again to extract their metadata. This allows to open huge asset libraries without loading every single file.
+ *
+ * @note All functions are thread safe - the metadata extraction is usually done in background tasks.
+ * @sa extractAssetMetadata()
+ */
+class AssetIndex {
+public:
+	static constexpr uint32_t Version = 1u;
+	/** the max width or height of the stored thumbnails */
+	static constexpr int ThumbnailSize = 128;
+
+private:
+	struct Record {
+		AssetEntry entry;
+		/** lower case path to speed up the name filter */
+		core::String searchKey;
+		/** png encoded */
+		core::Buffer<uint8_t> thumbnail;
+		/** the scan that has seen the file - not persisted */
+		uint32_t scan = 0u;
+	};
+	mutable core_trace_mutex(core::Lock, _lock, "AssetIndex");
+	core::DynamicArray<Record> _records;
+	core::HashMap<core::String, size_t, core::StringHash> _paths;
+	uint32_t _scan = 0u;
+	bool _dirty = false;
+
+	bool matches(const Record &record, const AssetQuery &query, const core::String &lowerName) const;
+
+public:
+	bool load(io::SeekableReadStream &stream);
+	bool save(io::SeekableWriteStream &stream);
+
+	/**
+	 * @brief Start a new directory scan - all files that are not reported via @c update() until @c endScan() is
+	 * called are removed from the index
+	 */
+	void beginScan();
+	/**
+	 * @brief Add the given file to the index or validate the existing entry
+	 * @return @c true if the metadata must get extracted because the file is new or was modified
+	 */
+	bool update(const io::FilesystemEntry &entry);
+	/**
+	 * @brief Remove all entries below the given directory that were not seen in the current scan
+	 * @return The amount of removed entries
+	 */
+	int endScan(const core::String &dir);
+
+	/**
+	 * @brief Store the extracted metadata - this is ignored if the file was modified in the meantime
+	 */
+	bool setMetadata(const AssetEntry &entry, const image::ImagePtr &thumbnail);
+	bool setThumbnail(const core::String &path, const image::ImagePtr &thumbnail);
+	/**
+	 * @brief Decodes the stored thumbnail
+	 * @return An empty pointer if there is no thumbnail for the given file
+	 */
+	image::ImagePtr thumbnail(const core::String &path, const core::String &name) const;
+
+	bool get(const core::String &path, AssetEntry &entry) const;
+	core::DynamicArray<AssetEntry> query(const AssetQuery &query) const;
+
+	void clear();
+	size_t size() const;
+	/**
+	 * @return @c true if the index was modified since it was loaded or saved the last time
+	 */
+	bool dirty() const;
+};
+
+using AssetIndexPtr = core::SharedPtr<AssetIndex>;
+
+/**
+ * @brief Load the given file and fill the metadata of the entry - this includes a thumbnail if the format embeds
+ * one or if there is a png with the same name next to the file.
+ * @note This is doing a full load of the file
+ */
+bool extractAssetMetadata(const io::ArchivePtr &archive, AssetEntry &entry, image::ImagePtr &thumbnail);
+
+} // namespace voxelcollection
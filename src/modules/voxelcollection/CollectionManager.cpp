@@ -19,6 +19,8 @@
 
 namespace voxelcollection {
 
+static const char *AssetIndexFile = "assetindex.bin";
+
 CollectionManager::CollectionManager(const io::FilesystemPtr &filesystem, const video::TexturePoolPtr &texturePool)
 	: _texturePool(texturePool), _filesystem(filesystem) {
 	_archive = io::openFilesystemArchive(filesystem, "", false);
@@ -27,6 +29,7 @@ CollectionManager::CollectionManager(const io::FilesystemPtr &filesystem, const
 	_newVoxelFiles = core::make_shared<QueuePtr::value_type>();
 	_imageQueue = core::make_shared<ImageQueuePtr::value_type>();
 	_voxelSourceQueue = core::make_shared<VoxelSourceQueuePtr::value_type>();
+	_assetIndex = core::make_shared<AssetIndex>();
 }
 
 CollectionManager::~CollectionManager() {
@@ -52,6 +55,41 @@ bool CollectionManager::init() {
 	if (_localDir.empty()) {
 		var->setVal(documents);
 	}
+	loadAssetIndex();
+	return true;
+}
+
+bool CollectionManager::loadAssetIndex() {
+	if (!_archive->exists(AssetIndexFile)) {
+		Log::debug("No asset index found - it will be created with the next scan");
+		return false;
+	}
+	core::ScopedPtr<io::SeekableReadStream> stream(_archive->readStream(AssetIndexFile));
+	if (!stream) {
+		return false;
+	}
+	if (!_assetIndex->load(*stream)) {
+		Log::warn("Failed to load the asset index - it will be rebuilt");
+		_assetIndex->clear();
+		return false;
+	}
+	return true;
+}
+
+bool CollectionManager::saveAssetIndex() {
+	if (!_assetIndex->dirty()) {
+		return true;
+	}
+	core::ScopedPtr<io::SeekableWriteStream> stream(_archive->writeStream(AssetIndexFile));
+	if (!stream) {
+		Log::warn("Failed to open the asset index for writing");
+		return false;
+	}
+	if (!_assetIndex->save(*stream)) {
+		Log::warn("Failed to write the asset index");
+		return false;
+	}
+	Log::debug("Saved the asset index with %i entries", (int)_assetIndex->size());
 	return true;
 }
 
@@ -78,6 +116,7 @@ bool CollectionManager::setLocalDir(const core::String &dir) {
 }
 
 void CollectionManager::shutdown() {
+	saveAssetIndex();
 }
 
 bool CollectionManager::local() {
@@ -92,7 +131,10 @@ bool CollectionManager::local() {
 	Log::info("Local document scanning (%s)...", localDir.c_str());
 	_archive->list(localDir, entities, "");
 	Log::debug("Found %i entries in %s", (int)entities.size(), localDir.c_str());
-	app::for_parallel(0, entities.size(), [entities, localDir, voxelFiles = _newVoxelFiles](int start, int end) {
+	core::ConcurrentQueue<VoxelFile> outdated;
+	_assetIndex->beginScan();
+	app::for_parallel(0, entities.size(), [&entities, &outdated, localDir, voxelFiles = _newVoxelFiles,
+										   assetIndex = _assetIndex](int start, int end) {
 		for (int i = start; i < end; ++i) {
 			const io::FilesystemEntry &entry  = entities[i];
 			if (!io::isA(entry.name, voxelformat::voxelLoad())) {
@@ -107,12 +149,38 @@ bool CollectionManager::local() {
 			// voxelFile.licenseUrl = "";
 			// voxelFile.thumbnailUrl = "";
 			voxelFile.downloaded = true;
+			if (assetIndex->update(entry)) {
+				outdated.push(voxelFile);
+			}
 			voxelFiles->push(voxelFile);
 		}
 	});
+	const int removed = _assetIndex->endScan(localDir);
+	Log::debug("Removed %i deleted files from the asset index", removed);
 	VoxelCollection collection{{}, 0.0, true};
 	_voxelFilesMap.put(LOCAL_SOURCE, collection);
 
+	// only new or modified files must be loaded - everything else is taken from the asset index
+	VoxelFiles outdatedFiles;
+	outdated.popAll(outdatedFiles);
+	Log::info("Update the asset index for %i of %i files", (int)outdatedFiles.size(), (int)_assetIndex->size());
+	for (const VoxelFile &voxelFile : outdatedFiles) {
+		app::schedule([archive = _archive, assetIndex = _assetIndex, imageQueue = _imageQueue, voxelFile]() {
+			AssetEntry entry;
+			if (!assetIndex->get(voxelFile.fullPath, entry)) {
+				return;
+			}
+			image::ImagePtr thumbnail;
+			extractAssetMetadata(archive, entry, thumbnail);
+			// files that failed to load are stored, too - otherwise they would get loaded again with every scan
+			assetIndex->setMetadata(entry, thumbnail);
+			if (thumbnail && thumbnail->isLoaded()) {
+				thumbnail->setName(voxelFile.id());
+				imageQueue->push(thumbnail);
+			}
+		});
+	}
+
 	return true;
 }
 
@@ -128,6 +196,20 @@ void CollectionManager::loadThumbnail(const VoxelFile &voxelFile) {
 	if (_texturePool->has(voxelFile.name)) {
 		return;
 	}
+	if (voxelFile.isLocal()) {
+		AssetEntry entry;
+		if (!_assetIndex->get(voxelFile.fullPath, entry) || !entry.scanned || !entry.hasThumbnail) {
+			// outdated entries get their thumbnail with the metadata extraction that was started by local()
+			return;
+		}
+		app::schedule([assetIndex = _assetIndex, imageQueue = _imageQueue, voxelFile]() {
+			image::ImagePtr image = assetIndex->thumbnail(voxelFile.fullPath, voxelFile.id());
+			if (image) {
+				imageQueue->push(image);
+			}
+		});
+		return;
+	}
 	const core::String &targetImageFile = voxelFile.targetFile() + ".png";
 	if (_archive->exists(targetImageFile)) {
 		app::schedule([voxelFile, targetImageFile, archive = _archive, imageQueue = _imageQueue]() {
@@ -185,6 +267,9 @@ bool CollectionManager::createThumbnail(const VoxelFile &voxelFile) {
 	}
 	image->setName(voxelFile.id());
 	_imageQueue->push(image);
+	if (voxelFile.isLocal()) {
+		_assetIndex->setThumbnail(voxelFile.fullPath, image);
+	}
 	const core::String &targetImageFile = voxelFile.targetFile() + ".png";
 	core::ScopedPtr<io::SeekableWriteStream> writeStream(_archive->writeStream(targetImageFile));
 	if (!writeStream || !image::writePNG(image, *writeStream)) {
@@ -259,6 +344,12 @@ void CollectionManager::update(double nowSeconds, int n) {
 		collection.sorted = true;
 	}
 	_count += voxelFiles.size();
+
+	// persist the progress of the metadata extraction from time to time
+	if (_assetIndexSaveSeconds + 60.0 < nowSeconds) {
+		_assetIndexSaveSeconds = nowSeconds;
+		saveAssetIndex();
+	}
 }
 
 bool CollectionManager::download(const io::ArchivePtr &archive, VoxelFile &voxelFile) {
@@ -12,6 +12,7 @@
 #include "io/Filesystem.h"
 #include "video/Texture.h"
 #include "video/TexturePool.h"
+#include "voxelcollection/AssetIndex.h"
 #include "voxelcollection/Downloader.h"
 
 namespace voxelcollection {
@@ -30,6 +31,8 @@ private:
 	VoxelSourceQueuePtr _voxelSourceQueue;
 	video::TexturePoolPtr _texturePool;
 	io::FilesystemPtr _filesystem;
+	AssetIndexPtr _assetIndex;
+	double _assetIndexSaveSeconds = 0.0;
 
 	int _count = 0;
 
@@ -38,6 +41,8 @@ private:
 	core::StringSet _onlineResolvedSources;
 	VoxelSources _sources;
 	static bool download(const io::ArchivePtr &archive, VoxelFile &voxelFile);
+	bool loadAssetIndex();
+	bool saveAssetIndex();
 
 public:
 	CollectionManager(const io::FilesystemPtr &filesystem, const video::TexturePoolPtr &texturePool);
@@ -69,6 +74,10 @@ public:
 
 	const VoxelFileMap &voxelFilesMap() const;
 	const VoxelSources &sources() const;
+	/**
+	 * @brief The persistent index of the local files - use it to query the precomputed metadata
+	 */
+	const AssetIndexPtr &assetIndex() const;
 	int allEntries() const;
 
 	core::String absolutePath(const VoxelFile &voxelFile) const;
@@ -82,6 +91,10 @@ inline const VoxelSources &CollectionManager::sources() const {
 	return _sources;
 }
 
+inline const AssetIndexPtr &CollectionManager::assetIndex() const {
+	return _assetIndex;
+}
+
 typedef core::SharedPtr<CollectionManager> CollectionManagerPtr;
 
 }; // namespace voxelcollection
@@ -0,0 +1,200 @@
+/**
+ * @file
+ */
+
+#include "voxelcollection/AssetIndex.h"
+#include "app/tests/AbstractTest.h"
+#include "core/StringUtil.h"
+#include "io/BufferedReadWriteStream.h"
+#include "io/FilesystemArchive.h"
+#include "voxelformat/FormatConfig.h"
+
+namespace voxelcollection {
+
+class AssetIndexTest : public app::AbstractTest {
+protected:
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		voxelformat::FormatConfig::init();
+	}
+
+	static io::FilesystemEntry fsEntry(const core::String &path, uint64_t mtime = 1000u, uint64_t size = 100u) {
+		io::FilesystemEntry entry;
+		entry.name = core::string::extractFilenameWithExtension(path);
+		entry.fullPath = path;
+		entry.type = io::FilesystemEntry::Type::file;
+		entry.mtime = mtime;
+		entry.size = size;
+		return entry;
+	}
+
+	static void addScanned(AssetIndex &index, const core::String &path, const core::String &format, uint64_t voxels,
+						   uint32_t nodes, int dimension) {
+		ASSERT_TRUE(index.update(fsEntry(path)));
+		AssetEntry entry;
+		ASSERT_TRUE(index.get(path, entry));
+		entry.format = format;
+		entry.voxels = voxels;
+		entry.nodes = nodes;
+		entry.dimensions = glm::ivec3(dimension);
+		entry.paletteHash = 42u;
+		ASSERT_TRUE(index.setMetadata(entry, image::ImagePtr()));
+	}
+
+	static image::ImagePtr createImage(int w, int h) {
+		image::ImagePtr image = image::createEmptyImage("thumbnail");
+		image->load(w, h, [](int x, int y, color::RGBA &rgba) { rgba = color::RGBA(x & 0xFF, y & 0xFF, 0, 255); });
+		return image;
+	}
+};
+
+TEST_F(AssetIndexTest, testUpdate) {
+	AssetIndex index;
+	index.beginScan();
+	EXPECT_TRUE(index.update(fsEntry("/assets/a.vox"))) << "New files must be scanned";
+	EXPECT_TRUE(index.update(fsEntry("/assets/a.vox"))) << "The metadata wasn't extracted yet";
+	AssetEntry entry;
+	ASSERT_TRUE(index.get("/assets/a.vox", entry));
+	EXPECT_FALSE(entry.scanned);
+	entry.voxels = 10u;
+	ASSERT_TRUE(index.setMetadata(entry, image::ImagePtr()));
+	EXPECT_FALSE(index.update(fsEntry("/assets/a.vox"))) << "Unchanged files must not get scanned again";
+	EXPECT_TRUE(index.update(fsEntry("/assets/a.vox", 2000u))) << "Modified files must get scanned again";
+	ASSERT_TRUE(index.get("/assets/a.vox", entry));
+	EXPECT_FALSE(entry.scanned);
+	EXPECT_EQ(0u, entry.voxels);
+
+	// metadata for an outdated state of the file is ignored
+	AssetEntry outdated = entry;
+	outdated.mtime = 1000u;
+	EXPECT_FALSE(index.setMetadata(outdated, image::ImagePtr()));
+}
+
+TEST_F(AssetIndexTest, testEndScan) {
+	AssetIndex index;
+	index.beginScan();
+	index.update(fsEntry("/assets/a.vox"));
+	index.update(fsEntry("/assets/b.vox"));
+	index.update(fsEntry("/other/c.vox"));
+	EXPECT_EQ(0, index.endScan("/assets/"));
+
+	index.beginScan();
+	index.update(fsEntry("/assets/b.vox"));
+	EXPECT_EQ(1, index.endScan("/assets/"));
+	AssetEntry entry;
+	EXPECT_FALSE(index.get("/assets/a.vox", entry));
+	EXPECT_TRUE(index.get("/assets/b.vox", entry));
+	EXPECT_TRUE(index.get("/other/c.vox", entry)) << "Files outside of the scanned directory must be kept";
+	EXPECT_EQ(2u, index.size());
+}
+
+TEST_F(AssetIndexTest, testEndScanSiblingDirectory) {
+	AssetIndex index;
+	index.beginScan();
+	index.update(fsEntry("/assets/a.vox"));
+	index.update(fsEntry("/assetsbackup/b.vox"));
+	EXPECT_EQ(0, index.endScan("/assets"));
+
+	index.beginScan();
+	EXPECT_EQ(1, index.endScan("/assets"));
+	AssetEntry entry;
+	EXPECT_FALSE(index.get("/assets/a.vox", entry));
+	EXPECT_TRUE(index.get("/assetsbackup/b.vox", entry)) << "Directories with the same prefix must be kept";
+}
+
+TEST_F(AssetIndexTest, testQuery) {
+	AssetIndex index;
+	index.beginScan();
+	addScanned(index, "/assets/Castle.vox", "MagicaVoxel", 1000u, 1u, 32);
+	addScanned(index, "/assets/castle-big.vengi", "Vengi", 100000u, 10u, 256);
+	addScanned(index, "/assets/tree.vox", "MagicaVoxel", 50u, 1u, 8);
+
+	AssetQuery query;
+	EXPECT_EQ(3u, index.query(query).size());
+
+	query.name = "CASTLE";
+	EXPECT_EQ(2u, index.query(query).size());
+
+	query.format = "MagicaVoxel";
+	core::DynamicArray<AssetEntry> result = index.query(query);
+	ASSERT_EQ(1u, result.size());
+	EXPECT_EQ("/assets/Castle.vox", result[0].path);
+
+	query = AssetQuery();
+	query.minVoxels = 100u;
+	query.maxDimension = 64;
+	result = index.query(query);
+	ASSERT_EQ(1u, result.size());
+	EXPECT_EQ("/assets/Castle.vox", result[0].path);
+
+	query = AssetQuery();
+	query.minNodes = 2u;
+	EXPECT_EQ(1u, index.query(query).size());
+
+	query = AssetQuery();
+	query.paletteHash = 1u;
+	EXPECT_EQ(0u, index.query(query).size());
+
+	query = AssetQuery();
+	query.onlyThumbnails = true;
+	EXPECT_EQ(0u, index.query(query).size());
+	ASSERT_TRUE(index.setThumbnail("/assets/tree.vox", createImage(16, 16)));
+	EXPECT_EQ(1u, index.query(query).size());
+}
+
+TEST_F(AssetIndexTest, testSaveLoad) {
+	AssetIndex index;
+	index.beginScan();
+	addScanned(index, "/assets/a.vox", "MagicaVoxel", 1000u, 3u, 32);
+	index.update(fsEntry("/assets/b.vox"));
+	ASSERT_TRUE(index.setThumbnail("/assets/a.vox", createImage(512, 256)));
+	EXPECT_TRUE(index.dirty());
+
+	io::BufferedReadWriteStream stream;
+	ASSERT_TRUE(index.save(stream));
+	EXPECT_FALSE(index.dirty());
+	stream.seek(0);
+
+	AssetIndex loaded;
+	ASSERT_TRUE(loaded.load(stream));
+	ASSERT_EQ(2u, loaded.size());
+	AssetEntry entry;
+	ASSERT_TRUE(loaded.get("/assets/a.vox", entry));
+	EXPECT_TRUE(entry.scanned);
+	EXPECT_TRUE(entry.hasThumbnail);
+	EXPECT_EQ("MagicaVoxel", entry.format);
+	EXPECT_EQ(1000u, entry.voxels);
+	EXPECT_EQ(3u, entry.nodes);
+	EXPECT_EQ(42u, entry.paletteHash);
+	EXPECT_EQ(glm::ivec3(32), entry.dimensions);
+
+	const image::ImagePtr &thumbnail = loaded.thumbnail("/assets/a.vox", "a");
+	ASSERT_TRUE(thumbnail);
+	EXPECT_EQ(AssetIndex::ThumbnailSize, thumbnail->width()) << "Thumbnails must get scaled down";
+	EXPECT_EQ(AssetIndex::ThumbnailSize / 2, thumbnail->height());
+
+	ASSERT_TRUE(loaded.get("/assets/b.vox", entry));
+	EXPECT_FALSE(entry.scanned);
+	EXPECT_FALSE(entry.hasThumbnail);
+	EXPECT_FALSE(loaded.thumbnail("/assets/b.vox", "b"));
+
+	loaded.beginScan();
+	EXPECT_FALSE(loaded.update(fsEntry("/assets/a.vox")));
+	EXPECT_TRUE(loaded.update(fsEntry("/assets/b.vox")));
+}
+
+TEST_F(AssetIndexTest, testExtractMetadata) {
+	const io::ArchivePtr &archive = io::openFilesystemArchive(_testApp->filesystem());
+	AssetEntry entry;
+	entry.path = "ambient-occlusion.vengi";
+	image::ImagePtr thumbnail;
+	ASSERT_TRUE(extractAssetMetadata(archive, entry, thumbnail));
+	EXPECT_TRUE(entry.scanned);
+	EXPECT_EQ("Vengi", entry.format);
+	EXPECT_GT(entry.nodes, 0u);
+	EXPECT_GT(entry.voxels, 0u);
+	EXPECT_NE(0u, entry.paletteHash);
+	EXPECT_GT(entry.dimensions.x, 0);
+}
+
+} // namespace voxelcollection
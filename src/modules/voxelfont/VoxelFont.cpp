@@ -7,7 +7,6 @@
 #include "core/Common.h"
 #include "core/Log.h"
 #include "core/StandardLib.h"
-#include "core/Unicode.h"
 #include "io/Filesystem.h"
 #include "voxel/RawVolumeWrapper.h"
 
@@ -70,60 +69,89 @@ void VoxelFont::shutdown() {
 	_ttfBuffer = nullptr;
 
 	_filename = "";
+	_glyphs.clear();
 }
 
-void VoxelFont::dimensions(const char *string, uint8_t size, int &w, int &h) const {
-	const char **s = &string;
+void VoxelFont::rasterize(int codepoint, uint8_t size, VoxelFontGlyph &glyph) const {
 	const float scale = stbtt_ScaleForPixelHeight(_font, (float)size);
 	int ix0, iy0, ix1, iy1;
+	stbtt_GetCodepointBitmapBox(_font, codepoint, scale, scale, &ix0, &iy0, &ix1, &iy1);
+	glyph.boxWidth = ix1 - ix0;
+	glyph.boxHeight = iy1 - iy0;
+
+	int w;
+	int h;
+	unsigned char *bitmap = stbtt_GetCodepointBitmap(_font, 0.0f, scale, codepoint, &w, &h, nullptr, nullptr);
+	if (bitmap == nullptr) {
+		Log::warn("Could not create voxelfont mesh for character: %i", codepoint);
+		return;
+	}
+	glyph.width = w;
+	glyph.valid = true;
+	for (int y = 0; y < h; ++y) {
+		const unsigned char *row = bitmap + y * w;
+		for (int x = 0; x < w;) {
+			// antialiasing
+			if (row[x] < 25) {
+				++x;
+				continue;
+			}
+			VoxelFontSpan span;
+			span.x = (int16_t)x;
+			span.y = (int16_t)(h - 1 - y);
+			while (x < w && row[x] >= 25) {
+				++x;
+			}
+			span.length = (int16_t)(x - span.x);
+			glyph.spans.push_back(span);
+		}
+	}
+	stbtt_FreeBitmap(bitmap, nullptr);
+}
+
+const VoxelFontGlyph *VoxelFont::glyph(int codepoint, uint8_t size) const {
+	const uint32_t key = ((uint32_t)codepoint << 8) | size;
+	auto iter = _glyphs.find(key);
+	if (iter != _glyphs.end()) {
+		return &iter->value;
+	}
+	VoxelFontGlyph glyph;
+	rasterize(codepoint, size, glyph);
+	_glyphs.emplace(key, core::move(glyph));
+	return &_glyphs.find(key)->value;
+}
+
+void VoxelFont::dimensions(const char *string, uint8_t size, int &w, int &h) const {
+	const char **s = &string;
 	w = 0;
 	h = 0;
 	for (int c = core::unicode::next(s); c != -1; c = core::unicode::next(s)) {
-		stbtt_GetCodepointBitmapBox(_font, c, scale, scale, &ix0, &iy0, &ix1, &iy1);
-		w += (ix1 - ix0);
-		h = core_max(h, iy1 - iy0);
+		const VoxelFontGlyph *g = glyph(c, size);
+		w += g->boxWidth;
+		h = core_max(h, g->boxHeight);
 	}
 }
 
 int VoxelFont::renderCharacter(int codepoint, uint8_t size, int thickness, const glm::ivec3 &pos,
 							   voxel::RawVolumeWrapper &volume, const voxel::Voxel &voxel, math::Axis axis) {
-	const float scale = stbtt_ScaleForPixelHeight(_font, (float)size);
-	int w;
-	int h;
-	unsigned char *bitmap = stbtt_GetCodepointBitmap(_font, 0.0f, scale, codepoint, &w, &h, nullptr, nullptr);
-	thickness = core_max(1, thickness);
-
-	if (bitmap == nullptr) {
-		Log::warn("Could not create voxelfont mesh for character: %i", codepoint);
+	const VoxelFontGlyph *g = glyph(codepoint, size);
+	if (!g->valid) {
 		return 0;
 	}
-
-	int ix0, iy0, ix1, iy1;
-	stbtt_GetCodepointBitmapBox(_font, codepoint, 0.0f, scale, &ix0, &iy0, &ix1, &iy1);
-
+	thickness = core_max(1, thickness);
 	const int widthIndex = math::getIndexForAxis(axis);
-	glm::ivec3 dim;
-	dim[(widthIndex + 0) % 3] = w;
-	dim[(widthIndex + 1) % 3] = h;
-	dim[(widthIndex + 2) % 3] = thickness;
-
-	for (int y = 0; y < h; ++y) {
-		for (int x = 0; x < w; ++x) {
-			// antialiasing
-			if (bitmap[y * w + x] >= 25) {
-				glm::ivec3 v;
-				v[(widthIndex + 0) % 3] = x + ix0;
-				v[(widthIndex + 1) % 3] = dim[(widthIndex + 1) % 3] - 1 - y;
-				v[(widthIndex + 2) % 3] = 0;
-				for (int z = 0; z < thickness; ++z) {
-					v[(widthIndex + 2) % 3] = z;
-					volume.setVoxel(pos + v, voxel);
-				}
+	for (const VoxelFontSpan &span : g->spans) {
+		glm::ivec3 v;
+		v[(widthIndex + 1) % 3] = span.y;
+		for (int x = span.x; x < span.x + span.length; ++x) {
+			v[(widthIndex + 0) % 3] = x;
+			for (int z = 0; z < thickness; ++z) {
+				v[(widthIndex + 2) % 3] = z;
+				volume.setVoxel(pos + v, voxel);
 			}
 		}
 	}
-	stbtt_FreeBitmap(bitmap, nullptr);
-	return w;
+	return g->width;
 }
 
 } // namespace voxelfont
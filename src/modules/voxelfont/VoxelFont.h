@@ -4,28 +4,67 @@
 
 #pragma once
 
+#include "core/Common.h"
 #include "core/String.h"
+#include "core/Unicode.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/HashMap.h"
 #include "math/Axis.h"
-#include <glm/fwd.hpp>
+#include "voxel/Voxel.h"
+#include <glm/vec3.hpp>
 #include <stdint.h>
 
 struct stbtt_fontinfo;
 
 namespace voxel {
 class RawVolumeWrapper;
-class Voxel;
 } // namespace voxel
 
 namespace voxelfont {
 
+/**
+ * @brief A horizontal run of set pixels in a glyph bitmap
+ */
+struct VoxelFontSpan {
+	/** offset along the width axis */
+	int16_t x;
+	/** offset along the height axis - counted from the bottom of the glyph bitmap */
+	int16_t y;
+	int16_t length;
+};
+
+/**
+ * @brief The rasterized glyph of a codepoint for one font size - the thickness is applied while the spans are
+ * stamped into the volume
+ */
+struct VoxelFontGlyph {
+	core::DynamicArray<VoxelFontSpan> spans;
+	/** the width of the glyph bitmap - this is the amount of voxels the cursor is advanced */
+	int width = 0;
+	/** the width of the glyph bounding box */
+	int boxWidth = 0;
+	/** the height of the glyph bounding box */
+	int boxHeight = 0;
+	/** @c false if the glyph could not get rasterized */
+	bool valid = false;
+};
+
 /**
  * @brief Will take any TTF font and rasterizes into voxels
+ *
+ * The glyphs are only rasterized once per codepoint and font size - they are cached as spans of voxels until the
+ * font is shut down.
+ *
+ * @note Not thread safe - the glyph cache is filled on demand
  */
 class VoxelFont {
 private:
 	stbtt_fontinfo *_font = nullptr;
 	uint8_t *_ttfBuffer = nullptr;
 	core::String _filename;
+	mutable core::HashMap<uint32_t, VoxelFontGlyph> _glyphs;
+
+	void rasterize(int codepoint, uint8_t size, VoxelFontGlyph &glyph) const;
 
 public:
 	~VoxelFont();
@@ -33,9 +72,55 @@ public:
 	bool init(const core::String &font);
 	void shutdown();
 
+	/**
+	 * @return The cached glyph for the given codepoint and size
+	 * @note The returned pointer is only valid until the next glyph is added to the cache
+	 */
+	const VoxelFontGlyph *glyph(int codepoint, uint8_t size) const;
+
 	void dimensions(const char *string, uint8_t size, int &w, int &h) const;
 	int renderCharacter(int codepoint, uint8_t size, int thickness, const glm::ivec3 &pos,
 						voxel::RawVolumeWrapper &volume, const voxel::Voxel &voxel, math::Axis axis = math::Axis::X);
+
+	/**
+	 * @brief Lays out the whole utf8 string and writes the glyph spans with the sampler of the given volume
+	 * @param[in] spacing The amount of voxels between two characters
+	 * @return The width of the rendered text (including the spacing after the last character)
+	 */
+	template<class Volume>
+	int renderString(const char *string, uint8_t size, int thickness, int spacing, const glm::ivec3 &pos,
+					 Volume &volume, const voxel::Voxel &voxel, math::Axis axis = math::Axis::X);
 };
 
+template<class Volume>
+int VoxelFont::renderString(const char *string, uint8_t size, int thickness, int spacing, const glm::ivec3 &pos,
+							Volume &volume, const voxel::Voxel &voxel, math::Axis axis) {
+	const int widthIndex = math::getIndexForAxis(axis);
+	const int heightIndex = (widthIndex + 1) % 3;
+	const int depthIndex = (widthIndex + 2) % 3;
+	thickness = core_max(1, thickness);
+
+	typename Volume::Sampler sampler(volume);
+	glm::ivec3 cursor = pos;
+	const char **s = &string;
+	for (int c = core::unicode::next(s); c != -1; c = core::unicode::next(s)) {
+		const VoxelFontGlyph *g = glyph(c, size);
+		for (const VoxelFontSpan &span : g->spans) {
+			glm::ivec3 start = cursor;
+			start[widthIndex] += span.x;
+			start[heightIndex] += span.y;
+			for (int z = 0; z < thickness; ++z) {
+				start[depthIndex] = cursor[depthIndex] + z;
+				sampler.setPosition(start);
+				for (int i = 0; i < span.length; ++i) {
+					sampler.setVoxel(voxel);
+					sampler.movePositive(axis);
+				}
+			}
+		}
+		cursor[widthIndex] += g->width + spacing;
+	}
+	return cursor[widthIndex] - pos[widthIndex];
+}
+
 } // namespace voxelfont
@@ -0,0 +1,90 @@
+/**
+ * @file
+ */
+
+#include "voxelfont/VoxelFont.h"
+#include "app/tests/AbstractTest.h"
+#include "voxel/RawVolume.h"
+#include "voxel/RawVolumeWrapper.h"
+
+namespace voxelfont {
+
+class VoxelFontTest : public app::AbstractTest {
+protected:
+	VoxelFont _font;
+
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		ASSERT_TRUE(_font.init("font.ttf"));
+	}
+
+	void TearDown() override {
+		_font.shutdown();
+		app::AbstractTest::TearDown();
+	}
+};
+
+TEST_F(VoxelFontTest, testGlyphCache) {
+	const VoxelFontGlyph *glyph = _font.glyph('A', 16);
+	ASSERT_NE(nullptr, glyph);
+	EXPECT_TRUE(glyph->valid);
+	EXPECT_FALSE(glyph->spans.empty());
+	EXPECT_GT(glyph->width, 0);
+	EXPECT_EQ(glyph, _font.glyph('A', 16)) << "The glyph should be cached";
+	EXPECT_NE(glyph, _font.glyph('A', 32)) << "Each size needs its own glyph";
+}
+
+TEST_F(VoxelFontTest, testDimensions) {
+	int w = 0;
+	int h = 0;
+	_font.dimensions("AB", 16, w, h);
+	const VoxelFontGlyph *a = _font.glyph('A', 16);
+	const int widthA = a->boxWidth;
+	const int heightA = a->boxHeight;
+	const VoxelFontGlyph *b = _font.glyph('B', 16);
+	EXPECT_EQ(widthA + b->boxWidth, w);
+	EXPECT_EQ(core_max(heightA, b->boxHeight), h);
+}
+
+TEST_F(VoxelFontTest, testRenderString) {
+	const voxel::Region region(0, 0, 0, 63, 31, 3);
+	const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 1);
+	const char *text = "Vengi";
+	const int spacing = 1;
+	const int thickness = 2;
+
+	voxel::RawVolume expected(region);
+	{
+		voxel::RawVolumeWrapper wrapper(&expected);
+		const char *t = text;
+		const char **s = &t;
+		glm::ivec3 pos(1, 1, 1);
+		for (int c = core::unicode::next(s); c != -1; c = core::unicode::next(s)) {
+			pos.x += _font.renderCharacter(c, 16, thickness, pos, wrapper, voxel);
+			pos.x += spacing;
+		}
+	}
+
+	voxel::RawVolume volume(region);
+	voxel::RawVolumeWrapper wrapper(&volume);
+	const int width = _font.renderString(text, 16, thickness, spacing, glm::ivec3(1, 1, 1), wrapper, voxel);
+	EXPECT_GT(width, 0);
+	EXPECT_TRUE(wrapper.dirtyRegion().isValid());
+
+	int voxels = 0;
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				ASSERT_EQ(expected.voxel(x, y, z), volume.voxel(x, y, z)) << x << ":" << y << ":" << z;
+				if (voxel::isBlocked(volume.voxel(x, y, z).getMaterial())) {
+					++voxels;
+				}
+			}
+		}
+	}
+	EXPECT_GT(voxels, 0);
+	EXPECT_FALSE(voxel::isBlocked(volume.voxel(0, 0, 0).getMaterial()));
+	EXPECT_FALSE(voxel::isBlocked(volume.voxel(1, 1, 3).getMaterial())) << "Exceeded the thickness";
+}
+
+} // namespace voxelfont
@@ -7,11 +7,9 @@
 #include "app/App.h"
 #include "color/Color.h"
 #include "core/Common.h"
-#include "core/ConfigVar.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
 #include "image/Image.h"
 #include "io/Archive.h"
 #include "math/Math.h"
@@ -141,11 +139,12 @@ glm::ivec3 Format::maxSize() const {
 }
 
 bool Format::singleVolume() const {
-	return core::Var::getSafe(cfg::VoxformatMerge)->boolVal();
+	return _config.merge;
 }
 
 bool Format::save(const scenegraph::SceneGraph &sceneGraph, const core::String &filename, const io::ArchivePtr &archive,
 				  const SaveContext &ctx) {
+	configure(ctx.config);
 	bool needsSplit = false;
 	const glm::ivec3 maxsize = maxSize();
 	if (maxsize.x > 0 && maxsize.y > 0 && maxsize.z > 0) {
@@ -168,7 +167,7 @@ bool Format::save(const scenegraph::SceneGraph &sceneGraph, const core::String &
 		return false;
 	}
 
-	const bool saveVisibleOnly = core::Var::getSafe(cfg::VoxformatSaveVisibleOnly)->boolVal();
+	const bool saveVisibleOnly = ctx.config.saveVisibleOnly;
 	if (singleVolume() && sceneGraph.size(scenegraph::SceneGraphNodeType::AllModels) > 1) {
 		Log::debug("Merge volumes before saving as the target format only supports one volume");
 		scenegraph::SceneGraph::MergeResult merged = sceneGraph.merge(saveVisibleOnly);
@@ -208,6 +207,7 @@ bool Format::save(const scenegraph::SceneGraph &sceneGraph, const core::String &
 
 bool Format::load(const core::String &filename, const io::ArchivePtr &archive, scenegraph::SceneGraph &sceneGraph,
 				  const LoadContext &ctx) {
+	configure(ctx.config);
 	if (!loadGroups(filename, archive, sceneGraph, ctx)) {
 		return false;
 	}
@@ -233,7 +233,7 @@ bool PaletteFormat::loadGroups(const core::String &filename, const io::ArchivePt
 		return false;
 	}
 
-	const bool createPalette = core::Var::getSafe(cfg::VoxelCreatePalette)->boolVal();
+	const bool createPalette = ctx.config.createPalette;
 	if (!createPalette) {
 		const palette::Palette &defaultPalette = voxel::getPalette();
 		Log::info("Remap the palette to %s", defaultPalette.name().c_str());
@@ -252,7 +252,7 @@ bool PaletteFormat::loadGroups(const core::String &filename, const io::ArchivePt
 int PaletteFormat::emptyPaletteIndex() const {
 	// this is only taken into account if the format doesn't force a
 	// particular empty index by overriding this method.
-	return core::Var::getSafe(cfg::VoxformatEmptyPaletteIndex)->intVal();
+	return _config.emptyPaletteIndex;
 }
 
 static void mergePalettesAndRemap(const scenegraph::SceneGraph &sceneGraph, scenegraph::SceneGraph &newSceneGraph,
@@ -316,6 +316,7 @@ static void palettesRemap(const scenegraph::SceneGraph &sceneGraph, scenegraph::
 
 bool PaletteFormat::save(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
 						 const io::ArchivePtr &archive, const SaveContext &ctx) {
+	configure(ctx.config);
 	int emptyIndex = this->emptyPaletteIndex();
 	if (onlyOnePalette() && sceneGraph.hasMoreThanOnePalette()) {
 		scenegraph::SceneGraph newSceneGraph;
@@ -329,16 +330,12 @@ bool PaletteFormat::save(const scenegraph::SceneGraph &sceneGraph, const core::S
 	return Super::save(sceneGraph, filename, archive, ctx);
 }
 
-Format::Format() {
-	_flattenFactor = core::Var::getSafe(cfg::VoxformatRGBFlattenFactor)->intVal();
-}
-
 color::RGBA Format::flattenRGB(color::RGBA rgba) const {
-	return color::flattenRGB(rgba.r, rgba.g, rgba.b, rgba.a, _flattenFactor);
+	return color::flattenRGB(rgba.r, rgba.g, rgba.b, rgba.a, _config.rgbFlattenFactor);
 }
 
 color::RGBA Format::flattenRGB(uint8_t r, uint8_t g, uint8_t b, uint8_t a) const {
-	return color::flattenRGB(r, g, b, a, _flattenFactor);
+	return color::flattenRGB(r, g, b, a, _config.rgbFlattenFactor);
 }
 
 int Format::createPalette(const palette::RGBABuffer &colors, palette::Palette &palette) const {
@@ -384,7 +381,7 @@ int Format::createPalette(const palette::RGBAMaterialMap &colors, palette::Palet
 bool RGBAFormat::loadGroups(const core::String &filename, const io::ArchivePtr &archive,
 							scenegraph::SceneGraph &sceneGraph, const LoadContext &ctx) {
 	palette::Palette palette;
-	const bool createPalette = core::Var::getSafe(cfg::VoxelCreatePalette)->boolVal();
+	const bool createPalette = ctx.config.createPalette;
 	if (createPalette) {
 		if (loadPalette(filename, archive, palette, ctx) <= 0) {
 			palette = voxel::getPalette();
@@ -402,11 +399,12 @@ bool RGBAFormat::loadGroups(const core::String &filename, const io::ArchivePtr &
 int RGBASinglePaletteFormat::emptyPaletteIndex() const {
 	// this is only taken into account if the format doesn't force a
 	// particular empty index by overriding this method.
-	return core::Var::getSafe(cfg::VoxformatEmptyPaletteIndex)->intVal();
+	return _config.emptyPaletteIndex;
 }
 
 bool RGBASinglePaletteFormat::save(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
 								   const io::ArchivePtr &archive, const SaveContext &ctx) {
+	configure(ctx.config);
 	int emptyIndex = this->emptyPaletteIndex();
 	if (sceneGraph.hasMoreThanOnePalette()) {
 		scenegraph::SceneGraph newSceneGraph;
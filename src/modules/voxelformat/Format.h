@@ -15,6 +15,7 @@
 #include "io/Stream.h"
 #include "palette/Palette.h"
 #include "voxel/RawVolume.h"
+#include "voxelformat/FormatConfig.h"
 #include "voxelformat/FormatThumbnail.h"
 #include <glm/fwd.hpp>
 
@@ -36,6 +37,14 @@ namespace voxelformat {
 typedef void (*ProgressMonitor)(const char *name, int cur, int max);
 
 struct LoadContext {
+	LoadContext() : config(FormatConfig::fromVars()) {
+	}
+	explicit LoadContext(const FormatConfig &_config) : config(_config) {
+	}
+	/**
+	 * The settings for this load call - by default a snapshot of the cvars at the time the context was created
+	 */
+	FormatConfig config;
 	ProgressMonitor monitor = nullptr;
 	inline void progress(const char *name, int cur, int max) const {
 		if (monitor == nullptr) {
@@ -46,6 +55,14 @@ struct LoadContext {
 };
 
 struct SaveContext {
+	SaveContext() : config(FormatConfig::fromVars()) {
+	}
+	explicit SaveContext(const FormatConfig &_config) : config(_config) {
+	}
+	/**
+	 * The settings for this save call - by default a snapshot of the cvars at the time the context was created
+	 */
+	FormatConfig config;
 	/**
 	 * @brief A basic image rendering helper.
 	 */
@@ -75,7 +92,12 @@ static constexpr int MaxRegionSize = 256;
  */
 class Format {
 protected:
-	uint8_t _flattenFactor;
+	/**
+	 * The settings of the current load or save call. The formats are instantiated for each call - so this is not
+	 * shared between conversions.
+	 * @sa configure()
+	 */
+	FormatConfig _config;
 	/**
 	 * @brief If you have to split the volumes in the scene graph because the format only supports a certain size, you
 	 * can return the max size here. If the returned value is not a valid volume size (<= 0) the value is ignored.
@@ -150,9 +172,22 @@ protected:
 							scenegraph::SceneGraph &sceneGraph, const LoadContext &ctx) = 0;
 
 public:
-	Format();
+	Format() = default;
 	virtual ~Format() = default;
 
+	/**
+	 * @brief Apply the settings for the helper functions that don't get the load or save context
+	 * @note This is done by @c load() and @c save() - but must be called manually before calling e.g.
+	 * @c loadPalette() if you don't want to use the default settings
+	 */
+	void configure(const FormatConfig &config) {
+		_config = config;
+	}
+
+	const FormatConfig &config() const {
+		return _config;
+	}
+
 	/**
 	 * @brief If a format only supports a single volume. If this returns true, the @¢ save() method gets a scene graph
 	 * with only one model
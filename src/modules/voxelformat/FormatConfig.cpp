@@ -5,7 +5,9 @@
 #include "FormatConfig.h"
 #include "app/I18N.h"
 #include "core/ConfigVar.h"
+#include "core/Hash.h"
 #include "core/StringUtil.h"
+#include "core/Trace.h"
 #include "core/Var.h"
 #include "math/Axis.h"
 #include "palette/FormatConfig.h"
@@ -25,6 +27,8 @@ static bool schematicTypeValidator(const core::String &value) {
 	return false;
 }
 
+static_assert((int)voxel::SurfaceExtractionType::Binary == 2, "FormatConfig::meshMode default must match");
+
 bool FormatConfig::init() {
 	palette::FormatConfig::init();
 
@@ -80,6 +84,11 @@ bool FormatConfig::init() {
 				   _("Use palette mode in qubicle qbt export"), core::Var::boolValidator);
 	core::Var::get(cfg::VoxformatQBTMergeCompounds, "false", core::CV_NOPERSIST, _("Merge compounds on load"),
 				   core::Var::boolValidator);
+	core::Var::get(cfg::VoxformatVENGIIndexed, "false", core::CV_NOPERSIST,
+				   _("Compress the voxels of the vengi nodes independently - older versions can't load these files"),
+				   core::Var::boolValidator);
+	core::Var::get(cfg::VoxformatPLYBinary, "true", core::CV_NOPERSIST, _("Save ply files in the binary format"),
+				   core::Var::boolValidator);
 	core::Var::get(cfg::VoxformatMerge, "false", core::CV_NOPERSIST, _("Merge all objects into one"),
 				   core::Var::boolValidator);
 	core::Var::get(cfg::VoxformatEmptyPaletteIndex, "-1", core::CV_NOPERSIST,
@@ -103,11 +112,20 @@ bool FormatConfig::init() {
 		core::Var::boolValidator);
 	core::Var::get(cfg::VoxformatPointCloudSize, "1", core::CV_NOPERSIST,
 				   _("Specify the side length for the voxels when loading a point cloud"));
+	core::Var::get(cfg::VoxformatPointCloudMemory, "512", core::CV_NOPERSIST,
+				   _("Memory budget in MiB for the color accumulation when loading a point cloud"),
+				   core::Var::minMaxValidator<1, 65536>);
 	core::Var::get(cfg::VoxformatGLTF_KHR_materials_pbrSpecularGlossiness, "true", core::CV_NOPERSIST,
 				   _("Apply KHR_materials_pbrSpecularGlossiness when saving into the gltf format"),
 				   core::Var::boolValidator);
 	core::Var::get(cfg::VoxformatGLTF_KHR_materials_specular, "false", core::CV_NOPERSIST,
 				   _("Apply KHR_materials_specular when saving into the gltf format"), core::Var::boolValidator);
+	core::Var::get(cfg::VoxformatGLTF_KHR_mesh_quantization, "false", core::CV_NOPERSIST,
+				   _("Store the vertex positions as integers (KHR_mesh_quantization) when saving into the gltf format"),
+				   core::Var::boolValidator);
+	core::Var::get(cfg::VoxformatGLTF_EXT_mesh_gpu_instancing, "false", core::CV_NOPERSIST,
+				   _("Save nodes that share the same mesh as instances (EXT_mesh_gpu_instancing) into the gltf format"),
+				   core::Var::boolValidator);
 	core::Var::get(cfg::VoxformatWithMaterials, "true", core::CV_NOPERSIST,
 				   _("Try to export material properties if the formats support it"), core::Var::boolValidator);
 	core::Var::get(cfg::VoxformatImageVolumeMaxDepth, "1", core::CV_NOPERSIST,
@@ -120,6 +138,8 @@ bool FormatConfig::init() {
 				   _("Import the image as volume for both sides"), core::Var::boolValidator);
 	core::Var::get(cfg::VoxformatTexturePath, "", core::CV_NOPERSIST,
 				   _("Register an additional search path for texture lookups"));
+	core::Var::get(cfg::VoxformatSceneCache, "", core::CV_NOPERSIST,
+				   _("Directory to cache the loaded scenes in - an empty value disables the cache"));
 	core::Var::get(cfg::VoxformatImageImportType, PNGFormat::ImageType::Plane, core::CV_NOPERSIST,
 				   _("0 = plane, 1 = heightmap, 2 = volume"),
 				   core::Var::minMaxValidator<PNGFormat::ImageType::Plane, PNGFormat::ImageType::Volume>);
@@ -153,4 +173,125 @@ bool FormatConfig::init() {
 	return true;
 }
 
+static bool boolVar(const char *name, bool defaultVal) {
+	const core::VarPtr &var = core::Var::get(name);
+	if (!var) {
+		return defaultVal;
+	}
+	return var->boolVal();
+}
+
+static int intVar(const char *name, int defaultVal) {
+	const core::VarPtr &var = core::Var::get(name);
+	if (!var) {
+		return defaultVal;
+	}
+	return var->intVal();
+}
+
+static float floatVar(const char *name, float defaultVal) {
+	const core::VarPtr &var = core::Var::get(name);
+	if (!var) {
+		return defaultVal;
+	}
+	return var->floatVal();
+}
+
+static core::String strVar(const char *name, const core::String &defaultVal) {
+	const core::VarPtr &var = core::Var::get(name);
+	if (!var) {
+		return defaultVal;
+	}
+	return var->strVal();
+}
+
+FormatConfig FormatConfig::fromVars() {
+	core_trace_scoped(FormatConfigFromVars);
+	FormatConfig c;
+	c.mergeQuads = boolVar(cfg::VoxformatMergequads, c.mergeQuads);
+	c.meshMode = intVar(cfg::VoxelMeshMode, c.meshMode);
+	c.reuseVertices = boolVar(cfg::VoxformatReusevertices, c.reuseVertices);
+	c.ambientOcclusion = boolVar(cfg::VoxformatAmbientocclusion, c.ambientOcclusion);
+	c.quads = boolVar(cfg::VoxformatQuads, c.quads);
+	c.withColor = boolVar(cfg::VoxformatWithColor, c.withColor);
+	c.withNormals = boolVar(cfg::VoxformatWithNormals, c.withNormals);
+	c.colorAsFloat = boolVar(cfg::VoxformatColorAsFloat, c.colorAsFloat);
+	c.withTexCoords = boolVar(cfg::VoxformatWithtexcoords, c.withTexCoords);
+	c.transform = boolVar(cfg::VoxformatTransform, c.transform);
+	c.optimize = boolVar(cfg::VoxformatOptimize, c.optimize);
+	c.withMaterials = boolVar(cfg::VoxformatWithMaterials, c.withMaterials);
+	c.plyBinary = boolVar(cfg::VoxformatPLYBinary, c.plyBinary);
+	c.gltfPbrSpecularGlossiness =
+		boolVar(cfg::VoxformatGLTF_KHR_materials_pbrSpecularGlossiness, c.gltfPbrSpecularGlossiness);
+	c.gltfSpecular = boolVar(cfg::VoxformatGLTF_KHR_materials_specular, c.gltfSpecular);
+	c.gltfMeshQuantization = boolVar(cfg::VoxformatGLTF_KHR_mesh_quantization, c.gltfMeshQuantization);
+	c.gltfMeshGpuInstancing = boolVar(cfg::VoxformatGLTF_EXT_mesh_gpu_instancing, c.gltfMeshGpuInstancing);
+
+	c.rgbWeightedAverage = boolVar(cfg::VoxformatRGBWeightedAverage, c.rgbWeightedAverage);
+	c.scale = floatVar(cfg::VoxformatScale, c.scale);
+	c.scaleX = floatVar(cfg::VoxformatScaleX, c.scaleX);
+	c.scaleY = floatVar(cfg::VoxformatScaleY, c.scaleY);
+	c.scaleZ = floatVar(cfg::VoxformatScaleZ, c.scaleZ);
+	c.fillHollow = boolVar(cfg::VoxformatFillHollow, c.fillHollow);
+	c.voxelizeMode = intVar(cfg::VoxformatVoxelizeMode, c.voxelizeMode);
+	c.pointCloudSize = intVar(cfg::VoxformatPointCloudSize, c.pointCloudSize);
+	c.pointCloudMemory = intVar(cfg::VoxformatPointCloudMemory, c.pointCloudMemory);
+	c.meshSimplify = boolVar(cfg::VoxformatMeshSimplify, c.meshSimplify);
+	c.texturePath = strVar(cfg::VoxformatTexturePath, c.texturePath);
+	c.normalPalette = strVar(cfg::NormalPalette, c.normalPalette);
+
+	c.rgbFlattenFactor = (uint8_t)intVar(cfg::VoxformatRGBFlattenFactor, c.rgbFlattenFactor);
+	c.saveVisibleOnly = boolVar(cfg::VoxformatSaveVisibleOnly, c.saveVisibleOnly);
+	c.merge = boolVar(cfg::VoxformatMerge, c.merge);
+	c.emptyPaletteIndex = intVar(cfg::VoxformatEmptyPaletteIndex, c.emptyPaletteIndex);
+	c.createPalette = boolVar(cfg::VoxelCreatePalette, c.createPalette);
+	c.sceneCache = strVar(cfg::VoxformatSceneCache, c.sceneCache);
+
+	c.qbtPaletteMode = boolVar(cfg::VoxformatQBTPaletteMode, c.qbtPaletteMode);
+	c.qbtMergeCompounds = boolVar(cfg::VoxformatQBTMergeCompounds, c.qbtMergeCompounds);
+	c.vengiIndexed = boolVar(cfg::VoxformatVENGIIndexed, c.vengiIndexed);
+	c.vxlLoadHVA = boolVar(cfg::VoxformatVXLLoadHVA, c.vxlLoadHVA);
+	c.voxCreateGroups = boolVar(cfg::VoxformatVOXCreateGroups, c.voxCreateGroups);
+	c.voxCreateLayers = boolVar(cfg::VoxformatVOXCreateLayers, c.voxCreateLayers);
+	c.qbSaveLeftHanded = boolVar(cfg::VoxformatQBSaveLeftHanded, c.qbSaveLeftHanded);
+	c.qbSaveCompressed = boolVar(cfg::VoxformatQBSaveCompressed, c.qbSaveCompressed);
+	c.imageVolumeMaxDepth = intVar(cfg::VoxformatImageVolumeMaxDepth, c.imageVolumeMaxDepth);
+	c.imageHeightmapMinHeight = intVar(cfg::VoxformatImageHeightmapMinHeight, c.imageHeightmapMinHeight);
+	c.imageVolumeBothSides = boolVar(cfg::VoxformatImageVolumeBothSides, c.imageVolumeBothSides);
+	c.imageImportType = intVar(cfg::VoxformatImageImportType, c.imageImportType);
+	c.imageSaveType = intVar(cfg::VoxformatImageSaveType, c.imageSaveType);
+	c.imageSliceOffsetAxis = strVar(cfg::VoxformatImageSliceOffsetAxis, c.imageSliceOffsetAxis);
+	c.imageSliceOffset = intVar(cfg::VoxformatImageSliceOffset, c.imageSliceOffset);
+	c.schematicType = strVar(cfg::VoxformatSchematicType, c.schematicType);
+	c.binvoxVersion = intVar(cfg::VoxformatBinvoxVersion, c.binvoxVersion);
+	c.skinApplyTransform = boolVar(cfg::VoxformatSkinApplyTransform, c.skinApplyTransform);
+	c.skinAddGroups = boolVar(cfg::VoxformatSkinAddGroups, c.skinAddGroups);
+	c.skinMergeFaces = boolVar(cfg::VoxformatSkinMergeFaces, c.skinMergeFaces);
+	return c;
+}
+
+FormatConfig FormatConfig::lossless() {
+	FormatConfig c;
+	c.saveVisibleOnly = false;
+	c.merge = false;
+	c.emptyPaletteIndex = -1;
+	return c;
+}
+
+uint64_t FormatConfig::hash() const {
+	const core::String &str = core::String::format(
+		"%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i|%i|%f|%f|%f|%f|%i|%i|%i|%i|%i|%s|%s|%i|%i|%i|%i|%i|%i%i%i%i%i%i%i%i|%i|%i|%"
+		"i|%i|%i|%s|%i|%s|%i|%i%i%i",
+		mergeQuads, meshMode, reuseVertices, ambientOcclusion, quads, withColor, withNormals, colorAsFloat,
+		withTexCoords, transform, optimize, withMaterials, plyBinary, gltfPbrSpecularGlossiness, gltfSpecular,
+		gltfMeshQuantization, gltfMeshGpuInstancing, rgbWeightedAverage, scale, scaleX, scaleY, scaleZ, fillHollow,
+		voxelizeMode, pointCloudSize, pointCloudMemory, meshSimplify, texturePath.c_str(), normalPalette.c_str(),
+		(int)rgbFlattenFactor, saveVisibleOnly, merge, emptyPaletteIndex, createPalette, qbtPaletteMode,
+		qbtMergeCompounds, vengiIndexed, vxlLoadHVA, voxCreateGroups, voxCreateLayers, qbSaveLeftHanded,
+		qbSaveCompressed, imageVolumeMaxDepth, imageHeightmapMinHeight, imageVolumeBothSides, imageImportType,
+		imageSaveType, imageSliceOffsetAxis.c_str(), imageSliceOffset, schematicType.c_str(), binvoxVersion,
+		skinApplyTransform, skinAddGroups, skinMergeFaces);
+	return core::hash(str.c_str());
+}
+
 } // namespace voxelformat
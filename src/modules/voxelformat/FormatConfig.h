@@ -4,11 +4,114 @@
 
 #pragma once
 
+#include "core/String.h"
+#include <stdint.h>
+
 namespace voxelformat {
 
+/**
+ * @brief The settings for loading and saving voxel formats
+ *
+ * The formats don't query the cvars themselves - they get a snapshot of the values via @c LoadContext::config or
+ * @c SaveContext::config. This allows to run several conversions with different settings at the same time. The
+ * default values match the default values of the cvars that are registered in @c init().
+ *
+ * @sa fromVars()
+ */
 class FormatConfig {
 public:
+	// mesh export
+	bool mergeQuads = true;
+	/** @c voxel::SurfaceExtractionType */
+	int meshMode = 2;
+	bool reuseVertices = true;
+	bool ambientOcclusion = false;
+	bool quads = true;
+	bool withColor = true;
+	bool withNormals = false;
+	bool colorAsFloat = true;
+	bool withTexCoords = true;
+	bool transform = true;
+	bool optimize = false;
+	bool withMaterials = true;
+	bool plyBinary = true;
+	bool gltfPbrSpecularGlossiness = true;
+	bool gltfSpecular = false;
+	bool gltfMeshQuantization = false;
+	bool gltfMeshGpuInstancing = false;
+
+	// voxelization
+	bool rgbWeightedAverage = true;
+	float scale = 1.0f;
+	float scaleX = 1.0f;
+	float scaleY = 1.0f;
+	float scaleZ = 1.0f;
+	bool fillHollow = true;
+	/** @c MeshFormat::VoxelizeMode */
+	int voxelizeMode = 0;
+	int pointCloudSize = 1;
+	/** memory budget in MiB for the color accumulation of point clouds */
+	int pointCloudMemory = 512;
+	bool meshSimplify = false;
+	/** additional search path for texture lookups */
+	core::String texturePath;
+	/** the normal palette that is assigned to voxelized meshes */
+	core::String normalPalette = "built-in:redalert2";
+
+	// general
+	/** [0-255] */
+	uint8_t rgbFlattenFactor = 0;
+	bool saveVisibleOnly = false;
+	bool merge = false;
+	/** [-1-255] - @c -1 means that the format doesn't need an empty palette slot */
+	int emptyPaletteIndex = -1;
+	bool createPalette = true;
+	/** directory of the scene cache - empty if the cache is disabled */
+	core::String sceneCache;
+
+	// format specific
+	bool qbtPaletteMode = true;
+	bool qbtMergeCompounds = false;
+	bool vengiIndexed = false;
+	bool vxlLoadHVA = true;
+	bool voxCreateGroups = true;
+	bool voxCreateLayers = true;
+	bool qbSaveLeftHanded = true;
+	bool qbSaveCompressed = true;
+	int imageVolumeMaxDepth = 1;
+	int imageHeightmapMinHeight = 0;
+	bool imageVolumeBothSides = true;
+	/** @c PNGFormat::ImageType */
+	int imageImportType = 0;
+	/** @c PNGFormat::ImageType */
+	int imageSaveType = 0;
+	core::String imageSliceOffsetAxis = "y";
+	int imageSliceOffset = 0;
+	core::String schematicType = "mcedit2";
+	int binvoxVersion = 2;
+	bool skinApplyTransform = false;
+	bool skinAddGroups = true;
+	bool skinMergeFaces = false;
+
+	/**
+	 * @brief Registers the cvars
+	 */
 	static bool init();
+	/**
+	 * @brief Snapshot of the current cvar values - if a cvar is not registered, the default value is used
+	 */
+	static FormatConfig fromVars();
+	/**
+	 * @brief Settings that store the scene graph as it is - no nodes are merged or skipped and the palette indices
+	 * are not remapped. Use this for data that is loaded again by vengi (caches, autosaves, ...)
+	 */
+	static FormatConfig lossless();
+
+	/**
+	 * @brief Hash over all values that might influence the loading of a file - used for the scene cache key
+	 * @note The scene cache directory is not part of the hash
+	 */
+	uint64_t hash() const;
 };
 
 } // namespace voxelformat
@@ -0,0 +1,114 @@
+/**
+ * @file
+ */
+
+#include "SceneCache.h"
+#include "core/Hash.h"
+#include "core/Log.h"
+#include "core/ScopedPtr.h"
+#include "core/StringUtil.h"
+#include "core/Trace.h"
+#include "core/UUID.h"
+#include "io/FilesystemArchive.h"
+#include "io/FormatDescription.h"
+#include "io/Stream.h"
+#include "palette/Palette.h"
+#include "scenegraph/SceneGraph.h"
+#include "voxel/MaterialColor.h"
+#include "voxelformat/Format.h"
+#include "voxelformat/private/vengi/VENGIFormat.h"
+
+namespace voxelformat {
+
+static core::String sceneCachePath(const FormatConfig &config, const core::String &key) {
+	return core::string::path(config.sceneCache, key + ".vengi");
+}
+
+/**
+ * @brief Hash over the format configuration of the load and the palette that the formats without an own palette are
+ * mapping their colors to
+ */
+static uint64_t sceneCacheConfigHash(const FormatConfig &config) {
+	const core::String &paletteHash = core::String::format("%016" PRIx64, voxel::getPalette().hash());
+	return core::hash(paletteHash.c_str(), config.hash());
+}
+
+bool isSceneCacheEnabled(const FormatConfig &config) {
+	return !config.sceneCache.empty();
+}
+
+core::String sceneCacheKey(const core::String &filename, const io::ArchivePtr &archive,
+						   const io::FormatDescription &desc, const FormatConfig &config) {
+	core_trace_scoped(SceneCacheKey);
+	core::ScopedPtr<io::SeekableReadStream> stream(archive->readStream(filename));
+	if (!stream) {
+		return "";
+	}
+	// two independent 32 bit hashes to reduce the chance of collisions
+	uint32_t contentHash1 = 0u;
+	uint32_t contentHash2 = 0x9e3779b9u;
+	const int64_t size = stream->size();
+	uint8_t buf[64 * 1024];
+	while (!stream->eos()) {
+		const int read = stream->read(buf, core_min((int64_t)sizeof(buf), stream->remaining()));
+		if (read <= 0) {
+			Log::warn("Failed to read %s for the scene cache", filename.c_str());
+			return "";
+		}
+		contentHash1 = core::hash(buf, read, contentHash1);
+		contentHash2 = core::hash(buf, read, contentHash2);
+	}
+	// some formats are reading information from the filename (e.g. the region coordinates of minecraft
+	// regions) and the node names are based on it, too
+	const uint64_t configHash = core::hash(filename.c_str(), core::hash(desc.name.c_str(), sceneCacheConfigHash(config)));
+	return core::String::format("%08x%08x%016" PRIx64 "%016" PRIx64, contentHash1, contentHash2, (uint64_t)size,
+								configHash);
+}
+
+bool loadSceneCache(const core::String &key, scenegraph::SceneGraph &sceneGraph, const LoadContext &ctx) {
+	core_trace_scoped(LoadSceneCache);
+	const core::String &path = sceneCachePath(ctx.config, key);
+	if (!io::Filesystem::sysExists(path)) {
+		return false;
+	}
+	const io::ArchivePtr &archive = io::openFilesystemArchive(io::filesystem());
+	VENGIFormat format;
+	if (!format.load(path, archive, sceneGraph, ctx)) {
+		Log::warn("Failed to load the cached scene %s - removing it", path.c_str());
+		sceneGraph.clear();
+		io::Filesystem::sysRemoveFile(path);
+		return false;
+	}
+	Log::debug("Loaded scene from cache %s", path.c_str());
+	return true;
+}
+
+bool saveSceneCache(const core::String &key, const scenegraph::SceneGraph &sceneGraph, const FormatConfig &config) {
+	core_trace_scoped(SaveSceneCache);
+	const core::String &dir = config.sceneCache;
+	if (!io::Filesystem::sysIsReadableDir(dir) && !io::Filesystem::sysCreateDir(dir)) {
+		Log::warn("Failed to create the scene cache directory %s", dir.c_str());
+		return false;
+	}
+	const core::String &path = sceneCachePath(config, key);
+	// concurrent loads of the same file must never see a partially written cache entry - and concurrent writers of
+	// the same entry must not write into the same temp file
+	const core::String tmpPath = path + "." + core::UUID::generate().str() + ".tmp";
+	const io::ArchivePtr &archive = io::openFilesystemArchive(io::filesystem());
+	VENGISnapshotFormat format;
+	// the cached scene must match the loaded scene - the save settings of the user don't apply here
+	SaveContext ctx(FormatConfig::lossless());
+	if (!format.save(sceneGraph, tmpPath, archive, ctx)) {
+		Log::warn("Failed to write the scene cache %s", tmpPath.c_str());
+		io::Filesystem::sysRemoveFile(tmpPath);
+		return false;
+	}
+	if (!io::Filesystem::sysRenameFile(tmpPath, path)) {
+		io::Filesystem::sysRemoveFile(tmpPath);
+		return false;
+	}
+	Log::debug("Wrote scene cache %s", path.c_str());
+	return true;
+}
+
+} // namespace voxelformat
@@ -0,0 +1,48 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/String.h"
+#include "io/Archive.h"
+
+namespace io {
+struct FormatDescription;
+}
+
+namespace scenegraph {
+class SceneGraph;
+}
+
+namespace voxelformat {
+
+class FormatConfig;
+struct LoadContext;
+
+/**
+ * @brief Persistent cache of loaded scenes in the directory given by @c FormatConfig::sceneCache
+ *
+ * Loading mesh formats or large worlds means parsing and voxelizing the input for every load. The cache stores the
+ * resulting scene graph and is keyed by the name and the content of the loaded file, the format, the format
+ * configuration of the load and the current palette. The scene is cached as it was loaded - the save settings of the
+ * format configuration don't apply.
+ *
+ * @note Files that are referenced by the loaded file (textures, material libraries or buffers) are not part of the
+ * key - modifying them doesn't invalidate the cached scene.
+ */
+bool isSceneCacheEnabled(const FormatConfig &config);
+
+/**
+ * @return The cache key for the given file or an empty string if the file couldn't get read
+ */
+core::String sceneCacheKey(const core::String &filename, const io::ArchivePtr &archive,
+						   const io::FormatDescription &desc, const FormatConfig &config);
+
+/**
+ * @return @c false if there is no scene cached for the given key
+ */
+bool loadSceneCache(const core::String &key, scenegraph::SceneGraph &sceneGraph, const LoadContext &ctx);
+bool saveSceneCache(const core::String &key, const scenegraph::SceneGraph &sceneGraph, const FormatConfig &config);
+
+} // namespace voxelformat
@@ -20,6 +20,7 @@
 #include "scenegraph/SceneGraphNode.h"
 #include "video/Texture.h"
 #include "voxelformat/Format.h"
+#include "voxelformat/SceneCache.h"
 #include "voxelformat/private/aceofspades/AoSVXLFormat.h"
 #include "voxelformat/private/animatoon/AnimaToonFormat.h"
 #include "voxelformat/private/anivoxel/AniVoxelFormat.h"
@@ -327,6 +328,7 @@ image::ImagePtr loadScreenshot(const core::String &filename, const io::ArchivePt
 	}
 	const core::SharedPtr<Format> &f = getFormat(*desc, magic);
 	if (f) {
+		f->configure(ctx.config);
 		return f->loadScreenshot(filename, archive, ctx);
 	}
 	Log::error("Failed to load model screenshot from file %s - "
@@ -364,6 +366,7 @@ size_t loadPalette(const core::String &filename, const io::ArchivePtr &archive,
 	palette.setName(desc->name);
 	palette.setFilename(filename);
 	if (const core::SharedPtr<Format> &f = getFormat(*desc, magic)) {
+		f->configure(ctx.config);
 		const size_t n = f->loadPalette(filename, archive, palette, ctx);
 		palette.markDirty();
 		return n;
@@ -385,6 +388,15 @@ bool loadFormat(const io::FileDescription &fileDesc, const io::ArchivePtr &archi
 	const core::TimeProviderPtr &timeProvider = app::App::getInstance()->timeProvider();
 	const uint64_t msStart = timeProvider->systemMillis();
 	const core::String &filename = fileDesc.name;
+	core::String cacheKey;
+	if (isSceneCacheEnabled(ctx.config) && !(*desc == VENGIFormat::format())) {
+		cacheKey = sceneCacheKey(filename, archive, *desc, ctx.config);
+		if (!cacheKey.empty() && loadSceneCache(cacheKey, newSceneGraph, ctx)) {
+			const uint64_t msDiff = timeProvider->systemMillis() - msStart;
+			Log::info("Load file %s from the scene cache (%ums)", filename.c_str(), (uint32_t)msDiff);
+			return true;
+		}
+	}
 	const core::SharedPtr<Format> &f = getFormat(*desc, magic);
 	if (f) {
 		if (!f->load(filename, archive, newSceneGraph, ctx)) {
@@ -408,6 +420,9 @@ bool loadFormat(const io::FileDescription &fileDesc, const io::ArchivePtr &archi
 	const uint64_t msEnd = timeProvider->systemMillis();
 	const uint64_t msDiff = msEnd - msStart;
 	Log::info("Load file %s with %i model nodes and %i point nodes (%ums)", filename.c_str(), models, points, (uint32_t)msDiff);
+	if (!cacheKey.empty()) {
+		saveSceneCache(cacheKey, newSceneGraph, ctx.config);
+	}
 	const core::String &ext = core::string::extractExtension(filename);
 	if (!ext.empty()) {
 		metric::count("load", 1, {{"type", ext.toLower()}});
@@ -5,6 +5,8 @@
 #include "app/benchmark/AbstractBenchmark.h"
 #include "io/FilesystemArchive.h"
 #include "scenegraph/SceneGraph.h"
+#include "scenegraph/SceneGraphNode.h"
+#include "voxel/RawVolume.h"
 #include "voxelformat/Format.h"
 #include "voxelformat/FormatConfig.h"
 #include "voxelformat/private/mesh/FBXFormat.h"
@@ -27,11 +29,12 @@ protected:
 			Super::voxelizePointCloud("benchmark", sceneGraph, core::move(vertices));
 		}
 
-		void transformTris(const voxelformat::MeshTriCollection &tris, voxelformat::PosMap &posMap, const voxelformat::MeshMaterialArray &meshMaterialArray) const {
+		void voxelizeTrisBinned(const voxelformat::MeshTriCollection &tris, const voxelformat::MeshMaterialArray &meshMaterialArray) const {
 			palette::NormalPalette normalPalette;
 			normalPalette.redAlert2();
-			voxel::Region region{-1000, 1000};
-			Super::transformTris(region, tris, posMap, meshMaterialArray, normalPalette);
+			scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+			node.setVolume(new voxel::RawVolume(voxel::Region{-128, 128}), true);
+			Super::voxelizeTrisBinned(node, tris, meshMaterialArray, normalPalette, false);
 		}
 
 		void transformTrisAxisAligned(const voxelformat::MeshTriCollection &tris, voxelformat::PosMap &posMap, const voxelformat::MeshMaterialArray &meshMaterialArray) const {
@@ -84,13 +87,20 @@ BENCHMARK_DEFINE_F(MeshFormatBenchmark, voxelizePointCloud)(benchmark::State &st
 	}
 }
 
-BENCHMARK_DEFINE_F(MeshFormatBenchmark, transformTris)(benchmark::State &state) {
+BENCHMARK_DEFINE_F(MeshFormatBenchmark, voxelizeTrisBinned)(benchmark::State &state) {
 	voxelformat::MeshTriCollection tris;
-	tris.resize(10000);
+	tris.reserve(10000);
+	for (int i = 0; i < 10000; ++i) {
+		const float x = (float)(i % 100) * 2.0f - 100.0f;
+		const float z = (float)(i / 100) * 2.0f - 100.0f;
+		voxelformat::MeshTri meshTri;
+		meshTri.setVertices(glm::vec3(x, -10.0f, z), glm::vec3(x + 2.0f, 10.0f, z), glm::vec3(x, 0.0f, z + 2.0f));
+		meshTri.setColor(color::RGBA(255, 0, 0, 255));
+		tris.push_back(meshTri);
+	}
 	for (auto _ : state) {
 		MeshFormatEx f;
-		voxelformat::PosMap posMap;
-		f.transformTris(tris, posMap, {});
+		f.voxelizeTrisBinned(tris, {});
 	}
 }
 
@@ -107,7 +117,7 @@ BENCHMARK_DEFINE_F(MeshFormatBenchmark, transformTrisAxisAligned)(benchmark::Sta
 BENCHMARK_REGISTER_F(MeshFormatBenchmark, GLTF);
 BENCHMARK_REGISTER_F(MeshFormatBenchmark, FBX);
 BENCHMARK_REGISTER_F(MeshFormatBenchmark, voxelizePointCloud);
-BENCHMARK_REGISTER_F(MeshFormatBenchmark, transformTris);
+BENCHMARK_REGISTER_F(MeshFormatBenchmark, voxelizeTrisBinned);
 BENCHMARK_REGISTER_F(MeshFormatBenchmark, transformTrisAxisAligned);
 
 BENCHMARK_MAIN();
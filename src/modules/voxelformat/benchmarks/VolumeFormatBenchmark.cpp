@@ -4,7 +4,11 @@
 
 #include "app/benchmark/AbstractBenchmark.h"
 #include "io/FilesystemArchive.h"
+#include "io/MemoryArchive.h"
 #include "scenegraph/SceneGraph.h"
+#include "scenegraph/SceneGraphNode.h"
+#include "voxel/RawVolume.h"
+#include "voxel/Voxel.h"
 #include "voxelformat/Format.h"
 #include "voxelformat/FormatConfig.h"
 #include "voxelformat/private/goxel/GoxFormat.h"
@@ -73,8 +77,64 @@ BENCHMARK_DEFINE_F(VolumeFormatBenchmark, MCR)(benchmark::State &state) {
 	}
 }
 
+/**
+ * @brief Loading a scene with a big model node in the vengi layouts
+ */
+class VENGILayoutBenchmark : public VolumeFormatBenchmark {
+private:
+	using Super = VolumeFormatBenchmark;
+
+protected:
+	io::MemoryArchivePtr _memArchive;
+
+	void SetUp(::benchmark::State &state) override {
+		Super::SetUp(state);
+		_memArchive = io::openMemoryArchive();
+		voxel::RawVolume *volume = new voxel::RawVolume(voxel::Region(0, 255));
+		for (int z = 0; z < 256; ++z) {
+			for (int y = 0; y < 128; ++y) {
+				for (int x = 0; x < 256; ++x) {
+					volume->setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, (uint8_t)((x ^ z) + y)));
+				}
+			}
+		}
+		scenegraph::SceneGraph sceneGraph;
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(volume, true);
+		sceneGraph.emplace(core::move(node));
+		voxelformat::SaveContext saveCtx;
+		voxelformat::VENGIFormat indexed;
+		indexed.save(sceneGraph, "indexed.vengi", _memArchive, saveCtx);
+		voxelformat::VENGISnapshotFormat snapshot;
+		snapshot.save(sceneGraph, "snapshot.vengi", _memArchive, saveCtx);
+	}
+
+	void TearDown(::benchmark::State &state) override {
+		_memArchive = {};
+		Super::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(VENGILayoutBenchmark, Indexed)(benchmark::State &state) {
+	for (auto _ : state) {
+		voxelformat::VENGIFormat f;
+		f.load("indexed.vengi", _memArchive, _sceneGraph, _ctx);
+		_sceneGraph.clear();
+	}
+}
+
+BENCHMARK_DEFINE_F(VENGILayoutBenchmark, Snapshot)(benchmark::State &state) {
+	for (auto _ : state) {
+		voxelformat::VENGIFormat f;
+		f.load("snapshot.vengi", _memArchive, _sceneGraph, _ctx);
+		_sceneGraph.clear();
+	}
+}
+
 BENCHMARK_REGISTER_F(VolumeFormatBenchmark, chr_knight_QB);
 BENCHMARK_REGISTER_F(VolumeFormatBenchmark, chr_knight_QBCL);
 BENCHMARK_REGISTER_F(VolumeFormatBenchmark, chr_knight_GOX);
 BENCHMARK_REGISTER_F(VolumeFormatBenchmark, chr_knight_VENGI);
 BENCHMARK_REGISTER_F(VolumeFormatBenchmark, MCR);
+BENCHMARK_REGISTER_F(VENGILayoutBenchmark, Indexed);
+BENCHMARK_REGISTER_F(VENGILayoutBenchmark, Snapshot);
@@ -7,7 +7,6 @@
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
 #include "io/Archive.h"
 #include "io/Stream.h"
 #include "scenegraph/SceneGraph.h"
@@ -195,7 +194,7 @@ bool BinVoxFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const co
 	const glm::ivec3 &offset = -mins;
 	const float scale = 1.0f;
 
-	const int binvoxVersion = core::Var::getSafe(cfg::VoxformatBinvoxVersion)->intVal();
+	const int binvoxVersion = ctx.config.binvoxVersion;
 
 	stream->writeStringFormat(false, "#binvox %i\n", binvoxVersion);
 	stream->writeStringFormat(false, "dim %u %u %u\n", width, depth, height);
@@ -5,11 +5,9 @@
 #include "VXLFormat.h"
 #include "core/Assert.h"
 #include "core/Common.h"
-#include "core/ConfigVar.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
 #include "core/collection/Buffer.h"
 #include "core/collection/StringSet.h"
 #include "io/Archive.h"
@@ -686,7 +684,7 @@ bool VXLFormat::loadGroupsPalette(const core::String &filename, const io::Archiv
 
 	const core::String &basename = core::string::stripExtension(filename);
 
-	const bool loadHVA = core::Var::getSafe(cfg::VoxformatVXLLoadHVA)->boolVal();
+	const bool loadHVA = ctx.config.vxlLoadHVA;
 	if (loadHVA && archive->exists(basename + ".hva")) {
 		HVAFormat hva;
 		wrapBool(hva.loadHVA(basename + ".hva", archive, mdl, sceneGraph))
@@ -4,13 +4,12 @@
 
 #include "AsepriteFormat.h"
 #include "app/Async.h"
-#include "core/ConfigVar.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/String.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
 #include "core/collection/Buffer.h"
+#include "core/collection/DynamicArray.h"
 #include "io/Stream.h"
 #include "math/Axis.h"
 #include "palette/Palette.h"
@@ -43,41 +42,32 @@
 
 namespace voxelformat {
 
-bool AsepriteFormat::addFrame(scenegraph::SceneGraph &sceneGraph, const core::String &filename, const palette::Palette &palette,
-					 const LoadContext &ctx, const ase_t *ase, int frameIndex, math::Axis axis, int offset) const {
-	const ase_frame_t *frame = ase->frames + frameIndex;
-	scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
-	voxel::Region region(0, 0, 0, ase->w - 1, ase->h - 1, 1);
-	voxel::RawVolume *v = new voxel::RawVolume(region);
-	node.setVolume(v, true);
-	node.setName(core::String::format("%s_%d", filename.c_str(), frameIndex));
-	node.setPalette(palette);
+void AsepriteFormat::fillFrames(const ase_t *ase, const palette::Palette &palette,
+								const core::DynamicArray<voxel::RawVolume *> &volumes) const {
 	palette::PaletteLookup palLookup(palette);
-	auto fn = [&palLookup, ase, frame, v, this](int start, int end) {
-		voxel::RawVolume::Sampler sampler(v);
-		sampler.setPosition(0, ase->h - 1, 0);
-		for (int y = 0; y < ase->h; ++y) {
-			voxel::RawVolume::Sampler sampler2 = sampler;
+	auto fn = [&palLookup, &volumes, ase, this](int start, int end) {
+		core::Buffer<color::RGBA> rowColors(ase->w);
+		core::Buffer<uint8_t> rowIndices(ase->w);
+		for (int row = start; row < end; ++row) {
+			const int frameIndex = row / ase->h;
+			const int y = row % ase->h;
+			const ase_color_t *pixels = ase->frames[frameIndex].pixels + y * ase->w;
 			for (int x = 0; x < ase->w; ++x) {
-				const ase_color_t pixel = frame->pixels[x + y * ase->w];
-				if (pixel.a == 0) {
-					sampler2.movePositiveX();
-					continue;
+				const ase_color_t pixel = pixels[x];
+				rowColors[x] = pixel.a == 0 ? color::RGBA(0, 0, 0, 0) : flattenRGB(pixel.r, pixel.g, pixel.b, pixel.a);
+			}
+			palLookup.findClosestIndices(rowColors.data(), rowIndices.data(), rowColors.size());
+			voxel::RawVolume::Sampler sampler(volumes[frameIndex]);
+			sampler.setPosition(0, ase->h - 1 - y, 0);
+			for (int x = 0; x < ase->w; ++x) {
+				if (rowColors[x].a != 0) {
+					sampler.setVoxel(voxel::createVoxel(voxel::VoxelType::Generic, rowIndices[x]));
 				}
-				const color::RGBA color = flattenRGB(pixel.r, pixel.g, pixel.b, pixel.a);
-				const int index = palLookup.findClosestIndex(color);
-				sampler2.setVoxel(voxel::createVoxel(voxel::VoxelType::Generic, index));
-				sampler2.movePositiveX();
+				sampler.movePositiveX();
 			}
-			sampler.moveNegativeY();
 		}
 	};
-	app::for_parallel(0, ase->w, fn);
-	glm::ivec3 sliceOffset(0);
-	sliceOffset[math::getIndexForAxis(axis)] = offset;
-	sliceOffset *= frameIndex;
-	node.volume()->translate(sliceOffset);
-	return sceneGraph.emplace(core::move(node)) != InvalidNodeId;
+	app::for_parallel(0, ase->frame_count * ase->h, fn);
 }
 
 ase_t *AsepriteFormat::loadAseprite(const core::String &filename, const io::ArchivePtr &archive) const {
@@ -109,17 +99,32 @@ bool AsepriteFormat::loadGroupsRGBA(const core::String &filename, const io::Arch
 		return false;
 	}
 	const core::String filenameNoPath = core::string::extractFilename(filename);
-	const int offset = core::Var::getSafe(cfg::VoxformatImageSliceOffset)->intVal();
-	const math::Axis axis = math::toAxis(core::Var::getSafe(cfg::VoxformatImageSliceOffsetAxis)->strVal());
+	const int offset = ctx.config.imageSliceOffset;
+	const math::Axis axis = math::toAxis(ctx.config.imageSliceOffsetAxis);
+	core::DynamicArray<voxel::RawVolume *> volumes;
+	volumes.reserve(ase->frame_count);
+	const voxel::Region region(0, 0, 0, ase->w - 1, ase->h - 1, 1);
+	for (int i = 0; i < ase->frame_count; ++i) {
+		volumes.push_back(new voxel::RawVolume(region));
+	}
+	fillFrames(ase, palette, volumes);
+
+	glm::ivec3 sliceOffset(0);
+	sliceOffset[math::getIndexForAxis(axis)] = offset;
+	bool success = true;
 	for (int i = 0; i < ase->frame_count; ++i) {
-		if (!addFrame(sceneGraph, filenameNoPath, palette, ctx, ase, i, axis, offset)) {
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(volumes[i], true);
+		node.setName(core::String::format("%s_%d", filenameNoPath.c_str(), i));
+		node.setPalette(palette);
+		node.volume()->translate(sliceOffset * i);
+		if (success && sceneGraph.emplace(core::move(node)) == InvalidNodeId) {
 			Log::error("Failed to add frame %d from Aseprite file '%s'", i, filename.c_str());
-			cute_aseprite_free(ase);
-			return false;
+			success = false;
 		}
 	}
 	cute_aseprite_free(ase);
-	return true;
+	return success;
 }
 
 size_t AsepriteFormat::loadPalette(const core::String &filename, const io::ArchivePtr &archive,
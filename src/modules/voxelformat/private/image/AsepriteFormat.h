@@ -4,10 +4,15 @@
 
 #pragma once
 
+#include "core/collection/DynamicArray.h"
 #include "voxelformat/Format.h"
 
 struct ase_t;
 
+namespace voxel {
+class RawVolume;
+}
+
 namespace voxelformat {
 
 /**
@@ -20,8 +25,12 @@ namespace voxelformat {
  */
 class AsepriteFormat : public RGBASinglePaletteFormat {
 protected:
-	bool addFrame(scenegraph::SceneGraph &sceneGraph, const core::String &filename, const palette::Palette &palette,
-				  const LoadContext &ctx, const ase_t *ase, int frameIndex, math::Axis axis, int offset) const;
+	/**
+	 * @brief Converts the pixels of all frames into the given volumes - the rows of all frames are converted in
+	 * parallel
+	 */
+	void fillFrames(const ase_t *ase, const palette::Palette &palette,
+					const core::DynamicArray<voxel::RawVolume *> &volumes) const;
 	ase_t *loadAseprite(const core::String &filename, const io::ArchivePtr &archive) const;
 	bool loadGroupsRGBA(const core::String &filename, const io::ArchivePtr &archive, scenegraph::SceneGraph &sceneGraph,
 						const palette::Palette &palette, const LoadContext &ctx) override;
@@ -4,11 +4,10 @@
 
 #include "PNGFormat.h"
 #include "app/Async.h"
-#include "core/ConfigVar.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
+#include "core/collection/Buffer.h"
 #include "core/collection/DynamicArray.h"
 #include "image/Image.h"
 #include "io/Archive.h"
@@ -100,6 +99,8 @@ bool PNGFormat::importSlices(scenegraph::SceneGraph &sceneGraph, const palette::
 
 	palette::PaletteLookup palLookup(palette);
 	auto fn = [&filteredEntites, &palLookup, &palette, &volume, imageHeight, imageWidth, this] (int start, int end) {
+		core::Buffer<color::RGBA> sliceColors(imageWidth * imageHeight);
+		core::Buffer<uint8_t> sliceIndices(imageWidth * imageHeight);
 		for (int i = start; i < end; ++i) {
 			const auto &entity = *filteredEntites[i];
 			const core::String &layerFilename = entity.fullPath;
@@ -120,18 +121,23 @@ bool PNGFormat::importSlices(scenegraph::SceneGraph &sceneGraph, const palette::
 			}
 			Log::debug("Import layer %i of image %s", layer, layerFilename.c_str());
 
+			// map the whole slice at once - runs of the same color are only looked up once
+			for (int y = 0; y < imageHeight; ++y) {
+				for (int x = 0; x < imageWidth; ++x) {
+					sliceColors[y * imageWidth + x] = flattenRGB(image->colorAt(x, y));
+				}
+			}
+			palLookup.findClosestIndices(sliceColors.data(), sliceIndices.data(), sliceColors.size());
+
 			voxel::RawVolume::Sampler sampler(volume);
 			sampler.setPosition(0, 0, layer);
 			for (int y = 0; y < imageHeight; ++y) {
 				voxel::RawVolume::Sampler sampler2 = sampler;
+				const int rowOffset = y * imageWidth;
 				for (int x = 0; x < imageWidth; ++x) {
-					const color::RGBA &color = flattenRGB(image->colorAt(x, y));
-					if (color.a == 0) {
-						sampler2.movePositiveX();
-						continue;
+					if (sliceColors[rowOffset + x].a != 0) {
+						sampler2.setVoxel(voxel::createVoxel(palette, sliceIndices[rowOffset + x]));
 					}
-					const int palIdx = palLookup.findClosestIndex(color);
-					sampler2.setVoxel(voxel::createVoxel(palette, palIdx));
 					sampler2.movePositiveX();
 				}
 				sampler.movePositiveY();
@@ -168,7 +174,7 @@ bool PNGFormat::importAsHeightmap(scenegraph::SceneGraph &sceneGraph, const pale
 	voxel::RawVolumeWrapper wrapper(volume);
 	scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
 	const voxel::Voxel dirtVoxel = voxel::createVoxel(voxel::VoxelType::Generic, 1);
-	const uint8_t minHeight = core::Var::getSafe(cfg::VoxformatImageHeightmapMinHeight)->intVal();
+	const uint8_t minHeight = _config.imageHeightmapMinHeight;
 	if (coloredHeightmap) {
 		voxelutil::importColoredHeightmap(wrapper, palette, image, dirtVoxel, minHeight, false);
 	} else {
@@ -184,8 +190,8 @@ bool PNGFormat::importAsHeightmap(scenegraph::SceneGraph &sceneGraph, const pale
 bool PNGFormat::importAsVolume(scenegraph::SceneGraph &sceneGraph, const palette::Palette &palette,
 							   const core::String &filename, const io::ArchivePtr &archive) const {
 	const image::ImagePtr &image = image::loadImage(filename);
-	const int maxDepth = core::Var::getSafe(cfg::VoxformatImageVolumeMaxDepth)->intVal();
-	const bool bothSides = core::Var::getSafe(cfg::VoxformatImageVolumeBothSides)->boolVal();
+	const int maxDepth = _config.imageVolumeMaxDepth;
+	const bool bothSides = _config.imageVolumeBothSides;
 	const core::String &depthMapFilename = voxelutil::getDefaultDepthMapFile(filename);
 	core::ScopedPtr<io::SeekableReadStream> depthMapStream(archive->readStream(depthMapFilename));
 	const image::ImagePtr &depthMapImage = image::loadImage(depthMapFilename, *depthMapStream, depthMapStream->size());
@@ -226,7 +232,7 @@ bool PNGFormat::importAsPlane(scenegraph::SceneGraph &sceneGraph, const palette:
 bool PNGFormat::loadGroupsRGBA(const core::String &filename, const io::ArchivePtr &archive,
 							   scenegraph::SceneGraph &sceneGraph, const palette::Palette &palette,
 							   const LoadContext &ctx) {
-	const int type = core::Var::getSafe(cfg::VoxformatImageImportType)->intVal();
+	const int type = ctx.config.imageImportType;
 	if (type == ImageType::Heightmap) {
 		return importAsHeightmap(sceneGraph, palette, filename, archive);
 	}
@@ -259,7 +265,7 @@ bool PNGFormat::loadGroupsRGBA(const core::String &filename, const io::ArchivePt
 size_t PNGFormat::loadPalette(const core::String &filename, const io::ArchivePtr &archive, palette::Palette &palette,
 							  const LoadContext &ctx) {
 	const image::ImagePtr &image = image::loadImage(filename);
-	const int type = core::Var::getSafe(cfg::VoxformatImageImportType)->intVal();
+	const int type = ctx.config.imageImportType;
 	if (type == ImageType::Heightmap) {
 		image->makeOpaque();
 	}
@@ -300,7 +306,7 @@ bool PNGFormat::saveThumbnail(const scenegraph::SceneGraph &sceneGraph, const co
 
 bool PNGFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
 						   const io::ArchivePtr &archive, const SaveContext &ctx) {
-	const int type = core::Var::getSafe(cfg::VoxformatImageSaveType)->intVal();
+	const int type = ctx.config.imageSaveType;
 	if (type == ImageType::Heightmap) {
 		return saveHeightmaps(sceneGraph, filename, archive);
 	}
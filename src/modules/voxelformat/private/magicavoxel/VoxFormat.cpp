@@ -4,11 +4,9 @@
 
 #include "VoxFormat.h"
 #include "app/Async.h"
-#include "core/ConfigVar.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
 #include "scenegraph/SceneGraph.h"
 #include "scenegraph/SceneGraphNode.h"
 #include "scenegraph/SceneGraphNodeCamera.h"
@@ -334,7 +332,7 @@ void VoxFormat::saveNode(const scenegraph::SceneGraph &sceneGraph, scenegraph::S
 		} else {
 			Log::debug("Add group node");
 		}
-		const bool addLayers = core::Var::getSafe(cfg::VoxformatVOXCreateLayers)->boolVal();
+		const bool addLayers = _config.voxCreateLayers;
 		if (node.isRootNode() || addLayers) {
 			// TODO: VOXELFORMAT: only add the layer if there are models in this group?
 			// https://github.com/vengi-voxel/vengi/issues/186
@@ -350,7 +348,7 @@ void VoxFormat::saveNode(const scenegraph::SceneGraph &sceneGraph, scenegraph::S
 			ctx.layers.push_back(ogt_layer);
 		}
 		const uint32_t ownLayerId = (int)ctx.layers.size() - 1;
-		const bool addGroups = core::Var::getSafe(cfg::VoxformatVOXCreateGroups)->boolVal();
+		const bool addGroups = _config.voxCreateGroups;
 		if (node.isRootNode() || addGroups) {
 			ogt_vox_group ogt_group;
 			core_memset(&ogt_group, 0, sizeof(ogt_group));
@@ -850,7 +850,7 @@ int FBXFormat::addMeshNode(const ufbx_scene *ufbxScene, const ufbx_node *ufbxNod
 			const ufbx_texture *ufbxTexture = ufbxMaterialTexture ? ufbxMaterialTexture->texture : nullptr;
 			if (ufbxTexture) {
 				const core::String &fbxTextureFilename = priv::_ufbx_to_string(ufbxTexture->relative_filename);
-				const core::String &textureName = lookupTexture(filename, fbxTextureFilename, archive);
+				const core::String &textureName = lookupTexture(filename, fbxTextureFilename, archive, _config.texturePath);
 				if (!textureName.empty()) {
 					const image::ImagePtr &tex = image::loadImage(textureName);
 					if (tex->isLoaded()) {
@@ -5,14 +5,12 @@
 #include "GLTFFormat.h"
 #include "app/App.h"
 #include "color/Color.h"
-#include "core/ConfigVar.h"
 #include "core/FourCC.h"
 #include "core/Log.h"
 #include "color/RGBA.h"
 #include "core/ScopedPtr.h"
 #include "core/String.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
 #include "core/collection/DynamicArray.h"
 #include "engine-config.h"
 #include "image/Image.h"
@@ -162,6 +160,9 @@ static bool archiveGetFileSize(size_t *filesize_out, std::string *err, const std
 	return true;
 }
 
+// the vertices and indices of all meshes are stored in the first buffer - for glb files this is the binary chunk
+static constexpr int MeshBufferIndex = 0;
+
 static int addBuffer(tinygltf::Model &gltfModel, io::BufferedReadWriteStream &stream, const char *name) {
 	tinygltf::Buffer gltfBuffer;
 	gltfBuffer.name = name;
@@ -227,6 +228,54 @@ static color::RGBA toColor(const tinygltf::Accessor *gltfAttributeAccessor, cons
 	return color::RGBA(0, 0, 0, 255);
 }
 
+static float readComponent(const tinygltf::Accessor *gltfAccessor, io::SeekableReadStream &stream) {
+	const bool normalized = gltfAccessor->normalized;
+	switch (gltfAccessor->componentType) {
+	case TINYGLTF_COMPONENT_TYPE_BYTE: {
+		int8_t v = 0;
+		stream.readInt8(v);
+		return normalized ? glm::max((float)v / 127.0f, -1.0f) : (float)v;
+	}
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+		uint8_t v = 0;
+		stream.readUInt8(v);
+		return normalized ? (float)v / 255.0f : (float)v;
+	}
+	case TINYGLTF_COMPONENT_TYPE_SHORT: {
+		int16_t v = 0;
+		stream.readInt16(v);
+		return normalized ? glm::max((float)v / 32767.0f, -1.0f) : (float)v;
+	}
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+		uint16_t v = 0;
+		stream.readUInt16(v);
+		return normalized ? (float)v / 65535.0f : (float)v;
+	}
+	default: {
+		float v = 0.0f;
+		stream.readFloat(v);
+		return v;
+	}
+	}
+}
+
+static bool readVec3(const tinygltf::Accessor *gltfAccessor, io::SeekableReadStream &stream, glm::vec3 &v) {
+	switch (gltfAccessor->componentType) {
+	case TINYGLTF_COMPONENT_TYPE_FLOAT:
+	case TINYGLTF_COMPONENT_TYPE_BYTE:
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+	case TINYGLTF_COMPONENT_TYPE_SHORT:
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		break;
+	default:
+		return false;
+	}
+	v.x = readComponent(gltfAccessor, stream);
+	v.y = readComponent(gltfAccessor, stream);
+	v.z = readComponent(gltfAccessor, stream);
+	return true;
+}
+
 static tinygltf::Camera processCamera(const scenegraph::SceneGraphNodeCamera &camera) {
 	tinygltf::Camera gltfCamera;
 	gltfCamera.name = camera.name().c_str();
@@ -312,7 +361,8 @@ static bool loadImageData(tinygltf::Image *tinyImage, const int image_idx, std::
 
 } // namespace _priv
 
-void GLTFFormat::createPointMesh(tinygltf::Model &gltfModel, const scenegraph::SceneGraphNode &node) const {
+void GLTFFormat::createPointMesh(tinygltf::Model &gltfModel, const scenegraph::SceneGraphNode &node,
+								 io::BufferedReadWriteStream &os) const {
 	tinygltf::Mesh gltfMesh;
 	gltfMesh.name = node.name().c_str();
 	const glm::vec3 position = node.transform().localTranslation();
@@ -331,36 +381,29 @@ void GLTFFormat::createPointMesh(tinygltf::Model &gltfModel, const scenegraph::S
 	gltfAccessor.bufferView = (int)gltfModel.bufferViews.size();
 	gltfModel.accessors.emplace_back(gltfAccessor);
 
-	io::BufferedReadWriteStream os;
+	tinygltf::BufferView gltfVerticesBufferView;
+	gltfVerticesBufferView.buffer = _priv::MeshBufferIndex;
+	gltfVerticesBufferView.byteOffset = os.size();
 	os.writeFloat(position.x);
 	os.writeFloat(position.y);
 	os.writeFloat(position.z);
-
-	tinygltf::BufferView gltfVerticesBufferView;
-	gltfVerticesBufferView.buffer = (int)gltfModel.buffers.size();
-	gltfVerticesBufferView.byteOffset = 0;
-	gltfVerticesBufferView.byteLength = os.size();
+	gltfVerticesBufferView.byteLength = os.size() - gltfVerticesBufferView.byteOffset;
 	gltfVerticesBufferView.byteStride = 0;
 	gltfVerticesBufferView.target = TINYGLTF_TARGET_ARRAY_BUFFER;
 
 	gltfModel.bufferViews.emplace_back(core::move(gltfVerticesBufferView));
-
-	tinygltf::Buffer gltfBuffer;
-	gltfBuffer.data.insert(gltfBuffer.data.end(), os.getBuffer(), os.getBuffer() + os.size());
-	gltfModel.buffers.emplace_back(core::move(gltfBuffer));
 	gltfModel.meshes.emplace_back(core::move(gltfMesh));
 }
 
-void GLTFFormat::saveGltfNode(core::Map<int, int> &nodeMapping, tinygltf::Model &gltfModel, tinygltf::Scene &gltfScene,
-							  const scenegraph::SceneGraphNode &node, Stack &stack,
-							  const scenegraph::SceneGraph &sceneGraph, const glm::vec3 &scale, bool exportAnimations) {
+int GLTFFormat::saveGltfNode(core::Map<int, int> &nodeMapping, tinygltf::Model &gltfModel, tinygltf::Scene &gltfScene,
+							 const scenegraph::SceneGraphNode &node, Stack &stack,
+							 const scenegraph::SceneGraph &sceneGraph, const glm::vec3 &scale, bool exportAnimations,
+							 int gltfMeshIdx, io::BufferedReadWriteStream &os) {
 	tinygltf::Node gltfNode;
-	if (node.isAnyModelNode()) {
-		gltfNode.mesh = (int)gltfModel.meshes.size();
-	}
+	gltfNode.mesh = gltfMeshIdx;
 	if (node.type() == scenegraph::SceneGraphNodeType::Point) {
-		createPointMesh(gltfModel, node);
 		gltfNode.mesh = (int)gltfModel.meshes.size();
+		createPointMesh(gltfModel, node, os);
 	}
 	gltfNode.name = node.name().c_str();
 	Log::debug("process node %s", gltfNode.name.c_str());
@@ -403,54 +446,98 @@ void GLTFFormat::saveGltfNode(core::Map<int, int> &nodeMapping, tinygltf::Model
 	for (int i = (int)nodeChildren.size() - 1; i >= 0; i--) {
 		stack.emplace_back(nodeChildren[i], idx);
 	}
+	return idx;
 }
 
-uint32_t GLTFFormat::writeBuffer(const voxel::Mesh *mesh, uint8_t idx, io::SeekableWriteStream &os, bool withColor,
-								 bool withTexCoords, bool colorAsFloat, bool exportNormals, bool applyTransform,
-								 const glm::vec3 &pivotOffset, const palette::Palette &palette, Bounds &bounds) {
+bool GLTFFormat::saveMeshPrimitives(const voxel::Mesh *mesh, const glm::vec3 &pivotOffset, bool applyTransform,
+									const palette::Palette &palette, bool withColor, bool withTexCoords,
+									bool colorAsFloat, bool quantize, int texcoordIndex,
+									const MaterialMap &paletteMaterialIndices, io::BufferedReadWriteStream &os,
+									tinygltf::Model &gltfModel, tinygltf::Mesh &gltfMesh, bool &quantized) const {
 	const int nv = (int)mesh->getNoOfVertices();
 	const int ni = (int)mesh->getNoOfIndices();
 
 	const voxel::VertexArray &vertices = mesh->getVertexVector();
 	const voxel::NormalArray &normals = mesh->getNormalVector();
 	const voxel::IndexArray &indices = mesh->getIndexVector();
+	const bool exportNormals = !normals.empty();
 
-	for (int i = 0; i < ni; i++) {
-		if (vertices[indices[i]].colorIndex != idx) {
-			continue;
-		}
-		if (bounds.maxIndex < indices[i]) {
-			bounds.maxIndex = indices[i];
-		}
-		if (indices[i] < bounds.minIndex) {
-			bounds.minIndex = indices[i];
+	// every material gets its own range in the index buffer
+	int triangles[palette::PaletteMaxColors]{};
+	for (int i = 0; i < ni; i += 3) {
+		++triangles[vertices[indices[i]].colorIndex];
+	}
+	int firstIndex[palette::PaletteMaxColors];
+	int materialIndices = 0;
+	for (int j = 0; j < palette::PaletteMaxColors; ++j) {
+		if (j >= palette.colorCount() || palette.color(j).a == 0) {
+			triangles[j] = 0;
 		}
-		os.writeUInt32(indices[i]);
-		++bounds.ni;
+		firstIndex[j] = materialIndices;
+		materialIndices += triangles[j] * 3;
+	}
+	if (materialIndices == 0) {
+		return false;
 	}
-	static_assert(sizeof(voxel::IndexType) == 4, "if not 4 bytes - we might need padding here");
-	const uint32_t indexOffset = (uint32_t)os.size();
 
+	glm::vec3 minVertex{FLT_MAX};
+	glm::vec3 maxVertex{-FLT_MAX};
+	bool onGrid = true;
 	for (int i = 0; i < nv; i++) {
 		glm::vec3 pos = vertices[i].position;
 		if (applyTransform) {
 			pos += pivotOffset;
 		}
+		minVertex = glm::min(minVertex, pos);
+		maxVertex = glm::max(maxVertex, pos);
+		onGrid &= pos == glm::floor(pos);
+	}
+	quantized = quantize && onGrid && glm::all(glm::greaterThanEqual(minVertex, glm::vec3(INT16_MIN))) &&
+				glm::all(glm::lessThanEqual(maxVertex, glm::vec3(INT16_MAX)));
 
-		for (int coordIndex = 0; coordIndex < glm::vec3::length(); coordIndex++) {
-			os.writeFloat(pos[coordIndex]);
-			if (bounds.maxVertex[coordIndex] < pos[coordIndex]) {
-				bounds.maxVertex[coordIndex] = pos[coordIndex];
-			}
-			if (bounds.minVertex[coordIndex] > pos[coordIndex]) {
-				bounds.minVertex[coordIndex] = pos[coordIndex];
-			}
+	// the vertex attributes are shared by the primitives of all materials
+	tinygltf::BufferView gltfVerticesBufferView;
+	gltfVerticesBufferView.buffer = _priv::MeshBufferIndex;
+	gltfVerticesBufferView.byteOffset = os.size();
+	gltfVerticesBufferView.target = TINYGLTF_TARGET_ARRAY_BUFFER;
+	// all attributes are aligned to 4 bytes
+	const int positionSize = quantized ? 4 * sizeof(int16_t) : 3 * sizeof(float);
+	const int normalSize = exportNormals ? (quantized ? 4 * sizeof(int8_t) : 3 * sizeof(float)) : 0;
+	int colorSize = 0;
+	if (withTexCoords) {
+		colorSize = 2 * sizeof(float);
+	} else if (withColor) {
+		colorSize = colorAsFloat ? 4 * sizeof(float) : 4 * sizeof(uint8_t);
+	}
+	gltfVerticesBufferView.byteStride = positionSize + normalSize + colorSize;
+
+	for (int i = 0; i < nv; i++) {
+		glm::vec3 pos = vertices[i].position;
+		if (applyTransform) {
+			pos += pivotOffset;
+		}
+		if (quantized) {
+			os.writeInt16((int16_t)pos.x);
+			os.writeInt16((int16_t)pos.y);
+			os.writeInt16((int16_t)pos.z);
+			os.writeInt16(0);
+		} else {
+			os.writeFloat(pos.x);
+			os.writeFloat(pos.y);
+			os.writeFloat(pos.z);
 		}
-		++bounds.nv;
 
 		if (exportNormals) {
-			for (int coordIndex = 0; coordIndex < glm::vec3::length(); coordIndex++) {
-				os.writeFloat(normals[i][coordIndex]);
+			const glm::vec3 &normal = normals[i];
+			if (quantized) {
+				os.writeInt8((int8_t)glm::round(glm::clamp(normal.x, -1.0f, 1.0f) * 127.0f));
+				os.writeInt8((int8_t)glm::round(glm::clamp(normal.y, -1.0f, 1.0f) * 127.0f));
+				os.writeInt8((int8_t)glm::round(glm::clamp(normal.z, -1.0f, 1.0f) * 127.0f));
+				os.writeInt8(0);
+			} else {
+				os.writeFloat(normal.x);
+				os.writeFloat(normal.y);
+				os.writeFloat(normal.z);
 			}
 		}
 
@@ -473,145 +560,126 @@ uint32_t GLTFFormat::writeBuffer(const voxel::Mesh *mesh, uint8_t idx, io::Seeka
 			}
 		}
 	}
-	return indexOffset;
-}
+	gltfVerticesBufferView.byteLength = os.size() - gltfVerticesBufferView.byteOffset;
 
-bool GLTFFormat::savePrimitivesPerMaterial(uint8_t idx, const glm::vec3 &pivotOffset, tinygltf::Model &gltfModel,
-										   tinygltf::Mesh &gltfMesh, const voxel::Mesh *mesh,
-										   const palette::Palette &palette, bool withColor, bool withTexCoords,
-										   bool colorAsFloat, bool exportNormals, bool applyTransform,
-										   int texcoordIndex, const MaterialMap &paletteMaterialIndices) {
+	// sort the triangles by material
+	voxel::IndexArray sortedIndices;
+	sortedIndices.resize(materialIndices);
+	{
+		int writeIndex[palette::PaletteMaxColors];
+		core_memcpy(writeIndex, firstIndex, sizeof(writeIndex));
+		for (int i = 0; i < ni; i += 3) {
+			const uint8_t colorIndex = vertices[indices[i]].colorIndex;
+			if (triangles[colorIndex] == 0) {
+				continue;
+			}
+			int &w = writeIndex[colorIndex];
+			sortedIndices[w++] = indices[i];
+			sortedIndices[w++] = indices[i + 1];
+			sortedIndices[w++] = indices[i + 2];
+		}
+	}
 
-	const size_t expectedSize =
-		mesh->getNoOfIndices() * sizeof(voxel::IndexType) + mesh->getNoOfVertices() * 10 * sizeof(float);
-	io::BufferedReadWriteStream os((int64_t)expectedSize);
+	// the maximum value of the component type is not allowed as index
+	const bool shortIndices = nv < (int)UINT16_MAX;
+	const int indexSize = shortIndices ? (int)sizeof(uint16_t) : (int)sizeof(uint32_t);
+	tinygltf::BufferView gltfIndicesBufferView;
+	gltfIndicesBufferView.buffer = _priv::MeshBufferIndex;
+	gltfIndicesBufferView.byteOffset = os.size();
+	gltfIndicesBufferView.target = TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER;
+	for (voxel::IndexType index : sortedIndices) {
+		if (shortIndices) {
+			os.writeUInt16((uint16_t)index);
+		} else {
+			os.writeUInt32(index);
+		}
+	}
+	gltfIndicesBufferView.byteLength = os.size() - gltfIndicesBufferView.byteOffset;
+	while (os.size() % 4 != 0) {
+		os.writeUInt8(0);
+	}
 
-	Bounds bounds;
-	bounds.minIndex = UINT_MAX;
-	bounds.maxVertex = glm::vec3{-FLT_MAX};
-	bounds.minVertex = glm::vec3{FLT_MAX};
+	const int verticesBufferViewIdx = (int)gltfModel.bufferViews.size();
+	const int indicesBufferViewIdx = verticesBufferViewIdx + 1;
+	gltfModel.bufferViews.emplace_back(core::move(gltfVerticesBufferView));
+	gltfModel.bufferViews.emplace_back(core::move(gltfIndicesBufferView));
 
-	const uint32_t indicesBufferByteLen = writeBuffer(mesh, idx, os, withColor, withTexCoords, colorAsFloat,
-													  exportNormals, applyTransform, pivotOffset, palette, bounds);
-	if (indicesBufferByteLen == 0u) {
-		return false;
+	std::map<std::string, int> attributes;
+	{
+		tinygltf::Accessor gltfVerticesAccessor;
+		gltfVerticesAccessor.bufferView = verticesBufferViewIdx;
+		gltfVerticesAccessor.byteOffset = 0;
+		gltfVerticesAccessor.componentType =
+			quantized ? TINYGLTF_COMPONENT_TYPE_SHORT : TINYGLTF_COMPONENT_TYPE_FLOAT;
+		gltfVerticesAccessor.count = nv;
+		gltfVerticesAccessor.type = TINYGLTF_TYPE_VEC3;
+		gltfVerticesAccessor.maxValues = {maxVertex[0], maxVertex[1], maxVertex[2]};
+		gltfVerticesAccessor.minValues = {minVertex[0], minVertex[1], minVertex[2]};
+		attributes["POSITION"] = (int)gltfModel.accessors.size();
+		gltfModel.accessors.emplace_back(core::move(gltfVerticesAccessor));
 	}
-	tinygltf::BufferView gltfIndicesBufferView;
-	gltfIndicesBufferView.buffer = (int)gltfModel.buffers.size();
-	gltfIndicesBufferView.byteOffset = 0;
-	gltfIndicesBufferView.byteLength = indicesBufferByteLen;
-	gltfIndicesBufferView.target = TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER;
 
-	tinygltf::BufferView gltfVerticesBufferView;
-	gltfVerticesBufferView.buffer = (int)gltfModel.buffers.size();
-	gltfVerticesBufferView.byteOffset = indicesBufferByteLen;
-	gltfVerticesBufferView.byteLength = os.size() - indicesBufferByteLen;
-	gltfVerticesBufferView.byteStride = 3 * sizeof(float);
 	if (exportNormals) {
-		gltfVerticesBufferView.byteStride += 3 * sizeof(float);
-	}
-	if (withTexCoords) {
-		gltfVerticesBufferView.byteStride += 2 * sizeof(float);
-	} else if (withColor) {
-		if (colorAsFloat) {
-			gltfVerticesBufferView.byteStride += 4 * sizeof(float);
-		} else {
-			gltfVerticesBufferView.byteStride += 4 * sizeof(uint8_t);
-		}
+		tinygltf::Accessor gltfNormalAccessor;
+		gltfNormalAccessor.bufferView = verticesBufferViewIdx;
+		gltfNormalAccessor.byteOffset = positionSize;
+		gltfNormalAccessor.componentType = quantized ? TINYGLTF_COMPONENT_TYPE_BYTE : TINYGLTF_COMPONENT_TYPE_FLOAT;
+		gltfNormalAccessor.normalized = quantized;
+		gltfNormalAccessor.count = nv;
+		gltfNormalAccessor.type = TINYGLTF_TYPE_VEC3;
+		attributes["NORMAL"] = (int)gltfModel.accessors.size();
+		gltfModel.accessors.emplace_back(core::move(gltfNormalAccessor));
 	}
-	gltfVerticesBufferView.target = TINYGLTF_TARGET_ARRAY_BUFFER;
 
-	// Describe the layout of indicesBufferView, the indices of the vertices
-	tinygltf::Accessor gltfIndicesAccessor;
-	gltfIndicesAccessor.bufferView = (int)gltfModel.bufferViews.size();
-	gltfIndicesAccessor.byteOffset = 0;
-	gltfIndicesAccessor.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
-	gltfIndicesAccessor.count = bounds.ni;
-	gltfIndicesAccessor.type = TINYGLTF_TYPE_SCALAR;
-	gltfIndicesAccessor.maxValues.push_back(bounds.maxIndex);
-	gltfIndicesAccessor.minValues.push_back(bounds.minIndex);
-
-	// Describe the layout of verticesUvBufferView, the vertices themself
-	tinygltf::Accessor gltfVerticesAccessor;
-	gltfVerticesAccessor.bufferView = (int)gltfModel.bufferViews.size() + 1;
-	gltfVerticesAccessor.byteOffset = 0;
-	gltfVerticesAccessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
-	gltfVerticesAccessor.count = bounds.nv;
-	gltfVerticesAccessor.type = TINYGLTF_TYPE_VEC3;
-	gltfVerticesAccessor.maxValues = {bounds.maxVertex[0], bounds.maxVertex[1], bounds.maxVertex[2]};
-	gltfVerticesAccessor.minValues = {bounds.minVertex[0], bounds.minVertex[1], bounds.minVertex[2]};
-
-	// Describe the layout of normals - they are followed
-	tinygltf::Accessor gltfNormalAccessor;
-	gltfNormalAccessor.bufferView = (int)gltfModel.bufferViews.size() + 1;
-	gltfNormalAccessor.byteOffset = 3 * sizeof(float);
-	gltfNormalAccessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
-	gltfNormalAccessor.count = bounds.nv;
-	gltfNormalAccessor.type = TINYGLTF_TYPE_VEC3;
-
-	tinygltf::Accessor gltfColorAccessor;
 	if (withTexCoords) {
-		gltfColorAccessor.bufferView = (int)gltfModel.bufferViews.size() + 1;
-		gltfColorAccessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
-		gltfColorAccessor.count = bounds.nv;
-		gltfColorAccessor.byteOffset = (exportNormals ? 2 : 1) * 3 * sizeof(float);
-		gltfColorAccessor.type = TINYGLTF_TYPE_VEC2;
+		tinygltf::Accessor gltfTexCoordAccessor;
+		gltfTexCoordAccessor.bufferView = verticesBufferViewIdx;
+		gltfTexCoordAccessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+		gltfTexCoordAccessor.count = nv;
+		gltfTexCoordAccessor.byteOffset = positionSize + normalSize;
+		gltfTexCoordAccessor.type = TINYGLTF_TYPE_VEC2;
+		const core::String &texcoordsKey = core::String::format("TEXCOORD_%i", texcoordIndex);
+		attributes[texcoordsKey.c_str()] = (int)gltfModel.accessors.size();
+		gltfModel.accessors.emplace_back(core::move(gltfTexCoordAccessor));
 	} else if (withColor) {
-		gltfColorAccessor.bufferView = (int)gltfModel.bufferViews.size() + 1;
-		gltfColorAccessor.count = bounds.nv;
+		tinygltf::Accessor gltfColorAccessor;
+		gltfColorAccessor.bufferView = verticesBufferViewIdx;
+		gltfColorAccessor.count = nv;
 		gltfColorAccessor.type = TINYGLTF_TYPE_VEC4;
-		gltfColorAccessor.byteOffset = (exportNormals ? 2 : 1) * 3 * sizeof(float);
+		gltfColorAccessor.byteOffset = positionSize + normalSize;
 		if (colorAsFloat) {
 			gltfColorAccessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
 		} else {
 			gltfColorAccessor.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+			gltfColorAccessor.normalized = true;
 		}
+		attributes["COLOR_0"] = (int)gltfModel.accessors.size();
+		gltfModel.accessors.emplace_back(core::move(gltfColorAccessor));
 	}
 
-	{
-		// Build the mesh meshPrimitive and add it to the mesh
+	auto paletteMaterialIter = paletteMaterialIndices.find(palette.hash());
+	core_assert(paletteMaterialIter != paletteMaterialIndices.end());
+	for (int j = 0; j < palette::PaletteMaxColors; ++j) {
+		if (triangles[j] == 0) {
+			continue;
+		}
+		tinygltf::Accessor gltfIndicesAccessor;
+		gltfIndicesAccessor.bufferView = indicesBufferViewIdx;
+		gltfIndicesAccessor.byteOffset = (size_t)firstIndex[j] * indexSize;
+		gltfIndicesAccessor.componentType =
+			shortIndices ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+		gltfIndicesAccessor.count = (size_t)triangles[j] * 3;
+		gltfIndicesAccessor.type = TINYGLTF_TYPE_SCALAR;
+
 		tinygltf::Primitive gltfMeshPrimitive;
-		// The index of the accessor for the vertex indices
 		gltfMeshPrimitive.indices = (int)gltfModel.accessors.size();
-		// The index of the accessor for positions
-		gltfMeshPrimitive.attributes["POSITION"] = (int)gltfModel.accessors.size() + 1;
-		if (exportNormals) {
-			gltfMeshPrimitive.attributes["NORMAL"] = (int)gltfModel.accessors.size() + 2;
-		}
-		if (withTexCoords) {
-			const core::String &texcoordsKey = core::String::format("TEXCOORD_%i", texcoordIndex);
-			gltfMeshPrimitive.attributes[texcoordsKey.c_str()] =
-				(int)gltfModel.accessors.size() + (exportNormals ? 3 : 2);
-		} else if (withColor) {
-			gltfMeshPrimitive.attributes["COLOR_0"] = (int)gltfModel.accessors.size() + (exportNormals ? 3 : 2);
-		}
-		auto paletteMaterialIter = paletteMaterialIndices.find(palette.hash());
-		core_assert(paletteMaterialIter != paletteMaterialIndices.end());
-		const int material = paletteMaterialIter->value[idx];
+		gltfMeshPrimitive.attributes = attributes;
+		const int material = paletteMaterialIter->value[j];
 		core_assert(material >= 0);
 		gltfMeshPrimitive.material = material;
 		gltfMeshPrimitive.mode = TINYGLTF_MODE_TRIANGLES;
 		gltfMesh.primitives.emplace_back(core::move(gltfMeshPrimitive));
-	}
-
-	{
-		// indices and vertices
-		tinygltf::Buffer gltfBuffer;
-		gltfBuffer.data.insert(gltfBuffer.data.end(), os.getBuffer(), os.getBuffer() + os.size());
-		gltfModel.buffers.emplace_back(core::move(gltfBuffer));
-	}
-
-	Log::debug("Index buffer view at %i", (int)gltfModel.bufferViews.size());
-	gltfModel.bufferViews.emplace_back(core::move(gltfIndicesBufferView));
-	Log::debug("vertex buffer view at %i", (int)gltfModel.bufferViews.size());
-	gltfModel.bufferViews.emplace_back(core::move(gltfVerticesBufferView));
-	gltfModel.accessors.emplace_back(core::move(gltfIndicesAccessor));
-	gltfModel.accessors.emplace_back(core::move(gltfVerticesAccessor));
-	if (exportNormals) {
-		gltfModel.accessors.emplace_back(core::move(gltfNormalAccessor));
-	}
-	if (withTexCoords || withColor) {
-		gltfModel.accessors.emplace_back(core::move(gltfColorAccessor));
+		gltfModel.accessors.emplace_back(core::move(gltfIndicesAccessor));
 	}
 
 	return true;
@@ -733,6 +801,178 @@ bool GLTFFormat::save_KHR_materials_pbrSpecularGlossiness(const palette::Materia
 	return true;
 }
 
+void GLTFFormat::save_EXT_mesh_gpu_instancing(int gltfNodeIdx, const core::DynamicArray<int> &nodeIds,
+											  const scenegraph::SceneGraph &sceneGraph, io::BufferedReadWriteStream &os,
+											  tinygltf::Model &gltfModel) const {
+	// the instance transforms are relative to the parent - just like the transforms of the nodes they replace
+	tinygltf::Node &gltfNode = gltfModel.nodes[gltfNodeIdx];
+	gltfNode.matrix.clear();
+
+	const int count = (int)nodeIds.size();
+	tinygltf::Value::Object attributes;
+	const struct {
+		const char *name;
+		int components;
+	} instanceAttributes[] = {{"TRANSLATION", 3}, {"ROTATION", 4}, {"SCALE", 3}};
+	for (const auto &attribute : instanceAttributes) {
+		tinygltf::BufferView gltfBufferView;
+		gltfBufferView.buffer = _priv::MeshBufferIndex;
+		gltfBufferView.byteOffset = os.size();
+		for (int nodeId : nodeIds) {
+			const scenegraph::SceneGraphTransform &transform = sceneGraph.node(nodeId).transform();
+			if (attribute.components == 4) {
+				const glm::quat &orientation = transform.localOrientation();
+				os.writeFloat(orientation.x);
+				os.writeFloat(orientation.y);
+				os.writeFloat(orientation.z);
+				os.writeFloat(orientation.w);
+				continue;
+			}
+			const glm::vec3 &v = attribute.name[0] == 'T' ? transform.localTranslation() : transform.localScale();
+			os.writeFloat(v.x);
+			os.writeFloat(v.y);
+			os.writeFloat(v.z);
+		}
+		gltfBufferView.byteLength = os.size() - gltfBufferView.byteOffset;
+
+		tinygltf::Accessor gltfAccessor;
+		gltfAccessor.bufferView = (int)gltfModel.bufferViews.size();
+		gltfAccessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+		gltfAccessor.count = count;
+		gltfAccessor.type = attribute.components == 4 ? TINYGLTF_TYPE_VEC4 : TINYGLTF_TYPE_VEC3;
+		attributes[attribute.name] = tinygltf::Value((int)gltfModel.accessors.size());
+		gltfModel.bufferViews.emplace_back(core::move(gltfBufferView));
+		gltfModel.accessors.emplace_back(core::move(gltfAccessor));
+	}
+	tinygltf::Value::Object instancing;
+	instancing["attributes"] = tinygltf::Value(attributes);
+	gltfNode.extensions["EXT_mesh_gpu_instancing"] = tinygltf::Value(instancing);
+	addExtension(gltfModel, "EXT_mesh_gpu_instancing");
+}
+
+bool GLTFFormat::load_EXT_mesh_gpu_instancing(const tinygltf::Model &gltfModel, const tinygltf::Node &gltfNode,
+											  core::DynamicArray<glm::mat4> &instances) const {
+	auto extIter = gltfNode.extensions.find("EXT_mesh_gpu_instancing");
+	if (extIter == gltfNode.extensions.end()) {
+		return false;
+	}
+	const tinygltf::Value &attributes = extIter->second.Get("attributes");
+	if (!attributes.IsObject()) {
+		return false;
+	}
+	const char *names[] = {"TRANSLATION", "ROTATION", "SCALE"};
+	const tinygltf::Accessor *accessors[lengthof(names)]{};
+	size_t count = 0;
+	for (int i = 0; i < lengthof(names); ++i) {
+		const tinygltf::Value &accessorId = attributes.Get(names[i]);
+		if (!accessorId.IsInt()) {
+			continue;
+		}
+		const tinygltf::Accessor *gltfAccessor = getAccessor(gltfModel, accessorId.GetNumberAsInt());
+		if (gltfAccessor == nullptr || gltfAccessor->componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
+			Log::warn("Unsupported accessor for instance attribute %s", names[i]);
+			return false;
+		}
+		if (count != 0 && count != gltfAccessor->count) {
+			Log::warn("Instance attribute %s has an invalid amount of elements", names[i]);
+			return false;
+		}
+		count = gltfAccessor->count;
+		accessors[i] = gltfAccessor;
+	}
+	if (count == 0) {
+		return false;
+	}
+	instances.resize(count);
+	for (size_t n = 0; n < count; ++n) {
+		glm::vec3 translation{0.0f};
+		glm::quat orientation = glm::quat::wxyz(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 scale{1.0f};
+		for (int i = 0; i < lengthof(names); ++i) {
+			const tinygltf::Accessor *gltfAccessor = accessors[i];
+			if (gltfAccessor == nullptr) {
+				continue;
+			}
+			const size_t size = accessorSize(*gltfAccessor);
+			const tinygltf::BufferView &gltfBufferView = gltfModel.bufferViews[gltfAccessor->bufferView];
+			const size_t stride = gltfBufferView.byteStride ? gltfBufferView.byteStride : size;
+			const tinygltf::Buffer &gltfBuffer = gltfModel.buffers[gltfBufferView.buffer];
+			const size_t offset = gltfAccessor->byteOffset + gltfBufferView.byteOffset + n * stride;
+			io::MemoryReadStream stream(gltfBuffer.data.data() + offset, size);
+			if (i == 0) {
+				stream.readFloat(translation.x);
+				stream.readFloat(translation.y);
+				stream.readFloat(translation.z);
+			} else if (i == 1) {
+				stream.readFloat(orientation.x);
+				stream.readFloat(orientation.y);
+				stream.readFloat(orientation.z);
+				stream.readFloat(orientation.w);
+			} else {
+				stream.readFloat(scale.x);
+				stream.readFloat(scale.y);
+				stream.readFloat(scale.z);
+			}
+		}
+		instances[n] = glm::scale(glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(orientation), scale);
+	}
+	return true;
+}
+
+void GLTFFormat::collectInstances(const core::Map<int, int> &meshIdxNodeMap, const scenegraph::SceneGraph &sceneGraph,
+								  const ChunkMeshes &meshes, InstanceGroups &instanceGroups,
+								  core::Map<int, int> &nodeInstanceGroups) const {
+	struct InstanceGroup {
+		const ChunkMeshExt *meshExt;
+		int parent;
+		uint64_t paletteHash;
+		core::DynamicArray<int> nodeIds;
+	};
+	core::DynamicArray<InstanceGroup> groups;
+	core::Map<int, core::DynamicArray<int>> groupsByMesh;
+	for (const auto &entry : meshIdxNodeMap) {
+		const scenegraph::SceneGraphNode &node = sceneGraph.node(entry->key);
+		if (!node.children().empty()) {
+			continue;
+		}
+		// don't wait for the meshes here - the nodes with the same owner share the mesh
+		const ChunkMeshExt &meshExt = meshes.properties(entry->value);
+		const int meshKey = meshes.owner(entry->value);
+		auto iter = groupsByMesh.find(meshKey);
+		if (iter == groupsByMesh.end()) {
+			groupsByMesh.put(meshKey, core::DynamicArray<int>());
+			iter = groupsByMesh.find(meshKey);
+		}
+		bool found = false;
+		for (int groupIdx : iter->value) {
+			InstanceGroup &group = groups[groupIdx];
+			if (group.parent != node.parent() || group.paletteHash != node.palette().hash()) {
+				continue;
+			}
+			if (meshExt.applyTransform && group.meshExt->pivot * group.meshExt->size != meshExt.pivot * meshExt.size) {
+				continue;
+			}
+			group.nodeIds.push_back(node.id());
+			found = true;
+			break;
+		}
+		if (!found) {
+			iter->value.push_back((int)groups.size());
+			groups.push_back({&meshExt, node.parent(), node.palette().hash(), {node.id()}});
+		}
+	}
+	for (InstanceGroup &group : groups) {
+		if (group.nodeIds.size() < 2) {
+			continue;
+		}
+		for (int nodeId : group.nodeIds) {
+			nodeInstanceGroups.put(nodeId, (int)instanceGroups.size());
+		}
+		Log::debug("Export %i nodes as instances of one node", (int)group.nodeIds.size());
+		instanceGroups.emplace_back(core::move(group.nodeIds));
+	}
+}
+
 int GLTFFormat::saveEmissiveTexture(tinygltf::Model &gltfModel, const palette::Palette &palette) const {
 	bool hasEmit = false;
 	color::RGBA colors[palette::PaletteMaxColors];
@@ -803,9 +1043,8 @@ void GLTFFormat::generateMaterials(bool withTexCoords, tinygltf::Model &gltfMode
 
 		const int textureIndex = withTexCoords ? saveTexture(gltfModel, palette) : -1;
 		const int emissiveTextureIndex = withTexCoords ? saveEmissiveTexture(gltfModel, palette) : -1;
-		const bool KHR_materials_pbrSpecularGlossiness =
-			core::Var::getSafe(cfg::VoxformatGLTF_KHR_materials_pbrSpecularGlossiness)->boolVal();
-		const bool withMaterials = core::Var::getSafe(cfg::VoxformatWithMaterials)->boolVal();
+		const bool KHR_materials_pbrSpecularGlossiness = _config.gltfPbrSpecularGlossiness;
+		const bool withMaterials = _config.withMaterials;
 
 		core::Array<int, palette::PaletteMaxColors> materialIds;
 		materialIds.fill(-1);
@@ -848,7 +1087,7 @@ void GLTFFormat::generateMaterials(bool withTexCoords, tinygltf::Model &gltfMode
 					pbrSpecularGlossiness = save_KHR_materials_pbrSpecularGlossiness(material, color, gltfMaterial, gltfModel);
 				}
 				if (!pbrSpecularGlossiness) {
-					if (core::Var::getSafe(cfg::VoxformatGLTF_KHR_materials_specular)->boolVal()) {
+					if (_config.gltfSpecular) {
 						save_KHR_materials_specular(material, color, gltfMaterial, gltfModel);
 					}
 					save_KHR_materials_ior(material, gltfMaterial, gltfModel);
@@ -880,13 +1119,16 @@ bool GLTFFormat::saveMeshes(const core::Map<int, int> &meshIdxNodeMap, const sce
 	tinygltf::Model gltfModel;
 	tinygltf::Scene gltfScene;
 
-	const bool colorAsFloat = core::Var::get(cfg::VoxformatColorAsFloat)->boolVal();
+	const bool colorAsFloat = _config.colorAsFloat;
 	if (colorAsFloat) {
 		Log::debug("Export colors as float");
 	} else {
 		Log::debug("Export colors as byte");
 	}
 
+	const bool quantize = _config.gltfMeshQuantization;
+	const bool instancing = _config.gltfMeshGpuInstancing;
+
 	const size_t modelNodes = meshes.size();
 	const core::String &appname = app::App::getInstance()->fullAppname();
 	const core::String &generator = core::String::format("%s " PROJECT_VERSION, appname.c_str());
@@ -895,12 +1137,36 @@ bool GLTFFormat::saveMeshes(const core::Map<int, int> &meshIdxNodeMap, const sce
 	gltfModel.asset.version = "2.0";
 	gltfModel.asset.copyright = sceneGraph.root().property(scenegraph::PropCopyright).c_str();
 	gltfModel.accessors.reserve(modelNodes * 4 + sceneGraph.animations().size() * 4);
+	gltfModel.buffers.resize(_priv::MeshBufferIndex + 1);
+	io::BufferedReadWriteStream os;
 
 	Stack stack;
 	stack.emplace_back(0, -1);
 
 	const bool exportAnimations = sceneGraph.hasAnimations();
 
+	InstanceGroups instanceGroups;
+	core::Map<int, int> nodeInstanceGroups;
+	if (instancing && !exportAnimations) {
+		collectInstances(meshIdxNodeMap, sceneGraph, meshes, instanceGroups, nodeInstanceGroups);
+	}
+	core::DynamicArray<bool> instanceGroupsSaved;
+	instanceGroupsSaved.resize(instanceGroups.size());
+	for (size_t i = 0; i < instanceGroupsSaved.size(); ++i) {
+		instanceGroupsSaved[i] = false;
+	}
+
+	// reference nodes share the mesh with the referenced node - the gltf mesh is only written once
+	struct GltfMeshEntry {
+		/** the index of the mesh owner - the meshes are released after they were written */
+		int meshOwner;
+		glm::vec3 pivotOffset;
+		uint64_t paletteHash;
+		int gltfMeshIdx;
+	};
+	core::DynamicArray<GltfMeshEntry> gltfMeshEntries;
+	bool quantized = false;
+
 	MaterialMap paletteMaterialIndices((int)sceneGraph.size());
 	core::Map<int, int> nodeMapping((int)sceneGraph.nodeSize());
 	while (!stack.empty()) {
@@ -908,67 +1174,87 @@ bool GLTFFormat::saveMeshes(const core::Map<int, int> &meshIdxNodeMap, const sce
 		const scenegraph::SceneGraphNode &node = sceneGraph.node(nodeId);
 		palette::Palette palette = node.palette();
 
+		int instanceGroup = -1;
+		if (nodeInstanceGroups.get(nodeId, instanceGroup) && instanceGroupsSaved[instanceGroup]) {
+			// this leaf node was already exported as an instance of one of its siblings
+			int meshExtIdx = 0;
+			if (meshIdxNodeMap.get(nodeId, meshExtIdx)) {
+				meshes.release(meshExtIdx);
+			}
+			stack.pop();
+			continue;
+		}
+
 		if (meshIdxNodeMap.find(nodeId) == meshIdxNodeMap.end()) {
-			saveGltfNode(nodeMapping, gltfModel, gltfScene, node, stack, sceneGraph, scale, false);
+			saveGltfNode(nodeMapping, gltfModel, gltfScene, node, stack, sceneGraph, scale, false, -1, os);
 			continue;
 		}
 
 		int meshExtIdx = 0;
 		core_assert_always(meshIdxNodeMap.get(nodeId, meshExtIdx));
 		const ChunkMeshExt &meshExt = meshes[meshExtIdx];
-
-		int texcoordIndex = 0;
-		if (node.isAnyModelNode()) {
-			for (int i = 0; i < voxel::ChunkMesh::Meshes; ++i) {
-				const voxel::Mesh *mesh = &meshExt.mesh->mesh[i];
-				if (mesh->isEmpty()) {
-					continue;
-				}
-				generateMaterials(withTexCoords, gltfModel, paletteMaterialIndices, node, palette, texcoordIndex);
+		const glm::vec3 pivotOffset = glm::vec3(meshExt.mesh->mesh[0].getOffset()) - meshExt.pivot * meshExt.size;
+
+		int gltfMeshIdx = -1;
+		const int meshOwner = meshes.owner(meshExtIdx);
+		for (const GltfMeshEntry &entry : gltfMeshEntries) {
+			if (entry.meshOwner == meshOwner && entry.paletteHash == palette.hash() &&
+				(!meshExt.applyTransform || entry.pivotOffset == pivotOffset)) {
+				gltfMeshIdx = entry.gltfMeshIdx;
+				break;
 			}
 		}
 
-		for (int i = 0; i < voxel::ChunkMesh::Meshes; ++i) {
-			const voxel::Mesh *mesh = &meshExt.mesh->mesh[i];
-			if (mesh->isEmpty()) {
-				continue;
-			}
-
-			Log::debug("Exporting model %s", meshExt.name.c_str());
-
-			const int ni = (int)mesh->getNoOfIndices();
-			if (ni % 3 != 0) {
-				Log::error("Unexpected indices amount");
-				return false;
-			}
+		if (gltfMeshIdx == -1) {
+			int texcoordIndex = 0;
+			generateMaterials(withTexCoords, gltfModel, paletteMaterialIndices, node, palette, texcoordIndex);
 
-			const voxel::NormalArray &normals = mesh->getNormalVector();
 			const char *objectName = meshExt.name.c_str();
-			const bool exportNormals = !normals.empty();
-			if (exportNormals) {
-				Log::debug("Export normals for mesh %i", i);
-			}
-
 			if (objectName[0] == '\0') {
 				objectName = "Noname";
 			}
-			const glm::vec3 &offset = mesh->getOffset();
-			const glm::vec3 pivotOffset = offset - meshExt.pivot * meshExt.size;
+			Log::debug("Exporting model %s", objectName);
 
 			tinygltf::Mesh gltfMesh;
 			gltfMesh.name = objectName;
-			for (int j = 0; j < palette.colorCount(); ++j) {
-				if (palette.color(j).a == 0) {
+			for (int i = 0; i < voxel::ChunkMesh::Meshes; ++i) {
+				const voxel::Mesh *mesh = &meshExt.mesh->mesh[i];
+				if (mesh->isEmpty()) {
 					continue;
 				}
-				savePrimitivesPerMaterial(j, pivotOffset, gltfModel, gltfMesh, mesh, palette, withColor, withTexCoords,
-										  colorAsFloat, exportNormals, meshExt.applyTransform, texcoordIndex,
-										  paletteMaterialIndices);
+				const int ni = (int)mesh->getNoOfIndices();
+				if (ni % 3 != 0) {
+					Log::error("Unexpected indices amount");
+					return false;
+				}
+				bool meshQuantized = false;
+				saveMeshPrimitives(mesh, pivotOffset, meshExt.applyTransform, palette, withColor, withTexCoords,
+								   colorAsFloat, quantize, texcoordIndex, paletteMaterialIndices, os, gltfModel,
+								   gltfMesh, meshQuantized);
+				quantized |= meshQuantized;
 			}
-			saveGltfNode(nodeMapping, gltfModel, gltfScene, node, stack, sceneGraph, scale, exportAnimations);
+			gltfMeshIdx = (int)gltfModel.meshes.size();
 			gltfModel.meshes.emplace_back(core::move(gltfMesh));
+			gltfMeshEntries.push_back({meshOwner, pivotOffset, palette.hash(), gltfMeshIdx});
+		} else {
+			Log::debug("Re-use mesh %i for model %s", gltfMeshIdx, meshExt.name.c_str());
+		}
+		meshes.release(meshExtIdx);
+		const int gltfNodeIdx = saveGltfNode(nodeMapping, gltfModel, gltfScene, node, stack, sceneGraph, scale,
+											 exportAnimations, gltfMeshIdx, os);
+		if (instanceGroup != -1) {
+			save_EXT_mesh_gpu_instancing(gltfNodeIdx, instanceGroups[instanceGroup], sceneGraph, os, gltfModel);
+			instanceGroupsSaved[instanceGroup] = true;
 		}
 	}
+	if (quantized) {
+		addExtension(gltfModel, "KHR_mesh_quantization");
+		gltfModel.extensionsRequired.push_back("KHR_mesh_quantization");
+	}
+	if (os.size() > 0) {
+		tinygltf::Buffer &gltfBuffer = gltfModel.buffers[_priv::MeshBufferIndex];
+		gltfBuffer.data.insert(gltfBuffer.data.end(), os.getBuffer(), os.getBuffer() + os.size());
+	}
 
 	if (exportAnimations) {
 		Log::debug("Export %i animations for %i nodes", (int)sceneGraph.animations().size(), (int)nodeMapping.size());
@@ -1400,7 +1686,7 @@ void GLTFFormat::loadTexture(const core::String &filename, const io::ArchivePtr
 			core::String name = gltfImage.uri.c_str();
 			meshMaterial->texture = image::loadImage(name);
 			if (!meshMaterial->texture->isLoaded()) {
-				name = lookupTexture(filename, name, archive);
+				name = lookupTexture(filename, name, archive, _config.texturePath);
 				meshMaterial->texture = image::loadImage(name);
 				if (meshMaterial->texture->isLoaded()) {
 					Log::debug("Use image %s", name.c_str());
@@ -1591,18 +1877,18 @@ bool GLTFFormat::loadAttributes(const core::String &filename, const tinygltf::Mo
 				   (int)stride);
 		const uint8_t *buf = gltfAttributeBuffer.data.data() + offset;
 		if (attrType == "POSITION") {
-			if (gltfAttributeAccessor->componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
-				Log::debug("Skip non float type for %s", attrType.c_str());
-				continue;
-			}
 			foundPositions = gltfAttributeAccessor->count;
 			core_assert(gltfAttributeAccessor->type == TINYGLTF_TYPE_VEC3);
 			for (size_t i = 0; i < gltfAttributeAccessor->count; i++) {
 				io::MemoryReadStream posStream(buf, stride);
 				glm::vec3 pos;
-				posStream.readFloat(pos.x);
-				posStream.readFloat(pos.y);
-				posStream.readFloat(pos.z);
+				// KHR_mesh_quantization allows integer positions
+				if (!_priv::readVec3(gltfAttributeAccessor, posStream, pos)) {
+					Log::debug("Skip unsupported type (%i) for %s", gltfAttributeAccessor->componentType,
+							   attrType.c_str());
+					foundPositions = 0;
+					break;
+				}
 				vertices[verticesOffset + i].pos = pos;
 				vertices[verticesOffset + i].materialIdx = gltfPrimitive.material;
 				buf += stride;
@@ -1990,6 +2276,26 @@ bool GLTFFormat::loadNode_r(const core::String &filename, scenegraph::SceneGraph
 			scenegraph::KeyFrameIndex keyFrameIdx = 0;
 			node.setTransform(keyFrameIdx, transform);
 		}
+		core::DynamicArray<glm::mat4> instances;
+		if (node.isModelNode() && load_EXT_mesh_gpu_instancing(gltfModel, gltfNode, instances)) {
+			// the first instance is the model node itself - all others are references to it
+			const glm::mat4 nodeMatrix = node.transform().localMatrix();
+			const scenegraph::KeyFrameIndex keyFrameIdx = 0;
+			scenegraph::SceneGraphTransform transform;
+			transform.setLocalMatrix(nodeMatrix * instances[0]);
+			node.setTransform(keyFrameIdx, transform);
+			const int instanceParentId = node.parent();
+			for (size_t i = 1; i < instances.size(); ++i) {
+				scenegraph::SceneGraphNode referenceNode(scenegraph::SceneGraphNodeType::ModelReference);
+				referenceNode.setReference(nodeId);
+				referenceNode.setName(core::String::format("%s %i", node.name().c_str(), (int)i));
+				referenceNode.setPalette(node.palette());
+				scenegraph::SceneGraphTransform instanceTransform;
+				instanceTransform.setLocalMatrix(nodeMatrix * instances[i]);
+				referenceNode.setTransform(keyFrameIdx, instanceTransform);
+				sceneGraph.emplace(core::move(referenceNode), instanceParentId);
+			}
+		}
 	}
 
 	for (int childId : gltfNode.children) {
@@ -25,6 +25,9 @@ struct TextureInfo;
 namespace scenegraph {
 class SceneGraphTransform;
 }
+namespace io {
+class BufferedReadWriteStream;
+}
 namespace voxelformat {
 
 /**
@@ -72,33 +75,55 @@ private:
 									 tinygltf::Material &gltfMaterial, tinygltf::Model &gltfModel) const;
 	void load_KHR_materials_specular(palette::Material &material, const tinygltf::Material &gltfMaterial) const;
 
+	/**
+	 * https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Vendor/EXT_mesh_gpu_instancing
+	 */
+	void save_EXT_mesh_gpu_instancing(int gltfNodeIdx, const core::DynamicArray<int> &nodeIds,
+									  const scenegraph::SceneGraph &sceneGraph, io::BufferedReadWriteStream &os,
+									  tinygltf::Model &gltfModel) const;
+	bool load_EXT_mesh_gpu_instancing(const tinygltf::Model &gltfModel, const tinygltf::Node &gltfNode,
+									  core::DynamicArray<glm::mat4> &instances) const;
+
 	// exporting
-	struct Bounds {
-		uint32_t maxIndex = 0u;
-		uint32_t minIndex = 0u;
-		uint32_t ni = 0u;
-		uint32_t nv = 0u;
-		glm::vec3 maxVertex{0.0f};
-		glm::vec3 minVertex{0.0f};
-	};
-	void createPointMesh(tinygltf::Model &gltfModel, const scenegraph::SceneGraphNode &node) const;
+	void createPointMesh(tinygltf::Model &gltfModel, const scenegraph::SceneGraphNode &node,
+						 io::BufferedReadWriteStream &os) const;
 	using Stack = core::Buffer<core::Pair<int, int>>;
 	using MaterialMap = core::Map<uint64_t, core::Array<int, palette::PaletteMaxColors>>;
-	void saveGltfNode(core::Map<int, int> &nodeMapping, tinygltf::Model &gltfModel, tinygltf::Scene &gltfScene,
-					  const scenegraph::SceneGraphNode &graphNode, Stack &stack,
-					  const scenegraph::SceneGraph &sceneGraph, const glm::vec3 &scale, bool exportAnimations);
-	uint32_t writeBuffer(const voxel::Mesh *mesh, uint8_t idx, io::SeekableWriteStream &os, bool withColor,
-						 bool withTexCoords, bool colorAsFloat, bool exportNormals, bool applyTransform,
-						 const glm::vec3 &pivotOffset, const palette::Palette &palette, Bounds &bounds);
+	/**
+	 * @brief Node ids of leaf nodes that are exported as instances of one gltf node
+	 */
+	using InstanceGroups = core::DynamicArray<core::DynamicArray<int>>;
+	/**
+	 * @brief Collects the leaf nodes that share the same mesh with the same parent to export them as instances of one
+	 * node
+	 * @param[out] nodeInstanceGroups Maps the node ids to the index of their group in @c instanceGroups
+	 */
+	void collectInstances(const core::Map<int, int> &meshIdxNodeMap, const scenegraph::SceneGraph &sceneGraph,
+						  const ChunkMeshes &meshes, InstanceGroups &instanceGroups,
+						  core::Map<int, int> &nodeInstanceGroups) const;
+	/**
+	 * @return The index of the gltf node
+	 */
+	int saveGltfNode(core::Map<int, int> &nodeMapping, tinygltf::Model &gltfModel, tinygltf::Scene &gltfScene,
+					 const scenegraph::SceneGraphNode &graphNode, Stack &stack, const scenegraph::SceneGraph &sceneGraph,
+					 const glm::vec3 &scale, bool exportAnimations, int gltfMeshIdx, io::BufferedReadWriteStream &os);
 	int saveEmissiveTexture(tinygltf::Model &gltfModel, const palette::Palette &palette) const;
 	int saveTexture(tinygltf::Model &gltfModel, const palette::Palette &palette) const;
 	void generateMaterials(bool withTexCoords, tinygltf::Model &gltfModel, MaterialMap &paletteMaterialIndices,
 						   const scenegraph::SceneGraphNode &node, const palette::Palette &palette,
 						   int &texcoordIndex) const;
-	bool savePrimitivesPerMaterial(uint8_t idx, const glm::vec3 &pivotOffset, tinygltf::Model &gltfModel,
-								   tinygltf::Mesh &gltfMesh, const voxel::Mesh *mesh, const palette::Palette &palette,
-								   bool withColor, bool withTexCoords, bool colorAsFloat, bool exportNormals,
-								   bool applyTransform, int texcoordIndex, const MaterialMap &paletteMaterialIndices);
+	/**
+	 * @brief Writes the vertices of the mesh once and adds a primitive for each used material that references them
+	 * @param[in] quantize Store the positions as integers (and the normals as normalized bytes) if the vertices are
+	 * located on the voxel grid (KHR_mesh_quantization)
+	 * @param[out] quantized Set to @c true if the attributes of this mesh were quantized
+	 * @return @c false if no primitive was added to the gltf mesh
+	 */
+	bool saveMeshPrimitives(const voxel::Mesh *mesh, const glm::vec3 &pivotOffset, bool applyTransform,
+							const palette::Palette &palette, bool withColor, bool withTexCoords, bool colorAsFloat,
+							bool quantize, int texcoordIndex, const MaterialMap &paletteMaterialIndices,
+							io::BufferedReadWriteStream &os, tinygltf::Model &gltfModel, tinygltf::Mesh &gltfMesh,
+							bool &quantized) const;
 
 	void saveAnimation(int targetNode, tinygltf::Model &m, const scenegraph::SceneGraphNode &node,
 					   tinygltf::Animation &gltfAnimation);
@@ -138,6 +163,9 @@ public:
 	bool saveMeshes(const core::Map<int, int> &meshIdxNodeMap, const scenegraph::SceneGraph &sceneGraph,
 					const ChunkMeshes &meshes, const core::String &filename, const io::ArchivePtr &archive,
 					const glm::vec3 &scale, bool quad, bool withColor, bool withTexCoords) override;
+	void meshAccessOrder(const scenegraph::SceneGraph &sceneGraph, core::DynamicArray<int> &nodeIds) const override {
+		depthFirstNodeOrder(sceneGraph, nodeIds);
+	}
 
 	static const io::FormatDescription &format() {
 		static io::FormatDescription f{"GL Transmission Format",
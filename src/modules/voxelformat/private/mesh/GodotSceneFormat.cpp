@@ -180,6 +180,7 @@ bool GodotSceneFormat::saveNode(const core::Map<int, int> &meshIdxNodeMap, const
 				wrapBool(stream.writeStringFormat(false, "}"))
 				surfaceIdx++;
 			}
+			meshes.release(iter->value);
 			wrapBool(stream.writeStringFormat(false, "\n]\n"))
 
 			wrapBool(stream.writeString("\n", false))
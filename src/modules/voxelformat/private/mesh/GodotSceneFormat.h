@@ -33,6 +33,9 @@ protected:
 					const ChunkMeshes &meshes, const core::String &filename, const io::ArchivePtr &archive,
 					const glm::vec3 &scale = glm::vec3(1.0f), bool quad = false, bool withColor = true,
 					bool withTexCoords = true) override;
+	void meshAccessOrder(const scenegraph::SceneGraph &sceneGraph, core::DynamicArray<int> &nodeIds) const override {
+		depthFirstNodeOrder(sceneGraph, nodeIds);
+	}
 
 public:
 	static const io::FormatDescription &format() {
@@ -8,16 +8,18 @@
 #include "color/Color.h"
 #include "core/ConfigVar.h"
 #include "core/GLM.h"
+#include "core/Hash.h"
 #include "core/Log.h"
 #include "color/RGBA.h"
 #include "core/StringUtil.h"
 #include "core/UUID.h"
-#include "core/Var.h"
 #include "core/collection/DynamicArray.h"
 #include "core/collection/Map.h"
-#include "core/concurrent/Atomic.h"
+#include "core/concurrent/Concurrency.h"
+#include "core/concurrent/ConditionVariable.h"
 #include "core/concurrent/Lock.h"
 #include "io/Archive.h"
+#include "io/BufferedReadWriteStream.h"
 #include "meshoptimizer.h"
 #include "palette/NormalPalette.h"
 #include "palette/NormalPaletteLookup.h"
@@ -44,30 +46,12 @@
 
 namespace voxelformat {
 
-MeshFormat::MeshFormat() {
-	_weightedAverage = core::Var::getSafe(cfg::VoxformatRGBWeightedAverage)->boolVal();
-}
-
-MeshFormat::ChunkMeshExt *MeshFormat::getParent(const scenegraph::SceneGraph &sceneGraph, MeshFormat::ChunkMeshes &meshes,
-										   int nodeId) {
-	if (!sceneGraph.hasNode(nodeId)) {
-		return nullptr;
-	}
-	const int parent = sceneGraph.node(nodeId).parent();
-	for (ChunkMeshExt &me : meshes) {
-		if (me.nodeId == parent) {
-			return &me;
-		}
-	}
-	return nullptr;
-}
+glm::vec3 MeshFormat::getInputScale() const {
+	const float scale = _config.scale;
 
-glm::vec3 MeshFormat::getInputScale() {
-	const float scale = core::Var::getSafe(cfg::VoxformatScale)->floatVal();
-
-	float scaleX = core::Var::getSafe(cfg::VoxformatScaleX)->floatVal();
-	float scaleY = core::Var::getSafe(cfg::VoxformatScaleY)->floatVal();
-	float scaleZ = core::Var::getSafe(cfg::VoxformatScaleZ)->floatVal();
+	float scaleX = _config.scaleX;
+	float scaleY = _config.scaleY;
+	float scaleZ = _config.scaleZ;
 
 	scaleX = glm::epsilonNotEqual(scaleX, 1.0f, glm::epsilon<float>()) ? scaleX : scale;
 	scaleY = glm::epsilonNotEqual(scaleY, 1.0f, glm::epsilon<float>()) ? scaleY : scale;
@@ -76,35 +60,47 @@ glm::vec3 MeshFormat::getInputScale() {
 	return {scaleX, scaleY, scaleZ};
 }
 
-bool MeshFormat::subdivideTri(const voxelformat::MeshTri &meshTri, MeshTriCollection &tinyTris, int &depth) {
-	if (depth > 16) {
-		const glm::vec3 &mins = meshTri.mins();
-		const glm::vec3 &maxs = meshTri.maxs();
-		const glm::vec3 size = maxs - mins;
-		Log::warn("Max subdivision depth reached for tri with size %f:%f:%f", size.x, size.y, size.z);
-
-		tinyTris.push_back(meshTri);
-		return false;
-	}
-	if (stopExecution()) {
-		return false;
-	}
-	const glm::vec3 &mins = meshTri.mins();
-	const glm::vec3 &maxs = meshTri.maxs();
-	const glm::vec3 size = maxs - mins;
-	if (glm::any(glm::greaterThan(size, glm::vec3(1.0f)))) {
-		voxelformat::MeshTri out[4];
-		subdivide(meshTri, out);
-		for (int i = 0; i < lengthof(out); ++i) {
-			int d = depth;
-			subdivideTri(out[i], tinyTris, d);
+bool MeshFormat::writeChunksParallel(io::WriteStream &stream, int elements,
+									 const std::function<void(int start, int end, io::WriteStream &chunk)> &func) {
+	core_trace_scoped(WriteChunksParallel);
+	// only a few chunks are kept in memory at the same time
+	constexpr int ElementsPerChunk = 16384;
+	const int chunks = (elements + ElementsPerChunk - 1) / ElementsPerChunk;
+	const int chunksPerBatch = (int)core::cpus() * 2;
+	core::DynamicArray<io::BufferedReadWriteStream> buffers;
+	buffers.resize(core_min(chunks, chunksPerBatch));
+	for (int batchStart = 0; batchStart < chunks; batchStart += chunksPerBatch) {
+		const int batchEnd = core_min(chunks, batchStart + chunksPerBatch);
+		app::for_parallel(batchStart, batchEnd, [&](int start, int end) {
+			for (int chunk = start; chunk < end; ++chunk) {
+				io::BufferedReadWriteStream &buffer = buffers[chunk - batchStart];
+				buffer.reset();
+				func(chunk * ElementsPerChunk, core_min(elements, (chunk + 1) * ElementsPerChunk), buffer);
+			}
+		});
+		for (int chunk = batchStart; chunk < batchEnd; ++chunk) {
+			const io::BufferedReadWriteStream &buffer = buffers[chunk - batchStart];
+			if (stream.write(buffer.getBuffer(), (size_t)buffer.size()) == -1) {
+				Log::error("Failed to write mesh data");
+				return false;
+			}
 		}
-		return true;
 	}
-	tinyTris.push_back(meshTri);
 	return true;
 }
 
+void MeshFormat::writeFloatText(io::WriteStream &stream, float value, int decimals) {
+	char buf[core::string::FormatNumberBufSize];
+	const int len = core::string::formatFloat(buf, value, decimals);
+	stream.write(buf, len);
+}
+
+void MeshFormat::writeIntText(io::WriteStream &stream, int64_t value) {
+	char buf[core::string::FormatNumberBufSize];
+	const int len = core::string::formatInt(buf, value);
+	stream.write(buf, len);
+}
+
 static void convertToVoxelGrid(glm::vec3 &v) {
 	// convert into voxel grid coordinates
 	if (v.x < 0.0f) {
@@ -132,47 +128,9 @@ void MeshFormat::addToPosMap(PosMap &posMap, const voxel::Region &region, color:
 	if (rgba.a <= AlphaThreshold) {
 		return;
 	}
-	core::ScopedLock lock(_mutex);
 	const int idx = region.index(pos);
-	auto iter = posMap.find(idx);
-	if (iter == posMap.end()) {
-		posMap.emplace(idx, {area, rgba, normalIdx, materialIdx});
-	} else {
-		PosSampling &posSampling = iter->value;
-		posSampling.add(area, rgba, normalIdx, materialIdx);
-	}
-}
-
-void MeshFormat::transformTris(const voxel::Region &region, const MeshTriCollection &tris, PosMap &posMap,
-							   const MeshMaterialArray &meshMaterialArray,
-							   const palette::NormalPalette &normalPalette) const {
-	Log::debug("subdivided into %i triangles", (int)tris.size());
-	palette::NormalPaletteLookup normalLookup(normalPalette);
-	auto fn = [&tris, &region, &normalLookup, &posMap, &meshMaterialArray, this](int start, int end) {
-		for (int i = start; i < end; ++i) {
-			if (stopExecution()) {
-				return;
-			}
-			const voxelformat::MeshTri &meshTri = tris[i];
-			const glm::vec2 &uv = meshTri.centerUV();
-			const color::RGBA rgba = colorAt(meshTri, meshMaterialArray, uv);
-			if (rgba.a <= AlphaThreshold) {
-				continue;
-			}
-			const uint32_t area = (uint32_t)(meshTri.area() * 1000.0f);
-			glm::vec3 c = meshTri.center();
-			convertToVoxelGrid(c);
-
-			int normalIdx = normalLookup.getClosestMatch(meshTri.normal());
-			if (normalIdx == palette::PaletteNormalNotFound) {
-				normalIdx = NO_NORMAL;
-			}
-
-			const glm::ivec3 p(c);
-			addToPosMap(posMap, region, rgba, area, normalIdx, p, meshTri.materialIdx);
-		}
-	};
-	app::for_parallel(0, tris.size(), fn);
+	posMap.emplaceOrUpdate(idx, PosSampling(area, rgba, normalIdx, materialIdx),
+						   [&](PosSampling &posSampling) { posSampling.add(area, rgba, normalIdx, materialIdx); });
 }
 
 void MeshFormat::transformTrisAxisAligned(const voxel::Region &region, const MeshTriCollection &tris, PosMap &posMap,
@@ -269,6 +227,117 @@ static void voxelizeTriangle(const glm::vec3 &trisMins, const voxelformat::MeshT
 	}
 }
 
+static constexpr int VoxelizeBrickBits = 5;
+static constexpr int VoxelizeBrickSize = 1 << VoxelizeBrickBits;
+static constexpr int VoxelizeBrickMask = VoxelizeBrickSize - 1;
+static constexpr int VoxelizeBrickVoxels = VoxelizeBrickSize * VoxelizeBrickSize * VoxelizeBrickSize;
+
+/**
+ * @brief The part of a triangle that is inside of a voxel - every clip plane adds at most one vertex
+ */
+struct ClippedTriangle {
+	glm::vec3 vertices[12];
+	int amount = 0;
+};
+
+/**
+ * @brief Sutherland-Hodgman clipping against one axis aligned plane
+ * @param sign @c 1 to keep the part above the plane - @c -1 to keep the part below the plane
+ */
+static void clipAgainstPlane(const ClippedTriangle &in, ClippedTriangle &out, int axis, float value, float sign) {
+	out.amount = 0;
+	if (in.amount == 0) {
+		return;
+	}
+	glm::vec3 prev = in.vertices[in.amount - 1];
+	float prevDist = (prev[axis] - value) * sign;
+	for (int i = 0; i < in.amount; ++i) {
+		const glm::vec3 &cur = in.vertices[i];
+		const float curDist = (cur[axis] - value) * sign;
+		if ((curDist >= 0.0f) != (prevDist >= 0.0f) && out.amount < lengthof(out.vertices)) {
+			glm::vec3 intersection = glm::mix(prev, cur, prevDist / (prevDist - curDist));
+			intersection[axis] = value;
+			out.vertices[out.amount++] = intersection;
+		}
+		if (curDist >= 0.0f && out.amount < lengthof(out.vertices)) {
+			out.vertices[out.amount++] = cur;
+		}
+		prev = cur;
+		prevDist = curDist;
+	}
+}
+
+/**
+ * @brief Computes the area and the center of the part of the triangle that is inside of the given voxel
+ *
+ * The voxels are half open - a polygon that is lying on the upper face of the voxel belongs to the neighbour.
+ *
+ * @return @c false if the triangle doesn't cover any area of the voxel
+ */
+static bool clipTriangle(const voxelformat::MeshTri &meshTri, const glm::ivec3 &pos, float &area, glm::vec3 &center) {
+	ClippedTriangle polygon;
+	ClippedTriangle clipped;
+	polygon.vertices[0] = meshTri.vertex0();
+	polygon.vertices[1] = meshTri.vertex1();
+	polygon.vertices[2] = meshTri.vertex2();
+	polygon.amount = 3;
+	for (int axis = 0; axis < 3; ++axis) {
+		clipAgainstPlane(polygon, clipped, axis, (float)pos[axis], 1.0f);
+		clipAgainstPlane(clipped, polygon, axis, (float)(pos[axis] + 1), -1.0f);
+	}
+	if (polygon.amount < 3) {
+		return false;
+	}
+	for (int axis = 0; axis < 3; ++axis) {
+		const float upper = (float)(pos[axis] + 1);
+		int onUpperFace = 0;
+		for (int i = 0; i < polygon.amount; ++i) {
+			onUpperFace += polygon.vertices[i][axis] >= upper;
+		}
+		if (onUpperFace == polygon.amount) {
+			return false;
+		}
+	}
+	area = 0.0f;
+	glm::vec3 weightedCenter(0.0f);
+	const glm::vec3 &p0 = polygon.vertices[0];
+	for (int i = 1; i < polygon.amount - 1; ++i) {
+		const glm::vec3 &p1 = polygon.vertices[i];
+		const glm::vec3 &p2 = polygon.vertices[i + 1];
+		const float fanArea = glm::length(glm::cross(p1 - p0, p2 - p0)) * 0.5f;
+		area += fanArea;
+		weightedCenter += fanArea * (p0 + p1 + p2);
+	}
+	if (area <= 0.0f) {
+		return false;
+	}
+	center = weightedCenter / (3.0f * area);
+	return true;
+}
+
+/**
+ * @brief Samples the interpolated color of the triangle at the given position
+ * @param normal The not normalized normal of the triangle - the barycentric coordinates are computed relative to its
+ * length to also work for very small triangles
+ */
+static color::RGBA sampleTriangle(const voxelformat::MeshTri &meshTri, const glm::vec3 &normal,
+								  const MeshMaterialArray &meshMaterialArray, const glm::vec3 &pos) {
+	const glm::vec3 &v0 = meshTri.vertex0();
+	const glm::vec3 &v1 = meshTri.vertex1();
+	const glm::vec3 &v2 = meshTri.vertex2();
+	const float denom = glm::dot(normal, normal);
+	const float b0 = glm::dot(glm::cross(v2 - v1, pos - v1), normal) / denom;
+	const float b1 = glm::dot(glm::cross(v0 - v2, pos - v2), normal) / denom;
+	glm::vec3 b = glm::clamp(glm::vec3(b0, b1, 1.0f - b0 - b1), 0.0f, 1.0f);
+	b /= b.x + b.y + b.z;
+	const glm::vec2 uv = b.x * meshTri.uv0() + b.y * meshTri.uv1() + b.z * meshTri.uv2();
+	const color::RGBA rgba = color::getRGBA(b.x * color::fromRGBA(meshTri.color0()) +
+											b.y * color::fromRGBA(meshTri.color1()) +
+											b.z * color::fromRGBA(meshTri.color2()));
+	const voxelformat::MeshTri sample({pos, pos, pos}, {uv, uv, uv}, meshTri.materialIdx, {rgba, rgba, rgba});
+	return colorAt(sample, meshMaterialArray, uv);
+}
+
 int MeshFormat::voxelizeNode(const core::UUID &uuid, const core::String &name, scenegraph::SceneGraph &sceneGraph,
 							 MeshTriCollection &&tris, const MeshMaterialArray &meshMaterialArray, int parent, bool resetOrigin) const {
 	if (tris.empty()) {
@@ -298,7 +367,7 @@ int MeshFormat::voxelizeNode(const core::UUID &uuid, const core::String &name, s
 		return InvalidNodeId;
 	}
 
-	const int voxelizeMode = core::Var::getSafe(cfg::VoxformatVoxelizeMode)->intVal();
+	const int voxelizeMode = _config.voxelizeMode;
 	const glm::ivec3 &vdim = region.getDimensionsInVoxels();
 	if (glm::any(glm::greaterThan(vdim, glm::ivec3(512)))) {
 		Log::warn("Large meshes will take a lot of time and use a lot of memory. Consider scaling the mesh! (%i:%i:%i)",
@@ -318,21 +387,20 @@ int MeshFormat::voxelizeNode(const core::UUID &uuid, const core::String &name, s
 	scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model, uuid);
 	node.setName(name);
 	palette::NormalPalette normalPalette;
-	const core::VarPtr &normalPaletteVar = core::Var::getSafe(cfg::NormalPalette);
-	if (!normalPalette.load(normalPaletteVar->strVal().c_str())) {
-		Log::debug("Failed to load normal palette %s - use redalert2 as default", normalPaletteVar->strVal().c_str());
+	if (!normalPalette.load(_config.normalPalette.c_str())) {
+		Log::debug("Failed to load normal palette %s - use redalert2 as default", _config.normalPalette.c_str());
 		normalPalette.redAlert2();
 	} else {
-		Log::debug("Loaded normal palette %s", normalPaletteVar->strVal().c_str());
+		Log::debug("Loaded normal palette %s", _config.normalPalette.c_str());
 	}
 	// TODO: VOXELFORMAT: auto generate the normal palette from the input tris?
 	node.setNormalPalette(normalPalette);
 
-	const bool fillHollow = core::Var::getSafe(cfg::VoxformatFillHollow)->boolVal();
+	const bool fillHollow = _config.fillHollow;
 	const int maxVoxels = vdim.x * vdim.y * vdim.z;
 	if (axisAligned) {
 		Log::debug("max voxels: %i (%i:%i:%i)", maxVoxels, vdim.x, vdim.y, vdim.z);
-		PosMap posMap(maxVoxels);
+		PosMap posMap;
 		transformTrisAxisAligned(region, tris, posMap, meshMaterialArray, normalPalette);
 		tris.release();
 		node.setVolume(new voxel::RawVolume(region), true);
@@ -340,7 +408,7 @@ int MeshFormat::voxelizeNode(const core::UUID &uuid, const core::String &name, s
 	} else if (voxelizeMode == VoxelizeMode::Fast) {
 		palette::Palette palette;
 
-		const bool shouldCreatePalette = core::Var::getSafe(cfg::VoxelCreatePalette)->boolVal();
+		const bool shouldCreatePalette = _config.createPalette;
 		if (shouldCreatePalette) {
 			palette::RGBAMaterialMap colorMaterials;
 			Log::debug("create palette");
@@ -397,57 +465,9 @@ int MeshFormat::voxelizeNode(const core::UUID &uuid, const core::String &name, s
 			voxelutil::fillHollow(wrapper, voxel);
 		}
 	} else {
-		const size_t parallel = app::for_parallel_size(0, tris.size());
-		Log::debug("Subdivide %i triangles (%i parallel)", (int)tris.size(), (int)parallel);
-		core::DynamicArray<MeshTriCollection> meshTriCollections;
-		meshTriCollections.resize(parallel);
-		core::AtomicInt currentIdx(0);
-		app::for_parallel(0, tris.size(), [&meshTriCollections, &tris, &currentIdx] (int start, int end) {
-			int c = currentIdx.increment();
-			MeshTriCollection &subdivided = meshTriCollections[c];
-			size_t estimateReserve = 0;
-			// cap per-triangle estimate to avoid pathological values (~1M)
-			const size_t maxPerTriangle = 1u << 20;
-			for (int i = start; i < end; ++i) {
-				const voxelformat::MeshTri &tri = tris[i];
-				estimateReserve += tri.subdivideTriCount(maxPerTriangle);
-			}
-			// Cap the total estimate to a reasonable upper bound to avoid huge single allocations
-			const size_t maxTotalReserve = (size_t)(end - start) * maxPerTriangle;
-			subdivided.reserve(glm::min(estimateReserve, maxTotalReserve));
-			for (int i = start; i < end; ++i) {
-				int depth = 0;
-				subdivideTri(tris[i], subdivided, depth);
-			}
-		});
-		Log::debug("Subdivision done");
-		tris.release();
-		size_t cnt = 0;
-		for (const MeshTriCollection &e : meshTriCollections) {
-			cnt += e.size();
-		}
-
-		MeshTriCollection subdivided;
-		subdivided.reserve(cnt);
-		for (MeshTriCollection &e : meshTriCollections) {
-			if (e.empty()) {
-				continue;
-			}
-			subdivided.append(core::move(e));
-			e.release();
-		}
-		meshTriCollections.release();
-
-		if (subdivided.empty()) {
-			Log::warn("Empty volume - could not subdivide");
-			return InvalidNodeId;
-		}
-
-		PosMap posMap(maxVoxels);
-		transformTris(region, subdivided, posMap, meshMaterialArray, normalPalette);
-		subdivided.release();
 		node.setVolume(new voxel::RawVolume(region), true);
-		voxelizeTris(node, posMap, meshMaterialArray, fillHollow);
+		voxelizeTrisBinned(node, tris, meshMaterialArray, normalPalette, fillHollow);
+		tris.release();
 	}
 
 	if (resetOrigin) {
@@ -484,22 +504,21 @@ void MeshFormat::voxelizeTris(scenegraph::SceneGraphNode &node, const PosMap &po
 		return;
 	}
 	palette::Palette palette;
-	const bool shouldCreatePalette = core::Var::getSafe(cfg::VoxelCreatePalette)->boolVal();
+	const bool shouldCreatePalette = _config.createPalette;
 	if (shouldCreatePalette) {
 		palette::RGBAMaterialMap colorMaterials;
 		Log::debug("create palette");
-		for (const auto &entry : posMap) {
-			if (stopExecution()) {
-				return;
-			}
-			const PosSampling &pos = entry->second;
+		posMap.visit([&](int, const PosSampling &pos) {
 			// TODO: PERF: don't do pos.getColor call twice
-			const color::RGBA rgba = pos.getColor(_flattenFactor, _weightedAverage);
+			const color::RGBA rgba = pos.getColor(_config.rgbFlattenFactor, _config.rgbWeightedAverage);
 			if (rgba.a <= AlphaThreshold) {
-				continue;
+				return;
 			}
 			MeshMaterialIndex materialIdx = pos.getMaterialIndex();
 			colorMaterials.put(rgba, materialIdx > 0 && materialIdx < (int)meshMaterialArray.size() ? &meshMaterialArray[materialIdx]->material : nullptr);
+		});
+		if (stopExecution()) {
+			return;
 		}
 		createPalette(colorMaterials, palette);
 	} else {
@@ -513,15 +532,11 @@ void MeshFormat::voxelizeTris(scenegraph::SceneGraphNode &node, const PosMap &po
 		if (stopExecution()) {
 			return;
 		}
-		const color::RGBA rgba = posSampling.getColor(_flattenFactor, _weightedAverage);
+		const color::RGBA rgba = posSampling.getColor(_config.rgbFlattenFactor, _config.rgbWeightedAverage);
 		if (rgba.a <= AlphaThreshold) {
 			return;
 		}
-		uint8_t colorIndex;
-		{
-			core::ScopedLock lock(_mutex);
-			colorIndex = palLookup.findClosestIndex(rgba);
-		}
+		const uint8_t colorIndex = palLookup.findClosestIndex(rgba);
 		const voxel::Voxel voxel = voxel::createVoxel(palette, colorIndex, posSampling.getNormal());
 		core_assert_always(volume->setVoxel(idx, voxel));
 	};
@@ -544,9 +559,247 @@ void MeshFormat::voxelizeTris(scenegraph::SceneGraphNode &node, const PosMap &po
 	}
 }
 
-MeshFormat::ChunkMeshExt::ChunkMeshExt(voxel::ChunkMesh *_mesh, const scenegraph::SceneGraphNode &node, bool _applyTransform)
-	: mesh(_mesh), name(node.name()), applyTransform(_applyTransform), size(node.region().getDimensionsInVoxels()),
-	  pivot(node.pivot()), nodeId(node.id()) {
+void MeshFormat::voxelizeTrisBinned(scenegraph::SceneGraphNode &node, const MeshTriCollection &tris,
+									const MeshMaterialArray &meshMaterialArray,
+									const palette::NormalPalette &normalPalette, bool fillHollow) const {
+	core_trace_scoped(VoxelizeTrisBinned);
+	voxel::RawVolume *volume = node.volume();
+	const voxel::Region &region = volume->region();
+	const glm::ivec3 &lower = region.getLowerCorner();
+	const glm::ivec3 &upper = region.getUpperCorner();
+	const glm::ivec3 bricks = (region.getDimensionsInVoxels() + VoxelizeBrickMask) >> VoxelizeBrickBits;
+	const size_t brickCount = (size_t)bricks.x * (size_t)bricks.y * (size_t)bricks.z;
+
+	auto voxelRange = [&lower, &upper](const voxelformat::MeshTri &meshTri, glm::ivec3 &mins, glm::ivec3 &maxs) {
+		mins = glm::clamp(glm::ivec3(glm::floor(meshTri.mins())), lower, upper);
+		maxs = glm::clamp(glm::ivec3(glm::floor(meshTri.maxs())), lower, upper);
+	};
+	// large triangles only end up in the bricks they are really intersecting
+	auto visitBricks = [&](const voxelformat::MeshTri &meshTri, auto &&func) {
+		glm::ivec3 mins, maxs;
+		voxelRange(meshTri, mins, maxs);
+		const glm::ivec3 brickMins = (mins - lower) >> VoxelizeBrickBits;
+		const glm::ivec3 brickMaxs = (maxs - lower) >> VoxelizeBrickBits;
+		const bool singleBrick = brickMins == brickMaxs;
+		const glm::vec3 halfSize(VoxelizeBrickSize / 2 + 0.01f);
+		for (int z = brickMins.z; z <= brickMaxs.z; ++z) {
+			for (int y = brickMins.y; y <= brickMaxs.y; ++y) {
+				for (int x = brickMins.x; x <= brickMaxs.x; ++x) {
+					if (!singleBrick) {
+						const glm::vec3 center =
+							glm::vec3(lower + glm::ivec3(x, y, z) * VoxelizeBrickSize) + (float)(VoxelizeBrickSize / 2);
+						if (!glm::intersectTriangleAABB(center, halfSize, meshTri.vertex0(), meshTri.vertex1(),
+														meshTri.vertex2())) {
+							continue;
+						}
+					}
+					func((size_t)x + (size_t)bricks.x * ((size_t)y + (size_t)bricks.y * (size_t)z));
+				}
+			}
+		}
+	};
+
+	// bin the triangle indices by brick - counting them first allows to put them into one flat buffer
+	core::Buffer<size_t> offsets;
+	offsets.resize(brickCount + 1);
+	const int triCount = (int)tris.size();
+	for (int i = 0; i < triCount; ++i) {
+		if (!(tris[i].area() > 0.0f)) {
+			continue;
+		}
+		visitBricks(tris[i], [&offsets](size_t brickIdx) { ++offsets[brickIdx + 1]; });
+	}
+	core::DynamicArray<size_t> brickIndices;
+	for (size_t i = 0; i < brickCount; ++i) {
+		if (offsets[i + 1] > 0u) {
+			brickIndices.push_back(i);
+		}
+		offsets[i + 1] += offsets[i];
+	}
+	if (brickIndices.empty()) {
+		Log::debug("Empty volume - no triangles with an area given");
+		return;
+	}
+	core::Buffer<int> binned;
+	binned.resize(offsets[brickCount]);
+	{
+		core::Buffer<size_t> cursor(offsets);
+		for (int i = 0; i < triCount; ++i) {
+			if (!(tris[i].area() > 0.0f)) {
+				continue;
+			}
+			visitBricks(tris[i], [&binned, &cursor, i](size_t brickIdx) { binned[cursor[brickIdx]++] = i; });
+		}
+	}
+	Log::debug("Binned %i triangles into %i bricks (%i entries)", triCount, (int)brickIndices.size(),
+			   (int)binned.size());
+
+	palette::NormalPaletteLookup normalLookup(normalPalette);
+	const uint8_t flattenFactor = _config.rgbFlattenFactor;
+	const bool weightedAverage = _config.rgbWeightedAverage;
+	// voxelizes the given range of bricks and calls the given function for every voxel of them
+	auto voxelizeBricks = [&](int start, int end, auto &&func) {
+		core::Buffer<PosSampling> samples;
+		samples.resize(VoxelizeBrickVoxels);
+		uint64_t occupied[VoxelizeBrickVoxels / 64];
+		for (int i = start; i < end; ++i) {
+			if (stopExecution()) {
+				return;
+			}
+			const size_t brickIdx = brickIndices[i];
+			const glm::ivec3 brick((int)(brickIdx % bricks.x), (int)((brickIdx / bricks.x) % bricks.y),
+								   (int)(brickIdx / ((size_t)bricks.x * (size_t)bricks.y)));
+			const glm::ivec3 brickMins = lower + brick * VoxelizeBrickSize;
+			const glm::ivec3 brickMaxs = glm::min(brickMins + VoxelizeBrickMask, upper);
+			core_memset(occupied, 0, sizeof(occupied));
+			for (size_t n = offsets[brickIdx]; n < offsets[brickIdx + 1]; ++n) {
+				const voxelformat::MeshTri &meshTri = tris[binned[n]];
+				glm::ivec3 mins, maxs;
+				voxelRange(meshTri, mins, maxs);
+				mins = glm::max(mins, brickMins);
+				maxs = glm::min(maxs, brickMaxs);
+
+				int normalIdx = normalLookup.getClosestMatch(meshTri.normal());
+				if (normalIdx == palette::PaletteNormalNotFound) {
+					normalIdx = NO_NORMAL;
+				}
+				// only visit the voxels along the dominant axis of the normal that the triangle plane is crossing
+				const glm::vec3 normal = glm::cross(meshTri.vertex1() - meshTri.vertex0(),
+													meshTri.vertex2() - meshTri.vertex0());
+				const glm::vec3 absNormal = glm::abs(normal);
+				int axis = 2;
+				if (absNormal.x >= absNormal.y && absNormal.x >= absNormal.z) {
+					axis = 0;
+				} else if (absNormal.y >= absNormal.z) {
+					axis = 1;
+				}
+				const int u = (axis + 1) % 3;
+				const int v = (axis + 2) % 3;
+				const float planeDist = glm::dot(normal, meshTri.vertex0());
+				glm::ivec3 pos;
+				for (pos[v] = mins[v]; pos[v] <= maxs[v]; ++pos[v]) {
+					for (pos[u] = mins[u]; pos[u] <= maxs[u]; ++pos[u]) {
+						float planeMin = FLT_MAX;
+						float planeMax = -FLT_MAX;
+						for (int corner = 0; corner < 4; ++corner) {
+							const float cu = (float)(pos[u] + (corner & 1));
+							const float cv = (float)(pos[v] + (corner >> 1));
+							const float d = (planeDist - normal[u] * cu - normal[v] * cv) / normal[axis];
+							planeMin = core_min(planeMin, d);
+							planeMax = core_max(planeMax, d);
+						}
+						const int from = (int)glm::clamp(glm::floor(planeMin), (float)mins[axis], (float)maxs[axis]);
+						const int to = (int)glm::clamp(glm::floor(planeMax), (float)mins[axis], (float)maxs[axis]);
+						for (pos[axis] = from; pos[axis] <= to; ++pos[axis]) {
+							float area;
+							glm::vec3 center;
+							if (!clipTriangle(meshTri, pos, area, center)) {
+								continue;
+							}
+							const uint32_t weight = (uint32_t)(area * 1000.0f);
+							if (weight == 0u) {
+								continue;
+							}
+							const color::RGBA rgba = sampleTriangle(meshTri, normal, meshMaterialArray, center);
+							if (rgba.a <= AlphaThreshold) {
+								continue;
+							}
+							const glm::ivec3 local = pos - brickMins;
+							const int idx = local.x | (local.y << VoxelizeBrickBits) | (local.z << (VoxelizeBrickBits * 2));
+							const uint64_t bit = 1ull << (idx % 64);
+							if (occupied[idx / 64] & bit) {
+								samples[idx].add(weight, rgba, normalIdx, meshTri.materialIdx);
+							} else {
+								samples[idx] = PosSampling(weight, rgba, normalIdx, meshTri.materialIdx);
+								occupied[idx / 64] |= bit;
+							}
+						}
+					}
+				}
+			}
+			for (int word = 0; word < lengthof(occupied); ++word) {
+				if (occupied[word] == 0u) {
+					continue;
+				}
+				for (int bit = 0; bit < 64; ++bit) {
+					if ((occupied[word] & (1ull << bit)) == 0u) {
+						continue;
+					}
+					const int idx = word * 64 + bit;
+					const PosSampling &posSampling = samples[idx];
+					const color::RGBA rgba = posSampling.getColor(flattenFactor, weightedAverage);
+					if (rgba.a <= AlphaThreshold) {
+						continue;
+					}
+					const glm::ivec3 pos(brickMins.x + (idx & VoxelizeBrickMask),
+										 brickMins.y + ((idx >> VoxelizeBrickBits) & VoxelizeBrickMask),
+										 brickMins.z + (idx >> (VoxelizeBrickBits * 2)));
+					func(pos, rgba, posSampling);
+				}
+			}
+		}
+	};
+
+	palette::Palette palette;
+	const bool shouldCreatePalette = _config.createPalette;
+	if (shouldCreatePalette) {
+		// the bricks are voxelized twice - once for the palette and once for the volume - to not keep all the
+		// sampled colors in memory until the palette is known
+		Log::debug("create palette");
+		palette::RGBAMaterialMap colorMaterials;
+		core_trace_mutex(core::Lock, lock, "VoxelizeTrisBinned");
+		app::for_parallel(0, (int)brickIndices.size(), [&](int start, int end) {
+			palette::RGBAMaterialMap brickColorMaterials;
+			voxelizeBricks(start, end, [&](const glm::ivec3 &, color::RGBA rgba, const PosSampling &posSampling) {
+				const MeshMaterialIndex materialIdx = posSampling.getMaterialIndex();
+				brickColorMaterials.put(rgba, materialIdx > 0 && materialIdx < (int)meshMaterialArray.size()
+												  ? &meshMaterialArray[materialIdx]->material
+												  : nullptr);
+			});
+			core::ScopedLock scopedLock(lock);
+			for (const auto &e : brickColorMaterials) {
+				colorMaterials.put(e->first, e->second);
+			}
+		});
+		if (stopExecution()) {
+			return;
+		}
+		createPalette(colorMaterials, palette);
+	} else {
+		palette = voxel::getPalette();
+	}
+
+	Log::debug("create voxels for %i bricks", (int)brickIndices.size());
+	palette::PaletteLookup palLookup(palette);
+	app::for_parallel(0, (int)brickIndices.size(), [&](int start, int end) {
+		// the bricks don't overlap - every voxel is only written by one thread
+		voxelizeBricks(start, end, [&](const glm::ivec3 &pos, color::RGBA rgba, const PosSampling &posSampling) {
+			const uint8_t colorIndex = palLookup.findClosestIndex(rgba);
+			volume->setVoxel(pos, voxel::createVoxel(palette, colorIndex, posSampling.getNormal()));
+		});
+	});
+	if (palette.colorCount() == 1) {
+		color::RGBA c = palette.color(0);
+		if (c.a == 0) {
+			c.a = 255;
+			palette.setColor(0, c);
+		}
+	}
+	node.setPalette(palette);
+	if (fillHollow) {
+		if (stopExecution()) {
+			return;
+		}
+		Log::debug("fill hollows");
+		const voxel::Voxel voxel = voxel::createVoxel(palette, FillColorIndex);
+		voxelutil::fillHollow(*volume, voxel);
+	}
+}
+
+MeshFormat::ChunkMeshExt::ChunkMeshExt(voxel::ChunkMesh *_mesh, const scenegraph::SceneGraph &sceneGraph,
+										const scenegraph::SceneGraphNode &node, bool _applyTransform)
+	: mesh(_mesh), name(node.name()), applyTransform(_applyTransform),
+	  size(sceneGraph.resolveRegion(node).getDimensionsInVoxels()), pivot(node.pivot()), nodeId(node.id()) {
 }
 
 void MeshFormat::ChunkMeshExt::visitByMaterial(
@@ -685,72 +938,56 @@ int MeshFormat::voxelizeMesh(const core::UUID &uuid, const core::String &name, s
 	return voxelizeNode(uuid, name, sceneGraph, core::move(tris), mesh.materials, parent, resetOrigin);
 }
 
-int MeshFormat::voxelizePointCloud(const core::String &filename, scenegraph::SceneGraph &sceneGraph,
-									PointCloud &&vertices) const {
-	glm::vec3 mins{std::numeric_limits<float>::max()};
-	glm::vec3 maxs{std::numeric_limits<float>::lowest()};
-	const glm::vec3 scale = getInputScale();
-	for (PointCloudVertex &v : vertices) {
-		v.position *= scale;
-		mins = glm::min(mins, v.position);
-		maxs = glm::max(maxs, v.position);
-	}
-	const int pointSize = core_max(1, core::Var::getSafe(cfg::VoxformatPointCloudSize)->intVal());
-	const voxel::Region region(glm::floor(mins), glm::ceil(maxs) + glm::vec3((float)(pointSize - 1)));
+PointCloudVoxelizer MeshFormat::pointCloudVoxelizer() const {
+	const size_t memoryBudget = (size_t)core_max(1, _config.pointCloudMemory) * 1024u * 1024u;
+	return PointCloudVoxelizer(voxel::getPalette(), getInputScale(), _config.pointCloudSize, memoryBudget);
+}
 
-	const size_t bytes = voxel::RawVolume::size(region);
-	if (!app::App::getInstance()->hasEnoughMemory(bytes)) {
-		const core::String &neededMem = core::string::humanSize(bytes);
-		Log::error("Not enough memory to create a volume of size %i:%i:%i (would need %s)", region.getDimensionsInVoxels().x,
-				  region.getDimensionsInVoxels().y, region.getDimensionsInVoxels().z, neededMem.c_str());
+int MeshFormat::voxelizePointCloud(const core::String &filename, scenegraph::SceneGraph &sceneGraph,
+								   PointCloudVoxelizer &voxelizer) const {
+	core::DynamicArray<voxel::RawVolume *> volumes;
+	if (!voxelizer.finish(volumes)) {
 		return InvalidNodeId;
 	}
+	const core::String &name = core::string::extractFilename(filename);
+	if (volumes.size() == 1) {
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(volumes[0], true);
+		node.setName(name);
+		node.setPalette(voxel::getPalette());
+		return sceneGraph.emplace(core::move(node));
+	}
+	// huge point clouds are split into chunk volumes
+	scenegraph::SceneGraphNode groupNode(scenegraph::SceneGraphNodeType::Group);
+	groupNode.setName(name);
+	const int groupNodeId = sceneGraph.emplace(core::move(groupNode));
+	for (size_t i = 0; i < volumes.size(); ++i) {
+		voxel::RawVolume *v = volumes[i];
+		if (groupNodeId == InvalidNodeId) {
+			delete v;
+			continue;
+		}
+		const glm::ivec3 &mins = v->region().getLowerCorner();
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(v, true);
+		node.setName(core::String::format("%s %i:%i:%i", name.c_str(), mins.x, mins.y, mins.z));
+		node.setPalette(voxel::getPalette());
+		sceneGraph.emplace(core::move(node), groupNodeId);
+	}
+	return groupNodeId;
+}
 
+int MeshFormat::voxelizePointCloud(const core::String &filename, scenegraph::SceneGraph &sceneGraph,
+								   PointCloud &&vertices) const {
 	simplifyPointCloud(vertices);
-
-	voxel::RawVolume *v = new voxel::RawVolume(region);
-	const palette::Palette &palette = voxel::getPalette();
-	palette::PaletteLookup palLookup(palette);
-	auto fn = [&vertices, &palLookup, &palette, pointSize, v](int start, int end) {
-		for (int i = start; i < end; ++i) {
-			if (stopExecution()) {
-				return;
-			}
-			const PointCloudVertex &vertex = vertices[i];
-			const glm::ivec3 pos = glm::round(vertex.position);
-			const voxel::Voxel voxel = voxel::createVoxel(palette, palLookup.findClosestIndex(vertex.color));
-			if (pointSize == 1) {
-				v->setVoxel(pos, voxel);
-				return;
-			}
-			voxel::RawVolume::Sampler sampler(v);
-			sampler.setPosition(pos);
-			for (int z = 0; z < pointSize; ++z) {
-				voxel::RawVolume::Sampler sampler2 = sampler;
-				for (int y = 0; y < pointSize; ++y) {
-					voxel::RawVolume::Sampler sampler3 = sampler2;
-					for (int x = 0; x < pointSize; ++x) {
-						sampler3.setVoxel(voxel);
-						sampler3.movePositiveX();
-					}
-					sampler2.movePositiveY();
-				}
-				sampler.movePositiveZ();
-			}
-		}
-	};
-	app::for_parallel(0, vertices.size(), fn);
+	PointCloudVoxelizer voxelizer = pointCloudVoxelizer();
+	voxelizer.add(vertices.data(), vertices.size());
 	vertices.release();
-
-	scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
-	node.setVolume(v, true);
-	node.setName(core::string::extractFilename(filename));
-	node.setPalette(palette);
-	return sceneGraph.emplace(core::move(node));
+	return voxelizePointCloud(filename, sceneGraph, voxelizer);
 }
 
 size_t MeshFormat::simplify(voxel::IndexArray &indices, const core::DynamicArray<MeshVertex> &vertices) const {
-	if (!core::Var::getSafe(cfg::VoxformatMeshSimplify)->boolVal()) {
+	if (!_config.meshSimplify) {
 		return indices.size();
 	}
 	voxel::IndexArray simplifiedIndices;
@@ -778,72 +1015,446 @@ bool MeshFormat::voxelizeGroups(const core::String &filename, const io::ArchiveP
 	return false;
 }
 
-bool MeshFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
-							const io::ArchivePtr &archive, const SaveContext &saveCtx) {
-	const bool quads = core::Var::getSafe(cfg::VoxformatQuads)->boolVal();
-	const bool withColor = core::Var::getSafe(cfg::VoxformatWithColor)->boolVal();
-	const bool withTexCoords = core::Var::getSafe(cfg::VoxformatWithtexcoords)->boolVal();
-	const voxel::SurfaceExtractionType type =
-		(voxel::SurfaceExtractionType)core::Var::getSafe(cfg::VoxelMeshMode)->intVal();
-
-	ChunkMeshes meshes;
-	meshes.resize(sceneGraph.nodes().size());
-	// TODO: VOXELFORMAT: this could get optimized by re-using the same mesh for multiple nodes (in case of reference
-	// nodes)
-	app::for_parallel(0, sceneGraph.nodes().size(), [&sceneGraph, type, &meshes] (int start, int end) {
-		const bool withNormals = core::Var::getSafe(cfg::VoxformatWithNormals)->boolVal();
-		const bool optimizeMesh = core::Var::getSafe(cfg::VoxformatOptimize)->boolVal();
-		const bool mergeQuads = core::Var::getSafe(cfg::VoxformatMergequads)->boolVal();
-		const bool reuseVertices = core::Var::getSafe(cfg::VoxformatReusevertices)->boolVal();
-		const bool ambientOcclusion = core::Var::getSafe(cfg::VoxformatAmbientocclusion)->boolVal();
-		const bool applyTransform = core::Var::getSafe(cfg::VoxformatTransform)->boolVal();
+static uint32_t volumeContentHash(const voxel::RawVolume &volume) {
+	const voxel::Region &region = volume.region();
+	const glm::ivec3 corners[2] = {region.getLowerCorner(), region.getUpperCorner()};
+	uint32_t hash = core::hash(corners, sizeof(corners));
+	const uint8_t *data = (const uint8_t *)volume.voxels();
+	size_t remaining = (size_t)region.voxels() * sizeof(voxel::Voxel);
+	while (remaining > 0) {
+		const size_t len = core_min(remaining, (size_t)INT32_MAX);
+		hash = core::hash(data, (int)len, hash);
+		data += len;
+		remaining -= len;
+	}
+	return hash;
+}
+
+static bool sameVolumeContent(const voxel::RawVolume &volume1, const voxel::RawVolume &volume2) {
+	if (&volume1 == &volume2) {
+		return true;
+	}
+	if (volume1.region() != volume2.region()) {
+		return false;
+	}
+	const size_t size = (size_t)volume1.region().voxels() * sizeof(voxel::Voxel);
+	return core_memcmp(volume1.voxels(), volume2.voxels(), size) == 0;
+}
+
+void MeshFormat::findMeshSources(const scenegraph::SceneGraph &sceneGraph, core::DynamicArray<int> &meshSources) {
+	const int n = (int)sceneGraph.nodes().size();
+	meshSources.resize(n);
+	core::DynamicArray<uint32_t> contentHashes;
+	contentHashes.resize(n);
+	app::for_parallel(0, n, [&sceneGraph, &meshSources, &contentHashes](int start, int end) {
 		for (int i = start; i < end; ++i) {
+			meshSources[i] = InvalidNodeId;
 			const scenegraph::SceneGraphNode &node = sceneGraph.node(i);
-			if (!node.isAnyModelNode()) {
-				continue;
+			if (node.isModelNode()) {
+				contentHashes[i] = volumeContentHash(*node.volume());
+			}
+		}
+	});
+
+	// model nodes with the same volume content and palette produce the same mesh
+	core::Map<uint32_t, core::DynamicArray<int>> uniqueNodes;
+	int duplicates = 0;
+	for (int i = 0; i < n; ++i) {
+		const scenegraph::SceneGraphNode &node = sceneGraph.node(i);
+		if (!node.isModelNode()) {
+			continue;
+		}
+		auto iter = uniqueNodes.find(contentHashes[i]);
+		if (iter == uniqueNodes.end()) {
+			core::DynamicArray<int> nodeIds;
+			nodeIds.push_back(i);
+			uniqueNodes.put(contentHashes[i], nodeIds);
+			continue;
+		}
+		for (int nodeId : iter->value) {
+			const scenegraph::SceneGraphNode &other = sceneGraph.node(nodeId);
+			if (other.palette().hash() == node.palette().hash() && sameVolumeContent(*other.volume(), *node.volume())) {
+				meshSources[i] = nodeId;
+				++duplicates;
+				break;
+			}
+		}
+		if (meshSources[i] == InvalidNodeId) {
+			iter->value.push_back(i);
+		}
+	}
+
+	// reference nodes re-use the mesh of the referenced model node - they only differ in the transform
+	for (int i = 0; i < n; ++i) {
+		const scenegraph::SceneGraphNode &node = sceneGraph.node(i);
+		if (!node.isReferenceNode()) {
+			continue;
+		}
+		const int referenceId = node.reference();
+		if (referenceId < 0 || referenceId >= n || !sceneGraph.hasNode(referenceId) ||
+			!sceneGraph.node(referenceId).isModelNode()) {
+			continue;
+		}
+		if (node.palette().hash() != sceneGraph.node(referenceId).palette().hash()) {
+			continue;
+		}
+		const int source = meshSources[referenceId];
+		meshSources[i] = source == InvalidNodeId ? referenceId : source;
+	}
+	Log::debug("Found %i model nodes with duplicated volumes", duplicates);
+}
+
+void MeshFormat::depthFirstNodeOrder(const scenegraph::SceneGraph &sceneGraph, core::DynamicArray<int> &nodeIds) {
+	nodeIds.reserve(sceneGraph.nodeSize());
+	core::DynamicArray<int> stack;
+	stack.push_back(sceneGraph.root().id());
+	while (!stack.empty()) {
+		const int nodeId = stack.back();
+		stack.pop();
+		nodeIds.push_back(nodeId);
+		const scenegraph::SceneGraphNodeChildren &children = sceneGraph.node(nodeId).children();
+		for (int i = (int)children.size() - 1; i >= 0; --i) {
+			stack.push_back(children[i]);
+		}
+	}
+}
+
+struct MeshFormat::ChunkMeshes::State {
+	enum class Status : uint8_t { Pending, Running, Done };
+	struct Entry {
+		ChunkMeshExt ext;
+		/** the extracted mesh - only for owners, the entries get the pointer assigned when they are accessed */
+		voxel::ChunkMesh *mesh = nullptr;
+		/** the index of the entry that owns the mesh - the own index if the mesh is not shared */
+		int owner = -1;
+		/** the amount of entries that were not yet released - only for owners */
+		int refs = 0;
+		Status status = Status::Pending;
+		/** the mesh was extracted by a background task and wasn't yet accessed */
+		bool ahead = false;
+	};
+	core_trace_mutex(core::Lock, lock, "ChunkMeshes");
+	core::ConditionVariable condition;
+	core::DynamicArray<Entry> entries;
+	/** the entry indices in the order the writer accesses them - the tasks extract the meshes in this order */
+	core::DynamicArray<int> order;
+	const scenegraph::SceneGraph *sceneGraph = nullptr;
+	voxel::SurfaceExtractionType type = voxel::SurfaceExtractionType::Cubic;
+	bool withNormals = false;
+	bool optimize = false;
+	bool mergeQuads = true;
+	bool reuseVertices = true;
+	bool ambientOcclusion = false;
+	int maxInFlight = 1;
+	/** scheduled tasks that didn't start yet */
+	int queued = 0;
+	/** meshes that are extracted or were extracted by the tasks but not yet accessed */
+	int ahead = 0;
+	/** owner entries that are not yet extracted */
+	int pending = 0;
+	/** entries that are currently extracted */
+	int running = 0;
+	/** no entry in @c order before this index is pending */
+	size_t cursor = 0;
+	int alive = 0;
+	int peak = 0;
+	bool abort = false;
+
+	voxel::ChunkMesh *extract(int idx) const;
+	void finish(int idx, voxel::ChunkMesh *mesh, bool ahead);
+	/**
+	 * @note The lock must be held - it's released while the surface is extracted
+	 */
+	void produce(int idx, bool ahead);
+	void fill(const core::SharedPtr<State> &self);
+};
+
+voxel::ChunkMesh *MeshFormat::ChunkMeshes::State::extract(int idx) const {
+	core_trace_scoped(ExtractMesh);
+	const scenegraph::SceneGraphNode &node = sceneGraph->node(entries[idx].ext.nodeId);
+	const voxel::RawVolume *volume = sceneGraph->resolveVolume(node);
+	voxel::ChunkMesh *mesh = new voxel::ChunkMesh();
+	voxel::Region regionExt = sceneGraph->resolveRegion(node);
+	// we are increasing the region by one voxel to ensure the inclusion of the boundary voxels in this mesh
+	regionExt.shiftUpperCorner(1, 1, 1);
+	voxel::SurfaceExtractionContext ctx = voxel::createContext(type, volume, regionExt, node.palette(), *mesh, {0, 0, 0},
+															 mergeQuads, reuseVertices, ambientOcclusion, optimize);
+	voxel::extractSurface(ctx);
+	if (withNormals) {
+		Log::debug("Calculate normals");
+		mesh->calculateNormals();
+	}
+	return mesh;
+}
+
+void MeshFormat::ChunkMeshes::State::finish(int idx, voxel::ChunkMesh *mesh, bool extractedAhead) {
+	Entry &entry = entries[idx];
+	entry.status = Status::Done;
+	--running;
+	if (entry.refs <= 0) {
+		// released while the surface was extracted
+		delete mesh;
+		if (extractedAhead) {
+			--ahead;
+		}
+	} else {
+		entry.mesh = mesh;
+		entry.ahead = extractedAhead;
+		++alive;
+		peak = core_max(peak, alive);
+	}
+	condition.notify_all();
+}
+
+void MeshFormat::ChunkMeshes::State::produce(int idx, bool extractedAhead) {
+	entries[idx].status = Status::Running;
+	--pending;
+	++running;
+	if (extractedAhead) {
+		++ahead;
+	}
+	lock.unlock();
+	voxel::ChunkMesh *mesh = extract(idx);
+	lock.lock();
+	finish(idx, mesh, extractedAhead);
+}
+
+void MeshFormat::ChunkMeshes::State::fill(const core::SharedPtr<State> &self) {
+	while (!abort && queued < pending && queued + ahead < maxInFlight) {
+		++queued;
+		app::schedule([self]() {
+			State &state = *self.get();
+			core::ScopedLock scopedLock(state.lock);
+			--state.queued;
+			if (state.abort) {
+				state.condition.notify_all();
+				return;
 			}
-			auto volume = sceneGraph.resolveVolume(node);
-			auto region = sceneGraph.resolveRegion(node);
-			voxel::ChunkMesh *mesh = new voxel::ChunkMesh();
-			voxel::Region regionExt = region;
-			// we are increasing the region by one voxel to ensure the inclusion of the boundary voxels in this mesh
-			regionExt.shiftUpperCorner(1, 1, 1);
-			voxel::SurfaceExtractionContext ctx = voxel::createContext(
-				type, volume, regionExt, node.palette(), *mesh, {0, 0, 0}, mergeQuads, reuseVertices, ambientOcclusion, optimizeMesh);
-			voxel::extractSurface(ctx);
-			if (withNormals) {
-				Log::debug("Calculate normals");
-				mesh->calculateNormals();
+			while (state.cursor < state.order.size() &&
+				   state.entries[state.order[state.cursor]].status != Status::Pending) {
+				++state.cursor;
 			}
+			if (state.cursor >= state.order.size()) {
+				return;
+			}
+			state.produce(state.order[state.cursor], true);
+		});
+	}
+}
 
-			meshes[i] = core::move(ChunkMeshExt(mesh, node, applyTransform));
+MeshFormat::ChunkMeshes::ChunkMeshes(const scenegraph::SceneGraph &sceneGraph, const FormatConfig &config,
+									 const core::DynamicArray<int> &accessOrder, int maxInFlight)
+	: _state(core::make_shared<State>()) {
+	State &state = *_state.get();
+	state.sceneGraph = &sceneGraph;
+	state.type = (voxel::SurfaceExtractionType)config.meshMode;
+	state.withNormals = config.withNormals;
+	state.optimize = config.optimize;
+	state.mergeQuads = config.mergeQuads;
+	state.reuseVertices = config.reuseVertices;
+	state.ambientOcclusion = config.ambientOcclusion;
+	state.maxInFlight = maxInFlight > 0 ? maxInFlight : core_max(1, app::App::getInstance()->threads());
+
+	// the node that owns the mesh for nodes that re-use the mesh of another node
+	core::DynamicArray<int> meshSources;
+	findMeshSources(sceneGraph, meshSources);
+	const int n = (int)sceneGraph.nodes().size();
+	core::DynamicArray<int> entryIndices;
+	entryIndices.resize(n);
+	core::DynamicArray<uint8_t> emptyVolumes;
+	emptyVolumes.resize(n);
+	app::for_parallel(0, n, [&sceneGraph, &meshSources, &emptyVolumes](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			emptyVolumes[i] = 1;
+			if (!sceneGraph.hasNode(i)) {
+				continue;
+			}
+			const scenegraph::SceneGraphNode &node = sceneGraph.node(i);
+			if (!node.isAnyModelNode() || meshSources[i] != InvalidNodeId) {
+				continue;
+			}
+			// a volume with at least one voxel always produces a surface
+			const voxel::RawVolume *volume = sceneGraph.resolveVolume(node);
+			emptyVolumes[i] = volume == nullptr || volume->isEmpty(sceneGraph.resolveRegion(node)) ? 1 : 0;
 		}
 	});
-	ChunkMeshes nonEmptyMeshes;
-	nonEmptyMeshes.reserve(meshes.size());
 
-	core::Map<int, int> meshIdxNodeMap;
-	// filter out empty meshes
-	for (auto iter = meshes.begin(); iter != meshes.end(); ++iter) {
-		if (!iter->mesh || iter->mesh->isEmpty()) {
+	const bool applyTransform = config.transform;
+	state.entries.reserve(n);
+	for (int i = 0; i < n; ++i) {
+		entryIndices[i] = -1;
+		if (!sceneGraph.hasNode(i)) {
+			continue;
+		}
+		const scenegraph::SceneGraphNode &node = sceneGraph.node(i);
+		if (!node.isAnyModelNode()) {
+			continue;
+		}
+		const int source = meshSources[i];
+		if (emptyVolumes[source == InvalidNodeId ? i : source]) {
 			continue;
 		}
-		nonEmptyMeshes.emplace_back(*iter);
-		meshIdxNodeMap.put(iter->nodeId, (int)nonEmptyMeshes.size() - 1);
+		State::Entry entry;
+		entry.ext = ChunkMeshExt(nullptr, sceneGraph, node, applyTransform);
+		entryIndices[i] = (int)state.entries.size();
+		state.entries.emplace_back(core::move(entry));
 	}
-	bool state;
-	if (nonEmptyMeshes.empty() && sceneGraph.empty(scenegraph::SceneGraphNodeType::Point)) {
-		Log::warn("Empty scene can't get saved as mesh");
-		state = false;
-	} else {
-		Log::debug("Save meshes");
-		state = saveMeshes(meshIdxNodeMap, sceneGraph, nonEmptyMeshes, filename, archive, {1.0f, 1.0f, 1.0f},
-						   type == voxel::SurfaceExtractionType::Cubic ? quads : false, withColor, withTexCoords);
+	for (size_t i = 0; i < state.entries.size(); ++i) {
+		State::Entry &entry = state.entries[i];
+		const int source = meshSources[entry.ext.nodeId];
+		if (source == InvalidNodeId) {
+			entry.owner = (int)i;
+			++state.pending;
+		} else {
+			entry.owner = entryIndices[source];
+			entry.ext.sharedMesh = true;
+			// the source was already extracted for the shared entries
+			entry.status = State::Status::Done;
+		}
+		++state.entries[entry.owner].refs;
+	}
+
+	// only the owners are extracted - the shared entries are resolved by accessing their owner
+	core::DynamicArray<uint8_t> ordered;
+	ordered.resize(state.entries.size());
+	state.order.reserve(state.pending);
+	for (int nodeId : accessOrder) {
+		if (nodeId < 0 || nodeId >= n || entryIndices[nodeId] == -1) {
+			continue;
+		}
+		const int owner = state.entries[entryIndices[nodeId]].owner;
+		if (!ordered[owner]) {
+			ordered[owner] = 1;
+			state.order.push_back(owner);
+		}
 	}
-	for (ChunkMeshExt &meshext : meshes) {
-		delete meshext.mesh;
+	for (size_t i = 0; i < state.entries.size(); ++i) {
+		if (state.entries[i].owner == (int)i && !ordered[i]) {
+			state.order.push_back((int)i);
+		}
+	}
+	core::ScopedLock scopedLock(state.lock);
+	state.fill(_state);
+}
+
+MeshFormat::ChunkMeshes::~ChunkMeshes() {
+	State &state = *_state.get();
+	core::ScopedLock scopedLock(state.lock);
+	state.abort = true;
+	// queued tasks keep the state alive and return without touching the scene graph
+	state.condition.wait(state.lock, [&state]() { return state.running == 0; });
+	for (State::Entry &entry : state.entries) {
+		delete entry.mesh;
+		entry.mesh = nullptr;
+		entry.ext.mesh = nullptr;
+	}
+}
+
+size_t MeshFormat::ChunkMeshes::size() const {
+	return _state->entries.size();
+}
+
+bool MeshFormat::ChunkMeshes::empty() const {
+	return _state->entries.empty();
+}
+
+const MeshFormat::ChunkMeshExt &MeshFormat::ChunkMeshes::operator[](size_t idx) const {
+	State &state = *_state.get();
+	core::ScopedLock scopedLock(state.lock);
+	State::Entry &entry = state.entries[idx];
+	State::Entry &owner = state.entries[entry.owner];
+	if (owner.status == State::Status::Pending) {
+		// not yet picked up by a task - don't wait for it
+		state.produce(entry.owner, false);
+	} else if (owner.status == State::Status::Running) {
+		state.condition.wait(state.lock, [&owner]() { return owner.status == State::Status::Done; });
 	}
-	return state;
+	core_assert_msg(owner.refs > 0, "Accessing the released mesh of node %i", entry.ext.nodeId);
+	if (owner.ahead) {
+		owner.ahead = false;
+		--state.ahead;
+	}
+	entry.ext.mesh = owner.mesh;
+	state.fill(_state);
+	return entry.ext;
+}
+
+void MeshFormat::ChunkMeshes::release(size_t idx) const {
+	State &state = *_state.get();
+	core::ScopedLock scopedLock(state.lock);
+	State::Entry &entry = state.entries[idx];
+	State::Entry &owner = state.entries[entry.owner];
+	entry.ext.mesh = nullptr;
+	if (owner.refs <= 0) {
+		return;
+	}
+	if (--owner.refs > 0) {
+		return;
+	}
+	if (owner.status == State::Status::Pending) {
+		// never accessed - no need to extract it anymore
+		owner.status = State::Status::Done;
+		--state.pending;
+	} else if (owner.status == State::Status::Done) {
+		delete owner.mesh;
+		owner.mesh = nullptr;
+		--state.alive;
+	}
+	// the running extraction frees its slot once it's finished
+	if (owner.ahead) {
+		owner.ahead = false;
+		--state.ahead;
+	}
+	state.fill(_state);
+}
+
+const MeshFormat::ChunkMeshExt &MeshFormat::ChunkMeshes::properties(size_t idx) const {
+	return _state->entries[idx].ext;
+}
+
+int MeshFormat::ChunkMeshes::owner(size_t idx) const {
+	return _state->entries[idx].owner;
+}
+
+void MeshFormat::ChunkMeshes::nodeMap(core::Map<int, int> &meshIdxNodeMap) const {
+	for (size_t i = 0; i < _state->entries.size(); ++i) {
+		meshIdxNodeMap.put(_state->entries[i].ext.nodeId, (int)i);
+	}
+}
+
+int MeshFormat::ChunkMeshes::maxInFlight() const {
+	return _state->maxInFlight;
+}
+
+int MeshFormat::ChunkMeshes::peakMeshes() const {
+	core::ScopedLock scopedLock(_state->lock);
+	return _state->peak;
+}
+
+int MeshFormat::ChunkMeshes::aheadMeshes() const {
+	core::ScopedLock scopedLock(_state->lock);
+	return _state->ahead;
+}
+
+bool MeshFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
+							const io::ArchivePtr &archive, const SaveContext &saveCtx) {
+	const FormatConfig &config = saveCtx.config;
+	const voxel::SurfaceExtractionType type = (voxel::SurfaceExtractionType)config.meshMode;
+
+	// the surfaces are extracted in the background in the order the writer consumes them
+	core::DynamicArray<int> accessOrder;
+	meshAccessOrder(sceneGraph, accessOrder);
+	ChunkMeshes meshes(sceneGraph, config, accessOrder);
+	if (meshes.empty() && sceneGraph.empty(scenegraph::SceneGraphNodeType::Point)) {
+		Log::warn("Empty scene can't get saved as mesh");
+		return false;
+	}
+	core::Map<int, int> meshIdxNodeMap;
+	meshes.nodeMap(meshIdxNodeMap);
+	Log::debug("Save meshes");
+	const bool quads = type == voxel::SurfaceExtractionType::Cubic ? config.quads : false;
+	return saveMeshes(meshIdxNodeMap, sceneGraph, meshes, filename, archive, {1.0f, 1.0f, 1.0f}, quads,
+					  config.withColor, config.withTexCoords);
 }
 
 } // namespace voxelformat
@@ -7,11 +7,12 @@
 #include "MeshTri.h"
 #include "PosSampling.h"
 #include "core/Common.h"
+#include "core/SharedPtr.h"
 #include "core/Trace.h"
 #include "core/UUID.h"
 #include "core/collection/DynamicArray.h"
-#include "core/collection/ParallelMap.h"
-#include "core/concurrent/Lock.h"
+#include "core/collection/Map.h"
+#include "core/collection/ParallelHashMap.h"
 #include "io/Archive.h"
 #include "palette/NormalPalette.h"
 #include "voxel/ChunkMesh.h"
@@ -19,16 +20,12 @@
 #include "voxelformat/Format.h"
 #include "voxelformat/private/mesh/Mesh.h"
 #include "voxelformat/private/mesh/MeshMaterial.h"
+#include "voxelformat/private/mesh/PointCloudVoxelizer.h"
 
 namespace voxelformat {
 
-struct PointCloudVertex {
-	glm::vec3 position{0.0f};
-	color::RGBA color{0, 0, 0, 255};
-};
-using PointCloud = core::Buffer<PointCloudVertex, 4096>;
 using MeshTriCollection = core::DynamicArray<voxelformat::MeshTri>;
-using PosMap = core::ParallelMap<int, PosSampling, 3541>;
+using PosMap = core::ParallelHashMap<int, PosSampling>;
 
 /**
  * @brief Convert the volume data into a mesh
@@ -40,10 +37,6 @@ class MeshFormat : public Format {
 public:
 	static constexpr const uint8_t FillColorIndex = 2;
 
-	/**
-	 * Subdivide until we brought the triangles down to the size of 1 or smaller
-	 */
-	static bool subdivideTri(const voxelformat::MeshTri &meshTri, MeshTriCollection &tinyTris, int &depth);
 	static bool calculateAABB(const MeshTriCollection &tris, glm::vec3 &mins, glm::vec3 &maxs);
 	/**
 	 * @brief Checks whether the given triangles are axis aligned - usually true for voxel meshes
@@ -75,18 +68,20 @@ private:
 					 MeshTriCollection &&tris, const MeshMaterialArray &meshMaterialArray, int parent = 0,
 					 bool resetOrigin = true) const;
 protected:
-	/**
-	 * @brief Color flatten factor - see @c PosSampling::getColor()
-	 */
-	bool _weightedAverage = true;
-	core_trace_mutex(core::Lock, _mutex, "PosSampling");
-
 	struct ChunkMeshExt {
 		ChunkMeshExt() = default;
-		ChunkMeshExt(voxel::ChunkMesh *mesh, const scenegraph::SceneGraphNode &node, bool applyTransform);
-		voxel::ChunkMesh *mesh;
+		ChunkMeshExt(voxel::ChunkMesh *mesh, const scenegraph::SceneGraph &sceneGraph,
+					 const scenegraph::SceneGraphNode &node, bool applyTransform);
+		/**
+		 * @note Reference nodes share the mesh of the referenced model node - see @c sharedMesh
+		 */
+		voxel::ChunkMesh *mesh = nullptr;
 		core::String name;
 		bool applyTransform = false;
+		/**
+		 * @brief The mesh is owned by the ChunkMeshExt instance of another node
+		 */
+		bool sharedMesh = false;
 
 		glm::vec3 size{0.0f};
 		glm::vec3 pivot{0.0f};
@@ -95,14 +90,147 @@ protected:
 		void visitByMaterial(int materialIndex, const std::function<void(const voxel::Mesh &, voxel::IndexType,
 																		voxel::IndexType, voxel::IndexType)> &callback) const;
 	};
-	using ChunkMeshes = core::DynamicArray<ChunkMeshExt>;
+	/**
+	 * @brief The meshes of the model nodes that are handed to @c saveMeshes()
+	 *
+	 * The surfaces are extracted in parallel in the background in the order the writer accesses the meshes. Only a
+	 * bounded amount of meshes is extracted ahead of the writer - accessing a mesh blocks until it is available.
+	 * Writers that only need a mesh once should call @c release() after the mesh was written - this keeps the peak
+	 * memory at a small multiple of the largest mesh instead of holding the meshes of the whole scene.
+	 *
+	 * Model nodes with identical content and reference nodes share the mesh of one node (see @c
+	 * ChunkMeshExt::sharedMesh). Model nodes without voxels are not part of the collection.
+	 */
+	class ChunkMeshes {
+	public:
+		struct State;
+
+		class Iterator {
+		private:
+			const ChunkMeshes *_meshes;
+			size_t _idx;
+
+		public:
+			Iterator(const ChunkMeshes *meshes, size_t idx) : _meshes(meshes), _idx(idx) {
+			}
+			inline const ChunkMeshExt &operator*() const {
+				return (*_meshes)[_idx];
+			}
+			inline const ChunkMeshExt *operator->() const {
+				return &(*_meshes)[_idx];
+			}
+			inline Iterator &operator++() {
+				++_idx;
+				return *this;
+			}
+			inline bool operator!=(const Iterator &rhs) const {
+				return _idx != rhs._idx;
+			}
+			inline bool operator==(const Iterator &rhs) const {
+				return _idx == rhs._idx;
+			}
+		};
+
+	private:
+		core::SharedPtr<State> _state;
+
+	public:
+		/**
+		 * @param accessOrder The node ids in the order the writer accesses their meshes - the surfaces are extracted
+		 * in this order. Nodes that are not part of it are extracted afterwards in node id order.
+		 * @param maxInFlight The max amount of meshes that are extracted ahead of the writer - @c 0 uses the amount
+		 * of threads
+		 */
+		ChunkMeshes(const scenegraph::SceneGraph &sceneGraph, const FormatConfig &config,
+					const core::DynamicArray<int> &accessOrder = {}, int maxInFlight = 0);
+		~ChunkMeshes();
+		ChunkMeshes(const ChunkMeshes &) = delete;
+		ChunkMeshes &operator=(const ChunkMeshes &) = delete;
+
+		size_t size() const;
+		bool empty() const;
+		/**
+		 * @brief Blocks until the surface of the given mesh was extracted
+		 */
+		const ChunkMeshExt &operator[](size_t idx) const;
+		/**
+		 * @brief Tell the collection that the writer doesn't need the mesh anymore - the mesh is deleted as soon as
+		 * all nodes that share it are released
+		 * @note The mesh must not get accessed anymore after calling this
+		 */
+		void release(size_t idx) const;
+		/**
+		 * @brief The node properties of the given entry - this doesn't wait for the surface extraction and the @c
+		 * mesh member must not be used
+		 */
+		const ChunkMeshExt &properties(size_t idx) const;
+		/**
+		 * @return The index of the entry that owns the mesh - entries with the same owner share the same mesh
+		 */
+		int owner(size_t idx) const;
+		/**
+		 * @brief Maps the node ids to the mesh indices
+		 */
+		void nodeMap(core::Map<int, int> &meshIdxNodeMap) const;
+
+		/**
+		 * @brief The max amount of meshes that are extracted ahead of the writer
+		 */
+		int maxInFlight() const;
+		/**
+		 * @brief The max amount of meshes that were alive at the same time
+		 */
+		int peakMeshes() const;
+		/**
+		 * @brief The amount of meshes that are extracted or were extracted ahead of the writer and weren't yet
+		 * accessed or released
+		 */
+		int aheadMeshes() const;
+
+		inline Iterator begin() const {
+			return Iterator(this, 0);
+		}
+		inline Iterator end() const {
+			return Iterator(this, size());
+		}
+	};
 	virtual bool saveMeshes(const core::Map<int, int> &meshIdxNodeMap, const scenegraph::SceneGraph &sceneGraph,
 							const ChunkMeshes &meshes, const core::String &filename, const io::ArchivePtr &archive,
 							const glm::vec3 &scale = glm::vec3(1.0f), bool quad = false, bool withColor = true,
 							bool withTexCoords = true) = 0;
+	/**
+	 * @brief The order in which @c saveMeshes() accesses the meshes - the surfaces are extracted in this order
+	 * @param[out] nodeIds The node ids in access order - stays empty for writers that access the meshes in node id
+	 * order
+	 * @sa depthFirstNodeOrder()
+	 */
+	virtual void meshAccessOrder(const scenegraph::SceneGraph &sceneGraph, core::DynamicArray<int> &nodeIds) const {
+	}
+	/**
+	 * @brief Collects the node ids in pre-order depth first order of the scene graph - starting at the root node
+	 */
+	static void depthFirstNodeOrder(const scenegraph::SceneGraph &sceneGraph, core::DynamicArray<int> &nodeIds);
 
-	static ChunkMeshExt *getParent(const scenegraph::SceneGraph &sceneGraph, ChunkMeshes &meshes, int nodeId);
-	static glm::vec3 getInputScale();
+	/**
+	 * @brief Finds the nodes that can re-use the mesh of another node. These are model nodes with the same volume
+	 * content and palette as another model node and reference nodes.
+	 * @param[out] meshSources The node id of the node whose mesh is re-used - or @c InvalidNodeId if the node needs
+	 * its own mesh. Indexed by the node id.
+	 */
+	static void findMeshSources(const scenegraph::SceneGraph &sceneGraph, core::DynamicArray<int> &meshSources);
+	glm::vec3 getInputScale() const;
+
+	/**
+	 * @brief Serializes the elements in parallel chunks and writes the chunks in order to the given stream
+	 * @param[in] func Writes the elements of the range [start, end) into the given chunk stream
+	 */
+	static bool writeChunksParallel(io::WriteStream &stream, int elements,
+									const std::function<void(int start, int end, io::WriteStream &chunk)> &func);
+	/**
+	 * @brief Writes the number as text like @c printf("%.*f") does - see @c core::string::formatFloat()
+	 */
+	static void writeFloatText(io::WriteStream &stream, float value, int decimals = 6);
+	static void writeIntText(io::WriteStream &stream, int64_t value);
 
 	/**
 	 * @brief Voxelizes the input mesh
@@ -128,6 +256,18 @@ protected:
 	 */
 	int voxelizePointCloud(const core::String &filename, scenegraph::SceneGraph &sceneGraph,
 						   PointCloud &&vertices) const;
+	/**
+	 * @brief Adds the volumes of a point cloud that was streamed into the given voxelizer to the scene graph
+	 * @return The id of the model node - or the id of the group node with one model node per chunk if the point cloud
+	 * was split into several chunk volumes. @c InvalidNodeId if the voxelization failed.
+	 * @sa pointCloudVoxelizer()
+	 */
+	int voxelizePointCloud(const core::String &filename, scenegraph::SceneGraph &sceneGraph,
+						   PointCloudVoxelizer &voxelizer) const;
+	/**
+	 * @return A voxelizer for point clouds that uses the scale, the point size and the memory budget of the config
+	 */
+	PointCloudVoxelizer pointCloudVoxelizer() const;
 	void convertToScaledTris(MeshTriCollection &tris, const core::DynamicArray<MeshVertex> &vertices,
 							 voxel::IndexArray &indices) const;
 	void triangulatePolygons(const core::DynamicArray<voxel::IndexArray> &polygons,
@@ -153,22 +293,27 @@ protected:
 					 MeshMaterialIndex material) const;
 
 	/**
-	 * @brief Convert the given input triangles into a list of positions to place the voxels at
+	 * @brief Voxelizes the given triangles into the volume of the node
+	 *
+	 * The triangles are binned into bricks of voxels and every brick is voxelized on its own. The part of a triangle
+	 * that is inside of a voxel is computed by clipping the triangle against the voxel box - the area of this
+	 * polygon is the weight of the color that is sampled at its center. Compared to subdividing the triangles, the
+	 * memory needed in addition to the volume only depends on the amount of triangles - and not on their size.
 	 *
 	 * @param[in] tris The triangles to voxelize
-	 * @param[out] posMap The PosMap instance to fill with positions and colors
-	 * @sa transformTrisAxisAligned()
+	 * @param[in] fillHollow Fill the inner parts of a voxel volume
+	 * @param[out] node The node with the volume to put the voxels into
 	 * @sa voxelizeTris()
 	 */
-	void transformTris(const voxel::Region &region, const MeshTriCollection &tris, PosMap &posMap,
-					   const MeshMaterialArray &meshMaterialArray, const palette::NormalPalette &normalPalette) const;
+	void voxelizeTrisBinned(scenegraph::SceneGraphNode &node, const MeshTriCollection &tris,
+							const MeshMaterialArray &meshMaterialArray,
+							const palette::NormalPalette &normalPalette, bool fillHollow) const;
 	/**
 	 * @brief Convert the given input triangles into a list of positions to place the voxels at. This version is for
 	 * aligned aligned triangles. This is usually the case for meshes that were exported from voxels.
 	 *
 	 * @param[in] tris The triangles to voxelize
 	 * @param[out] posMap The @c PosMap instance to fill with positions and colors
-	 * @sa transformTris()
 	 * @sa voxelizeTris()
 	 */
 	void transformTrisAxisAligned(const voxel::Region &region, const MeshTriCollection &tris, PosMap &posMap,
@@ -177,7 +322,7 @@ protected:
 	/**
 	 * @brief Convert the given @c PosMap into a volume
 	 *
-	 * @note The @c PosMap values can get calculated by @c transformTris() or @c transformTrisAxisAligned()
+	 * @note The @c PosMap values can get calculated by @c transformTrisAxisAligned()
 	 * @param[in] posMap The @c PosMap values with voxel positions and colors
 	 * @param[in] fillHollow Fill the inner parts of a voxel volume
 	 * @param[out] node The node to create the volume in
@@ -185,7 +330,6 @@ protected:
 	void voxelizeTris(scenegraph::SceneGraphNode &node, const PosMap &posMap, const MeshMaterialArray &meshMaterialArray, bool fillHollow) const;
 
 public:
-	MeshFormat();
 	bool loadGroups(const core::String &filename, const io::ArchivePtr &archive, scenegraph::SceneGraph &sceneGraph,
 					const LoadContext &ctx) override;
 	bool saveGroups(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
@@ -32,14 +32,6 @@ public:
 	const glm::vec2 &uv1() const;
 	const glm::vec2 &uv2() const;
 
-	float maxSideLength() const;
-	/**
-	 * Estimate reserve size: each subdivision splits a triangle into 4.
-	 * We need d subdivisions where longest_side * (0.5^d) <= 1 => d = ceil(log2(longest_side)).
-	 * The number of triangles produced per original triangle is 4^d.
-	 */
-	int subdivideTriCount(size_t maxPerTriangle) const;
-
 	/**
 	 * @return @c false if the given position is not within the triangle area. The value of uv should not be used in
 	 * this case.
@@ -60,28 +52,6 @@ inline const glm::vec2 &MeshTri::uv2() const {
 	return _uv[2];
 }
 
-// Sierpinski gasket with keeping the middle
-template<class MESHTRI>
-inline void subdivide(const MESHTRI &in, MESHTRI out[4]) {
-	const glm::vec3 midv[]{glm::mix(in.vertex0(), in.vertex1(), 0.5f), glm::mix(in.vertex1(), in.vertex2(), 0.5f),
-						   glm::mix(in.vertex2(), in.vertex0(), 0.5f)};
-	const glm::vec2 miduv[]{glm::mix(in.uv0(), in.uv1(), 0.5f), glm::mix(in.uv1(), in.uv2(), 0.5f),
-							glm::mix(in.uv2(), in.uv0(), 0.5f)};
-	const color::RGBA midc[]{color::RGBA::mix(in.color0(), in.color1()), color::RGBA::mix(in.color1(), in.color2()),
-							color::RGBA::mix(in.color2(), in.color0())};
-
-	// the subdivided new three triangles
-	out[0] = MESHTRI{
-		{in.vertex0(), midv[0], midv[2]}, {in.uv0(), miduv[0], miduv[2]}, in.materialIdx, {in.color0(), midc[0], midc[2]}};
-	out[1] = MESHTRI{
-		{in.vertex1(), midv[1], midv[0]}, {in.uv1(), miduv[1], miduv[0]}, in.materialIdx, {in.color1(), midc[1], midc[0]}};
-	out[2] = MESHTRI{
-		{in.vertex2(), midv[2], midv[1]}, {in.uv2(), miduv[2], miduv[1]}, in.materialIdx, {in.color2(), midc[2], midc[1]}};
-	// keep the middle
-	out[3] =
-		MESHTRI{{midv[0], midv[1], midv[2]}, {miduv[0], miduv[1], miduv[2]}, in.materialIdx, {midc[0], midc[1], midc[2]}};
-}
-
 inline color::RGBA colorAt(const MeshTri &tri, const MeshMaterialArray &meshMaterialArray, const glm::vec2 &uv, bool originUpperLeft = false) {
 	MeshMaterial* material;
 	if (tri.materialIdx >= 0 && tri.materialIdx < (int)meshMaterialArray.size()) {
@@ -123,7 +123,8 @@ bool OBJFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 
 	int idxOffset = 0;
 	int texcoordOffset = 0;
-	for (const auto &meshExt : meshes) {
+	for (size_t meshIdx = 0; meshIdx < meshes.size(); ++meshIdx) {
+		const ChunkMeshExt &meshExt = meshes[meshIdx];
 		for (int i = 0; i < voxel::ChunkMesh::Meshes; ++i) {
 			const voxel::Mesh *mesh = &meshExt.mesh->mesh[i];
 			if (mesh->isEmpty()) {
@@ -159,105 +160,98 @@ bool OBJFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 				return false;
 			}
 
-			for (int j = 0; j < nv; ++j) {
-				const voxel::VoxelVertex &v = vertices[j];
+			auto writeVertices = [&](int start, int end, io::WriteStream &chunk) {
+				for (int j = start; j < end; ++j) {
+					const voxel::VoxelVertex &v = vertices[j];
 
-				glm::vec3 pos;
-				if (meshExt.applyTransform) {
-					pos = transform.apply(v.position, meshExt.pivot * meshExt.size);
-				} else {
-					pos = v.position;
-				}
-				pos *= scale;
-				stream->writeStringFormat(false, "v %.04f %.04f %.04f", pos.x, pos.y, pos.z);
-				if (withColor) {
-					const glm::vec4 &color = color::fromRGBA(palette.color(v.colorIndex));
-					stream->writeStringFormat(false, " %.03f %.03f %.03f", color.r, color.g, color.b);
+					glm::vec3 pos;
+					if (meshExt.applyTransform) {
+						pos = transform.apply(v.position, meshExt.pivot * meshExt.size);
+					} else {
+						pos = v.position;
+					}
+					pos *= scale;
+					chunk.writeUInt8('v');
+					for (int k = 0; k < 3; ++k) {
+						chunk.writeUInt8(' ');
+						writeFloatText(chunk, pos[k], 4);
+					}
+					if (withColor) {
+						const glm::vec4 &color = color::fromRGBA(palette.color(v.colorIndex));
+						for (int k = 0; k < 3; ++k) {
+							chunk.writeUInt8(' ');
+							writeFloatText(chunk, color[k], 3);
+						}
+					}
+					chunk.writeUInt8('\n');
 				}
-				wrapBool(stream->writeStringFormat(false, "\n"))
-			}
+			};
+			wrapBool(writeChunksParallel(*stream, nv, writeVertices))
 			if (withNormals) {
-				for (int j = 0; j < nv; ++j) {
-					const glm::vec3 &norm = normals[j];
-					stream->writeStringFormat(false, "vn %.04f %.04f %.04f\n", norm.x, norm.y, norm.z);
-				}
+				auto writeNormals = [&](int start, int end, io::WriteStream &chunk) {
+					for (int j = start; j < end; ++j) {
+						const glm::vec3 &norm = normals[j];
+						chunk.writeUInt8('v');
+						chunk.writeUInt8('n');
+						for (int k = 0; k < 3; ++k) {
+							chunk.writeUInt8(' ');
+							writeFloatText(chunk, norm[k], 4);
+						}
+						chunk.writeUInt8('\n');
+					}
+				};
+				wrapBool(writeChunksParallel(*stream, nv, writeNormals))
 			}
 
-			if (quad) {
-				if (withTexCoords) {
-					for (int j = 0; j < ni; j += 6) {
-						const voxel::VoxelVertex &v = vertices[indices[j]];
+			// the quads are built from two triangles - the fourth index is the last one of the second triangle
+			static const int quadIndices[] = {0, 1, 2, 5};
+			const int indicesPerFace = quad ? 6 : 3;
+			const int cornersPerFace = quad ? 4 : 3;
+			const int faces = ni / indicesPerFace;
+			if (withTexCoords) {
+				// every corner gets its own texture coordinate
+				auto writeTexCoords = [&](int start, int end, io::WriteStream &chunk) {
+					for (int face = start; face < end; ++face) {
+						const voxel::VoxelVertex &v = vertices[indices[face * indicesPerFace]];
 						const glm::vec2 &uv = paletteUV(v.colorIndex);
-						stream->writeStringFormat(false, "vt %f %f\n", uv.x, uv.y);
-						stream->writeStringFormat(false, "vt %f %f\n", uv.x, uv.y);
-						stream->writeStringFormat(false, "vt %f %f\n", uv.x, uv.y);
-						stream->writeStringFormat(false, "vt %f %f\n", uv.x, uv.y);
-					}
-				}
-
-				int uvi = texcoordOffset;
-				for (int j = 0; j < ni - 5; j += 6, uvi += 4) {
-					const uint32_t one = idxOffset + indices[j + 0] + 1;
-					const uint32_t two = idxOffset + indices[j + 1] + 1;
-					const uint32_t three = idxOffset + indices[j + 2] + 1;
-					const uint32_t four = idxOffset + indices[j + 5] + 1;
-					if (withTexCoords) {
-						if (withNormals) {
-							stream->writeStringFormat(false, "f %i/%i/%i %i/%i/%i %i/%i/%i %i/%i/%i\n", (int)one,
-													  uvi + 1, (int)one, (int)two, uvi + 2, (int)two, (int)three,
-													  uvi + 3, (int)three, (int)four, uvi + 4, (int)four);
-						} else {
-							stream->writeStringFormat(false, "f %i/%i %i/%i %i/%i %i/%i\n", (int)one, uvi + 1, (int)two,
-													  uvi + 2, (int)three, uvi + 3, (int)four, uvi + 4);
-						}
-					} else {
-						if (withNormals) {
-							stream->writeStringFormat(false, "f %i//%i %i//%i %i//%i %i//%i\n", (int)one, (int)two,
-													  (int)three, (int)four, (int)one, (int)two, (int)three, (int)four);
-						} else {
-							stream->writeStringFormat(false, "f %i %i %i %i\n", (int)one, (int)two, (int)three,
-													  (int)four);
+						for (int k = 0; k < cornersPerFace; ++k) {
+							chunk.writeUInt8('v');
+							chunk.writeUInt8('t');
+							chunk.writeUInt8(' ');
+							writeFloatText(chunk, uv.x);
+							chunk.writeUInt8(' ');
+							writeFloatText(chunk, uv.y);
+							chunk.writeUInt8('\n');
 						}
 					}
-				}
-				texcoordOffset += ni / 6 * 4;
-			} else {
-				if (withTexCoords) {
-					for (int j = 0; j < ni; j += 3) {
-						const voxel::VoxelVertex &v = vertices[indices[j]];
-						const glm::vec2 &uv = paletteUV(v.colorIndex);
-						stream->writeStringFormat(false, "vt %f %f\n", uv.x, uv.y);
-						stream->writeStringFormat(false, "vt %f %f\n", uv.x, uv.y);
-						stream->writeStringFormat(false, "vt %f %f\n", uv.x, uv.y);
-					}
-				}
+				};
+				wrapBool(writeChunksParallel(*stream, faces, writeTexCoords))
+			}
 
-				for (int j = 0; j < ni; j += 3) {
-					const uint32_t one = idxOffset + indices[j + 0] + 1;
-					const uint32_t two = idxOffset + indices[j + 1] + 1;
-					const uint32_t three = idxOffset + indices[j + 2] + 1;
-					if (withTexCoords) {
-						if (withNormals) {
-							stream->writeStringFormat(false, "f %i/%i/%i %i/%i/%i %i/%i/%i\n", (int)one,
-													  texcoordOffset + j + 1, (int)one, (int)two,
-													  texcoordOffset + j + 2, (int)two, (int)three,
-													  texcoordOffset + j + 3, (int)three);
-						} else {
-							stream->writeStringFormat(false, "f %i/%i %i/%i %i/%i\n", (int)one, texcoordOffset + j + 1,
-													  (int)two, texcoordOffset + j + 2, (int)three,
-													  texcoordOffset + j + 3);
+			auto writeFaces = [&](int start, int end, io::WriteStream &chunk) {
+				for (int face = start; face < end; ++face) {
+					chunk.writeUInt8('f');
+					for (int k = 0; k < cornersPerFace; ++k) {
+						const int vertexIdx = idxOffset + (int)indices[face * indicesPerFace + quadIndices[k]] + 1;
+						chunk.writeUInt8(' ');
+						writeIntText(chunk, vertexIdx);
+						if (withTexCoords) {
+							chunk.writeUInt8('/');
+							writeIntText(chunk, texcoordOffset + face * cornersPerFace + k + 1);
 						}
-					} else {
 						if (withNormals) {
-							stream->writeStringFormat(false, "f %i//%i %i//%i %i//%i\n", (int)one, (int)two, (int)three,
-													  (int)one, (int)two, (int)three);
-						} else {
-							stream->writeStringFormat(false, "f %i %i %i\n", (int)one, (int)two, (int)three);
+							if (!withTexCoords) {
+								chunk.writeUInt8('/');
+							}
+							chunk.writeUInt8('/');
+							writeIntText(chunk, vertexIdx);
 						}
 					}
+					chunk.writeUInt8('\n');
 				}
-				texcoordOffset += ni;
-			}
+			};
+			wrapBool(writeChunksParallel(*stream, faces, writeFaces))
+			texcoordOffset += faces * cornersPerFace;
 			idxOffset += nv;
 
 			if (paletteMaterialIndices.find(palette.hash()) == paletteMaterialIndices.end()) {
@@ -274,6 +268,7 @@ bool OBJFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 				}
 			}
 		}
+		meshes.release(meshIdx);
 	}
 	return true;
 }
@@ -466,7 +461,7 @@ bool OBJFormat::voxelizeGroups(const core::String &filename, const io::ArchivePt
 
 		if (!tinyMaterial.diffuse_texname.empty()) {
 			const core::String &diffuseTextureName =
-				lookupTexture(filename, tinyMaterial.diffuse_texname.c_str(), archive);
+				lookupTexture(filename, tinyMaterial.diffuse_texname.c_str(), archive, _config.texturePath);
 			image::ImagePtr diffuseTexture = image::loadImage(diffuseTextureName);
 			if (diffuseTexture->isLoaded()) {
 				Log::debug("Use image %s", diffuseTextureName.c_str());
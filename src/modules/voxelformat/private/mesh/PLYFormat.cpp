@@ -4,15 +4,14 @@
 
 #include "PLYFormat.h"
 #include "color/Color.h"
-#include "core/ConfigVar.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
 #include "core/collection/DynamicArray.h"
 #include "engine-config.h"
 #include "io/Archive.h"
 #include "io/EndianStreamReadWrapper.h"
+#include "io/MemoryReadStream.h"
 #include "palette/Palette.h"
 #include "scenegraph/SceneGraph.h"
 #include "scenegraph/SceneGraphNode.h"
@@ -322,12 +321,12 @@ bool PLYFormat::parseFacesAscii(const Element &element, io::SeekableReadStream &
 }
 
 bool PLYFormat::parseVerticesAscii(const Element &element, io::SeekableReadStream &stream,
-								   core::DynamicArray<MeshVertex> &vertices) const {
+								   core::DynamicArray<MeshVertex> &vertices, int count) const {
 	core::DynamicArray<core::String> tokens;
 	tokens.reserve(32);
 
-	vertices.reserve(element.count);
-	for (int idx = 0; idx < element.count; ++idx) {
+	vertices.reserve(vertices.size() + count);
+	for (int idx = 0; idx < count; ++idx) {
 		core::String line;
 		wrapBool(stream.readLine(line))
 		tokens.clear();
@@ -387,63 +386,74 @@ bool PLYFormat::parseVerticesAscii(const Element &element, io::SeekableReadStrea
 	return true;
 }
 
-bool PLYFormat::parsePointCloudBinary(const core::String &filename, io::SeekableReadStream &stream,
-									  scenegraph::SceneGraph &sceneGraph, const Header &header,
-									  core::DynamicArray<MeshVertex> &vertices) const {
-	for (int i = 0; i < (int)header.elements.size(); ++i) {
-		const Element &element = header.elements[i];
-		if (element.name == "vertex") {
-			if (!parseVerticesBinary(element, stream, vertices, header)) {
+bool PLYFormat::parsePointCloudVertices(const Element &element, io::SeekableReadStream &stream, const Header &header,
+									   PointCloudVoxelizer &voxelizer) const {
+	Log::debug("loading %i points", element.count);
+	const int size = elementSize(element);
+	// the binary parser leaves the alpha at 0 if there is no alpha property
+	const bool hasAlpha = core::find_if(element.properties.begin(), element.properties.end(), [](const Property &p) {
+							  return p.use == PropertyUse::alpha;
+						  }) != element.properties.end();
+	core::DynamicArray<MeshVertex> vertices;
+	core::Buffer<uint8_t> buffer;
+	PointCloud block;
+	for (int start = 0; start < element.count; start += PointCloudBlockSize) {
+		if (stopExecution()) {
+			return false;
+		}
+		const int count = core_min(PointCloudBlockSize, element.count - start);
+		vertices.clear();
+		if (header.format == PlyFormatType::Ascii) {
+			if (!parseVerticesAscii(element, stream, vertices, count)) {
 				return false;
 			}
-		} else {
-			if (!skipElementBinary(element, stream, header)) {
+		} else if (size > 0) {
+			// read the whole block at once instead of every single property from the (file) stream
+			buffer.resize((size_t)size * count);
+			if (stream.read(buffer.data(), buffer.size()) != (int)buffer.size()) {
+				Log::error("Failed to read ply point cloud block at vertex %i", start);
+				return false;
+			}
+			io::MemoryReadStream blockStream(buffer.data(), buffer.size());
+			if (!parseVerticesBinary(element, blockStream, vertices, header, count)) {
 				return false;
 			}
+		} else if (!parseVerticesBinary(element, stream, vertices, header, count)) {
+			return false;
+		}
+		block.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			block[i].position = vertices[i].pos;
+			block[i].color = vertices[i].color;
+			if (!hasAlpha) {
+				block[i].color.a = 255;
+			}
 		}
+		voxelizer.add(block.data(), block.size());
 	}
 	return true;
 }
 
-bool PLYFormat::parsePointCloudAscii(const core::String &filename, io::SeekableReadStream &stream,
-									 scenegraph::SceneGraph &sceneGraph, const Header &header,
-									 core::DynamicArray<MeshVertex> &vertices) const {
+bool PLYFormat::parsePointCloud(const core::String &filename, io::SeekableReadStream &stream,
+								scenegraph::SceneGraph &sceneGraph, const LoadContext &ctx,
+								const Header &header) const {
+	PointCloudVoxelizer voxelizer = pointCloudVoxelizer();
 	for (int i = 0; i < (int)header.elements.size(); ++i) {
 		const Element &element = header.elements[i];
-		if (element.name != "vertex") {
+		if (element.name == "vertex") {
+			if (!parsePointCloudVertices(element, stream, header, voxelizer)) {
+				return false;
+			}
+		} else if (header.format == PlyFormatType::Ascii) {
 			for (int skip = 0; skip < element.count; ++skip) {
 				core::String line;
 				wrapBool(stream.readLine(line))
 			}
-			continue;
-		}
-		if (!parseVerticesAscii(element, stream, vertices)) {
+		} else if (!skipElementBinary(element, stream, header)) {
 			return false;
 		}
 	}
-	return true;
-}
-
-bool PLYFormat::parsePointCloud(const core::String &filename, io::SeekableReadStream &stream,
-								scenegraph::SceneGraph &sceneGraph, const LoadContext &ctx,
-								const Header &header) const {
-	core::DynamicArray<MeshVertex> vertices;
-	if (header.format == PlyFormatType::Ascii) {
-		if (!parsePointCloudAscii(filename, stream, sceneGraph, header, vertices)) {
-			return false;
-		}
-	} else if (header.format == PlyFormatType::BinaryLittleEndian || header.format == PlyFormatType::BinaryBigEndian) {
-		if (!parsePointCloudBinary(filename, stream, sceneGraph, header, vertices)) {
-			return false;
-		}
-	}
-	PointCloud pointCloud;
-	pointCloud.resize(vertices.size());
-	for (int i = 0; i < (int)vertices.size(); ++i) {
-		pointCloud[i].position = vertices[i].pos;
-		pointCloud[i].color = vertices[i].color;
-	}
-	return voxelizePointCloud(filename, sceneGraph, core::move(pointCloud)) != InvalidNodeId;
+	return voxelizePointCloud(filename, sceneGraph, voxelizer) != InvalidNodeId;
 }
 
 bool PLYFormat::parseFacesBinary(const Element &element, io::SeekableReadStream &stream, voxel::IndexArray &indices,
@@ -490,11 +500,11 @@ bool PLYFormat::parseFacesBinary(const Element &element, io::SeekableReadStream
 }
 
 bool PLYFormat::parseVerticesBinary(const Element &element, io::SeekableReadStream &stream,
-									core::DynamicArray<MeshVertex> &vertices, const Header &header) const {
+									core::DynamicArray<MeshVertex> &vertices, const Header &header, int count) const {
 	io::EndianStreamReadWrapper es(stream, header.format == PlyFormatType::BinaryBigEndian);
-	vertices.reserve(element.count);
-	Log::debug("loading %i vertices", element.count);
-	for (int i = 0; i < element.count; ++i) {
+	vertices.reserve(vertices.size() + count);
+	Log::debug("loading %i vertices", count);
+	for (int i = 0; i < count; ++i) {
 		MeshVertex vertex;
 		for (size_t j = 0; j < element.properties.size(); ++j) {
 			const Property &prop = element.properties[j];
@@ -544,15 +554,32 @@ bool PLYFormat::parseVerticesBinary(const Element &element, io::SeekableReadStre
 	return true;
 }
 
-bool PLYFormat::skipElementBinary(const Element &element, io::SeekableReadStream &stream, const Header &header) {
-	for (size_t i = 0; i < element.properties.size(); ++i) {
-		const Property &prop = element.properties[i];
+int PLYFormat::elementSize(const Element &element) {
+	int size = 0;
+	for (const Property &prop : element.properties) {
 		if (prop.isList) {
-			io::EndianStreamReadWrapper es(stream, header.format == PlyFormatType::BinaryBigEndian);
-			const int64_t listCount = read<int64_t>(es, prop.countType);
-			stream.skip(listCount * dataSize(prop.type));
-		} else {
-			stream.skip(dataSize(prop.type));
+			return -1;
+		}
+		size += dataSize(prop.type);
+	}
+	return size;
+}
+
+bool PLYFormat::skipElementBinary(const Element &element, io::SeekableReadStream &stream, const Header &header) {
+	const int size = elementSize(element);
+	if (size >= 0) {
+		return stream.skip((int64_t)size * element.count) != -1;
+	}
+	io::EndianStreamReadWrapper es(stream, header.format == PlyFormatType::BinaryBigEndian);
+	for (int idx = 0; idx < element.count; ++idx) {
+		for (size_t i = 0; i < element.properties.size(); ++i) {
+			const Property &prop = element.properties[i];
+			if (prop.isList) {
+				const int64_t listCount = read<int64_t>(es, prop.countType);
+				stream.skip(listCount * dataSize(prop.type));
+			} else {
+				stream.skip(dataSize(prop.type));
+			}
 		}
 	}
 	return true;
@@ -562,7 +589,7 @@ bool PLYFormat::parseMeshBinary(io::SeekableReadStream &stream, const Header &he
 	for (int i = 0; i < (int)header.elements.size(); ++i) {
 		const Element &element = header.elements[i];
 		if (element.name == "vertex") {
-			if (!parseVerticesBinary(element, stream, mesh.vertices, header)) {
+			if (!parseVerticesBinary(element, stream, mesh.vertices, header, element.count)) {
 				return false;
 			}
 		} else if (element.name == "face") {
@@ -585,7 +612,7 @@ bool PLYFormat::parseMeshAscii(io::SeekableReadStream &stream, const Header &hea
 	for (int i = 0; i < (int)header.elements.size(); ++i) {
 		const Element &element = header.elements[i];
 		if (element.name == "vertex") {
-			if (!parseVerticesAscii(element, stream, mesh.vertices)) {
+			if (!parseVerticesAscii(element, stream, mesh.vertices, element.count)) {
 				return false;
 			}
 		} else if (element.name == "face") {
@@ -665,7 +692,7 @@ bool PLYFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 		return false;
 	}
 	// if no transform are applied, and no scale is wanted, we can just export integers
-	const bool applyTransform = core::Var::getSafe(cfg::VoxformatTransform)->boolVal();
+	const bool applyTransform = _config.transform;
 	const bool exportIntegers = glm::all(glm::equal(scale, glm::vec3(1.0f))) && !applyTransform;
 	int elementsCnt = 0;
 	int indicesCnt = 0;
@@ -689,7 +716,12 @@ bool PLYFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 		palFilename = "palette";
 	}
 	const core::String paletteName = core::string::replaceExtension(palFilename, "png");
-	stream->writeStringFormat(false, "ply\nformat ascii 1.0\n");
+	const bool binary = _config.plyBinary;
+	if (binary) {
+		stream->writeStringFormat(false, "ply\nformat binary_little_endian 1.0\n");
+	} else {
+		stream->writeStringFormat(false, "ply\nformat ascii 1.0\n");
+	}
 	stream->writeStringFormat(false, "comment version " PROJECT_VERSION " github.com/vengi-voxel/vengi\n");
 	stream->writeStringFormat(false, "comment TextureFile %s\n", paletteName.c_str());
 
@@ -738,29 +770,66 @@ bool PLYFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 			const scenegraph::SceneGraphTransform &transform = graphNode.transform(keyFrameIdx);
 			const palette::Palette &palette = graphNode.palette();
 
-			for (int j = 0; j < nv; ++j) {
-				const voxel::VoxelVertex &v = vertices[j];
-				glm::vec3 pos;
-				if (meshExt.applyTransform) {
-					pos = transform.apply(v.position, meshExt.pivot * meshExt.size);
-				} else {
-					pos = v.position;
+			auto writeVertices = [&](int start, int end, io::WriteStream &chunk) {
+				for (int j = start; j < end; ++j) {
+					const voxel::VoxelVertex &v = vertices[j];
+					glm::vec3 pos;
+					if (meshExt.applyTransform) {
+						pos = transform.apply(v.position, meshExt.pivot * meshExt.size);
+					} else {
+						pos = v.position;
+					}
+					if (!exportIntegers) {
+						pos *= scale;
+					}
+					for (int k = 0; k < 3; ++k) {
+						if (binary) {
+							if (exportIntegers) {
+								chunk.writeInt32((int32_t)pos[k]);
+							} else {
+								chunk.writeFloat(pos[k]);
+							}
+							continue;
+						}
+						if (k > 0) {
+							chunk.writeUInt8(' ');
+						}
+						if (exportIntegers) {
+							writeIntText(chunk, (int)pos[k]);
+						} else {
+							writeFloatText(chunk, pos[k]);
+						}
+					}
+					if (withTexCoords) {
+						const glm::vec2 &uv = paletteUV(v.colorIndex);
+						if (binary) {
+							chunk.writeFloat(uv.x);
+							chunk.writeFloat(uv.y);
+						} else {
+							chunk.writeUInt8(' ');
+							writeFloatText(chunk, uv.x);
+							chunk.writeUInt8(' ');
+							writeFloatText(chunk, uv.y);
+						}
+					}
+					if (withColor) {
+						const color::RGBA color = palette.color(v.colorIndex);
+						for (int k = 0; k < 4; ++k) {
+							if (binary) {
+								chunk.writeUInt8(color[k]);
+							} else {
+								chunk.writeUInt8(' ');
+								writeIntText(chunk, color[k]);
+							}
+						}
+					}
+					if (!binary) {
+						chunk.writeUInt8('\n');
+					}
 				}
-				if (exportIntegers) {
-					stream->writeStringFormat(false, "%d %d %d", (int)pos.x, (int)pos.y, (int)pos.z);
-				} else {
-					pos *= scale;
-					stream->writeStringFormat(false, "%f %f %f", pos.x, pos.y, pos.z);
-				}
-				if (withTexCoords) {
-					const glm::vec2 &uv = paletteUV(v.colorIndex);
-					stream->writeStringFormat(false, " %f %f", uv.x, uv.y);
-				}
-				if (withColor) {
-					const color::RGBA color = palette.color(v.colorIndex);
-					stream->writeStringFormat(false, " %u %u %u %u", color.r, color.g, color.b, color.a);
-				}
-				stream->writeStringFormat(false, "\n");
+			};
+			if (!writeChunksParallel(*stream, nv, writeVertices)) {
+				return false;
 			}
 		}
 	}
@@ -779,21 +848,30 @@ bool PLYFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 				return false;
 			}
 			const voxel::IndexType *indices = mesh.getRawIndexData();
-			if (quad) {
-				for (int j = 0; j < ni; j += 6) {
-					const uint32_t one = idxOffset + indices[j + 0];
-					const uint32_t two = idxOffset + indices[j + 1];
-					const uint32_t three = idxOffset + indices[j + 2];
-					const uint32_t four = idxOffset + indices[j + 5];
-					stream->writeStringFormat(false, "4 %i %i %i %i\n", (int)one, (int)two, (int)three, (int)four);
-				}
-			} else {
-				for (int j = 0; j < ni; j += 3) {
-					const uint32_t one = idxOffset + indices[j + 0];
-					const uint32_t two = idxOffset + indices[j + 1];
-					const uint32_t three = idxOffset + indices[j + 2];
-					stream->writeStringFormat(false, "3 %i %i %i\n", (int)one, (int)two, (int)three);
+			// the quads are built from two triangles - the fourth index is the last one of the second triangle
+			static const int quadIndices[] = {0, 1, 2, 5};
+			const int indicesPerFace = quad ? 6 : 3;
+			const int cornersPerFace = quad ? 4 : 3;
+			auto writeFaces = [&](int start, int end, io::WriteStream &chunk) {
+				for (int face = start; face < end; ++face) {
+					const voxel::IndexType *faceIndices = indices + face * indicesPerFace;
+					if (binary) {
+						chunk.writeUInt8((uint8_t)cornersPerFace);
+						for (int k = 0; k < cornersPerFace; ++k) {
+							chunk.writeUInt32((uint32_t)idxOffset + faceIndices[quadIndices[k]]);
+						}
+						continue;
+					}
+					chunk.writeUInt8('0' + cornersPerFace);
+					for (int k = 0; k < cornersPerFace; ++k) {
+						chunk.writeUInt8(' ');
+						writeIntText(chunk, (int)(idxOffset + faceIndices[quadIndices[k]]));
+					}
+					chunk.writeUInt8('\n');
 				}
+			};
+			if (!writeChunksParallel(*stream, ni / indicesPerFace, writeFaces)) {
+				return false;
 			}
 			idxOffset += nv;
 		}
@@ -63,6 +63,18 @@ public:
 	};
 
 protected:
+	/**
+	 * The amount of vertices that are read and voxelized at once when loading a point cloud
+	 */
+	static constexpr int PointCloudBlockSize = 65536;
+
+	/**
+	 * @return The size in bytes of one binary element or @c -1 if the element contains a list property
+	 */
+	static int elementSize(const Element &element);
+	/**
+	 * @brief Skips all entries of the given element
+	 */
 	static bool skipElementBinary(const Element &element, io::SeekableReadStream &stream, const Header &header);
 	static int dataSize(DataType type);
 	static DataType dataType(const core::String &in);
@@ -71,18 +83,17 @@ protected:
 	bool parseFacesAscii(const Element &element, io::SeekableReadStream &stream, voxel::IndexArray &indices,
 						 core::DynamicArray<voxel::IndexArray> &polygons) const;
 	bool parseVerticesAscii(const Element &element, io::SeekableReadStream &stream,
-							core::DynamicArray<MeshVertex> &vertices) const;
+							core::DynamicArray<MeshVertex> &vertices, int count) const;
 	bool parseFacesBinary(const Element &element, io::SeekableReadStream &stream, voxel::IndexArray &indices,
 						  core::DynamicArray<voxel::IndexArray> &polygons, const Header &header) const;
 	bool parseVerticesBinary(const Element &element, io::SeekableReadStream &stream,
-							 core::DynamicArray<MeshVertex> &vertices, const Header &header) const;
-
-	bool parsePointCloudBinary(const core::String &filename, io::SeekableReadStream &stream,
-							   scenegraph::SceneGraph &sceneGraph, const Header &header,
-							   core::DynamicArray<MeshVertex> &vertices) const;
-	bool parsePointCloudAscii(const core::String &filename, io::SeekableReadStream &stream,
-							  scenegraph::SceneGraph &sceneGraph, const Header &header,
-							  core::DynamicArray<MeshVertex> &vertices) const;
+							 core::DynamicArray<MeshVertex> &vertices, const Header &header, int count) const;
+
+	/**
+	 * @brief Streams the vertices of the given element in blocks of @c PointCloudBlockSize into the voxelizer
+	 */
+	bool parsePointCloudVertices(const Element &element, io::SeekableReadStream &stream, const Header &header,
+								 PointCloudVoxelizer &voxelizer) const;
 	bool parsePointCloud(const core::String &filename, io::SeekableReadStream &stream,
 						 scenegraph::SceneGraph &sceneGraph, const LoadContext &ctx, const Header &header) const;
 
@@ -0,0 +1,374 @@
+/**
+ * @file
+ */
+
+#include "PointCloudVoxelizer.h"
+#include "app/App.h"
+#include "app/Async.h"
+#include "core/Algorithm.h"
+#include "core/Log.h"
+#include "core/StringUtil.h"
+#include "core/Trace.h"
+#include "core/collection/DynamicArray.h"
+#include "palette/Palette.h"
+#include "voxel/RawVolume.h"
+#include "voxel/Voxel.h"
+
+namespace voxelformat {
+
+// prevent an overflow of the color sums
+static constexpr uint32_t MaxSamplesPerVoxel = UINT32_MAX / 255u;
+
+PointCloudVoxelizer::PointCloudVoxelizer(const palette::Palette &palette, const glm::vec3 &scale, int pointSize,
+										 size_t memoryBudget, int chunkBits)
+	: _palette(palette), _palLookup(palette), _scale(scale), _pointSize(core_max(1, pointSize)),
+	  _chunkBits(core_max(BrickBits, chunkBits)),
+	  _maxBricks(core_max((size_t)1u, memoryBudget / 2u / sizeof(Brick))),
+	  _maxFlushedBricks(core_max((size_t)1u, memoryBudget / 2u / FlushedBrickBytes)) {
+}
+
+PointCloudVoxelizer::~PointCloudVoxelizer() {
+	for (auto iter = _bricks.begin(); iter != _bricks.end(); ++iter) {
+		delete iter->value;
+	}
+	for (auto iter = _chunks.begin(); iter != _chunks.end(); ++iter) {
+		delete iter->value;
+	}
+	for (voxel::RawVolume *v : _volumes) {
+		delete v;
+	}
+}
+
+void PointCloudVoxelizer::updatePeakMemory() {
+	const size_t memory = _bricks.size() * sizeof(Brick) + _flushedBricksInChunks * FlushedBrickBytes;
+	_peakMemory = core_max(_peakMemory, memory);
+}
+
+void PointCloudVoxelizer::add(const PointCloudVertex *vertices, size_t amount) {
+	core_trace_scoped(PointCloudVoxelizerAdd);
+	if (app::App::getInstance()->shouldQuit()) {
+		return;
+	}
+	++_blocks;
+	_points += amount;
+	// consecutive points are usually close to each other - avoid the hash lookup for them
+	glm::ivec3 lastBrickPos(0);
+	Brick *lastBrick = nullptr;
+	for (size_t i = 0; i < amount; ++i) {
+		const PointCloudVertex &vertex = vertices[i];
+		const glm::ivec3 pos = glm::round(vertex.position * _scale);
+		const glm::ivec3 brickPos(pos.x >> BrickBits, pos.y >> BrickBits, pos.z >> BrickBits);
+		if (lastBrick == nullptr || lastBrickPos != brickPos) {
+			auto iter = _bricks.find(brickPos);
+			if (iter != _bricks.end()) {
+				lastBrick = iter->value;
+			} else {
+				if (_bricks.size() >= _maxBricks) {
+					flushOldest();
+				}
+				lastBrick = new Brick();
+				_bricks.put(brickPos, lastBrick);
+				_peakBricks = core_max(_peakBricks, _bricks.size());
+				updatePeakMemory();
+			}
+			lastBrickPos = brickPos;
+			lastBrick->lastUse = _blocks;
+		}
+		const int idx = voxelIndex(pos);
+		Accumulator &acc = lastBrick->voxels[idx];
+		if (acc.count >= MaxSamplesPerVoxel) {
+			continue;
+		}
+		acc.r += vertex.color.r;
+		acc.g += vertex.color.g;
+		acc.b += vertex.color.b;
+		acc.a += vertex.color.a;
+		++acc.count;
+		lastBrick->occupied[idx / 64] |= 1ull << (idx % 64);
+	}
+}
+
+void PointCloudVoxelizer::flushOldest() {
+	core_trace_scoped(PointCloudVoxelizerFlushOldest);
+	struct Entry {
+		uint64_t lastUse;
+		glm::ivec3 pos;
+	};
+	core::DynamicArray<Entry> entries;
+	entries.reserve(_bricks.size());
+	for (auto iter = _bricks.begin(); iter != _bricks.end(); ++iter) {
+		entries.push_back({iter->value->lastUse, iter->key});
+	}
+	core::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+		if (a.lastUse != b.lastUse) {
+			return a.lastUse < b.lastUse;
+		}
+		// keep the flush order independent from the hash map layout
+		if (a.pos.z != b.pos.z) {
+			return a.pos.z < b.pos.z;
+		}
+		if (a.pos.y != b.pos.y) {
+			return a.pos.y < b.pos.y;
+		}
+		return a.pos.x < b.pos.x;
+	});
+	const size_t n = core_max((size_t)1u, entries.size() / 2u);
+	core::DynamicArray<glm::ivec3> brickPositions;
+	brickPositions.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		brickPositions.push_back(entries[i].pos);
+	}
+	_flushedBricks += n;
+	flush(brickPositions);
+	if (_flushedBricksInChunks > _maxFlushedBricks) {
+		createOldestChunkVolumes();
+	}
+}
+
+voxel::RawVolume *PointCloudVoxelizer::chunkVolume(const glm::ivec3 &chunkPos) const {
+	int idx;
+	if (!_chunkVolumes.get(chunkPos, idx)) {
+		return nullptr;
+	}
+	return _volumes[idx];
+}
+
+void PointCloudVoxelizer::setPointVoxel(voxel::RawVolume &volume, const glm::ivec3 &pos,
+										const voxel::Voxel &voxel) const {
+	const voxel::Region &region = volume.region();
+	const glm::ivec3 mins = glm::max(pos, region.getLowerCorner());
+	const glm::ivec3 maxs = glm::min(pos + (_pointSize - 1), region.getUpperCorner());
+	for (int z = mins.z; z <= maxs.z; ++z) {
+		for (int y = mins.y; y <= maxs.y; ++y) {
+			for (int x = mins.x; x <= maxs.x; ++x) {
+				volume.setVoxel(x, y, z, voxel);
+			}
+		}
+	}
+}
+
+void PointCloudVoxelizer::flush(const core::DynamicArray<glm::ivec3> &brickPositions) {
+	core_trace_scoped(PointCloudVoxelizerFlush);
+	const int n = (int)brickPositions.size();
+	core::DynamicArray<Brick *> bricks;
+	bricks.reserve(n);
+	// the chunks are looked up once per brick - the chunk size is a multiple of the brick size
+	core::DynamicArray<Chunk *> chunks;
+	chunks.reserve(n);
+	core::DynamicArray<voxel::RawVolume *> chunkVolumes;
+	chunkVolumes.reserve(n);
+	for (const glm::ivec3 &brickPos : brickPositions) {
+		Brick *brick = nullptr;
+		_bricks.get(brickPos, brick);
+		core_assert(brick != nullptr);
+		bricks.push_back(brick);
+		_bricks.remove(brickPos);
+		const glm::ivec3 &cpos = chunkPos(brickPos);
+		Chunk *chunk = nullptr;
+		if (!_chunks.get(cpos, chunk)) {
+			chunk = new Chunk();
+			_chunks.put(cpos, chunk);
+		}
+		chunk->lastUse = _blocks;
+		chunks.push_back(chunk);
+		chunkVolumes.push_back(chunkVolume(cpos));
+	}
+
+	// the palette lookup is the expensive part - the chunks are only read here
+	core::Buffer<uint8_t> colorIndices;
+	colorIndices.resize((size_t)n * BrickVoxels);
+	app::for_parallel(0, n, [&](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			if (app::App::getInstance()->shouldQuit()) {
+				return;
+			}
+			const Brick *brick = bricks[i];
+			const Chunk *chunk = chunks[i];
+			const voxel::RawVolume *volume = chunkVolumes[i];
+			const glm::ivec3 mins = brickPositions[i] * BrickSize;
+			for (int idx = 0; idx < BrickVoxels; ++idx) {
+				if ((brick->occupied[idx / 64] & (1ull << (idx % 64))) == 0u) {
+					continue;
+				}
+				const Accumulator &acc = brick->voxels[idx];
+				const uint32_t half = acc.count / 2u;
+				color::RGBA color((acc.r + half) / acc.count, (acc.g + half) / acc.count, (acc.b + half) / acc.count,
+								  (acc.a + half) / acc.count);
+				const glm::ivec3 pos(mins.x + (idx & BrickMask), mins.y + ((idx >> BrickBits) & BrickMask),
+									 mins.z + (idx >> (BrickBits * 2)));
+				const voxel::Voxel *existing = nullptr;
+				if (volume != nullptr && volume->region().containsPoint(pos.x, pos.y, pos.z)) {
+					existing = &volume->voxel(pos);
+				} else if (chunk->volume.hasVoxel(pos)) {
+					existing = &chunk->volume.voxel(pos);
+				}
+				if (existing != nullptr && !voxel::isAir(existing->getMaterial())) {
+					const color::RGBA existingColor = _palette.color(existing->getColor());
+					color = color::RGBA((color.r + existingColor.r + 1) / 2, (color.g + existingColor.g + 1) / 2,
+										(color.b + existingColor.b + 1) / 2, (color.a + existingColor.a + 1) / 2);
+				}
+				colorIndices[(size_t)i * BrickVoxels + idx] = _palLookup.findClosestIndex(color);
+			}
+		}
+	});
+
+	// the color indices are incomplete if the execution was stopped
+	const bool stopped = app::App::getInstance()->shouldQuit();
+	for (int i = 0; i < n; ++i) {
+		Brick *brick = bricks[i];
+		if (stopped) {
+			delete brick;
+			continue;
+		}
+		Chunk *chunk = chunks[i];
+		voxel::RawVolume *volume = chunkVolumes[i];
+		bool flushedIntoChunk = false;
+		const glm::ivec3 mins = brickPositions[i] * BrickSize;
+		for (int idx = 0; idx < BrickVoxels; ++idx) {
+			if ((brick->occupied[idx / 64] & (1ull << (idx % 64))) == 0u) {
+				continue;
+			}
+			const glm::ivec3 pos(mins.x + (idx & BrickMask), mins.y + ((idx >> BrickBits) & BrickMask),
+								 mins.z + (idx >> (BrickBits * 2)));
+			const uint8_t colorIdx = colorIndices[(size_t)i * BrickVoxels + idx];
+			const voxel::Voxel &voxel = voxel::createVoxel(_palette, colorIdx);
+			if (volume != nullptr && volume->region().containsPoint(pos.x, pos.y, pos.z)) {
+				setPointVoxel(*volume, pos, voxel);
+				continue;
+			}
+			chunk->volume.setVoxel(pos, voxel);
+			flushedIntoChunk = true;
+		}
+		if (flushedIntoChunk) {
+			++chunk->bricks;
+			++_flushedBricksInChunks;
+		}
+		delete brick;
+	}
+	updatePeakMemory();
+	// chunks that only got voxels for their existing volume
+	for (int i = 0; i < n; ++i) {
+		const glm::ivec3 &cpos = chunkPos(brickPositions[i]);
+		Chunk *chunk = nullptr;
+		if (_chunks.get(cpos, chunk) && chunk->bricks == 0u) {
+			_chunks.remove(cpos);
+			delete chunk;
+		}
+	}
+}
+
+void PointCloudVoxelizer::createChunkVolume(const glm::ivec3 &chunkPos) {
+	core_trace_scoped(PointCloudVoxelizerCreateChunkVolume);
+	Chunk *chunk = nullptr;
+	if (!_chunks.get(chunkPos, chunk)) {
+		return;
+	}
+	_chunks.remove(chunkPos);
+	_flushedBricksInChunks -= chunk->bricks;
+	if (_failed || chunk->volume.empty()) {
+		delete chunk;
+		return;
+	}
+	const voxel::Region &voxelRegion = chunk->volume.calculateRegion();
+	const voxel::Region region(voxelRegion.getLowerCorner(), voxelRegion.getUpperCorner() + (_pointSize - 1));
+	const size_t bytes = voxel::RawVolume::size(region);
+	if (!app::App::getInstance()->hasEnoughMemory(bytes)) {
+		const core::String &neededMem = core::string::humanSize(bytes);
+		Log::error("Not enough memory to create a volume of size %i:%i:%i (would need %s)",
+				   region.getDimensionsInVoxels().x, region.getDimensionsInVoxels().y,
+				   region.getDimensionsInVoxels().z, neededMem.c_str());
+		_failed = true;
+		delete chunk;
+		return;
+	}
+
+	voxel::RawVolume *v = new voxel::RawVolume(region);
+	if (_pointSize == 1) {
+		chunk->volume.copyTo(*v);
+	} else {
+		chunk->volume.visitVoxels([this, v](const glm::ivec3 &pos, const voxel::Voxel &voxel) {
+			setPointVoxel(*v, pos, voxel);
+		});
+	}
+	delete chunk;
+	_chunkVolumes.put(chunkPos, (int)_volumes.size());
+	_volumes.push_back(v);
+}
+
+void PointCloudVoxelizer::createOldestChunkVolumes() {
+	core_trace_scoped(PointCloudVoxelizerCreateOldestChunkVolumes);
+	struct Entry {
+		uint64_t lastUse;
+		glm::ivec3 pos;
+	};
+	core::DynamicArray<Entry> entries;
+	entries.reserve(_chunks.size());
+	for (auto iter = _chunks.begin(); iter != _chunks.end(); ++iter) {
+		entries.push_back({iter->value->lastUse, iter->key});
+	}
+	core::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+		if (a.lastUse != b.lastUse) {
+			return a.lastUse < b.lastUse;
+		}
+		if (a.pos.z != b.pos.z) {
+			return a.pos.z < b.pos.z;
+		}
+		if (a.pos.y != b.pos.y) {
+			return a.pos.y < b.pos.y;
+		}
+		return a.pos.x < b.pos.x;
+	});
+	for (const Entry &entry : entries) {
+		if (_flushedBricksInChunks <= _maxFlushedBricks / 2u) {
+			break;
+		}
+		createChunkVolume(entry.pos);
+	}
+}
+
+bool PointCloudVoxelizer::finish(core::DynamicArray<voxel::RawVolume *> &volumes) {
+	core_trace_scoped(PointCloudVoxelizerFinish);
+	core::DynamicArray<glm::ivec3> brickPositions;
+	brickPositions.reserve(_bricks.size());
+	for (auto iter = _bricks.begin(); iter != _bricks.end(); ++iter) {
+		brickPositions.push_back(iter->key);
+	}
+	flush(brickPositions);
+	if (app::App::getInstance()->shouldQuit()) {
+		return false;
+	}
+	if (_chunks.empty() && _volumes.empty()) {
+		Log::error("No points found in the point cloud");
+		return false;
+	}
+
+	// create the remaining volumes in a stable order
+	core::DynamicArray<glm::ivec3> chunkPositions;
+	chunkPositions.reserve(_chunks.size());
+	for (auto iter = _chunks.begin(); iter != _chunks.end(); ++iter) {
+		chunkPositions.push_back(iter->key);
+	}
+	core::sort(chunkPositions.begin(), chunkPositions.end(), [](const glm::ivec3 &a, const glm::ivec3 &b) {
+		if (a.z != b.z) {
+			return a.z < b.z;
+		}
+		if (a.y != b.y) {
+			return a.y < b.y;
+		}
+		return a.x < b.x;
+	});
+	for (const glm::ivec3 &cpos : chunkPositions) {
+		createChunkVolume(cpos);
+	}
+	Log::debug("Voxelized %i points into %i volumes (flushed %i bricks early, peak %i bricks)", (int)_points,
+			   (int)_volumes.size(), (int)_flushedBricks, (int)_peakBricks);
+	if (_failed) {
+		return false;
+	}
+	volumes = core::move(_volumes);
+	_volumes.clear();
+	_chunkVolumes.clear();
+	return true;
+}
+
+} // namespace voxelformat
@@ -0,0 +1,207 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "color/RGBA.h"
+#include "core/GLM.h"
+#include "core/NonCopyable.h"
+#include "core/collection/Buffer.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/HashMap.h"
+#include "palette/PaletteLookup.h"
+#include "voxel/SparseVolume.h"
+#include "voxel/Voxel.h"
+#include <glm/vec3.hpp>
+
+namespace palette {
+class Palette;
+}
+
+namespace voxel {
+class RawVolume;
+}
+
+namespace voxelformat {
+
+struct PointCloudVertex {
+	glm::vec3 position{0.0f};
+	color::RGBA color{0, 0, 0, 255};
+};
+using PointCloud = core::Buffer<PointCloudVertex, 4096>;
+
+/**
+ * @brief Voxelizes a point cloud that is streamed in blocks of vertices
+ *
+ * The points are binned into bricks of voxels. Each brick accumulates the colors of all points that fall into one of
+ * its voxels - the voxel gets the average color. If the accumulating bricks exceed their share of the memory budget,
+ * the bricks that were not touched for the longest time are considered finished and are flushed into the sparse
+ * volume of their chunk. If the flushed voxels exceed the other share of the budget, the least recently touched chunks
+ * are converted into dense volumes of at most the chunk size - these are the result of the voxelization and are no
+ * longer part of the budget.
+ *
+ * Scans are usually recorded in a spatially coherent order - so points that end up in an already flushed voxel are
+ * rare. They are blended with the color of the flushed voxel. If the chunk volume was already created and the voxel
+ * is outside of its region, a new volume is created for the chunk.
+ *
+ * @note The voxels of a point can reach into the neighbour chunk if the point size is bigger than one - the volumes
+ * are growing by the point size in that case.
+ */
+class PointCloudVoxelizer : public core::NonCopyable {
+public:
+	static constexpr int BrickBits = voxel::SparseVolume::BrickBits;
+	static constexpr int BrickSize = 1 << BrickBits;
+	static constexpr int BrickMask = BrickSize - 1;
+	static constexpr int BrickVoxels = BrickSize * BrickSize * BrickSize;
+	/** the side length of the chunk volumes is 256 voxels */
+	static constexpr int ChunkBits = 8;
+
+private:
+	struct Accumulator {
+		uint32_t r = 0u;
+		uint32_t g = 0u;
+		uint32_t b = 0u;
+		uint32_t a = 0u;
+		uint32_t count = 0u;
+	};
+
+	struct Brick {
+		Accumulator voxels[BrickVoxels];
+		uint64_t occupied[BrickVoxels / 64]{};
+		/** the block counter of the last @c add() call that touched this brick */
+		uint64_t lastUse = 0u;
+	};
+
+	/**
+	 * @brief The flushed voxels of a chunk that was not converted into a volume yet
+	 */
+	struct Chunk {
+		voxel::SparseVolume volume;
+		/** the amount of flushed bricks - used to estimate the memory of the sparse volume */
+		size_t bricks = 0u;
+		/** the block counter of the last flush into this chunk */
+		uint64_t lastUse = 0u;
+	};
+
+	/** estimated memory of a flushed brick in the sparse volume of a chunk */
+	static constexpr size_t FlushedBrickBytes = BrickVoxels * sizeof(voxel::Voxel) + BrickVoxels / 8;
+
+	const palette::Palette &_palette;
+	palette::PaletteLookup _palLookup;
+	const glm::vec3 _scale;
+	const int _pointSize;
+	const int _chunkBits;
+	const size_t _maxBricks;
+	const size_t _maxFlushedBricks;
+	core::HashMap<glm::ivec3, Brick *, glm::hash<glm::ivec3>> _bricks;
+	core::HashMap<glm::ivec3, Chunk *, glm::hash<glm::ivec3>> _chunks;
+	/** the index of the last volume in @c _volumes that was created for a chunk */
+	core::HashMap<glm::ivec3, int, glm::hash<glm::ivec3>> _chunkVolumes;
+	core::DynamicArray<voxel::RawVolume *> _volumes;
+	uint64_t _blocks = 0u;
+	size_t _points = 0u;
+	size_t _flushedBricksInChunks = 0u;
+	size_t _peakBricks = 0u;
+	size_t _peakMemory = 0u;
+	size_t _flushedBricks = 0u;
+	bool _failed = false;
+
+	static CORE_FORCE_INLINE int voxelIndex(const glm::ivec3 &pos) {
+		return (pos.x & BrickMask) | ((pos.y & BrickMask) << BrickBits) | ((pos.z & BrickMask) << (BrickBits * 2));
+	}
+
+	inline glm::ivec3 chunkPos(const glm::ivec3 &brickPos) const {
+		const int shift = _chunkBits - BrickBits;
+		return glm::ivec3(brickPos.x >> shift, brickPos.y >> shift, brickPos.z >> shift);
+	}
+
+	/**
+	 * @return The volume that was already created for the chunk or @c nullptr
+	 */
+	voxel::RawVolume *chunkVolume(const glm::ivec3 &chunkPos) const;
+	/**
+	 * @brief Sets the voxel and the additional voxels of the point size - clipped to the region of the volume
+	 */
+	void setPointVoxel(voxel::RawVolume &volume, const glm::ivec3 &pos, const voxel::Voxel &voxel) const;
+	void updatePeakMemory();
+
+	/**
+	 * @brief Writes the averaged colors of the given bricks into the chunks and frees them
+	 */
+	void flush(const core::DynamicArray<glm::ivec3> &brickPositions);
+	/**
+	 * @brief Flushes the least recently used half of the bricks
+	 */
+	void flushOldest();
+	/**
+	 * @brief Converts the sparse volume of the chunk into a dense volume and frees the chunk
+	 */
+	void createChunkVolume(const glm::ivec3 &chunkPos);
+	/**
+	 * @brief Creates the volumes of the least recently used chunks until half of their budget is free again
+	 */
+	void createOldestChunkVolumes();
+
+public:
+	/**
+	 * @param palette The palette the voxel colors are mapped to - must outlive the voxelizer
+	 * @param scale The scale that is applied to the point positions
+	 * @param pointSize The side length of the voxels that are created for every point
+	 * @param memoryBudget The amount of bytes that may be used for the color accumulation and the flushed voxels
+	 * that were not converted into chunk volumes yet
+	 * @param chunkBits The side length of the chunk volumes as power of two - must not be smaller than @c BrickBits
+	 */
+	PointCloudVoxelizer(const palette::Palette &palette, const glm::vec3 &scale, int pointSize, size_t memoryBudget,
+						int chunkBits = ChunkBits);
+	~PointCloudVoxelizer();
+
+	/**
+	 * @brief Bins a block of points into the bricks - might flush bricks or create chunk volumes if the memory budget
+	 * is exceeded
+	 */
+	void add(const PointCloudVertex *vertices, size_t amount);
+
+	/**
+	 * @brief Flushes all remaining bricks and creates the remaining chunk volumes
+	 * @param[out] volumes The chunk volumes - the caller takes the ownership
+	 * @return @c false if there were no points, if the execution was stopped or if there is not enough memory for the
+	 * volumes
+	 */
+	bool finish(core::DynamicArray<voxel::RawVolume *> &volumes);
+
+	inline size_t points() const {
+		return _points;
+	}
+
+	/**
+	 * @return The maximum amount of bricks that were accumulating at the same time
+	 */
+	inline size_t peakBricks() const {
+		return _peakBricks;
+	}
+
+	/**
+	 * @return The maximum amount of bricks that fit into the memory budget
+	 */
+	inline size_t maxBricks() const {
+		return _maxBricks;
+	}
+
+	/**
+	 * @return The maximum amount of bytes that were used for the accumulating bricks and the flushed voxels that were
+	 * not converted into chunk volumes yet
+	 */
+	inline size_t peakMemory() const {
+		return _peakMemory;
+	}
+
+	/**
+	 * @return The amount of bricks that were flushed before @c finish() was called
+	 */
+	inline size_t flushedBricks() const {
+		return _flushedBricks;
+	}
+};
+
+} // namespace voxelformat
@@ -38,6 +38,7 @@ private:
 	core::Array<PosSamplingEntry, MaxTriangleColorContributions> entries;
 
 public:
+	PosSampling() = default;
 	PosSampling(uint32_t area, color::RGBA color, uint8_t normal, MeshMaterialIndex materialIdx) {
 		entries[0].area = area;
 		entries[0].color = color;
@@ -5,6 +5,7 @@
 #include "STLFormat.h"
 #include "color/Color.h"
 #include "core/FourCC.h"
+#include "core/Endian.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
@@ -17,6 +18,18 @@ namespace voxelformat {
 
 namespace priv {
 static constexpr const size_t BinaryHeaderSize = 80;
+// normal, three vertices and the attribute byte count
+static constexpr const size_t FacetSize = 4 * 3 * sizeof(float) + sizeof(uint16_t);
+
+static inline uint8_t *putVec3(uint8_t *buf, const glm::vec3 &v) {
+	for (int i = 0; i < 3; ++i) {
+		uint32_t val;
+		core_memcpy(&val, &v[i], sizeof(val));
+		val = core_swap32le(val);
+		core_memcpy(buf + i * sizeof(val), &val, sizeof(val));
+	}
+	return buf + 3 * sizeof(uint32_t);
+}
 }
 
 bool STLFormat::parseAscii(io::SeekableReadStream &stream, Mesh &mesh) {
@@ -151,27 +164,6 @@ bool STLFormat::voxelizeGroups(const core::String &filename, const io::ArchivePt
 #undef wrap
 #undef wrapBool
 
-bool STLFormat::writeVertex(io::SeekableWriteStream &stream, const ChunkMeshExt &meshExt, const voxel::VoxelVertex &v1,
-							const scenegraph::SceneGraphTransform &transform, const glm::vec3 &scale) {
-	glm::vec3 pos;
-	if (meshExt.applyTransform) {
-		pos = transform.apply(v1.position, meshExt.pivot * meshExt.size);
-	} else {
-		pos = v1.position;
-	}
-	pos *= scale;
-	if (!stream.writeFloat(pos.x)) {
-		return false;
-	}
-	if (!stream.writeFloat(pos.y)) {
-		return false;
-	}
-	if (!stream.writeFloat(pos.z)) {
-		return false;
-	}
-	return true;
-}
-
 bool STLFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneGraph &sceneGraph, const ChunkMeshes &meshes,
 						   const core::String &filename, const io::ArchivePtr &archive, const glm::vec3 &scale,
 						   bool quad, bool withColor, bool withTexCoords) {
@@ -187,29 +179,23 @@ bool STLFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 	}
 	core_assert(stream->pos() == priv::BinaryHeaderSize);
 
-	int faceCount = 0;
-	for (const auto &meshExt : meshes) {
+	// the face count is patched after the meshes were written - this allows to release every mesh after it was
+	// written
+	const int64_t faceCountPos = stream->pos();
+	stream->writeUInt32(0);
+
+	uint32_t faceCount = 0;
+	for (size_t meshIdx = 0; meshIdx < meshes.size(); ++meshIdx) {
+		const ChunkMeshExt &meshExt = meshes[meshIdx];
 		for (int i = 0; i < voxel::ChunkMesh::Meshes; ++i) {
 			const voxel::Mesh *mesh = &meshExt.mesh->mesh[i];
 			if (mesh->isEmpty()) {
 				continue;
 			}
-			const int ni = (int)mesh->getNoOfIndices();
-			if (ni % 3 != 0) {
+			if (mesh->getNoOfIndices() % 3 != 0) {
 				Log::error("Unexpected indices amount");
 				return false;
 			}
-			faceCount += ni / 3;
-		}
-	}
-	stream->writeUInt32(faceCount);
-
-	for (const auto &meshExt : meshes) {
-		for (int i = 0; i < voxel::ChunkMesh::Meshes; ++i) {
-			const voxel::Mesh *mesh = &meshExt.mesh->mesh[i];
-			if (mesh->isEmpty()) {
-				continue;
-			}
 			Log::debug("Exporting model %s", meshExt.name.c_str());
 			const int ni = (int)mesh->getNoOfIndices();
 			const scenegraph::SceneGraphNode &graphNode = sceneGraph.node(meshExt.nodeId);
@@ -218,41 +204,47 @@ bool STLFormat::saveMeshes(const core::Map<int, int> &, const scenegraph::SceneG
 			const voxel::VoxelVertex *vertices = mesh->getRawVertexData();
 			const voxel::IndexType *indices = mesh->getRawIndexData();
 
-			for (int j = 0; j < ni; j += 3) {
-				const uint32_t one = indices[j + 0];
-				const uint32_t two = indices[j + 1];
-				const uint32_t three = indices[j + 2];
-
-				const voxel::VoxelVertex &v1 = vertices[one];
-				const voxel::VoxelVertex &v2 = vertices[two];
-				const voxel::VoxelVertex &v3 = vertices[three];
-
-				// normal
-				const glm::vec3 edge1 = glm::vec3(v2.position - v1.position);
-				const glm::vec3 edge2 = glm::vec3(v3.position - v1.position);
-				const glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
-				for (int k = 0; k < 3; ++k) {
-					if (!stream->writeFloat(normal[k])) {
-						return false;
+			auto writeFacets = [&](int start, int end, io::WriteStream &chunk) {
+				uint8_t facet[priv::FacetSize];
+				for (int face = start; face < end; ++face) {
+					glm::vec3 pos[3];
+					for (int k = 0; k < 3; ++k) {
+						const voxel::VoxelVertex &v = vertices[indices[face * 3 + k]];
+						if (meshExt.applyTransform) {
+							pos[k] = transform.apply(v.position, meshExt.pivot * meshExt.size);
+						} else {
+							pos[k] = v.position;
+						}
+						pos[k] *= scale;
 					}
+					// the normal is calculated from the untransformed positions
+					const voxel::VoxelVertex &v1 = vertices[indices[face * 3 + 0]];
+					const glm::vec3 edge1 = glm::vec3(vertices[indices[face * 3 + 1]].position - v1.position);
+					const glm::vec3 edge2 = glm::vec3(vertices[indices[face * 3 + 2]].position - v1.position);
+					const glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
+
+					uint8_t *p = priv::putVec3(facet, normal);
+					for (int k = 0; k < 3; ++k) {
+						p = priv::putVec3(p, pos[k]);
+					}
+					// attribute byte count
+					p[0] = p[1] = 0u;
+					chunk.write(facet, sizeof(facet));
 				}
-
-				if (!writeVertex(*stream, meshExt, v1, transform, scale)) {
-					return false;
-				}
-
-				if (!writeVertex(*stream, meshExt, v2, transform, scale)) {
-					return false;
-				}
-
-				if (!writeVertex(*stream, meshExt, v3, transform, scale)) {
-					return false;
-				}
-
-				stream->writeUInt16(0);
+			};
+			if (!writeChunksParallel(*stream, ni / 3, writeFacets)) {
+				return false;
 			}
+			faceCount += ni / 3;
 		}
+		meshes.release(meshIdx);
+	}
+	const int64_t endPos = stream->pos();
+	if (stream->seek(faceCountPos) == -1 || !stream->writeUInt32(faceCount)) {
+		Log::error("Failed to write the face count");
+		return false;
 	}
+	stream->seek(endPos);
 	return true;
 }
 
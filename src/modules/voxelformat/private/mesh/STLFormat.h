@@ -36,9 +36,6 @@ namespace voxelformat {
  */
 class STLFormat : public MeshFormat {
 private:
-	bool writeVertex(io::SeekableWriteStream &stream, const ChunkMeshExt &meshExt, const voxel::VoxelVertex &v1,
-					 const scenegraph::SceneGraphTransform &transform, const glm::vec3 &scale);
-
 	bool parseBinary(io::SeekableReadStream &stream, Mesh &mesh);
 	bool parseAscii(io::SeekableReadStream &stream, Mesh &mesh);
 
@@ -6,7 +6,6 @@
 #include "app/App.h"
 #include "core/Path.h"
 #include "core/String.h"
-#include "core/Var.h"
 #include "io/Archive.h"
 #include "io/FormatDescription.h"
 
@@ -61,11 +60,12 @@ static core::Path searchInPath(const core::Path &referencePath, const core::Path
 	return {};
 }
 
-core::Path lookupTexture(const core::Path &referenceFile, const core::Path &file, const io::ArchivePtr &archive) {
+core::Path lookupTexture(const core::Path &referenceFile, const core::Path &file, const io::ArchivePtr &archive,
+						 const core::String &searchPath) {
 	const core::Path referencePath(referenceFile.dirname());
 	core::Path foundFile = searchInPath(referencePath, file, archive);
 	if (!foundFile.valid()) {
-		const core::Path additionalSearchPath(core::Var::getSafe(cfg::VoxformatTexturePath)->strVal());
+		const core::Path additionalSearchPath(searchPath);
 		if (additionalSearchPath.valid()) {
 			foundFile = searchInPath(additionalSearchPath, file, archive);
 		}
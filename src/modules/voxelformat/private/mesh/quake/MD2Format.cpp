@@ -91,7 +91,7 @@ bool MD2Format::voxelizeGroups(const core::String &filename, const io::ArchivePt
 			skinname = skinname.substr(1);
 		}
 
-		const core::String &imageName = lookupTexture(filename, skinname, archive);
+		const core::String &imageName = lookupTexture(filename, skinname, archive, _config.texturePath);
 		const image::ImagePtr &image = image::loadImage(imageName);
 		meshMaterialArray.push_back(createMaterial(image));
 	}
@@ -207,7 +207,7 @@ bool MapFormat::parseBrush(const core::String &filename, const io::ArchivePtr &a
 		auto iter = meshMaterials.find(qface.texture);
 		MeshMaterialIndex materialIdx;
 		if (iter == meshMaterials.end()) {
-			const core::String &imageName = lookupTexture(filename, qface.texture, archive);
+			const core::String &imageName = lookupTexture(filename, qface.texture, archive, _config.texturePath);
 			const image::ImagePtr &image = image::loadImage(imageName);
 			mesh.materials.push_back(createMaterial(image));
 			materialIdx = mesh.materials.size() - 1;
@@ -12,7 +12,6 @@
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
-#include "core/Var.h"
 #include "core/concurrent/Atomic.h"
 #include "io/ZipReadStream.h"
 #include "io/ZipWriteStream.h"
@@ -623,7 +622,7 @@ bool SchematicFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const
 	palette::Palette minecraftPalette;
 	minecraftPalette.minecraft();
 
-	const core::VarPtr &schematicType = core::Var::getSafe(cfg::VoxformatSchematicType);
+	const core::String &schematicType = ctx.config.schematicType;
 	core::StringMap<int8_t> paletteMap(getPaletteArray().size());
 	int paletteIndex = 1;
 	{
@@ -680,28 +679,28 @@ bool SchematicFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const
 			sampler.movePositiveZ();
 		}
 		compound.put("Blocks", priv::NamedBinaryTag(core::move(blocks)));
-		if (schematicType->strVal() == "mcedit2") {
+		if (schematicType == "mcedit2") {
 			priv::NBTCompound paletteTag;
 			for (const auto &e : paletteMap) {
 				const core::String key = core::string::toString((int)e->second);
 				paletteTag.put(key, priv::NamedBinaryTag(e->first));
 			}
 			compound.put("BlockIDs", core::move(paletteTag));
-		} else if (schematicType->strVal() == "worldedit") {
+		} else if (schematicType == "worldedit") {
 			priv::NBTCompound paletteTag;
 			for (const auto &e : paletteMap) {
 				paletteTag.put(e->first, (int32_t)e->second);
 			}
 			compound.put("Palette", core::move(paletteTag));
 			compound.put("PaletteMax", (int32_t)paletteMap.size());
-		} else if (schematicType->strVal() == "schematica") {
+		} else if (schematicType == "schematica") {
 			priv::NBTCompound paletteTag;
 			for (const auto &e : paletteMap) {
 				paletteTag.put(e->first, (int16_t)e->second);
 			}
 			compound.put("SchematicaMapping", core::move(paletteTag));
 		} else {
-			Log::error("Unknown schematic type: %s", schematicType->strVal().c_str());
+			Log::error("Unknown schematic type: %s", schematicType.c_str());
 		}
 	}
 	const priv::NamedBinaryTag tag(core::move(compound));
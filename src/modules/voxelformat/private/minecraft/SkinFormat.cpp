@@ -5,7 +5,6 @@
 #include "SkinFormat.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
-#include "core/Var.h"
 #include "image/Image.h"
 #include "math/Rect.h"
 #include "palette/Palette.h"
@@ -327,9 +326,9 @@ bool SkinFormat::loadGroupsRGBA(const core::String &filename, const io::ArchiveP
 		return false;
 	}
 
-	const bool applyTransform = core::Var::getSafe(cfg::VoxformatSkinApplyTransform)->boolVal();
-	const bool addGroup = core::Var::getSafe(cfg::VoxformatSkinAddGroups)->boolVal();
-	const bool mergeFaces = core::Var::getSafe(cfg::VoxformatSkinMergeFaces)->boolVal();
+	const bool applyTransform = ctx.config.skinApplyTransform;
+	const bool addGroup = ctx.config.skinAddGroups;
+	const bool mergeFaces = ctx.config.skinMergeFaces;
 
 	const SkinBox *boxes = skinBoxes;
 	int nBoxes = lengthof(skinBoxes);
@@ -3,15 +3,18 @@
  */
 
 #include "QBCLFormat.h"
+#include "app/Async.h"
 #include "core/Assert.h"
 #include "color/Color.h"
 #include "core/FourCC.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
 #include "core/StringUtil.h"
+#include "core/concurrent/Atomic.h"
 #include "image/Image.h"
 #include "io/Archive.h"
 #include "io/BufferedReadWriteStream.h"
+#include "io/MemoryReadStream.h"
 #include "io/Stream.h"
 #include "io/ZipReadStream.h"
 #include "io/ZipWriteStream.h"
@@ -139,13 +142,158 @@ static bool writeRLE(io::WriteStream &stream, color::RGBA color, uint8_t count)
 	return true;
 }
 
+/**
+ * @brief Amount of equal colors at the beginning of the given column
+ *
+ * Four colors are compared per iteration to allow the compiler to vectorize the scan.
+ */
+static int runLength(const uint32_t *colors, int n) {
+	const uint32_t color = colors[0];
+	int i = 1;
+	for (; i + 4 <= n; i += 4) {
+		const uint32_t diff = (colors[i] ^ color) | (colors[i + 1] ^ color) | (colors[i + 2] ^ color) | (colors[i + 3] ^ color);
+		if (diff != 0u) {
+			break;
+		}
+	}
+	while (i < n && colors[i] == color) {
+		++i;
+	}
+	return i;
+}
+
+/**
+ * @brief Writes the rle entries of one column and returns the amount of rle entries (in 4 byte units)
+ */
+static int writeColumn(io::WriteStream &stream, const uint32_t *colors, int n) {
+	int rleEntries = 0;
+	for (int y = 0; y < n;) {
+		int count = runLength(colors + y, n - y);
+		const color::RGBA color(colors[y]);
+		y += count;
+		for (; count > 0; count -= 255) {
+			const uint8_t chunk = (uint8_t)core_min(count, 255);
+			if (!writeRLE(stream, color, chunk)) {
+				return -1;
+			}
+			rleEntries += core_min((int)chunk, 2);
+		}
+	}
+	return rleEntries;
+}
+
+const core::Buffer<uint8_t> *QBCLFormat::EncodedMatrices::find(int nodeId) const {
+	int idx;
+	if (!indices.get(nodeId, idx)) {
+		return nullptr;
+	}
+	return &compressed[idx];
+}
+
+bool QBCLFormat::encodeMatrix(const scenegraph::SceneGraph &sceneGraph, const scenegraph::SceneGraphNode &node,
+							  core::Buffer<uint8_t> &compressed) const {
+	const voxel::Region &region = sceneGraph.resolveRegion(node);
+	const glm::ivec3 &mins = region.getLowerCorner();
+	const glm::ivec3 size = region.getDimensionsInVoxels();
+	const voxel::RawVolume *v = sceneGraph.resolveVolume(node);
+	const palette::Palette &palette = node.palette();
+
+	// every x slice is encoded into its own buffer - they are concatenated in order afterwards
+	core::DynamicArray<io::BufferedReadWriteStream *> slices;
+	slices.resize(size.x);
+	core::AtomicBool success{true};
+	auto fn = [v, &palette, &mins, &size, &slices, &success](int start, int end) {
+		constexpr voxel::Voxel Empty;
+		core::Buffer<uint32_t> colors(size.y);
+		voxel::RawVolume::Sampler sampler(v);
+		for (int x = start; x < end; ++x) {
+			io::BufferedReadWriteStream *slice = new io::BufferedReadWriteStream(size.z * size.y * 8);
+			slices[x] = slice;
+			for (int z = 0; z < size.z; ++z) {
+				sampler.setPosition(mins.x + x, mins.y, mins.z + z);
+				for (int y = 0; y < size.y; ++y) {
+					const voxel::Voxel &voxel = sampler.voxel();
+					sampler.movePositiveY();
+					if (voxel.isSameType(Empty)) {
+						colors[y] = 0u;
+					} else {
+						colors[y] = palette.color(voxel.getColor());
+					}
+				}
+				// remember the position in the stream because we have
+				// to write the real value after the column was written
+				const int64_t dataSizePos = slice->pos();
+				slice->writeUInt16(0);
+				const int rleEntries = writeColumn(*slice, colors.data(), size.y);
+				if (rleEntries < 0 || slice->seek(dataSizePos) == -1 || !slice->writeUInt16((uint16_t)rleEntries) ||
+					slice->seek(0, SEEK_END) == -1) {
+					success = false;
+					return;
+				}
+			}
+		}
+	};
+	app::for_parallel(0, size.x, fn);
+
+	int64_t rleSize = 0;
+	for (const io::BufferedReadWriteStream *slice : slices) {
+		if (slice != nullptr) {
+			rleSize += slice->size();
+		}
+	}
+	io::BufferedReadWriteStream bufferStream(rleSize / 2);
+	{
+		io::ZipWriteStream zipStream(bufferStream);
+		for (io::BufferedReadWriteStream *slice : slices) {
+			if (success && (slice == nullptr || zipStream.write(slice->getBuffer(), slice->size()) == -1)) {
+				Log::error("Could not write compressed data");
+				success = false;
+			}
+			delete slice;
+		}
+		if (success && !zipStream.flush()) {
+			success = false;
+		}
+	}
+	if (!success) {
+		return false;
+	}
+	compressed.append(bufferStream.getBuffer(), (size_t)bufferStream.size());
+	return true;
+}
+
+bool QBCLFormat::encodeMatrices(const scenegraph::SceneGraph &sceneGraph, EncodedMatrices &encoded) const {
+	for (const auto &entry : sceneGraph.nodes()) {
+		const scenegraph::SceneGraphNode &node = entry->second;
+		if (node.isAnyModelNode()) {
+			encoded.indices.put(node.id(), (int)encoded.nodeIds.size());
+			encoded.nodeIds.push_back(node.id());
+		}
+	}
+	encoded.compressed.resize(encoded.nodeIds.size());
+	core::AtomicBool success{true};
+	auto fn = [this, &sceneGraph, &encoded, &success](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			const scenegraph::SceneGraphNode &node = sceneGraph.node(encoded.nodeIds[i]);
+			if (!encodeMatrix(sceneGraph, node, encoded.compressed[i])) {
+				success = false;
+			}
+		}
+	};
+	app::for_parallel(0, (int)encoded.nodeIds.size(), fn);
+	return success;
+}
+
 bool QBCLFormat::saveMatrix(io::SeekableWriteStream &outStream, const scenegraph::SceneGraph &sceneGraph,
-							const scenegraph::SceneGraphNode &node) const {
+							const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const {
+	const core::Buffer<uint8_t> *compressed = encoded.find(node.id());
+	if (compressed == nullptr) {
+		Log::error("Could not save qbcl file: no voxel data for node %s", node.name().c_str());
+		return false;
+	}
 	const voxel::Region &region = sceneGraph.resolveRegion(node);
 	const scenegraph::SceneGraphTransform &transform = node.transform(0);
 	const glm::ivec3 &translation = transform.localTranslation();
-	const glm::ivec3 &mins = region.getLowerCorner();
-	const glm::ivec3 &maxs = region.getUpperCorner();
 	const glm::ivec3 size = region.getDimensionsInVoxels();
 
 	wrapSave(outStream.writeUInt32(1)) // unknown
@@ -167,81 +315,25 @@ bool QBCLFormat::saveMatrix(io::SeekableWriteStream &outStream, const scenegraph
 	wrapSave(outStream.writeFloat(/* TODO: VOXELFORMAT: mins.y +*/ normalizedPivot.y * size.y))
 	wrapSave(outStream.writeFloat(/* TODO: VOXELFORMAT: mins.z +*/ normalizedPivot.z * size.z))
 
-	constexpr voxel::Voxel Empty;
-
-	uint32_t voxelDataSizePos = outStream.pos();
-	wrapSave(outStream.writeUInt32(0));
-
-	io::BufferedReadWriteStream rleDataStream(size.x * size.y * size.z * 32);
-
-	const voxel::RawVolume *v = sceneGraph.resolveVolume(node);
-	const palette::Palette &palette = node.palette();
-	for (int x = mins.x; x <= maxs.x; ++x) {
-		for (int z = mins.z; z <= maxs.z; ++z) {
-			color::RGBA currentColor;
-			uint16_t rleEntries = 0;
-			uint8_t count = 0;
-
-			// remember the position in the stream because we have
-			// to write the real value after the z loop
-			const int64_t dataSizePos = rleDataStream.pos();
-			wrapSave(rleDataStream.writeUInt16(rleEntries))
-			for (int y = mins.y; y <= maxs.y; ++y) {
-				const voxel::Voxel &voxel = v->voxel(x, y, z);
-				color::RGBA newColor;
-				if (voxel.isSameType(Empty)) {
-					newColor = 0;
-					Log::trace("Save empty voxel: x %i, y %i, z %i", x, y, z);
-				} else {
-					newColor = palette.color(voxel.getColor());
-					Log::trace("Save voxel: x %i, y %i, z %i (color: index(%i) => rgba(%i:%i:%i:%i))", x, y, z,
-							   (int)voxel.getColor(), (int)newColor.r, (int)newColor.g, (int)newColor.b,
-							   (int)newColor.a);
-				}
-				if (newColor != currentColor || count == 255) {
-					wrapSave(writeRLE(rleDataStream, currentColor, count))
-					rleEntries += core_min(count, 2);
-					count = 0;
-					currentColor = newColor;
-				}
-				++count;
-			}
-			wrapSave(writeRLE(rleDataStream, currentColor, count))
-			rleEntries += core_min(count, 2);
-
-			wrapSaveNegative(rleDataStream.seek(dataSizePos))
-			wrapSave(rleDataStream.writeUInt16(rleEntries))
-			wrapSaveNegative(rleDataStream.seek(0, SEEK_END))
-		}
-	}
-
-	io::ZipWriteStream zipStream(outStream);
-	if (zipStream.write(rleDataStream.getBuffer(), rleDataStream.size()) == -1) {
-		Log::error("Could not write compressed data");
-		return false;
-	}
-	wrapSave(zipStream.flush())
-	const int64_t compressedDataSize = zipStream.size();
-	wrapSaveNegative(outStream.seek(voxelDataSizePos))
-	wrapSave(outStream.writeUInt32(compressedDataSize))
-	wrapSaveNegative(outStream.seek(0, SEEK_END))
+	wrapSave(outStream.writeUInt32((uint32_t)compressed->size()))
+	wrapSaveNegative(outStream.write(compressed->data(), compressed->size()))
 
 	return true;
 }
 
 bool QBCLFormat::saveCompound(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-							  const scenegraph::SceneGraphNode &node) const {
-	wrapSave(saveMatrix(stream, sceneGraph, node))
+							  const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const {
+	wrapSave(saveMatrix(stream, sceneGraph, node, encoded))
 	wrapSave(stream.writeUInt32((int)node.children().size()));
 	for (int nodeId : node.children()) {
 		const scenegraph::SceneGraphNode &cnode = sceneGraph.node(nodeId);
-		wrapSave(saveNode(stream, sceneGraph, cnode))
+		wrapSave(saveNode(stream, sceneGraph, cnode, encoded))
 	}
 	return true;
 }
 
 bool QBCLFormat::saveModel(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-						   const scenegraph::SceneGraphNode &node) const {
+						   const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const {
 	const uint32_t children = (uint32_t)node.children().size();
 	qbcl::ScopedQBCLHeader header(stream, node.type());
 	wrapSave(stream.writeUInt32(1)) // unknown
@@ -259,25 +351,25 @@ bool QBCLFormat::saveModel(io::SeekableWriteStream &stream, const scenegraph::Sc
 
 	for (int nodeId : node.children()) {
 		const scenegraph::SceneGraphNode &cnode = sceneGraph.node(nodeId);
-		wrapSave(saveNode(stream, sceneGraph, cnode))
+		wrapSave(saveNode(stream, sceneGraph, cnode, encoded))
 	}
 
 	return true;
 }
 
 bool QBCLFormat::saveNode(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-						  const scenegraph::SceneGraphNode &node) const {
+						  const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const {
 	const scenegraph::SceneGraphNodeType type = node.type();
 	if (node.isAnyModelNode()) {
 		if (node.children().empty()) {
 			qbcl::ScopedQBCLHeader header(stream, node.type());
-			wrapSave(saveMatrix(stream, sceneGraph, node) && header.success())
+			wrapSave(saveMatrix(stream, sceneGraph, node, encoded) && header.success())
 		} else {
 			qbcl::ScopedQBCLHeader scoped(stream, qbcl::NODE_TYPE_COMPOUND);
-			wrapSave(saveCompound(stream, sceneGraph, node) && scoped.success())
+			wrapSave(saveCompound(stream, sceneGraph, node, encoded) && scoped.success())
 		}
 	} else if (type == scenegraph::SceneGraphNodeType::Group || type == scenegraph::SceneGraphNodeType::Root) {
-		wrapSave(saveModel(stream, sceneGraph, node))
+		wrapSave(saveModel(stream, sceneGraph, node, encoded))
 	}
 	return true;
 }
@@ -331,7 +423,11 @@ bool QBCLFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const core
 	wrapSave(stream->writePascalStringUInt32LE(rootNode.property(scenegraph::PropCopyright)))
 	wrapSave(stream->writeUInt64(0)) // timestamp1
 	wrapSave(stream->writeUInt64(0)) // timestamp2
-	return saveNode(*stream, sceneGraph, sceneGraph.root());
+	EncodedMatrices encoded;
+	if (!encodeMatrices(sceneGraph, encoded)) {
+		return false;
+	}
+	return saveNode(*stream, sceneGraph, sceneGraph.root(), encoded);
 }
 
 size_t QBCLFormat::loadPalette(const core::String &filename, const io::ArchivePtr &archive, palette::Palette &palette,
@@ -347,6 +443,7 @@ size_t QBCLFormat::loadPalette(const core::String &filename, const io::ArchivePt
 
 	scenegraph::SceneGraph sceneGraph;
 	wrapBool(readNodes(filename, *stream, sceneGraph, sceneGraph.root().id(), palette, header))
+	wrapBool(decodeMatrices(sceneGraph, palette, header))
 
 	Log::debug("qbcl: loaded %i colors", palette.colorCount());
 	return palette.colorCount();
@@ -400,87 +497,26 @@ bool QBCLFormat::readMatrix(const core::String &filename, io::SeekableReadStream
 		return false;
 	}
 
-	io::ZipReadStream zipStream(stream, (int)compressedDataSize);
-	core::ScopedPtr<voxel::RawVolume> volume(new voxel::RawVolume(region));
-	uint32_t index = 0;
-
-	palette::PaletteLookup palLookup(palette);
-
-	while (!zipStream.eos()) {
-		int y = 0;
-		uint16_t rleEntries;
-		wrap(zipStream.readUInt16(rleEntries))
-		for (int i = 0; i < (int)rleEntries; i++) {
-			uint8_t red;
-			uint8_t green;
-			uint8_t blue;
-			uint8_t mask;
-
-			wrap(zipStream.readUInt8(red))
-			wrap(zipStream.readUInt8(green))
-			wrap(zipStream.readUInt8(blue))
-			wrap(zipStream.readUInt8(mask))
-
-			if (mask == qbcl::RLE_FLAG) {
-				uint8_t rleLength = red;
-				uint8_t alpha;
-				wrap(zipStream.readUInt8(red))
-				wrap(zipStream.readUInt8(green))
-				wrap(zipStream.readUInt8(blue))
-				wrap(zipStream.readUInt8(alpha))
-
-				if (alpha == 0) {
-					y += rleLength;
-				} else {
-					const color::RGBA color = flattenRGB(red, green, blue, 255 /* TODO: VOXELFORMAT: alpha support? */);
-					if (header.loadPalette) {
-						palette.tryAdd(color, false);
-					} else {
-						const uint8_t palIndex = palLookup.findClosestIndex(color);
-						const voxel::Voxel &voxel = voxel::createVoxel(palette, palIndex);
-						const uint32_t x = (index / size.z);
-						const uint32_t z = index % size.z;
-						voxel::RawVolume::Sampler sampler(volume);
-						sampler.setPosition((int)x, y, (int)z);
-						for (int j = 0; j < rleLength; ++j) {
-							sampler.setVoxel(voxel);
-							sampler.movePositiveY();
-						}
-						y += rleLength;
-					}
-				}
-				// we've read another color value for the rle values
-				++i;
-			} else if (mask == 0) {
-				++y;
-			} else {
-				// Uncompressed
-				const color::RGBA color = flattenRGB(red, green, blue, 255 /* TODO: VOXELFORMAT: alpha support? */);
-				if (header.loadPalette) {
-					palette.tryAdd(color, false);
-				} else {
-					const uint32_t x = (index / size.z);
-					const uint32_t z = index % size.z;
-					const uint8_t palIndex = palLookup.findClosestIndex(color);
-					const voxel::Voxel &voxel = voxel::createVoxel(palette, palIndex);
-					volume->setVoxel((int)x, y, (int)z, voxel);
-				}
-				++y;
-			}
-		}
-
-		index++;
+	// the rle data is decompressed and decoded in parallel once all nodes were read
+	MatrixData matrix;
+	matrix.size = size;
+	matrix.compressed.resize(compressedDataSize);
+	if (stream.read(matrix.compressed.data(), compressedDataSize) != (int)compressedDataSize) {
+		Log::error("Could not load qbcl file: Not enough data for the voxels of matrix %s", name.c_str());
+		return false;
 	}
 
 	if (header.loadPalette) {
+		header.matrices.emplace_back(core::move(matrix));
 		return true;
 	}
 
+	core::ScopedPtr<voxel::RawVolume> volume(new voxel::RawVolume(region));
 	scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
 	node.setVolume(volume.release(), true);
 	node.setVisible(nodeHeader.visible);
 	node.setLocked(nodeHeader.locked);
-	node.setPalette(palLookup.palette());
+	node.setPalette(palette);
 	if (name.empty()) {
 		node.setName("Matrix");
 	} else {
@@ -491,7 +527,142 @@ bool QBCLFormat::readMatrix(const core::String &filename, io::SeekableReadStream
 	// the pivot is given in voxel coordinates
 	// node.setPivot(pivot / glm::vec3(size)); // TODO: VOXELFORMAT:
 	const int id = sceneGraph.emplace(core::move(node), parent);
-	return id != -1;
+	if (id == -1) {
+		return false;
+	}
+	matrix.nodeId = id;
+	header.matrices.emplace_back(core::move(matrix));
+	return true;
+}
+
+/**
+ * @brief Calls the given functor for every solid voxel run in the decompressed rle data of a matrix
+ * @return @c false if the data is truncated
+ */
+template<class FUNC>
+static bool visitRLE(const uint8_t *data, size_t dataSize, const glm::uvec3 &size, FUNC &&func) {
+	size_t pos = 0;
+	uint32_t index = 0;
+	while (pos < dataSize) {
+		if (pos + 2 > dataSize) {
+			return false;
+		}
+		const int rleEntries = (int)data[pos] | ((int)data[pos + 1] << 8);
+		pos += 2;
+		const int x = (int)(index / size.z);
+		const int z = (int)(index % size.z);
+		int y = 0;
+		for (int i = 0; i < rleEntries; i++) {
+			if (pos + 4 > dataSize) {
+				return false;
+			}
+			const uint8_t *entry = data + pos;
+			pos += 4;
+			if (entry[3] == qbcl::RLE_FLAG) {
+				if (pos + 4 > dataSize) {
+					return false;
+				}
+				const uint8_t rleLength = entry[0];
+				const uint8_t *rgba = data + pos;
+				pos += 4;
+				if (rgba[3] != 0) {
+					func(x, y, z, (int)rleLength, rgba[0], rgba[1], rgba[2]);
+				}
+				y += rleLength;
+				// we've read another color value for the rle values
+				++i;
+			} else if (entry[3] == 0) {
+				++y;
+			} else {
+				// Uncompressed
+				func(x, y, z, 1, entry[0], entry[1], entry[2]);
+				++y;
+			}
+		}
+		index++;
+	}
+	return true;
+}
+
+static bool decompress(const core::Buffer<uint8_t> &compressed, core::Buffer<uint8_t> &rleData) {
+	io::MemoryReadStream memStream(compressed.data(), compressed.size());
+	io::ZipReadStream zipStream(memStream, (int)memStream.size());
+	uint8_t buf[65536];
+	for (;;) {
+		const int read = zipStream.read(buf, sizeof(buf));
+		if (read < 0) {
+			return false;
+		}
+		if (read == 0) {
+			break;
+		}
+		rleData.append(buf, read);
+	}
+	return true;
+}
+
+bool QBCLFormat::decodeMatrices(scenegraph::SceneGraph &sceneGraph, palette::Palette &palette, Header &header) {
+	const int matrixCount = (int)header.matrices.size();
+	if (header.loadPalette) {
+		core::DynamicArray<core::Buffer<uint8_t>> rleData;
+		rleData.resize(matrixCount);
+		core::AtomicBool success{true};
+		app::for_parallel(0, matrixCount, [&header, &rleData, &success](int start, int end) {
+			for (int i = start; i < end; ++i) {
+				if (!decompress(header.matrices[i].compressed, rleData[i])) {
+					success = false;
+				}
+			}
+		});
+		if (!success) {
+			Log::error("Could not load qbcl file: Failed to decompress the voxel data");
+			return false;
+		}
+		// the palette indices depend on the order the colors are added - keep the file order here
+		for (int i = 0; i < matrixCount; ++i) {
+			auto fn = [this, &palette](int, int, int, int, uint8_t r, uint8_t g, uint8_t b) {
+				palette.tryAdd(flattenRGB(r, g, b, 255 /* TODO: VOXELFORMAT: alpha support? */), false);
+			};
+			if (!visitRLE(rleData[i].data(), rleData[i].size(), header.matrices[i].size, fn)) {
+				Log::error("Could not load qbcl file: Not enough rle data in matrix %i", i);
+				return false;
+			}
+		}
+		header.matrices.clear();
+		return true;
+	}
+
+	palette::PaletteLookup palLookup(palette);
+	core::AtomicBool success{true};
+	auto fn = [this, &sceneGraph, &header, &palLookup, &palette, &success](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			const MatrixData &matrix = header.matrices[i];
+			core::Buffer<uint8_t> rleData;
+			if (!decompress(matrix.compressed, rleData)) {
+				Log::error("Could not load qbcl file: Failed to decompress the voxel data of matrix %i", i);
+				success = false;
+				continue;
+			}
+			voxel::RawVolume::Sampler sampler(sceneGraph.node(matrix.nodeId).volume());
+			auto setVoxels = [this, &sampler, &palLookup, &palette](int x, int y, int z, int length, uint8_t r,
+																	 uint8_t g, uint8_t b) {
+				const color::RGBA color = flattenRGB(r, g, b, 255 /* TODO: VOXELFORMAT: alpha support? */);
+				const voxel::Voxel voxel = voxel::createVoxel(palette, palLookup.findClosestIndex(color));
+				sampler.setPosition(x, y, z);
+				for (int j = 0; j < length; ++j) {
+					sampler.setVoxel(voxel);
+					sampler.movePositiveY();
+				}
+			};
+			if (!visitRLE(rleData.data(), rleData.size(), matrix.size, setVoxels)) {
+				Log::error("Could not load qbcl file: Not enough rle data in matrix %i", i);
+				success = false;
+			}
+		}
+	};
+	app::for_parallel(0, matrixCount, fn);
+	header.matrices.clear();
+	return success;
 }
 
 bool QBCLFormat::readModel(const core::String &filename, io::SeekableReadStream &stream,
@@ -631,6 +802,7 @@ bool QBCLFormat::loadGroupsRGBA(const core::String &filename, const io::ArchiveP
 
 	palette::Palette palCopy = palette;
 	wrapBool(readNodes(filename, *stream, sceneGraph, -1, palCopy, header))
+	wrapBool(decodeMatrices(sceneGraph, palCopy, header))
 
 	scenegraph::SceneGraphNode &rootNode = sceneGraph.node(sceneGraph.root().id());
 	rootNode.setProperty(scenegraph::PropTitle, header.title);
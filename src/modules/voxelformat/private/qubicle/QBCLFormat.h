@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include "core/collection/Buffer.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/Map.h"
 #include "io/Stream.h"
 #include "voxelformat/Format.h"
 
@@ -22,6 +25,15 @@ namespace voxelformat {
  */
 class QBCLFormat : public RGBAFormat {
 private:
+	/**
+	 * @brief The still compressed rle data of a matrix node - decoded after all nodes were read
+	 */
+	struct MatrixData {
+		// the node to fill - or -1 if only the palette is loaded
+		int nodeId = -1;
+		glm::uvec3 size{0};
+		core::Buffer<uint8_t> compressed;
+	};
 	struct Header {
 		uint32_t magic = 0;
 		uint32_t version = 0; // (major, minor, release, build)
@@ -38,22 +50,42 @@ private:
 		uint64_t timestamp1;
 		uint64_t timestamp2;
 		bool loadPalette = false;
+		core::DynamicArray<MatrixData> matrices;
+	};
+	/**
+	 * @brief The compressed rle data of all model nodes - encoded in parallel before the nodes are written
+	 */
+	struct EncodedMatrices {
+		core::DynamicArray<int> nodeIds;
+		core::DynamicArray<core::Buffer<uint8_t>> compressed;
+		// node id to index into the arrays
+		core::Map<int, int, 251> indices;
+
+		const core::Buffer<uint8_t> *find(int nodeId) const;
 	};
 	struct NodeHeader {
 		bool visible;
 		bool unknown;
 		bool locked;
 	};
+	bool encodeMatrix(const scenegraph::SceneGraph &sceneGraph, const scenegraph::SceneGraphNode &node,
+					  core::Buffer<uint8_t> &compressed) const;
+	bool encodeMatrices(const scenegraph::SceneGraph &sceneGraph, EncodedMatrices &encoded) const;
 	bool saveMatrix(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-					const scenegraph::SceneGraphNode &node) const;
+					const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const;
 	bool saveModel(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-				   const scenegraph::SceneGraphNode &node) const;
+				   const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const;
 	bool saveNode(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-				  const scenegraph::SceneGraphNode &node) const;
+				  const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const;
 	bool saveCompound(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-					  const scenegraph::SceneGraphNode &node) const;
+					  const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const;
 
 	bool readHeader(io::SeekableReadStream &stream, Header &header);
+	/**
+	 * @brief Decompresses the collected matrices in parallel and fills the volumes of the nodes - or the palette
+	 * if @c Header::loadPalette is set
+	 */
+	bool decodeMatrices(scenegraph::SceneGraph &sceneGraph, palette::Palette &palette, Header &header);
 	bool readMatrix(const core::String &filename, io::SeekableReadStream &stream, scenegraph::SceneGraph &sceneGraph,
 					int parent, const core::String &name, palette::Palette &palette, Header &header,
 					const NodeHeader &nodeHeader);
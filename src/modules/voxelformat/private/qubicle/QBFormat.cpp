@@ -7,7 +7,6 @@
 #include "core/Enum.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
-#include "core/Var.h"
 #include "core/collection/DynamicMap.h"
 #include "io/Stream.h"
 #include "scenegraph/SceneGraph.h"
@@ -200,9 +199,9 @@ bool QBFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const core::
 	}
 	wrapSave(stream->writeUInt32(257)) // version
 	wrapSave(stream->writeUInt32((uint32_t)ColorFormat::RGBA))
-	const bool leftHanded = core::Var::getSafe(cfg::VoxformatQBSaveLeftHanded)->boolVal();
+	const bool leftHanded = ctx.config.qbSaveLeftHanded;
 	const ZAxisOrientation orientation = leftHanded ? ZAxisOrientation::LeftHanded : ZAxisOrientation::RightHanded;
-	const bool rleCompressed = core::Var::getSafe(cfg::VoxformatQBSaveCompressed)->boolVal();
+	const bool rleCompressed = ctx.config.qbSaveCompressed;
 	wrapSave(stream->writeUInt32((uint32_t)orientation))
 	wrapSave(stream->writeUInt32(rleCompressed ? (uint32_t)Compression::RLE : (uint32_t)Compression::None))
 	wrapSave(stream->writeUInt32((uint32_t)VisibilityMask::AlphaChannelVisibleByValue))
@@ -3,15 +3,16 @@
  */
 
 #include "QBTFormat.h"
+#include "app/Async.h"
 #include "color/Color.h"
 #include "core/Common.h"
 #include "core/FourCC.h"
 #include "core/GLM.h"
-#include "core/ConfigVar.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
-#include "core/Var.h"
+#include "core/concurrent/Atomic.h"
 #include "io/BufferedReadWriteStream.h"
+#include "io/MemoryReadStream.h"
 #include "io/Stream.h"
 #include "io/ZipReadStream.h"
 #include "io/ZipWriteStream.h"
@@ -130,50 +131,96 @@ public:
 		return false;                                                                                                  \
 	}
 
-bool QBTFormat::saveMatrix(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-						   const scenegraph::SceneGraphNode &node, bool colorMap) const {
+const core::Buffer<uint8_t> *QBTFormat::EncodedMatrices::find(int nodeId) const {
+	int idx;
+	if (!indices.get(nodeId, idx)) {
+		return nullptr;
+	}
+	return &compressed[idx];
+}
+
+bool QBTFormat::encodeMatrix(const scenegraph::SceneGraph &sceneGraph, const scenegraph::SceneGraphNode &node,
+							 bool colorMap, core::Buffer<uint8_t> &compressed) const {
 	const voxel::Region &region = sceneGraph.resolveRegion(node);
 	const glm::ivec3 &mins = region.getLowerCorner();
-	const glm::ivec3 &maxs = region.getUpperCorner();
 	const glm::ivec3 size = region.getDimensionsInVoxels();
-
 	const palette::Palette &palette = node.palette();
-
-	const int zlibBufSize = size.x * size.y * size.z * (int)sizeof(uint32_t);
-	io::BufferedReadWriteStream bufferStream(zlibBufSize);
-	io::ZipWriteStream zipStream(bufferStream);
-
 	const voxel::RawVolume *v = sceneGraph.resolveVolume(node);
-	for (int x = mins.x; x <= maxs.x; ++x) {
-		for (int z = mins.z; z <= maxs.z; ++z) {
-			for (int y = mins.y; y <= maxs.y; ++y) {
-				const voxel::Voxel &voxel = v->voxel(x, y, z);
-				if (isAir(voxel.getMaterial())) {
-					zipStream.writeUInt8(0);
-					zipStream.writeUInt8(0);
-					zipStream.writeUInt8(0);
-					zipStream.writeUInt8(0); // mask 0 == air
-					continue;
-				}
-				if (colorMap) {
-					zipStream.writeUInt8(voxel.getColor());
-					zipStream.writeUInt8(0);
-					zipStream.writeUInt8(0);
-				} else {
-					const color::RGBA voxelColor = palette.color(voxel.getColor());
-					// const uint8_t alpha = voxelColor.a * 255.0f;
-					zipStream.writeUInt8(voxelColor.r);
-					zipStream.writeUInt8(voxelColor.g);
-					zipStream.writeUInt8(voxelColor.b);
+
+	// x is running slowest - so every x slice is a contiguous block in the uncompressed data
+	const size_t sliceBytes = (size_t)size.z * (size_t)size.y * sizeof(uint32_t);
+	// zero initialized - mask 0 == air
+	core::Buffer<uint8_t> rgbm(sliceBytes * (size_t)size.x);
+	auto fn = [v, &rgbm, &palette, &mins, &size, sliceBytes, colorMap](int start, int end) {
+		voxel::RawVolume::Sampler sampler(v);
+		for (int x = start; x < end; ++x) {
+			uint8_t *out = rgbm.data() + (size_t)x * sliceBytes;
+			for (int z = 0; z < size.z; ++z) {
+				sampler.setPosition(mins.x + x, mins.y, mins.z + z);
+				for (int y = 0; y < size.y; ++y, out += 4) {
+					const voxel::Voxel &voxel = sampler.voxel();
+					sampler.movePositiveY();
+					if (isAir(voxel.getMaterial())) {
+						continue;
+					}
+					if (colorMap) {
+						out[0] = voxel.getColor();
+					} else {
+						const color::RGBA voxelColor = palette.color(voxel.getColor());
+						out[0] = voxelColor.r;
+						out[1] = voxelColor.g;
+						out[2] = voxelColor.b;
+					}
+					// mask != 0 means solid, 1 is core (surrounded by others and not visible)
+					// TODO: VOXELFORMAT: const voxel::FaceBits faceBits = voxel::visibleFaces(v, x, y, z);
+					out[3] = 0xff;
 				}
-				// mask != 0 means solid, 1 is core (surrounded by others and not visible)
-				// TODO: VOXELFORMAT: const voxel::FaceBits faceBits = voxel::visibleFaces(v, x, y, z);
-				zipStream.writeUInt8(0xff);
 			}
 		}
-	}
+	};
+	app::for_parallel(0, size.x, fn);
 
+	io::BufferedReadWriteStream bufferStream((int64_t)rgbm.size());
+	io::ZipWriteStream zipStream(bufferStream);
+	if (zipStream.write(rgbm.data(), rgbm.size()) == -1) {
+		Log::error("Could not save qbt file: failed to compress the voxel data of %s", node.name().c_str());
+		return false;
+	}
 	zipStream.flush();
+	compressed.append(bufferStream.getBuffer(), (size_t)bufferStream.size());
+	return true;
+}
+
+bool QBTFormat::encodeMatrices(const scenegraph::SceneGraph &sceneGraph, EncodedMatrices &encoded) const {
+	for (const auto &entry : sceneGraph.nodes()) {
+		const scenegraph::SceneGraphNode &node = entry->second;
+		if (node.isAnyModelNode()) {
+			encoded.indices.put(node.id(), (int)encoded.nodeIds.size());
+			encoded.nodeIds.push_back(node.id());
+		}
+	}
+	encoded.compressed.resize(encoded.nodeIds.size());
+	core::AtomicBool success{true};
+	auto fn = [this, &sceneGraph, &encoded, &success](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			const scenegraph::SceneGraphNode &node = sceneGraph.node(encoded.nodeIds[i]);
+			if (!encodeMatrix(sceneGraph, node, encoded.colorMap, encoded.compressed[i])) {
+				success = false;
+			}
+		}
+	};
+	app::for_parallel(0, (int)encoded.nodeIds.size(), fn);
+	return success;
+}
+
+bool QBTFormat::saveMatrix(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
+						   const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const {
+	const core::Buffer<uint8_t> *compressed = encoded.find(node.id());
+	if (compressed == nullptr) {
+		Log::error("Could not save qbt file: no voxel data for node %s", node.name().c_str());
+		return false;
+	}
+	const glm::ivec3 size = sceneGraph.resolveRegion(node).getDimensionsInVoxels();
 
 	wrapSave(stream.writePascalStringUInt32LE(node.name()));
 	Log::debug("Save matrix with name %s", node.name().c_str());
@@ -199,9 +246,9 @@ bool QBTFormat::saveMatrix(io::SeekableWriteStream &stream, const scenegraph::Sc
 	wrapSave(stream.writeUInt32(size.y));
 	wrapSave(stream.writeUInt32(size.z));
 
-	Log::debug("save %i compressed bytes", (int)bufferStream.size());
-	wrapSave(stream.writeUInt32(bufferStream.size()));
-	if (stream.write(bufferStream.getBuffer(), bufferStream.size()) == -1) {
+	Log::debug("save %i compressed bytes", (int)compressed->size());
+	wrapSave(stream.writeUInt32((uint32_t)compressed->size()));
+	if (stream.write(compressed->data(), compressed->size()) == -1) {
 		Log::error("Could not save qbt file: failed to write the compressed buffer");
 		return false;
 	}
@@ -223,39 +270,39 @@ bool QBTFormat::saveColorMap(io::SeekableWriteStream &stream, const palette::Pal
 }
 
 bool QBTFormat::saveCompound(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-							 const scenegraph::SceneGraphNode &node, bool colorMap) const {
-	wrapSave(saveMatrix(stream, sceneGraph, node, colorMap))
+							 const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const {
+	wrapSave(saveMatrix(stream, sceneGraph, node, encoded))
 	wrapSave(stream.writeUInt32((int)node.children().size()));
 	for (int nodeId : node.children()) {
 		const scenegraph::SceneGraphNode &cnode = sceneGraph.node(nodeId);
-		wrapSave(saveNode(stream, sceneGraph, cnode, colorMap))
+		wrapSave(saveNode(stream, sceneGraph, cnode, encoded))
 	}
 	return true;
 }
 
 bool QBTFormat::saveNode(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-						 const scenegraph::SceneGraphNode &node, bool colorMap) const {
+						 const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const {
 	const scenegraph::SceneGraphNodeType type = node.type();
 	if (node.isAnyModelNode()) {
 		if (node.children().empty()) {
 			qbt::ScopedQBTHeader header(stream, type);
-			wrapSave(saveMatrix(stream, sceneGraph, node, colorMap) && header.success())
+			wrapSave(saveMatrix(stream, sceneGraph, node, encoded) && header.success())
 		} else {
 			qbt::ScopedQBTHeader scoped(stream, qbt::NODE_TYPE_COMPOUND);
-			wrapSave(saveCompound(stream, sceneGraph, node, colorMap) && scoped.success())
+			wrapSave(saveCompound(stream, sceneGraph, node, encoded) && scoped.success())
 		}
 	} else if (type == scenegraph::SceneGraphNodeType::Group || type == scenegraph::SceneGraphNodeType::Root) {
-		wrapSave(saveModel(stream, sceneGraph, node, colorMap))
+		wrapSave(saveModel(stream, sceneGraph, node, encoded))
 	}
 	return true;
 }
 
 bool QBTFormat::saveModel(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-						  const scenegraph::SceneGraphNode &node, bool colorMap) const {
+						  const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const {
 	if (node.children().size() == 1) {
 		for (int nodeId : node.children()) {
 			const scenegraph::SceneGraphNode &cnode = sceneGraph.node(nodeId);
-			wrapSave(saveNode(stream, sceneGraph, cnode, colorMap))
+			wrapSave(saveNode(stream, sceneGraph, cnode, encoded))
 		}
 		return true;
 	}
@@ -264,7 +311,7 @@ bool QBTFormat::saveModel(io::SeekableWriteStream &stream, const scenegraph::Sce
 	wrapSave(stream.writeUInt32(children));
 	for (int nodeId : node.children()) {
 		const scenegraph::SceneGraphNode &cnode = sceneGraph.node(nodeId);
-		wrapSave(saveNode(stream, sceneGraph, cnode, colorMap))
+		wrapSave(saveNode(stream, sceneGraph, cnode, encoded))
 	}
 	return scoped.success();
 }
@@ -290,8 +337,12 @@ bool QBTFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const core:
 	wrapSave(stream->writeFloat(1.0f)); // globalscale
 	wrapSave(stream->writeFloat(1.0f)); // globalscale
 	wrapSave(stream->writeFloat(1.0f)); // globalscale
-	const bool colorMap = core::Var::getSafe(cfg::VoxformatQBTPaletteMode)->boolVal();
-	if (colorMap) {
+	EncodedMatrices encoded;
+	encoded.colorMap = ctx.config.qbtPaletteMode;
+	if (!encodeMatrices(sceneGraph, encoded)) {
+		return false;
+	}
+	if (encoded.colorMap) {
 		const palette::Palette &palette = sceneGraph.firstPalette();
 		if (!saveColorMap(*stream, palette)) {
 			return false;
@@ -305,7 +356,7 @@ bool QBTFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const core:
 	if (!stream->writeString("DATATREE", false)) {
 		return false;
 	}
-	return saveNode(*stream, sceneGraph, sceneGraph.root(), colorMap);
+	return saveNode(*stream, sceneGraph, sceneGraph.root(), encoded);
 }
 
 bool QBTFormat::skipNode(io::SeekableReadStream &stream) {
@@ -338,7 +389,7 @@ bool QBTFormat::loadCompound(io::SeekableReadStream &stream, scenegraph::SceneGr
 	if (!loadMatrix(stream, sceneGraph, nodeId, palette, state)) {
 		return false;
 	}
-	const bool mergeCompounds = core::Var::getSafe(cfg::VoxformatQBTMergeCompounds)->boolVal();
+	const bool mergeCompounds = _config.qbtMergeCompounds;
 	uint32_t childCount;
 	wrap(stream.readUInt32(childCount));
 	Log::debug("Load %u children", childCount);
@@ -427,42 +478,20 @@ bool QBTFormat::loadMatrix(io::SeekableReadStream &stream, scenegraph::SceneGrap
 		Log::warn("Size of matrix results in empty space - voxelDataSize: %u", voxelDataSize);
 		return false;
 	}
-	io::ZipReadStream zipStream(stream, voxelDataSize);
-
 	const voxel::Region region(glm::ivec3(0), glm::ivec3(size) - 1);
 	if (!region.isValid()) {
 		Log::error("Invalid region");
 		return false;
 	}
-	core::ScopedPtr<voxel::RawVolume> volume(new voxel::RawVolume(region));
-	// TODO: PERF: use volume sampler
-	for (int32_t x = 0; x < (int)size.x; x++) {
-		for (int32_t z = 0; z < (int)size.z; z++) {
-			for (int32_t y = 0; y < (int)size.y; y++) {
-				uint8_t red;
-				wrap(zipStream.readUInt8(red))
-				uint8_t green;
-				wrap(zipStream.readUInt8(green))
-				uint8_t blue;
-				wrap(zipStream.readUInt8(blue))
-				uint8_t mask;
-				wrap(zipStream.readUInt8(mask))
-				if (mask == 0u) {
-					continue;
-				}
-				if (state.colorFormat == ColorFormat::Palette) {
-					const voxel::Voxel &voxel = voxel::createVoxel(palette, red);
-					volume->setVoxel(x, y, z, voxel);
-				} else {
-					const color::RGBA color = flattenRGB(red, green, blue);
-					uint8_t index = 1;
-					palette.tryAdd(color, false, &index);
-					const voxel::Voxel &voxel = voxel::createVoxel(palette, index);
-					volume->setVoxel(x, y, z, voxel);
-				}
-			}
-		}
+	// the voxel data is decompressed and converted in parallel once the whole data tree was parsed
+	MatrixData matrix;
+	matrix.size = glm::ivec3(size);
+	matrix.compressed.resize(voxelDataSize);
+	if (stream.read(matrix.compressed.data(), voxelDataSize) != (int)voxelDataSize) {
+		Log::error("Could not load qbt file: Not enough data for the voxels of matrix %s", name.c_str());
+		return false;
 	}
+	core::ScopedPtr<voxel::RawVolume> volume(new voxel::RawVolume(region));
 	scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
 	node.setVolume(volume.release(), true);
 	node.setName(name);
@@ -471,7 +500,90 @@ bool QBTFormat::loadMatrix(io::SeekableReadStream &stream, scenegraph::SceneGrap
 	const scenegraph::KeyFrameIndex keyFrameIdx = 0;
 	node.setTransform(keyFrameIdx, transform);
 	const int id = sceneGraph.emplace(core::move(node), parent);
-	return id != InvalidNodeId;
+	if (id == InvalidNodeId) {
+		return false;
+	}
+	matrix.nodeId = id;
+	state.matrices.emplace_back(core::move(matrix));
+	return true;
+}
+
+bool QBTFormat::decodeMatrices(scenegraph::SceneGraph &sceneGraph, palette::Palette &palette, Header &state) {
+	const int matrixCount = (int)state.matrices.size();
+	core::DynamicArray<core::Buffer<uint8_t>> rgbm;
+	rgbm.resize(matrixCount);
+	core::AtomicBool success{true};
+	auto decompress = [&state, &rgbm, &success](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			const MatrixData &matrix = state.matrices[i];
+			const size_t bytes = (size_t)matrix.size.x * (size_t)matrix.size.y * (size_t)matrix.size.z * sizeof(uint32_t);
+			rgbm[i].resize(bytes);
+			io::MemoryReadStream memStream(matrix.compressed.data(), matrix.compressed.size());
+			io::ZipReadStream zipStream(memStream, (int)memStream.size());
+			if (zipStream.read(rgbm[i].data(), bytes) != (int)bytes) {
+				Log::error("Could not load qbt file: Not enough voxel data in matrix %i", i);
+				success = false;
+			}
+		}
+	};
+	app::for_parallel(0, matrixCount, decompress);
+	if (!success) {
+		return false;
+	}
+
+	for (int i = 0; i < matrixCount; ++i) {
+		const MatrixData &matrix = state.matrices[i];
+		voxel::RawVolume *volume = sceneGraph.node(matrix.nodeId).volume();
+		const glm::ivec3 &size = matrix.size;
+		const size_t sliceBytes = (size_t)size.z * (size_t)size.y * sizeof(uint32_t);
+		const uint8_t *data = rgbm[i].data();
+		if (state.colorFormat == ColorFormat::Palette) {
+			// the palette isn't modified here - so the x slices can be converted in parallel
+			auto fn = [volume, data, &size, sliceBytes, &palette](int start, int end) {
+				voxel::RawVolume::Sampler sampler(volume);
+				for (int x = start; x < end; ++x) {
+					const uint8_t *in = data + (size_t)x * sliceBytes;
+					for (int z = 0; z < size.z; ++z) {
+						sampler.setPosition(x, 0, z);
+						for (int y = 0; y < size.y; ++y, in += 4) {
+							if (in[3] != 0u) {
+								sampler.setVoxel(voxel::createVoxel(palette, in[0]));
+							}
+							sampler.movePositiveY();
+						}
+					}
+				}
+			};
+			app::for_parallel(0, size.x, fn);
+		} else {
+			// the palette indices depend on the order the colors are added - keep the file order here
+			voxel::RawVolume::Sampler sampler(volume);
+			// flattenRGB() always returns opaque colors - so this never matches
+			color::RGBA lastColor(0, 0, 0, 0);
+			uint8_t lastIndex = 1;
+			const uint8_t *in = data;
+			for (int x = 0; x < size.x; ++x) {
+				for (int z = 0; z < size.z; ++z) {
+					sampler.setPosition(x, 0, z);
+					for (int y = 0; y < size.y; ++y, in += 4) {
+						if (in[3] != 0u) {
+							const color::RGBA color = flattenRGB(in[0], in[1], in[2]);
+							if (color != lastColor) {
+								lastIndex = 1;
+								palette.tryAdd(color, false, &lastIndex);
+								lastColor = color;
+							}
+							sampler.setVoxel(voxel::createVoxel(palette, lastIndex));
+						}
+						sampler.movePositiveY();
+					}
+				}
+			}
+		}
+		rgbm[i].release();
+	}
+	state.matrices.clear();
+	return true;
 }
 
 /**
@@ -657,6 +769,10 @@ size_t QBTFormat::loadPalette(const core::String &filename, const io::ArchivePtr
 				Log::error("Failed to load node");
 				return 0u;
 			}
+			if (!decodeMatrices(sceneGraph, palette, state)) {
+				Log::error("Failed to load the voxel data");
+				return 0u;
+			}
 		} else {
 			Log::error("Unknown section found: %c%c%c%c%c%c%c%c", buf[0], buf[1], buf[2], buf[3], buf[4], buf[5],
 					   buf[6], buf[7]);
@@ -704,6 +820,10 @@ bool QBTFormat::loadGroupsPalette(const core::String &filename, const io::Archiv
 			return false;
 		}
 	}
+	if (!decodeMatrices(sceneGraph, palette, state)) {
+		Log::error("Failed to load the voxel data");
+		return false;
+	}
 	for (auto iter = sceneGraph.beginModel(); iter != sceneGraph.end(); ++iter) {
 		scenegraph::SceneGraphNode &node = *iter;
 		node.setPalette(palette);
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include "core/collection/Buffer.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/Map.h"
 #include "voxelformat/Format.h"
 
 namespace voxelformat {
@@ -23,14 +26,39 @@ namespace voxelformat {
 class QBTFormat : public PaletteFormat {
 private:
 	enum class ColorFormat : uint8_t { RGBA, Palette };
+	/**
+	 * @brief The still compressed voxel data of a matrix node - decoded after the data tree was parsed
+	 */
+	struct MatrixData {
+		int nodeId = -1;
+		glm::ivec3 size{0};
+		core::Buffer<uint8_t> compressed;
+	};
 	struct Header {
 		uint8_t versionMajor = 0;
 		uint8_t versionMinor = 0;
 		ColorFormat colorFormat = ColorFormat::RGBA;
 		glm::vec3 globalScale{0};
+		core::DynamicArray<MatrixData> matrices;
+	};
+	/**
+	 * @brief The compressed voxel data of all model nodes - encoded in parallel before the data tree is written
+	 */
+	struct EncodedMatrices {
+		core::DynamicArray<int> nodeIds;
+		core::DynamicArray<core::Buffer<uint8_t>> compressed;
+		// node id to index into the arrays
+		core::Map<int, int, 251> indices;
+		bool colorMap = false;
+
+		const core::Buffer<uint8_t> *find(int nodeId) const;
 	};
 
 	bool loadHeader(io::SeekableReadStream &stream, Header &state);
+	/**
+	 * @brief Decompresses the collected matrices in parallel and fills the volumes of the nodes
+	 */
+	bool decodeMatrices(scenegraph::SceneGraph &sceneGraph, palette::Palette &palette, Header &state);
 
 	bool skipNode(io::SeekableReadStream &stream);
 	bool loadMatrix(io::SeekableReadStream &stream, scenegraph::SceneGraph &sceneGraph, int parent,
@@ -46,15 +74,18 @@ private:
 						   scenegraph::SceneGraph &sceneGraph, palette::Palette &palette,
 						   const LoadContext &ctx) override;
 
+	bool encodeMatrix(const scenegraph::SceneGraph &sceneGraph, const scenegraph::SceneGraphNode &node, bool colorMap,
+					  core::Buffer<uint8_t> &compressed) const;
+	bool encodeMatrices(const scenegraph::SceneGraph &sceneGraph, EncodedMatrices &encoded) const;
 	bool saveNode(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-				  const scenegraph::SceneGraphNode &node, bool colorMap) const;
+				  const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const;
 	bool saveCompound(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-					  const scenegraph::SceneGraphNode &node, bool colorMap) const;
+					  const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const;
 	bool saveMatrix(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-					const scenegraph::SceneGraphNode &node, bool colorMap) const;
+					const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const;
 	bool saveColorMap(io::SeekableWriteStream &stream, const palette::Palette &palette) const;
 	bool saveModel(io::SeekableWriteStream &stream, const scenegraph::SceneGraph &sceneGraph,
-				   const scenegraph::SceneGraphNode &node, bool colorMap) const;
+				   const scenegraph::SceneGraphNode &node, const EncodedMatrices &encoded) const;
 	bool saveGroups(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
 					const io::ArchivePtr &archive, const SaveContext &ctx) override;
 
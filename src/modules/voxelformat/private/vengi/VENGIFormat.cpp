@@ -3,14 +3,16 @@
  */
 
 #include "VENGIFormat.h"
+#include "app/Async.h"
 #include "core/ArrayLength.h"
 #include "core/FourCC.h"
-#include "core/ConfigVar.h"
 #include "core/Log.h"
 #include "core/ScopedPtr.h"
-#include "core/Var.h"
+#include "core/StandardLib.h"
 #include "core/collection/Array.h"
+#include "core/concurrent/Atomic.h"
 #include "io/BufferedReadWriteStream.h"
+#include "io/MemoryReadStream.h"
 #include "io/ZipReadStream.h"
 #include "io/ZipWriteStream.h"
 #include "palette/Material.h"
@@ -97,7 +99,17 @@ bool VENGIFormat::saveNodeData(const scenegraph::SceneGraph &sceneGraph, const s
 	wrapBool(stream.writeInt32(region.getUpperX()))
 	wrapBool(stream.writeInt32(region.getUpperY()))
 	wrapBool(stream.writeInt32(region.getUpperZ()))
-	const int replaceIndex = core::Var::getSafe(cfg::VoxformatEmptyPaletteIndex)->intVal();
+	int payloadIndex;
+	if (_payloadIndices.get(node.id(), payloadIndex)) {
+		// the voxels are stored in payloads after the scene graph data
+		const int slices = _rawPayloads ? region.getWidthInVoxels() : payloadSlices(region);
+		const int payloadCount = (region.getWidthInVoxels() + slices - 1) / slices;
+		wrapBool(stream.writeUInt32((uint32_t)slices))
+		wrapBool(stream.writeUInt32((uint32_t)payloadIndex))
+		wrapBool(stream.writeUInt32((uint32_t)payloadCount))
+		return true;
+	}
+	const int replaceIndex = _config.emptyPaletteIndex;
 	int replacement = -1;
 	if (replaceIndex != -1) {
 		replacement = node.palette().findReplacement(replaceIndex);
@@ -260,11 +272,60 @@ bool VENGIFormat::loadNodeData(scenegraph::SceneGraph &sceneGraph, scenegraph::S
 	wrap(stream.readInt32(maxs.z))
 	Log::debug("Load region of %i:%i:%i %i:%i:%i", mins.x, mins.y, mins.z, maxs.x, maxs.y, maxs.z);
 	const voxel::Region region(mins, maxs);
-	voxel::RawVolume *v = new voxel::RawVolume(region);
+	if (!region.isValid()) {
+		Log::error("Invalid region for node %s", node.name().c_str());
+		return false;
+	}
+	voxel::RawVolume *v;
+	if (_rawPayloads) {
+		// the voxels are read into the uninitialized memory once the whole scene graph is loaded
+		voxel::Voxel *data = (voxel::Voxel *)core_malloc(voxel::RawVolume::size(region));
+		if (data == nullptr) {
+			Log::error("Failed to allocate the memory for node %s", node.name().c_str());
+			return false;
+		}
+		v = voxel::RawVolume::createRaw(data, region);
+	} else {
+		v = new voxel::RawVolume(region);
+	}
 	node.setVolume(v, true);
 	const palette::Palette &palette = node.palette();
 
-	if (version >= 4u) {
+	if (version >= 7u) {
+		// the voxels are decoded once the whole scene graph is loaded
+		uint32_t slices;
+		wrap(stream.readUInt32(slices))
+		uint32_t firstPayload;
+		wrap(stream.readUInt32(firstPayload))
+		uint32_t payloadCount;
+		wrap(stream.readUInt32(payloadCount))
+		const uint32_t width = (uint32_t)region.getWidthInVoxels();
+		if (slices == 0u || payloadCount != (width + slices - 1u) / slices ||
+			(uint64_t)firstPayload + payloadCount > (uint64_t)_payloads.size()) {
+			Log::error("Invalid payload range %u/%u for node %s", firstPayload, payloadCount, node.name().c_str());
+			return false;
+		}
+		for (uint32_t i = 0u; i < payloadCount; ++i) {
+			Payload &payload = _payloads[firstPayload + i];
+			if (payload.nodeId != InvalidNodeId) {
+				Log::error("Payload %u is used by more than one node", firstPayload + i);
+				return false;
+			}
+			payload.nodeId = node.id();
+			payload.lowerX = region.getLowerX() + (int)(i * slices);
+			payload.upperX = core_min(payload.lowerX + (int)slices - 1, region.getUpperX());
+			if (_rawPayloads) {
+				continue;
+			}
+			// every voxel is stored with one or three bytes
+			const uint64_t voxels = (uint64_t)region.getHeightInVoxels() * (uint64_t)region.getDepthInVoxels() *
+									(uint64_t)(payload.upperX - payload.lowerX + 1);
+			if (payload.uncompressedSize < voxels || payload.uncompressedSize > voxels * 3u) {
+				Log::error("Payload %u doesn't match the region of node %s", firstPayload + i, node.name().c_str());
+				return false;
+			}
+		}
+	} else if (version >= 4u) {
 		union Data {
 			uint16_t data;
 			struct {
@@ -569,6 +630,407 @@ bool VENGIFormat::loadNode(scenegraph::SceneGraph &sceneGraph, int parent, uint3
 	return false;
 }
 
+// the uncompressed size of a payload is read into memory at once
+static constexpr uint32_t MaxPayloadSize = 1u << 30;
+// deflate can't compress the data better than about 1:1032
+static constexpr uint64_t MaxCompressionRatio = 1032u;
+
+int VENGIFormat::payloadSlices(const voxel::Region &region) {
+	// roughly one million voxels per payload
+	const int sliceVoxels = region.getHeightInVoxels() * region.getDepthInVoxels();
+	return core_max(1, core_min(region.getWidthInVoxels(), (1 << 20) / core_max(1, sliceVoxels)));
+}
+
+bool VENGIFormat::encodePayload(const scenegraph::SceneGraphNode &node, int replaceIndex, int replacement,
+								Payload &payload) const {
+	const voxel::RawVolume *v = node.volume();
+	const voxel::Region &region = v->region();
+	const size_t sliceVoxels = (size_t)region.getHeightInVoxels() * (size_t)region.getDepthInVoxels();
+	// air is stored as one byte, solid voxels with three bytes
+	core::Buffer<uint8_t> raw(sliceVoxels * (size_t)(payload.upperX - payload.lowerX + 1) * 3u);
+	uint8_t *out = raw.data();
+	voxel::RawVolume::Sampler sampler(v);
+	for (int x = payload.lowerX; x <= payload.upperX; ++x) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			sampler.setPosition(x, y, region.getLowerZ());
+			for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+				const voxel::Voxel &voxel = sampler.voxel();
+				sampler.movePositiveZ();
+				const bool air = isAir(voxel.getMaterial());
+				*out++ = air ? 1u : 0u;
+				if (air) {
+					continue;
+				}
+				*out++ = voxel.getColor() == replaceIndex ? (uint8_t)replacement : voxel.getColor();
+				*out++ = voxel.getNormal();
+			}
+		}
+	}
+	payload.uncompressedSize = (uint32_t)(out - raw.data());
+	io::BufferedReadWriteStream compressed(payload.uncompressedSize / 4 + 64);
+	{
+		io::ZipWriteStream zipStream(compressed);
+		if (zipStream.write(raw.data(), payload.uncompressedSize) == -1 || !zipStream.flush()) {
+			Log::error("Failed to compress the voxels of node %s", node.name().c_str());
+			return false;
+		}
+	}
+	payload.compressed.append(compressed.getBuffer(), (size_t)compressed.size());
+	return true;
+}
+
+bool VENGIFormat::decodePayload(scenegraph::SceneGraph &sceneGraph, const Payload &payload) const {
+	scenegraph::SceneGraphNode &node = sceneGraph.node(payload.nodeId);
+	voxel::RawVolume *v = node.volume();
+	const voxel::Region &region = v->region();
+	const palette::Palette &palette = node.palette();
+
+	core::Buffer<uint8_t> raw;
+	raw.resize(payload.uncompressedSize);
+	io::MemoryReadStream memStream(payload.compressed.data(), payload.compressed.size());
+	io::ZipReadStream zipStream(memStream, (int)memStream.size());
+	if (zipStream.read(raw.data(), raw.size()) != (int)raw.size()) {
+		Log::error("Failed to decompress the voxels of node %s", node.name().c_str());
+		return false;
+	}
+	const uint8_t *in = raw.data();
+	const uint8_t *end = in + raw.size();
+	voxel::RawVolume::Sampler sampler(v);
+	for (int x = payload.lowerX; x <= payload.upperX; ++x) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			sampler.setPosition(x, y, region.getLowerZ());
+			for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+				if (in >= end) {
+					Log::error("Not enough voxel data for node %s", node.name().c_str());
+					return false;
+				}
+				const bool air = *in++ != 0u;
+				if (!air) {
+					if (in + 2 > end) {
+						Log::error("Not enough voxel data for node %s", node.name().c_str());
+						return false;
+					}
+					sampler.setVoxel(voxel::createVoxel(palette, in[0], in[1]));
+					in += 2;
+				}
+				sampler.movePositiveZ();
+			}
+		}
+	}
+	return true;
+}
+
+bool VENGIFormat::saveIndexed(const scenegraph::SceneGraph &sceneGraph, io::SeekableWriteStream &stream) {
+	const int replaceIndex = _config.emptyPaletteIndex;
+	core::DynamicArray<int> replacements;
+	for (const auto &entry : sceneGraph.nodes()) {
+		const scenegraph::SceneGraphNode &node = entry->second;
+		if (node.type() != scenegraph::SceneGraphNodeType::Model) {
+			continue;
+		}
+		const voxel::Region &region = node.volume()->region();
+		const int slices = payloadSlices(region);
+		_payloadIndices.put(node.id(), (int)_payloads.size());
+		const int replacement = replaceIndex == -1 ? -1 : node.palette().findReplacement(replaceIndex);
+		for (int x = region.getLowerX(); x <= region.getUpperX(); x += slices) {
+			Payload payload;
+			payload.nodeId = node.id();
+			payload.lowerX = x;
+			payload.upperX = core_min(x + slices - 1, region.getUpperX());
+			_payloads.emplace_back(core::move(payload));
+			replacements.push_back(replacement);
+		}
+	}
+	core::AtomicBool success{true};
+	auto fn = [this, &sceneGraph, &replacements, replaceIndex, &success](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			Payload &payload = _payloads[i];
+			if (!encodePayload(sceneGraph.node(payload.nodeId), replaceIndex, replacements[i], payload)) {
+				success = false;
+			}
+		}
+	};
+	app::for_parallel(0, (int)_payloads.size(), fn);
+	if (!success) {
+		return false;
+	}
+
+	io::BufferedReadWriteStream treeStream;
+	{
+		io::ZipWriteStream zipStream(treeStream);
+		wrapBool(saveNode(sceneGraph, zipStream, sceneGraph.root()))
+		wrapBool(zipStream.flush())
+	}
+
+	wrapBool(stream.writeUInt32(FourCC('V', 'I', 'D', 'X')))
+	wrapBool(stream.writeUInt32(7))
+	wrapBool(stream.writeUInt32((uint32_t)treeStream.size()))
+	wrapBool(stream.writeUInt32((uint32_t)_payloads.size()))
+	uint64_t offset = 0u;
+	for (const Payload &payload : _payloads) {
+		wrapBool(stream.writeUInt64(offset))
+		wrapBool(stream.writeUInt32((uint32_t)payload.compressed.size()))
+		wrapBool(stream.writeUInt32(payload.uncompressedSize))
+		offset += payload.compressed.size();
+	}
+	wrap(stream.write(treeStream.getBuffer(), (size_t)treeStream.size()))
+	for (const Payload &payload : _payloads) {
+		wrap(stream.write(payload.compressed.data(), payload.compressed.size()))
+	}
+	return true;
+}
+
+bool VENGIFormat::loadIndexed(io::SeekableReadStream &stream, scenegraph::SceneGraph &sceneGraph) {
+	uint32_t version;
+	wrap(stream.readUInt32(version))
+	if (version != 7) {
+		Log::error("Unsupported version %u", version);
+		return false;
+	}
+	uint32_t treeSize;
+	wrap(stream.readUInt32(treeSize))
+	uint32_t payloadCount;
+	wrap(stream.readUInt32(payloadCount))
+	// offset, compressed size and uncompressed size per payload
+	const int64_t tableSize = (int64_t)payloadCount * 16;
+	if (tableSize + (int64_t)treeSize > stream.remaining()) {
+		Log::error("Invalid payload table");
+		return false;
+	}
+	core::DynamicArray<uint64_t> offsets;
+	offsets.resize(payloadCount);
+	_payloads.resize(payloadCount);
+	for (uint32_t i = 0u; i < payloadCount; ++i) {
+		uint32_t compressedSize;
+		wrap(stream.readUInt64(offsets[i]))
+		wrap(stream.readUInt32(compressedSize))
+		wrap(stream.readUInt32(_payloads[i].uncompressedSize))
+		if (offsets[i] + compressedSize > (uint64_t)stream.remaining()) {
+			Log::error("Invalid payload %u", i);
+			return false;
+		}
+		// validate the size before it is used for the allocation in decodePayload()
+		const uint32_t uncompressedSize = _payloads[i].uncompressedSize;
+		if (uncompressedSize > MaxPayloadSize ||
+			(uint64_t)uncompressedSize > (uint64_t)compressedSize * MaxCompressionRatio + 64u) {
+			Log::error("Invalid uncompressed size %u of payload %u", uncompressedSize, i);
+			return false;
+		}
+		_payloads[i].compressed.resize(compressedSize);
+	}
+	const int64_t payloadsPos = stream.pos() + treeSize;
+
+	NodeMapping nodeMapping;
+	{
+		io::ZipReadStream zipStream(stream, (int)treeSize);
+		uint32_t chunkMagic;
+		wrap(zipStream.readUInt32(chunkMagic))
+		if (chunkMagic != FourCC('N', 'O', 'D', 'E')) {
+			Log::error("Unknown chunk magic");
+			return false;
+		}
+		if (!loadNode(sceneGraph, sceneGraph.root().id(), version, zipStream, nodeMapping)) {
+			return false;
+		}
+	}
+
+	// the stream is not thread safe - read the compressed voxels sequentially and decode them in parallel
+	for (uint32_t i = 0u; i < payloadCount; ++i) {
+		Payload &payload = _payloads[i];
+		if (payload.nodeId == InvalidNodeId) {
+			continue;
+		}
+		wrap(stream.seek(payloadsPos + (int64_t)offsets[i]))
+		if (stream.read(payload.compressed.data(), payload.compressed.size()) != (int)payload.compressed.size()) {
+			Log::error("Failed to read payload %u", i);
+			return false;
+		}
+	}
+	core::AtomicBool success{true};
+	auto fn = [this, &sceneGraph, &success](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			const Payload &payload = _payloads[i];
+			if (payload.nodeId != InvalidNodeId && !decodePayload(sceneGraph, payload)) {
+				success = false;
+			}
+		}
+	};
+	app::for_parallel(0, (int)payloadCount, fn);
+	if (!success) {
+		return false;
+	}
+	if (!fixupReferences(sceneGraph, nodeMapping)) {
+		return false;
+	}
+	sceneGraph.updateTransforms();
+	return true;
+}
+
+uint32_t VENGIFormat::snapshotVoxelProbe() {
+	const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 0x12, 0x34, 0x1, 0x56);
+	uint32_t probe;
+	static_assert(sizeof(probe) == sizeof(voxel), "Unexpected voxel size");
+	core_memcpy(&probe, &voxel, sizeof(probe));
+	return probe;
+}
+
+// the voxels of the snapshot layout are aligned to allow mapping them into memory
+static constexpr int64_t SnapshotAlignment = 64;
+// int sized reads and writes for huge volumes
+static constexpr int64_t SnapshotMaxBlockSize = 1 << 30;
+
+static bool writeSnapshotPadding(io::SeekableWriteStream &stream) {
+	while (stream.pos() % SnapshotAlignment != 0) {
+		if (!stream.writeUInt8(0u)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool VENGIFormat::saveSnapshot(const scenegraph::SceneGraph &sceneGraph, io::SeekableWriteStream &stream) {
+	core::DynamicArray<uint64_t> sizes;
+	for (const auto &entry : sceneGraph.nodes()) {
+		const scenegraph::SceneGraphNode &node = entry->second;
+		if (node.type() != scenegraph::SceneGraphNodeType::Model) {
+			continue;
+		}
+		const voxel::Region &region = node.volume()->region();
+		_payloadIndices.put(node.id(), (int)_payloads.size());
+		Payload payload;
+		payload.nodeId = node.id();
+		payload.lowerX = region.getLowerX();
+		payload.upperX = region.getUpperX();
+		_payloads.emplace_back(core::move(payload));
+		sizes.push_back((uint64_t)voxel::RawVolume::size(region));
+	}
+
+	io::BufferedReadWriteStream treeStream;
+	wrapBool(saveNode(sceneGraph, treeStream, sceneGraph.root()))
+
+	wrapBool(stream.writeUInt32(FourCC('V', 'S', 'N', 'P')))
+	wrapBool(stream.writeUInt32(7))
+	wrapBool(stream.writeUInt32((uint32_t)sizeof(voxel::Voxel)))
+	wrapBool(stream.writeUInt32(snapshotVoxelProbe()))
+	wrapBool(stream.writeUInt32((uint32_t)treeStream.size()))
+	wrapBool(stream.writeUInt32((uint32_t)_payloads.size()))
+	const int64_t tableSize = (int64_t)_payloads.size() * 16;
+	int64_t offset = stream.pos() + tableSize + treeStream.size();
+	for (size_t i = 0; i < _payloads.size(); ++i) {
+		offset = (offset + SnapshotAlignment - 1) / SnapshotAlignment * SnapshotAlignment;
+		wrapBool(stream.writeUInt64((uint64_t)offset))
+		wrapBool(stream.writeUInt64(sizes[i]))
+		offset += (int64_t)sizes[i];
+	}
+	wrap(stream.write(treeStream.getBuffer(), (size_t)treeStream.size()))
+	for (size_t i = 0; i < _payloads.size(); ++i) {
+		wrapBool(writeSnapshotPadding(stream))
+		const uint8_t *data = sceneGraph.node(_payloads[i].nodeId).volume()->data();
+		for (int64_t written = 0; written < (int64_t)sizes[i]; written += SnapshotMaxBlockSize) {
+			const int64_t blockSize = core_min(SnapshotMaxBlockSize, (int64_t)sizes[i] - written);
+			wrap(stream.write(data + written, (size_t)blockSize))
+		}
+	}
+	return true;
+}
+
+bool VENGIFormat::loadSnapshot(io::SeekableReadStream &stream, scenegraph::SceneGraph &sceneGraph) {
+	uint32_t version;
+	wrap(stream.readUInt32(version))
+	if (version != 7) {
+		Log::error("Unsupported version %u", version);
+		return false;
+	}
+	uint32_t voxelSize;
+	wrap(stream.readUInt32(voxelSize))
+	uint32_t probe;
+	wrap(stream.readUInt32(probe))
+	if (voxelSize != (uint32_t)sizeof(voxel::Voxel) || probe != snapshotVoxelProbe()) {
+		Log::error("The snapshot was written with an incompatible voxel layout");
+		return false;
+	}
+	uint32_t treeSize;
+	wrap(stream.readUInt32(treeSize))
+	uint32_t payloadCount;
+	wrap(stream.readUInt32(payloadCount))
+	const int64_t tableSize = (int64_t)payloadCount * 16;
+	if (tableSize + (int64_t)treeSize > stream.remaining()) {
+		Log::error("Invalid payload table");
+		return false;
+	}
+	core::DynamicArray<uint64_t> offsets;
+	offsets.resize(payloadCount);
+	core::DynamicArray<uint64_t> sizes;
+	sizes.resize(payloadCount);
+	_payloads.resize(payloadCount);
+	for (uint32_t i = 0u; i < payloadCount; ++i) {
+		wrap(stream.readUInt64(offsets[i]))
+		wrap(stream.readUInt64(sizes[i]))
+		if (offsets[i] + sizes[i] > (uint64_t)stream.size()) {
+			Log::error("Invalid payload %u", i);
+			return false;
+		}
+	}
+
+	NodeMapping nodeMapping;
+	uint32_t chunkMagic;
+	wrap(stream.readUInt32(chunkMagic))
+	if (chunkMagic != FourCC('N', 'O', 'D', 'E')) {
+		Log::error("Unknown chunk magic");
+		return false;
+	}
+	if (!loadNode(sceneGraph, sceneGraph.root().id(), version, stream, nodeMapping)) {
+		return false;
+	}
+
+	for (uint32_t i = 0u; i < payloadCount; ++i) {
+		const Payload &payload = _payloads[i];
+		if (payload.nodeId == InvalidNodeId) {
+			continue;
+		}
+		voxel::RawVolume *v = sceneGraph.node(payload.nodeId).volume();
+		if (sizes[i] != (uint64_t)voxel::RawVolume::size(v->region())) {
+			Log::error("Payload %u doesn't match the node region", i);
+			return false;
+		}
+		wrap(stream.seek((int64_t)offsets[i]))
+		uint8_t *data = (uint8_t *)v->voxels();
+		for (int64_t read = 0; read < (int64_t)sizes[i]; read += SnapshotMaxBlockSize) {
+			const int64_t blockSize = core_min(SnapshotMaxBlockSize, (int64_t)sizes[i] - read);
+			if (stream.read(data + read, (size_t)blockSize) != (int)blockSize) {
+				Log::error("Failed to read payload %u", i);
+				return false;
+			}
+		}
+	}
+	for (uint32_t i = 0u; i < payloadCount; ++i) {
+		if (_payloads[i].nodeId == InvalidNodeId) {
+			Log::error("Payload %u is not used by any node", i);
+			return false;
+		}
+	}
+	if (!fixupReferences(sceneGraph, nodeMapping)) {
+		return false;
+	}
+	sceneGraph.updateTransforms();
+	return true;
+}
+
+bool VENGIFormat::fixupReferences(scenegraph::SceneGraph &sceneGraph, const NodeMapping &nodeMapping) const {
+	for (auto iter = sceneGraph.begin(scenegraph::SceneGraphNodeType::ModelReference); iter != sceneGraph.end();
+		 ++iter) {
+		scenegraph::SceneGraphNode &node = *iter;
+		int nodeId;
+		if (!nodeMapping.get(node.reference(), nodeId)) {
+			Log::error("Failed to perform node id mapping for references");
+			return false;
+		}
+		Log::debug("Update node reference for node %i to: %i", node.id(), nodeId);
+		node.setReference(nodeId);
+	}
+	return true;
+}
+
 bool VENGIFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
 							 const io::ArchivePtr &archive, const SaveContext &ctx) {
 	core::ScopedPtr<io::SeekableWriteStream> stream(archive->writeStream(filename));
@@ -577,7 +1039,23 @@ bool VENGIFormat::saveGroups(const scenegraph::SceneGraph &sceneGraph, const cor
 		return false;
 	}
 	Log::debug("Save scenegraph as vengi");
+	_payloads.clear();
+	_payloadIndices.clear();
 	wrapBool(stream->writeUInt32(FourCC('V', 'E', 'N', 'G')))
+	if (_snapshot) {
+		_rawPayloads = true;
+		const bool success = saveSnapshot(sceneGraph, *stream);
+		_rawPayloads = false;
+		_payloads.clear();
+		_payloadIndices.clear();
+		return success;
+	}
+	if (ctx.config.vengiIndexed) {
+		const bool success = saveIndexed(sceneGraph, *stream);
+		_payloads.clear();
+		_payloadIndices.clear();
+		return success;
+	}
 	io::ZipWriteStream zipStream(*stream, stream->size());
 	wrapBool(zipStream.writeUInt32(6))
 	if (!saveNode(sceneGraph, zipStream, sceneGraph.root())) {
@@ -599,10 +1077,29 @@ bool VENGIFormat::loadGroups(const core::String &filename, const io::ArchivePtr
 		Log::error("Invalid vengi magic");
 		return false;
 	}
+	uint32_t layout;
+	wrap(stream->readUInt32(layout))
+	if (layout == FourCC('V', 'I', 'D', 'X')) {
+		_payloads.clear();
+		const bool success = loadIndexed(*stream, sceneGraph);
+		_payloads.clear();
+		return success;
+	}
+	if (layout == FourCC('V', 'S', 'N', 'P')) {
+		_payloads.clear();
+		_rawPayloads = true;
+		const bool success = loadSnapshot(*stream, sceneGraph);
+		_rawPayloads = false;
+		_payloads.clear();
+		return success;
+	}
+	// the zip stream of the older versions starts right after the magic
+	wrap(stream->seek(-4, SEEK_CUR))
 	io::ZipReadStream zipStream(*stream, stream->size());
 	uint32_t version;
 	wrap(zipStream.readUInt32(version))
 	if (version > 6) {
+		// version 7 and newer use the indexed layout
 		Log::error("Unsupported version %u", version);
 		return false;
 	}
@@ -613,16 +1110,8 @@ bool VENGIFormat::loadGroups(const core::String &filename, const io::ArchivePtr
 		if (!loadNode(sceneGraph, sceneGraph.root().id(), version, zipStream, nodeMapping)) {
 			return false;
 		}
-		for (auto iter = sceneGraph.begin(scenegraph::SceneGraphNodeType::ModelReference); iter != sceneGraph.end();
-			 ++iter) {
-			scenegraph::SceneGraphNode &node = *iter;
-			int nodeId;
-			if (!nodeMapping.get(node.reference(), nodeId)) {
-				Log::error("Failed to perform node id mapping for references");
-				return false;
-			}
-			Log::debug("Update node reference for node %i to: %i", node.id(), nodeId);
-			node.setReference(nodeId);
+		if (!fixupReferences(sceneGraph, nodeMapping)) {
+			return false;
 		}
 		sceneGraph.updateTransforms();
 		return true;
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "core/collection/Buffer.h"
+#include "core/collection/DynamicArray.h"
 #include "voxelformat/Format.h"
 #include "scenegraph/SceneGraphNode.h"
 #include "voxel/RawVolume.h"
@@ -15,12 +17,52 @@ namespace voxelformat {
  *
  * It's a RIFF header based format. It stores one palette per model node.
  *
+ * Since version 7 the voxel data of the model nodes is no longer part of the compressed scene graph data. It is
+ * split into ranges of x slices that are compressed independently and located by an offset table - this allows
+ * to encode and decode the voxels in parallel.
+ *
+ * The snapshot layout (see @c VENGISnapshotFormat) stores the voxels uncompressed in the memory layout of
+ * @c voxel::RawVolume.
+ *
  * @ingroup Formats
  */
 class VENGIFormat : public Format {
 private:
 	using NodeMapping = core::Map<int, int>;
 
+	/**
+	 * @brief An independently compressed range of x slices of a model node
+	 */
+	struct Payload {
+		int nodeId = InvalidNodeId;
+		int lowerX = 0;
+		int upperX = -1;
+		uint32_t uncompressedSize = 0u;
+		core::Buffer<uint8_t> compressed;
+	};
+	// the voxel payloads of the indexed layout (version 7)
+	core::DynamicArray<Payload> _payloads;
+	// node id to the index of the first payload of the node
+	NodeMapping _payloadIndices;
+	// the payloads are uncompressed copies of the volume data (snapshot layout)
+	bool _rawPayloads = false;
+
+	/**
+	 * @return The amount of x slices that are put into one payload
+	 */
+	static int payloadSlices(const voxel::Region &region);
+	/**
+	 * @return A voxel in its memory representation to detect incompatible voxel layouts in snapshots
+	 */
+	static uint32_t snapshotVoxelProbe();
+	bool encodePayload(const scenegraph::SceneGraphNode &node, int replaceIndex, int replacement,
+					   Payload &payload) const;
+	bool decodePayload(scenegraph::SceneGraph &sceneGraph, const Payload &payload) const;
+	bool saveIndexed(const scenegraph::SceneGraph &sceneGraph, io::SeekableWriteStream &stream);
+	bool loadIndexed(io::SeekableReadStream &stream, scenegraph::SceneGraph &sceneGraph);
+	bool saveSnapshot(const scenegraph::SceneGraph &sceneGraph, io::SeekableWriteStream &stream);
+	bool loadSnapshot(io::SeekableReadStream &stream, scenegraph::SceneGraph &sceneGraph);
+
 	bool saveNodeProperties(const scenegraph::SceneGraph &sceneGraph, const scenegraph::SceneGraphNode &node,
 							io::WriteStream &stream);
 	bool saveNodeData(const scenegraph::SceneGraph &sceneGraph, const scenegraph::SceneGraphNode &node,
@@ -52,6 +94,11 @@ private:
 								io::ReadStream &stream);
 	bool loadNode(scenegraph::SceneGraph &sceneGraph, int parent, uint32_t version, io::ReadStream &stream,
 				  NodeMapping &nodeMapping);
+	bool fixupReferences(scenegraph::SceneGraph &sceneGraph, const NodeMapping &nodeMapping) const;
+
+protected:
+	// write the snapshot layout
+	bool _snapshot = false;
 
 public:
 	bool saveGroups(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
@@ -65,4 +112,21 @@ public:
 	}
 };
 
+/**
+ * @brief Saves the snapshot layout of the vengi format
+ *
+ * The voxels are not compressed and aligned in the file - they are read directly into the memory of the volumes. This
+ * makes loading mostly limited by the disk bandwidth, but the files are big and can only be loaded on machines with
+ * the same voxel memory layout. It is meant for caches, autosaves and to hand over scenes to other processes. Snapshots
+ * are loaded by @c VENGIFormat.
+ *
+ * @ingroup Formats
+ */
+class VENGISnapshotFormat : public VENGIFormat {
+public:
+	VENGISnapshotFormat() {
+		_snapshot = true;
+	}
+};
+
 } // namespace voxelformat
@@ -23,9 +23,6 @@ private:
 	 * Helper method to load a scenegraph
 	 */
 	bool helper_loadIntoSceneGraph(const core::String &filename, const io::ArchivePtr &archive, Format &format, scenegraph::SceneGraph &sceneGraph);
-	void testSaveLoadVolumes(const core::String &filename, const voxel::RawVolume &v, Format *format,
-							voxel::ValidateFlags flags = voxel::ValidateFlags::All,
-							float maxDelta = 0.001f);
 	void testRGBSmall(const core::String &filename, const io::ArchivePtr &archive, scenegraph::SceneGraph &sceneGraph);
 
 protected:
@@ -40,6 +37,9 @@ protected:
 	io::ArchivePtr helper_archive(const core::String &filename = "");
 	io::ArchivePtr helper_filesystemarchive();
 
+	void testSaveLoadVolumes(const core::String &filename, const voxel::RawVolume &v, Format *format,
+							voxel::ValidateFlags flags = voxel::ValidateFlags::All,
+							float maxDelta = 0.001f);
 	void testFirstAndLastPaletteIndex(const core::String &filename, Format *format, voxel::ValidateFlags flags);
 	void testFirstAndLastPaletteIndexConversion(Format &srcFormat, const core::String &srcFilename, Format &destFormat,
 												const core::String &destFilename,
@@ -4,15 +4,13 @@
 
 #include "voxelformat/private/binvox/BinVoxFormat.h"
 #include "AbstractFormatTest.h"
-#include "core/ConfigVar.h"
-#include "util/VarUtil.h"
 
 namespace voxelformat {
 
 class BinVoxFormatTest : public AbstractFormatTest {
 protected:
 	void saveLoad(int version) {
-		util::ScopedVarChange versionVar(cfg::VoxformatBinvoxVersion, version);
+		testSaveCtx.config.binvoxVersion = version;
 		BinVoxFormat f;
 		// binvox doesn't store palette data, only indices without the color information (since version >= 2).
 		const voxel::ValidateFlags flags =
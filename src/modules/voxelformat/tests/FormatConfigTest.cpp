@@ -0,0 +1,69 @@
+/**
+ * @file
+ */
+
+#include "voxelformat/FormatConfig.h"
+#include "AbstractFormatTest.h"
+#include "app/Async.h"
+#include "core/ArrayLength.h"
+#include "core/ConfigVar.h"
+#include "io/FilesystemArchive.h"
+#include "scenegraph/SceneGraph.h"
+#include "scenegraph/SceneGraphNode.h"
+#include "util/VarUtil.h"
+#include "voxelformat/VolumeFormat.h"
+#include "voxelformat/private/image/PNGFormat.h"
+
+namespace voxelformat {
+
+class FormatConfigTest : public AbstractFormatTest {};
+
+TEST_F(FormatConfigTest, testDefaults) {
+	ASSERT_TRUE(FormatConfig::init());
+	const FormatConfig defaults;
+	EXPECT_EQ(defaults.hash(), FormatConfig::fromVars().hash()) << "The defaults must match the cvar defaults";
+}
+
+TEST_F(FormatConfigTest, testFromVars) {
+	ASSERT_TRUE(FormatConfig::init());
+	const FormatConfig before = FormatConfig::fromVars();
+	{
+		util::ScopedVarChange scale(cfg::VoxformatScale, "2.0");
+		util::ScopedVarChange schematicType(cfg::VoxformatSchematicType, "worldedit");
+		const FormatConfig config = FormatConfig::fromVars();
+		EXPECT_FLOAT_EQ(2.0f, config.scale);
+		EXPECT_EQ("worldedit", config.schematicType);
+		EXPECT_NE(before.hash(), config.hash());
+		EXPECT_FLOAT_EQ(1.0f, before.scale) << "A snapshot must not change with the cvars";
+	}
+	EXPECT_EQ(before.hash(), FormatConfig::fromVars().hash());
+}
+
+TEST_F(FormatConfigTest, testConcurrentLoads) {
+	const io::ArchivePtr &archive = helper_filesystemarchive();
+	io::FileDescription fileDesc;
+	fileDesc.set("test-heightmap.png");
+
+	FormatConfig configs[2];
+	configs[0].imageImportType = PNGFormat::ImageType::Volume;
+	configs[1].imageImportType = PNGFormat::ImageType::Heightmap;
+	const glm::ivec3 expected[2] = {glm::ivec3(8, 8, 3), glm::ivec3(8, 255, 8)};
+	glm::ivec3 dimensions[lengthof(configs)];
+	bool loaded[lengthof(configs)] = {false, false};
+	app::for_parallel(0, lengthof(configs), [&](int start, int end) {
+		for (int i = start; i < end; ++i) {
+			const LoadContext ctx(configs[i]);
+			scenegraph::SceneGraph sceneGraph;
+			loaded[i] = loadFormat(fileDesc, archive, sceneGraph, ctx);
+			if (const scenegraph::SceneGraphNode *node = sceneGraph.firstModelNode()) {
+				dimensions[i] = node->region().getDimensionsInVoxels();
+			}
+		}
+	});
+	for (int i = 0; i < lengthof(configs); ++i) {
+		ASSERT_TRUE(loaded[i]) << "Failed to load with config " << i;
+		EXPECT_EQ(expected[i], dimensions[i]) << "Unexpected dimensions for config " << i;
+	}
+}
+
+} // namespace voxelformat
@@ -16,21 +16,25 @@
 #include "voxelformat/VolumeFormat.h"
 #include "voxelformat/private/mesh/MeshMaterial.h"
 #include "voxelformat/tests/AbstractFormatTest.h"
+#include "voxelutil/VoxelUtil.h"
+#include <thread>
 
 namespace voxelformat {
 
-class MeshFormatTest : public AbstractFormatTest {};
-
-TEST_F(MeshFormatTest, testSubdivide) {
-	MeshTriCollection tinyTris;
-	voxelformat::MeshTri meshTri;
-	meshTri.setVertices(glm::vec3(-8.77272797, -11.43335, -0.154544264),
-						glm::vec3(-8.77272701, 11.1000004, -0.154543981),
-						glm::vec3(8.77272701, 11.1000004, -0.154543981));
-	int depth = 0;
-	MeshFormat::subdivideTri(meshTri, tinyTris, depth);
-	EXPECT_EQ(1024u, tinyTris.size());
-}
+class MeshFormatTest : public AbstractFormatTest {
+protected:
+	class VoxelizeMesh : public MeshFormat {
+	public:
+		bool saveMeshes(const core::Map<int, int> &, const scenegraph::SceneGraph &, const ChunkMeshes &,
+						const core::String &, const io::ArchivePtr &, const glm::vec3 &, bool, bool, bool) override {
+			return false;
+		}
+		void voxelize(scenegraph::SceneGraph &sceneGraph, Mesh &&mesh) {
+			voxelizeMesh("test", sceneGraph, core::move(mesh));
+			sceneGraph.updateTransforms();
+		}
+	};
+};
 
 TEST_F(MeshFormatTest, testColorAt) {
 	const image::ImagePtr &texture = image::loadImage("palette-nippon.png");
@@ -103,19 +107,7 @@ TEST_F(MeshFormatTest, testAreAllTrisAxisAligned) {
 }
 
 TEST_F(MeshFormatTest, testVoxelizeColor) {
-	class TestMesh : public MeshFormat {
-	public:
-		bool saveMeshes(const core::Map<int, int> &, const scenegraph::SceneGraph &, const ChunkMeshes &,
-						const core::String &, const io::ArchivePtr &, const glm::vec3 &, bool, bool, bool) override {
-			return false;
-		}
-		void voxelize(scenegraph::SceneGraph &sceneGraph, Mesh &&mesh) {
-			voxelizeMesh("test", sceneGraph, core::move(mesh));
-			sceneGraph.updateTransforms();
-		}
-	};
-
-	TestMesh testMesh;
+	VoxelizeMesh testMesh;
 	Mesh mesh;
 	video::ShapeBuilder b;
 	scenegraph::SceneGraph sceneGraph;
@@ -159,4 +151,212 @@ TEST_F(MeshFormatTest, testVoxelizeColor) {
 	EXPECT_COLOR_NEAR(nipponGreen, nodePal.color(v->voxel(size - 1, size - 1, size - 1).getColor()), 0.06f);
 }
 
+// the slope crosses the borders of the bricks the triangles are binned into - every column must get exactly one voxel
+TEST_F(MeshFormatTest, testVoxelizeSlope) {
+	VoxelizeMesh testMesh;
+	FormatConfig config = testMesh.config();
+	config.fillHollow = false;
+	testMesh.configure(config);
+
+	const float size = 64.0f;
+	const color::RGBA green(0, 255, 0, 255);
+	const color::RGBA blue(0, 0, 255, 255);
+	const glm::vec3 v00(0.0f, 0.0f, 0.0f);
+	const glm::vec3 v10(size, 0.0f, size / 2.0f);
+	const glm::vec3 v01(0.0f, size, 0.0f);
+	const glm::vec3 v11(size, size, size / 2.0f);
+	Mesh mesh;
+	voxelformat::MeshTri meshTri;
+	meshTri.setVertices(v00, v10, v11);
+	meshTri.setColor(green, blue, blue);
+	mesh.addTriangle(meshTri);
+	meshTri.setVertices(v00, v11, v01);
+	meshTri.setColor(green, blue, green);
+	mesh.addTriangle(meshTri);
+
+	scenegraph::SceneGraph sceneGraph;
+	testMesh.voxelize(sceneGraph, core::move(mesh));
+	scenegraph::SceneGraphNode *node = sceneGraph.findNodeByName("test");
+	ASSERT_NE(nullptr, node);
+	const voxel::RawVolume *v = node->volume();
+	EXPECT_EQ((int)(size * size), voxelutil::countVoxels(*v));
+	for (int x = 0; x < (int)size; ++x) {
+		for (int y = 0; y < (int)size; ++y) {
+			ASSERT_TRUE(voxel::isBlocked(v->voxel(x, y, x / 2).getMaterial())) << x << ":" << y;
+		}
+	}
+	const palette::Palette &nodePal = node->palette();
+	EXPECT_COLOR_NEAR(green, nodePal.color(v->voxel(0, 32, 0).getColor()), 0.06f);
+	EXPECT_COLOR_NEAR(blue, nodePal.color(v->voxel(63, 32, 31).getColor()), 0.06f);
+}
+
+TEST_F(MeshFormatTest, testSaveSharedMeshes) {
+	class TestMesh : public MeshFormat {
+	public:
+		core::Map<int, const voxel::ChunkMesh *> nodeMeshes;
+		bool saveMeshes(const core::Map<int, int> &meshIdxNodeMap, const scenegraph::SceneGraph &,
+						const ChunkMeshes &meshes, const core::String &, const io::ArchivePtr &, const glm::vec3 &,
+						bool, bool, bool) override {
+			for (const auto &e : meshIdxNodeMap) {
+				nodeMeshes.put(e->key, meshes[e->value].mesh);
+			}
+			return true;
+		}
+	};
+
+	palette::Palette pal;
+	pal.nippon();
+	voxel::RawVolume volume(voxel::Region(0, 3));
+	volume.setVoxel(1, 2, 3, voxel::createVoxel(pal, 1));
+	voxel::RawVolume otherVolume(voxel::Region(0, 3));
+	otherVolume.setVoxel(3, 2, 1, voxel::createVoxel(pal, 1));
+
+	scenegraph::SceneGraph sceneGraph;
+	int nodeIds[4];
+	for (int i = 0; i < 4; ++i) {
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		// the first three nodes have the same content
+		node.setVolume(new voxel::RawVolume(i == 3 ? otherVolume : volume), true);
+		node.setPalette(pal);
+		nodeIds[i] = sceneGraph.emplace(core::move(node));
+	}
+	int referenceNodeId;
+	{
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::ModelReference);
+		node.setReference(nodeIds[1]);
+		node.setPalette(pal);
+		referenceNodeId = sceneGraph.emplace(core::move(node));
+	}
+
+	TestMesh testMesh;
+	ASSERT_TRUE(testMesh.save(sceneGraph, "shared", helper_archive(), testSaveCtx));
+	const voxel::ChunkMesh *mesh = nullptr;
+	ASSERT_TRUE(testMesh.nodeMeshes.get(nodeIds[0], mesh));
+	const voxel::ChunkMesh *otherMesh = nullptr;
+	ASSERT_TRUE(testMesh.nodeMeshes.get(nodeIds[3], otherMesh));
+	EXPECT_NE(mesh, otherMesh);
+	const voxel::ChunkMesh *sharedMesh = nullptr;
+	ASSERT_TRUE(testMesh.nodeMeshes.get(nodeIds[1], sharedMesh));
+	EXPECT_EQ(mesh, sharedMesh);
+	ASSERT_TRUE(testMesh.nodeMeshes.get(nodeIds[2], sharedMesh));
+	EXPECT_EQ(mesh, sharedMesh);
+	ASSERT_TRUE(testMesh.nodeMeshes.get(referenceNodeId, sharedMesh));
+	EXPECT_EQ(mesh, sharedMesh);
+}
+
+TEST_F(MeshFormatTest, testDepthFirstNodeOrder) {
+	class TestMesh : public MeshFormat {
+	public:
+		bool saveMeshes(const core::Map<int, int> &, const scenegraph::SceneGraph &, const ChunkMeshes &,
+						const core::String &, const io::ArchivePtr &, const glm::vec3 &, bool, bool, bool) override {
+			return true;
+		}
+		static void order(const scenegraph::SceneGraph &sceneGraph, core::DynamicArray<int> &nodeIds) {
+			depthFirstNodeOrder(sceneGraph, nodeIds);
+		}
+	};
+
+	scenegraph::SceneGraph sceneGraph;
+	const int group = sceneGraph.emplace(scenegraph::SceneGraphNode(scenegraph::SceneGraphNodeType::Group));
+	const int second = sceneGraph.emplace(scenegraph::SceneGraphNode(scenegraph::SceneGraphNodeType::Group));
+	// added after the second top level node - but visited before it
+	const int child = sceneGraph.emplace(scenegraph::SceneGraphNode(scenegraph::SceneGraphNodeType::Group), group);
+	core::DynamicArray<int> nodeIds;
+	TestMesh::order(sceneGraph, nodeIds);
+	ASSERT_EQ(4u, nodeIds.size());
+	EXPECT_EQ(sceneGraph.root().id(), nodeIds[0]);
+	EXPECT_EQ(group, nodeIds[1]);
+	EXPECT_EQ(child, nodeIds[2]);
+	EXPECT_EQ(second, nodeIds[3]);
+}
+
+TEST_F(MeshFormatTest, testSaveReleaseMeshes) {
+	class TestMesh : public MeshFormat {
+	public:
+		int exported = 0;
+		int maxInFlight = 0;
+		int peakMeshes = 0;
+		bool saveMeshes(const core::Map<int, int> &, const scenegraph::SceneGraph &, const ChunkMeshes &meshes,
+						const core::String &, const io::ArchivePtr &, const glm::vec3 &, bool, bool, bool) override {
+			for (size_t i = 0; i < meshes.size(); ++i) {
+				const ChunkMeshExt &meshExt = meshes[i];
+				if (meshExt.mesh != nullptr && !meshExt.mesh->isEmpty()) {
+					++exported;
+				}
+				meshes.release(i);
+			}
+			maxInFlight = meshes.maxInFlight();
+			peakMeshes = meshes.peakMeshes();
+			return true;
+		}
+	};
+
+	palette::Palette pal;
+	pal.nippon();
+	scenegraph::SceneGraph sceneGraph;
+	const int nodes = 64;
+	for (int i = 0; i < nodes; ++i) {
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		voxel::RawVolume *volume = new voxel::RawVolume(voxel::Region(0, 7));
+		// different content for each node - no shared meshes
+		volume->setVoxel(i % 8, (i / 8) % 8, 0, voxel::createVoxel(pal, 1));
+		node.setVolume(volume, true);
+		node.setPalette(pal);
+		sceneGraph.emplace(core::move(node));
+	}
+
+	TestMesh testMesh;
+	ASSERT_TRUE(testMesh.save(sceneGraph, "release", helper_archive(), testSaveCtx));
+	EXPECT_EQ(nodes, testMesh.exported);
+	EXPECT_GT(testMesh.maxInFlight, 0);
+	EXPECT_LE(testMesh.peakMeshes, testMesh.maxInFlight + 1) << "The released meshes must not be kept alive";
+}
+
+TEST_F(MeshFormatTest, testSaveSkipMeshes) {
+	class TestMesh : public MeshFormat {
+	public:
+		int exported = 0;
+		int maxInFlight = 0;
+		int aheadMeshes = 0;
+		bool saveMeshes(const core::Map<int, int> &, const scenegraph::SceneGraph &, const ChunkMeshes &meshes,
+						const core::String &, const io::ArchivePtr &, const glm::vec3 &, bool, bool, bool) override {
+			// wait until the meshes that were extracted ahead are done
+			while (meshes.peakMeshes() < meshes.maxInFlight()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			for (size_t i = 0; i < meshes.size(); ++i) {
+				// the writer skips the first half of the meshes without accessing them
+				if (i >= meshes.size() / 2) {
+					const ChunkMeshExt &meshExt = meshes[i];
+					if (meshExt.mesh != nullptr && !meshExt.mesh->isEmpty()) {
+						++exported;
+					}
+				}
+				meshes.release(i);
+			}
+			maxInFlight = meshes.maxInFlight();
+			aheadMeshes = meshes.aheadMeshes();
+			return true;
+		}
+	};
+
+	palette::Palette pal;
+	pal.nippon();
+	scenegraph::SceneGraph sceneGraph;
+	const int nodes = 64;
+	for (int i = 0; i < nodes; ++i) {
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		voxel::RawVolume *volume = new voxel::RawVolume(voxel::Region(0, 7));
+		volume->setVoxel(i % 8, (i / 8) % 8, 0, voxel::createVoxel(pal, 1));
+		node.setVolume(volume, true);
+		node.setPalette(pal);
+		sceneGraph.emplace(core::move(node));
+	}
+
+	TestMesh testMesh;
+	ASSERT_TRUE(testMesh.save(sceneGraph, "skip", helper_archive(), testSaveCtx));
+	EXPECT_EQ(nodes / 2, testMesh.exported);
+	EXPECT_LT(testMesh.aheadMeshes, testMesh.maxInFlight) << "The skipped meshes must not block the extraction";
+}
+
 } // namespace voxelformat
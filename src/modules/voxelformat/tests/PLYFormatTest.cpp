@@ -3,6 +3,10 @@
  */
 
 #include "AbstractFormatTest.h"
+#include "voxelformat/private/mesh/PLYFormat.h"
+#include "core/ScopedPtr.h"
+#include "io/Stream.h"
+#include "voxelutil/VolumeVisitor.h"
 
 namespace voxelformat {
 
@@ -16,4 +20,89 @@ TEST_F(PLYFormatTest, testVoxelizeCube) {
 	testLoad("cube.ply");
 }
 
+TEST_F(PLYFormatTest, testSaveBinaryAndAscii) {
+	voxel::RawVolume original(voxel::Region(0, 3));
+	for (int i = 0; i < 4; ++i) {
+		original.setVoxel(i, i, 0, voxel::createVoxel(voxel::VoxelType::Generic, i));
+		original.setVoxel(0, i, i, voxel::createVoxel(voxel::VoxelType::Generic, i + 1));
+	}
+	scenegraph::SceneGraph sceneGraphSave;
+	{
+		palette::Palette pal;
+		pal.nippon();
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(&original, false);
+		node.setPalette(pal);
+		sceneGraphSave.emplace(core::move(node));
+	}
+	io::ArchivePtr archive = helper_archive();
+	PLYFormat f;
+	testSaveCtx.config.plyBinary = true;
+	ASSERT_TRUE(f.save(sceneGraphSave, "binary.ply", archive, testSaveCtx));
+	testSaveCtx.config.plyBinary = false;
+	ASSERT_TRUE(f.save(sceneGraphSave, "ascii.ply", archive, testSaveCtx));
+
+	scenegraph::SceneGraph sceneGraphBinary;
+	ASSERT_TRUE(f.load("binary.ply", archive, sceneGraphBinary, testLoadCtx));
+	scenegraph::SceneGraph sceneGraphAscii;
+	ASSERT_TRUE(f.load("ascii.ply", archive, sceneGraphAscii, testLoadCtx));
+	ASSERT_EQ(1u, sceneGraphBinary.size(scenegraph::SceneGraphNodeType::AllModels));
+	voxel::sceneGraphComparator(sceneGraphBinary, sceneGraphAscii, voxel::ValidateFlags::All);
+}
+
+TEST_F(PLYFormatTest, testVoxelizePointCloudBlocks) {
+	io::ArchivePtr archive = helper_archive();
+	// more points than fit into one block and an element after the vertices that must get skipped
+	const int size = 300;
+	{
+		core::ScopedPtr<io::SeekableWriteStream> stream(archive->writeStream("points.ply"));
+		ASSERT_TRUE(stream);
+		ASSERT_TRUE(stream->writeStringFormat(false,
+											  "ply\nformat binary_little_endian 1.0\nelement vertex %i\n"
+											  "property float x\nproperty float y\nproperty float z\n"
+											  "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+											  "element camera 1\nproperty float view_px\nend_header\n",
+											  size * size));
+		for (int z = 0; z < size; ++z) {
+			for (int x = 0; x < size; ++x) {
+				ASSERT_TRUE(stream->writeFloat((float)x));
+				ASSERT_TRUE(stream->writeFloat((float)((x + z) % 4)));
+				ASSERT_TRUE(stream->writeFloat((float)z));
+				ASSERT_TRUE(stream->writeUInt8(x < size / 2 ? 255 : 0));
+				ASSERT_TRUE(stream->writeUInt8(0));
+				ASSERT_TRUE(stream->writeUInt8(x < size / 2 ? 0 : 255));
+			}
+		}
+		ASSERT_TRUE(stream->writeFloat(1.0f));
+	}
+	PLYFormat f;
+	scenegraph::SceneGraph sceneGraph;
+	ASSERT_TRUE(f.load("points.ply", archive, sceneGraph, testLoadCtx));
+	// the point cloud is bigger than one chunk volume
+	EXPECT_EQ(4u, sceneGraph.size(scenegraph::SceneGraphNodeType::Model));
+	int voxels = 0;
+	voxel::Region region = voxel::Region::InvalidRegion;
+	for (auto iter = sceneGraph.beginModel(); iter != sceneGraph.end(); ++iter) {
+		const scenegraph::SceneGraphNode &node = *iter;
+		const voxel::RawVolume *v = node.volume();
+		voxels += voxelutil::countVoxels(*v);
+		if (region.isValid()) {
+			region.accumulate(v->region());
+		} else {
+			region = v->region();
+		}
+		const palette::Palette &palette = node.palette();
+		if (v->region().containsPoint(0, 0, 0)) {
+			voxel::colorComparatorDistance(color::RGBA(255, 0, 0, 255), palette.color(v->voxel(0, 0, 0).getColor()),
+										   0.1f);
+		}
+		if (v->region().containsPoint(size - 1, 1, 2)) {
+			voxel::colorComparatorDistance(color::RGBA(0, 0, 255, 255),
+										   palette.color(v->voxel(size - 1, 1, 2).getColor()), 0.1f);
+		}
+	}
+	EXPECT_EQ(voxel::Region(0, 0, 0, size - 1, 3, size - 1), region);
+	EXPECT_EQ(size * size, voxels);
+}
+
 } // namespace voxelformat
@@ -4,9 +4,11 @@
 
 #include "voxelformat/private/image/PNGFormat.h"
 #include "AbstractFormatTest.h"
+#include "io/Filesystem.h"
+#include "palette/Palette.h"
 #include "scenegraph/SceneGraph.h"
 #include "scenegraph/SceneGraphNode.h"
-#include "util/VarUtil.h"
+#include "voxel/RawVolume.h"
 
 namespace voxelformat {
 
@@ -22,7 +24,7 @@ TEST_F(PNGFormatTest, testLoadPlane) {
 }
 
 TEST_F(PNGFormatTest, testLoadVolume) {
-	util::ScopedVarChange scoped(cfg::VoxformatImageImportType, PNGFormat::ImageType::Volume);
+	testLoadCtx.config.imageImportType = PNGFormat::ImageType::Volume;
 	scenegraph::SceneGraph sceneGraph;
 	testLoad(sceneGraph, "test-heightmap.png", 1);
 	scenegraph::SceneGraphNode *node = sceneGraph.firstModelNode();
@@ -32,7 +34,7 @@ TEST_F(PNGFormatTest, testLoadVolume) {
 }
 
 TEST_F(PNGFormatTest, testLoadHeightmap) {
-	util::ScopedVarChange scoped(cfg::VoxformatImageImportType, PNGFormat::ImageType::Heightmap);
+	testLoadCtx.config.imageImportType = PNGFormat::ImageType::Heightmap;
 	scenegraph::SceneGraph sceneGraph;
 	testLoad(sceneGraph, "test-heightmap.png", 1);
 	scenegraph::SceneGraphNode *node = sceneGraph.firstModelNode();
@@ -41,4 +43,48 @@ TEST_F(PNGFormatTest, testLoadHeightmap) {
 	EXPECT_EQ(region.getDimensionsInVoxels(), glm::ivec3(8, 255, 8));
 }
 
+TEST_F(PNGFormatTest, testLoadSlices) {
+	palette::Palette pal;
+	pal.nippon();
+	const voxel::Region region(0, 0, 0, 7, 3, 15);
+	scenegraph::SceneGraph sceneGraphSave;
+	{
+		voxel::RawVolume *volume = new voxel::RawVolume(region);
+		for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				volume->setVoxel(0, y, z, voxel::createVoxel(pal, 1));
+				volume->setVoxel(7, y, z, voxel::createVoxel(pal, 1 + z));
+			}
+		}
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(volume, true);
+		node.setPalette(pal);
+		sceneGraphSave.emplace(core::move(node));
+	}
+	const io::ArchivePtr &archive = helper_filesystemarchive();
+	const core::String filename = "pngslicestest.png";
+	PNGFormat format;
+	ASSERT_TRUE(format.save(sceneGraphSave, filename, archive, testSaveCtx));
+
+	const core::String &uuid = sceneGraphSave.firstModelNode()->uuid().str();
+	const core::String &sliceFilename = core::String::format("pngslicestest-%s-0.png", uuid.c_str());
+	scenegraph::SceneGraph sceneGraph;
+	ASSERT_TRUE(format.load(sliceFilename, archive, sceneGraph, testLoadCtx));
+	const scenegraph::SceneGraphNode *node = sceneGraph.firstModelNode();
+	ASSERT_NE(nullptr, node);
+	ASSERT_EQ(region, node->region());
+	const voxel::RawVolume *volume = node->volume();
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			ASSERT_FALSE(voxel::isAir(volume->voxel(0, y, z).getMaterial())) << "at " << y << ":" << z;
+			ASSERT_FALSE(voxel::isAir(volume->voxel(7, y, z).getMaterial())) << "at " << y << ":" << z;
+			ASSERT_TRUE(voxel::isAir(volume->voxel(3, y, z).getMaterial())) << "at " << y << ":" << z;
+		}
+	}
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		io::Filesystem::sysRemoveFile(
+			_testApp->filesystem()->homeWritePath(core::String::format("pngslicestest-%s-%i.png", uuid.c_str(), z)));
+	}
+}
+
 } // namespace voxelformat
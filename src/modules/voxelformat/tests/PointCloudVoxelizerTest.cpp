@@ -0,0 +1,155 @@
+/**
+ * @file
+ */
+
+#include "voxelformat/private/mesh/PointCloudVoxelizer.h"
+#include "TestHelper.h"
+#include "app/tests/AbstractTest.h"
+#include "core/ScopedPtr.h"
+#include "palette/Palette.h"
+#include "palette/PaletteLookup.h"
+#include "voxel/RawVolume.h"
+#include "voxelutil/VolumeMerger.h"
+
+namespace voxelformat {
+
+class PointCloudVoxelizerTest : public app::AbstractTest {
+protected:
+	palette::Palette _palette;
+
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		const color::RGBA colors[] = {{255, 0, 0, 255}, {0, 255, 0, 255}, {0, 0, 255, 255}, {255, 255, 0, 255},
+									  {0, 255, 255, 255}, {255, 0, 255, 255}, {255, 255, 255, 255}, {0, 0, 0, 255}};
+		_palette.setSize(lengthof(colors));
+		for (int i = 0; i < lengthof(colors); ++i) {
+			_palette.setColor(i, colors[i]);
+		}
+	}
+
+	/**
+	 * @brief Merges the chunk volumes into one volume - the chunk volumes are deleted
+	 */
+	voxel::RawVolume *merge(const core::DynamicArray<voxel::RawVolume *> &volumes) {
+		voxel::Region region = volumes[0]->region();
+		for (const voxel::RawVolume *v : volumes) {
+			region.accumulate(v->region());
+		}
+		voxel::RawVolume *merged = new voxel::RawVolume(region);
+		for (voxel::RawVolume *v : volumes) {
+			voxelutil::mergeVolumes(merged, v, v->region(), v->region());
+			delete v;
+		}
+		return merged;
+	}
+
+	voxel::RawVolume *finish(PointCloudVoxelizer &voxelizer) {
+		core::DynamicArray<voxel::RawVolume *> volumes;
+		if (!voxelizer.finish(volumes)) {
+			return nullptr;
+		}
+		return merge(volumes);
+	}
+
+	// visits the region twice in different orders - the second pass hits the bricks that were flushed already
+	void addPoints(PointCloudVoxelizer &voxelizer) {
+		const int size = 48;
+		PointCloud block;
+		auto addPoint = [&](int x, int y, int z) {
+			PointCloudVertex vertex;
+			vertex.position = glm::vec3(x, y, z);
+			vertex.color = _palette.color((x + y + z) % _palette.colorCount());
+			block.push_back(vertex);
+			if (block.size() >= 1024) {
+				voxelizer.add(block.data(), block.size());
+				block.clear();
+			}
+		};
+		for (int z = 0; z < size; ++z) {
+			for (int y = 0; y < size; y += 3) {
+				for (int x = 0; x < size; ++x) {
+					addPoint(x, y, z);
+				}
+			}
+		}
+		for (int x = 0; x < size; ++x) {
+			for (int y = 0; y < size; y += 3) {
+				for (int z = 0; z < size; ++z) {
+					addPoint(x, y, z);
+				}
+			}
+		}
+		voxelizer.add(block.data(), block.size());
+	}
+};
+
+TEST_F(PointCloudVoxelizerTest, testAverageColor) {
+	PointCloudVoxelizer voxelizer(_palette, glm::vec3(1.0f), 1, 1024 * 1024);
+	const PointCloudVertex points[] = {{glm::vec3(1.1f, 2.0f, 3.0f), color::RGBA(255, 0, 0, 255)},
+									   {glm::vec3(0.9f, 2.2f, 2.8f), color::RGBA(255, 255, 0, 255)},
+									   {glm::vec3(-4.0f, 0.0f, 0.0f), color::RGBA(0, 0, 255, 255)}};
+	voxelizer.add(points, lengthof(points));
+	EXPECT_EQ(3u, voxelizer.points());
+	core::ScopedPtr<voxel::RawVolume> v(finish(voxelizer));
+	ASSERT_TRUE(v);
+	EXPECT_EQ(voxel::Region(-4, 0, 0, 1, 2, 3), v->region());
+	palette::PaletteLookup palLookup(_palette);
+	EXPECT_EQ(palLookup.findClosestIndex(color::RGBA(255, 128, 0, 255)), v->voxel(1, 2, 3).getColor());
+	EXPECT_EQ(2, v->voxel(-4, 0, 0).getColor());
+	EXPECT_TRUE(voxel::isAir(v->voxel(0, 0, 0).getMaterial()));
+}
+
+TEST_F(PointCloudVoxelizerTest, testPointSize) {
+	PointCloudVoxelizer voxelizer(_palette, glm::vec3(2.0f), 3, 1024 * 1024);
+	const PointCloudVertex point{glm::vec3(1.0f), color::RGBA(0, 255, 0, 255)};
+	voxelizer.add(&point, 1);
+	core::ScopedPtr<voxel::RawVolume> v(finish(voxelizer));
+	ASSERT_TRUE(v);
+	EXPECT_EQ(voxel::Region(2, 4), v->region());
+	EXPECT_EQ(1, v->voxel(4, 4, 4).getColor());
+}
+
+TEST_F(PointCloudVoxelizerTest, testMemoryBudget) {
+	PointCloudVoxelizer unbounded(_palette, glm::vec3(1.0f), 1, 512u * 1024u * 1024u);
+	addPoints(unbounded);
+	EXPECT_EQ(0u, unbounded.flushedBricks());
+	core::ScopedPtr<voxel::RawVolume> expected(finish(unbounded));
+	ASSERT_TRUE(expected);
+
+	PointCloudVoxelizer bounded(_palette, glm::vec3(1.0f), 1, 512u * 1024u);
+	addPoints(bounded);
+	EXPECT_GT(bounded.flushedBricks(), 0u);
+	EXPECT_LE(bounded.peakBricks(), bounded.maxBricks());
+	EXPECT_LT(bounded.peakBricks(), unbounded.peakBricks());
+	core::ScopedPtr<voxel::RawVolume> v(finish(bounded));
+	ASSERT_TRUE(v);
+	voxel::volumeComparator(*expected, _palette, *v, _palette, voxel::ValidateFlags::All);
+}
+
+TEST_F(PointCloudVoxelizerTest, testChunkVolumes) {
+	PointCloudVoxelizer unbounded(_palette, glm::vec3(1.0f), 1, 512u * 1024u * 1024u);
+	addPoints(unbounded);
+	core::ScopedPtr<voxel::RawVolume> expected(finish(unbounded));
+	ASSERT_TRUE(expected);
+
+	// 16 voxel chunks - the 48 voxel region is split into 27 chunks
+	const int chunkBits = 4;
+	const size_t budget = 256u * 1024u;
+	PointCloudVoxelizer voxelizer(_palette, glm::vec3(1.0f), 1, budget, chunkBits);
+	addPoints(voxelizer);
+	// the flushed voxels are part of the budget until their chunk volume is created
+	EXPECT_LE(voxelizer.peakMemory(), budget);
+	core::DynamicArray<voxel::RawVolume *> volumes;
+	ASSERT_TRUE(voxelizer.finish(volumes));
+	EXPECT_GE(volumes.size(), 27u);
+	for (voxel::RawVolume *v : volumes) {
+		const glm::ivec3 &dim = v->region().getDimensionsInVoxels();
+		EXPECT_LE(dim.x, 1 << chunkBits);
+		EXPECT_LE(dim.y, 1 << chunkBits);
+		EXPECT_LE(dim.z, 1 << chunkBits);
+	}
+	core::ScopedPtr<voxel::RawVolume> v(merge(volumes));
+	voxel::volumeComparator(*expected, _palette, *v, _palette, voxel::ValidateFlags::All);
+}
+
+} // namespace voxelformat
@@ -21,6 +21,26 @@ TEST_F(QBCLFormatTest, testSaveSmallVoxel) {
 	testSaveLoadVoxel("qubicle-smallvolumesavetest.qbcl", &f, 0, 1, flags);
 }
 
+TEST_F(QBCLFormatTest, testSaveMultipleModels) {
+	QBCLFormat f;
+	const voxel::ValidateFlags flags = voxel::ValidateFlags::All & ~voxel::ValidateFlags::Palette;
+	testSaveMultipleModels("qubicle-multiplemodelsavetest.qbcl", &f, flags);
+}
+
+TEST_F(QBCLFormatTest, testSaveLongRuns) {
+	// columns that are longer than the max rle length of 255 voxels
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(3, 255, 2));
+	voxel::RawVolume original(region);
+	for (int y = 0; y < 256; ++y) {
+		original.setVoxel(0, y, 0, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+		original.setVoxel(3, y, 2, voxel::createVoxel(voxel::VoxelType::Generic, y < 100 ? 1 : 2));
+	}
+	original.setVoxel(1, 255, 1, voxel::createVoxel(voxel::VoxelType::Generic, 3));
+	QBCLFormat f;
+	const voxel::ValidateFlags flags = voxel::ValidateFlags::All & ~voxel::ValidateFlags::Palette;
+	testSaveLoadVolumes("qubicle-longrunsavetest.qbcl", original, &f, flags);
+}
+
 TEST_F(QBCLFormatTest, testLoadRGB) {
 	testRGB("rgb.qbcl");
 }
@@ -4,7 +4,6 @@
 
 #include "voxelformat/private/minecraft/SchematicFormat.h"
 #include "AbstractFormatTest.h"
-#include "util/VarUtil.h"
 #include "voxelformat/tests/TestHelper.h"
 
 namespace voxelformat {
@@ -27,7 +26,7 @@ TEST_F(SchematicFormatTest, testLoadStructory) {
 
 TEST_F(SchematicFormatTest, testSaveSmallVoxel) {
 	SchematicFormat f;
-	util::ScopedVarChange scoped(cfg::VoxformatMerge, "true");
+	testSaveCtx.config.merge = true;
 	core::String filename = "minecraft-smallvolumesavetest.schematic";
 	SCOPED_TRACE(filename.c_str());
 	int mins = 0;
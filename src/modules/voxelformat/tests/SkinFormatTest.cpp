@@ -4,8 +4,6 @@
 
 #include "voxelformat/private/minecraft/SkinFormat.h"
 #include "AbstractFormatTest.h"
-#include "core/ConfigVar.h"
-#include "util/VarUtil.h"
 #include "gtest/gtest.h"
 
 namespace voxelformat {
@@ -23,9 +21,9 @@ TEST_P(LoadSave, exec) {
 	SkinFormat src;
 	SkinFormat target;
 	const Params &params = GetParam();
-	util::ScopedVarChange groups(cfg::VoxformatSkinAddGroups, params.groups);
-	util::ScopedVarChange transform(cfg::VoxformatSkinApplyTransform, params.transform);
-	util::ScopedVarChange mergeFaces(cfg::VoxformatSkinMergeFaces, params.mergeFaces);
+	testLoadCtx.config.skinAddGroups = params.groups;
+	testLoadCtx.config.skinApplyTransform = params.transform;
+	testLoadCtx.config.skinMergeFaces = params.mergeFaces;
 	testLoadSaveAndLoadSceneGraph("minecraft-skin.png", src, "minecraft-skin-test.mcskin", target, params.flags);
 }
 
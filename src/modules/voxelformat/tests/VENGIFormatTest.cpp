@@ -4,6 +4,8 @@
 
 #include "voxelformat/private/vengi/VENGIFormat.h"
 #include "AbstractFormatTest.h"
+#include "core/ScopedPtr.h"
+#include "io/MemoryArchive.h"
 
 namespace voxelformat {
 
@@ -19,4 +21,73 @@ TEST_F(VENGIFormatTest, testSaveLoadVoxel) {
 	testSaveLoadVoxel("testSaveLoadVoxel.vengi", &f);
 }
 
+TEST_F(VENGIFormatTest, testSaveMultipleModels) {
+	VENGIFormat f;
+	testSaveMultipleModels("testSaveMultipleModels.vengi", &f);
+}
+
+TEST_F(VENGIFormatTest, testSaveLoadVoxelIndexedLayout) {
+	testSaveCtx.config.vengiIndexed = true;
+	VENGIFormat f;
+	testSaveLoadVoxel("testSaveLoadVoxelIndexedLayout.vengi", &f);
+}
+
+TEST_F(VENGIFormatTest, testSaveLoadVoxelSnapshot) {
+	VENGISnapshotFormat f;
+	testSaveLoadVoxel("testSaveLoadVoxelSnapshot.vengi", &f);
+}
+
+TEST_F(VENGIFormatTest, testSaveMultipleModelsSnapshot) {
+	VENGISnapshotFormat f;
+	testSaveMultipleModels("testSaveMultipleModelsSnapshot.vengi", &f);
+}
+
+TEST_F(VENGIFormatTest, testSaveLoadMultiplePayloads) {
+	// a volume that is split into several independently compressed payloads
+	const voxel::Region region(glm::ivec3(-3, 0, 0), glm::ivec3(36, 255, 255));
+	voxel::RawVolume original(region);
+	for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+		original.setVoxel(x, x + 3, 255 - (x + 3), voxel::createVoxel(voxel::VoxelType::Generic, (uint8_t)(x + 3), 1));
+		original.setVoxel(x, 255, 0, voxel::createVoxel(voxel::VoxelType::Generic, 42));
+	}
+	testSaveCtx.config.vengiIndexed = true;
+	VENGIFormat f;
+	testSaveLoadVolumes("testSaveLoadMultiplePayloads.vengi", original, &f);
+}
+
+TEST_F(VENGIFormatTest, testLoadInvalidUncompressedSize) {
+	const voxel::Region region(0, 31);
+	voxel::RawVolume original(region);
+	original.setVoxel(0, 0, 0, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	scenegraph::SceneGraph sceneGraph;
+	scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+	node.setVolume(&original, false);
+	sceneGraph.emplace(core::move(node));
+
+	const io::MemoryArchivePtr &archive = io::openMemoryArchive();
+	testSaveCtx.config.vengiIndexed = true;
+	VENGIFormat f;
+	ASSERT_TRUE(f.save(sceneGraph, "valid.vengi", archive, testSaveCtx));
+	core::Buffer<uint8_t> data;
+	{
+		core::ScopedPtr<io::SeekableReadStream> stream(archive->readStream("valid.vengi"));
+		ASSERT_TRUE(stream);
+		data.resize((size_t)stream->size());
+		ASSERT_EQ((int)data.size(), stream->read(data.data(), data.size()));
+	}
+	// magic, layout, version, tree size, payload count, offset and compressed size of the first payload
+	const size_t uncompressedSizePos = 5 * sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t);
+	ASSERT_GT(data.size(), uncompressedSizePos + sizeof(uint32_t));
+	// way more than the compressed data can hold - and more than the region of the node
+	const uint32_t sizes[] = {0x7fffffffu, (uint32_t)region.voxels() * 3u + 1u, 1u};
+	for (uint32_t size : sizes) {
+		core::Buffer<uint8_t> invalid = data;
+		core_memcpy(invalid.data() + uncompressedSizePos, &size, sizeof(size));
+		const core::String name = core::String::format("invalid%u.vengi", size);
+		ASSERT_TRUE(archive->add(name, invalid.data(), invalid.size()));
+		scenegraph::SceneGraph loaded;
+		EXPECT_FALSE(f.load(name, archive, loaded, testLoadCtx)) << "size " << size;
+	}
+}
+
 } // namespace voxelformat
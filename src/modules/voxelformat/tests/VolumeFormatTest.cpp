@@ -4,7 +4,14 @@
 
 #include "voxelformat/VolumeFormat.h"
 #include "AbstractFormatTest.h"
+#include "core/StringUtil.h"
 #include "io/FilesystemArchive.h"
+#include "io/FormatDescription.h"
+#include "io/MemoryArchive.h"
+#include "scenegraph/SceneGraphNode.h"
+#include "voxel/RawVolume.h"
+#include "voxelformat/SceneCache.h"
+#include "voxelformat/tests/TestHelper.h"
 
 namespace voxelformat {
 
@@ -30,6 +37,78 @@ TEST_F(VolumeFormatTest, testLoadFormat) {
 	}
 }
 
+TEST_F(VolumeFormatTest, testLoadFormatSceneCache) {
+	const core::String &cacheDir = core::string::path(_testApp->filesystem()->homePath(), "scenecache");
+	testLoadCtx.config.sceneCache = cacheDir;
+	const io::ArchivePtr &archive = io::openFilesystemArchive(_testApp->filesystem());
+	io::FileDescription fileDesc;
+	fileDesc.set("rgb.qb");
+	const io::FormatDescription *desc = io::getDescription(fileDesc, 0u, voxelLoad());
+	ASSERT_NE(nullptr, desc);
+	const core::String &key = sceneCacheKey(fileDesc.name, archive, *desc, testLoadCtx.config);
+	ASSERT_FALSE(key.empty());
+	const core::String &cachedFile = core::string::path(cacheDir, key + ".vengi");
+	io::Filesystem::sysRemoveFile(cachedFile);
+
+	scenegraph::SceneGraph sceneGraph;
+	ASSERT_TRUE(loadFormat(fileDesc, archive, sceneGraph, testLoadCtx));
+	ASSERT_TRUE(io::Filesystem::sysExists(cachedFile)) << "Scene cache " << cachedFile << " wasn't written";
+
+	scenegraph::SceneGraph cachedSceneGraph;
+	ASSERT_TRUE(loadSceneCache(key, cachedSceneGraph, testLoadCtx));
+	voxel::sceneGraphComparator(sceneGraph, cachedSceneGraph, voxel::ValidateFlags::All);
+
+	scenegraph::SceneGraph sceneGraph2;
+	ASSERT_TRUE(loadFormat(fileDesc, archive, sceneGraph2, testLoadCtx));
+	voxel::sceneGraphComparator(sceneGraph, sceneGraph2, voxel::ValidateFlags::All);
+
+	FormatConfig scaled = testLoadCtx.config;
+	scaled.scale = 2.0f;
+	EXPECT_NE(key, sceneCacheKey(fileDesc.name, archive, *desc, scaled)) << "The format config must be part of the key";
+	EXPECT_EQ(key, sceneCacheKey(fileDesc.name, archive, *desc, testLoadCtx.config));
+	io::Filesystem::sysRemoveFile(cachedFile);
+}
+
+TEST_F(VolumeFormatTest, testSceneCacheKeyFilename) {
+	const io::MemoryArchivePtr &archive = io::openMemoryArchive();
+	const uint8_t data[] = {1, 2, 3, 4};
+	archive->add("r.0.0.mca", data, sizeof(data));
+	archive->add("r.1.0.mca", data, sizeof(data));
+	io::FileDescription fileDesc;
+	fileDesc.set("r.0.0.mca");
+	const io::FormatDescription *desc = io::getDescription(fileDesc, 0u, voxelLoad());
+	ASSERT_NE(nullptr, desc);
+	// the region coordinates are taken from the filename
+	EXPECT_NE(sceneCacheKey("r.0.0.mca", archive, *desc, testLoadCtx.config),
+			  sceneCacheKey("r.1.0.mca", archive, *desc, testLoadCtx.config));
+}
+
+TEST_F(VolumeFormatTest, testSceneCacheIgnoresSaveSettings) {
+	FormatConfig config = testLoadCtx.config;
+	config.sceneCache = core::string::path(_testApp->filesystem()->homePath(), "scenecache");
+	config.saveVisibleOnly = true;
+	config.merge = true;
+
+	scenegraph::SceneGraph sceneGraph;
+	for (int i = 0; i < 2; ++i) {
+		voxel::RawVolume *volume = new voxel::RawVolume(voxel::Region(0, 1));
+		volume->setVoxel(i, i, i, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(volume, true);
+		node.setVisible(i == 0);
+		ASSERT_NE(InvalidNodeId, sceneGraph.emplace(core::move(node)));
+	}
+	const core::String key = "savesettings";
+	ASSERT_TRUE(saveSceneCache(key, sceneGraph, config));
+
+	LoadContext ctx(config);
+	scenegraph::SceneGraph cachedSceneGraph;
+	ASSERT_TRUE(loadSceneCache(key, cachedSceneGraph, ctx));
+	EXPECT_EQ(2u, cachedSceneGraph.size(scenegraph::SceneGraphNodeType::Model))
+		<< "The cached scene must contain the hidden node and must not be merged";
+	io::Filesystem::sysRemoveFile(core::string::path(config.sceneCache, key + ".vengi"));
+}
+
 TEST_F(VolumeFormatTest, testIsMeshFormat) {
 	EXPECT_TRUE(isMeshFormat("foo.obj", false));
 	EXPECT_TRUE(isMeshFormat("foo.glb", false));
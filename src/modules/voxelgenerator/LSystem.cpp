@@ -4,8 +4,10 @@
 
 #include "LSystem.h"
 #include "app/I18N.h"
-#include "core/Tokenizer.h"
+#include "core/ArrayLength.h"
+#include "core/Hash.h"
 #include "core/Log.h"
+#include "core/Tokenizer.h"
 
 namespace voxelgenerator {
 namespace lsystem {
@@ -28,8 +30,65 @@ const core::DynamicArray<LSystemCommand>& getLSystemCommands() {
 	return commands;
 }
 
+// branches with less commands are cheaper to interpret than to look up
+static constexpr uint64_t MinBranchCommands = 16u;
+static constexpr uint64_t MaxBranchCommands = 64u * 1024u;
+// the max amount of voxels that are recorded for the currently interpreted branches
+static constexpr size_t MaxRecordedVoxels = 64u * 1024u;
+// the max amount of voxels of all memoized branches
+static constexpr size_t MaxBranchVoxels = 1024u * 1024u;
+static constexpr uint64_t MaxCommands = UINT64_MAX / 2u;
+
+/**
+ * @return The index after the digits of the voxel type command that starts at the given index
+ */
+static size_t skipVoxelType(const core::String &sentence, size_t i) {
+	while (i < sentence.size() && sentence[i] >= '0' && sentence[i] <= '9') {
+		++i;
+	}
+	return i;
+}
+
+static uint64_t countCommands(const LSystemState &state, const core::String &sentence, int depth) {
+	uint64_t commands = 0u;
+	for (size_t i = 0; i < sentence.size(); ++i) {
+		const char c = sentence[i];
+		const int rule = state.rule(c, depth);
+		if (rule >= 0) {
+			commands += state.commandsOf(rule, depth + 1);
+		} else {
+			// the digits of the voxel type are part of the command - see executeCommand()
+			if (c == '(') {
+				i = skipVoxelType(sentence, i + 1) - 1;
+			}
+			++commands;
+		}
+		commands = core_min(commands, MaxCommands);
+	}
+	return commands;
+}
+
+static bool hasLeaves(const LSystemState &state, const core::String &sentence, int depth) {
+	for (size_t i = 0; i < sentence.size(); ++i) {
+		const char c = sentence[i];
+		const int rule = state.rule(c, depth);
+		if (rule >= 0) {
+			if (state.leavesOf(rule, depth + 1)) {
+				return true;
+			}
+		} else if (c == '(') {
+			i = skipVoxelType(sentence, i + 1) - 1;
+		} else if (c == 'L') {
+			return true;
+		}
+	}
+	return false;
+}
+
 void prepareState(const LSystemConfig &conf, LSystemState &state) {
-	state.sentence = conf.axiom;
+	state.axiom = conf.axiom;
+	state.rules = conf.rules;
+	state.iterations = core_max(0, conf.iterations);
 	state.position = conf.position;
 	state.angle = conf.angle;
 	state.length = conf.length;
@@ -37,31 +96,139 @@ void prepareState(const LSystemConfig &conf, LSystemState &state) {
 	state.widthIncrement = conf.widthIncrement;
 	state.leafRadius = conf.leafRadius;
 
-	for (int i = 0; i < conf.iterations; i++) {
-		core::String nextSentence = "";
-
-		for (size_t j = 0; j < state.sentence.size(); ++j) {
-			const char current = state.sentence[j];
-			bool found = false;
-			for (const auto &rule : conf.rules) {
-				if (rule.a == current) {
-					found = true;
-					nextSentence += rule.b;
-					break;
-				}
-			}
-			if (!found) {
-				nextSentence += current;
-			}
-			if (nextSentence.size() > 1024 * 1024) {
-				Log::warn("LSystem sentence length exceeded limit");
-				state.sentence = nextSentence;
-				return;
+	for (int i = 0; i < lengthof(state.ruleIndex); ++i) {
+		state.ruleIndex[i] = -1;
+	}
+	for (int i = (int)state.rules.size() - 1; i >= 0; --i) {
+		// the first rule for a symbol wins
+		state.ruleIndex[(uint8_t)state.rules[i].a] = (int16_t)i;
+	}
+
+	// the expanded sentence of a rule at depth d only depends on the expansions at depth d + 1
+	const int depths = state.iterations + 1;
+	state.ruleCommands.resize(state.rules.size() * depths);
+	state.ruleLeaves.resize(state.rules.size() * depths);
+	for (int depth = state.iterations; depth >= 1; --depth) {
+		for (size_t r = 0; r < state.rules.size(); ++r) {
+			state.ruleCommands[r * depths + depth] = countCommands(state, state.rules[r].b, depth);
+			state.ruleLeaves[r * depths + depth] = hasLeaves(state, state.rules[r].b, depth) ? 1u : 0u;
+		}
+	}
+	state.commands = countCommands(state, state.axiom, 0);
+	if (state.commands >= MaxCommands) {
+		Log::warn("LSystem sentence length exceeded limit - generation will not finish");
+	}
+}
+
+bool LSystemBranchKey::operator==(const LSystemBranchKey &other) const {
+	return rule == other.rule && depth == other.depth && fraction == other.fraction && rotation == other.rotation &&
+		   width == other.width && voxel == other.voxel;
+}
+
+size_t LSystemBranchKeyHash::operator()(const LSystemBranchKey &key) const {
+	uint32_t hash = core::hash(&key.fraction, sizeof(key.fraction));
+	hash = core::hash(&key.rotation, sizeof(key.rotation), hash);
+	hash = core::hash(&key.width, sizeof(key.width), hash);
+	return (size_t)hash ^ ((size_t)key.rule << 8) ^ (size_t)key.depth ^ ((size_t)key.voxel.getColor() << 16);
+}
+
+static LSystemBranchKey branchKey(const TurtleStep &turtle, int rule, int depth) {
+	LSystemBranchKey key;
+	key.rule = rule;
+	key.depth = depth;
+	key.fraction = turtle.pos - glm::floor(turtle.pos);
+	key.rotation = turtle.rotation;
+	key.width = turtle.width;
+	key.voxel = turtle.voxel;
+	return key;
+}
+
+static void stopRecording(LSystemExecutionState &execState) {
+	for (LSystemFrame &frame : execState.frames) {
+		frame.recording = false;
+	}
+	execState.recordings = 0;
+	execState.recorded.clear();
+}
+
+const LSystemBranch *enterRule(const LSystemState &state, LSystemExecutionState &execState, int rule, int depth) {
+	LSystemFrame frame;
+	frame.rule = rule;
+	frame.depth = depth;
+	frame.start = execState.step;
+	frame.turtleStackSize = (uint32_t)execState.stack.size();
+	const uint64_t commands = state.commandsOf(rule, depth);
+	if (state.memoize && commands >= MinBranchCommands && commands <= MaxBranchCommands &&
+		!state.leavesOf(rule, depth)) {
+		auto iter = execState.branches.find(branchKey(execState.step, rule, depth));
+		if (iter != execState.branches.end()) {
+			return &iter->value;
+		}
+		if (execState.branchVoxels < MaxBranchVoxels) {
+			frame.recording = true;
+			frame.recordStart = (uint32_t)execState.recorded.size();
+			++execState.recordings;
+		}
+	}
+	execState.frames.push_back(frame);
+	return nullptr;
+}
+
+void leaveFrame(LSystemExecutionState &execState) {
+	const LSystemFrame &frame = execState.frames.back();
+	if (frame.recording) {
+		--execState.recordings;
+		const size_t voxels = execState.recorded.size() - frame.recordStart;
+		// a branch that pops more turtle states than it pushed depends on the state before the branch
+		if (execState.stack.size() == frame.turtleStackSize && execState.branchVoxels + voxels <= MaxBranchVoxels) {
+			LSystemBranch branch;
+			const glm::ivec3 origin(glm::floor(frame.start.pos));
+			branch.voxels.reserve(voxels);
+			for (size_t i = frame.recordStart; i < execState.recorded.size(); ++i) {
+				const LSystemRecordedVoxel &v = execState.recorded[i];
+				branch.voxels.push_back({v.pos - origin, v.voxel});
 			}
+			branch.end = execState.step;
+			branch.end.pos = execState.step.pos - frame.start.pos;
+			execState.branchVoxels += voxels;
+			execState.branches.emplace(branchKey(frame.start, frame.rule, frame.depth), core::move(branch));
 		}
+		if (execState.recordings == 0) {
+			execState.recorded.clear();
+		}
+	}
+	execState.frames.pop();
+}
+
+void pushTurtle(LSystemExecutionState &execState) {
+	if (execState.stack.size() >= execState.stack.maxSize()) {
+		Log::warn("LSystem stack overflow");
+		return;
+	}
+	execState.stack.push(execState.step);
+}
+
+void popTurtle(LSystemExecutionState &execState) {
+	if (execState.stack.empty()) {
+		return;
+	}
+	const size_t stackSize = execState.stack.size();
+	for (LSystemFrame &frame : execState.frames) {
+		if (frame.recording && frame.turtleStackSize >= stackSize) {
+			frame.recording = false;
+			--execState.recordings;
+		}
+	}
+	execState.step = execState.stack.top();
+	execState.stack.pop();
+}
 
-		state.sentence = nextSentence;
+void recordVoxel(LSystemExecutionState &execState, const glm::ivec3 &pos, const voxel::Voxel &voxel) {
+	if (execState.recorded.size() >= MaxRecordedVoxels) {
+		stopRecording(execState);
+		return;
 	}
+	execState.recorded.push_back({pos, voxel});
 }
 
 // https://paulbourke.net/fractals/lsys/
@@ -8,6 +8,7 @@
 #include "core/String.h"
 #include "core/StringUtil.h"
 #include "core/collection/DynamicArray.h"
+#include "core/collection/HashMap.h"
 #include "core/collection/Stack.h"
 #include "voxel/Voxel.h"
 #ifndef GLM_ENABLE_EXPERIMENTAL
@@ -62,19 +63,119 @@ struct LSystemConfig {
 };
 
 struct LSystemState {
-	core::String sentence;
+	core::String axiom;
+	core::DynamicArray<Rule> rules;
+	/** index into @c rules for every symbol or @c -1 if there is no rule for the symbol */
+	int16_t ruleIndex[256];
+	int iterations = 0;
+	/**
+	 * The amount of commands of the expanded sentence for every rule and iteration depth - the entry for a rule at
+	 * depth @c d is at @c rule * (iterations + 1) + d
+	 */
+	core::DynamicArray<uint64_t> ruleCommands;
+	/**
+	 * Whether the expanded sentence for a rule and iteration depth contains leaves - same layout as @c ruleCommands.
+	 * The leaves are random, so these branches are never memoized.
+	 */
+	core::DynamicArray<uint8_t> ruleLeaves;
+	/** the amount of commands of the fully expanded sentence */
+	uint64_t commands = 0u;
+	/** stamp the voxels of already generated identical branches instead of interpreting them again */
+	bool memoize = true;
 	glm::ivec3 position{0};
 	float angle = glm::radians(25.0f);
 	float length = 1.0f;
 	float width = 1.0f;
 	float widthIncrement = 0.5f;
 	float leafRadius = 8.0f;
+
+	/**
+	 * @return The rule that replaces the given symbol at the given iteration depth or @c -1 if the symbol is a command
+	 */
+	inline int rule(char c, int depth) const {
+		if (depth >= iterations) {
+			return -1;
+		}
+		return ruleIndex[(uint8_t)c];
+	}
+
+	inline uint64_t commandsOf(int rule, int depth) const {
+		return ruleCommands[rule * (iterations + 1) + depth];
+	}
+
+	inline bool leavesOf(int rule, int depth) const {
+		return ruleLeaves[rule * (iterations + 1) + depth] != 0;
+	}
+
+	inline const core::String &sentence(int rule) const {
+		if (rule < 0) {
+			return axiom;
+		}
+		return rules[rule].b;
+	}
+};
+
+/**
+ * @brief A part of the sentence that is currently interpreted - either the axiom or the successor of a rule
+ */
+struct LSystemFrame {
+	/** index into @c LSystemState::rules or @c -1 for the axiom */
+	int rule = -1;
+	/** the iteration depth of the symbols in this frame */
+	int depth = 0;
+	uint32_t index = 0u;
+	/** the voxels of this frame are recorded to stamp them for identical branches */
+	bool recording = false;
+	uint32_t recordStart = 0u;
+	uint32_t turtleStackSize = 0u;
+	TurtleStep start;
+};
+
+/**
+ * @brief Identifies the expansion of a rule - the generated voxels only depend on these values
+ */
+struct LSystemBranchKey {
+	int rule = -1;
+	int depth = 0;
+	/** the fractional part of the turtle position */
+	glm::vec3 fraction{0.0f};
+	glm::vec3 rotation{0.0f};
+	float width = 0.0f;
+	voxel::Voxel voxel;
+
+	bool operator==(const LSystemBranchKey &other) const;
+};
+
+struct LSystemBranchKeyHash {
+	size_t operator()(const LSystemBranchKey &key) const;
+};
+
+struct LSystemRecordedVoxel {
+	glm::ivec3 pos;
+	voxel::Voxel voxel;
+};
+
+/**
+ * @brief The memoized result of a rule expansion
+ */
+struct LSystemBranch {
+	/** relative to the integer part of the turtle position */
+	core::DynamicArray<LSystemRecordedVoxel> voxels;
+	/** the turtle state after the expansion - the position is relative to the start position */
+	TurtleStep end;
 };
 
 struct LSystemExecutionState {
 	core::Stack<TurtleStep, 512> stack;
 	TurtleStep step;
-	size_t index = 0;
+	/** the rule expansions that are currently interpreted - never deeper than the iterations */
+	core::DynamicArray<LSystemFrame> frames;
+	core::DynamicArray<LSystemRecordedVoxel> recorded;
+	core::HashMap<LSystemBranchKey, LSystemBranch, LSystemBranchKeyHash> branches;
+	size_t branchVoxels = 0u;
+	int recordings = 0;
+	/** the amount of commands of the expanded sentence that were already executed */
+	uint64_t commands = 0u;
 	bool initialized = false;
 };
 
@@ -85,145 +186,218 @@ struct LSystemTemplate {
 };
 core::DynamicArray<LSystemTemplate> defaultTemplates();
 
+/**
+ * @brief Prepare the state for the interpretation - the sentence is not expanded here, the rules are applied while
+ * the commands are executed.
+ */
 void prepareState(const LSystemConfig &conf, LSystemState &state);
 
 /**
- * @brief Generate voxels according to the given L-System rules
- *
- * @li @c F Draw line forwards
- * @li @c ( Set voxel type
- * @li @c b Move backwards (no drawing)
- * @li @c L Leaf
- * @li @c + Rotate right
- * @li @c - Rotate left
- * @li @c > Rotate forward
- * @li @c < Rotate back
- * @li @c # Increment width
- * @li @c ! Decrement width
- * @li @c [ Push
- * @li @c ] Pop
+ * @brief Enter the expansion of the given rule
+ * @return The memoized branch if an identical branch was already generated - otherwise @c nullptr and a new frame
+ * was pushed.
  */
-template<class Volume>
-bool step(Volume &volume, const voxel::Voxel &voxel, const LSystemState &state, LSystemExecutionState &execState) {
-	if (state.sentence.empty()) {
-		return false;
-	}
-	if (!execState.initialized) {
-		execState.step.width = state.width;
-		execState.step.voxel = voxel;
-		execState.initialized = true;
-		execState.index = 0;
-	}
+const LSystemBranch *enterRule(const LSystemState &state, LSystemExecutionState &execState, int rule, int depth);
+/**
+ * @brief Leave the current frame and memoize the recorded branch
+ */
+void leaveFrame(LSystemExecutionState &execState);
+void pushTurtle(LSystemExecutionState &execState);
+void popTurtle(LSystemExecutionState &execState);
+void recordVoxel(LSystemExecutionState &execState, const glm::ivec3 &pos, const voxel::Voxel &voxel);
 
-	if (execState.index >= state.sentence.size()) {
-		return false;
+template<class Volume>
+inline void setVoxel(Volume &volume, const LSystemState &state, LSystemExecutionState &execState,
+					 const glm::ivec3 &pos, const voxel::Voxel &voxel) {
+	volume.setVoxel(state.position + pos, voxel);
+	if (execState.recordings > 0) {
+		recordVoxel(execState, pos, voxel);
 	}
+}
 
-	const float leafDistance = glm::round(2.0f * state.leafRadius);
-	// apply a factor to close potential holes
-	const int leavesVoxelCnt = (int)(glm::pow(leafDistance, 3) * 2.0);
-
-	const char c = state.sentence[execState.index];
+template<class Volume>
+void executeCommand(Volume &volume, const LSystemState &state, LSystemExecutionState &execState, char c,
+					const core::String &sentence, uint32_t &index) {
+	TurtleStep &turtle = execState.step;
 	switch (c) {
 	case 'F': {
 		// Draw line forwards
 		for (int j = 0; j < (int)state.length; j++) {
-			float r = execState.step.width / 2.0f;
+			float r = turtle.width / 2.0f;
 			for (float x = -r; x < r; x++) {
 				for (float y = -r; y < r; y++) {
 					for (float z = -r; z < r; z++) {
-						const glm::ivec3 dest(glm::round(execState.step.pos + glm::vec3(x, y, z)));
-						volume.setVoxel(state.position + dest, execState.step.voxel);
+						const glm::ivec3 dest(glm::round(turtle.pos + glm::vec3(x, y, z)));
+						setVoxel(volume, state, execState, dest, turtle.voxel);
 					}
 				}
 			}
-			execState.step.pos += 1.0f * execState.step.rotation;
+			turtle.pos += 1.0f * turtle.rotation;
 		}
 		break;
 	}
 	case '(': {
 		// Set voxel type
-		++execState.index;
-		size_t begin = execState.index;
-		size_t slength = 0u;
-		while (execState.index < state.sentence.size() && state.sentence[execState.index] >= '0' &&
-			   state.sentence[execState.index] <= '9') {
-			++slength;
-			++execState.index;
+		const uint32_t begin = index;
+		while (index < sentence.size() && sentence[index] >= '0' && sentence[index] <= '9') {
+			++index;
 		}
-		core::String voxelString(state.sentence.c_str() + begin, slength);
+		const core::String voxelString(sentence.c_str() + begin, index - begin);
 		const int colorIndex = core::string::toInt(voxelString);
 		if (colorIndex == 0) {
-			execState.step.voxel = voxel::Voxel();
+			turtle.voxel = voxel::Voxel();
 		} else if (colorIndex > 0 && colorIndex < 256) {
-			execState.step.voxel = voxel::createVoxel(voxel::VoxelType::Generic, colorIndex);
+			turtle.voxel = voxel::createVoxel(voxel::VoxelType::Generic, colorIndex);
 		}
 		break;
 	}
 	case 'b': {
 		// Move backwards (no drawing)
 		for (int j = 0; j < (int)state.length; j++) {
-			execState.step.pos -= 1.0f * execState.step.rotation;
+			turtle.pos -= 1.0f * turtle.rotation;
 		}
 		break;
 	}
 
 	case 'L': {
 		// Leaf
+		const float leafDistance = glm::round(2.0f * state.leafRadius);
+		// apply a factor to close potential holes
+		const int leavesVoxelCnt = (int)(glm::pow(leafDistance, 3) * 2.0);
 		for (int j = 0; j < leavesVoxelCnt; j++) {
 			const glm::vec3 &r = glm::ballRand(state.leafRadius);
-			const glm::ivec3 p = state.position + glm::ivec3(glm::round(execState.step.pos + r));
-			volume.setVoxel(p, execState.step.voxel);
+			const glm::ivec3 p(glm::round(turtle.pos + r));
+			setVoxel(volume, state, execState, p, turtle.voxel);
 		}
 		break;
 	}
 
 	case '+':
 		// Rotate right
-		execState.step.rotation = glm::rotateZ(execState.step.rotation, state.angle);
+		turtle.rotation = glm::rotateZ(turtle.rotation, state.angle);
 		break;
 
 	case '-':
 		// Rotate left
-		execState.step.rotation = glm::rotateZ(execState.step.rotation, -state.angle);
+		turtle.rotation = glm::rotateZ(turtle.rotation, -state.angle);
 		break;
 
 	case '>':
 		// Rotate forward
-		execState.step.rotation = glm::rotateX(execState.step.rotation, state.angle);
+		turtle.rotation = glm::rotateX(turtle.rotation, state.angle);
 		break;
 
 	case '<':
 		// Rotate back
-		execState.step.rotation = glm::rotateX(execState.step.rotation, -state.angle);
+		turtle.rotation = glm::rotateX(turtle.rotation, -state.angle);
 		break;
 
 	case '#':
 		// Increment width
-		execState.step.width += state.widthIncrement;
+		turtle.width += state.widthIncrement;
 		break;
 
 	case '!':
 		// Decrement width
-		execState.step.width -= state.widthIncrement;
-		execState.step.width = glm::max(1.1f, execState.step.width);
+		turtle.width -= state.widthIncrement;
+		turtle.width = glm::max(1.1f, turtle.width);
 		break;
 
 	case '[':
 		// Push
-		execState.stack.push(execState.step);
+		pushTurtle(execState);
 		break;
 
 	case ']':
 		// Pop
-		if (!execState.stack.empty()) {
-			execState.step = execState.stack.top();
-			execState.stack.pop();
-		}
+		popTurtle(execState);
 		break;
 	}
-	++execState.index;
-	return execState.index < state.sentence.size();
+}
+
+/**
+ * @brief Generate voxels according to the given L-System rules
+ *
+ * The sentence is never expanded - the rules are applied while walking the sentence with an explicit stack of the
+ * rule expansions. This means that the memory usage doesn't depend on the amount of iterations. Identical branches
+ * (same rule, iteration depth and turtle state) are stamped into the volume if @c LSystemState::memoize is set -
+ * except for branches with leaves, as those are placed randomly.
+ *
+ * One call executes one command or stamps one branch.
+ *
+ * @li @c F Draw line forwards
+ * @li @c ( Set voxel type
+ * @li @c b Move backwards (no drawing)
+ * @li @c L Leaf
+ * @li @c + Rotate right
+ * @li @c - Rotate left
+ * @li @c > Rotate forward
+ * @li @c < Rotate back
+ * @li @c # Increment width
+ * @li @c ! Decrement width
+ * @li @c [ Push
+ * @li @c ] Pop
+ *
+ * @return @c false if there is nothing left to execute
+ */
+template<class Volume>
+bool step(Volume &volume, const voxel::Voxel &voxel, const LSystemState &state, LSystemExecutionState &execState) {
+	if (!execState.initialized) {
+		execState.step = TurtleStep();
+		execState.step.width = state.width;
+		execState.step.voxel = voxel;
+		execState.initialized = true;
+		execState.commands = 0u;
+		if (!state.axiom.empty()) {
+			LSystemFrame frame;
+			frame.start = execState.step;
+			execState.frames.push_back(frame);
+		}
+	}
+
+	for (;;) {
+		if (execState.frames.empty()) {
+			return false;
+		}
+		LSystemFrame &frame = execState.frames.back();
+		const core::String &sentence = state.sentence(frame.rule);
+		if (frame.index >= sentence.size()) {
+			leaveFrame(execState);
+			continue;
+		}
+		const char c = sentence[frame.index++];
+		const int rule = state.rule(c, frame.depth);
+		if (rule >= 0) {
+			const int depth = frame.depth + 1;
+			const LSystemBranch *branch = enterRule(state, execState, rule, depth);
+			if (branch == nullptr) {
+				continue;
+			}
+			const glm::ivec3 origin(glm::floor(execState.step.pos));
+			for (const LSystemRecordedVoxel &v : branch->voxels) {
+				setVoxel(volume, state, execState, origin + v.pos, v.voxel);
+			}
+			execState.step.pos += branch->end.pos;
+			execState.step.rotation = branch->end.rotation;
+			execState.step.width = branch->end.width;
+			execState.step.voxel = branch->end.voxel;
+			execState.commands += state.commandsOf(rule, depth);
+			return true;
+		}
+		++execState.commands;
+		executeCommand(volume, state, execState, c, sentence, frame.index);
+		return true;
+	}
+}
+
+/**
+ * @brief Execute all commands of the L-System
+ */
+template<class Volume>
+void generate(Volume &volume, const voxel::Voxel &voxel, const LSystemState &state) {
+	LSystemExecutionState execState;
+	while (step(volume, voxel, state, execState)) {
+	}
 }
 
 } // namespace lsystem
@@ -8,7 +8,6 @@
 #include "commonlua/LUAFunctions.h"
 #include "color/Color.h"
 #include "core/StringUtil.h"
-#include "core/Unicode.h"
 #include "image/Image.h"
 #include "io/FilesystemArchive.h"
 #include "io/Stream.h"
@@ -35,6 +34,7 @@
 #include "voxelformat/Format.h"
 #include "voxelformat/VolumeFormat.h"
 #include "voxelgenerator/Genland.h"
+#include "voxelgenerator/LSystem.h"
 #include "voxelgenerator/ShapeGenerator.h"
 #include "voxelutil/FillHollow.h"
 #include "voxelutil/Hollow.h"
@@ -110,6 +110,10 @@ static const char *luaVoxel_globaldirtyregion() {
 	return "__global_region";
 }
 
+static const char *luaVoxel_globalfonts() {
+	return "__global_fonts";
+}
+
 static const char *luaVoxel_metascenegraphnode() {
 	return "__meta_scenegraphnode";
 }
@@ -438,24 +442,26 @@ static int luaVoxel_volumewrapper_text(lua_State *s) {
 	const voxel::Region &region = volume->region();
 	const char *ttffont = lua_tostring(s, 2);
 	const char *text = lua_tostring(s, 3);
-	int x = (int)luaL_optinteger(s, 4, region.getLowerX());
+	const int x = (int)luaL_optinteger(s, 4, region.getLowerX());
 	const int y = (int)luaL_optinteger(s, 5, region.getLowerY());
 	const int z = (int)luaL_optinteger(s, 6, region.getLowerZ());
 	const int size = (int)luaL_optinteger(s, 7, 16);
 	const int thickness = (int)luaL_optinteger(s, 8, 1);
 	const int spacing = (int)luaL_optinteger(s, 9, 0);
-	voxelfont::VoxelFont font;
-	if (!font.init(ttffont)) {
-		clua_error(s, "Could not initialize font %s", ttffont);
+	// the fonts are kept alive for the following calls - this avoids loading the ttf and rasterizing the glyphs again
+	core::StringMap<voxelfont::VoxelFont *> *fonts =
+		luaVoxel_globalData<core::StringMap<voxelfont::VoxelFont *>>(s, luaVoxel_globalfonts());
+	voxelfont::VoxelFont *font = nullptr;
+	if (!fonts->get(ttffont, font)) {
+		font = new voxelfont::VoxelFont();
+		if (!font->init(ttffont)) {
+			delete font;
+			clua_error(s, "Could not initialize font %s", ttffont);
+		}
+		fonts->put(ttffont, font);
 	}
-	const char **str = &text;
-	glm::ivec3 pos(x, y, z);
 	const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 0);
-	for (int c = core::unicode::next(str); c != -1; c = core::unicode::next(str)) {
-		pos.x += font.renderCharacter(c, size, thickness, pos, *volume, voxel);
-		pos.x += spacing;
-	}
-	font.shutdown();
+	font->renderString(text, size, thickness, spacing, glm::ivec3(x, y, z), *volume, voxel);
 	return 0;
 }
 
@@ -577,6 +583,28 @@ static int luaVoxel_shape_bezier(lua_State* s) {
 	return 0;
 }
 
+static int luaVoxel_shape_lsystem(lua_State* s) {
+	LuaRawVolumeWrapper *volume = luaVoxel_tovolumewrapper(s, 1);
+	lsystem::LSystemConfig conf;
+	conf.position = clua_tovec<glm::ivec3>(s, 2);
+	conf.axiom = luaL_checkstring(s, 3);
+	const char *rules = luaL_checkstring(s, 4);
+	const voxel::Voxel voxel = luaVoxel_getVoxel(s, 5);
+	conf.angle = glm::radians((float)luaL_optnumber(s, 6, 25.0));
+	conf.length = (float)luaL_optnumber(s, 7, 1.0);
+	conf.width = (float)luaL_optnumber(s, 8, 1.0);
+	conf.widthIncrement = (float)luaL_optnumber(s, 9, 0.5);
+	conf.iterations = (int)luaL_optinteger(s, 10, 4);
+	conf.leafRadius = (float)luaL_optnumber(s, 11, 8.0);
+	if (!lsystem::parseRules(rules, conf.rules)) {
+		return clua_error(s, "Failed to parse the lsystem rules");
+	}
+	lsystem::LSystemState state;
+	lsystem::prepareState(conf, state);
+	lsystem::generate(*volume, voxel, state);
+	return 0;
+}
+
 static int luaVoxel_load_palette(lua_State *s) {
 	const char *filename = luaL_checkstring(s, 1);
 	io::SeekableReadStream *readStream = clua_tostream(s, 2);
@@ -1954,6 +1982,7 @@ static void prepareState(lua_State* s) {
 		{"cone", luaVoxel_shape_cone},
 		{"line", luaVoxel_shape_line},
 		{"bezier", luaVoxel_shape_bezier},
+		{"lsystem", luaVoxel_shape_lsystem},
 		{nullptr, nullptr}
 	};
 	clua_registerfuncsglobal(s, shapeFuncs, luaVoxel_metashape(), "g_shape");
@@ -1989,6 +2018,7 @@ bool LUAApi::init() {
 	}
 	luaVoxel_newGlobalData(_lua, luaVoxel_globalnoise(), &_noise);
 	luaVoxel_newGlobalData(_lua, luaVoxel_globaldirtyregion(), &_dirtyRegion);
+	luaVoxel_newGlobalData(_lua, luaVoxel_globalfonts(), &_fonts);
 	prepareState(_lua);
 	return true;
 }
@@ -2021,6 +2051,11 @@ ScriptState LUAApi::update(double nowSeconds) {
 void LUAApi::shutdown() {
 	lua_gc(_lua, LUA_GCCOLLECT, 0);
 	_noise.shutdown();
+	for (const auto &entry : _fonts) {
+		entry->value->shutdown();
+		delete entry->value;
+	}
+	_fonts.clear();
 	_lua.resetState();
 }
 
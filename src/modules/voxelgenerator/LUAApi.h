@@ -9,6 +9,7 @@
 #include "core/IComponent.h"
 #include "core/String.h"
 #include "core/collection/DynamicArray.h"
+#include "core/collection/StringMap.h"
 #include "io/Filesystem.h"
 #include "noise/Noise.h"
 #include "voxel/Region.h"
@@ -24,6 +25,10 @@ class RawVolumeWrapper;
 class Voxel;
 } // namespace voxel
 
+namespace voxelfont {
+class VoxelFont;
+}
+
 namespace voxelgenerator {
 
 enum class LUAParameterType {
@@ -85,6 +90,8 @@ private:
 	lua::LUA _lua;
 	core::DynamicArray<LUAParameterDescription> _argsInfo;
 	voxel::Region _dirtyRegion = voxel::Region::InvalidRegion;
+	// the fonts that were used by the scripts - the glyphs are cached per size by the font
+	core::StringMap<voxelfont::VoxelFont *> _fonts;
 	bool _scriptStillRunning = false;
 	int _nargs = 0;
 
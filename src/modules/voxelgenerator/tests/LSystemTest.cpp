@@ -11,7 +11,15 @@
 namespace voxelgenerator {
 namespace lsystem {
 
-class LSystemTests : public app::AbstractTest {};
+class LSystemTests : public app::AbstractTest {
+protected:
+	struct CountingVolume {
+		uint64_t voxels = 0u;
+		void setVoxel(const glm::ivec3 &, const voxel::Voxel &) {
+			++voxels;
+		}
+	};
+};
 
 TEST_F(LSystemTests, testParse) {
 	const core::String rulesString = R"(
@@ -35,7 +43,7 @@ TEST_F(LSystemTests, testTemplates) {
 	for (const auto &t : templates) {
 		LSystemState state;
 		prepareState(t.config, state);
-		ASSERT_FALSE(state.sentence.empty()) << "Template " << t.name << " failed to generate sentence";
+		ASSERT_GT(state.commands, 0u) << "Template " << t.name << " failed to generate sentence";
 	}
 }
 
@@ -47,7 +55,7 @@ TEST_F(LSystemTests, testInvalidRule) {
 	conf.iterations = 2;
 	LSystemState state;
 	prepareState(conf, state);
-	ASSERT_FALSE(state.sentence.empty());
+	ASSERT_GT(state.commands, 0u);
 	voxel::Region r(0, 10);
 	voxel::RawVolume v(r);
 	const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 1);
@@ -63,6 +71,104 @@ TEST_F(LSystemTests, testInvalidRule) {
 	ASSERT_LT(steps, 1000);
 }
 
+TEST_F(LSystemTests, testDeepIterations) {
+	LSystemConfig conf;
+	conf.axiom = "A";
+	conf.rules.push_back({'A', "AA"});
+	conf.iterations = 25;
+	LSystemState state;
+	prepareState(conf, state);
+	ASSERT_EQ(1ull << 25, state.commands);
+
+	CountingVolume volume;
+	const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 1);
+	LSystemExecutionState execState;
+	while (step(volume, voxel, state, execState)) {
+	}
+	EXPECT_EQ(state.commands, execState.commands);
+	EXPECT_TRUE(execState.frames.empty());
+	EXPECT_EQ(0u, volume.voxels);
+}
+
+TEST_F(LSystemTests, testMemoize) {
+	LSystemConfig conf;
+	conf.axiom = "F";
+	conf.rules.push_back({'F', "F[+F]F[->F]F"});
+	conf.iterations = 4;
+	conf.position = glm::ivec3(32, 0, 32);
+	conf.angle = glm::radians(90.0f);
+	LSystemState state;
+	prepareState(conf, state);
+
+	const voxel::Region region(0, 63);
+	const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 1);
+	voxel::RawVolume memoized(region);
+	voxel::RawVolume interpreted(region);
+	LSystemExecutionState execState;
+	int steps = 0;
+	while (step(memoized, voxel, state, execState)) {
+		++steps;
+	}
+	EXPECT_FALSE(execState.branches.empty());
+	EXPECT_LT((uint64_t)steps, state.commands) << "Memoized branches should be stamped in one step";
+	EXPECT_EQ(state.commands, execState.commands);
+
+	state.memoize = false;
+	generate(interpreted, voxel, state);
+
+	int voxels = 0;
+	for (int z = 0; z <= 63; ++z) {
+		for (int y = 0; y <= 63; ++y) {
+			for (int x = 0; x <= 63; ++x) {
+				const voxel::Voxel &expected = interpreted.voxel(x, y, z);
+				ASSERT_EQ(expected, memoized.voxel(x, y, z)) << x << ":" << y << ":" << z;
+				if (voxel::isBlocked(expected.getMaterial())) {
+					++voxels;
+				}
+			}
+		}
+	}
+	EXPECT_GT(voxels, 0);
+}
+
+TEST_F(LSystemTests, testVoxelTypeCommands) {
+	LSystemConfig conf;
+	conf.axiom = "A";
+	conf.rules.push_back({'A', "(12)F(3)F"});
+	conf.iterations = 1;
+	LSystemState state;
+	prepareState(conf, state);
+	// the digits are part of the voxel type command, the closing bracket is a command of its own
+	ASSERT_EQ(6u, state.commands);
+
+	CountingVolume volume;
+	const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 1);
+	LSystemExecutionState execState;
+	while (step(volume, voxel, state, execState)) {
+	}
+	EXPECT_EQ(state.commands, execState.commands);
+}
+
+TEST_F(LSystemTests, testLeavesAreNotMemoized) {
+	LSystemConfig conf;
+	conf.axiom = "F";
+	conf.rules.push_back({'F', "F[+FL]F[->FL]F"});
+	conf.iterations = 4;
+	conf.position = glm::ivec3(32, 0, 32);
+	conf.angle = glm::radians(90.0f);
+	LSystemState state;
+	prepareState(conf, state);
+
+	const voxel::Region region(0, 63);
+	const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 1);
+	voxel::RawVolume volume(region);
+	LSystemExecutionState execState;
+	while (step(volume, voxel, state, execState)) {
+	}
+	EXPECT_TRUE(execState.branches.empty());
+	EXPECT_EQ(state.commands, execState.commands);
+}
+
 } // namespace lsystem
 
 } // namespace voxelgenerator
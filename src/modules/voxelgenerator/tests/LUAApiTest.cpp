@@ -243,6 +243,20 @@ TEST_F(LUAApiTest, testSceneGraphNewNode) {
 	run(sceneGraph, script);
 }
 
+TEST_F(LUAApiTest, testShapeLSystem) {
+	const core::String script = R"(
+		function main(node, region, color)
+			local volume = node:volume()
+			g_shape.lsystem(volume, g_ivec3.new(4, 1, 4), "F", "{ F F[+F]F }", color, 90, 1, 1, 0.5, 2)
+			if volume:voxel(3, 0, 3) == -1 then
+				error('Expected the lsystem to generate voxels')
+			end
+		end
+	)";
+	scenegraph::SceneGraph sceneGraph;
+	run(sceneGraph, script);
+}
+
 TEST_F(LUAApiTest, DISABLED_testDownloadAndImport) {
 	voxelformat::FormatConfig::init();
 	scenegraph::SceneGraph sceneGraph;
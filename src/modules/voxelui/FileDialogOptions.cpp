@@ -245,6 +245,10 @@ bool saveOptions(const io::FormatDescription *desc, const io::FilesystemEntry &e
 		ImGui::CheckboxVar(_("Merge compounds"), cfg::VoxformatQBTMergeCompounds);
 	}
 
+	if (*desc == voxelformat::VENGIFormat::format()) {
+		ImGui::CheckboxVar(_("Parallel data layout"), cfg::VoxformatVENGIIndexed);
+	}
+
 	if (*desc == voxelformat::VoxFormat::format()) {
 		ImGui::CheckboxVar(_("Create groups"), cfg::VoxformatVOXCreateGroups);
 		ImGui::CheckboxVar(_("Create layers"), cfg::VoxformatVOXCreateLayers);
@@ -309,6 +313,7 @@ static void loadOptionsMesh() {
 	ImGui::InputVarString(_("Texture search path"), cfg::VoxformatTexturePath);
 	ImGui::CheckboxVar(_("Fill hollow"), cfg::VoxformatFillHollow);
 	ImGui::InputVarInt(_("Point cloud size"), cfg::VoxformatPointCloudSize);
+	ImGui::InputVarInt(_("Point cloud memory (MiB)"), cfg::VoxformatPointCloudMemory);
 	ImGui::CheckboxVar(_("Simplify"), cfg::VoxformatMeshSimplify);
 
 	const core::VarPtr &normalPaletteVar = core::Var::getSafe(cfg::NormalPalette);
@@ -9,6 +9,7 @@
 #include "core/SharedPtr.h"
 #include "core/StringUtil.h"
 #include "core/Var.h"
+#include "core/collection/Buffer.h"
 #include "image/Image.h"
 #include "math/Axis.h"
 #include "palette/Palette.h"
@@ -76,16 +77,22 @@ void importColoredHeightmap(voxel::RawVolumeWrapper &volume, const palette::Pale
 		const float stepWidthX = (float)imageWidth / (float)volumeWidth;
 		float imageY = start * stepWidthY;
 
+		// the alpha channel is the height - the colors of a row are mapped to the palette in one batch
+		core::Buffer<color::RGBA> colors(volumeWidth);
+		core::Buffer<uint8_t> heights(volumeWidth);
+		core::Buffer<uint8_t> indices(volumeWidth);
 		voxel::RawVolumeWrapper::Sampler sampler(volume);
 		for (int z = start; z < end; ++z, imageY += stepWidthY) {
 			float imageX = 0.0f;
 			for (int x = 0; x < volumeWidth; ++x, imageX += stepWidthX) {
 				const color::RGBA heightmapPixel = image->colorAt((int)imageX, (int)imageY);
-				const uint8_t heightValue =
-					getHeightValueFromAlpha(heightmapPixel.a, adoptHeight, volumeHeight, minHeight);
-				const color::RGBA rgba(heightmapPixel.r, heightmapPixel.g, heightmapPixel.b);
-				const uint8_t palidx = palLookup.findClosestIndex(rgba);
-				const voxel::Voxel surfaceVoxel = voxel::createVoxel(palLookup.palette(), palidx);
+				heights[x] = getHeightValueFromAlpha(heightmapPixel.a, adoptHeight, volumeHeight, minHeight);
+				colors[x] = color::RGBA(heightmapPixel.r, heightmapPixel.g, heightmapPixel.b);
+			}
+			palLookup.findClosestIndices(colors.data(), indices.data(), volumeWidth);
+			for (int x = 0; x < volumeWidth; ++x) {
+				const uint8_t heightValue = heights[x];
+				const voxel::Voxel surfaceVoxel = voxel::createVoxel(palLookup.palette(), indices[x]);
 				if (voxel::isAir(underground.getMaterial())) {
 					const glm::ivec3 pos(x, heightValue - 1, z);
 					const glm::ivec3 regionPos = mins + pos;
@@ -126,7 +133,7 @@ void importHeightmap(voxel::RawVolumeWrapper &volume, const image::ImagePtr &ima
 		const float stepWidthX = (float)imageWidth / (float)volumeWidth;
 		Log::debug("stepwidth: %f %f", stepWidthX, stepWidthY);
 		const float scaleHeight = adoptHeight ? (float)volumeHeight / (float)maxImageHeight : 1.0f;
-		float imageY = 0.0f;
+		float imageY = start * stepWidthY;
 		voxel::RawVolumeWrapper::Sampler sampler(volume);
 		sampler.setPosition(mins.x, mins.y, mins.z + start);
 		for (int z = start; z < end; ++z, imageY += stepWidthY) {
@@ -142,7 +149,7 @@ void importHeightmap(voxel::RawVolumeWrapper &volume, const image::ImagePtr &ima
 
 				if (voxel::isAir(underground.getMaterial())) {
 					sampler3.movePositiveY(heightValue - 1);
-					sampler.setVoxel(surface);
+					sampler3.setVoxel(surface);
 				} else {
 					for (int y = 0; y < heightValue; ++y) {
 						voxel::Voxel voxel = surface;
@@ -271,18 +278,23 @@ voxel::RawVolume *importAsVolume(const image::ImagePtr &image, const image::Imag
 	voxel::RawVolume *volume = new voxel::RawVolume(region);
 	palette::PaletteLookup palLookup(palette);
 	auto fn = [&palLookup, &palette, imageWidth, volume, image, depthmap, maxDepth, bothSides] (int start, int end) {
+		// the colors of a row are mapped to the palette in one batch
+		core::Buffer<color::RGBA> colors(imageWidth);
+		core::Buffer<uint8_t> indices(imageWidth);
 		voxel::RawVolume::Sampler sampler(volume);
-		sampler.setPosition(0, volume->region().getUpperY(), 0);
+		sampler.setPosition(0, volume->region().getUpperY() - start, 0);
 		for (int y = start; y < end; ++y) {
 			voxel::RawVolume::Sampler sampler2 = sampler;
 			for (int x = 0; x < imageWidth; ++x) {
-				const color::RGBA data = image->colorAt(x, y);
-				if (data.a == 0 /* AlphaThreshold */) {
+				colors[x] = image->colorAt(x, y);
+			}
+			palLookup.findClosestIndices(colors.data(), indices.data(), imageWidth);
+			for (int x = 0; x < imageWidth; ++x) {
+				if (colors[x].a == 0 /* AlphaThreshold */) {
 					sampler2.movePositiveX();
 					continue;
 				}
-				const uint8_t index = palLookup.findClosestIndex(data);
-				const voxel::Voxel voxel = voxel::createVoxel(palette, index);
+				const voxel::Voxel voxel = voxel::createVoxel(palette, indices[x]);
 				const color::RGBA heightdata = depthmap->colorAt(x, y);
 				const float thickness = (float)heightdata.r;
 				const float maxthickness = maxDepth;
@@ -0,0 +1,188 @@
+/**
+ * @file
+ */
+
+#include "OccupancyPyramid.h"
+#include "app/Async.h"
+#include "core/Trace.h"
+#include "voxel/RawVolume.h"
+#include "voxel/Voxel.h"
+
+namespace voxelutil {
+
+int OccupancyPyramid::cellIndex(int level, const glm::ivec3 &localPos) const {
+	const glm::ivec3 cell = localPos >> cellShift(level);
+	const glm::ivec3 &dim = _dimensions[level];
+	return cell.x + cell.y * dim.x + cell.z * dim.x * dim.y;
+}
+
+uint32_t OccupancyPyramid::solidVoxelsAt(int level, int idx) const {
+	if (level == 0) {
+		return _level0[idx];
+	}
+	if (level == 1) {
+		return _level1[idx];
+	}
+	return _level2[idx];
+}
+
+void OccupancyPyramid::addToParents(const glm::ivec3 &localPos, int delta) {
+	_level1[cellIndex(1, localPos)] += delta;
+	_level2[cellIndex(2, localPos)] += delta;
+}
+
+uint8_t OccupancyPyramid::countCell(const voxel::RawVolume &volume, const glm::ivec3 &cell) const {
+	const int size = cellSize(0);
+	const glm::ivec3 mins = cell * size;
+	const glm::ivec3 maxs = glm::min(mins + (size - 1), _region.getDimensionsInVoxels() - 1);
+	const voxel::Voxel *voxels = volume.voxels();
+	const int width = volume.width();
+	const int stride = _region.stride();
+	uint8_t solid = 0;
+	for (int z = mins.z; z <= maxs.z; ++z) {
+		for (int y = mins.y; y <= maxs.y; ++y) {
+			const voxel::Voxel *row = voxels + y * width + z * stride;
+			for (int x = mins.x; x <= maxs.x; ++x) {
+				if (!voxel::isAir(row[x].getMaterial())) {
+					++solid;
+				}
+			}
+		}
+	}
+	return solid;
+}
+
+void OccupancyPyramid::build(const voxel::RawVolume &volume) {
+	core_trace_scoped(OccupancyPyramidBuild);
+	_region = volume.region();
+	const glm::ivec3 &dim = _region.getDimensionsInVoxels();
+	for (int level = 0; level < Levels; ++level) {
+		const int size = cellSize(level);
+		_dimensions[level] = (dim + (size - 1)) / size;
+	}
+	const glm::ivec3 &dim0 = _dimensions[0];
+	_level0.resize((size_t)dim0.x * dim0.y * dim0.z);
+	_level0.fill(0);
+	_level1.resize((size_t)_dimensions[1].x * _dimensions[1].y * _dimensions[1].z);
+	_level1.fill(0);
+	_level2.resize((size_t)_dimensions[2].x * _dimensions[2].y * _dimensions[2].z);
+	_level2.fill(0);
+
+	// every task owns a layer of lowest level cells
+	const voxel::Voxel *voxels = volume.voxels();
+	const int width = volume.width();
+	const int stride = _region.stride();
+	const int shift = cellShift(0);
+	app::for_parallel(0, dim0.z, [&](int start, int end) {
+		for (int cz = start; cz < end; ++cz) {
+			const int zEnd = glm::min((cz + 1) << shift, dim.z);
+			for (int z = cz << shift; z < zEnd; ++z) {
+				for (int y = 0; y < dim.y; ++y) {
+					const voxel::Voxel *row = voxels + y * width + z * stride;
+					uint8_t *cells = &_level0[(size_t)(y >> shift) * dim0.x + (size_t)cz * dim0.x * dim0.y];
+					for (int x = 0; x < dim.x; ++x) {
+						if (!voxel::isAir(row[x].getMaterial())) {
+							++cells[x >> shift];
+						}
+					}
+				}
+			}
+		}
+	});
+
+	const int size0 = cellSize(0);
+	for (int cz = 0; cz < dim0.z; ++cz) {
+		for (int cy = 0; cy < dim0.y; ++cy) {
+			for (int cx = 0; cx < dim0.x; ++cx) {
+				const uint8_t solid = _level0[cx + cy * dim0.x + cz * dim0.x * dim0.y];
+				if (solid != 0u) {
+					addToParents(glm::ivec3(cx, cy, cz) * size0, solid);
+				}
+			}
+		}
+	}
+}
+
+void OccupancyPyramid::update(const voxel::RawVolume &volume, const voxel::Region &region) {
+	if (!isValid() || volume.region() != _region) {
+		build(volume);
+		return;
+	}
+	voxel::Region dirty(region);
+	if (!dirty.cropTo(_region)) {
+		return;
+	}
+	core_trace_scoped(OccupancyPyramidUpdate);
+	const int shift = cellShift(0);
+	const glm::ivec3 mins = (dirty.getLowerCorner() - _region.getLowerCorner()) >> shift;
+	const glm::ivec3 maxs = (dirty.getUpperCorner() - _region.getLowerCorner()) >> shift;
+	for (int cz = mins.z; cz <= maxs.z; ++cz) {
+		for (int cy = mins.y; cy <= maxs.y; ++cy) {
+			for (int cx = mins.x; cx <= maxs.x; ++cx) {
+				const glm::ivec3 cell(cx, cy, cz);
+				const glm::ivec3 localPos = cell << shift;
+				const int idx = cellIndex(0, localPos);
+				const uint8_t solid = countCell(volume, cell);
+				const int delta = (int)solid - (int)_level0[idx];
+				if (delta != 0) {
+					_level0[idx] = solid;
+					addToParents(localPos, delta);
+				}
+			}
+		}
+	}
+}
+
+bool OccupancyPyramid::setVoxel(voxel::RawVolume &volume, const glm::ivec3 &pos, const voxel::Voxel &voxel) {
+	const bool wasAir = voxel::isAir(volume.voxel(pos).getMaterial());
+	if (!volume.setVoxel(pos, voxel)) {
+		return false;
+	}
+	if (!isValid() || volume.region() != _region) {
+		build(volume);
+		return true;
+	}
+	const bool isAir = voxel::isAir(voxel.getMaterial());
+	if (wasAir == isAir) {
+		return true;
+	}
+	const int delta = isAir ? -1 : 1;
+	const glm::ivec3 localPos = pos - _region.getLowerCorner();
+	_level0[cellIndex(0, localPos)] += delta;
+	addToParents(localPos, delta);
+	return true;
+}
+
+void OccupancyPyramid::clear() {
+	_region = voxel::Region::InvalidRegion;
+	_level0.release();
+	_level1.release();
+	_level2.release();
+}
+
+uint32_t OccupancyPyramid::solidVoxels(int level, const glm::ivec3 &pos) const {
+	if (!_region.containsPoint(pos)) {
+		return 0u;
+	}
+	return solidVoxelsAt(level, cellIndex(level, pos - _region.getLowerCorner()));
+}
+
+bool OccupancyPyramid::emptyCell(const glm::ivec3 &pos, voxel::Region &cell) const {
+	if (!_region.containsPoint(pos)) {
+		return false;
+	}
+	const glm::ivec3 localPos = pos - _region.getLowerCorner();
+	for (int level = Levels - 1; level >= 0; --level) {
+		if (solidVoxelsAt(level, cellIndex(level, localPos)) != 0u) {
+			continue;
+		}
+		const int shift = cellShift(level);
+		const glm::ivec3 mins = _region.getLowerCorner() + ((localPos >> shift) << shift);
+		cell = voxel::Region(mins, mins + (cellSize(level) - 1));
+		cell.cropTo(_region);
+		return true;
+	}
+	return false;
+}
+
+} // namespace voxelutil
@@ -0,0 +1,99 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/collection/Buffer.h"
+#include "voxel/Region.h"
+#include <glm/vec3.hpp>
+
+namespace voxel {
+class RawVolume;
+class Voxel;
+} // namespace voxel
+
+namespace voxelutil {
+
+/**
+ * @brief Summary levels of a volume that store the amount of solid voxels in cells of 4, 16 and 64 voxels edge length
+ *
+ * This is used to skip empty space - e.g. in raycasts (see @c raycastWithEndpoints()). The pyramid stores counts
+ * instead of flags to be able to update it for single voxel changes without looking at the neighbours.
+ *
+ * @note The pyramid doesn't know about modifications of the volume - use @c setVoxel() or call @c update() for the
+ * modified region.
+ */
+class OccupancyPyramid {
+public:
+	static constexpr int Levels = 3;
+
+	/**
+	 * @return The edge length of the cells of the given level in voxels
+	 */
+	static constexpr int cellSize(int level) {
+		return 1 << cellShift(level);
+	}
+
+	static constexpr int cellShift(int level) {
+		return 2 + level * 2;
+	}
+
+private:
+	voxel::Region _region = voxel::Region::InvalidRegion;
+	glm::ivec3 _dimensions[Levels]{};
+	core::Buffer<uint8_t> _level0;
+	core::Buffer<uint16_t> _level1;
+	core::Buffer<uint32_t> _level2;
+
+	int cellIndex(int level, const glm::ivec3 &localPos) const;
+	uint32_t solidVoxelsAt(int level, int idx) const;
+	void addToParents(const glm::ivec3 &localPos, int delta);
+	/**
+	 * @brief Counts the solid voxels in the lowest level cell with the given cell coordinates
+	 */
+	uint8_t countCell(const voxel::RawVolume &volume, const glm::ivec3 &cell) const;
+
+public:
+	/**
+	 * @brief Counts the solid voxels of the whole volume - this must be called again if the region of the volume changes
+	 */
+	void build(const voxel::RawVolume &volume);
+	/**
+	 * @brief Recounts the solid voxels of the cells that intersect the given region
+	 */
+	void update(const voxel::RawVolume &volume, const voxel::Region &region);
+	/**
+	 * @brief Sets the voxel in the volume and updates the counts of the affected cells
+	 * @return @c false if the voxel wasn't changed
+	 */
+	bool setVoxel(voxel::RawVolume &volume, const glm::ivec3 &pos, const voxel::Voxel &voxel);
+	void clear();
+
+	/**
+	 * @return The amount of solid voxels in the cell of the given level that contains the given position
+	 */
+	uint32_t solidVoxels(int level, const glm::ivec3 &pos) const;
+	/**
+	 * @brief Looks up the largest empty cell that contains the given position
+	 * @param[out] cell The region of the cell - cropped to the region of the volume
+	 * @return @c false if the position is outside of the volume or there are solid voxels in the lowest level cell
+	 */
+	bool emptyCell(const glm::ivec3 &pos, voxel::Region &cell) const;
+
+	bool isValid() const;
+	/**
+	 * @return The region of the volume the pyramid was built for
+	 */
+	const voxel::Region &region() const;
+};
+
+inline bool OccupancyPyramid::isValid() const {
+	return _region.isValid();
+}
+
+inline const voxel::Region &OccupancyPyramid::region() const {
+	return _region;
+}
+
+} // namespace voxelutil
@@ -4,6 +4,7 @@
 
 #include "Raycast.h"
 #include "core/Common.h"
+#include <float.h>
 
 namespace voxelutil {
 
@@ -177,4 +178,91 @@ RaycastHit raycastFaceDetection(const glm::vec3 &rayOrigin, const glm::vec3 &ray
 	return {face, frac, hitPoint};
 }
 
+namespace detail {
+
+bool clipRay(const voxel::Region &region, const glm::vec3 &start, const glm::vec3 &end, glm::vec3 &clippedStart,
+			 glm::vec3 &clippedEnd) {
+	const glm::vec3 mins = glm::vec3(region.getLowerCorner()) - 1.0f;
+	const glm::vec3 maxs = glm::vec3(region.getUpperCorner()) + 2.0f;
+	const glm::vec3 dir = end - start;
+	float enter = 0.0f;
+	float exit = 1.0f;
+	for (int a = 0; a < 3; ++a) {
+		if (glm::abs(dir[a]) <= glm::epsilon<float>()) {
+			if (start[a] < mins[a] || start[a] >= maxs[a]) {
+				return false;
+			}
+			continue;
+		}
+		float t0 = (mins[a] - start[a]) / dir[a];
+		float t1 = (maxs[a] - start[a]) / dir[a];
+		if (t0 > t1) {
+			core::exchange(t0, t1);
+		}
+		enter = glm::max(enter, t0);
+		exit = glm::min(exit, t1);
+		if (enter > exit) {
+			return false;
+		}
+	}
+	clippedStart = start + dir * enter;
+	clippedEnd = start + dir * exit;
+	return true;
+}
+
+bool skipEmptyCell(const voxel::Region &cell, const glm::ivec3 &dir, const glm::ivec3 &endPos, const glm::vec3 &delta,
+				   glm::ivec3 &pos, glm::vec3 &t, glm::ivec3 &lastNormal) {
+	// the amount of steps along each axis that stay inside of the cell and the time of the step that leaves it
+	glm::ivec3 inside(0);
+	float exitT = FLT_MAX;
+	int exitAxis = 0;
+	for (int a = 0; a < 3; ++a) {
+		if (dir[a] != 0) {
+			const int boundary = dir[a] > 0 ? glm::min(cell.getUpperCorner()[a], endPos[a])
+											: glm::max(cell.getLowerCorner()[a], endPos[a]);
+			inside[a] = glm::max(0, (boundary - pos[a]) * dir[a]);
+		}
+		const float axisExitT = t[a] + (float)inside[a] * delta[a];
+		// on equal times the lower axis is stepped first
+		if (axisExitT < exitT) {
+			exitT = axisExitT;
+			exitAxis = a;
+		}
+	}
+
+	glm::ivec3 steps(0);
+	glm::ivec3 normal(0);
+	float lastStepT = -FLT_MAX;
+	for (int a = 0; a < 3; ++a) {
+		if (a == exitAxis) {
+			steps[a] = inside[a];
+		} else if (dir[a] != 0) {
+			const float n = (exitT - t[a]) / delta[a];
+			int s = (int)glm::ceil(n);
+			if (a < exitAxis && (float)s == n) {
+				++s;
+			}
+			steps[a] = glm::clamp(s, 0, inside[a]);
+		}
+		if (steps[a] == 0) {
+			continue;
+		}
+		const float stepT = t[a] + (float)(steps[a] - 1) * delta[a];
+		if (stepT >= lastStepT) {
+			lastStepT = stepT;
+			normal = glm::ivec3(0);
+			normal[a] = -dir[a];
+		}
+	}
+	if (steps.x + steps.y + steps.z == 0) {
+		return false;
+	}
+	pos += steps * dir;
+	t += glm::vec3(steps) * delta;
+	lastNormal = normal;
+	return true;
+}
+
+} // namespace detail
+
 } // namespace voxelutil
@@ -71,8 +71,10 @@
 #include "core/Common.h"
 #include "core/Trace.h"
 #include "voxel/Face.h"
+#include "voxelutil/OccupancyPyramid.h"
 #include <glm/ext/scalar_constants.hpp>
 #include <glm/geometric.hpp>
+#include <float.h>
 
 namespace voxelutil {
 
@@ -116,6 +118,27 @@ struct RaycastResult {
 	glm::vec3 projectOnPlane(const glm::vec3 &v) const;
 };
 
+namespace detail {
+
+/**
+ * @brief Clips the ray to the given region - one voxel on each side of the region is kept
+ * @return @c false if the ray doesn't touch the region
+ */
+bool clipRay(const voxel::Region &region, const glm::vec3 &start, const glm::vec3 &end, glm::vec3 &clippedStart,
+			 glm::vec3 &clippedEnd);
+
+/**
+ * @brief Moves the ray state of @c raycastWithEndpoints() to the last voxel of the given empty cell
+ *
+ * The voxels are stepped in the same order as the single steps would do it.
+ *
+ * @return @c false if there is no voxel left to skip in the cell
+ */
+bool skipEmptyCell(const voxel::Region &cell, const glm::ivec3 &dir, const glm::ivec3 &endPos, const glm::vec3 &delta,
+				   glm::ivec3 &pos, glm::vec3 &t, glm::ivec3 &lastNormal);
+
+} // namespace detail
+
 /**
  * Cast a ray through a volume by specifying the start and end positions
  *
@@ -124,7 +147,12 @@ struct RaycastResult {
  * returns a RaycastResults::Type::Interrupted. If it passes from start to end
  * without @a callback returning @a false, it returns RaycastResults::Type::Completed.
  *
+ * If an @c OccupancyPyramid is given, the ray is clipped to the region of the pyramid (keeping one voxel on each
+ * side) and the empty cells of the pyramid are skipped: the callback is only executed for the first and the last voxel
+ * of the ray in an empty cell. Use this for large and sparse volumes where the callback is looking for solid voxels.
+ *
  * @param volData The volume to pass the ray though
+ * @param occupancy The optional occupancy pyramid of the volume - must be up to date with the volume
  * @param start The start position in the volume
  * @param end The end position in the volume
  * @param callback The callback to call for each voxel
@@ -132,20 +160,30 @@ struct RaycastResult {
  * @return A RaycastResults designating whether the ray hit anything or not
  */
 template<typename Callback, class Volume>
-RaycastResult raycastWithEndpoints(Volume *volData, const glm::vec3 &start, const glm::vec3 &end, Callback &&callback) {
+RaycastResult raycastWithEndpoints(Volume *volData, const OccupancyPyramid *occupancy, const glm::vec3 &start,
+								   const glm::vec3 &end, Callback &&callback) {
 	core_trace_scoped(raycastWithEndpoints);
 	typename Volume::Sampler sampler(volData);
 
 	const glm::vec3 v3dStart = start + RaycastOffset;
 	const glm::vec3 v3dEnd = end + RaycastOffset;
-	const float x1 = v3dStart.x;
-	const float y1 = v3dStart.y;
-	const float z1 = v3dStart.z;
-	const float x2 = v3dEnd.x;
-	const float y2 = v3dEnd.y;
-	const float z2 = v3dEnd.z;
-
-	const glm::ivec3 floorEnd(glm::floor(v3dEnd));
+	glm::vec3 rayStart = v3dStart;
+	glm::vec3 rayEnd = v3dEnd;
+	if (occupancy != nullptr) {
+		if (!occupancy->isValid()) {
+			occupancy = nullptr;
+		} else if (!detail::clipRay(occupancy->region(), v3dStart, v3dEnd, rayStart, rayEnd)) {
+			return RaycastResult::completed(glm::distance(v3dStart, v3dEnd));
+		}
+	}
+	const float x1 = rayStart.x;
+	const float y1 = rayStart.y;
+	const float z1 = rayStart.z;
+	const float x2 = rayEnd.x;
+	const float y2 = rayEnd.y;
+	const float z2 = rayEnd.z;
+
+	const glm::ivec3 floorEnd(glm::floor(rayEnd));
 	const int iend = floorEnd.x;
 	const int jend = floorEnd.y;
 	const int kend = floorEnd.z;
@@ -154,18 +192,20 @@ RaycastResult raycastWithEndpoints(Volume *volData, const glm::vec3 &start, cons
 	const int dj = ((y1 < y2) ? 1 : ((y1 > y2) ? -1 : 0));
 	const int dk = ((z1 < z2) ? 1 : ((z1 > z2) ? -1 : 0));
 
-	const glm::vec3 dist = glm::abs(v3dEnd - v3dStart);
+	const glm::vec3 dist = glm::abs(rayEnd - rayStart);
 	// the distance between cell boundaries
 	const float deltatx = dist.x < glm::epsilon<float>() ? 1.0f : 1.0f / dist.x;
 	const float deltaty = dist.y < glm::epsilon<float>() ? 1.0f : 1.0f / dist.y;
 	const float deltatz = dist.z < glm::epsilon<float>() ? 1.0f : 1.0f / dist.z;
 
-	const glm::vec3 floorStart(glm::floor(v3dStart));
+	const glm::ivec3 startVoxel(glm::floor(v3dStart));
+	const glm::vec3 floorStart(glm::floor(rayStart));
 	const glm::vec3 maxs = floorStart + 1.0f;
 
-	float tx = ((di == -1) ? (x1 - floorStart.x) : (maxs.x - x1)) * deltatx;
-	float ty = ((dj == -1) ? (y1 - floorStart.y) : (maxs.y - y1)) * deltaty;
-	float tz = ((dk == -1) ? (z1 - floorStart.z) : (maxs.z - z1)) * deltatz;
+	// an axis without direction is never stepped - the ray ends once the other axes reached the end voxel
+	float tx = di == 0 ? FLT_MAX : ((di == -1) ? (x1 - floorStart.x) : (maxs.x - x1)) * deltatx;
+	float ty = dj == 0 ? FLT_MAX : ((dj == -1) ? (y1 - floorStart.y) : (maxs.y - y1)) * deltaty;
+	float tz = dk == 0 ? FLT_MAX : ((dk == -1) ? (z1 - floorStart.z) : (maxs.z - z1)) * deltatz;
 
 	int i = (int)floorStart.x;
 	int j = (int)floorStart.y;
@@ -174,9 +214,11 @@ RaycastResult raycastWithEndpoints(Volume *volData, const glm::vec3 &start, cons
 
 	// Track the last stepped face normal so we can report which face was hit when interrupted
 	glm::ivec3 lastNormal{0, 0, 0};
+	// don't look up the cell again after its empty space was skipped
+	bool skipped = false;
 	for (;;) {
 		if (!callback(sampler)) {
-			if (i == (int)floorStart.x && j == (int)floorStart.y && k == (int)floorStart.z) {
+			if (i == startVoxel.x && j == startVoxel.y && k == startVoxel.z) {
 				return RaycastResult::interrupted(0.0f, 0.0f, lastNormal);
 			}
 
@@ -198,6 +240,27 @@ RaycastResult raycastWithEndpoints(Volume *volData, const glm::vec3 &start, cons
 			return RaycastResult::interrupted(length, fract, lastNormal);
 		}
 
+		if (occupancy != nullptr) {
+			voxel::Region cell;
+			if (!skipped && occupancy->emptyCell(glm::ivec3(i, j, k), cell)) {
+				glm::ivec3 pos(i, j, k);
+				glm::vec3 t(tx, ty, tz);
+				if (detail::skipEmptyCell(cell, glm::ivec3(di, dj, dk), floorEnd, glm::vec3(deltatx, deltaty, deltatz),
+										  pos, t, lastNormal)) {
+					i = pos.x;
+					j = pos.y;
+					k = pos.z;
+					tx = t.x;
+					ty = t.y;
+					tz = t.z;
+					sampler.setPosition(i, j, k);
+					skipped = true;
+					continue;
+				}
+			}
+			skipped = false;
+		}
+
 		if (tx <= ty && tx <= tz) {
 			if (i == iend) {
 				break;
@@ -250,6 +313,15 @@ RaycastResult raycastWithEndpoints(Volume *volData, const glm::vec3 &start, cons
 	return RaycastResult::completed(length);
 }
 
+/**
+ * @copydoc raycastWithEndpoints()
+ */
+template<typename Callback, class Volume>
+RaycastResult raycastWithEndpoints(Volume *volData, const glm::vec3 &start, const glm::vec3 &end, Callback &&callback) {
+	return raycastWithEndpoints(volData, (const OccupancyPyramid *)nullptr, start, end,
+								core::forward<Callback>(callback));
+}
+
 /**
  * Cast a ray through a volume by specifying the start and a direction
  *
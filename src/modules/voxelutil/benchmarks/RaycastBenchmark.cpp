@@ -0,0 +1,103 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "core/ScopedPtr.h"
+#include "voxel/RawVolume.h"
+#include "voxel/Voxel.h"
+#include "voxelutil/OccupancyPyramid.h"
+#include "voxelutil/Raycast.h"
+
+/**
+ * @brief Picking rays through a large and sparse volume
+ */
+class RaycastBenchmark : public app::AbstractBenchmark {
+protected:
+	static constexpr int Size = 256;
+	static constexpr int Rays = 64;
+	core::ScopedPtr<voxel::RawVolume> _volume;
+	voxelutil::OccupancyPyramid _occupancy;
+	glm::vec3 _starts[Rays];
+	glm::vec3 _ends[Rays];
+
+public:
+	void SetUp(::benchmark::State &state) override {
+		app::AbstractBenchmark::SetUp(state);
+		_volume = new voxel::RawVolume(voxel::Region(0, Size - 1));
+		const voxel::Voxel voxel = voxel::createVoxel(voxel::VoxelType::Generic, 1);
+		// a ground plate and a few pillars
+		for (int z = 0; z < Size; ++z) {
+			for (int x = 0; x < Size; ++x) {
+				_volume->setVoxel(x, 0, z, voxel);
+			}
+		}
+		for (int i = 0; i < 16; ++i) {
+			const int px = 8 + (i * 67) % (Size - 16);
+			const int pz = 8 + (i * 131) % (Size - 16);
+			for (int y = 1; y < Size / 2; ++y) {
+				_volume->setVoxel(px, y, pz, voxel);
+			}
+		}
+		_occupancy.build(*_volume);
+		// rays from outside of the volume that are looking down onto the ground plate
+		for (int i = 0; i < Rays; ++i) {
+			_starts[i] = glm::vec3(-50.5f + (float)i, (float)Size + 20.3f, -40.7f + (float)(i * 3));
+			const glm::vec3 target((float)((i * 37) % Size) + 0.5f, 0.5f, (float)((i * 91) % Size) + 0.5f);
+			_ends[i] = _starts[i] + (target - _starts[i]) * 1.5f;
+		}
+	}
+
+	void TearDown(::benchmark::State &state) override {
+		_occupancy.clear();
+		_volume = nullptr;
+		app::AbstractBenchmark::TearDown(state);
+	}
+};
+
+struct SolidRaycastFunctor {
+	glm::ivec3 hit{0};
+	template<typename Sampler>
+	bool operator()(Sampler &sampler) {
+		if (voxel::isAir(sampler.voxel().getMaterial())) {
+			return true;
+		}
+		hit = sampler.position();
+		return false;
+	}
+};
+
+BENCHMARK_DEFINE_F(RaycastBenchmark, Plain)(benchmark::State &state) {
+	voxel::RawVolume *volume = _volume;
+	for (auto _ : state) {
+		for (int i = 0; i < Rays; ++i) {
+			SolidRaycastFunctor functor;
+			voxelutil::RaycastResult result = voxelutil::raycastWithEndpoints(volume, _starts[i], _ends[i], functor);
+			benchmark::DoNotOptimize(result);
+		}
+	}
+}
+
+BENCHMARK_DEFINE_F(RaycastBenchmark, OccupancyPyramid)(benchmark::State &state) {
+	voxel::RawVolume *volume = _volume;
+	for (auto _ : state) {
+		for (int i = 0; i < Rays; ++i) {
+			SolidRaycastFunctor functor;
+			voxelutil::RaycastResult result =
+				voxelutil::raycastWithEndpoints(volume, &_occupancy, _starts[i], _ends[i], functor);
+			benchmark::DoNotOptimize(result);
+		}
+	}
+}
+
+BENCHMARK_DEFINE_F(RaycastBenchmark, BuildOccupancyPyramid)(benchmark::State &state) {
+	for (auto _ : state) {
+		voxelutil::OccupancyPyramid occupancy;
+		occupancy.build(*_volume);
+		benchmark::DoNotOptimize(occupancy);
+	}
+}
+
+BENCHMARK_REGISTER_F(RaycastBenchmark, Plain);
+BENCHMARK_REGISTER_F(RaycastBenchmark, OccupancyPyramid);
+BENCHMARK_REGISTER_F(RaycastBenchmark, BuildOccupancyPyramid);
@@ -7,6 +7,7 @@
 #include "color/Color.h"
 #include "core/ScopedPtr.h"
 #include "core/String.h"
+#include "core/collection/Buffer.h"
 #include "core/tests/TestColorHelper.h"
 #include "image/Image.h"
 #include "io/FileStream.h"
@@ -22,6 +23,11 @@
 namespace voxelutil {
 
 class ImageUtilsTest : public app::AbstractTest {
+public:
+	// the image rows are imported in parallel
+	ImageUtilsTest() : app::AbstractTest(4) {
+	}
+
 protected:
 	void validateVoxel(const voxel::RawVolume &volume, const palette::Palette &palette, const image::ImagePtr &image,
 					   int x, int y) {
@@ -181,6 +187,43 @@ TEST_F(ImageUtilsTest, testImportColoredHeightmapSurfaceOnly) {
 	validateHeightmap(underground);
 }
 
+TEST_F(ImageUtilsTest, testImportHeightmap) {
+	// enough rows to distribute them over several workers
+	constexpr int w = 2;
+	constexpr int h = 256;
+	core::Buffer<color::RGBA> buffer(w * h);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			const uint8_t height = (uint8_t)(y % 31 + 1);
+			buffer[y * w + x] = color::RGBA(height, height, height);
+		}
+	}
+	const image::ImagePtr &image = image::createEmptyImage("heightmap");
+	ASSERT_TRUE(image->loadRGBA((const uint8_t *)buffer.data(), w, h));
+	const voxel::Voxel underground = voxel::createVoxel(voxel::VoxelType::Generic, 1);
+	const voxel::Voxel surface = voxel::createVoxel(voxel::VoxelType::Generic, 2);
+	const voxel::Voxel air;
+	const voxel::Region region(0, 0, 0, w - 1, 31, h - 1);
+	for (const voxel::Voxel &ground : {underground, air}) {
+		voxel::RawVolume volume(region);
+		voxel::RawVolumeWrapper wrapper(&volume);
+		voxelutil::importHeightmap(wrapper, image, ground, surface, 0, false);
+		for (int z = 0; z < h; ++z) {
+			const int height = z % 31 + 1;
+			for (int x = 0; x < w; ++x) {
+				ASSERT_EQ(surface.getColor(), volume.voxel(x, height - 1, z).getColor()) << x << ":" << z;
+				ASSERT_TRUE(voxel::isBlocked(volume.voxel(x, height - 1, z).getMaterial())) << x << ":" << z;
+				if (height < region.getHeightInVoxels()) {
+					ASSERT_TRUE(voxel::isAir(volume.voxel(x, height, z).getMaterial())) << x << ":" << z;
+				}
+			}
+		}
+		if (voxel::isAir(ground.getMaterial())) {
+			EXPECT_EQ(w * h, voxelutil::countVoxels(volume));
+		}
+	}
+}
+
 TEST_F(ImageUtilsTest, testRenderToImage) {
 	palette::Palette palette;
 	palette.nippon();
@@ -0,0 +1,97 @@
+/**
+ * @file
+ */
+
+#include "voxelutil/OccupancyPyramid.h"
+#include "app/tests/AbstractTest.h"
+#include "voxel/RawVolume.h"
+#include "voxel/Voxel.h"
+
+namespace voxelutil {
+
+class OccupancyPyramidTest : public app::AbstractTest {};
+
+TEST_F(OccupancyPyramidTest, testBuild) {
+	voxel::RawVolume volume(voxel::Region(-5, 70));
+	volume.setVoxel(glm::ivec3(-5, -5, -5), voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	volume.setVoxel(glm::ivec3(-4, -5, -5), voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	volume.setVoxel(glm::ivec3(70, 70, 70), voxel::createVoxel(voxel::VoxelType::Generic, 1));
+
+	OccupancyPyramid occupancy;
+	occupancy.build(volume);
+	ASSERT_TRUE(occupancy.isValid());
+	EXPECT_EQ(2u, occupancy.solidVoxels(0, glm::ivec3(-5, -5, -5)));
+	EXPECT_EQ(2u, occupancy.solidVoxels(1, glm::ivec3(5, 5, 5)));
+	EXPECT_EQ(2u, occupancy.solidVoxels(2, glm::ivec3(58, 58, 58)));
+	EXPECT_EQ(1u, occupancy.solidVoxels(2, glm::ivec3(70, 70, 70)));
+	EXPECT_EQ(0u, occupancy.solidVoxels(0, glm::ivec3(-1, -5, -5)));
+}
+
+TEST_F(OccupancyPyramidTest, testEmptyCell) {
+	voxel::RawVolume volume(voxel::Region(0, 99));
+	volume.setVoxel(glm::ivec3(1, 1, 1), voxel::createVoxel(voxel::VoxelType::Generic, 1));
+
+	OccupancyPyramid occupancy;
+	occupancy.build(volume);
+	voxel::Region cell;
+	EXPECT_FALSE(occupancy.emptyCell(glm::ivec3(2, 2, 2), cell));
+	EXPECT_FALSE(occupancy.emptyCell(glm::ivec3(100, 0, 0), cell));
+
+	ASSERT_TRUE(occupancy.emptyCell(glm::ivec3(5, 0, 0), cell));
+	EXPECT_EQ(voxel::Region(4, 0, 0, 7, 3, 3), cell);
+
+	ASSERT_TRUE(occupancy.emptyCell(glm::ivec3(20, 0, 0), cell));
+	EXPECT_EQ(voxel::Region(16, 0, 0, 31, 15, 15), cell);
+
+	// the cell is cropped to the volume region
+	ASSERT_TRUE(occupancy.emptyCell(glm::ivec3(90, 90, 90), cell));
+	EXPECT_EQ(voxel::Region(64, 99), cell);
+}
+
+TEST_F(OccupancyPyramidTest, testSetVoxel) {
+	voxel::RawVolume volume(voxel::Region(0, 63));
+	OccupancyPyramid occupancy;
+	occupancy.build(volume);
+	voxel::Region cell;
+	ASSERT_TRUE(occupancy.emptyCell(glm::ivec3(10, 10, 10), cell));
+
+	const voxel::Voxel solid = voxel::createVoxel(voxel::VoxelType::Generic, 1);
+	ASSERT_TRUE(occupancy.setVoxel(volume, glm::ivec3(10, 10, 10), solid));
+	EXPECT_FALSE(occupancy.setVoxel(volume, glm::ivec3(10, 10, 10), solid)) << "Voxel didn't change";
+	EXPECT_EQ(1u, occupancy.solidVoxels(0, glm::ivec3(8, 8, 8)));
+	EXPECT_EQ(1u, occupancy.solidVoxels(2, glm::ivec3(0, 0, 0)));
+	EXPECT_FALSE(occupancy.emptyCell(glm::ivec3(10, 10, 10), cell));
+
+	ASSERT_TRUE(occupancy.setVoxel(volume, glm::ivec3(10, 10, 10), voxel::Voxel()));
+	EXPECT_EQ(0u, occupancy.solidVoxels(2, glm::ivec3(0, 0, 0)));
+	EXPECT_TRUE(occupancy.emptyCell(glm::ivec3(10, 10, 10), cell));
+}
+
+TEST_F(OccupancyPyramidTest, testUpdate) {
+	voxel::RawVolume volume(voxel::Region(0, 40));
+	OccupancyPyramid occupancy;
+	occupancy.build(volume);
+
+	const voxel::Region modified(3, 20);
+	for (int z = modified.getLowerZ(); z <= modified.getUpperZ(); ++z) {
+		for (int y = modified.getLowerY(); y <= modified.getUpperY(); ++y) {
+			for (int x = modified.getLowerX(); x <= modified.getUpperX(); ++x) {
+				volume.setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+			}
+		}
+	}
+	occupancy.update(volume, modified);
+	EXPECT_EQ((uint32_t)modified.voxels(), occupancy.solidVoxels(2, glm::ivec3(0)));
+	EXPECT_EQ(1u, occupancy.solidVoxels(0, glm::ivec3(0)));
+	EXPECT_EQ(64u, occupancy.solidVoxels(0, glm::ivec3(4)));
+
+	OccupancyPyramid rebuilt;
+	rebuilt.build(volume);
+	for (int i = 0; i <= 40; ++i) {
+		const glm::ivec3 pos(i, (i * 7) % 41, (i * 13) % 41);
+		EXPECT_EQ(rebuilt.solidVoxels(0, pos), occupancy.solidVoxels(0, pos));
+		EXPECT_EQ(rebuilt.solidVoxels(1, pos), occupancy.solidVoxels(1, pos));
+	}
+}
+
+} // namespace voxelutil
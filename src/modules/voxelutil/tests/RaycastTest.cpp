@@ -548,4 +548,70 @@ TEST_F(RaycastTest, testRaycastCornerHitFraction) {
 	EXPECT_NEAR(result.length, glm::length(dir) * 0.375f, 0.0001f);
 }
 
+TEST_F(RaycastTest, testRaycastOccupancyPyramidMatchesPlainRaycast) {
+	const voxel::Region region(-10, 120);
+	voxel::RawVolume volume(region);
+	for (int i = 0; i < 40; ++i) {
+		const glm::ivec3 pos(-10 + (i * 37) % 131, -10 + (i * 53) % 131, -10 + (i * 71) % 131);
+		volume.setVoxel(pos, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	}
+	OccupancyPyramid occupancy;
+	occupancy.build(volume);
+
+	int hits = 0;
+	for (int i = 0; i < 500; ++i) {
+		const glm::vec3 start(-30.0f + (float)((i * 17) % 180) + 0.3f, -30.0f + (float)((i * 29) % 180) + 0.6f,
+							  -30.0f + (float)((i * 43) % 180) + 0.1f);
+		const int n = i % 40;
+		const glm::ivec3 target(-10 + (n * 37) % 131, -10 + (n * 53) % 131, -10 + (n * 71) % 131);
+		const glm::vec3 end = start + (glm::vec3(target) + 0.5f - start) * 2.0f;
+
+		SimpleRaycastFunctor plain;
+		const RaycastResult plainResult = raycastWithEndpoints(&volume, start, end, plain);
+		SimpleRaycastFunctor accelerated;
+		const RaycastResult acceleratedResult = raycastWithEndpoints(&volume, &occupancy, start, end, accelerated);
+
+		ASSERT_EQ(plain.hitSolid, accelerated.hitSolid) << "ray " << i;
+		ASSERT_EQ(plainResult.type, acceleratedResult.type) << "ray " << i;
+		if (!plain.hitSolid) {
+			continue;
+		}
+		++hits;
+		EXPECT_EQ(plain.hitPosition, accelerated.hitPosition) << "ray " << i;
+		EXPECT_EQ(plainResult.normal, acceleratedResult.normal) << "ray " << i;
+		EXPECT_NEAR(plainResult.fract, acceleratedResult.fract, 0.0001f) << "ray " << i;
+		EXPECT_LE(accelerated.visitedVoxels, plain.visitedVoxels) << "ray " << i;
+	}
+	EXPECT_GT(hits, 400);
+}
+
+TEST_F(RaycastTest, testRaycastOccupancyPyramidSkipsEmptySpace) {
+	voxel::RawVolume volume(voxel::Region(0, 255));
+	volume.setVoxel(glm::ivec3(200, 100, 100), voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	OccupancyPyramid occupancy;
+	occupancy.build(volume);
+
+	const glm::vec3 start(-20.5f, 100.5f, 100.5f);
+	const glm::vec3 end(300.5f, 100.5f, 100.5f);
+	SimpleRaycastFunctor functor;
+	const RaycastResult result = raycastWithEndpoints(&volume, &occupancy, start, end, functor);
+	ASSERT_TRUE(result.isInterrupted());
+	EXPECT_EQ(glm::ivec3(200, 100, 100), functor.hitPosition);
+	EXPECT_EQ(glm::ivec3(-1, 0, 0), result.normal);
+	EXPECT_LT(functor.visitedVoxels, 20);
+}
+
+TEST_F(RaycastTest, testRaycastOccupancyPyramidMissesRegion) {
+	voxel::RawVolume volume(voxel::Region(0, 31));
+	volume.setVoxel(glm::ivec3(0, 0, 0), voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	OccupancyPyramid occupancy;
+	occupancy.build(volume);
+
+	CountingRaycastFunctor functor;
+	const RaycastResult result =
+		raycastWithEndpoints(&volume, &occupancy, glm::vec3(-100.0f, 50.0f, 0.5f), glm::vec3(100.0f, 60.0f, 0.5f), functor);
+	EXPECT_TRUE(result.isCompleted());
+	EXPECT_EQ(0, functor.visitedVoxels);
+}
+
 } // namespace voxelutil
@@ -250,6 +250,13 @@ void CollectionPanel::thumbnailTooltip(voxelcollection::VoxelFile *voxelFile) {
 			const video::Id handle = texture->handle();
 			ImGui::Image(handle, ImGui::Size(40.0f));
 			ImGui::TextUnformatted(voxelFile->fullPath.c_str());
+			voxelcollection::AssetEntry entry;
+			if (voxelFile->isLocal() && _collectionMgr->assetIndex()->get(voxelFile->fullPath, entry) &&
+				entry.scanned) {
+				ImGui::Text(_("Size: %i:%i:%i"), entry.dimensions.x, entry.dimensions.y, entry.dimensions.z);
+				ImGui::Text(_("Voxels: %i"), (int)entry.voxels);
+				ImGui::Text(_("Models: %i"), (int)entry.nodes);
+			}
 			ImGui::EndTooltip();
 		}
 	}
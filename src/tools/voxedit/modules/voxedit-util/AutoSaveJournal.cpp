@@ -0,0 +1,390 @@
+/**
+ * @file
+ */
+
+#include "AutoSaveJournal.h"
+#include "app/Async.h"
+#include "core/FourCC.h"
+#include "core/Log.h"
+#include "core/ScopedPtr.h"
+#include "core/StringUtil.h"
+#include "core/collection/Buffer.h"
+#include "io/File.h"
+#include "io/FileStream.h"
+#include "io/Filesystem.h"
+#include "io/FilesystemArchive.h"
+#include "io/MemoryArchive.h"
+#include "io/BufferedReadWriteStream.h"
+#include "memento/MementoHandler.h"
+#include "scenegraph/SceneGraph.h"
+#include "scenegraph/SceneGraphNode.h"
+#include "scenegraph/SceneGraphUtil.h"
+#include "voxel/RawVolume.h"
+#include "voxelformat/Format.h"
+#include "voxelformat/FormatConfig.h"
+#include "voxelformat/private/vengi/VENGIFormat.h"
+
+namespace voxedit {
+
+static constexpr uint32_t JournalEntryMagic = FourCC('J', 'N', 'R', 'L');
+// root node property of the full save that the journal entries must match
+static constexpr const char *GenerationProperty = "autosave_generation";
+
+void AutoSaveJournal::markDirty(const memento::MementoState &state) {
+	switch (state.type) {
+	case memento::MementoType::Modification:
+	case memento::MementoType::SceneNodeRenamed:
+	case memento::MementoType::SceneNodePaletteChanged:
+	case memento::MementoType::SceneNodeNormalPaletteChanged:
+	case memento::MementoType::SceneNodeKeyFrames:
+	case memento::MementoType::SceneNodeProperties:
+		_dirtyNodes.insert(state.nodeUUID);
+		break;
+	case memento::MementoType::SceneNodeMove:
+	case memento::MementoType::SceneNodeAdded:
+	case memento::MementoType::SceneNodeRemoved:
+	case memento::MementoType::SceneGraphAnimation:
+	case memento::MementoType::Max:
+		_structureChanged = true;
+		// the node might come back with a different volume (undo of a removal)
+		if (state.nodeUUID.isValid()) {
+			_dirtyNodes.insert(state.nodeUUID);
+		}
+		break;
+	}
+}
+
+void AutoSaveJournal::onMementoStateAdded(const memento::MementoState &state) {
+	markDirty(state);
+}
+
+void AutoSaveJournal::onMementoStateSkipped(const memento::MementoState &state) {
+	// undo and redo are modifying the scene, too
+	markDirty(state);
+}
+
+void AutoSaveJournal::reset() {
+	_dirtyNodes.clear();
+	_structureChanged = true;
+	_entries = 0;
+	_filename = "";
+	_generation = core::UUID();
+	_volumes.clear();
+}
+
+bool AutoSaveJournal::busy() const {
+	return _job.valid() && !_job.ready();
+}
+
+bool AutoSaveJournal::wait() {
+	if (!_job.valid()) {
+		return true;
+	}
+	const bool success = _job.get();
+	_job = {};
+	if (!success) {
+		// the journal might miss an entry now
+		_structureChanged = true;
+	}
+	return success;
+}
+
+core::String AutoSaveJournal::journalFilename(const core::String &filename) {
+	return filename + ".journal";
+}
+
+bool AutoSaveJournal::isAutoSave(const core::String &filename) {
+	return core::string::startsWith(core::string::extractFilenameWithExtension(filename), "autosave-");
+}
+
+void AutoSaveJournal::snapshotVolume(const scenegraph::SceneGraphNode &node, scenegraph::SceneGraphNode &newNode,
+									 VolumeSnapshots &snapshots, Volumes &volumes) {
+	VolumeSnapshot snapshot;
+	if (_dirtyNodes.has(node.uuid()) || !_volumes.get(node.uuid(), snapshot) || snapshot.source != node.volume()) {
+		snapshot.source = node.volume();
+		snapshot.copy = core::make_shared<voxel::RawVolume>(node.volume());
+	}
+	snapshots.put(node.uuid(), snapshot);
+	volumes.push_back(snapshot.copy);
+	newNode.setVolume((const voxel::RawVolume *)snapshot.copy.get());
+}
+
+int AutoSaveJournal::copyNode_r(scenegraph::SceneGraph &target, const scenegraph::SceneGraph &source,
+								const scenegraph::SceneGraphNode &node, int parent, core::Map<int, int> &nodeMapping,
+								VolumeSnapshots &snapshots, Volumes &volumes) {
+	scenegraph::SceneGraphNode newNode(node.type(), node.uuid());
+	scenegraph::copyNode(node, newNode, false);
+	if (node.isModelNode()) {
+		snapshotVolume(node, newNode, snapshots, volumes);
+	}
+	const int nodeId = target.emplace(core::move(newNode), parent);
+	if (nodeId == InvalidNodeId) {
+		return InvalidNodeId;
+	}
+	nodeMapping.put(node.id(), nodeId);
+	for (int childId : node.children()) {
+		if (copyNode_r(target, source, source.node(childId), nodeId, nodeMapping, snapshots, volumes) ==
+			InvalidNodeId) {
+			return InvalidNodeId;
+		}
+	}
+	return nodeId;
+}
+
+bool AutoSaveJournal::copySceneGraphWithUUIDs(scenegraph::SceneGraph &target, const scenegraph::SceneGraph &source,
+											  Volumes &volumes) {
+	for (const core::String &animation : source.animations()) {
+		target.addAnimation(animation);
+	}
+	target.setRootUUID(source.root().uuid());
+	target.node(target.root().id()).addProperties(source.root().properties());
+	core::Map<int, int> nodeMapping;
+	// the snapshots of removed nodes are dropped
+	VolumeSnapshots snapshots;
+	for (int childId : source.root().children()) {
+		if (copyNode_r(target, source, source.node(childId), target.root().id(), nodeMapping, snapshots, volumes) ==
+			InvalidNodeId) {
+			Log::error("Failed to copy the scene graph for the autosave");
+			return false;
+		}
+	}
+	_volumes = core::move(snapshots);
+	for (auto iter = target.begin(scenegraph::SceneGraphNodeType::ModelReference); iter != target.end(); ++iter) {
+		int nodeId;
+		if (!nodeMapping.get((*iter).reference(), nodeId)) {
+			Log::error("Failed to map the reference node for the autosave");
+			return false;
+		}
+		(*iter).setReference(nodeId);
+	}
+	target.updateTransforms();
+	return true;
+}
+
+static bool saveFull(const scenegraph::SceneGraph &sceneGraph, const core::String &filename) {
+	const io::ArchivePtr &archive = io::openFilesystemArchive(io::filesystem());
+	voxelformat::VENGIFormat format;
+	// the journal entries are applied by node uuid - the nodes must be saved as they are
+	voxelformat::SaveContext ctx(voxelformat::FormatConfig::lossless());
+	// never leave a partially written full save behind - the journal entries of the old one are still valid then
+	const core::String tmpFilename = filename + ".tmp";
+	if (!format.save(sceneGraph, tmpFilename, archive, ctx)) {
+		Log::error("Failed to write the autosave %s", tmpFilename.c_str());
+		io::Filesystem::sysRemoveFile(tmpFilename);
+		return false;
+	}
+	if (!io::Filesystem::sysRenameFile(tmpFilename, filename)) {
+		io::Filesystem::sysRemoveFile(tmpFilename);
+		return false;
+	}
+	// the new generation id makes the old entries invalid - even if we crash before the journal is removed
+	const core::String &journal = AutoSaveJournal::journalFilename(filename);
+	if (io::Filesystem::sysExists(journal) && !io::Filesystem::sysRemoveFile(journal)) {
+		Log::error("Failed to remove the autosave journal %s", journal.c_str());
+		return false;
+	}
+	return true;
+}
+
+static bool appendEntry(const scenegraph::SceneGraph &sceneGraph, const core::String &filename,
+						const core::UUID &generation) {
+	const io::MemoryArchivePtr &memArchive = io::openMemoryArchive();
+	voxelformat::VENGIFormat format;
+	voxelformat::SaveContext ctx(voxelformat::FormatConfig::lossless());
+	const core::String entryName = "entry.vengi";
+	if (!format.save(sceneGraph, entryName, memArchive, ctx)) {
+		Log::error("Failed to serialize the autosave journal entry");
+		return false;
+	}
+	core::ScopedPtr<io::SeekableReadStream> entryStream(memArchive->readStream(entryName));
+	if (!entryStream) {
+		return false;
+	}
+	const core::String &journal = AutoSaveJournal::journalFilename(filename);
+	io::FilePtr file = core::make_shared<io::File>(journal, io::FileMode::Append);
+	io::FileStream stream(file);
+	if (!stream.valid()) {
+		Log::error("Failed to open the autosave journal %s", journal.c_str());
+		return false;
+	}
+	if (!stream.writeUInt32(JournalEntryMagic) || !stream.writeUInt64(generation.data0()) ||
+		!stream.writeUInt64(generation.data1()) || !stream.writeUInt32((uint32_t)entryStream->size()) ||
+		!stream.writeStream(*entryStream)) {
+		Log::error("Failed to write to the autosave journal %s", journal.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool AutoSaveJournal::save(const scenegraph::SceneGraph &sceneGraph, const core::String &filename) {
+	if (busy()) {
+		return false;
+	}
+	wait();
+
+	const bool full = _structureChanged || _filename != filename || _entries >= MaxEntries;
+	core::SharedPtr<scenegraph::SceneGraph> copy = core::make_shared<scenegraph::SceneGraph>();
+	Volumes volumes;
+	if (full) {
+		if (!copySceneGraphWithUUIDs(*copy.get(), sceneGraph, volumes)) {
+			return false;
+		}
+		_generation = core::UUID::generate();
+		copy->node(copy->root().id()).setProperty(GenerationProperty, _generation.str());
+	} else {
+		for (const core::String &animation : sceneGraph.animations()) {
+			copy->addAnimation(animation);
+		}
+		bool needFullSave = false;
+		int copied = 0;
+		VolumeSnapshots snapshots;
+		for (const auto &entry : sceneGraph.nodes()) {
+			const scenegraph::SceneGraphNode &node = entry->second;
+			if (node.isRootNode() || !_dirtyNodes.has(node.uuid())) {
+				continue;
+			}
+			if (node.isReferenceNode()) {
+				// the referenced node is not part of the entry
+				needFullSave = true;
+				break;
+			}
+			scenegraph::SceneGraphNode newNode(node.type(), node.uuid());
+			scenegraph::copyNode(node, newNode, false);
+			if (node.isModelNode()) {
+				snapshotVolume(node, newNode, snapshots, volumes);
+			}
+			copy->emplace(core::move(newNode), copy->root().id());
+			++copied;
+		}
+		if (needFullSave) {
+			_structureChanged = true;
+			return save(sceneGraph, filename);
+		}
+		if (copied == 0) {
+			// nothing was modified or the modified nodes were removed
+			_dirtyNodes.clear();
+			return true;
+		}
+		for (auto iter = snapshots.begin(); iter != snapshots.end(); ++iter) {
+			_volumes.put(iter->key, iter->value);
+		}
+	}
+	_dirtyNodes.clear();
+	_structureChanged = false;
+	_filename = filename;
+	_entries = full ? 0 : _entries + 1;
+	Log::debug("Schedule %s autosave %s", full ? "full" : "incremental", filename.c_str());
+	const core::UUID generation = _generation;
+	// the copy only references the volume snapshots
+	_job = app::async([copy, volumes, filename, full, generation]() {
+		if (full) {
+			return saveFull(*copy.get(), filename);
+		}
+		return appendEntry(*copy.get(), filename, generation);
+	});
+	return true;
+}
+
+/**
+ * @brief Replaces the data of the node with the data of the journal entry node
+ */
+static void applyNode(scenegraph::SceneGraph &sceneGraph, scenegraph::SceneGraphNode &entryNode,
+					  scenegraph::SceneGraphNode &node) {
+	node.setName(entryNode.name());
+	node.setVisible(entryNode.visible());
+	node.setLocked(entryNode.locked());
+	node.setColor(entryNode.color());
+	node.setPivot(entryNode.pivot());
+	node.properties().clear();
+	node.addProperties(entryNode.properties());
+	if (entryNode.hasPalette()) {
+		node.setPalette(entryNode.palette());
+	}
+	if (entryNode.hasNormalPalette()) {
+		node.setNormalPalette(entryNode.normalPalette());
+	}
+	sceneGraph.setAllKeyFramesForNode(node, entryNode.allKeyFrames());
+	if (node.isModelNode() && entryNode.isModelNode()) {
+		voxel::RawVolume *volume = entryNode.volume();
+		entryNode.releaseOwnership();
+		node.setVolume(volume, true);
+	}
+}
+
+bool AutoSaveJournal::replay(const core::String &filename, const io::ArchivePtr &archive,
+							 scenegraph::SceneGraph &sceneGraph) {
+	scenegraph::SceneGraphNode &root = sceneGraph.node(sceneGraph.root().id());
+	const core::UUID generation(root.property(GenerationProperty));
+	// this is an internal property of the autosave - don't let it end up in the files of the user
+	root.properties().remove(GenerationProperty);
+	const core::String &journal = journalFilename(filename);
+	if (!archive->exists(journal)) {
+		return true;
+	}
+	core::ScopedPtr<io::SeekableReadStream> stream(archive->readStream(journal));
+	if (!stream) {
+		return false;
+	}
+	int entries = 0;
+	int skipped = 0;
+	while (stream->remaining() >= 24) {
+		uint32_t magic;
+		uint64_t generation0;
+		uint64_t generation1;
+		uint32_t size;
+		if (stream->readUInt32(magic) == -1 || stream->readUInt64(generation0) == -1 ||
+			stream->readUInt64(generation1) == -1 || stream->readUInt32(size) == -1) {
+			Log::error("Failed to read the journal entry header");
+			return false;
+		}
+		if (magic != JournalEntryMagic || (int64_t)size > stream->remaining()) {
+			// the last entry might be incomplete if the application crashed while writing it
+			Log::warn("Invalid journal entry %i in %s", entries, journal.c_str());
+			break;
+		}
+		if (!generation.isValid() || core::UUID(generation0, generation1) != generation) {
+			// written for an older full save
+			if (stream->skip(size) == -1) {
+				return false;
+			}
+			++skipped;
+			continue;
+		}
+		core::Buffer<uint8_t> buf(size);
+		if (stream->read(buf.data(), size) != (int)size) {
+			Log::error("Failed to read the journal entry %i", entries);
+			return false;
+		}
+		const io::MemoryArchivePtr &memArchive = io::openMemoryArchive();
+		const core::String entryName = "entry.vengi";
+		memArchive->add(entryName, buf.data(), buf.size());
+		scenegraph::SceneGraph entrySceneGraph;
+		voxelformat::VENGIFormat format;
+		voxelformat::LoadContext ctx(voxelformat::FormatConfig::lossless());
+		if (!format.load(entryName, memArchive, entrySceneGraph, ctx)) {
+			Log::error("Failed to load the journal entry %i", entries);
+			return false;
+		}
+		for (const auto &entry : entrySceneGraph.nodes()) {
+			if (entry->second.isRootNode()) {
+				continue;
+			}
+			scenegraph::SceneGraphNode &entryNode = entrySceneGraph.node(entry->second.id());
+			scenegraph::SceneGraphNode *node = sceneGraph.findNodeByUUID(entryNode.uuid());
+			if (node == nullptr || node->type() != entryNode.type()) {
+				Log::warn("Journal entry for unknown node %s", entryNode.uuid().str().c_str());
+				continue;
+			}
+			applyNode(sceneGraph, entryNode, *node);
+		}
+		++entries;
+	}
+	sceneGraph.updateTransforms();
+	if (skipped > 0) {
+		Log::warn("Skipped %i stale journal entries in %s", skipped, journal.c_str());
+	}
+	Log::info("Applied %i journal entries from %s", entries, journal.c_str());
+	return true;
+}
+
+} // namespace voxedit
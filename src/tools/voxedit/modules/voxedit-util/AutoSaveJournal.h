@@ -0,0 +1,123 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/SharedPtr.h"
+#include "core/String.h"
+#include "core/UUID.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/DynamicMap.h"
+#include "core/collection/DynamicSet.h"
+#include "core/collection/Map.h"
+#include "core/concurrent/Future.h"
+#include "io/Archive.h"
+#include "memento/IMementoStateListener.h"
+
+namespace scenegraph {
+class SceneGraph;
+class SceneGraphNode;
+} // namespace scenegraph
+
+namespace voxel {
+class RawVolume;
+}
+
+namespace voxedit {
+
+/**
+ * @brief Incremental autosaves - a full vengi file and a journal with the nodes that were modified since
+ *
+ * The memento states are used to collect the nodes that were changed. Changes that only affect single nodes (voxels,
+ * name, palette, properties or keyframes) are appended as small vengi scenes to the journal. Changes of the scene
+ * graph structure (adding, removing or moving nodes, animations) and a growing journal lead to a new full save that
+ * replaces the journal. The nodes are copied on the calling thread - the serialization happens on a worker thread.
+ * The volume copies are kept and reused for the following saves: only the volumes of the nodes that were modified
+ * since the last save are copied again, so a full save doesn't stall the calling thread with copying all volumes.
+ *
+ * Every full save gets a new generation id that is stored in the root node and in each journal entry. The full save
+ * is written to a temporary file that is renamed into place - if the application crashes before the old journal is
+ * removed, the stale entries are ignored because their generation doesn't match the new full save.
+ *
+ * @sa replay()
+ */
+class AutoSaveJournal : public memento::IMementoStateListener {
+private:
+	// the amount of journal entries before the next save is a full save again
+	static constexpr int MaxEntries = 32;
+
+	struct VolumeSnapshot {
+		// the volume of the scene node the copy was taken from
+		const voxel::RawVolume *source = nullptr;
+		core::SharedPtr<voxel::RawVolume> copy;
+	};
+	using VolumeSnapshots = core::DynamicMap<core::UUID, VolumeSnapshot, 11, core::UUIDHash>;
+	using Volumes = core::DynamicArray<core::SharedPtr<voxel::RawVolume>>;
+
+	core::DynamicSet<core::UUID, 11, core::UUIDHash> _dirtyNodes;
+	bool _structureChanged = true;
+	int _entries = 0;
+	// the file of the last full save
+	core::String _filename;
+	// the generation id of the last full save - stamped into every journal entry
+	core::UUID _generation;
+	// the volume copies of the last saves by node uuid
+	VolumeSnapshots _volumes;
+	core::Future<bool> _job;
+
+	void markDirty(const memento::MementoState &state);
+	/**
+	 * @brief Sets the volume of the node copy to the volume snapshot of the given node - the snapshot is only created
+	 * if the node was modified since the last save
+	 * @param[out] volumes The snapshots that are used by the copy - they must be kept alive while the copy is saved
+	 */
+	void snapshotVolume(const scenegraph::SceneGraphNode &node, scenegraph::SceneGraphNode &newNode,
+						VolumeSnapshots &snapshots, Volumes &volumes);
+	int copyNode_r(scenegraph::SceneGraph &target, const scenegraph::SceneGraph &source,
+				   const scenegraph::SceneGraphNode &node, int parent, core::Map<int, int> &nodeMapping,
+				   VolumeSnapshots &snapshots, Volumes &volumes);
+	/**
+	 * @brief Copies the scene graph with the same node uuids - the journal entries are applied by uuid
+	 */
+	bool copySceneGraphWithUUIDs(scenegraph::SceneGraph &target, const scenegraph::SceneGraph &source,
+								 Volumes &volumes);
+
+public:
+	void onMementoStateAdded(const memento::MementoState &state) override;
+	void onMementoStateSkipped(const memento::MementoState &state) override;
+
+	/**
+	 * @brief Forget about the collected changes - the next save will be a full save
+	 */
+	void reset();
+
+	/**
+	 * @brief Schedules the full save or the journal entry for the changes since the last call
+	 * @param[in] filename The absolute path of the vengi file - the journal is written next to it (see
+	 * @c journalFilename())
+	 * @return @c false if the previous save is still running or the scene graph could not be copied - nothing was
+	 * scheduled in this case
+	 */
+	bool save(const scenegraph::SceneGraph &sceneGraph, const core::String &filename);
+	/**
+	 * @brief Block until the scheduled save is done
+	 * @return @c false if the last save failed
+	 */
+	bool wait();
+	bool busy() const;
+
+	static core::String journalFilename(const core::String &filename);
+	/**
+	 * @return @c true if the given file was written as autosave - only those are able to have a journal
+	 */
+	static bool isAutoSave(const core::String &filename);
+	/**
+	 * @brief Applies the journal entries of the given (already loaded) vengi file to the scene graph
+	 * @note Entries that don't belong to the generation of the loaded full save are skipped
+	 * @return @c true if there was no journal or it was applied
+	 */
+	static bool replay(const core::String &filename, const io::ArchivePtr &archive, scenegraph::SceneGraph &sceneGraph);
+};
+
+} // namespace voxedit
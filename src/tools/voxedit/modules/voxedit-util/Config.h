@@ -59,5 +59,6 @@ constexpr const char *VoxEditNetRconPassword = "ve_netrconpassword";
 constexpr const char *VoxEditNetHostname = "ve_nethostname";
 constexpr const char *VoxEditNetServerInterface = "ve_netserverinterface";
 constexpr const char *VoxEditNetServerMaxConnections = "ve_netservermaxconnections";
+constexpr const char *VoxEditNetCoalesceMillis = "ve_netcoalescemillis";
 
 }
@@ -41,7 +41,6 @@
 #include "video/Camera.h"
 #include "voxedit-util/ModelNodeSettings.h"
 #include "voxedit-util/modifier/SceneModifiedFlags.h"
-#include "voxedit-util/network/protocol/SceneStateMessage.h"
 #include "voxel/Face.h"
 #include "voxel/MaterialColor.h"
 #include "voxel/RawVolume.h"
@@ -202,23 +201,24 @@ void SceneManager::autosave() {
 	if (delay <= 0 || _lastAutoSave + (double)delay > _timeProvider->tickSeconds()) {
 		return;
 	}
-	// autosaves go into the write path directory (which is usually the home directory of the user)
-	io::FileDescription autoSaveFilename;
+	// autosaves go into the write path directory (which is usually the home directory of the user) - they are
+	// always vengi files to be able to only append the modified nodes to the journal of the last full save
+	const core::String &ext = voxelformat::VENGIFormat::format().mainExtension();
+	core::String autoSaveFilename;
 	if (_lastFilename.empty()) {
-		autoSaveFilename.set(_filesystem->homeWritePath("autosave-noname." + voxelformat::VENGIFormat::format().mainExtension()));
+		autoSaveFilename = _filesystem->homeWritePath("autosave-noname." + ext);
 	} else {
 		const core::String &filename = core::string::extractFilename(_lastFilename.name);
 		const core::String &prefix = core::string::startsWith(filename, "autosave-") ? "" : "autosave-";
-		const core::String &ext = core::string::extractExtension(_lastFilename.name);
-		const core::String &autosaveFilename =
-			core::String::format("%s%s.%s", prefix.c_str(), filename.c_str(), ext.c_str());
-		autoSaveFilename.set(_filesystem->homeWritePath(autosaveFilename), &_lastFilename.desc);
+		autoSaveFilename = _filesystem->homeWritePath(
+			core::String::format("%s%s.%s", prefix.c_str(), filename.c_str(), ext.c_str()));
 	}
-	if (save(autoSaveFilename, true)) {
-		Log::info("Autosave file %s", autoSaveFilename.c_str());
-	} else {
-		Log::warn("Failed to autosave");
+	if (!_autoSaveJournal.save(_sceneGraph, autoSaveFilename)) {
+		// the previous autosave is still running - try again in the next frame
+		return;
 	}
+	Log::info("Autosave file %s", autoSaveFilename.c_str());
+	_needAutoSave = false;
 	_lastAutoSave = _timeProvider->tickSeconds();
 }
 
@@ -487,7 +487,10 @@ bool SceneManager::load(const io::FileDescription& file) {
 	_loadingFuture = app::async([archive, file] () {
 		scenegraph::SceneGraph newSceneGraph;
 		voxelformat::LoadContext loadCtx;
-		voxelformat::loadFormat(file, archive, newSceneGraph, loadCtx);
+		if (voxelformat::loadFormat(file, archive, newSceneGraph, loadCtx) && AutoSaveJournal::isAutoSave(file.name)) {
+			// restoring an incremental autosave - apply the changes of the journal
+			AutoSaveJournal::replay(file.name, archive, newSceneGraph);
+		}
 		mergeIfNeeded(newSceneGraph);
 		return core::move(newSceneGraph);
 	});
@@ -550,6 +553,7 @@ void SceneManager::modified(int nodeId, const voxel::Region& modifiedRegion, Sce
 		Log::debug("Modify region for nodeid %i", nodeId);
 		_sceneRenderer->updateNodeRegion(nodeId, modifiedRegion, renderRegionMillis);
 	}
+	updatePickingOccupancy(nodeId, modifiedRegion);
 	markDirty();
 	const bool resetTrace = (flags & SceneModifiedFlags::ResetTrace) == SceneModifiedFlags::ResetTrace;
 	if (resetTrace) {
@@ -1280,6 +1284,8 @@ void SceneManager::resetSceneState() {
 	_sceneGraph.setActiveNode(_sceneGraph.root().id());
 	nodeActivate(node.id());
 	_mementoHandler.clearStates();
+	_autoSaveJournal.reset();
+	resetPickingOccupancy();
 	Log::debug("New volume for node %i", node.id());
 	_mementoHandler.markInitialSceneState(_sceneGraph);
 	_dirty = false;
@@ -1289,8 +1295,7 @@ void SceneManager::resetSceneState() {
 	setReferencePosition(node.region().getCenter());
 	resetLastTrace();
 	if (server().isRunning()) {
-		SceneStateMessage msg(_sceneGraph);
-		server().network().broadcast(msg, 0);
+		server().broadcastSceneState(0);
 	}
 }
 
@@ -1372,6 +1377,7 @@ bool SceneManager::loadSceneGraph(scenegraph::SceneGraph&& sceneGraph, bool disc
 		return true;
 	}
 
+	resetPickingOccupancy();
 	_sceneGraph = core::move(sceneGraph);
 	_sceneRenderer->clear();
 
@@ -1391,6 +1397,26 @@ bool SceneManager::loadSceneGraph(scenegraph::SceneGraph&& sceneGraph, bool disc
 	return true;
 }
 
+void SceneManager::beginSceneStream(const core::UUID &rootUUID) {
+	resetPickingOccupancy();
+	_sceneGraph.clear();
+	_sceneGraph.setRootUUID(rootUUID);
+	_sceneRenderer->clear();
+	_mementoHandler.clearStates();
+	_autoSaveJournal.reset();
+	_result = voxelutil::PickResult();
+	_dirty = false;
+}
+
+void SceneManager::endSceneStream() {
+	_sceneGraph.updateTransforms();
+	if (_sceneGraph.empty()) {
+		Log::warn("Received scene state without any model node");
+		return;
+	}
+	resetSceneState();
+}
+
 bool SceneManager::splitVolumes() {
 	scenegraph::SceneGraph newSceneGraph;
 	if (scenegraph::splitVolumes(_sceneGraph, newSceneGraph, false, false)) {
@@ -1483,6 +1509,7 @@ bool SceneManager::setSceneGraphNodeVolume(scenegraph::SceneGraphNode &node, vox
 		return true;
 	}
 
+	resetPickingOccupancy(node.id());
 	node.setVolume(volume, true);
 	// the old volume pointer might no longer be used
 	_sceneRenderer->removeNode(node.id());
@@ -1499,6 +1526,7 @@ bool SceneManager::setSceneGraphNodeVolume(scenegraph::SceneGraphNode &node, vox
 }
 
 bool SceneManager::newScene(bool force, const core::String &name, voxel::RawVolume *v) {
+	resetPickingOccupancy();
 	_sceneGraph.clear();
 	_sceneRenderer->clear();
 
@@ -2617,6 +2645,7 @@ bool SceneManager::init() {
 		Log::error("Failed to initialize the memento handler");
 		return false;
 	}
+	_mementoHandler.registerListener(&_autoSaveJournal);
 	if (!_sceneRenderer->init()) {
 		Log::error("Failed to initialize the scene renderer");
 		return false;
@@ -2774,6 +2803,8 @@ bool SceneManager::update(double nowSeconds) {
 		}
 		if (_sceneGraph.dirty()) {
 			markDirty();
+			// the script might have replaced volumes
+			resetPickingOccupancy();
 			_sceneRenderer->clear();
 			_sceneGraph.markClean();
 		}
@@ -2836,7 +2867,9 @@ void SceneManager::shutdown() {
 		return;
 	}
 
+	_autoSaveJournal.wait();
 	autosave();
+	_autoSaveJournal.wait();
 
 	_luaApi.shutdown();
 
@@ -2845,11 +2878,13 @@ void SceneManager::shutdown() {
 		Log::error("Lua api listener still registered");
 		_sceneGraph.unregisterListener(&_luaApiListener);
 	}
+	resetPickingOccupancy();
 	_sceneGraph.clear();
 
 	_camMovement.shutdown();
 	_modifierFacade.shutdown();
 	_mementoHandler.unregisterListener(&_client);
+	_mementoHandler.unregisterListener(&_autoSaveJournal);
 	_mementoHandler.shutdown();
 	_server.shutdown();
 	_client.shutdown();
@@ -2894,18 +2929,23 @@ void SceneManager::stepLSystem() {
 		return;
 	}
 	voxel::RawVolumeWrapper wrapper = _modifierFacade.createRawVolumeWrapper(v);
-	if (!voxelgenerator::lsystem::step(wrapper, _lsystemVoxel, _lsystemState, _lsystemExecState)) {
-		_lsystemRunning = false;
-		_mementoHandler.endGroup();
+	// execute several commands per frame - the sentence might expand to millions of commands
+	const int maxSteps = 64;
+	for (int i = 0; i < maxSteps; ++i) {
+		if (!voxelgenerator::lsystem::step(wrapper, _lsystemVoxel, _lsystemState, _lsystemExecState)) {
+			_lsystemRunning = false;
+			_mementoHandler.endGroup();
+			break;
+		}
 	}
 	modified(_lsystemNodeId, wrapper.dirtyRegion());
 }
 
 float SceneManager::lsystemProgress() const {
-	if (!_lsystemRunning || _lsystemState.sentence.empty()) {
+	if (!_lsystemRunning || _lsystemState.commands == 0u) {
 		return 0.0f;
 	}
-	return (float)_lsystemExecState.index / (float)_lsystemState.sentence.size();
+	return (float)((double)_lsystemExecState.commands / (double)_lsystemState.commands);
 }
 
 void SceneManager::setReferencePosition(const glm::ivec3& pos) {
@@ -3059,6 +3099,94 @@ void SceneManager::updateCursor() {
 	}
 }
 
+void SceneManager::resetPickingOccupancy() {
+	_pickingOccupancies.clear();
+}
+
+void SceneManager::resetPickingOccupancy(int nodeId) {
+	if (_pickingOccupancies.empty()) {
+		return;
+	}
+	// reference nodes share the volume of the model node - their pyramids are invalid, too
+	const scenegraph::SceneGraphNode *node = sceneGraphNode(nodeId);
+	const voxel::RawVolume *v = node != nullptr ? _sceneGraph.resolveVolume(*node) : nullptr;
+	core::DynamicArray<int> invalid;
+	for (auto iter = _pickingOccupancies.begin(); iter != _pickingOccupancies.end(); ++iter) {
+		if (iter->key == nodeId || (v != nullptr && iter->value->volume == v)) {
+			invalid.push_back(iter->key);
+		}
+	}
+	for (int id : invalid) {
+		_pickingOccupancies.remove(id);
+	}
+}
+
+void SceneManager::updatePickingOccupancy(int nodeId, const voxel::Region &modifiedRegion) {
+	if (_pickingOccupancies.empty()) {
+		return;
+	}
+	const scenegraph::SceneGraphNode *node = sceneGraphNode(nodeId);
+	const voxel::RawVolume *v = node != nullptr ? _sceneGraph.resolveVolume(*node) : nullptr;
+	core::DynamicArray<int> invalid;
+	for (auto iter = _pickingOccupancies.begin(); iter != _pickingOccupancies.end(); ++iter) {
+		PickingOccupancy &entry = *iter->value.get();
+		const bool sameVolume = v != nullptr && entry.volume == v;
+		if (iter->key != nodeId && !sameVolume) {
+			continue;
+		}
+		if (!sameVolume || !modifiedRegion.isValid() || v->region() != entry.region) {
+			invalid.push_back(iter->key);
+		} else if (entry.pyramid) {
+			entry.pyramid->update(*v, modifiedRegion);
+		} else if (entry.dirtyRegion.isValid()) {
+			entry.dirtyRegion.accumulate(modifiedRegion);
+		} else {
+			entry.dirtyRegion = modifiedRegion;
+		}
+	}
+	for (int id : invalid) {
+		_pickingOccupancies.remove(id);
+	}
+}
+
+const voxelutil::OccupancyPyramid *SceneManager::pickingOccupancy(int nodeId, const voxel::RawVolume *volume) {
+	if (volume->region().voxels() < PickingOccupancyMinVoxels) {
+		return nullptr;
+	}
+	core::SharedPtr<PickingOccupancy> entry;
+	if (_pickingOccupancies.get(nodeId, entry) && (entry->volume != volume || entry->region != volume->region())) {
+		entry = nullptr;
+	}
+	if (!entry) {
+		entry = core::make_shared<PickingOccupancy>();
+		entry->volume = volume;
+		entry->region = volume->region();
+		// the volume might get modified or replaced while the pyramid is built - modifications are recorded in the
+		// dirty region and applied once the build is done
+		const core::SharedPtr<voxel::RawVolume> snapshot = core::make_shared<voxel::RawVolume>(*volume);
+		entry->building = app::async([snapshot]() {
+			core_trace_scoped(BuildPickingOccupancy);
+			core::SharedPtr<voxelutil::OccupancyPyramid> pyramid = core::make_shared<voxelutil::OccupancyPyramid>();
+			pyramid->build(*snapshot.get());
+			return pyramid;
+		});
+		_pickingOccupancies.put(nodeId, entry);
+		return nullptr;
+	}
+	if (!entry->pyramid) {
+		if (!entry->building.ready()) {
+			return nullptr;
+		}
+		entry->pyramid = entry->building.get();
+		entry->building = {};
+		if (entry->dirtyRegion.isValid()) {
+			entry->pyramid->update(*volume, entry->dirtyRegion);
+			entry->dirtyRegion = voxel::Region::InvalidRegion;
+		}
+	}
+	return entry->pyramid.get();
+}
+
 bool SceneManager::mouseRayTrace(bool force, const glm::mat4 &invModel) {
 	// mouse tracing is disabled - e.g. because the voxel cursor was moved by keyboard
 	// shortcuts. In this case the execution of the modifier would result in a
@@ -3105,8 +3233,11 @@ bool SceneManager::mouseRayTrace(bool force, const glm::mat4 &invModel) {
 	const math::Axis lockedAxis = _modifierFacade.lockedAxis();
 	// TODO: we could optionally limit the raycast to the selection
 
+	// the locked axis plane checks need to see every voxel on the ray
+	const voxelutil::OccupancyPyramid *occupancy = lockedAxis == math::Axis::None ? pickingOccupancy(nodeId, v) : nullptr;
+
 	const float offset = voxelutil::RaycastOffset;
-	voxelutil::raycastWithEndpoints(v, ray.origin - offset, ray.origin + dirWithLength - offset, [&] (voxel::RawVolume::Sampler& sampler) {
+	voxelutil::raycastWithEndpoints(v, occupancy, ray.origin - offset, ray.origin + dirWithLength - offset, [&] (voxel::RawVolume::Sampler& sampler) {
 		if (!_result.firstValidPosition && sampler.currentPositionValid()) {
 			_result.firstPosition = sampler.position();
 			_result.firstValidPosition = true;
@@ -3649,6 +3780,7 @@ bool SceneManager::nodeRemove(scenegraph::SceneGraphNode &node, bool recursive)
 		}
 	}
 	_mementoHandler.markNodeRemove(_sceneGraph, node);
+	resetPickingOccupancy(nodeId);
 	if (!_sceneGraph.removeNode(nodeId, false)) {
 		Log::error("Failed to remove node with id %i", nodeId);
 		return false;
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "AutoSaveJournal.h"
 #include "Clipboard.h"
 #include "ISceneRenderer.h"
 #include "LUAApiListener.h"
@@ -12,7 +13,9 @@
 #include "core/Enum.h"
 #include "core/TimeProvider.h"
 #include "core/Var.h"
+#include "core/SharedPtr.h"
 #include "core/collection/DynamicArray.h"
+#include "core/collection/DynamicMap.h"
 #include "core/concurrent/Future.h"
 #include "io/Filesystem.h"
 #include "io/FormatDescription.h"
@@ -33,6 +36,7 @@
 #include "voxelgenerator/LUAApi.h"
 #include "voxelrender/CameraMovement.h"
 #include "voxelrender/RawVolumeRenderer.h"
+#include "voxelutil/OccupancyPyramid.h"
 #include "voxelutil/Picking.h"
 #include <functional>
 
@@ -108,6 +112,7 @@ protected:
 
 	io::FileDescription _lastFilename;
 	double _lastAutoSave = 0u;
+	AutoSaveJournal _autoSaveJournal;
 
 	int _lastRaytraceX = -1;
 	int _lastRaytraceY = -1;
@@ -138,6 +143,30 @@ protected:
 
 	voxelutil::PickResult _result;
 
+	// empty space skipping for mouse picking in large volumes - built in the background for each picked node and
+	// updated in modified()
+	static constexpr int PickingOccupancyMinVoxels = 128 * 128 * 128;
+	struct PickingOccupancy {
+		const voxel::RawVolume *volume = nullptr;
+		voxel::Region region;
+		core::SharedPtr<voxelutil::OccupancyPyramid> pyramid;
+		core::Future<core::SharedPtr<voxelutil::OccupancyPyramid>> building;
+		// the voxels that were modified while the pyramid was built from the snapshot
+		voxel::Region dirtyRegion = voxel::Region::InvalidRegion;
+	};
+	core::DynamicMap<int, core::SharedPtr<PickingOccupancy>, 11> _pickingOccupancies;
+	/**
+	 * @return The occupancy pyramid for the given volume or @c nullptr if the volume is too small to benefit from it
+	 * or the pyramid is still being built
+	 */
+	const voxelutil::OccupancyPyramid *pickingOccupancy(int nodeId, const voxel::RawVolume *volume);
+	void updatePickingOccupancy(int nodeId, const voxel::Region &modifiedRegion);
+	/**
+	 * @brief Drops the occupancy pyramid of the given node - call this if the volume of the node was replaced
+	 */
+	void resetPickingOccupancy(int nodeId);
+	void resetPickingOccupancy();
+
 	/**
 	 * @note This might return @c nullptr in the case where the active node is no model node
 	 */
@@ -367,6 +396,18 @@ public:
 	bool load(const io::FileDescription &file, const uint8_t *data, size_t size);
 	bool isLoading() const;
 	bool loadSceneGraph(scenegraph::SceneGraph &&sceneGraph, bool disconnect = true);
+	/**
+	 * @brief Clears the scene for a scene state that is streamed node by node from the server
+	 * @param[in] rootUUID The uuid of the root node on the server side - needed to resolve the parents of the
+	 * nodes that are added later on
+	 * @sa endSceneStream()
+	 */
+	void beginSceneStream(const core::UUID &rootUUID);
+	/**
+	 * @brief All nodes of the streamed scene state were received
+	 * @sa beginSceneStream()
+	 */
+	void endSceneStream();
 
 	bool undo(int n = 1);
 	bool redo(int n = 1);
@@ -52,15 +52,8 @@ void TextBrush::generate(scenegraph::SceneGraph &sceneGraph, ModifierVolumeWrapp
 		Log::error("Failed to initialize voxel font with %s", _font.c_str());
 		return;
 	}
-	const char *t = _input.c_str();
-	const char **s = &t;
-	glm::ivec3 pos = region.getLowerCorner();
-	const int widthIndex = math::getIndexForAxis(_axis);
-
-	for (int c = core::unicode::next(s); c != -1; c = core::unicode::next(s)) {
-		pos[widthIndex] += _voxelFont.renderCharacter(c, _size, _thickness, pos, wrapper, ctx.cursorVoxel, _axis);
-		pos[widthIndex] += _spacing;
-	}
+	_voxelFont.renderString(_input.c_str(), _size, _thickness, _spacing, region.getLowerCorner(), wrapper,
+							ctx.cursorVoxel, _axis);
 }
 
 void TextBrush::setSize(int size) {
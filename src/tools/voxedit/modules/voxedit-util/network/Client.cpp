@@ -14,6 +14,8 @@
 #include "protocol/NodeRenamedMessage.h"
 #include "protocol/SceneStateMessage.h"
 #include "protocol/VoxelModificationMessage.h"
+#include "app/I18N.h"
+#include "voxedit-util/Config.h"
 #include "voxedit-util/SceneManager.h"
 #include "protocol/NodeNormalPaletteChangedMessage.h"
 #include "protocol/SceneGraphAnimationMessage.h"
@@ -26,6 +28,8 @@ Client::~Client() {
 
 void Client::construct() {
 	_network.construct();
+	_coalesceMillis = core::Var::get(cfg::VoxEditNetCoalesceMillis, "50",
+									 _("Merge voxel modifications of the same node within this time window before sending them"));
 }
 
 bool Client::init() {
@@ -45,10 +49,18 @@ bool Client::isConnected() const {
 }
 
 void Client::disconnect() {
+	_pendingModification = PendingModification();
 	_network.disconnect();
 }
 
 void Client::update(double nowSeconds) {
+	_nowSeconds = nowSeconds;
+	if (_pendingModification.region.isValid()) {
+		const double windowSeconds = (double)_coalesceMillis->intVal() / 1000.0;
+		if (nowSeconds - _pendingModification.startSeconds >= windowSeconds) {
+			flushPendingModification();
+		}
+	}
 	_network.update(nowSeconds);
 }
 
@@ -68,16 +80,64 @@ void Client::onMementoStateSkipped(const memento::MementoState &state) {
 	onMementoStateAdded(state);
 }
 
+// the int voxel count of the region overflows for large regions
+static uint64_t regionVoxels(const voxel::Region &region) {
+	return (uint64_t)region.getWidthInVoxels() * (uint64_t)region.getHeightInVoxels() *
+		   (uint64_t)region.getDepthInVoxels();
+}
+
+void Client::flushPendingModification() {
+	if (!_pendingModification.region.isValid()) {
+		return;
+	}
+	const PendingModification pending = _pendingModification;
+	_pendingModification = PendingModification();
+	scenegraph::SceneGraphNode *node = _sceneMgr->sceneGraph().findNodeByUUID(pending.nodeUUID);
+	if (node == nullptr || node->volume() == nullptr) {
+		Log::debug("Node %s is gone - drop the pending voxel modification", pending.nodeUUID.str().c_str());
+		return;
+	}
+	// send the current state of the accumulated region - this includes all merged modifications
+	VoxelModificationMessage msg(pending.nodeUUID, *node->volume(), pending.region);
+	_network.sendMessage(msg);
+}
+
+void Client::addPendingModification(const memento::MementoState &state) {
+	const voxel::Region &region = state.dataRegion();
+	if (_pendingModification.region.isValid()) {
+		if (_pendingModification.nodeUUID == state.nodeUUID) {
+			voxel::Region merged = _pendingModification.region;
+			merged.accumulate(region);
+			// don't merge far away modifications - the bounding box would transfer a lot of unmodified voxels
+			const uint64_t separateVoxels = regionVoxels(_pendingModification.region) + regionVoxels(region);
+			if (regionVoxels(merged) <= 2u * separateVoxels) {
+				_pendingModification.region = merged;
+				return;
+			}
+		}
+		flushPendingModification();
+	}
+	_pendingModification.nodeUUID = state.nodeUUID;
+	_pendingModification.region = region;
+	_pendingModification.startSeconds = _nowSeconds;
+	if (_coalesceMillis->intVal() <= 0) {
+		flushPendingModification();
+	}
+}
+
 void Client::onMementoStateAdded(const memento::MementoState &state) {
 	if (_locked || !isConnected()) {
 		return;
 	}
+	if (state.type == memento::MementoType::Modification) {
+		addPendingModification(state);
+		return;
+	}
+	// keep the order of the messages
+	flushPendingModification();
 	switch (state.type) {
-	case memento::MementoType::Modification: {
-		VoxelModificationMessage msg(state);
-		_network.sendMessage(msg);
+	case memento::MementoType::Modification:
 		break;
-	}
 	case memento::MementoType::SceneNodeMove: {
 		NodeMovedMessage msg(state);
 		_network.sendMessage(msg);
@@ -133,6 +193,7 @@ void Client::executeCommand(const core::String &command) {
 		return;
 	}
 	const core::String rconPassword = core::Var::getSafe(cfg::VoxEditNetRconPassword)->strVal();
+	flushPendingModification();
 	CommandMessage msg(command, rconPassword);
 	Log::info("Send command to server: %s", command.c_str());
 	_network.sendMessage(msg);
@@ -142,6 +203,7 @@ void Client::sendSceneState() {
 	if (!isConnected()) {
 		return;
 	}
+	_pendingModification = PendingModification();
 	SceneStateMessage msg(_sceneMgr->sceneGraph());
 	Log::info("Send scene state to server (%i bytes)", (int)msg.size());
 	_network.sendMessage(msg);
@@ -6,7 +6,10 @@
 
 #include "ClientNetwork.h"
 #include "core/IComponent.h"
+#include "core/UUID.h"
+#include "core/Var.h"
 #include "memento/IMementoStateListener.h"
+#include "voxel/Region.h"
 
 namespace voxedit {
 
@@ -18,6 +21,24 @@ protected:
 	SceneManager *_sceneMgr = nullptr;
 	ClientNetwork _network;
 	bool _locked = false;
+	double _nowSeconds = 0.0;
+	core::VarPtr _coalesceMillis;
+
+	/**
+	 * @brief Consecutive voxel modifications of the same node that are merged into one message
+	 *
+	 * Rapid brush strokes would otherwise produce one message per stroke. The modifications are collected
+	 * for @c cfg::VoxEditNetCoalesceMillis and the current voxels of the accumulated region are sent.
+	 */
+	struct PendingModification {
+		core::UUID nodeUUID;
+		voxel::Region region = voxel::Region::InvalidRegion;
+		double startSeconds = 0.0;
+	};
+	PendingModification _pendingModification;
+
+	void addPendingModification(const memento::MementoState &state);
+	void flushPendingModification();
 
 public:
 	Client(SceneManager *sceneMgr) : _sceneMgr(sceneMgr), _network(sceneMgr) {
@@ -21,7 +21,7 @@ ClientNetwork::ClientNetwork(SceneManager *sceneMgr)
 	  _nodeKeyFramesHandle(sceneMgr), _nodeMovedHandler(sceneMgr), _nodePaletteChangedHandle(sceneMgr),
 	  _nodeNormalPaletteChangedHandle(sceneMgr), _nodePropertiesHandler(sceneMgr), _nodeRemovedHandler(sceneMgr),
 	  _nodeRenamedHandler(sceneMgr), _sceneStateRequestHandler(sceneMgr), _sceneStateHandler(sceneMgr),
-	  _sceneGraphAnimationHandler(sceneMgr) {
+	  _sceneStateBeginHandler(sceneMgr), _sceneStateEndHandler(sceneMgr), _sceneGraphAnimationHandler(sceneMgr) {
 }
 
 ClientNetwork::~ClientNetwork() {
@@ -111,6 +111,8 @@ bool ClientNetwork::init() {
 	r.registerHandler(PROTO_COMMAND, &_nopHandler); // never execute commands on the client side
 	r.registerHandler(PROTO_SCENE_STATE_REQUEST, &_sceneStateRequestHandler);
 	r.registerHandler(PROTO_SCENE_STATE, &_sceneStateHandler);
+	r.registerHandler(PROTO_SCENE_STATE_BEGIN, &_sceneStateBeginHandler);
+	r.registerHandler(PROTO_SCENE_STATE_END, &_sceneStateEndHandler);
 	r.registerHandler(PROTO_VOXEL_MODIFICATION, &_voxelModificationHandler);
 	r.registerHandler(PROTO_NODE_ADDED, &_nodeAddedHandler);
 	r.registerHandler(PROTO_NODE_REMOVED, &_nodeRemovedHandler);
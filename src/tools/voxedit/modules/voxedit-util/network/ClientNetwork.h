@@ -15,6 +15,8 @@
 #include "voxedit-util/network/handler/client/NodePropertiesHandler.h"
 #include "voxedit-util/network/handler/client/NodeRemovedHandler.h"
 #include "voxedit-util/network/handler/client/NodeRenamedHandler.h"
+#include "voxedit-util/network/handler/client/SceneStateBeginHandler.h"
+#include "voxedit-util/network/handler/client/SceneStateEndHandler.h"
 #include "voxedit-util/network/handler/client/SceneStateHandlerClient.h"
 #include "voxedit-util/network/handler/client/SceneStateRequestHandler.h"
 #include "voxedit-util/network/handler/client/VoxelModificationHandler.h"
@@ -43,6 +45,8 @@ protected:
 	NodeRenamedHandler _nodeRenamedHandler;
 	SceneStateRequestHandler _sceneStateRequestHandler;
 	SceneStateHandlerClient _sceneStateHandler;
+	SceneStateBeginHandler _sceneStateBeginHandler;
+	SceneStateEndHandler _sceneStateEndHandler;
 	SceneGraphAnimationHandler _sceneGraphAnimationHandler;
 	network::MessageStream in;
 
@@ -11,7 +11,9 @@ namespace voxedit {
 const network::ProtocolId PROTO_PING = 0;
 // request the initial scene state from the first client that connects
 const network::ProtocolId PROTO_SCENE_STATE_REQUEST = 1;
-// the complete scene state - the answer to the scene state request
+// the complete scene state - the answer to the scene state request. This is sent by the client to the server,
+// the server streams the scene state with PROTO_SCENE_STATE_BEGIN, PROTO_NODE_ADDED, PROTO_VOXEL_MODIFICATION and
+// PROTO_SCENE_STATE_END to the clients
 const network::ProtocolId PROTO_SCENE_STATE = 2;
 // voxel modification message with compressed voxel data that is broadcasted to all clients
 const network::ProtocolId PROTO_VOXEL_MODIFICATION = 3;
@@ -37,5 +39,9 @@ const network::ProtocolId PROTO_COMMAND = 12;
 const network::ProtocolId PROTO_NODE_NORMAL_PALETTE_CHANGED = 13;
 // scene graph animation list changed
 const network::ProtocolId PROTO_SCENE_GRAPH_ANIMATION = 14;
+// start of a streamed scene state - the client clears its scene graph
+const network::ProtocolId PROTO_SCENE_STATE_BEGIN = 15;
+// all nodes of a streamed scene state were sent
+const network::ProtocolId PROTO_SCENE_STATE_END = 16;
 
 } // namespace voxedit
@@ -14,6 +14,8 @@
 #include "protocol/NodeNormalPaletteChangedMessage.h"
 #include "protocol/SceneGraphAnimationMessage.h"
 #include "protocol/PingMessage.h"
+#include "protocol/SceneStateBeginMessage.h"
+#include "protocol/SceneStateEndMessage.h"
 #include "protocol/SceneStateMessage.h"
 #include "protocol/SceneStateRequestMessage.h"
 #include "protocol/VoxelModificationMessage.h"
@@ -102,6 +104,12 @@ network::ProtocolMessage *ProtocolMessageFactory::create(network::MessageStream
 	case PROTO_SCENE_GRAPH_ANIMATION:
 		msg = new SceneGraphAnimationMessage(in);
 		break;
+	case PROTO_SCENE_STATE_BEGIN:
+		msg = new SceneStateBeginMessage(in);
+		break;
+	case PROTO_SCENE_STATE_END:
+		msg = new SceneStateEndMessage();
+		break;
 	default:
 		Log::error("Unknown protocol message type: %u with size %u", type, size);
 		break;
@@ -0,0 +1,149 @@
+/**
+ * @file
+ */
+
+#include "SceneStateStream.h"
+#include "core/Log.h"
+#include "protocol/NodeAddedMessage.h"
+#include "protocol/SceneStateBeginMessage.h"
+#include "protocol/SceneStateEndMessage.h"
+#include "protocol/VoxelModificationMessage.h"
+#include "scenegraph/SceneGraph.h"
+#include "voxelutil/VoxelUtil.h"
+
+namespace voxedit {
+
+SceneStateStream::SceneStateStream(ConnectionId connection, double startSeconds, int brickSize)
+	: _connection(connection), _brickSize(brickSize), _startSeconds(startSeconds) {
+	core_assert(_brickSize > 0);
+}
+
+void SceneStateStream::collectNodes(const scenegraph::SceneGraph &sceneGraph, int nodeId,
+									core::DynamicArray<int> &deferredReferences) {
+	for (int childId : sceneGraph.node(nodeId).children()) {
+		if (!sceneGraph.hasNode(childId)) {
+			continue;
+		}
+		const scenegraph::SceneGraphNode &child = sceneGraph.node(childId);
+		// the referenced model node must be known on the client side before the reference node arrives
+		if (child.type() == scenegraph::SceneGraphNodeType::ModelReference) {
+			deferredReferences.push_back(childId);
+			continue;
+		}
+		if (!_sent.has(child.uuid())) {
+			_nodes.push_back(child.uuid());
+		}
+		collectNodes(sceneGraph, childId, deferredReferences);
+	}
+}
+
+void SceneStateStream::collectNodes(const scenegraph::SceneGraph &sceneGraph) {
+	_nodes.clear();
+	_nodeIndex = 0u;
+	core::DynamicArray<int> deferredReferences;
+	collectNodes(sceneGraph, sceneGraph.root().id(), deferredReferences);
+	for (size_t i = 0; i < deferredReferences.size(); ++i) {
+		const int nodeId = deferredReferences[i];
+		const scenegraph::SceneGraphNode &node = sceneGraph.node(nodeId);
+		if (!_sent.has(node.uuid())) {
+			_nodes.push_back(node.uuid());
+		}
+		// might append further references
+		collectNodes(sceneGraph, nodeId, deferredReferences);
+	}
+}
+
+network::ProtocolMessage *SceneStateStream::nextBrick(scenegraph::SceneGraph &sceneGraph) {
+	const scenegraph::SceneGraphNode *node = sceneGraph.findNodeByUUID(_brickNodeUUID);
+	if (node == nullptr || node->volume() == nullptr) {
+		// the node was removed in the meantime
+		_brickVolumeRegion = voxel::Region::InvalidRegion;
+		return nullptr;
+	}
+	const voxel::RawVolume &volume = *node->volume();
+	const glm::ivec3 &mins = _brickVolumeRegion.getLowerCorner();
+	const glm::ivec3 &maxs = _brickVolumeRegion.getUpperCorner();
+	while (_brickPos.z <= maxs.z) {
+		const glm::ivec3 brickMins = _brickPos;
+		const glm::ivec3 brickMaxs = glm::min(brickMins + (_brickSize - 1), maxs);
+		_brickPos.x += _brickSize;
+		if (_brickPos.x > maxs.x) {
+			_brickPos.x = mins.x;
+			_brickPos.y += _brickSize;
+			if (_brickPos.y > maxs.y) {
+				_brickPos.y = mins.y;
+				_brickPos.z += _brickSize;
+			}
+		}
+		// the volume might have been resized in the meantime
+		voxel::Region brickRegion(brickMins, brickMaxs);
+		brickRegion.cropTo(volume.region());
+		if (!brickRegion.isValid()) {
+			continue;
+		}
+		// the client created an empty volume already
+		if (voxelutil::isEmpty(volume, brickRegion)) {
+			continue;
+		}
+		return new VoxelModificationMessage(_brickNodeUUID, volume, brickRegion);
+	}
+	_brickVolumeRegion = voxel::Region::InvalidRegion;
+	return nullptr;
+}
+
+network::ProtocolMessage *SceneStateStream::next(scenegraph::SceneGraph &sceneGraph) {
+	if (_done) {
+		return nullptr;
+	}
+	if (!_started) {
+		_started = true;
+		_rootUUID = sceneGraph.root().uuid();
+		collectNodes(sceneGraph);
+		return new SceneStateBeginMessage(sceneGraph, (uint32_t)_nodes.size());
+	}
+	for (;;) {
+		if (_brickVolumeRegion.isValid()) {
+			if (network::ProtocolMessage *msg = nextBrick(sceneGraph)) {
+				return msg;
+			}
+		}
+		if (_nodeIndex >= _nodes.size()) {
+			// pick up the nodes that were added while the stream was running
+			collectNodes(sceneGraph);
+			if (_nodes.empty()) {
+				_done = true;
+				return new SceneStateEndMessage();
+			}
+		}
+		const core::UUID uuid = _nodes[_nodeIndex++];
+		if (_sent.has(uuid)) {
+			continue;
+		}
+		const scenegraph::SceneGraphNode *node = sceneGraph.findNodeByUUID(uuid);
+		if (node == nullptr) {
+			Log::debug("Node %s was removed while streaming the scene state", uuid.str().c_str());
+			continue;
+		}
+		_sent.insert(uuid);
+		const int brickVoxels = _brickSize * _brickSize * _brickSize;
+		if (node->isModelNode() && node->volume() != nullptr && node->region().voxels() > brickVoxels) {
+			_brickNodeUUID = uuid;
+			_brickVolumeRegion = node->region();
+			_brickPos = _brickVolumeRegion.getLowerCorner();
+			return new NodeAddedMessage(sceneGraph, *node, false);
+		}
+		return new NodeAddedMessage(sceneGraph, *node, true);
+	}
+}
+
+void SceneStateStream::nodeBroadcasted(const core::UUID &nodeUUID, const core::UUID &parentUUID) {
+	// the begin message resets the scene graph of the client
+	if (!_started || _done) {
+		return;
+	}
+	if (parentUUID == _rootUUID || _sent.has(parentUUID)) {
+		_sent.insert(nodeUUID);
+	}
+}
+
+} // namespace voxedit
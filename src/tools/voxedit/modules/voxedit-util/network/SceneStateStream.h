@@ -0,0 +1,98 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/NonCopyable.h"
+#include "core/UUID.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/DynamicSet.h"
+#include "network/ProtocolMessage.h"
+#include "voxedit-util/network/ServerNetworkIO.h"
+#include "voxel/Region.h"
+#include <glm/vec3.hpp>
+
+namespace scenegraph {
+class SceneGraph;
+}
+
+namespace voxedit {
+
+/**
+ * @brief Produces the messages to transfer the scene state to a client one by one
+ *
+ * The stream starts with a @c SceneStateBeginMessage, followed by a @c NodeAddedMessage for each node (parents are
+ * sent before their children) and ends with a @c SceneStateEndMessage. Model nodes with volumes that are larger than
+ * one brick are sent without voxels and followed by @c VoxelModificationMessage bricks.
+ *
+ * The nodes are looked up in the scene graph when the message is created - this means that the stream always
+ * transfers the current state, even if the scene is modified while the stream is running. Modifications of nodes
+ * that were already sent are broadcasted to the client anyway. Nodes that were added while the stream was running
+ * are sent before the end message - unless the client already received them by a broadcast (see
+ * @c nodeBroadcasted()).
+ */
+class SceneStateStream : public core::NonCopyable {
+public:
+	static constexpr int DefaultBrickSize = 32;
+
+private:
+	ConnectionId _connection;
+	const int _brickSize;
+	const double _startSeconds;
+	core::DynamicArray<core::UUID> _nodes;
+	size_t _nodeIndex = 0u;
+	core::DynamicSet<core::UUID, 1031, core::UUIDHash> _sent;
+	// the root node is part of the begin message
+	core::UUID _rootUUID;
+
+	// the node that is currently transferred in bricks
+	core::UUID _brickNodeUUID;
+	voxel::Region _brickVolumeRegion = voxel::Region::InvalidRegion;
+	glm::ivec3 _brickPos{0};
+
+	bool _started = false;
+	bool _done = false;
+
+	void collectNodes(const scenegraph::SceneGraph &sceneGraph, int nodeId,
+					  core::DynamicArray<int> &deferredReferences);
+	/**
+	 * @brief Collects all nodes that were not yet sent - parents before children
+	 */
+	void collectNodes(const scenegraph::SceneGraph &sceneGraph);
+	network::ProtocolMessage *nextBrick(scenegraph::SceneGraph &sceneGraph);
+
+public:
+	SceneStateStream(ConnectionId connection, double startSeconds, int brickSize = DefaultBrickSize);
+
+	/**
+	 * @return The next message to send or @c nullptr if the stream is done. The caller takes ownership.
+	 */
+	network::ProtocolMessage *next(scenegraph::SceneGraph &sceneGraph);
+
+	/**
+	 * @brief Called for node added messages that are broadcasted to the client while the stream is running
+	 *
+	 * The client only adds the node if it already knows the parent - in that case the node is not sent again by the
+	 * stream. Otherwise the client drops the message and the stream sends the node after its parent.
+	 */
+	void nodeBroadcasted(const core::UUID &nodeUUID, const core::UUID &parentUUID);
+
+	bool done() const {
+		return _done;
+	}
+	ConnectionId connection() const {
+		return _connection;
+	}
+	double startSeconds() const {
+		return _startSeconds;
+	}
+	/**
+	 * @return The amount of nodes that were sent so far
+	 */
+	size_t sentNodes() const {
+		return _sent.size();
+	}
+};
+
+} // namespace voxedit
@@ -5,11 +5,15 @@
 #include "Server.h"
 #include "ProtocolVersion.h"
 #include "core/Log.h"
-#include "protocol/SceneStateMessage.h"
+#include "core/ScopedPtr.h"
 #include "protocol/SceneStateRequestMessage.h"
 
 namespace voxedit {
 
+// the amount of scene state bytes that may be queued for a client before the next message is created. This
+// keeps the server responsive for the edits of the other clients while a large scene is transferred.
+static constexpr uint32_t SceneStateWindowBytes = 256u * 1024u;
+
 Server::Server() : _network(this) {
 	_network.addListener(this);
 }
@@ -42,7 +46,8 @@ bool Server::shouldSendClientState(bool localServer) const {
 bool Server::initSession(const network::ClientId &clientId, uint32_t protocolVersion, const core::String &applicationVersion,
 						 const core::String &username, const core::String &password, bool localServer) {
 	if (protocolVersion != PROTOCOL_VERSION) {
-		Log::error("Client %u has incompatible protocol version %u (expected 1)", clientId, protocolVersion);
+		Log::error("Client %u has incompatible protocol version %u (expected %u)", clientId, protocolVersion,
+				   (uint32_t)PROTOCOL_VERSION);
 		return false;
 	}
 
@@ -71,8 +76,7 @@ bool Server::initSession(const network::ClientId &clientId, uint32_t protocolVer
 		}
 	} else if (shouldSendClientState(localServer)) {
 		Log::info("Sending scene state to client %u", clientId);
-		SceneStateMessage msg(*_sceneGraph);
-		if (!_network.sendToClient(clientId, msg)) {
+		if (!startSceneStateStream(clientId)) {
 			Log::error("Failed to send scene state to client %u", clientId);
 			return false;
 		}
@@ -83,6 +87,75 @@ bool Server::initSession(const network::ClientId &clientId, uint32_t protocolVer
 	return true;
 }
 
+bool Server::startSceneStateStream(const network::ClientId &clientId) {
+	if (_sceneGraph == nullptr) {
+		return false;
+	}
+	RemoteClient *client = _network.client(clientId);
+	if (client == nullptr) {
+		Log::error("Client %u not found", clientId);
+		return false;
+	}
+	// a running transfer is restarted - the begin message resets the scene on the client side
+	removeSceneStateStream(client->connection);
+	_sceneStateStreams.push_back(new SceneStateStream(client->connection, _nowSeconds));
+	return true;
+}
+
+void Server::broadcastSceneState(network::ClientId except) {
+	for (size_t i = 0; i < _network.clientCount(); ++i) {
+		if ((network::ClientId)i == except) {
+			continue;
+		}
+		startSceneStateStream((network::ClientId)i);
+	}
+}
+
+bool Server::isStreamingSceneState() const {
+	return !_sceneStateStreams.empty();
+}
+
+void Server::nodeBroadcasted(const core::UUID &nodeUUID, const core::UUID &parentUUID) {
+	for (SceneStateStream *stream : _sceneStateStreams) {
+		stream->nodeBroadcasted(nodeUUID, parentUUID);
+	}
+}
+
+void Server::removeSceneStateStream(ConnectionId connection) {
+	for (size_t i = 0; i < _sceneStateStreams.size(); ++i) {
+		if (_sceneStateStreams[i]->connection() == connection) {
+			delete _sceneStateStreams[i];
+			_sceneStateStreams.erase(i);
+			return;
+		}
+	}
+}
+
+void Server::updateSceneStateStreams() {
+	for (size_t i = _sceneStateStreams.size(); i > 0; --i) {
+		SceneStateStream *stream = _sceneStateStreams[i - 1];
+		RemoteClient *client = _network.clientByConnection(stream->connection());
+		if (client == nullptr || _sceneGraph == nullptr) {
+			delete stream;
+			_sceneStateStreams.erase(i - 1);
+			continue;
+		}
+		while (client->pendingStreamBytes < SceneStateWindowBytes) {
+			core::ScopedPtr<network::ProtocolMessage> msg(stream->next(*_sceneGraph));
+			if (!msg) {
+				break;
+			}
+			_network.streamToClient(*client, *msg);
+		}
+		if (stream->done()) {
+			Log::info("Sent scene state with %i nodes to %s in %f seconds", (int)stream->sentNodes(),
+					  client->name.c_str(), _nowSeconds - stream->startSeconds());
+			delete stream;
+			_sceneStateStreams.erase(i - 1);
+		}
+	}
+}
+
 void Server::disconnect(const network::ClientId &clientId) {
 	_network.disconnect(clientId);
 }
@@ -92,6 +165,7 @@ void Server::onConnect(RemoteClient *client) {
 }
 
 void Server::onDisconnect(RemoteClient *client) {
+	removeSceneStateStream(client->connection);
 	Log::info("remote client disconnect (%i): %s", (int)_network.clientCount(), client->name.c_str());
 }
 
@@ -116,10 +190,16 @@ bool Server::isRunning() const {
 }
 
 void Server::update(double nowSeconds) {
+	_nowSeconds = nowSeconds;
 	_network.update(nowSeconds);
+	updateSceneStateStreams();
 }
 
 void Server::shutdown() {
+	for (SceneStateStream *stream : _sceneStateStreams) {
+		delete stream;
+	}
+	_sceneStateStreams.clear();
 	_network.removeListener(this);
 	_network.shutdown();
 }
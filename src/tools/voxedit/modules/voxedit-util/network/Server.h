@@ -3,8 +3,10 @@
  */
 #pragma once
 
+#include "SceneStateStream.h"
 #include "ServerNetwork.h"
 #include "core/IComponent.h"
+#include "core/collection/DynamicArray.h"
 #include "scenegraph/SceneGraph.h"
 
 namespace voxedit {
@@ -14,6 +16,12 @@ protected:
 	ServerNetwork _network;
 	// the state of the scene graph that the server is broadcasting to the clients
 	scenegraph::SceneGraph *_sceneGraph = nullptr;
+	// the scene state transfers that are currently running - one per client
+	core::DynamicArray<SceneStateStream *> _sceneStateStreams;
+	double _nowSeconds = 0.0;
+
+	void updateSceneStateStreams();
+	void removeSceneStateStream(ConnectionId connection);
 
 	void onConnect(RemoteClient *client) override;
 	void onDisconnect(RemoteClient *client) override;
@@ -53,6 +61,22 @@ public:
 	void update(double nowSeconds);
 	const RemoteClients &clients() const;
 
+	/**
+	 * @brief Transfer the current scene state to the given client. The scene is streamed node by node in
+	 * @c update() - the amount of data that is queued for the client at the same time is limited.
+	 */
+	bool startSceneStateStream(const network::ClientId &clientId);
+	/**
+	 * @brief Start the scene state transfer for all clients
+	 */
+	void broadcastSceneState(network::ClientId except = 0xFF);
+	bool isStreamingSceneState() const;
+	/**
+	 * @brief Informs the running scene state transfers about a node added message that is broadcasted to the
+	 * clients - to not send the node twice
+	 */
+	void nodeBroadcasted(const core::UUID &nodeUUID, const core::UUID &parentUUID);
+
 	bool initSession(const network::ClientId &clientId, uint32_t protocolVersion, const core::String &applicationVersion,
 					 const core::String &username, const core::String &password, bool localServer);
 	void disconnect(const network::ClientId &clientId);
@@ -20,29 +20,30 @@
 namespace voxedit {
 
 RemoteClient::RemoteClient(RemoteClient &&other) noexcept
-	: socket(other.socket), bytesIn(other.bytesIn), bytesOut(other.bytesOut), lastPingTime(other.lastPingTime),
-	  lastActivity(other.lastActivity), in(core::move(other.in)), out(core::move(other.out)),
-	  name(core::move(other.name)) {
-	other.socket = network::InvalidSocketId;
+	: connection(other.connection), bytesIn(other.bytesIn), bytesOut(other.bytesOut),
+	  pendingStreamBytes(other.pendingStreamBytes), lastPingTime(other.lastPingTime),
+	  lastActivity(other.lastActivity), name(core::move(other.name)) {
+	other.connection = InvalidConnectionId;
 	other.bytesIn = 0u;
 	other.bytesOut = 0u;
+	other.pendingStreamBytes = 0u;
 	other.lastPingTime = 0.0;
 	other.lastActivity = 0.0;
 }
 
 RemoteClient &RemoteClient::operator=(RemoteClient &&other) noexcept {
 	if (this != &other) {
-		socket = other.socket;
+		connection = other.connection;
 		bytesIn = other.bytesIn;
 		bytesOut = other.bytesOut;
+		pendingStreamBytes = other.pendingStreamBytes;
 		lastPingTime = other.lastPingTime;
 		lastActivity = other.lastActivity;
-		in = core::move(other.in);
-		out = core::move(other.out);
 		name = core::move(other.name);
-		other.socket = network::InvalidSocketId;
+		other.connection = InvalidConnectionId;
 		other.bytesIn = 0u;
 		other.bytesOut = 0u;
+		other.pendingStreamBytes = 0u;
 		other.lastPingTime = 0.0;
 		other.lastActivity = 0.0;
 	}
@@ -65,9 +66,6 @@ void ServerNetwork::shutdown() {
 }
 
 bool ServerNetwork::start(uint16_t port, const core::String &iface) {
-	FD_ZERO(&_impl->readFDSet);
-	FD_ZERO(&_impl->writeFDSet);
-
 	_impl->socketFD = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
 	if (_impl->socketFD == network::InvalidSocketId) {
 		network_cleanup();
@@ -105,8 +103,6 @@ bool ServerNetwork::start(uint16_t port, const core::String &iface) {
 	}
 
 	if (bind(_impl->socketFD, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
-		FD_CLR(_impl->socketFD, &_impl->readFDSet);
-		FD_CLR(_impl->socketFD, &_impl->writeFDSet);
 		closesocket(_impl->socketFD);
 		_impl->socketFD = network::InvalidSocketId;
 		network_cleanup();
@@ -124,15 +120,16 @@ bool ServerNetwork::start(uint16_t port, const core::String &iface) {
 		return false;
 	}
 
-#ifdef O_NONBLOCK
-	fcntl(_impl->socketFD, F_SETFL, O_NONBLOCK);
-#endif
-#ifdef WIN32
-	unsigned long mode = 1;
-	ioctlsocket(_impl->socketFD, FIONBIO, &mode);
-#endif
+	// the io thread accepts in a loop until the call would block
+	network::setNonBlocking(_impl->socketFD);
 
-	FD_SET(_impl->socketFD, &_impl->readFDSet);
+	_io.setMaxClients(_maxClients->intVal());
+	if (!_io.start(_impl->socketFD)) {
+		closesocket(_impl->socketFD);
+		_impl->socketFD = network::InvalidSocketId;
+		network_cleanup();
+		return false;
+	}
 	return true;
 }
 
@@ -143,6 +140,7 @@ void ServerNetwork::stop() {
 	for (int j = _clients.size() - 1; j >= 0; --j) {
 		disconnect((network::ClientId)j);
 	}
+	_io.stop();
 	closesocket(_impl->socketFD);
 	_impl->socketFD = network::InvalidSocketId;
 }
@@ -151,6 +149,19 @@ bool ServerNetwork::isRunning() const {
 	return _impl->socketFD != network::InvalidSocketId;
 }
 
+uint16_t ServerNetwork::port() const {
+	if (_impl->socketFD == network::InvalidSocketId) {
+		return 0u;
+	}
+	struct sockaddr_in sin;
+	socklen_t len = sizeof(sin);
+	if (getsockname(_impl->socketFD, (struct sockaddr *)&sin, &len) != 0) {
+		Log::error("Failed to query the server port: %s", network::getNetworkErrorString());
+		return 0u;
+	}
+	return ntohs(sin.sin_port);
+}
+
 void ServerNetwork::construct() {
 	core::Var::get(cfg::VoxEditNetPort, "10001", _("The port to run the voxedit server on"));
 	core::Var::get(cfg::VoxEditNetPassword, "", core::CV_SECRET, _("The password required to connect to the voxedit server"));
@@ -192,56 +203,82 @@ bool ServerNetwork::init() {
 }
 
 void ServerNetwork::disconnect(network::ClientId clientId) {
+	if (clientId >= (network::ClientId)_clients.size()) {
+		return;
+	}
 	RemoteClient &client = _clients[clientId];
-	const network::SocketId clientSocket = client.socket;
-	FD_CLR(clientSocket, &_impl->readFDSet);
-	FD_CLR(clientSocket, &_impl->writeFDSet);
-	closesocket(clientSocket);
-	client.socket = network::InvalidSocketId;
+	// the io thread flushes nothing more for this connection and closes its socket
+	_io.close(client.connection);
 	Log::debug("RemoteClient %d disconnected", clientId);
 	for (NetworkListener *listener : _listeners) {
 		listener->onDisconnect(&client);
 	}
+	client.connection = InvalidConnectionId;
 	_clients.erase(clientId);
 }
 
-bool ServerNetwork::updateClient(RemoteClient &client) {
-	const size_t total = client.out.size();
-	size_t sentTotal = 0;
-	while (sentTotal < total) {
-		const size_t toSend = total - sentTotal;
-		const network_return sent = send(client.socket, (const char *)client.out.getBuffer() + sentTotal, toSend, 0);
-		if (sent < 0) {
-			client.out.skip(sentTotal);
-			client.out.trim();
-			client.bytesOut += sentTotal;
+RemoteClient *ServerNetwork::clientByConnection(ConnectionId connection, network::ClientId &clientId) {
+	for (size_t i = 0; i < _clients.size(); ++i) {
+		if (_clients[i].connection == connection) {
+			clientId = (network::ClientId)i;
+			return &_clients[i];
+		}
+	}
+	return nullptr;
+}
 
-#ifdef WIN32
-			int error = WSAGetLastError();
-			if (error == WSAEWOULDBLOCK || error == WSAEINPROGRESS) {
-				return true;
-			}
-#else
-			if (errno == EAGAIN || errno == EWOULDBLOCK) {
-				return true;
-			}
-#endif
-			// Real error occurred (connection reset, etc.)
-			Log::error("Server send error: %s", network::getNetworkErrorString());
-			return false;
+RemoteClient *ServerNetwork::clientByConnection(ConnectionId connection) {
+	network::ClientId clientId = 0;
+	return clientByConnection(connection, clientId);
+}
+
+void ServerNetwork::handleEvent(ServerNetworkEvent &event, double nowSeconds) {
+	core::ScopedPtr<network::ProtocolMessage> msg(event.msg);
+	switch (event.type) {
+	case ServerNetworkEvent::Type::Connected: {
+		_clients.emplace_back(event.connection);
+		RemoteClient *client = &_clients.back();
+		client->lastActivity = nowSeconds;
+		client->lastPingTime = nowSeconds;
+		for (NetworkListener *listener : _listeners) {
+			listener->onConnect(client);
 		}
-		if (sent == 0) {
-			// Socket closed by peer
-			Log::error("RemoteClient socket closed during send");
-			return false;
+		break;
+	}
+	case ServerNetworkEvent::Type::Disconnected: {
+		network::ClientId clientId = 0;
+		if (clientByConnection(event.connection, clientId) == nullptr) {
+			// we've already disconnected the client on our side
+			break;
 		}
-		sentTotal += sent;
+		Log::debug("RemoteClient %d closed the connection", clientId);
+		disconnect(clientId);
+		break;
+	}
+	case ServerNetworkEvent::Type::Message: {
+		network::ClientId clientId = 0;
+		RemoteClient *client = clientByConnection(event.connection, clientId);
+		if (client == nullptr) {
+			Log::debug("Dropping message of type %d from disconnected client", msg->getId());
+			break;
+		}
+		client->lastActivity = nowSeconds;
+		client->bytesIn += event.bytes;
+		if (network::ProtocolHandler *handler = _protocolRegistry.getHandler(*msg)) {
+			handler->execute(clientId, *msg);
+		} else {
+			Log::warn("No server handler for message type %d", msg->getId());
+		}
+		break;
+	}
+	case ServerNetworkEvent::Type::Sent: {
+		if (RemoteClient *client = clientByConnection(event.connection)) {
+			core_assert(client->pendingStreamBytes >= event.bytes);
+			client->pendingStreamBytes -= event.bytes;
+		}
+		break;
+	}
 	}
-	client.out.skip(sentTotal);
-	client.out.trim();
-	client.bytesOut += sentTotal;
-
-	return true;
 }
 
 void ServerNetwork::update(double nowSeconds) {
@@ -256,112 +293,12 @@ void ServerNetwork::update(double nowSeconds) {
 		// broadcast(msg);
 		_pingSeconds = 0.0;
 	}
-	fd_set readFDsOut;
-	fd_set writeFDsOut;
-
-	readFDsOut = _impl->readFDSet;
-	writeFDsOut = _impl->writeFDSet;
-
-	struct timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = 0;
-#ifdef WIN32
-	const int ready = select(0, &readFDsOut, &writeFDsOut, nullptr, &tv);
-#else
-	int maxFd = _impl->socketFD;
-	for (const auto &client : _clients) {
-		const network::SocketId clientSocket = client.socket;
-		if (client.socket != network::InvalidSocketId && clientSocket > maxFd) {
-			maxFd = clientSocket;
-		}
-	}
-	const int ready = select(maxFd + 1, &readFDsOut, &writeFDsOut, nullptr, &tv);
-#endif
-	if (ready < 0) {
-		Log::warn("select() failed: %s", network::getNetworkErrorString());
-		return;
-	}
-	if (_impl->socketFD != network::InvalidSocketId && FD_ISSET(_impl->socketFD, &readFDsOut)) {
-		const network::SocketId clientSocket = accept(_impl->socketFD, nullptr, nullptr);
-		if (clientSocket != network::InvalidSocketId) {
-			if (_clients.size() >= (size_t)_maxClients->intVal()) {
-				Log::info("Maximum number of clients reached - rejecting connection");
-				closesocket(clientSocket);
-				return;
-			}
-			FD_SET(clientSocket, &_impl->readFDSet);
-			_clients.emplace_back(static_cast<uintptr_t>(clientSocket));
-			RemoteClient *client = &_clients.back();
-			client->lastActivity = nowSeconds;
-			client->lastPingTime = nowSeconds;
-			for (NetworkListener *listener : _listeners) {
-				listener->onConnect(client);
-			}
-		}
-	}
-
-	network::ClientId clientId = 0;
-	core::Array<bool, 256> remove;
-	remove.fill(false);
-	for (auto i = _clients.begin(); i != _clients.end(); ++i, ++clientId) {
-		RemoteClient &client = *i;
-		const network::SocketId clientSocket = client.socket;
-		if (client.socket == network::InvalidSocketId) {
-			remove[clientId] = true;
-			continue;
-		}
-
-		if (FD_ISSET(clientSocket, &writeFDsOut)) {
-			if (!updateClient(client)) {
-				remove[clientId] = true;
-				continue;
-			}
-		}
-
-		if (FD_ISSET(clientSocket, &readFDsOut)) {
-			core::Array<uint8_t, 16384> buf;
-			const network_return len = recv(clientSocket, (char *)&buf[0], buf.size(), 0);
-			if (len < 0) {
-				Log::debug("RemoteClient %d recv error: %s", clientId, network::getNetworkErrorString());
-				remove[clientId] = true;
-				continue;
-			} else if (len == 0) {
-				Log::debug("RemoteClient %d disconnected gracefully", clientId);
-				remove[clientId] = true;
-				continue;
-			}
-			// Update activity timestamp when we receive data
-			client.lastActivity = nowSeconds;
-			client.bytesIn += len;
-			Log::debug("Received %d bytes from client %d", (int)len, clientId);
-			Log::trace("first bytes: %02x %02x %02x %02x %02x", buf[0], buf[1], buf[2], buf[3], buf[4]);
-			client.in.write(buf.data(), len);
-		}
+	_io.setMaxClients(_maxClients->intVal());
 
-		// Process all available messages in the buffer
-		while (ProtocolMessageFactory::isNewMessageAvailable(client.in)) {
-			core::ScopedPtr<network::ProtocolMessage> msg(ProtocolMessageFactory::create(client.in));
-			if (!msg) {
-				Log::debug("RemoteClient %d sent invalid message", clientId);
-				remove[clientId] = true;
-				break;
-			}
-			// Update activity timestamp when we receive a valid message
-			client.lastActivity = nowSeconds;
-			if (network::ProtocolHandler *handler = _protocolRegistry.getHandler(*msg)) {
-				handler->execute(clientId, *msg);
-			} else {
-				Log::warn("No server handler for message type %d", msg->getId());
-			}
-		}
-	}
-	if (clientId > 0) {
-		for (size_t j = clientId; j > 0u; --j) {
-			if (!remove[j - 1]) {
-				continue;
-			}
-			disconnect((network::ClientId)j - 1);
-		}
+	// the io thread has already decoded the messages - we only have to dispatch them
+	ServerNetworkEvent event;
+	while (_io.pollEvent(event)) {
+		handleEvent(event, nowSeconds);
 	}
 }
 
@@ -370,47 +307,26 @@ bool ServerNetwork::broadcast(network::ProtocolMessage &msg, network::ClientId e
 		return false;
 	}
 	_pingSeconds = 0.0;
-	core::Array<bool, 256> remove;
-	remove.fill(false);
+	// encode once - all clients share the same payload
+	const NetworkPayload payload = ServerNetworkIO::encode(msg);
 	network::ClientId clientId = 0;
 	for (auto i = _clients.begin(); i != _clients.end(); ++i, ++clientId) {
 		if (clientId == except) {
 			continue;
 		}
-		RemoteClient &client = *i;
-		if (client.socket == network::InvalidSocketId) {
-			remove[clientId] = true;
-			continue;
-		}
-
 		Log::debug("Broadcasting message to client %i", (int)clientId);
-
-		msg.seek(0);
-		client.out.seek(0, SEEK_END);
-		client.out.writeStream(msg);
-		FD_SET(client.socket, &_impl->writeFDSet);
-	}
-	if (clientId > 0) {
-		for (size_t j = clientId; j > 0u; --j) {
-			if (!remove[j - 1]) {
-				continue;
-			}
-			disconnect((network::ClientId)j - 1);
-		}
+		sendToClient(*i, payload);
 	}
 
 	return true;
 }
 
-bool ServerNetwork::sendToClient(RemoteClient &client, network::ProtocolMessage &msg) {
-	if (client.socket == network::InvalidSocketId) {
+bool ServerNetwork::sendToClient(RemoteClient &client, const NetworkPayload &payload) {
+	if (client.connection == InvalidConnectionId) {
 		return false;
 	}
-
-	msg.seek(0);
-	client.out.seek(0, SEEK_END);
-	client.out.writeStream(msg);
-	FD_SET(client.socket, &_impl->writeFDSet);
+	client.bytesOut += payload->size();
+	_io.send(client.connection, payload);
 	return true;
 }
 
@@ -419,7 +335,18 @@ bool ServerNetwork::sendToClient(network::ClientId clientId, network::ProtocolMe
 		Log::error("Invalid client ID %d - failed to send message: %s", clientId, network::getNetworkErrorString());
 		return false;
 	}
-	return sendToClient(_clients[clientId], msg);
+	return sendToClient(_clients[clientId], ServerNetworkIO::encode(msg));
+}
+
+bool ServerNetwork::streamToClient(RemoteClient &client, network::ProtocolMessage &msg) {
+	if (client.connection == InvalidConnectionId) {
+		return false;
+	}
+	const NetworkPayload payload = ServerNetworkIO::encode(msg);
+	client.bytesOut += payload->size();
+	client.pendingStreamBytes += (uint32_t)payload->size();
+	_io.send(client.connection, payload, true);
+	return true;
 }
 
 void ServerNetwork::addListener(NetworkListener *listener) {
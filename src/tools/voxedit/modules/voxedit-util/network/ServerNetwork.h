@@ -10,6 +10,7 @@
 #include "handler/server/InitSessionHandler.h"
 #include "handler/server/SceneStateHandlerServer.h"
 #include "network/ProtocolHandlerRegistry.h"
+#include "voxedit-util/network/ServerNetworkIO.h"
 #include "voxedit-util/network/handler/server/BroadcastHandler.h"
 #include "voxedit-util/network/handler/server/CommandHandlerServer.h"
 
@@ -22,7 +23,7 @@ namespace voxedit {
 class ProtocolMessage;
 
 struct RemoteClient {
-	explicit RemoteClient(network::SocketId _socket) : socket(_socket) {
+	explicit RemoteClient(ConnectionId _connection) : connection(_connection) {
 	}
 	RemoteClient(RemoteClient &&other) noexcept;
 	RemoteClient &operator=(RemoteClient &&other) noexcept;
@@ -30,13 +31,13 @@ struct RemoteClient {
 	RemoteClient(const RemoteClient &) = delete;
 	RemoteClient &operator=(const RemoteClient &) = delete;
 
-	network::SocketId socket;
+	ConnectionId connection;
 	uint64_t bytesIn = 0u;
 	uint64_t bytesOut = 0u;
+	// bytes of flow controlled messages that were queued but not yet handed over to the socket
+	uint32_t pendingStreamBytes = 0u;
 	double lastPingTime = 0.0;
 	double lastActivity = 0.0;
-	network::MessageStream in;
-	network::MessageStream out;
 	core::String name;
 };
 using RemoteClients = core::DynamicArray<RemoteClient>;
@@ -52,9 +53,14 @@ public:
 	}
 };
 
+/**
+ * @brief The socket io is performed by @c ServerNetworkIO in its own thread - the main loop only
+ * dispatches the already decoded messages in @c update() and queues the encoded payloads
+ */
 class ServerNetwork : public core::DeltaFrameSeconds {
 protected:
 	network::NetworkImpl *_impl;
+	ServerNetworkIO _io;
 
 	double _pingSeconds = 0.0;
 	network::ProtocolHandlerRegistry _protocolRegistry;
@@ -70,8 +76,9 @@ protected:
 	using Listeners = core::DynamicArray<NetworkListener *>;
 	Listeners _listeners;
 
-	bool updateClient(RemoteClient &client);
-	bool sendToClient(RemoteClient &client, network::ProtocolMessage &msg);
+	bool sendToClient(RemoteClient &client, const NetworkPayload &payload);
+	RemoteClient *clientByConnection(ConnectionId connection, network::ClientId &clientId);
+	void handleEvent(ServerNetworkEvent &event, double nowSeconds);
 
 public:
 	ServerNetwork(Server *server);
@@ -80,6 +87,11 @@ public:
 	bool start(uint16_t port = 10001u, const core::String &iface = "0.0.0.0");
 	void stop();
 	bool isRunning() const;
+	/**
+	 * @return The port the server is listening on - useful if it was started with port @c 0 to let the os
+	 * pick a free one. Returns @c 0 if the server is not running.
+	 */
+	uint16_t port() const;
 	void construct() override;
 	bool init() override;
 	void shutdown() override;
@@ -98,6 +110,12 @@ public:
 	 */
 	bool broadcast(network::ProtocolMessage &msg, network::ClientId except = 0xFF);
 	bool sendToClient(network::ClientId clientId, network::ProtocolMessage &msg);
+	/**
+	 * @brief Like @c sendToClient() - but the size of the message is tracked in @c RemoteClient::pendingStreamBytes
+	 * until the io thread handed it over to the socket
+	 */
+	bool streamToClient(RemoteClient &client, network::ProtocolMessage &msg);
+	RemoteClient *clientByConnection(ConnectionId connection);
 };
 
 inline RemoteClient *ServerNetwork::client(network::ClientId clientId) {
@@ -0,0 +1,334 @@
+/**
+ * @file
+ */
+
+#include "ServerNetworkIO.h"
+#include "ProtocolMessageFactory.h"
+#include "core/Log.h"
+#include "core/Trace.h"
+#include "core/collection/Array.h"
+#include "network/NetworkError.h"
+#include "network/NetworkImpl.h"
+
+namespace voxedit {
+
+// upper bound for the poll() timeout - the main loop wakes us up on posix systems, on windows
+// this is the max latency for queued payloads
+static constexpr int PollTimeoutMillis = 10;
+
+ServerNetworkIO::~ServerNetworkIO() {
+	stop();
+}
+
+NetworkPayload ServerNetworkIO::encode(const network::ProtocolMessage &msg) {
+	NetworkPayload payload = core::make_shared<core::Buffer<uint8_t>>();
+	payload->append(msg.getBuffer(), (size_t)msg.size());
+	return payload;
+}
+
+bool ServerNetworkIO::start(network::SocketId listenSocket) {
+	if (_running) {
+		Log::warn("Server io thread is already running");
+		return false;
+	}
+	_listenSocket = listenSocket;
+#ifndef WIN32
+	if (pipe(_wakeupPipe) != 0) {
+		Log::error("Failed to create the server wakeup pipe: %s", network::getNetworkErrorString());
+		return false;
+	}
+	network::setNonBlocking(_wakeupPipe[0]);
+	network::setNonBlocking(_wakeupPipe[1]);
+#endif
+	_running = true;
+	_thread = std::thread([this]() { run(); });
+	return true;
+}
+
+void ServerNetworkIO::stop() {
+	if (!_running.exchange(false)) {
+		return;
+	}
+	wakeup();
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+	for (size_t i = _connections.size(); i > 0; --i) {
+		closeConnection(i - 1, false);
+	}
+	_commands.clear();
+	ServerNetworkEvent event;
+	while (_events.pop(event)) {
+		delete event.msg;
+	}
+#ifndef WIN32
+	::close(_wakeupPipe[0]);
+	::close(_wakeupPipe[1]);
+	_wakeupPipe[0] = _wakeupPipe[1] = -1;
+#endif
+	_listenSocket = network::InvalidSocketId;
+}
+
+void ServerNetworkIO::wakeup() {
+#ifndef WIN32
+	if (_wakeupPipe[1] != -1) {
+		const uint8_t b = 0u;
+		// the pipe might be full - but then the io thread wakes up anyway
+		(void)!write(_wakeupPipe[1], &b, sizeof(b));
+	}
+#endif
+}
+
+void ServerNetworkIO::send(ConnectionId connection, const NetworkPayload &payload, bool notifySent) {
+	Command cmd;
+	cmd.type = Command::Type::Send;
+	cmd.connection = connection;
+	cmd.payload = payload;
+	cmd.notifySent = notifySent;
+	_commands.push(core::move(cmd));
+	wakeup();
+}
+
+void ServerNetworkIO::close(ConnectionId connection) {
+	Command cmd;
+	cmd.type = Command::Type::Close;
+	cmd.connection = connection;
+	_commands.push(core::move(cmd));
+	wakeup();
+}
+
+bool ServerNetworkIO::pollEvent(ServerNetworkEvent &event) {
+	return _events.pop(event);
+}
+
+ServerNetworkIO::Connection *ServerNetworkIO::findConnection(ConnectionId id, size_t &idx) const {
+	for (size_t i = 0; i < _connections.size(); ++i) {
+		if (_connections[i]->id == id) {
+			idx = i;
+			return _connections[i];
+		}
+	}
+	return nullptr;
+}
+
+void ServerNetworkIO::closeConnection(size_t idx, bool notify) {
+	Connection *connection = _connections[idx];
+	closesocket(connection->socket);
+	if (notify) {
+		ServerNetworkEvent event;
+		event.type = ServerNetworkEvent::Type::Disconnected;
+		event.connection = connection->id;
+		_events.push(core::move(event));
+	}
+	delete connection;
+	_connections.erase(idx);
+}
+
+void ServerNetworkIO::executeCommands() {
+	Command cmd;
+	while (_commands.pop(cmd)) {
+		size_t idx = 0;
+		Connection *connection = findConnection(cmd.connection, idx);
+		if (connection == nullptr) {
+			// the client already disconnected
+			continue;
+		}
+		if (cmd.type == Command::Type::Close) {
+			closeConnection(idx, false);
+			continue;
+		}
+		PendingPayload pending;
+		pending.payload = cmd.payload;
+		pending.notifySent = cmd.notifySent;
+		connection->pending.push(core::move(pending));
+	}
+}
+
+void ServerNetworkIO::acceptConnections() {
+	for (;;) {
+		const network::SocketId clientSocket = accept(_listenSocket, nullptr, nullptr);
+		if (clientSocket == network::InvalidSocketId) {
+			return;
+		}
+		if (_connections.size() >= (size_t)(int)_maxClients) {
+			Log::info("Maximum number of clients reached - rejecting connection");
+			closesocket(clientSocket);
+			continue;
+		}
+		if (!network::setNonBlocking(clientSocket)) {
+			Log::warn("Failed to switch client socket into non-blocking mode: %s", network::getNetworkErrorString());
+			closesocket(clientSocket);
+			continue;
+		}
+		// we are sending a lot of small messages - don't wait for more data
+		int t = 1;
+		setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, (const char *)&t, sizeof(t));
+
+		Connection *connection = new Connection();
+		connection->id = ++_nextConnectionId;
+		connection->socket = clientSocket;
+		_connections.push_back(connection);
+
+		ServerNetworkEvent event;
+		event.type = ServerNetworkEvent::Type::Connected;
+		event.connection = connection->id;
+		_events.push(core::move(event));
+	}
+}
+
+bool ServerNetworkIO::readConnection(Connection *connection) {
+	core::Array<uint8_t, 16384> buf;
+	for (;;) {
+		const network_return len = recv(connection->socket, (char *)&buf[0], buf.size(), 0);
+		if (len < 0) {
+			if (network::wouldBlock()) {
+				break;
+			}
+			Log::debug("RemoteClient recv error: %s", network::getNetworkErrorString());
+			return false;
+		}
+		if (len == 0) {
+			Log::debug("RemoteClient disconnected gracefully");
+			return false;
+		}
+		connection->in.write(buf.data(), len);
+	}
+
+	// decode the messages here to take the load from the main loop
+	while (ProtocolMessageFactory::isNewMessageAvailable(connection->in)) {
+		const int64_t before = connection->in.size();
+		network::ProtocolMessage *msg = ProtocolMessageFactory::create(connection->in);
+		if (msg == nullptr) {
+			Log::debug("RemoteClient sent invalid message");
+			return false;
+		}
+		ServerNetworkEvent event;
+		event.type = ServerNetworkEvent::Type::Message;
+		event.connection = connection->id;
+		event.msg = msg;
+		event.bytes = (uint32_t)(before - connection->in.size());
+		_events.push(core::move(event));
+	}
+	return true;
+}
+
+bool ServerNetworkIO::flushConnection(Connection *connection) {
+	while (!connection->pending.empty()) {
+		const NetworkPayload &payload = connection->pending.front().payload;
+		const size_t total = payload->size();
+		while (connection->pendingOffset < total) {
+			const size_t toSend = total - connection->pendingOffset;
+			const network_return sent =
+				::send(connection->socket, (const char *)payload->data() + connection->pendingOffset, toSend, 0);
+			if (sent < 0) {
+				if (network::wouldBlock()) {
+					// try again once poll() reports the socket as writable
+					return true;
+				}
+				Log::error("Server send error: %s", network::getNetworkErrorString());
+				return false;
+			}
+			if (sent == 0) {
+				Log::error("RemoteClient socket closed during send");
+				return false;
+			}
+			connection->pendingOffset += sent;
+		}
+		if (connection->pending.front().notifySent) {
+			ServerNetworkEvent event;
+			event.type = ServerNetworkEvent::Type::Sent;
+			event.connection = connection->id;
+			event.bytes = (uint32_t)total;
+			_events.push(core::move(event));
+		}
+		connection->pendingOffset = 0u;
+		connection->pending.pop();
+	}
+	return true;
+}
+
+void ServerNetworkIO::run() {
+	core_trace_thread("ServerNetworkIO");
+	core::DynamicArray<network_pollfd> fds;
+	while (_running) {
+		executeCommands();
+		// try to send everything right away - poll() only has to wait for the sockets that would block
+		for (size_t i = _connections.size(); i > 0; --i) {
+			if (!flushConnection(_connections[i - 1])) {
+				closeConnection(i - 1, true);
+			}
+		}
+
+		fds.clear();
+		network_pollfd listenFd;
+		listenFd.fd = _listenSocket;
+		listenFd.events = POLLIN;
+		listenFd.revents = 0;
+		fds.push_back(listenFd);
+#ifndef WIN32
+		network_pollfd wakeupFd;
+		wakeupFd.fd = _wakeupPipe[0];
+		wakeupFd.events = POLLIN;
+		wakeupFd.revents = 0;
+		fds.push_back(wakeupFd);
+#endif
+		const size_t connectionOffset = fds.size();
+		for (const Connection *connection : _connections) {
+			network_pollfd fd;
+			fd.fd = connection->socket;
+			fd.events = POLLIN;
+			if (!connection->pending.empty()) {
+				fd.events |= POLLOUT;
+			}
+			fd.revents = 0;
+			fds.push_back(fd);
+		}
+
+		const int ready = network_poll(fds.data(), (unsigned long)fds.size(), PollTimeoutMillis);
+		if (ready < 0) {
+#ifndef WIN32
+			if (errno == EINTR) {
+				continue;
+			}
+#endif
+			Log::warn("poll() failed: %s", network::getNetworkErrorString());
+			continue;
+		}
+		if (ready == 0) {
+			continue;
+		}
+
+#ifndef WIN32
+		if (fds[1].revents & POLLIN) {
+			uint8_t drain[64];
+			while (read(_wakeupPipe[0], drain, sizeof(drain)) > 0) {
+			}
+		}
+#endif
+
+		// iterate backwards - connections might get removed. New connections are only appended
+		// after this loop and are thus not part of the fds array
+		for (size_t i = _connections.size(); i > 0; --i) {
+			const network_pollfd &fd = fds[connectionOffset + i - 1];
+			Connection *connection = _connections[i - 1];
+			core_assert(fd.fd == connection->socket);
+			bool alive = true;
+			if (fd.revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) {
+				// POLLHUP and POLLERR are detected by recv()
+				alive = readConnection(connection);
+			}
+			if (alive && (fd.revents & POLLOUT)) {
+				alive = flushConnection(connection);
+			}
+			if (!alive) {
+				closeConnection(i - 1, true);
+			}
+		}
+
+		if (fds[0].revents & POLLIN) {
+			acceptConnections();
+		}
+	}
+}
+
+} // namespace voxedit
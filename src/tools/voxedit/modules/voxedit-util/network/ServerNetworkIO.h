@@ -0,0 +1,147 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/NonCopyable.h"
+#include "core/SharedPtr.h"
+#include "core/collection/Buffer.h"
+#include "core/collection/ConcurrentLockFreeQueue.h"
+#include "core/collection/DynamicArray.h"
+#include "core/collection/Queue.h"
+#include "core/concurrent/Atomic.h"
+#include "network/ProtocolMessage.h"
+#include "network/SocketId.h"
+#include <thread>
+
+namespace voxedit {
+
+/**
+ * @brief Encoded message bytes that are shared between all receivers of a broadcast
+ */
+using NetworkPayload = core::SharedPtr<core::Buffer<uint8_t>>;
+
+/**
+ * @brief Identifies a client connection of the @c ServerNetworkIO. Unlike the socket handle - which the
+ * os might reuse for the next accepted connection - an id is never handed out twice.
+ */
+using ConnectionId = uint32_t;
+static constexpr ConnectionId InvalidConnectionId = 0u;
+
+/**
+ * @brief Events that are produced by the io thread and consumed by the main loop
+ */
+struct ServerNetworkEvent {
+	enum class Type : uint8_t { Connected, Disconnected, Message, Sent };
+	Type type = Type::Message;
+	ConnectionId connection = InvalidConnectionId;
+	// owned by the receiver of the event - only set for @c Type::Message
+	network::ProtocolMessage *msg = nullptr;
+	// the amount of bytes that were received for the message - or for @c Type::Sent the amount of bytes
+	// of the payload that was completely handed over to the socket
+	uint32_t bytes = 0u;
+};
+
+/**
+ * @brief Dedicated thread that owns the client sockets of the @c ServerNetwork
+ *
+ * The thread accepts new connections, reads and decodes incoming messages and flushes queued outgoing
+ * payloads to the non-blocking client sockets via @c poll(). The main loop only talks to it through two
+ * lock-free queues - it never touches a socket on its own.
+ */
+class ServerNetworkIO : public core::NonCopyable {
+private:
+	struct PendingPayload {
+		NetworkPayload payload;
+		bool notifySent = false;
+	};
+
+	struct Connection {
+		ConnectionId id = InvalidConnectionId;
+		network::SocketId socket = network::InvalidSocketId;
+		network::MessageStream in;
+		core::Queue<PendingPayload> pending;
+		// amount of bytes of the first pending payload that were already sent
+		size_t pendingOffset = 0u;
+	};
+
+	struct Command {
+		enum class Type : uint8_t { Send, Close };
+		Type type = Type::Send;
+		ConnectionId connection = InvalidConnectionId;
+		NetworkPayload payload;
+		bool notifySent = false;
+	};
+
+	std::thread _thread;
+	core::AtomicBool _running{false};
+	core::AtomicInt _maxClients{10};
+	network::SocketId _listenSocket = network::InvalidSocketId;
+#ifndef WIN32
+	// self-pipe to wake up the poll() call if new commands were queued
+	int _wakeupPipe[2]{-1, -1};
+#endif
+	core::ConcurrentLockFreeQueue<ServerNetworkEvent> _events;
+	core::ConcurrentLockFreeQueue<Command> _commands;
+	// only accessed by the io thread
+	core::DynamicArray<Connection *> _connections;
+	ConnectionId _nextConnectionId = InvalidConnectionId;
+
+	void run();
+	void wakeup();
+	void executeCommands();
+	void acceptConnections();
+	bool readConnection(Connection *connection);
+	bool flushConnection(Connection *connection);
+	void closeConnection(size_t idx, bool notify);
+	Connection *findConnection(ConnectionId id, size_t &idx) const;
+
+public:
+	~ServerNetworkIO();
+
+	/**
+	 * @brief Spawn the io thread for the given non-blocking listen socket
+	 * @note The listen socket stays owned by the caller - but must not get closed before @c stop() was called
+	 */
+	bool start(network::SocketId listenSocket);
+	/**
+	 * @brief Stops the io thread and closes all client connections
+	 */
+	void stop();
+	bool isRunning() const;
+
+	void setMaxClients(int maxClients);
+
+	/**
+	 * @brief Queue the payload for the given client connection. The same payload can be queued for multiple
+	 * clients without copying the data.
+	 * @param notifySent Generate a @c ServerNetworkEvent::Type::Sent event once the payload was handed over to the
+	 * socket. This can be used for flow control.
+	 */
+	void send(ConnectionId connection, const NetworkPayload &payload, bool notifySent = false);
+	/**
+	 * @brief Close the connection to the given client. No disconnect event is generated for this.
+	 */
+	void close(ConnectionId connection);
+
+	/**
+	 * @note Only call this from the main thread
+	 */
+	bool pollEvent(ServerNetworkEvent &event);
+
+	/**
+	 * @brief Creates the shareable payload from the serialized message
+	 */
+	static NetworkPayload encode(const network::ProtocolMessage &msg);
+};
+
+inline bool ServerNetworkIO::isRunning() const {
+	return _running;
+}
+
+inline void ServerNetworkIO::setMaxClients(int maxClients) {
+	_maxClients = maxClients;
+}
+
+} // namespace voxedit
@@ -5,6 +5,7 @@
 #include "NodeAddedHandler.h"
 #include "scenegraph/SceneGraphNode.h"
 #include "voxedit-util/SceneManager.h"
+#include "voxel/RawVolume.h"
 #include "voxel/VolumeCompression.h"
 
 namespace voxedit {
@@ -53,7 +54,12 @@ void NodeAddedHandler::execute(const network::ClientId &, NodeAddedMessage *mess
 	if (nodeType == scenegraph::SceneGraphNodeType::Model) {
 		const uint8_t *data = message->compressedData();
 		const uint32_t dataSize = message->compressedSize();
-		newNode.setVolume(voxel::toVolume(data, dataSize, message->region()), true);
+		if (dataSize == 0u) {
+			// streamed scene state - the voxels follow as voxel modifications
+			newNode.setVolume(new voxel::RawVolume(message->region()), true);
+		} else {
+			newNode.setVolume(voxel::toVolume(data, dataSize, message->region()), true);
+		}
 	}
 	newNode.setPalette(message->palette());
 	for (const auto & e : message->properties()) {
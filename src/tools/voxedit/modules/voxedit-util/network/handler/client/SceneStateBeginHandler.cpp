@@ -0,0 +1,31 @@
+/**
+ * @file
+ */
+
+#include "SceneStateBeginHandler.h"
+#include "voxedit-util/SceneManager.h"
+
+namespace voxedit {
+
+SceneStateBeginHandler::SceneStateBeginHandler(SceneManager *sceneMgr) : _sceneMgr(sceneMgr) {
+}
+
+void SceneStateBeginHandler::execute(const network::ClientId &, SceneStateBeginMessage *message) {
+	Log::info("Receiving scene state with %u nodes", message->nodeCount());
+
+	Client &client = _sceneMgr->client();
+	client.lockListener();
+	_sceneMgr->beginSceneStream(message->rootUUID());
+	scenegraph::SceneGraph &sceneGraph = _sceneMgr->sceneGraph();
+	scenegraph::SceneGraphNode &root = sceneGraph.node(sceneGraph.root().id());
+	for (const auto &e : message->rootProperties()) {
+		root.setProperty(e->first, e->second);
+	}
+	if (!message->animations().empty()) {
+		sceneGraph.setAnimations(message->animations());
+	}
+	sceneGraph.setAnimation(message->activeAnimation());
+	client.unlockListener();
+}
+
+} // namespace voxedit
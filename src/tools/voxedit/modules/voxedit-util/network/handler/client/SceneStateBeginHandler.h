@@ -0,0 +1,23 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "network/ProtocolHandler.h"
+#include "voxedit-util/network/protocol/SceneStateBeginMessage.h"
+
+namespace voxedit {
+
+class SceneManager;
+
+class SceneStateBeginHandler : public network::ProtocolTypeHandler<SceneStateBeginMessage> {
+private:
+	SceneManager *_sceneMgr;
+
+public:
+	SceneStateBeginHandler(SceneManager *sceneMgr);
+	void execute(const network::ClientId &, SceneStateBeginMessage *message) override;
+};
+
+} // namespace voxedit
@@ -0,0 +1,22 @@
+/**
+ * @file
+ */
+
+#include "SceneStateEndHandler.h"
+#include "voxedit-util/SceneManager.h"
+
+namespace voxedit {
+
+SceneStateEndHandler::SceneStateEndHandler(SceneManager *sceneMgr) : _sceneMgr(sceneMgr) {
+}
+
+void SceneStateEndHandler::execute(const network::ClientId &, SceneStateEndMessage *) {
+	Log::info("Received scene state with %i nodes", (int)_sceneMgr->sceneGraph().size());
+
+	Client &client = _sceneMgr->client();
+	client.lockListener();
+	_sceneMgr->endSceneStream();
+	client.unlockListener();
+}
+
+} // namespace voxedit
@@ -0,0 +1,23 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "network/ProtocolHandler.h"
+#include "voxedit-util/network/protocol/SceneStateEndMessage.h"
+
+namespace voxedit {
+
+class SceneManager;
+
+class SceneStateEndHandler : public network::ProtocolTypeHandler<SceneStateEndMessage> {
+private:
+	SceneManager *_sceneMgr;
+
+public:
+	SceneStateEndHandler(SceneManager *sceneMgr);
+	void execute(const network::ClientId &, SceneStateEndMessage *message) override;
+};
+
+} // namespace voxedit
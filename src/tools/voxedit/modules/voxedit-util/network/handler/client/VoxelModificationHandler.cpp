@@ -3,8 +3,7 @@
  */
 
 #include "VoxelModificationHandler.h"
-#include "io/MemoryReadStream.h"
-#include "io/ZipReadStream.h"
+#include "core/ScopedPtr.h"
 #include "scenegraph/SceneGraphNode.h"
 #include "voxedit-util/SceneManager.h"
 
@@ -30,18 +29,11 @@ void VoxelModificationHandler::execute(const network::ClientId &, VoxelModificat
 		Log::warn("Received voxel modification with invalid region for node UUID %s", uuidStr.c_str());
 		return;
 	}
-	const uint8_t *data = message->compressedData();
-	const uint32_t dataSize = message->compressedSize();
-	const size_t uncompressedBufferSize = message->region().voxels() * sizeof(voxel::Voxel);
-	io::MemoryReadStream dataStream(data, dataSize);
-	io::ZipReadStream stream(dataStream, (int)dataStream.size());
-	uint8_t *uncompressedBuf = (uint8_t *)core_malloc(uncompressedBufferSize);
-	if (stream.read(uncompressedBuf, uncompressedBufferSize) == -1) {
-		core_free(uncompressedBuf);
+	core::ScopedPtr<voxel::RawVolume> v(message->toVolume());
+	if (!v) {
+		Log::warn("Failed to decode voxel modification for node UUID %s", uuidStr.c_str());
 		return;
 	}
-	core::ScopedPtr<voxel::RawVolume> v(
-		voxel::RawVolume::createRaw((voxel::Voxel *)uncompressedBuf, message->region()));
 	Client &client = _sceneMgr->client();
 	client.lockListener();
 	_sceneMgr->nodeUpdatePartialVolume(*node, *v);
@@ -4,6 +4,7 @@
 
 #include "BroadcastHandler.h"
 #include "voxedit-util/network/Server.h"
+#include "voxedit-util/network/protocol/NodeAddedMessage.h"
 
 namespace voxedit {
 
@@ -13,6 +14,10 @@ BroadcastHandler::BroadcastHandler(Server *server) : _server(server) {
 void BroadcastHandler::execute(const network::ClientId &clientId, network::ProtocolMessage &msg) {
 	Log::debug("Broadcasting message of type %d from client %d", msg.getId(), (int)clientId);
 	msg.writeBack();
+	if (msg.getId() == PROTO_NODE_ADDED) {
+		const NodeAddedMessage &added = (const NodeAddedMessage &)msg;
+		_server->nodeBroadcasted(added.nodeUUID(), added.parentUUID());
+	}
 	_server->network().broadcast(msg, clientId);
 }
 
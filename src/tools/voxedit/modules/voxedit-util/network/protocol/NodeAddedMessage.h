@@ -6,6 +6,7 @@
 
 #include "core/String.h"
 #include "memento/MementoHandler.h"
+#include "scenegraph/SceneGraph.h"
 #include "scenegraph/SceneGraphNode.h"
 #include "voxedit-util/network/ProtocolIds.h"
 
@@ -29,46 +30,83 @@ private:
 	uint8_t *_compressedData = nullptr;
 	voxel::Region _region;
 
-public:
-	NodeAddedMessage(const memento::MementoState &state) : ProtocolMessage(PROTO_NODE_ADDED) {
-		if (!writeUUID(state.parentUUID)) {
+	bool serialize(const core::UUID &parentUUID, const core::UUID &nodeUUID, const core::UUID &referenceUUID,
+				   const core::String &name, scenegraph::SceneGraphNodeType nodeType, const glm::vec3 &pivot,
+				   const palette::Palette &palette, const scenegraph::SceneGraphNodeProperties &properties,
+				   const voxel::Region &region, const uint8_t *compressedData, uint32_t compressedSize,
+				   const scenegraph::SceneGraphKeyFramesMap &keyFrames) {
+		if (!writeUUID(parentUUID)) {
 			Log::error("Failed to write parent UUID");
-			return;
+			return false;
 		}
-		if (!writeUUID(state.nodeUUID)) {
+		if (!writeUUID(nodeUUID)) {
 			Log::error("Failed to write node UUID");
-			return;
+			return false;
 		}
-		if (!writeUUID(state.referenceUUID)) {
+		if (!writeUUID(referenceUUID)) {
 			Log::error("Failed to write reference UUID");
-			return;
+			return false;
 		}
-		if (!writePascalStringUInt16LE(state.name)) {
+		if (!writePascalStringUInt16LE(name)) {
 			Log::error("Failed to write node name");
-			return;
+			return false;
 		}
-		if (!writeUInt8((uint8_t)state.nodeType)) {
+		if (!writeUInt8((uint8_t)nodeType)) {
 			Log::error("Failed to write node type");
-			return;
+			return false;
 		}
-		if (!serializeVec3(state.pivot)) {
-			return;
+		if (!serializeVec3(pivot)) {
+			return false;
 		}
-		if (!serializePalette(state.palette)) {
-			return;
+		if (!serializePalette(palette)) {
+			return false;
 		}
-		if (!serializeProperties(state.properties)) {
-			return;
+		if (!serializeProperties(properties)) {
+			return false;
 		}
-		if (state.nodeType == scenegraph::SceneGraphNodeType::Model) {
-			if (!serializeRegion(state.volumeRegion())) {
-				return;
+		if (nodeType == scenegraph::SceneGraphNodeType::Model) {
+			if (!serializeRegion(region)) {
+				return false;
 			}
-			if (!serializeVolume(state.data.buffer(), state.data.size())) {
-				return;
+			if (!serializeVolume(compressedData, compressedSize)) {
+				return false;
+			}
+		}
+		if (!serializeKeyFrames(keyFrames)) {
+			return false;
+		}
+		return true;
+	}
+
+public:
+	NodeAddedMessage(const memento::MementoState &state) : ProtocolMessage(PROTO_NODE_ADDED) {
+		if (!serialize(state.parentUUID, state.nodeUUID, state.referenceUUID, state.name, state.nodeType, state.pivot,
+					   state.palette, state.properties, state.volumeRegion(), state.data.buffer(),
+					   (uint32_t)state.data.size(), state.keyFrames)) {
+			return;
+		}
+		writeSize();
+	}
+
+	/**
+	 * @brief Creates the message from the current state of the given node
+	 * @param withVoxels If this is @c false, model nodes are transferred with their region only. The client
+	 * creates an empty volume and the voxels are sent in separate @c VoxelModificationMessage bricks.
+	 */
+	NodeAddedMessage(const scenegraph::SceneGraph &sceneGraph, const scenegraph::SceneGraphNode &node,
+					 bool withVoxels)
+		: ProtocolMessage(PROTO_NODE_ADDED) {
+		memento::MementoData data;
+		voxel::Region region = voxel::Region::InvalidRegion;
+		if (node.type() == scenegraph::SceneGraphNodeType::Model) {
+			region = node.region();
+			if (withVoxels) {
+				data = memento::MementoData::fromVolume(node.volume(), voxel::Region::InvalidRegion);
 			}
 		}
-		if (!serializeKeyFrames(state.keyFrames)) {
+		if (!serialize(sceneGraph.uuid(node.parent()), node.uuid(), sceneGraph.uuid(node.reference()), node.name(),
+					   node.type(), node.pivot(), node.palette(), node.properties(), region, data.buffer(),
+					   (uint32_t)data.size(), node.allKeyFrames())) {
 			return;
 		}
 		writeSize();
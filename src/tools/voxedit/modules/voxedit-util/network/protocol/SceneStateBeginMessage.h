@@ -0,0 +1,139 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/String.h"
+#include "core/UUID.h"
+#include "core/collection/DynamicArray.h"
+#include "scenegraph/SceneGraph.h"
+#include "voxedit-util/network/ProtocolIds.h"
+
+namespace voxedit {
+
+/**
+ * @brief Start of a streamed scene state
+ *
+ * The server doesn't send the whole scene graph in one message to a client that joins the session. It sends this
+ * message with the scene graph level data, the nodes as @c NodeAddedMessage - large volumes are followed by
+ * @c VoxelModificationMessage bricks - and finally the @c SceneStateEndMessage.
+ */
+class SceneStateBeginMessage : public network::ProtocolMessage {
+private:
+	core::UUID _rootUUID;
+	// the amount of nodes that are going to be streamed - only for progress information
+	uint32_t _nodeCount = 0u;
+	scenegraph::SceneGraphNodeProperties _rootProperties;
+	core::DynamicArray<core::String> _animations;
+	core::String _activeAnimation;
+
+	bool serialize() {
+		if (!writeUUID(_rootUUID)) {
+			Log::error("Failed to write root UUID");
+			return false;
+		}
+		if (!writeUInt32(_nodeCount)) {
+			Log::error("Failed to write node count");
+			return false;
+		}
+		if (!serializeProperties(_rootProperties)) {
+			Log::error("Failed to write root properties");
+			return false;
+		}
+		if (!writeUInt16((uint16_t)_animations.size())) {
+			Log::error("Failed to write animation count");
+			return false;
+		}
+		for (const core::String &anim : _animations) {
+			if (!writePascalStringUInt16LE(anim)) {
+				Log::error("Failed to write animation name");
+				return false;
+			}
+		}
+		if (!writePascalStringUInt16LE(_activeAnimation)) {
+			Log::error("Failed to write active animation");
+			return false;
+		}
+		return true;
+	}
+
+public:
+	SceneStateBeginMessage(const scenegraph::SceneGraph &sceneGraph, uint32_t nodeCount)
+		: ProtocolMessage(PROTO_SCENE_STATE_BEGIN), _nodeCount(nodeCount) {
+		const scenegraph::SceneGraphNode &root = sceneGraph.root();
+		_rootUUID = root.uuid();
+		_rootProperties = root.properties();
+		_animations = sceneGraph.animations();
+		_activeAnimation = sceneGraph.activeAnimation();
+		if (!serialize()) {
+			Log::error("Failed to serialize SceneStateBeginMessage");
+			return;
+		}
+		writeSize();
+	}
+
+	SceneStateBeginMessage(network::MessageStream &in) {
+		_id = PROTO_SCENE_STATE_BEGIN;
+		if (in.readUUID(_rootUUID) == -1) {
+			Log::error("Failed to read root UUID");
+			return;
+		}
+		if (in.readUInt32(_nodeCount) == -1) {
+			Log::error("Failed to read node count");
+			return;
+		}
+		if (!deserializeProperties(in, _rootProperties)) {
+			Log::error("Failed to read root properties");
+			return;
+		}
+		uint16_t count = 0;
+		if (in.readUInt16(count) == -1) {
+			Log::error("Failed to read animation count");
+			return;
+		}
+		_animations.reserve(count);
+		for (uint16_t i = 0; i < count; ++i) {
+			core::String anim;
+			if (!in.readPascalStringUInt16LE(anim)) {
+				Log::error("Failed to read animation name");
+				return;
+			}
+			_animations.push_back(anim);
+		}
+		if (!in.readPascalStringUInt16LE(_activeAnimation)) {
+			Log::error("Failed to read active animation");
+			return;
+		}
+	}
+
+	void writeBack() override {
+		if (!writeInt32(0) || !writeUInt8(_id)) {
+			Log::error("Failed to write header in SceneStateBeginMessage::writeBack");
+			return;
+		}
+		if (!serialize()) {
+			Log::error("Failed to serialize in SceneStateBeginMessage::writeBack");
+			return;
+		}
+		writeSize();
+	}
+
+	const core::UUID &rootUUID() const {
+		return _rootUUID;
+	}
+	uint32_t nodeCount() const {
+		return _nodeCount;
+	}
+	const scenegraph::SceneGraphNodeProperties &rootProperties() const {
+		return _rootProperties;
+	}
+	const core::DynamicArray<core::String> &animations() const {
+		return _animations;
+	}
+	const core::String &activeAnimation() const {
+		return _activeAnimation;
+	}
+};
+
+} // namespace voxedit
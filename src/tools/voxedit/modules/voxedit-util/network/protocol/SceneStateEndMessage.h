@@ -0,0 +1,17 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "voxedit-util/network/ProtocolIds.h"
+
+namespace voxedit {
+
+/**
+ * @brief Marks the end of a streamed scene state
+ * @sa SceneStateBeginMessage
+ */
+PROTO_MSG(SceneStateEndMessage, PROTO_SCENE_STATE_END);
+
+} // namespace voxedit
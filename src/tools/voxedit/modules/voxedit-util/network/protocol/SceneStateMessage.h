@@ -8,8 +8,8 @@
 #include "io/Stream.h"
 #include "io/StreamArchive.h"
 #include "scenegraph/SceneGraph.h"
-#include "util/VarUtil.h"
 #include "voxedit-util/network/ProtocolIds.h"
+#include "voxelformat/FormatConfig.h"
 #include "voxelformat/private/vengi/VENGIFormat.h"
 
 namespace voxedit {
@@ -18,29 +18,36 @@ class SceneStateMessage : public network::ProtocolMessage {
 private:
 	scenegraph::SceneGraph _sceneGraph;
 
-public:
-	SceneStateMessage(scenegraph::SceneGraph &sceneGraph) : ProtocolMessage(PROTO_SCENE_STATE) {
+	/**
+	 * @brief The format settings for the scene state - the peers must agree on them, so they must not depend on the
+	 * settings of the user
+	 */
+	static voxelformat::FormatConfig formatConfig() {
+		voxelformat::FormatConfig config;
 		// we don't want to modify the voxels
-		util::ScopedVarChange var1(cfg::VoxformatEmptyPaletteIndex, "-1");
+		config.emptyPaletteIndex = -1;
+		config.vengiIndexed = false;
+		return config;
+	}
 
+public:
+	SceneStateMessage(scenegraph::SceneGraph &sceneGraph) : ProtocolMessage(PROTO_SCENE_STATE) {
 		voxelformat::VENGIFormat vengiFormat;
 		io::SeekableWriteStream *writeStream = (io::SeekableWriteStream *)this;
 		const io::StreamArchivePtr &archive = io::openStreamArchive(writeStream);
-		voxelformat::SaveContext ctx;
+		voxelformat::SaveContext ctx(formatConfig());
+		vengiFormat.configure(ctx.config);
 		vengiFormat.saveGroups(sceneGraph, "net.vengi", archive, ctx);
 		writeSize();
 	}
 
 	SceneStateMessage(network::MessageStream &in, uint32_t size) {
 		_id = PROTO_SCENE_STATE;
-		// we don't want to modify the voxels
-		util::ScopedVarChange var1(cfg::VoxformatEmptyPaletteIndex, "-1");
-
 		voxelformat::VENGIFormat vengiFormat;
 		io::BufferedReadWriteStream bufferedStream(in, size);
 		io::SeekableReadStream *readStream = (io::SeekableReadStream *)&bufferedStream;
 		const io::StreamArchivePtr &archive = io::openStreamArchive(readStream);
-		voxelformat::LoadContext ctx;
+		voxelformat::LoadContext ctx(formatConfig());
 		vengiFormat.load("net.vengi", archive, _sceneGraph, ctx);
 	}
 	// this is intentionally not complete - as this message is not broadcasted because it is sent by the server and
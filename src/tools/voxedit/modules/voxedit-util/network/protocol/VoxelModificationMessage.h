@@ -4,21 +4,195 @@
 
 #pragma once
 
+#include "core/ScopedPtr.h"
+#include "core/collection/DynamicArray.h"
+#include "io/BufferedReadWriteStream.h"
+#include "io/ZipWriteStream.h"
 #include "memento/MementoHandler.h"
 #include "voxedit-util/network/ProtocolIds.h"
+#include "voxel/RawVolume.h"
 #include "voxel/Region.h"
+#include "voxel/VolumeCompression.h"
 
 namespace voxedit {
 
 /**
- * @brief Voxel modification message with compressed voxel data
+ * @brief How the voxels of the modified region are transferred
+ */
+enum class VoxelModificationEncoding : uint8_t {
+	// the whole region as compressed voxel data
+	Dense = 0,
+	// only the non-air voxels of the region with their index - every other voxel in the region is air
+	Sparse = 1
+};
+
+/**
+ * @brief A single non-air voxel of a sparse encoded voxel modification
+ */
+struct SparseVoxel {
+	// linear index into the region (x + y * width + z * width * height)
+	uint32_t index = 0u;
+	voxel::Voxel voxel;
+};
+
+/**
+ * @brief Voxel modification message with either compressed or sparse voxel data
+ *
+ * The sender picks the smaller of both encodings for the modified region.
  */
 class VoxelModificationMessage : public network::ProtocolMessage {
 private:
 	core::UUID _nodeUUID;
 	voxel::Region _region;
+	VoxelModificationEncoding _encoding = VoxelModificationEncoding::Dense;
 	uint32_t _compressedSize = 0;
 	uint8_t *_compressedData = nullptr;
+	core::DynamicArray<SparseVoxel> _sparseVoxels;
+
+	// amount of bytes needed for the sparse encoding - the uint32 count, index and voxel per entry
+	static constexpr uint64_t sparseBytes(uint64_t voxels) {
+		return sizeof(uint32_t) + voxels * (sizeof(uint32_t) + sizeof(voxel::Voxel));
+	}
+
+	static uint64_t regionVoxels(const voxel::Region &region) {
+		return (uint64_t)region.getWidthInVoxels() * (uint64_t)region.getHeightInVoxels() *
+			   (uint64_t)region.getDepthInVoxels();
+	}
+
+	/**
+	 * @return @c true if the sparse encoding is the smaller one - it's not possible for regions that can't be
+	 * indexed with the uint32 sparse voxel index
+	 */
+	static bool useSparse(const voxel::Region &region, uint64_t solid, uint64_t compressedSize) {
+		return regionVoxels(region) <= (uint64_t)UINT32_MAX &&
+			   sparseBytes(solid) < sizeof(uint32_t) + compressedSize;
+	}
+
+	static uint64_t countSolid(const voxel::RawVolume &volume) {
+		const voxel::Voxel *voxels = volume.voxels();
+		const size_t n = (size_t)regionVoxels(volume.region());
+		uint64_t solid = 0u;
+		for (size_t i = 0u; i < n; ++i) {
+			if (!voxel::isAir(voxels[i].getMaterial())) {
+				++solid;
+			}
+		}
+		return solid;
+	}
+
+	bool serializeSparse(const voxel::RawVolume &volume, uint64_t solid) {
+		ScopedProtocolMessageSerialization s(this, "SparseVolume");
+		if (!writeUInt32((uint32_t)solid)) {
+			Log::error("Failed to write sparse voxel count");
+			return false;
+		}
+		const voxel::Voxel *voxels = volume.voxels();
+		const size_t n = (size_t)regionVoxels(volume.region());
+		for (size_t i = 0u; i < n; ++i) {
+			if (voxel::isAir(voxels[i].getMaterial())) {
+				continue;
+			}
+			uint32_t raw;
+			core_memcpy(&raw, &voxels[i], sizeof(raw));
+			if (!writeUInt32((uint32_t)i) || !writeUInt32(raw)) {
+				Log::error("Failed to write sparse voxel");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool serializeSparse() {
+		ScopedProtocolMessageSerialization s(this, "SparseVolume");
+		if (!writeUInt32((uint32_t)_sparseVoxels.size())) {
+			Log::error("Failed to write sparse voxel count");
+			return false;
+		}
+		for (const SparseVoxel &v : _sparseVoxels) {
+			uint32_t raw;
+			core_memcpy(&raw, &v.voxel, sizeof(raw));
+			if (!writeUInt32(v.index) || !writeUInt32(raw)) {
+				Log::error("Failed to write sparse voxel");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool deserializeSparse(network::MessageStream &in, const voxel::Region &region,
+								  core::DynamicArray<SparseVoxel> &sparseVoxels) {
+		ScopedProtocolStreamDeserialization s(in, "SparseVolume");
+		uint32_t count = 0u;
+		if (in.readUInt32(count) == -1) {
+			Log::error("Failed to read sparse voxel count");
+			return false;
+		}
+		const uint64_t maxIndex = regionVoxels(region);
+		if (count > maxIndex) {
+			Log::error("Sparse voxel count %u exceeds the region size", count);
+			return false;
+		}
+		sparseVoxels.resize(count);
+		for (uint32_t i = 0u; i < count; ++i) {
+			SparseVoxel &v = sparseVoxels[i];
+			uint32_t raw;
+			if (in.readUInt32(v.index) == -1 || in.readUInt32(raw) == -1) {
+				Log::error("Failed to read sparse voxel %u/%u", i, count);
+				return false;
+			}
+			if (v.index >= maxIndex) {
+				Log::error("Sparse voxel index %u is out of bounds", v.index);
+				return false;
+			}
+			core_memcpy((void *)&v.voxel, &raw, sizeof(raw));
+		}
+		return true;
+	}
+
+	void writeSparse(const voxel::RawVolume &volume, uint64_t solid) {
+		Log::debug("Use sparse encoding for %u voxels", (uint32_t)solid);
+		if (!writeUInt8((uint8_t)VoxelModificationEncoding::Sparse) || !serializeSparse(volume, solid)) {
+			Log::error("Failed to serialize sparse volume in VoxelModificationMessage");
+		}
+	}
+
+	void writeDense(const uint8_t *compressedData, uint32_t compressedSize) {
+		if (!writeUInt8((uint8_t)VoxelModificationEncoding::Dense) ||
+			!serializeVolume(compressedData, compressedSize)) {
+			Log::error("Failed to serialize volume in VoxelModificationMessage");
+		}
+	}
+
+	/**
+	 * @param[in] volume The voxels of the modified region - the region of the volume must match the
+	 * modified region. They are only compressed if the sparse encoding is not the smaller one.
+	 */
+	void serialize(const voxel::RawVolume &volume) {
+		const voxel::Region &region = volume.region();
+		const uint64_t solid = countSolid(volume);
+		// the compressed data can't get smaller than a few bytes - don't compress at all if
+		// the sparse encoding is already that small
+		if (useSparse(region, solid, 64u)) {
+			writeSparse(volume, solid);
+			return;
+		}
+		const size_t bytes = (size_t)regionVoxels(region) * sizeof(voxel::Voxel);
+		io::BufferedReadWriteStream outStream((int64_t)bytes);
+		{
+			io::ZipWriteStream stream(outStream);
+			if (stream.write(volume.data(), bytes) == -1 || !stream.flush()) {
+				Log::error("Failed to compress volume data in VoxelModificationMessage");
+				writeSparse(volume, solid);
+				return;
+			}
+		}
+		const uint64_t compressedSize = (uint64_t)outStream.size();
+		if (useSparse(region, solid, compressedSize)) {
+			writeSparse(volume, solid);
+		} else {
+			writeDense(outStream.getBuffer(), (uint32_t)compressedSize);
+		}
+	}
 
 public:
 	VoxelModificationMessage(const memento::MementoState &state) : ProtocolMessage(PROTO_VOXEL_MODIFICATION) {
@@ -31,12 +205,41 @@ public:
 			Log::error("Failed to serialize region in VoxelModificationMessage ctor");
 			return;
 		}
-		if (!serializeVolume(state.data.buffer(), state.data.size())) {
-			Log::error("Failed to serialize volume in VoxelModificationMessage ctor");
+		// the memento knows the amount of solid voxels - the data is only decompressed for the sparse encoding
+		const uint64_t solid = state.data.solidVoxels();
+		if (useSparse(state.dataRegion(), solid, state.data.size())) {
+			core::ScopedPtr<voxel::RawVolume> v(
+				voxel::toVolume(state.data.buffer(), (uint32_t)state.data.size(), state.dataRegion()));
+			if (!v) {
+				Log::error("Failed to decompress the memento state in VoxelModificationMessage ctor");
+				return;
+			}
+			writeSparse(*v, solid);
+		} else {
+			writeDense(state.data.buffer(), (uint32_t)state.data.size());
+		}
+		writeSize();
+	}
+
+	/**
+	 * @brief Transfers the current voxels of the given region of the volume
+	 */
+	VoxelModificationMessage(const core::UUID &nodeUUID, const voxel::RawVolume &volume,
+							 const voxel::Region &region)
+		: ProtocolMessage(PROTO_VOXEL_MODIFICATION) {
+		if (!writeUUID(nodeUUID)) {
+			Log::error("Failed to write node UUID in VoxelModificationMessage ctor");
+			return;
+		}
+		const voxel::RawVolume v(volume, region);
+		if (!serializeRegion(v.region())) {
+			Log::error("Failed to serialize region in VoxelModificationMessage ctor");
 			return;
 		}
+		serialize(v);
 		writeSize();
 	}
+
 	VoxelModificationMessage(network::MessageStream &in) {
 		_id = PROTO_VOXEL_MODIFICATION;
 		if (in.readUUID(_nodeUUID) == -1) {
@@ -47,6 +250,18 @@ public:
 			Log::error("Failed to deserialize region for voxel modification");
 			return;
 		}
+		uint8_t encoding = 0u;
+		if (in.readUInt8(encoding) == -1) {
+			Log::error("Failed to read the encoding for voxel modification");
+			return;
+		}
+		_encoding = (VoxelModificationEncoding)encoding;
+		if (_encoding == VoxelModificationEncoding::Sparse) {
+			if (!deserializeSparse(in, _region, _sparseVoxels)) {
+				Log::error("Failed to deserialize sparse volume for voxel modification");
+			}
+			return;
+		}
 		if (!deserializeVolume(in, _compressedSize, _compressedData)) {
 			Log::error("Failed to deserialize volume for voxel modification");
 			return;
@@ -65,7 +280,16 @@ public:
 			Log::error("Failed to serialize region in VoxelModificationMessage::writeBack");
 			return;
 		}
-		if (!serializeVolume(_compressedData, _compressedSize)) {
+		if (!writeUInt8((uint8_t)_encoding)) {
+			Log::error("Failed to write encoding in VoxelModificationMessage::writeBack");
+			return;
+		}
+		if (_encoding == VoxelModificationEncoding::Sparse) {
+			if (!serializeSparse()) {
+				Log::error("Failed to serialize sparse volume in VoxelModificationMessage::writeBack");
+				return;
+			}
+		} else if (!serializeVolume(_compressedData, _compressedSize)) {
 			Log::error("Failed to serialize volume in VoxelModificationMessage::writeBack");
 			return;
 		}
@@ -76,12 +300,40 @@ public:
 		delete[] _compressedData;
 	}
 
+	/**
+	 * @brief Creates a volume for the modified region
+	 * @return @c nullptr on error - the caller takes ownership
+	 */
+	voxel::RawVolume *toVolume() const {
+		if (!_region.isValid()) {
+			return nullptr;
+		}
+		if (_encoding == VoxelModificationEncoding::Sparse) {
+			voxel::RawVolume *v = new voxel::RawVolume(_region);
+			voxel::Voxel *voxels = v->voxels();
+			for (const SparseVoxel &sv : _sparseVoxels) {
+				voxels[sv.index] = sv.voxel;
+			}
+			return v;
+		}
+		if (_compressedData == nullptr) {
+			return nullptr;
+		}
+		return voxel::toVolume(_compressedData, _compressedSize, _region);
+	}
+
 	const voxel::Region &region() const {
 		return _region;
 	}
 	const core::UUID &nodeUUID() const {
 		return _nodeUUID;
 	}
+	VoxelModificationEncoding encoding() const {
+		return _encoding;
+	}
+	const core::DynamicArray<SparseVoxel> &sparseVoxels() const {
+		return _sparseVoxels;
+	}
 	const uint8_t *compressedData() const {
 		return _compressedData;
 	}
@@ -0,0 +1,198 @@
+/**
+ * @file
+ */
+
+#include "../AutoSaveJournal.h"
+#include "app/tests/AbstractTest.h"
+#include "core/ConfigVar.h"
+#include "core/Var.h"
+#include "io/Filesystem.h"
+#include "io/FilesystemArchive.h"
+#include "memento/MementoHandler.h"
+#include "scenegraph/SceneGraph.h"
+#include "scenegraph/SceneGraphNode.h"
+#include "voxel/RawVolume.h"
+#include "voxel/Voxel.h"
+#include "voxelformat/Format.h"
+#include "voxelformat/FormatConfig.h"
+#include "voxelformat/private/vengi/VENGIFormat.h"
+
+namespace voxedit {
+
+class AutoSaveJournalTest : public app::AbstractTest {
+protected:
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		voxelformat::FormatConfig::init();
+	}
+
+	int addModel(scenegraph::SceneGraph &sceneGraph, const core::String &name) {
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(new voxel::RawVolume(voxel::Region(0, 3)), true);
+		node.setName(name);
+		return sceneGraph.emplace(core::move(node));
+	}
+
+	memento::MementoState state(memento::MementoType type, const core::UUID &nodeUUID) {
+		memento::MementoState s;
+		s.type = type;
+		s.nodeUUID = nodeUUID;
+		return s;
+	}
+
+	bool load(const core::String &filename, scenegraph::SceneGraph &sceneGraph) {
+		const io::ArchivePtr &archive = io::openFilesystemArchive(_testApp->filesystem());
+		voxelformat::VENGIFormat format;
+		voxelformat::LoadContext ctx;
+		if (!format.load(filename, archive, sceneGraph, ctx)) {
+			return false;
+		}
+		return AutoSaveJournal::replay(filename, archive, sceneGraph);
+	}
+};
+
+TEST_F(AutoSaveJournalTest, testIncrementalSave) {
+	const core::String &filename = _testApp->filesystem()->homeWritePath("autosavejournaltest.vengi");
+	const core::String &journal = AutoSaveJournal::journalFilename(filename);
+	scenegraph::SceneGraph sceneGraph;
+	const int nodeId1 = addModel(sceneGraph, "first");
+	const int nodeId2 = addModel(sceneGraph, "second");
+	ASSERT_NE(InvalidNodeId, nodeId1);
+	ASSERT_NE(InvalidNodeId, nodeId2);
+	scenegraph::SceneGraphNode &node1 = sceneGraph.node(nodeId1);
+	scenegraph::SceneGraphNode &node2 = sceneGraph.node(nodeId2);
+
+	AutoSaveJournal autoSave;
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+	EXPECT_TRUE(io::Filesystem::sysExists(filename));
+	EXPECT_FALSE(io::Filesystem::sysExists(journal));
+
+	// only the first node is modified - this goes into the journal
+	node1.volume()->setVoxel(1, 2, 3, voxel::createVoxel(voxel::VoxelType::Generic, 42));
+	node1.setName("renamed");
+	node2.volume()->setVoxel(0, 0, 0, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	autoSave.onMementoStateAdded(state(memento::MementoType::Modification, node1.uuid()));
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+	EXPECT_TRUE(io::Filesystem::sysExists(journal));
+
+	scenegraph::SceneGraph loaded;
+	ASSERT_TRUE(load(filename, loaded));
+	const scenegraph::SceneGraphNode *loadedNode1 = loaded.findNodeByUUID(node1.uuid());
+	const scenegraph::SceneGraphNode *loadedNode2 = loaded.findNodeByUUID(node2.uuid());
+	ASSERT_NE(nullptr, loadedNode1);
+	ASSERT_NE(nullptr, loadedNode2);
+	EXPECT_EQ("renamed", loadedNode1->name());
+	EXPECT_EQ(42, loadedNode1->volume()->voxel(1, 2, 3).getColor());
+	// not announced by a memento state - so not part of the journal
+	EXPECT_TRUE(voxel::isAir(loadedNode2->volume()->voxel(0, 0, 0).getMaterial()));
+
+	// structural changes are leading to a full save again
+	autoSave.onMementoStateAdded(state(memento::MementoType::SceneNodeAdded, node2.uuid()));
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+	EXPECT_FALSE(io::Filesystem::sysExists(journal));
+
+	scenegraph::SceneGraph loadedFull;
+	ASSERT_TRUE(load(filename, loadedFull));
+	loadedNode2 = loadedFull.findNodeByUUID(node2.uuid());
+	ASSERT_NE(nullptr, loadedNode2);
+	EXPECT_EQ(1, loadedNode2->volume()->voxel(0, 0, 0).getColor());
+	io::Filesystem::sysRemoveFile(filename);
+}
+
+TEST_F(AutoSaveJournalTest, testStaleJournalEntries) {
+	const core::String &filename = _testApp->filesystem()->homeWritePath("autosavejournalstaletest.vengi");
+	const core::String &journal = AutoSaveJournal::journalFilename(filename);
+	const core::String &staleJournal = journal + ".stale";
+	scenegraph::SceneGraph sceneGraph;
+	const int nodeId = addModel(sceneGraph, "first");
+	ASSERT_NE(InvalidNodeId, nodeId);
+	scenegraph::SceneGraphNode &node = sceneGraph.node(nodeId);
+
+	AutoSaveJournal autoSave;
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+	node.setName("journal");
+	autoSave.onMementoStateAdded(state(memento::MementoType::SceneNodeRenamed, node.uuid()));
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+	ASSERT_TRUE(io::Filesystem::sysRenameFile(journal, staleJournal));
+
+	// simulate a crash after the new full save was written - but before the journal was removed
+	node.setName("full");
+	autoSave.onMementoStateAdded(state(memento::MementoType::SceneNodeAdded, node.uuid()));
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+	ASSERT_TRUE(io::Filesystem::sysRenameFile(staleJournal, journal));
+
+	scenegraph::SceneGraph loaded;
+	ASSERT_TRUE(load(filename, loaded));
+	const scenegraph::SceneGraphNode *loadedNode = loaded.findNodeByUUID(node.uuid());
+	ASSERT_NE(nullptr, loadedNode);
+	EXPECT_EQ("full", loadedNode->name());
+	EXPECT_FALSE(loaded.root().properties().hasKey("autosave_generation"));
+	io::Filesystem::sysRemoveFile(journal);
+	io::Filesystem::sysRemoveFile(filename);
+}
+
+TEST_F(AutoSaveJournalTest, testIgnoreSaveSettings) {
+	const core::String &filename = _testApp->filesystem()->homeWritePath("autosavejournalsettingstest.vengi");
+	scenegraph::SceneGraph sceneGraph;
+	const int nodeId1 = addModel(sceneGraph, "visible");
+	const int nodeId2 = addModel(sceneGraph, "hidden");
+	ASSERT_NE(InvalidNodeId, nodeId1);
+	ASSERT_NE(InvalidNodeId, nodeId2);
+	sceneGraph.node(nodeId2).setVisible(false);
+	core::Var::getSafe(cfg::VoxformatMerge)->setVal(true);
+	core::Var::getSafe(cfg::VoxformatSaveVisibleOnly)->setVal(true);
+
+	AutoSaveJournal autoSave;
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+	core::Var::getSafe(cfg::VoxformatMerge)->setVal(false);
+	core::Var::getSafe(cfg::VoxformatSaveVisibleOnly)->setVal(false);
+
+	scenegraph::SceneGraph loaded;
+	ASSERT_TRUE(load(filename, loaded));
+	EXPECT_NE(nullptr, loaded.findNodeByUUID(sceneGraph.node(nodeId1).uuid()));
+	EXPECT_NE(nullptr, loaded.findNodeByUUID(sceneGraph.node(nodeId2).uuid()));
+	io::Filesystem::sysRemoveFile(filename);
+}
+
+TEST_F(AutoSaveJournalTest, testFullSaveReusesVolumeSnapshots) {
+	const core::String &filename = _testApp->filesystem()->homeWritePath("autosavejournalsnapshottest.vengi");
+	scenegraph::SceneGraph sceneGraph;
+	const int nodeId1 = addModel(sceneGraph, "first");
+	const int nodeId2 = addModel(sceneGraph, "second");
+	ASSERT_NE(InvalidNodeId, nodeId1);
+	ASSERT_NE(InvalidNodeId, nodeId2);
+	scenegraph::SceneGraphNode &node1 = sceneGraph.node(nodeId1);
+	scenegraph::SceneGraphNode &node2 = sceneGraph.node(nodeId2);
+
+	AutoSaveJournal autoSave;
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+
+	// only the volume of the modified node is copied again for the next full save
+	node1.volume()->setVoxel(1, 1, 1, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	node2.volume()->setVoxel(2, 2, 2, voxel::createVoxel(voxel::VoxelType::Generic, 2));
+	autoSave.onMementoStateAdded(state(memento::MementoType::Modification, node1.uuid()));
+	autoSave.onMementoStateAdded(state(memento::MementoType::SceneGraphAnimation, core::UUID()));
+	ASSERT_TRUE(autoSave.save(sceneGraph, filename));
+	ASSERT_TRUE(autoSave.wait());
+
+	scenegraph::SceneGraph loaded;
+	ASSERT_TRUE(load(filename, loaded));
+	const scenegraph::SceneGraphNode *loadedNode1 = loaded.findNodeByUUID(node1.uuid());
+	const scenegraph::SceneGraphNode *loadedNode2 = loaded.findNodeByUUID(node2.uuid());
+	ASSERT_NE(nullptr, loadedNode1);
+	ASSERT_NE(nullptr, loadedNode2);
+	EXPECT_EQ(1, loadedNode1->volume()->voxel(1, 1, 1).getColor());
+	// not announced by a memento state - the snapshot of the last save was reused
+	EXPECT_TRUE(voxel::isAir(loadedNode2->volume()->voxel(2, 2, 2).getMaterial()));
+	io::Filesystem::sysRemoveFile(filename);
+}
+
+} // namespace voxedit
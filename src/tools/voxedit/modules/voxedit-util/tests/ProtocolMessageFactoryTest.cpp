@@ -23,6 +23,8 @@
 #include "voxedit-util/network/protocol/NodeRemovedMessage.h"
 #include "voxedit-util/network/protocol/NodeRenamedMessage.h"
 #include "voxedit-util/network/protocol/PingMessage.h"
+#include "voxedit-util/network/protocol/SceneStateBeginMessage.h"
+#include "voxedit-util/network/protocol/SceneStateEndMessage.h"
 #include "voxedit-util/network/protocol/SceneStateMessage.h"
 #include "voxedit-util/network/protocol/SceneStateRequestMessage.h"
 #include "voxedit-util/network/protocol/VoxelModificationMessage.h"
@@ -273,12 +275,14 @@ protected:
 							  const core::String &messageName) {
 		EXPECT_EQ(state.nodeUUID, deserialized->nodeUUID()) << messageName + ": Node UUID mismatch";
 		EXPECT_EQ(state.dataRegion(), deserialized->region()) << messageName + ": Region mismatch";
-		EXPECT_EQ(state.data.size(), deserialized->compressedSize()) << messageName + ": Compressed size mismatch";
 
-		if (state.data.size() > 0 && deserialized->compressedData() != nullptr) {
-			EXPECT_EQ(0, memcmp(state.data.buffer(), deserialized->compressedData(), state.data.size()))
-				<< messageName + ": Compressed data mismatch";
-		}
+		core::ScopedPtr<voxel::RawVolume> expected(
+			voxel::toVolume(state.data.buffer(), (uint32_t)state.data.size(), state.dataRegion()));
+		core::ScopedPtr<voxel::RawVolume> actual(deserialized->toVolume());
+		ASSERT_TRUE(expected) << messageName + ": Failed to decompress the state";
+		ASSERT_TRUE(actual) << messageName + ": Failed to create the volume";
+		EXPECT_EQ(0, memcmp(expected->data(), actual->data(), expected->region().voxels() * sizeof(voxel::Voxel)))
+			<< messageName + ": Voxel data mismatch";
 	}
 
 	void verifyMessageContent(const memento::MementoState &state, voxedit::NodeKeyFramesMessage *deserialized,
@@ -328,7 +332,6 @@ public:
 	void SetUp() override {
 		app::AbstractTest::SetUp();
 		core::Var::get(cfg::VoxformatRGBFlattenFactor, "0");
-		core::Var::get(cfg::VoxformatEmptyPaletteIndex, "-1");
 		core::Var::get(cfg::VoxEditNetPassword, "test");
 	}
 };
@@ -343,6 +346,17 @@ TEST_F(ProtocolMessageFactoryTest, testSceneStateRequestMessage) {
 	testRoundTripSerialization(&originalMsg, "SceneStateRequestMessage");
 }
 
+TEST_F(ProtocolMessageFactoryTest, testSceneStateBeginMessage) {
+	scenegraph::SceneGraph sceneGraph = createTestSceneGraph();
+	voxedit::SceneStateBeginMessage originalMsg(sceneGraph, (uint32_t)sceneGraph.size());
+	testRoundTripSerialization(&originalMsg, "SceneStateBeginMessage");
+}
+
+TEST_F(ProtocolMessageFactoryTest, testSceneStateEndMessage) {
+	voxedit::SceneStateEndMessage originalMsg;
+	testRoundTripSerialization(&originalMsg, "SceneStateEndMessage");
+}
+
 TEST_F(ProtocolMessageFactoryTest, testInitSessionMessage) {
 	voxedit::InitSessionMessage originalMsg(true);
 	testRoundTripSerialization(&originalMsg, "InitSessionMessage");
@@ -353,6 +367,65 @@ TEST_F(ProtocolMessageFactoryTest, testVoxelModificationMessage) {
 	testRoundTripSerializationWithState<voxedit::VoxelModificationMessage>(state, "VoxelModificationMessage");
 }
 
+TEST_F(ProtocolMessageFactoryTest, testVoxelModificationMessageSparse) {
+	memento::MementoState state = createTestMementoState();
+	EXPECT_EQ(2u, state.data.solidVoxels());
+	voxedit::VoxelModificationMessage msg(state);
+	network::MessageStream stream;
+	stream.write(msg.getBuffer(), msg.size());
+	core::ScopedPtr<network::ProtocolMessage> deserialized(voxedit::ProtocolMessageFactory::create(stream));
+	ASSERT_TRUE(deserialized);
+	voxedit::VoxelModificationMessage *m = (voxedit::VoxelModificationMessage *)((network::ProtocolMessage *)deserialized);
+	// only two voxels are set - this must be transferred as a list of voxels
+	EXPECT_EQ(voxedit::VoxelModificationEncoding::Sparse, m->encoding());
+	EXPECT_EQ(2u, m->sparseVoxels().size());
+}
+
+TEST_F(ProtocolMessageFactoryTest, testVoxelModificationMessageDense) {
+	const voxel::Region region(0, 31);
+	voxel::RawVolume volume(region);
+	volume.fill(voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	const voxel::Region modified(4, 4, 4, 19, 19, 19);
+	const core::UUID nodeUUID = core::UUID::generate();
+	voxedit::VoxelModificationMessage msg(nodeUUID, volume, modified);
+	network::MessageStream stream;
+	stream.write(msg.getBuffer(), msg.size());
+	core::ScopedPtr<network::ProtocolMessage> deserialized(voxedit::ProtocolMessageFactory::create(stream));
+	ASSERT_TRUE(deserialized);
+	voxedit::VoxelModificationMessage *m = (voxedit::VoxelModificationMessage *)((network::ProtocolMessage *)deserialized);
+	// a solid region compresses way better than listing all voxels
+	EXPECT_EQ(voxedit::VoxelModificationEncoding::Dense, m->encoding());
+	EXPECT_EQ(nodeUUID, m->nodeUUID());
+	EXPECT_EQ(modified, m->region());
+	core::ScopedPtr<voxel::RawVolume> v(m->toVolume());
+	ASSERT_TRUE(v);
+	EXPECT_EQ(modified, v->region());
+	EXPECT_TRUE(voxel::isBlocked(v->voxel(4, 4, 4).getMaterial()));
+	EXPECT_TRUE(voxel::isBlocked(v->voxel(19, 19, 19).getMaterial()));
+}
+
+TEST_F(ProtocolMessageFactoryTest, testVoxelModificationMessageDenseMemento) {
+	const voxel::Region region(0, 31);
+	voxel::RawVolume volume(region);
+	volume.fill(voxel::createVoxel(voxel::VoxelType::Generic, 1));
+	memento::MementoState state = createTestMementoState();
+	state.data = memento::MementoData::fromVolume(&volume, region);
+	EXPECT_EQ((size_t)region.voxels(), state.data.solidVoxels());
+	voxedit::VoxelModificationMessage msg(state);
+	network::MessageStream stream;
+	stream.write(msg.getBuffer(), msg.size());
+	core::ScopedPtr<network::ProtocolMessage> deserialized(voxedit::ProtocolMessageFactory::create(stream));
+	ASSERT_TRUE(deserialized);
+	voxedit::VoxelModificationMessage *m = (voxedit::VoxelModificationMessage *)((network::ProtocolMessage *)deserialized);
+	// the compressed memento data is sent as it is
+	EXPECT_EQ(voxedit::VoxelModificationEncoding::Dense, m->encoding());
+	EXPECT_EQ((uint32_t)state.data.size(), m->compressedSize());
+	core::ScopedPtr<voxel::RawVolume> v(m->toVolume());
+	ASSERT_TRUE(v);
+	EXPECT_EQ(region, v->region());
+	EXPECT_TRUE(voxel::isBlocked(v->voxel(31, 31, 31).getMaterial()));
+}
+
 TEST_F(ProtocolMessageFactoryTest, testNodeAddedMessage) {
 	memento::MementoState state = createTestMementoState();
 	testRoundTripSerializationWithState<voxedit::NodeAddedMessage>(state, "NodeAddedMessage");
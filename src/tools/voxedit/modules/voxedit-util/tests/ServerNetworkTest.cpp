@@ -0,0 +1,363 @@
+/**
+ * @file
+ */
+
+#include "voxedit-util/network/Server.h"
+#include "voxedit-util/network/SceneStateStream.h"
+#include "app/tests/AbstractTest.h"
+#include "core/ScopedPtr.h"
+#include "core/TimeProvider.h"
+#include "memento/MementoHandler.h"
+#include "network/NetworkImpl.h"
+#include "voxedit-util/Config.h"
+#include "scenegraph/SceneGraph.h"
+#include "voxedit-util/network/ProtocolMessageFactory.h"
+#include "voxedit-util/network/protocol/InitSessionMessage.h"
+#include "voxedit-util/network/protocol/NodeAddedMessage.h"
+#include "voxedit-util/network/protocol/SceneStateBeginMessage.h"
+#include "voxedit-util/network/protocol/VoxelModificationMessage.h"
+#include "voxel/RawVolume.h"
+#include "voxel/VolumeCompression.h"
+
+namespace voxedit {
+
+/**
+ * @brief Loopback load test for the collaboration server. Simulated clients are plain non-blocking sockets
+ * that flood the server with voxel modifications while the server has to broadcast them to all others.
+ */
+class ServerNetworkTest : public app::AbstractTest {
+protected:
+	struct SimulatedClient {
+		network::SocketId socket = network::InvalidSocketId;
+		network::MessageStream in;
+		int received = 0;
+
+		~SimulatedClient() {
+			if (socket != network::InvalidSocketId) {
+				closesocket(socket);
+			}
+		}
+
+		bool connect(uint16_t port) {
+			socket = ::socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+			if (socket == network::InvalidSocketId) {
+				return false;
+			}
+			struct sockaddr_in sin;
+			memset(&sin, 0, sizeof(sin));
+			sin.sin_family = AF_INET;
+			sin.sin_port = htons(port);
+			inet_pton(AF_INET, "127.0.0.1", &sin.sin_addr);
+			if (::connect(socket, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+				return false;
+			}
+			return network::setNonBlocking(socket);
+		}
+
+		bool send(const network::ProtocolMessage &msg) {
+			const size_t total = msg.size();
+			size_t sentTotal = 0;
+			while (sentTotal < total) {
+				const network_return sent =
+					::send(socket, (const char *)msg.getBuffer() + sentTotal, total - sentTotal, 0);
+				if (sent < 0) {
+					if (network::wouldBlock()) {
+						drain();
+						continue;
+					}
+					return false;
+				}
+				sentTotal += sent;
+			}
+			return true;
+		}
+
+		template<class FUNC>
+		void receive(FUNC &&func) {
+			uint8_t buf[16384];
+			for (;;) {
+				const network_return len = recv(socket, (char *)buf, sizeof(buf), 0);
+				if (len <= 0) {
+					break;
+				}
+				in.write(buf, len);
+			}
+			while (ProtocolMessageFactory::isNewMessageAvailable(in)) {
+				core::ScopedPtr<network::ProtocolMessage> msg(ProtocolMessageFactory::create(in));
+				if (msg) {
+					func(*msg);
+				}
+			}
+		}
+
+		void drain() {
+			receive([this](network::ProtocolMessage &msg) {
+				if (msg.getId() == PROTO_VOXEL_MODIFICATION) {
+					++received;
+				}
+			});
+		}
+	};
+
+	Server _server;
+	uint16_t _port = 0u;
+
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		_server.construct();
+		ASSERT_TRUE(_server.init());
+		core::Var::getSafe(cfg::VoxEditNetServerMaxConnections)->setVal("64");
+		// let the os pick a free port
+		if (!_server.start(0u, "127.0.0.1")) {
+			GTEST_SKIP() << "Could not start the voxedit server";
+		}
+		_port = _server.network().port();
+		ASSERT_NE(0u, _port);
+	}
+
+	void TearDown() override {
+		_server.shutdown();
+		app::AbstractTest::TearDown();
+	}
+
+	double now() {
+		_testApp->timeProvider()->updateTickTime();
+		return _testApp->timeProvider()->tickSeconds();
+	}
+
+	// the message as the client sees it
+	static network::ProtocolMessage *receive(network::ProtocolMessage *sent) {
+		core::ScopedPtr<network::ProtocolMessage> msg(sent);
+		if (!msg) {
+			return nullptr;
+		}
+		network::MessageStream in;
+		in.write(msg->getBuffer(), msg->size());
+		return ProtocolMessageFactory::create(in);
+	}
+
+	memento::MementoState createModification() {
+		const voxel::Region region(0, 15);
+		voxel::RawVolume volume(region);
+		for (int i = 0; i < 16; ++i) {
+			volume.setVoxel(i, i, i, voxel::createVoxel(voxel::VoxelType::Generic, 1));
+		}
+		memento::MementoState state;
+		state.type = memento::MementoType::Modification;
+		state.nodeUUID = core::UUID::generate();
+		state.data = memento::MementoData::fromVolume(&volume, region);
+		return state;
+	}
+};
+
+TEST_F(ServerNetworkTest, testBroadcastLoad) {
+	const int clientCount = 16;
+	const int messagesPerClient = 50;
+	SimulatedClient clients[clientCount];
+	for (SimulatedClient &client : clients) {
+		ASSERT_TRUE(client.connect(_port));
+	}
+
+	const double startSeconds = now();
+	while (_server.clients().size() < (size_t)clientCount) {
+		_server.update(now());
+		ASSERT_LT(now() - startSeconds, 5.0) << "Not all clients got accepted";
+	}
+
+	const memento::MementoState state = createModification();
+	VoxelModificationMessage msg(state);
+	const double sendStartSeconds = now();
+	for (int i = 0; i < messagesPerClient; ++i) {
+		for (SimulatedClient &client : clients) {
+			ASSERT_TRUE(client.send(msg));
+		}
+		_server.update(now());
+	}
+
+	const int expected = (clientCount - 1) * messagesPerClient;
+	for (;;) {
+		_server.update(now());
+		bool done = true;
+		for (SimulatedClient &client : clients) {
+			client.drain();
+			if (client.received < expected) {
+				done = false;
+			}
+		}
+		if (done) {
+			break;
+		}
+		ASSERT_LT(now() - sendStartSeconds, 20.0) << "Not all broadcasts were received";
+	}
+	const double seconds = now() - sendStartSeconds;
+	const int messages = clientCount * messagesPerClient;
+	Log::info("Broadcasted %i messages of %i bytes to %i clients in %f seconds", messages, (int)msg.size(),
+			  clientCount, seconds);
+	for (const SimulatedClient &client : clients) {
+		EXPECT_EQ(expected, client.received);
+	}
+}
+
+TEST_F(ServerNetworkTest, testDisconnect) {
+	SimulatedClient *client = new SimulatedClient();
+	ASSERT_TRUE(client->connect(_port));
+	const double startSeconds = now();
+	while (_server.clients().empty()) {
+		_server.update(now());
+		ASSERT_LT(now() - startSeconds, 5.0) << "Client was not accepted";
+	}
+	delete client;
+	while (!_server.clients().empty()) {
+		_server.update(now());
+		ASSERT_LT(now() - startSeconds, 5.0) << "Disconnect was not detected";
+	}
+}
+
+TEST_F(ServerNetworkTest, testSceneStateStream) {
+	// a few small nodes and one large node that is transferred in bricks
+	scenegraph::SceneGraph sceneGraph;
+	const int groupId = sceneGraph.emplace(scenegraph::SceneGraphNode(scenegraph::SceneGraphNodeType::Group));
+	ASSERT_NE(InvalidNodeId, groupId);
+	for (int i = 0; i < 8; ++i) {
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		voxel::RawVolume *v = new voxel::RawVolume(voxel::Region(0, 7));
+		v->setVoxel(i, i, i, voxel::createVoxel(voxel::VoxelType::Generic, i));
+		node.setVolume(v, true);
+		ASSERT_NE(InvalidNodeId, sceneGraph.emplace(core::move(node), groupId));
+	}
+	const voxel::Region largeRegion(0, 0, 0, 255, 63, 255);
+	voxel::RawVolume *large = new voxel::RawVolume(largeRegion);
+	for (int z = 0; z <= largeRegion.getUpperZ(); ++z) {
+		for (int x = 0; x <= largeRegion.getUpperX(); ++x) {
+			const int h = (x ^ z) % 64;
+			for (int y = 0; y <= h; ++y) {
+				large->setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, (uint8_t)(1 + y % 8)));
+			}
+		}
+	}
+	scenegraph::SceneGraphNode largeNode(scenegraph::SceneGraphNodeType::Model);
+	largeNode.setVolume(large, true);
+	const core::UUID largeUUID = largeNode.uuid();
+	ASSERT_NE(InvalidNodeId, sceneGraph.emplace(core::move(largeNode)));
+	_server.setState(&sceneGraph);
+
+	SimulatedClient client;
+	ASSERT_TRUE(client.connect(_port));
+	double startSeconds = now();
+	while (_server.clients().empty()) {
+		_server.update(now());
+		ASSERT_LT(now() - startSeconds, 5.0) << "Client was not accepted";
+	}
+	InitSessionMessage init(false);
+	ASSERT_TRUE(client.send(init));
+
+	bool begin = false;
+	bool end = false;
+	int nodes = 0;
+	int bricks = 0;
+	double firstNodeSeconds = -1.0;
+	core::ScopedPtr<voxel::RawVolume> received;
+	startSeconds = now();
+	while (!end) {
+		_server.update(now());
+		client.receive([&](network::ProtocolMessage &msg) {
+			switch (msg.getId()) {
+			case PROTO_SCENE_STATE_BEGIN:
+				begin = true;
+				EXPECT_EQ(sceneGraph.root().uuid(), ((SceneStateBeginMessage &)msg).rootUUID());
+				break;
+			case PROTO_NODE_ADDED: {
+				EXPECT_TRUE(begin);
+				if (firstNodeSeconds < 0.0) {
+					firstNodeSeconds = now() - startSeconds;
+				}
+				++nodes;
+				const NodeAddedMessage &added = (const NodeAddedMessage &)msg;
+				if (added.nodeUUID() == largeUUID) {
+					// the voxels are following as bricks
+					EXPECT_EQ(0u, added.compressedSize());
+					received = new voxel::RawVolume(added.region());
+				}
+				break;
+			}
+			case PROTO_VOXEL_MODIFICATION: {
+				const VoxelModificationMessage &mod = (const VoxelModificationMessage &)msg;
+				ASSERT_EQ(largeUUID, mod.nodeUUID());
+				ASSERT_TRUE(received);
+				core::ScopedPtr<voxel::RawVolume> brick(mod.toVolume());
+				ASSERT_TRUE(brick);
+				received->copyInto(*brick);
+				++bricks;
+				break;
+			}
+			case PROTO_SCENE_STATE_END:
+				end = true;
+				break;
+			}
+		});
+		ASSERT_LT(now() - startSeconds, 20.0) << "Scene state was not received";
+	}
+	const double totalSeconds = now() - startSeconds;
+	Log::info("Received first node after %f seconds, %i nodes and %i bricks after %f seconds", firstNodeSeconds,
+			  nodes, bricks, totalSeconds);
+	EXPECT_FALSE(_server.isStreamingSceneState());
+	// all nodes but the root node
+	EXPECT_EQ((int)sceneGraph.size(scenegraph::SceneGraphNodeType::All) - 1, nodes);
+	EXPECT_GT(bricks, 1);
+	ASSERT_TRUE(received);
+	const voxel::RawVolume *expected = sceneGraph.findNodeByUUID(largeUUID)->volume();
+	EXPECT_EQ(0, memcmp(expected->data(), received->data(), largeRegion.voxels() * sizeof(voxel::Voxel)));
+	_server.setState(nullptr);
+}
+
+TEST_F(ServerNetworkTest, testSceneStateStreamNodeAdded) {
+	scenegraph::SceneGraph sceneGraph;
+	const int groupId = sceneGraph.emplace(scenegraph::SceneGraphNode(scenegraph::SceneGraphNodeType::Group));
+	ASSERT_NE(InvalidNodeId, groupId);
+	int modelIds[2];
+	for (int i = 0; i < 2; ++i) {
+		scenegraph::SceneGraphNode node(scenegraph::SceneGraphNodeType::Model);
+		node.setVolume(new voxel::RawVolume(voxel::Region(0, 7)), true);
+		modelIds[i] = sceneGraph.emplace(core::move(node), groupId);
+		ASSERT_NE(InvalidNodeId, modelIds[i]);
+	}
+
+	SceneStateStream stream(InvalidConnectionId, now(), 16);
+	core::ScopedPtr<network::ProtocolMessage> msg(stream.next(sceneGraph));
+	ASSERT_TRUE(msg);
+	ASSERT_EQ(PROTO_SCENE_STATE_BEGIN, msg->getId());
+	msg = receive(stream.next(sceneGraph));
+	ASSERT_TRUE(msg);
+	ASSERT_EQ(PROTO_NODE_ADDED, msg->getId());
+	ASSERT_EQ(sceneGraph.node(groupId).uuid(), ((const NodeAddedMessage &)*msg).nodeUUID());
+
+	// added by other clients while the stream is running - the client knows the parent of the first node and
+	// adds it from the broadcast, the broadcast of the second node is dropped as its parent wasn't sent yet
+	const int broadcastedId = sceneGraph.emplace(scenegraph::SceneGraphNode(scenegraph::SceneGraphNodeType::Group));
+	ASSERT_NE(InvalidNodeId, broadcastedId);
+	const core::UUID broadcastedUUID = sceneGraph.node(broadcastedId).uuid();
+	stream.nodeBroadcasted(broadcastedUUID, sceneGraph.root().uuid());
+	const int droppedId =
+		sceneGraph.emplace(scenegraph::SceneGraphNode(scenegraph::SceneGraphNodeType::Group), modelIds[1]);
+	ASSERT_NE(InvalidNodeId, droppedId);
+	const core::UUID droppedUUID = sceneGraph.node(droppedId).uuid();
+	stream.nodeBroadcasted(droppedUUID, sceneGraph.node(modelIds[1]).uuid());
+
+	core::DynamicArray<core::UUID> streamed;
+	for (;;) {
+		msg = receive(stream.next(sceneGraph));
+		ASSERT_TRUE(msg);
+		if (msg->getId() == PROTO_SCENE_STATE_END) {
+			break;
+		}
+		ASSERT_EQ(PROTO_NODE_ADDED, msg->getId());
+		streamed.push_back(((const NodeAddedMessage &)*msg).nodeUUID());
+	}
+	EXPECT_TRUE(stream.done());
+	ASSERT_EQ(3u, streamed.size());
+	EXPECT_EQ(sceneGraph.node(modelIds[0]).uuid(), streamed[0]);
+	EXPECT_EQ(sceneGraph.node(modelIds[1]).uuid(), streamed[1]);
+	EXPECT_EQ(droppedUUID, streamed[2]);
+}
+
+} // namespace voxedit